@@ -92,7 +92,12 @@ void GraphicsClass::Shutdown() {
 
 void GraphicsClass::Frame(float deltaTime) {
 
-  particle_system_->Frame(frame_time_);
+  XMMATRIX viewMatrix;
+
+  camera_->Render();
+  camera_->GetViewMatrix(viewMatrix);
+
+  particle_system_->Frame(frame_time_, viewMatrix);
 
   Render();
 }
@@ -115,9 +120,17 @@ void GraphicsClass::Render() {
 
   particle_system_->Render();
 
-  auto result = particle_shader_->Render(
-      particle_system_->GetIndexCount(), worldMatrix, viewMatrix,
-      projectionMatrix, particle_system_->GetTexture());
+  if (particle_system_->IsInstanced()) {
+    particle_shader_->RenderInstanced(
+        particle_system_->GetQuadVertexCount(),
+        particle_system_->GetInstanceCount(),
+        particle_system_->GetStartInstance(), worldMatrix, viewMatrix,
+        projectionMatrix, particle_system_->GetTexture());
+  } else {
+    particle_shader_->Render(particle_system_->GetIndexCount(), worldMatrix,
+                             viewMatrix, projectionMatrix,
+                             particle_system_->GetTexture());
+  }
 
   directx_device->TurnOffAlphaBlending();
 
@@ -1,8 +1,68 @@
 #include "System.h"
+#include "particleinstancebenchmarks.h"
+#include "particleinstancetests.h"
+#include "particlepoolbenchmarks.h"
+#include "particlepooltests.h"
+#include "particlesortbenchmarks.h"
+#include "particlesorttests.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace {
+
+struct StartupTest {
+  const wchar_t *name;
+  bool (*run)();
+};
+
+const StartupTest kStartupTests[] = {
+    {L"Particle pool", RunParticlePoolTests},
+    {L"Particle sort", RunParticleSortTests},
+    {L"Particle instance", RunParticleInstanceTests},
+};
+
+// Runs the unit tests in order and reports the first failure.
+bool RunStartupTests() {
+  for (const auto &test : kStartupTests) {
+    if (!test.run()) {
+      const std::wstring message = std::wstring(test.name) + L" tests failed.";
+      MessageBox(NULL, message.c_str(), L"Error", MB_OK);
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR pScmdline,
                    int iCmdshow) {
 
+  // --self-test runs the unit tests and exits. Debug builds also run them on
+  // every start; Release builds go straight to the window.
+  if (pScmdline && strstr(pScmdline, "--self-test")) {
+    return RunStartupTests() ? 0 : 1;
+  }
+#ifdef _DEBUG
+  if (!RunStartupTests()) {
+    return 1;
+  }
+#endif
+
+  // Headless benchmark mode: no window or device is created.
+  if (pScmdline && strstr(pScmdline, "--benchmark")) {
+    AllocConsole();
+    FILE *benchmark_out = nullptr;
+    freopen_s(&benchmark_out, "CONOUT$", "w", stdout);
+    auto benchmarks_ok = RunParticlePoolBenchmarks();
+    benchmarks_ok = RunParticleSortBenchmarks() && benchmarks_ok;
+    benchmarks_ok = RunParticleInstanceBenchmarks() && benchmarks_ok;
+    FreeConsole();
+    return benchmarks_ok ? 0 : 1;
+  }
+
   System *system = new System();
   if (!system) {
     return 0;
@@ -37,6 +37,35 @@ PixelInputType ParticleVertexShader(VertexInputType input)
     return output;
 }
 
+struct InstanceInputType
+{
+    float2 corner : POSITION;
+    float4 instancePosition : TEXCOORD1;
+	float4 color : COLOR;
+};
+
+PixelInputType ParticleInstanceVertexShader(InstanceInputType input)
+{
+    PixelInputType output;
+    float4 position;
+
+	// Stretch the quad corner by the particle size, stored in w, around the particle position.
+    position.xy = input.instancePosition.xy + input.corner * input.instancePosition.w;
+    position.z = input.instancePosition.z;
+    position.w = 1.0f;
+
+    output.position = mul(position, worldMatrix);
+    output.position = mul(output.position, viewMatrix);
+    output.position = mul(output.position, projectionMatrix);
+
+	// Map the corner from -1..1 to the texture, v pointing down.
+	output.tex = float2(input.corner.x + 1.0f, 1.0f - input.corner.y) * 0.5f;
+
+    output.color = input.color;
+
+    return output;
+}
+
 Texture2D shaderTexture;
 SamplerState SampleType;
 
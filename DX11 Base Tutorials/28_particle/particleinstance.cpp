@@ -0,0 +1,29 @@
+#include "particleinstance.h"
+
+#include "particlepoolclass.h"
+
+void PackParticleInstances(const ParticlePoolClass &particles,
+                           const std::vector<std::uint32_t> &order,
+                           float size, ParticleInstanceType *instances) {
+
+  const float *position_x = particles.GetPositionX();
+  const float *position_y = particles.GetPositionY();
+  const float *position_z = particles.GetPositionZ();
+  const float *red = particles.GetRed();
+  const float *green = particles.GetGreen();
+  const float *blue = particles.GetBlue();
+
+  // Every field is written, so the target may be a mapped buffer that is
+  // only ever written to.
+  for (auto i : order) {
+    instances->position[0] = position_x[i];
+    instances->position[1] = position_y[i];
+    instances->position[2] = position_z[i];
+    instances->size = size;
+    instances->color[0] = red[i];
+    instances->color[1] = green[i];
+    instances->color[2] = blue[i];
+    instances->color[3] = 1.0f;
+    instances++;
+  }
+}
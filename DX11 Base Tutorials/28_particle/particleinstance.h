@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class ParticlePoolClass;
+
+// Per-instance data of a billboard: the quad is stretched by size around
+// the position. 32 bytes against the 216 of six full vertices.
+struct ParticleInstanceType {
+  float position[3];
+  float size;
+  float color[4];
+};
+
+// Writes one instance per particle in the given draw order. Kept free of
+// any device so it is tested headless.
+void PackParticleInstances(const ParticlePoolClass &,
+                           const std::vector<std::uint32_t> &, float,
+                           ParticleInstanceType *);
@@ -0,0 +1,106 @@
+#include "particleinstancebenchmarks.h"
+
+#include "particleinstance.h"
+#include "particlepoolclass.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int kFrames = 20;
+
+template <typename Func> double MeasureMilliseconds(Func &&func) {
+  const auto start = Clock::now();
+  func();
+  const auto end = Clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Same layout as the particle system's vertex: position, uv and color.
+struct VertexType {
+  float position[3];
+  float texture[2];
+  float color[4];
+};
+
+// The tutorial's upload: two triangles per particle, every field written
+// six times.
+void BuildVertices(const ParticlePoolClass &particles,
+                   const std::vector<std::uint32_t> &order, float size,
+                   VertexType *vertices) {
+  const float corner_x[6] = {-1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f};
+  const float corner_y[6] = {-1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f};
+
+  for (auto i : order) {
+    for (int corner = 0; corner < 6; corner++) {
+      vertices->position[0] =
+          particles.GetPositionX()[i] + corner_x[corner] * size;
+      vertices->position[1] =
+          particles.GetPositionY()[i] + corner_y[corner] * size;
+      vertices->position[2] = particles.GetPositionZ()[i];
+      vertices->texture[0] = (corner_x[corner] + 1.0f) * 0.5f;
+      vertices->texture[1] = (1.0f - corner_y[corner]) * 0.5f;
+      vertices->color[0] = particles.GetRed()[i];
+      vertices->color[1] = particles.GetGreen()[i];
+      vertices->color[2] = particles.GetBlue()[i];
+      vertices->color[3] = 1.0f;
+      vertices++;
+    }
+  }
+}
+
+} // namespace
+
+bool RunParticleInstanceBenchmarks() {
+  bool consistent = true;
+
+  printf("=== Particle upload benchmark ===\n");
+  printf("%9s %22s %22s\n", "particles", "six vertices", "instances");
+
+  for (int count : {5000, 1000000}) {
+    ParticleEmitterDesc desc;
+    ParticlePoolClass pool;
+    pool.Initialize(count, desc, 3);
+    pool.Emit(count);
+
+    std::vector<std::uint32_t> order(count);
+    for (int i = 0; i < count; i++) {
+      order[i] = static_cast<std::uint32_t>(count - 1 - i);
+    }
+
+    std::vector<VertexType> vertices(count * 6);
+    std::vector<ParticleInstanceType> instances(count);
+
+    double vertex_total = 0.0, instance_total = 0.0;
+    for (int frame = 0; frame < kFrames; frame++) {
+      vertex_total += MeasureMilliseconds(
+          [&] { BuildVertices(pool, order, 0.2f, vertices.data()); });
+      instance_total += MeasureMilliseconds(
+          [&] { PackParticleInstances(pool, order, 0.2f, instances.data()); });
+    }
+
+    // The bottom left corner of the first quad sits size below and left of
+    // the instance position.
+    consistent =
+        vertices[0].position[0] == instances[0].position[0] - 0.2f &&
+        vertices[0].position[2] == instances[0].position[2] &&
+        vertices[0].color[1] == instances[0].color[1] && consistent;
+
+    const double vertex_kb = sizeof(VertexType) * 6.0 * count / 1024.0;
+    const double instance_kb =
+        sizeof(ParticleInstanceType) * 1.0 * count / 1024.0;
+    printf("%9d %8.3f ms %8.0f KB %8.3f ms %8.0f KB\n", count,
+           vertex_total / kFrames, vertex_kb, instance_total / kFrames,
+           instance_kb);
+  }
+
+  if (!consistent) {
+    printf("Vertices and instances disagree\n");
+  }
+  return consistent;
+}
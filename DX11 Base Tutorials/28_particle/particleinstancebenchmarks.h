@@ -0,0 +1,7 @@
+#pragma once
+
+// Headless upload benchmarks: six vertices per particle built the way the
+// tutorial did against one packed instance per particle, at the demo's
+// scale and at a million particles. Prints timings and bytes written per
+// frame, and returns false if the two disagree on a particle.
+bool RunParticleInstanceBenchmarks();
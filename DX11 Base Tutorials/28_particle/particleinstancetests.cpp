@@ -0,0 +1,234 @@
+#include "particleinstancetests.h"
+
+#include "particleinstance.h"
+#include "particlepoolclass.h"
+#include "particleringallocatorclass.h"
+
+#include <windows.h>
+
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+struct RangeType {
+  std::uint64_t frame;
+  int first, count;
+};
+
+bool TestPacking(std::string &message) {
+  ParticleEmitterDesc desc;
+  ParticlePoolClass pool;
+  pool.Initialize(37, desc, 41);
+  pool.Emit(37);
+
+  // Drawn in reverse slot order.
+  std::vector<std::uint32_t> order;
+  for (std::uint32_t i = 37; i-- > 0;) {
+    order.push_back(i);
+  }
+
+  // One spare instance on each side to catch writes out of range.
+  std::vector<ParticleInstanceType> instances(39);
+  for (auto &instance : instances) {
+    instance.size = -1.0f;
+  }
+  PackParticleInstances(pool, order, 0.25f, &instances[1]);
+
+  if (instances.front().size != -1.0f || instances.back().size != -1.0f) {
+    message = "wrote outside the range";
+    return false;
+  }
+  for (std::size_t k = 0; k < order.size(); k++) {
+    const auto &instance = instances[k + 1];
+    const auto i = order[k];
+    if (instance.position[0] != pool.GetPositionX()[i] ||
+        instance.position[1] != pool.GetPositionY()[i] ||
+        instance.position[2] != pool.GetPositionZ()[i] ||
+        instance.size != 0.25f || instance.color[0] != pool.GetRed()[i] ||
+        instance.color[1] != pool.GetGreen()[i] ||
+        instance.color[2] != pool.GetBlue()[i] || instance.color[3] != 1.0f) {
+      message = "instance " + std::to_string(k) + " differs";
+      return false;
+    }
+  }
+  return sizeof(ParticleInstanceType) == 32;
+}
+
+bool TestSequentialRanges(std::string &message) {
+  ParticleRingAllocatorClass ring;
+  if (ring.Initialize(0) || !ring.Initialize(100)) {
+    message = "capacity not checked";
+    return false;
+  }
+
+  if (ring.Allocate(30) != 0 || ring.Allocate(30) != 30 ||
+      ring.Allocate(40) != 60 || ring.GetUsedCount() != 100) {
+    message = "ranges not handed out back to back";
+    return false;
+  }
+
+  // Full until the frame retires.
+  if (ring.Allocate(1) != -1) {
+    message = "allocated from a full ring";
+    return false;
+  }
+  ring.Retire(ring.EndFrame());
+  if (ring.GetUsedCount() != 0 || ring.GetFramesInFlight() != 0 ||
+      ring.Allocate(100) != 0) {
+    message = "retired frame not freed";
+    return false;
+  }
+
+  // Empty ranges take nothing; oversized ones never fit.
+  if (ring.Allocate(101) != -1 || ring.Allocate(-1) != -1) {
+    message = "impossible range handed out";
+    return false;
+  }
+  ring.Reset();
+  return ring.Allocate(0) == 0 && ring.GetUsedCount() == 0;
+}
+
+bool TestWrapSkipsTail(std::string &message) {
+  ParticleRingAllocatorClass ring;
+  ring.Initialize(100);
+
+  ring.Allocate(60);
+  const auto first = ring.EndFrame();
+  ring.Allocate(30);
+  const auto second = ring.EndFrame();
+  ring.Retire(first);
+
+  // Twenty do not fit in the last ten, so they start over at zero and the
+  // ten are skipped until this frame retires.
+  if (ring.Allocate(20) != 0 || ring.GetUsedCount() != 60) {
+    message = "range did not wrap to the front";
+    return false;
+  }
+
+  // The second frame still owns 60 to 90.
+  if (ring.Allocate(50) != -1) {
+    message = "range overlaps a frame in flight";
+    return false;
+  }
+  ring.Retire(second);
+  if (ring.Allocate(50) != 20 || ring.GetUsedCount() != 80) {
+    message = "range after the retired frame not handed out";
+    return false;
+  }
+  return true;
+}
+
+bool TestFramesInFlight(std::string &message) {
+  ParticleRingAllocatorClass ring;
+  ring.Initialize(1000);
+  std::deque<RangeType> in_flight;
+  std::vector<std::uint64_t> frames;
+  std::uint32_t random = 7;
+  int failed = 0;
+
+  // A GPU a few frames behind: every frame allocates a few ranges, and the
+  // frame from up to three frames ago is retired.
+  for (int frame = 0; frame < 5000; frame++) {
+    for (int n = 0; n < 3; n++) {
+      random = random * 1664525u + 1013904223u;
+      const int count = static_cast<int>((random >> 8) % 200);
+      const int first = ring.Allocate(count);
+      if (first < 0) {
+        failed++;
+        continue;
+      }
+      if (first + count > 1000) {
+        message = "range runs past the end";
+        return false;
+      }
+      for (const auto &range : in_flight) {
+        if (count > 0 && range.count > 0 && first < range.first + range.count &&
+            range.first < first + count) {
+          message = "range overwrites a frame in flight in frame " +
+                    std::to_string(frame);
+          return false;
+        }
+      }
+      in_flight.push_back({static_cast<std::uint64_t>(frame), first, count});
+    }
+
+    const auto id = ring.EndFrame();
+    frames.push_back(id);
+    const int lag = 1 + static_cast<int>((random >> 20) % 3);
+    if (static_cast<int>(frames.size()) > lag) {
+      const auto retired = frames[frames.size() - 1 - lag];
+      ring.Retire(retired);
+      while (!in_flight.empty() && in_flight.front().frame + 1 <= retired) {
+        in_flight.pop_front();
+      }
+    }
+  }
+
+  // Some allocations had to wait, and everything comes back at the end.
+  ring.Retire(frames.back());
+  if (failed == 0 || ring.GetUsedCount() != 0 || ring.Allocate(1000) != 0) {
+    message = "ring not freed after the last frame";
+    return false;
+  }
+  return true;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(4);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("Packing", TestPacking);
+  run("Sequential ranges", TestSequentialRanges);
+  run("Wrap skips the tail", TestWrapSkipsTail);
+  run("Frames in flight", TestFramesInFlight);
+
+  return results;
+}
+
+} // namespace
+
+bool RunParticleInstanceTests() {
+  const auto results = RunAllTestsInternal();
+  bool all_passed = true;
+
+  for (const auto &result : results) {
+    if (!result.passed) {
+      all_passed = false;
+      std::string line = "ParticleInstanceTests: Test failed: " + result.name;
+      if (!result.message.empty()) {
+        line += " - " + result.message;
+      }
+      line += "\n";
+      OutputDebugStringA(line.c_str());
+    }
+  }
+
+  return all_passed;
+}
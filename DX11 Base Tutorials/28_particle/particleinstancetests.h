@@ -0,0 +1,7 @@
+#pragma once
+
+// Executes the headless parts of instanced particle rendering: packing the
+// per-instance data in draw order and the ring allocator that keeps frames
+// in flight from being overwritten. Failures are written to the debugger
+// output. Returns true when all tests pass.
+bool RunParticleInstanceTests();
@@ -0,0 +1,156 @@
+#include "particlepoolbenchmarks.h"
+
+#include "particlepoolclass.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int kSmallParticles = 10000;
+const int kLargeParticles = 1 << 20;
+const int kFrames = 100;
+
+template <typename Func> double MeasureMilliseconds(Func &&func) {
+  const auto start = Clock::now();
+  func();
+  const auto end = Clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// The particle array the tutorial started with: kept sorted by depth with
+// an insertion on every emit and a shift of the tail on every kill. Like the
+// original, a kill skips the particle shifted into its place.
+struct LegacyParticle {
+  float position_x, position_y, position_z;
+  float red, green, blue;
+  float velocity;
+  bool active;
+};
+
+class LegacyParticles {
+public:
+  explicit LegacyParticles(int capacity) : particles_(capacity) {}
+
+  void Emit() {
+    const float z = ((float)rand() - (float)rand()) / RAND_MAX * 2.0f;
+    count_++;
+    int index = 0;
+    while (particles_[index].active && particles_[index].position_z >= z) {
+      index++;
+    }
+    for (int i = count_; i != index; i--) {
+      particles_[i] = particles_[i - 1];
+    }
+    particles_[index] = {0.0f, 0.0f, z, 1.0f, 1.0f, 1.0f,
+                         1.0f + ((float)rand() - (float)rand()) / RAND_MAX *
+                                    0.2f};
+    particles_[index].active = true;
+  }
+
+  void Update(float frame_time) {
+    for (int i = 0; i < count_; i++) {
+      particles_[i].position_y -=
+          particles_[i].velocity * frame_time * 0.001f;
+    }
+  }
+
+  void Kill() {
+    for (int i = 0; i < static_cast<int>(particles_.size()); i++) {
+      if (particles_[i].active && particles_[i].position_y < -3.0f) {
+        particles_[i].active = false;
+        count_--;
+        for (int j = i; j < static_cast<int>(particles_.size()) - 1; j++) {
+          particles_[j] = particles_[j + 1];
+        }
+      }
+    }
+  }
+
+  int GetCount() const { return count_; }
+
+private:
+  std::vector<LegacyParticle> particles_;
+  int count_ = 0;
+};
+
+bool NoDeadParticles(const ParticlePoolClass &pool, float kill_height) {
+  for (int i = 0; i < pool.GetParticleCount(); i++) {
+    if (pool.GetLifetime()[i] <= 0.0f ||
+        pool.GetPositionY()[i] < kill_height) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+bool RunParticlePoolBenchmarks() {
+  ParticleEmitterDesc desc;
+  ParticlePoolClass pool;
+  bool consistent = true;
+
+  printf("=== Particle pool benchmark ===\n");
+
+  // Spawn and kill the tutorial's way: one particle at a time into the
+  // sorted array, then let them all fall out.
+  LegacyParticles legacy(kSmallParticles + 1);
+  const double legacy_emit_ms = MeasureMilliseconds([&] {
+    for (int i = 0; i < kSmallParticles; i++) {
+      legacy.Emit();
+    }
+  });
+  legacy.Update(5000.0f);
+  const double legacy_kill_ms = MeasureMilliseconds([&] { legacy.Kill(); });
+
+  pool.Initialize(kSmallParticles, desc, 1);
+  const double emit_ms =
+      MeasureMilliseconds([&] { pool.Emit(kSmallParticles); });
+  pool.Update(5000.0f);
+  const double kill_ms = MeasureMilliseconds([&] { pool.Kill(); });
+  consistent = pool.GetParticleCount() == 0;
+
+  printf("%d particles spawned and killed\n", kSmallParticles);
+  printf("  sorted array  emit %9.3f ms  kill %9.3f ms\n", legacy_emit_ms,
+         legacy_kill_ms);
+  printf("  SoA pool      emit %9.3f ms  kill %9.3f ms (the depth sort is "
+         "timed on its own)\n",
+         emit_ms, kill_ms);
+
+  // A million particles with a steady stream: three seconds of life at a
+  // third of the pool per second keeps it nearly full once warmed up.
+  desc.lifetime = 3000.0f;
+  pool.Initialize(kLargeParticles, desc, 2);
+  for (int frame = 0; frame < 200; frame++) {
+    pool.Kill();
+    pool.EmitOverTime(16.0f, kLargeParticles / 3.0f);
+    pool.Update(16.0f);
+  }
+  double kill_total = 0.0, emit_total = 0.0, update_total = 0.0, alive = 0.0;
+  for (int frame = 0; frame < kFrames; frame++) {
+    const float frame_time = 16.0f;
+    kill_total += MeasureMilliseconds([&] { pool.Kill(); });
+    emit_total += MeasureMilliseconds([&] {
+      pool.EmitOverTime(frame_time, kLargeParticles / 3.0f);
+    });
+    update_total += MeasureMilliseconds([&] { pool.Update(frame_time); });
+    alive += pool.GetParticleCount();
+  }
+  pool.Kill();
+  consistent = NoDeadParticles(pool, desc.kill_height) && consistent;
+
+  printf("%d particle pool, %d frames, %.0f alive on average\n",
+         kLargeParticles, kFrames, alive / kFrames);
+  printf("  kill %.3f ms  emit %.3f ms  update %.3f ms  per frame\n",
+         kill_total / kFrames, emit_total / kFrames, update_total / kFrames);
+
+  if (!consistent) {
+    printf("Particles left alive after they died\n");
+  }
+  return consistent;
+}
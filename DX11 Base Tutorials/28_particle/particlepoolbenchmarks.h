@@ -0,0 +1,7 @@
+#pragma once
+
+// Headless particle benchmarks: the old depth-sorted particle array against
+// the structure-of-arrays pool at the tutorial's scale, then a pool of a
+// million particles framed like the particle system. Prints timings and
+// returns false if the pool leaves a dead particle alive.
+bool RunParticlePoolBenchmarks();
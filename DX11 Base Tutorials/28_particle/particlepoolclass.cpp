@@ -0,0 +1,218 @@
+#include "particlepoolclass.h"
+
+#include <algorithm>
+#include <xmmintrin.h>
+
+#include "JobSystem.h"
+
+namespace {
+
+// Pools smaller than this are simulated on the calling thread; larger ones
+// are split into blocks that threads take in turn.
+const int kParallelThreshold = 1 << 16;
+const int kParallelBlockSize = 1 << 14;
+
+} // namespace
+
+bool ParticlePoolClass::Initialize(int capacity,
+                                   const ParticleEmitterDesc &desc,
+                                   std::uint32_t seed) {
+
+  if (capacity <= 0) {
+    return false;
+  }
+
+  desc_ = desc;
+  capacity_ = capacity;
+  particle_count_ = 0;
+  accumulated_time_ = 0.0f;
+
+  // Xorshift needs a non-zero state.
+  random_state_ = seed != 0 ? seed : 1;
+
+  // Round the arrays up to whole SIMD lanes.
+  const auto padded = static_cast<std::size_t>((capacity + 3) & ~3);
+  for (auto *array : {&position_x_, &position_y_, &position_z_, &velocity_x_,
+                      &velocity_y_, &velocity_z_, &red_, &green_, &blue_,
+                      &lifetime_}) {
+    array->assign(padded, 0.0f);
+  }
+
+  return true;
+}
+
+void ParticlePoolClass::Shutdown() {
+
+  for (auto *array : {&position_x_, &position_y_, &position_z_, &velocity_x_,
+                      &velocity_y_, &velocity_z_, &red_, &green_, &blue_,
+                      &lifetime_}) {
+    std::vector<float>().swap(*array);
+  }
+
+  capacity_ = 0;
+  particle_count_ = 0;
+}
+
+int ParticlePoolClass::Emit(int count) {
+
+  count = std::max(0, std::min(count, capacity_ - particle_count_));
+
+  // New particles go on the end of the alive range.
+  for (int n = 0; n < count; n++) {
+    const int i = particle_count_++;
+
+    position_x_[i] = desc_.position_x + RandomSigned() * desc_.deviation_x;
+    position_y_[i] = desc_.position_y + RandomSigned() * desc_.deviation_y;
+    position_z_[i] = desc_.position_z + RandomSigned() * desc_.deviation_z;
+
+    velocity_x_[i] = 0.0f;
+    velocity_y_[i] =
+        -(desc_.velocity + RandomSigned() * desc_.velocity_variation);
+    velocity_z_[i] = 0.0f;
+
+    red_[i] = RandomSigned() + 0.5f;
+    green_[i] = RandomSigned() + 0.5f;
+    blue_[i] = RandomSigned() + 0.5f;
+
+    lifetime_[i] = desc_.lifetime;
+  }
+
+  return count;
+}
+
+int ParticlePoolClass::EmitOverTime(float frame_time,
+                                    float particles_per_second) {
+
+  if (particles_per_second <= 0.0f) {
+    return 0;
+  }
+
+  // Emit every whole particle the elapsed time has earned, however many
+  // that is, and keep the remainder for the next frame.
+  accumulated_time_ += frame_time;
+  const float period = 1000.0f / particles_per_second;
+  const float earned = accumulated_time_ / period;
+  const int count = earned >= static_cast<float>(capacity_)
+                        ? capacity_
+                        : static_cast<int>(earned);
+  accumulated_time_ -= static_cast<float>(count) * period;
+
+  const int emitted = Emit(count);
+
+  // A full pool does not bank time for a burst later.
+  if (emitted < count) {
+    accumulated_time_ = 0.0f;
+  }
+
+  return emitted;
+}
+
+void ParticlePoolClass::Update(float frame_time) {
+
+  if (particle_count_ < kParallelThreshold) {
+    UpdateRange(0, particle_count_, frame_time);
+    return;
+  }
+
+  // Every particle is independent, so blocks run in parallel.
+  const int block_count =
+      (particle_count_ + kParallelBlockSize - 1) / kParallelBlockSize;
+  JobSystem::GetShared().ParallelFor(block_count, [&](int block) {
+    const int begin = block * kParallelBlockSize;
+    const int end = std::min(begin + kParallelBlockSize, particle_count_);
+    UpdateRange(begin, end, frame_time);
+  });
+}
+
+void ParticlePoolClass::UpdateRange(int begin, int end, float frame_time) {
+
+  const float seconds = frame_time * 0.001f;
+  const __m128 dt = _mm_set1_ps(seconds);
+  const __m128 dv = _mm_set1_ps(desc_.gravity * seconds);
+  const __m128 elapsed = _mm_set1_ps(frame_time);
+
+  // Blocks start on multiples of four and the arrays are padded, so the
+  // last group may run past the alive range into unused slots.
+  for (int i = begin; i < end; i += 4) {
+    const __m128 velocity_y = _mm_add_ps(_mm_loadu_ps(&velocity_y_[i]), dv);
+    _mm_storeu_ps(&velocity_y_[i], velocity_y);
+
+    _mm_storeu_ps(&position_x_[i],
+                  _mm_add_ps(_mm_loadu_ps(&position_x_[i]),
+                             _mm_mul_ps(_mm_loadu_ps(&velocity_x_[i]), dt)));
+    _mm_storeu_ps(&position_y_[i],
+                  _mm_add_ps(_mm_loadu_ps(&position_y_[i]),
+                             _mm_mul_ps(velocity_y, dt)));
+    _mm_storeu_ps(&position_z_[i],
+                  _mm_add_ps(_mm_loadu_ps(&position_z_[i]),
+                             _mm_mul_ps(_mm_loadu_ps(&velocity_z_[i]), dt)));
+
+    _mm_storeu_ps(&lifetime_[i],
+                  _mm_sub_ps(_mm_loadu_ps(&lifetime_[i]), elapsed));
+  }
+}
+
+int ParticlePoolClass::Kill() {
+
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 kill_height = _mm_set1_ps(desc_.kill_height);
+  int killed = 0;
+
+  int i = 0;
+  while (i < particle_count_) {
+    // Step over four live particles at a time.
+    if (i + 4 <= particle_count_) {
+      const __m128 dead = _mm_or_ps(
+          _mm_cmple_ps(_mm_loadu_ps(&lifetime_[i]), zero),
+          _mm_cmplt_ps(_mm_loadu_ps(&position_y_[i]), kill_height));
+      if (_mm_movemask_ps(dead) == 0) {
+        i += 4;
+        continue;
+      }
+    }
+
+    // Swap-remove: the last alive particle fills the hole and is checked
+    // next.
+    if (IsDead(i)) {
+      particle_count_--;
+      MoveParticle(particle_count_, i);
+      killed++;
+    } else {
+      i++;
+    }
+  }
+
+  return killed;
+}
+
+bool ParticlePoolClass::IsDead(int i) const {
+  return lifetime_[i] <= 0.0f || position_y_[i] < desc_.kill_height;
+}
+
+void ParticlePoolClass::MoveParticle(int from, int to) {
+
+  if (from == to) {
+    return;
+  }
+
+  for (auto *array : {&position_x_, &position_y_, &position_z_, &velocity_x_,
+                      &velocity_y_, &velocity_z_, &red_, &green_, &blue_,
+                      &lifetime_}) {
+    (*array)[to] = (*array)[from];
+  }
+}
+
+float ParticlePoolClass::RandomSigned() {
+
+  // The difference of two uniform numbers, like (rand() - rand()) /
+  // RAND_MAX, so particles gather towards the emitter.
+  float uniform[2];
+  for (auto &value : uniform) {
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 17;
+    random_state_ ^= random_state_ << 5;
+    value = static_cast<float>(random_state_ >> 8) * (1.0f / 16777216.0f);
+  }
+
+  return uniform[0] - uniform[1];
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Where and how particles are emitted. Positions and velocities are in world
+// units and units per second, lifetimes in milliseconds.
+struct ParticleEmitterDesc {
+  float position_x = 0.0f, position_y = 0.0f, position_z = 0.0f;
+
+  // Random deviation of the emit position on each axis.
+  float deviation_x = 0.5f, deviation_y = 0.1f, deviation_z = 2.0f;
+
+  // Falling speed and its random variation.
+  float velocity = 1.0f, velocity_variation = 0.2f;
+
+  float gravity = 0.0f;
+
+  float lifetime = 10000.0f;
+
+  // Particles that fall below this height are killed as well.
+  float kill_height = -3.0f;
+};
+
+// Structure-of-arrays particle storage. The alive particles always occupy
+// the first GetParticleCount() entries of every array: emitting appends,
+// killing moves the last particle into the hole, so both are O(1) per
+// particle and the arrays double as the compacted list the renderer uploads.
+// Update runs SSE kernels over four particles at a time and splits large
+// pools into blocks simulated on several threads.
+class ParticlePoolClass {
+public:
+  ParticlePoolClass() {}
+
+  ParticlePoolClass(const ParticlePoolClass &rhs) = delete;
+
+  ~ParticlePoolClass() {}
+
+public:
+  bool Initialize(int, const ParticleEmitterDesc &, std::uint32_t);
+
+  void Shutdown();
+
+  // Emits up to the given number of particles at once and returns how many
+  // fit.
+  int Emit(int);
+
+  // Emits as many particles as the rate allows for the elapsed time,
+  // carrying the fraction over to the next frame.
+  int EmitOverTime(float, float);
+
+  void Update(float);
+
+  // Removes particles whose lifetime ran out or that fell below the kill
+  // height. Returns how many were removed.
+  int Kill();
+
+  int GetParticleCount() const { return particle_count_; }
+
+  int GetCapacity() const { return capacity_; }
+
+  const float *GetPositionX() const { return position_x_.data(); }
+
+  const float *GetPositionY() const { return position_y_.data(); }
+
+  const float *GetPositionZ() const { return position_z_.data(); }
+
+  const float *GetVelocityY() const { return velocity_y_.data(); }
+
+  const float *GetRed() const { return red_.data(); }
+
+  const float *GetGreen() const { return green_.data(); }
+
+  const float *GetBlue() const { return blue_.data(); }
+
+  const float *GetLifetime() const { return lifetime_.data(); }
+
+private:
+  void UpdateRange(int, int, float);
+
+  bool IsDead(int) const;
+
+  void MoveParticle(int, int);
+
+  float RandomSigned();
+
+private:
+  ParticleEmitterDesc desc_;
+
+  int capacity_ = 0;
+
+  int particle_count_ = 0;
+
+  float accumulated_time_ = 0.0f;
+
+  std::uint32_t random_state_ = 1;
+
+  // Sized to the capacity rounded up to a multiple of four, so the SIMD
+  // kernels never need a scalar tail.
+  std::vector<float> position_x_, position_y_, position_z_;
+
+  std::vector<float> velocity_x_, velocity_y_, velocity_z_;
+
+  std::vector<float> red_, green_, blue_;
+
+  std::vector<float> lifetime_;
+};
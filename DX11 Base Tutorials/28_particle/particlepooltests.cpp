@@ -0,0 +1,291 @@
+#include "particlepooltests.h"
+
+#include "particlepoolclass.h"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+// Copy of the alive particles, to compare against after an operation.
+struct Snapshot {
+  std::vector<float> x, y, z, velocity_y, red, green, blue, lifetime;
+};
+
+Snapshot Take(const ParticlePoolClass &pool) {
+  const int count = pool.GetParticleCount();
+  Snapshot snapshot;
+  snapshot.x.assign(pool.GetPositionX(), pool.GetPositionX() + count);
+  snapshot.y.assign(pool.GetPositionY(), pool.GetPositionY() + count);
+  snapshot.z.assign(pool.GetPositionZ(), pool.GetPositionZ() + count);
+  snapshot.velocity_y.assign(pool.GetVelocityY(),
+                             pool.GetVelocityY() + count);
+  snapshot.red.assign(pool.GetRed(), pool.GetRed() + count);
+  snapshot.green.assign(pool.GetGreen(), pool.GetGreen() + count);
+  snapshot.blue.assign(pool.GetBlue(), pool.GetBlue() + count);
+  snapshot.lifetime.assign(pool.GetLifetime(), pool.GetLifetime() + count);
+  return snapshot;
+}
+
+// Updates with the same operations as the kernel, one particle at a time.
+bool MatchesReferenceUpdate(const ParticlePoolClass &pool,
+                            const Snapshot &before, float gravity,
+                            float frame_time, std::string &message) {
+  const float seconds = frame_time * 0.001f;
+  for (int i = 0; i < pool.GetParticleCount(); i++) {
+    const float velocity_y = before.velocity_y[i] + gravity * seconds;
+    if (pool.GetVelocityY()[i] != velocity_y ||
+        pool.GetPositionX()[i] != before.x[i] ||
+        pool.GetPositionY()[i] != before.y[i] + velocity_y * seconds ||
+        pool.GetPositionZ()[i] != before.z[i] ||
+        pool.GetLifetime()[i] != before.lifetime[i] - frame_time) {
+      message = "particle " + std::to_string(i) + " differs";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestBurstEmission(std::string &message) {
+  ParticleEmitterDesc desc;
+  desc.position_y = 5.0f;
+  desc.lifetime = 1234.0f;
+  ParticlePoolClass pool;
+  pool.Initialize(600, desc, 7);
+
+  // A burst larger than the pool fills it and no more.
+  if (pool.Emit(1000) != 600 || pool.GetParticleCount() != 600 ||
+      pool.Emit(1) != 0) {
+    message = "burst not clamped to the capacity";
+    return false;
+  }
+
+  for (int i = 0; i < pool.GetParticleCount(); i++) {
+    if (std::fabs(pool.GetPositionX()[i]) > desc.deviation_x ||
+        std::fabs(pool.GetPositionY()[i] - 5.0f) > desc.deviation_y ||
+        std::fabs(pool.GetPositionZ()[i]) > desc.deviation_z ||
+        std::fabs(-pool.GetVelocityY()[i] - desc.velocity) >
+            desc.velocity_variation ||
+        pool.GetRed()[i] < -0.5f || pool.GetRed()[i] > 1.5f ||
+        pool.GetLifetime()[i] != 1234.0f) {
+      message = "particle " + std::to_string(i) + " emitted out of range";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestEmissionRate(std::string &message) {
+  ParticleEmitterDesc desc;
+  ParticlePoolClass pool;
+  pool.Initialize(10000, desc, 3);
+
+  // 250 particles a second over 100 frames of 15 ms, 3.75 particles per
+  // frame with the fractions carried over.
+  int emitted = 0;
+  for (int frame = 0; frame < 100; frame++) {
+    emitted += pool.EmitOverTime(15.0f, 250.0f);
+  }
+  if (emitted != 375 || pool.GetParticleCount() != 375) {
+    message = "expected 375 particles, got " + std::to_string(emitted);
+    return false;
+  }
+
+  // Long frames emit many particles at once.
+  if (pool.EmitOverTime(100.0f, 2500.0f) != 250) {
+    message = "a long frame did not emit a burst";
+    return false;
+  }
+
+  // A full pool does not save up time for a burst once there is room.
+  ParticlePoolClass full;
+  full.Initialize(10, desc, 3);
+  full.Emit(10);
+  full.EmitOverTime(10000.0f, 250.0f);
+  full.Update(desc.lifetime);
+  full.Kill();
+  if (full.GetParticleCount() != 0 || full.EmitOverTime(4.0f, 250.0f) != 1) {
+    message = "time banked while the pool was full";
+    return false;
+  }
+  return true;
+}
+
+bool TestUpdate(std::string &message) {
+  ParticleEmitterDesc desc;
+  desc.gravity = -9.8f;
+  ParticlePoolClass pool;
+
+  // Counts that leave every remainder after the four-wide loop.
+  for (int count = 1; count <= 9; count++) {
+    pool.Initialize(count, desc, count);
+    pool.Emit(count);
+    const Snapshot before = Take(pool);
+    pool.Update(16.5f);
+    if (!MatchesReferenceUpdate(pool, before, desc.gravity, 16.5f,
+                                message)) {
+      message += " with " + std::to_string(count) + " particles";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestThreadedUpdate(std::string &message) {
+  ParticleEmitterDesc desc;
+  desc.gravity = -2.0f;
+  ParticlePoolClass pool;
+
+  // Large enough to be split into blocks, the last one partial.
+  pool.Initialize(300001, desc, 11);
+  pool.Emit(300001);
+  const Snapshot before = Take(pool);
+  pool.Update(33.0f);
+  return MatchesReferenceUpdate(pool, before, desc.gravity, 33.0f, message);
+}
+
+bool TestKill(std::string &message) {
+  ParticleEmitterDesc desc;
+  desc.deviation_y = 0.0f;
+  desc.velocity = 1.0f;
+  desc.velocity_variation = 0.9f;
+  desc.kill_height = -3.0f;
+  ParticlePoolClass pool;
+  pool.Initialize(5003, desc, 5);
+  pool.Emit(5003);
+
+  // After three seconds roughly half have fallen through the kill height.
+  pool.Update(3000.0f);
+  const Snapshot before = Take(pool);
+  std::vector<std::tuple<float, float, float>> expected, actual;
+  for (std::size_t i = 0; i < before.y.size(); i++) {
+    if (before.y[i] >= desc.kill_height) {
+      expected.emplace_back(before.red[i], before.green[i], before.blue[i]);
+    }
+  }
+
+  const int killed = pool.Kill();
+  if (killed != static_cast<int>(before.y.size() - expected.size()) ||
+      pool.GetParticleCount() != static_cast<int>(expected.size()) ||
+      expected.empty() || killed == 0) {
+    message = "wrong number of particles killed";
+    return false;
+  }
+
+  // The survivors are exactly the particles above the kill height, packed
+  // at the front.
+  for (int i = 0; i < pool.GetParticleCount(); i++) {
+    if (pool.GetPositionY()[i] < desc.kill_height) {
+      message = "dead particle left alive";
+      return false;
+    }
+    actual.emplace_back(pool.GetRed()[i], pool.GetGreen()[i],
+                        pool.GetBlue()[i]);
+  }
+  std::sort(expected.begin(), expected.end());
+  std::sort(actual.begin(), actual.end());
+  if (actual != expected) {
+    message = "survivors differ";
+    return false;
+  }
+
+  // Running out of lifetime kills the rest.
+  pool.Update(desc.lifetime);
+  if (pool.Kill() != static_cast<int>(expected.size()) ||
+      pool.GetParticleCount() != 0) {
+    message = "expired particles not killed";
+    return false;
+  }
+  return true;
+}
+
+bool TestSteadyState(std::string &message) {
+  ParticleEmitterDesc desc;
+  ParticlePoolClass pool;
+  pool.Initialize(2000, desc, 17);
+
+  // Frame the way the particle system does and check the invariants.
+  for (int frame = 0; frame < 2000; frame++) {
+    const float frame_time = 5.0f + static_cast<float>(frame % 30);
+    pool.Kill();
+    pool.EmitOverTime(frame_time, 900.0f);
+    pool.Update(frame_time);
+    if (pool.GetParticleCount() > pool.GetCapacity()) {
+      message = "more particles than the capacity";
+      return false;
+    }
+  }
+  pool.Kill();
+  for (int i = 0; i < pool.GetParticleCount(); i++) {
+    if (pool.GetLifetime()[i] <= 0.0f ||
+        pool.GetPositionY()[i] < desc.kill_height) {
+      message = "dead particle left alive";
+      return false;
+    }
+  }
+  return pool.GetParticleCount() > 0;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(6);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("Burst emission", TestBurstEmission);
+  run("Emission rate", TestEmissionRate);
+  run("Update", TestUpdate);
+  run("Threaded update", TestThreadedUpdate);
+  run("Kill", TestKill);
+  run("Steady state", TestSteadyState);
+
+  return results;
+}
+
+} // namespace
+
+bool RunParticlePoolTests() {
+  const auto results = RunAllTestsInternal();
+  bool all_passed = true;
+
+  for (const auto &result : results) {
+    if (!result.passed) {
+      all_passed = false;
+      std::string line = "ParticlePoolTests: Test failed: " + result.name;
+      if (!result.message.empty()) {
+        line += " - " + result.message;
+      }
+      line += "\n";
+      OutputDebugStringA(line.c_str());
+    }
+  }
+
+  return all_passed;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// Executes the particle pool unit tests: burst and rate emission, the SIMD
+// and threaded update against a scalar reference and swap-remove killing.
+// Failures are written to the debugger output. Returns true when all tests
+// pass.
+bool RunParticlePoolTests();
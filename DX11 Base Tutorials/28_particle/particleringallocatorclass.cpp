@@ -0,0 +1,82 @@
+#include "particleringallocatorclass.h"
+
+bool ParticleRingAllocatorClass::Initialize(int capacity) {
+
+  if (capacity <= 0) {
+    return false;
+  }
+
+  capacity_ = capacity;
+
+  Reset();
+
+  return true;
+}
+
+void ParticleRingAllocatorClass::Shutdown() {
+
+  Reset();
+
+  capacity_ = 0;
+}
+
+int ParticleRingAllocatorClass::Allocate(int count) {
+
+  if (count < 0 || count > capacity_) {
+    return -1;
+  }
+
+  // With nothing in use the next range may as well start at the front.
+  if (used_count_ == 0) {
+    head_ = 0;
+  }
+
+  // A range that does not fit before the end skips the rest of the buffer.
+  const int skipped = head_ + count > capacity_ ? capacity_ - head_ : 0;
+  if (used_count_ + skipped + count > capacity_) {
+    return -1;
+  }
+
+  if (skipped > 0) {
+    head_ = 0;
+  }
+
+  const int first = head_;
+
+  head_ += count;
+  if (head_ == capacity_) {
+    head_ = 0;
+  }
+
+  used_count_ += skipped + count;
+  frame_used_count_ += skipped + count;
+
+  return first;
+}
+
+std::uint64_t ParticleRingAllocatorClass::EndFrame() {
+
+  const auto id = next_frame_id_++;
+
+  frames_.push_back({id, frame_used_count_});
+  frame_used_count_ = 0;
+
+  return id;
+}
+
+void ParticleRingAllocatorClass::Retire(std::uint64_t id) {
+
+  // Frames retire in order, freeing the oldest elements first.
+  while (!frames_.empty() && frames_.front().id <= id) {
+    used_count_ -= frames_.front().used_count;
+    frames_.pop_front();
+  }
+}
+
+void ParticleRingAllocatorClass::Reset() {
+
+  head_ = 0;
+  used_count_ = 0;
+  frame_used_count_ = 0;
+  frames_.clear();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+// Hands out ranges of a persistent ring buffer of elements. A frame's
+// ranges are written with D3D11_MAP_WRITE_NO_OVERWRITE, which promises the
+// GPU is not reading them, so an allocation never reaches into a frame that
+// has not been retired yet. EndFrame closes the current frame and returns
+// its id for a fence; Retire frees every frame up to an id once its fence
+// has signalled. A range that would run past the end starts over at zero,
+// and the skipped tail is freed with its frame.
+//
+// Only bookkeeping: no device is needed, so it is unit tested headless.
+class ParticleRingAllocatorClass {
+public:
+  ParticleRingAllocatorClass() {}
+
+  ParticleRingAllocatorClass(const ParticleRingAllocatorClass &rhs) = delete;
+
+  ~ParticleRingAllocatorClass() {}
+
+public:
+  bool Initialize(int);
+
+  void Shutdown();
+
+  // Returns the first element of a contiguous range, or -1 if there is no
+  // room without touching a frame in flight.
+  int Allocate(int);
+
+  // Closes the current frame and returns its id.
+  std::uint64_t EndFrame();
+
+  // The GPU is done with every frame up to and including the id.
+  void Retire(std::uint64_t);
+
+  // Frees everything, after the buffer was mapped with discard.
+  void Reset();
+
+  int GetCapacity() const { return capacity_; }
+
+  // Elements in use by open and in-flight frames, skipped tails included.
+  int GetUsedCount() const { return used_count_; }
+
+  int GetFramesInFlight() const { return static_cast<int>(frames_.size()); }
+
+private:
+  struct FrameType {
+    std::uint64_t id;
+    int used_count;
+  };
+
+  int capacity_ = 0;
+
+  // Where the next range starts.
+  int head_ = 0;
+
+  int used_count_ = 0;
+
+  // Elements taken since the last EndFrame.
+  int frame_used_count_ = 0;
+
+  std::uint64_t next_frame_id_ = 1;
+
+  std::deque<FrameType> frames_;
+};
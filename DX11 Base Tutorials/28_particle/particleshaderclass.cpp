@@ -20,6 +20,11 @@ bool ParticleShaderClass::Initialize(HWND hwnd) {
     return false;
   }
 
+  result = InitializeInstanceShader(hwnd, L"particle.hlsl");
+  if (!result) {
+    return false;
+  }
+
   return true;
 }
 
@@ -41,6 +46,22 @@ bool ParticleShaderClass::Render(int indexCount, const XMMATRIX &worldMatrix,
   return true;
 }
 
+bool ParticleShaderClass::RenderInstanced(
+    int vertexCount, int instanceCount, int startInstance,
+    const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix,
+    const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView *texture) {
+
+  auto result =
+      SetShaderParameters(worldMatrix, viewMatrix, projectionMatrix, texture);
+  if (!result) {
+    return false;
+  }
+
+  RenderInstancedShader(vertexCount, instanceCount, startInstance);
+
+  return true;
+}
+
 bool ParticleShaderClass::InitializeShader(HWND hwnd, WCHAR *vsFilename,
                                            WCHAR *psFilename) {
 
@@ -170,6 +191,78 @@ bool ParticleShaderClass::InitializeShader(HWND hwnd, WCHAR *vsFilename,
   return true;
 }
 
+bool ParticleShaderClass::InitializeInstanceShader(HWND hwnd,
+                                                   WCHAR *vsFilename) {
+
+  ID3D10Blob *errorMessage = nullptr;
+  ID3D10Blob *vertexShaderBuffer = nullptr;
+
+  auto result = D3DCompileFromFile(vsFilename, NULL, NULL,
+                                   "ParticleInstanceVertexShader", "vs_5_0",
+                                   D3D10_SHADER_ENABLE_STRICTNESS, 0,
+                                   &vertexShaderBuffer, &errorMessage);
+  if (FAILED(result)) {
+    if (errorMessage) {
+      OutputShaderErrorMessage(errorMessage, hwnd, vsFilename);
+    } else {
+      MessageBox(hwnd, vsFilename, L"Missing Shader File", MB_OK);
+    }
+
+    return false;
+  }
+
+  auto device = DirectX11Device::GetD3d11DeviceInstance()->GetDevice();
+
+  result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(),
+                                      vertexShaderBuffer->GetBufferSize(), NULL,
+                                      &instance_vertex_shader_);
+  if (FAILED(result)) {
+    return false;
+  }
+
+  // The quad corners come from slot 0; the particle position with its size
+  // in w, and its color, come once per instance from slot 1.
+  D3D11_INPUT_ELEMENT_DESC polygonLayout[3];
+
+  polygonLayout[0].SemanticName = "POSITION";
+  polygonLayout[0].SemanticIndex = 0;
+  polygonLayout[0].Format = DXGI_FORMAT_R32G32_FLOAT;
+  polygonLayout[0].InputSlot = 0;
+  polygonLayout[0].AlignedByteOffset = 0;
+  polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+  polygonLayout[0].InstanceDataStepRate = 0;
+
+  polygonLayout[1].SemanticName = "TEXCOORD";
+  polygonLayout[1].SemanticIndex = 1;
+  polygonLayout[1].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+  polygonLayout[1].InputSlot = 1;
+  polygonLayout[1].AlignedByteOffset = 0;
+  polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+  polygonLayout[1].InstanceDataStepRate = 1;
+
+  polygonLayout[2].SemanticName = "COLOR";
+  polygonLayout[2].SemanticIndex = 0;
+  polygonLayout[2].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+  polygonLayout[2].InputSlot = 1;
+  polygonLayout[2].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+  polygonLayout[2].InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+  polygonLayout[2].InstanceDataStepRate = 1;
+
+  unsigned int numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
+
+  result = device->CreateInputLayout(
+      polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(),
+      vertexShaderBuffer->GetBufferSize(), &instance_layout_);
+  if (FAILED(result)) {
+    return false;
+  }
+
+  vertexShaderBuffer->Release();
+  vertexShaderBuffer = 0;
+
+  return true;
+}
+
 void ParticleShaderClass::ShutdownShader() {
 
   if (sample_state_) {
@@ -182,6 +275,16 @@ void ParticleShaderClass::ShutdownShader() {
     matrix_buffer_ = nullptr;
   }
 
+  if (instance_layout_) {
+    instance_layout_->Release();
+    instance_layout_ = nullptr;
+  }
+
+  if (instance_vertex_shader_) {
+    instance_vertex_shader_->Release();
+    instance_vertex_shader_ = nullptr;
+  }
+
   if (layout_) {
     layout_->Release();
     layout_ = nullptr;
@@ -275,4 +378,22 @@ void ParticleShaderClass::RenderShader(int indexCount) {
   device_context->PSSetSamplers(0, 1, &sample_state_);
 
   device_context->DrawIndexed(indexCount, 0, 0);
+}
+
+void ParticleShaderClass::RenderInstancedShader(int vertexCount,
+                                                int instanceCount,
+                                                int startInstance) {
+
+  auto device_context =
+      DirectX11Device::GetD3d11DeviceInstance()->GetDeviceContext();
+
+  device_context->IASetInputLayout(instance_layout_);
+
+  device_context->VSSetShader(instance_vertex_shader_, NULL, 0);
+
+  device_context->PSSetShader(pixel_shader_, NULL, 0);
+
+  device_context->PSSetSamplers(0, 1, &sample_state_);
+
+  device_context->DrawInstanced(vertexCount, instanceCount, 0, startInstance);
 }
\ No newline at end of file
@@ -19,9 +19,17 @@ public:
   bool Render(int, const DirectX::XMMATRIX &, const DirectX::XMMATRIX &,
               const DirectX::XMMATRIX &, ID3D11ShaderResourceView *);
 
+  // Draws vertices of a quad strip for a range of instances, starting at
+  // the given instance of the bound instance buffer.
+  bool RenderInstanced(int, int, int, const DirectX::XMMATRIX &,
+                       const DirectX::XMMATRIX &, const DirectX::XMMATRIX &,
+                       ID3D11ShaderResourceView *);
+
 private:
   bool InitializeShader(HWND, WCHAR *, WCHAR *);
 
+  bool InitializeInstanceShader(HWND, WCHAR *);
+
   void ShutdownShader();
 
   void OutputShaderErrorMessage(ID3D10Blob *, HWND, WCHAR *);
@@ -32,6 +40,8 @@ private:
 
   void RenderShader(int);
 
+  void RenderInstancedShader(int, int, int);
+
 private:
   ID3D11VertexShader *vertex_shader_ = nullptr;
 
@@ -39,6 +49,10 @@ private:
 
   ID3D11InputLayout *layout_ = nullptr;
 
+  ID3D11VertexShader *instance_vertex_shader_ = nullptr;
+
+  ID3D11InputLayout *instance_layout_ = nullptr;
+
   ID3D11Buffer *matrix_buffer_ = nullptr;
 
   ID3D11SamplerState *sample_state_ = nullptr;
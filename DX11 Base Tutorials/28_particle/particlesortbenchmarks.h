@@ -0,0 +1,7 @@
+#pragma once
+
+// Headless depth sort benchmarks for 10K to 1M particles framed like the
+// particle system: std::sort by view depth, the radix sort, and the radix
+// sort with temporal coherence. Prints timings and returns false if the
+// sorts disagree.
+bool RunParticleSortBenchmarks();
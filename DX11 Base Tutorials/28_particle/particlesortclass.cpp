@@ -0,0 +1,296 @@
+#include "particlesortclass.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "JobSystem.h"
+#include "particlepoolclass.h"
+
+namespace {
+
+// Sorts smaller than this run on the calling thread; larger ones are split
+// into blocks that threads take in turn.
+const int kParallelThreshold = 1 << 16;
+const int kParallelBlockSize = 1 << 14;
+
+// How far the insertion pass lets a particle move before setting it aside.
+const int kMaxInsertionShift = 8;
+
+// At most this many items are taken back off the end of the sorted run.
+const int kMaxEvictions = 4 * kMaxInsertionShift;
+
+// The insertion pass gives up when more than this share of the particles,
+// one in kStrayDivisor, had to be set aside.
+const int kStrayDivisor = 16;
+
+// After the insertion pass gives up, this many sorts go straight to the
+// radix sort before it is tried again.
+const int kRetryInterval = 30;
+
+const int kRadixBits = 8;
+const int kRadixSize = 1 << kRadixBits;
+
+std::uint64_t MakeItem(float depth, std::uint32_t index) {
+
+  std::uint32_t bits;
+  std::memcpy(&bits, &depth, sizeof(bits));
+
+  // Flip negative floats entirely and set the sign of positive ones, so the
+  // keys compare as unsigned integers the way the depths compare as floats.
+  bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+
+  // Farthest first: the larger the depth, the smaller the key.
+  return (static_cast<std::uint64_t>(~bits) << 32) | index;
+}
+
+float ViewDepth(const ParticlePoolClass &pool, const float view[4],
+                std::uint32_t i) {
+  return pool.GetPositionX()[i] * view[0] + pool.GetPositionY()[i] * view[1] +
+         pool.GetPositionZ()[i] * view[2] + view[3];
+}
+
+// Calls func(begin, end) over [0, count), in blocks on several threads for
+// large counts.
+template <typename Func> void ForEachBlock(int count, const Func &func) {
+
+  if (count < kParallelThreshold) {
+    func(0, count);
+    return;
+  }
+
+  const int block_count = (count + kParallelBlockSize - 1) / kParallelBlockSize;
+  JobSystem::GetShared().ParallelFor(block_count, [&](int block) {
+    const int begin = block * kParallelBlockSize;
+    func(begin, std::min(begin + kParallelBlockSize, count));
+  });
+}
+
+} // namespace
+
+void ParticleSortClass::Sort(const ParticlePoolClass &pool, const float view[4],
+                             std::vector<std::uint32_t> &order) {
+
+  const auto count = static_cast<std::uint32_t>(pool.GetParticleCount());
+
+  incremental_ = false;
+
+  if (retry_countdown_ > 0) {
+    retry_countdown_--;
+  } else if (temporal_coherence_ && !order.empty()) {
+    // Keep last frame's order for the slots that are still alive, then
+    // append the slots filled since. Killed slots were refilled by
+    // swap-remove, so their particles land anywhere; the insertion pass
+    // sets them aside. The depths are calculated in slot order first so
+    // the walk in draw order reads one array.
+    CalculateDepths(pool, view);
+    items_.clear();
+    for (auto i : order) {
+      if (i < count) {
+        items_.push_back(MakeItem(depths_[i], i));
+      }
+    }
+    for (auto i = static_cast<std::uint32_t>(order.size()); i < count; i++) {
+      items_.push_back(MakeItem(depths_[i], i));
+    }
+
+    incremental_ = items_.size() == count && InsertionSort();
+    if (!incremental_) {
+      retry_countdown_ = kRetryInterval;
+    }
+  }
+
+  if (!incremental_) {
+    CalculateItems(pool, view);
+    RadixSort();
+  }
+
+  order.resize(count);
+  for (std::uint32_t i = 0; i < count; i++) {
+    order[i] = static_cast<std::uint32_t>(items_[i]);
+  }
+}
+
+void ParticleSortClass::Shutdown() {
+
+  std::vector<std::uint64_t>().swap(items_);
+  std::vector<std::uint64_t>().swap(scratch_);
+  std::vector<std::uint64_t>().swap(strays_);
+  std::vector<float>().swap(depths_);
+  std::vector<int>().swap(histograms_);
+
+  retry_countdown_ = 0;
+}
+
+void ParticleSortClass::CalculateItems(const ParticlePoolClass &pool,
+                                       const float view[4]) {
+
+  items_.resize(pool.GetParticleCount());
+
+  ForEachBlock(pool.GetParticleCount(), [&](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      items_[i] = MakeItem(ViewDepth(pool, view, i), i);
+    }
+  });
+}
+
+void ParticleSortClass::CalculateDepths(const ParticlePoolClass &pool,
+                                        const float view[4]) {
+
+  depths_.resize(pool.GetParticleCount());
+
+  ForEachBlock(pool.GetParticleCount(), [&](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      depths_[i] = ViewDepth(pool, view, i);
+    }
+  });
+}
+
+bool ParticleSortClass::InsertionSort() {
+
+  const int count = static_cast<int>(items_.size());
+  const auto max_strays = static_cast<std::size_t>(count / kStrayDivisor);
+
+  strays_.clear();
+
+  // The sorted run grows at the front of the array; it never overtakes the
+  // item being placed, so the array needs no second buffer.
+  // The input items just before the current one, which the run may have
+  // overwritten already.
+  std::uint64_t behind[kMaxInsertionShift] = {};
+
+  int run_end = 0;
+  for (int i = 0; i < count; i++) {
+    const auto item = items_[i];
+
+    // In order with the input items just before it and kMaxInsertionShift
+    // before it, the mirror of the check below.
+    const bool in_order =
+        i < kMaxInsertionShift ||
+        (behind[(i - 1) % kMaxInsertionShift] <= item &&
+         behind[i % kMaxInsertionShift] <= item);
+    behind[i % kMaxInsertionShift] = item;
+
+    // So far forward that it would sit at the end of the run and make
+    // everything after it shift past it. Checking the next item too keeps
+    // one that is merely followed by a stray.
+    if (i + kMaxInsertionShift < count && item > items_[i + 1] &&
+        item > items_[i + kMaxInsertionShift]) {
+      strays_.push_back(item);
+      if (strays_.size() > max_strays) {
+        return false;
+      }
+      continue;
+    }
+
+    const int limit = std::max(0, run_end - kMaxInsertionShift);
+    int j = run_end;
+    while (j > limit && items_[j - 1] > item) {
+      j--;
+    }
+
+    if (j > 0 && items_[j - 1] > item) {
+      // When the item is in order with the input, the end of the run is
+      // what is out of place: a few items that slipped past the check
+      // above. Those are set aside instead, as long as there are few.
+      const int evict_limit = std::max(0, run_end - kMaxEvictions);
+      while (in_order && j > evict_limit && items_[j - 1] > item) {
+        j--;
+      }
+      const bool evict = in_order && (j == 0 || items_[j - 1] <= item);
+      if (evict) {
+        strays_.insert(strays_.end(), items_.begin() + j,
+                       items_.begin() + run_end);
+        run_end = j;
+      } else {
+        strays_.push_back(item);
+      }
+      if (strays_.size() > max_strays) {
+        return false;
+      }
+      if (!evict) {
+        continue;
+      }
+    }
+
+    std::copy_backward(items_.begin() + j, items_.begin() + run_end,
+                       items_.begin() + run_end + 1);
+    items_[j] = item;
+    run_end++;
+  }
+
+  if (strays_.empty()) {
+    return true;
+  }
+
+  // Few enough to sort on their own and merge in.
+  std::sort(strays_.begin(), strays_.end());
+  scratch_.resize(count);
+  std::merge(items_.begin(), items_.begin() + run_end, strays_.begin(),
+             strays_.end(), scratch_.begin());
+  items_.swap(scratch_);
+
+  return true;
+}
+
+void ParticleSortClass::RadixSort() {
+
+  const int count = static_cast<int>(items_.size());
+  const int block_count =
+      count < kParallelThreshold
+          ? 1
+          : (count + kParallelBlockSize - 1) / kParallelBlockSize;
+  const int block_size = (count + block_count - 1) / block_count;
+
+  scratch_.resize(count);
+  histograms_.resize(block_count * kRadixSize);
+
+  // One pass per key byte, least significant first. Each pass is stable, so
+  // equal keys keep their index order from the pass before.
+  for (int shift = 32; shift < 64; shift += kRadixBits) {
+    std::fill(histograms_.begin(), histograms_.end(), 0);
+
+    JobSystem::GetShared().ParallelFor(block_count, [&](int block) {
+      auto *histogram = &histograms_[block * kRadixSize];
+      const int end = std::min((block + 1) * block_size, count);
+      for (int i = block * block_size; i < end; i++) {
+        histogram[(items_[i] >> shift) & (kRadixSize - 1)]++;
+      }
+    });
+
+    // A byte that is the same for every item leaves the order as it is.
+    bool skip = false;
+    for (int digit = 0; digit < kRadixSize && !skip; digit++) {
+      int digit_count = 0;
+      for (int block = 0; block < block_count; block++) {
+        digit_count += histograms_[block * kRadixSize + digit];
+      }
+      skip = digit_count == count;
+    }
+    if (skip) {
+      continue;
+    }
+
+    // Turn the counts into the first output slot of every digit in every
+    // block: all blocks of a digit in order, then the next digit.
+    int offset = 0;
+    for (int digit = 0; digit < kRadixSize; digit++) {
+      for (int block = 0; block < block_count; block++) {
+        auto &slot = histograms_[block * kRadixSize + digit];
+        const int digit_count = slot;
+        slot = offset;
+        offset += digit_count;
+      }
+    }
+
+    JobSystem::GetShared().ParallelFor(block_count, [&](int block) {
+      auto *histogram = &histograms_[block * kRadixSize];
+      const int end = std::min((block + 1) * block_size, count);
+      for (int i = block * block_size; i < end; i++) {
+        const auto item = items_[i];
+        scratch_[histogram[(item >> shift) & (kRadixSize - 1)]++] = item;
+      }
+    });
+
+    items_.swap(scratch_);
+  }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class ParticlePoolClass;
+
+// Orders the alive particles of a pool back to front in view space, once per
+// frame after the simulation. Every particle gets a 64-bit item: its view
+// depth mapped to an order-preserving 32-bit key in the high half, its index
+// in the low half. Items are sorted with a least significant digit radix
+// sort on the key bytes, split into blocks on several threads for large
+// pools.
+//
+// With temporal coherence on, the previous frame's order is reused: an
+// insertion pass moves each particle back a few places at most, the few
+// that moved farther (respawned slots, new particles) are sorted aside and
+// merged in. If too many moved, the radix sort runs instead, and keeps
+// running for a while before the insertion pass is tried again.
+class ParticleSortClass {
+public:
+  ParticleSortClass() {}
+
+  ParticleSortClass(const ParticleSortClass &rhs) = delete;
+
+  ~ParticleSortClass() {}
+
+public:
+  void SetTemporalCoherence(bool enabled) { temporal_coherence_ = enabled; }
+
+  bool GetTemporalCoherence() const { return temporal_coherence_; }
+
+  // Fills the order in which to draw the alive particles, farthest first.
+  // The view depth of a particle is x * v[0] + y * v[1] + z * v[2] + v[3],
+  // the third column of a row-vector view matrix. With temporal coherence
+  // on, the order must hold the previous result on entry.
+  void Sort(const ParticlePoolClass &, const float[4],
+            std::vector<std::uint32_t> &);
+
+  // Whether the last Sort got away with the insertion pass.
+  bool WasLastSortIncremental() const { return incremental_; }
+
+  void Shutdown();
+
+private:
+  void CalculateItems(const ParticlePoolClass &, const float[4]);
+
+  void CalculateDepths(const ParticlePoolClass &, const float[4]);
+
+  bool InsertionSort();
+
+  void RadixSort();
+
+private:
+  bool temporal_coherence_ = false;
+
+  bool incremental_ = false;
+
+  // Sorts left before the insertion pass is tried again.
+  int retry_countdown_ = 0;
+
+  std::vector<std::uint64_t> items_, scratch_, strays_;
+
+  // View depth of every particle in slot order, for the insertion pass.
+  std::vector<float> depths_;
+
+  // One 256-entry digit histogram per block of the radix sort.
+  std::vector<int> histograms_;
+};
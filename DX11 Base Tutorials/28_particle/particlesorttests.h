@@ -0,0 +1,8 @@
+#pragma once
+
+// Executes the particle sort unit tests: the radix order against a
+// reference sort on one thread and on several, ties and negative depths,
+// view directions, and the temporal coherence path against full sorts, with
+// drifting particles and with respawned slots. Failures are written to the
+// debugger output. Returns true when all tests pass.
+bool RunParticleSortTests();
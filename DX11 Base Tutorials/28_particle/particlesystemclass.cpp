@@ -1,18 +1,12 @@
 #include "particlesystemclass.h"
 #include "../CommonFramework/DirectX11Device.h"
+#include "particleinstance.h"
 #include "textureclass.h"
 
 #include <DirectXMath.h>
 
 using namespace DirectX;
 
-struct ParticleType {
-  float positionX, positionY, positionZ;
-  float red, green, blue;
-  float velocity;
-  bool active;
-};
-
 struct VertexType {
   XMFLOAT3 position;
   XMFLOAT2 texture;
@@ -51,15 +45,25 @@ void ParticleSystemClass::Shutdown() {
   ReleaseTexture();
 }
 
-bool ParticleSystemClass::Frame(float frameTime) {
+bool ParticleSystemClass::Frame(float frameTime,
+                                const XMMATRIX &viewMatrix) {
 
-  KillParticles();
+  // Release the particles that have fallen out or run out of time.
+  particles_.Kill();
 
-  // Emit new particles.
-  EmitParticles(frameTime);
+  // Emit new particles, as many as the elapsed time allows.
+  particles_.EmitOverTime(frameTime, particles_per_second_);
 
   // Update the position of the particles.
-  UpdateParticles(frameTime);
+  particles_.Update(frameTime);
+
+  // Keep the view-space depth axis for the sort; it follows the camera.
+  XMFLOAT4X4 view;
+  XMStoreFloat4x4(&view, viewMatrix);
+  view_depth_[0] = view._13;
+  view_depth_[1] = view._23;
+  view_depth_[2] = view._33;
+  view_depth_[3] = view._43;
 
   // Update the dynamic vertex buffer with the new position of each particle.
   auto result = UpdateBuffers();
@@ -76,7 +80,9 @@ ID3D11ShaderResourceView *ParticleSystemClass::GetTexture() {
   return texture_->GetTexture();
 }
 
-int ParticleSystemClass::GetIndexCount() { return index_count_; }
+int ParticleSystemClass::GetIndexCount() {
+  return particles_.GetParticleCount() * 6;
+}
 
 bool ParticleSystemClass::LoadTexture(WCHAR *filename) {
 
@@ -105,14 +111,13 @@ void ParticleSystemClass::ReleaseTexture() {
 bool ParticleSystemClass::InitializeParticleSystem() {
 
   // Set the random deviation of where the particles can be located when
-  // emitted.
-  particle_deviatio_x_ = 0.5f;
-  particle_deviation_y_ = 0.1f;
-  particle_deviation_z_ = 2.0f;
-
-  // Set the speed and speed variation of particles.
-  particle_velocity_ = 1.0f;
-  particle_velocity_variation_ = 0.2f;
+  // emitted, and the speed and speed variation of particles.
+  ParticleEmitterDesc desc;
+  desc.deviation_x = 0.5f;
+  desc.deviation_y = 0.1f;
+  desc.deviation_z = 2.0f;
+  desc.velocity = 1.0f;
+  desc.velocity_variation = 0.2f;
 
   // Set the physical size of the particles.
   particle_size_ = 0.2f;
@@ -123,55 +128,47 @@ bool ParticleSystemClass::InitializeParticleSystem() {
   // Set the maximum number of particles allowed in the particle system.
   max_particles_ = 5000;
 
-  // Create the particle list.
-  particle_list_ = new ParticleType[max_particles_];
-  if (!particle_list_) {
+  // Create the particle storage.
+  auto result = particles_.Initialize(max_particles_, desc, 1);
+  if (!result) {
     return false;
   }
 
-  // Initialize the particle list.
-  for (int i = 0; i < max_particles_; i++) {
-    particle_list_[i].active = false;
-  }
+  draw_order_.reserve(max_particles_);
 
-  // Initialize the current particle count to zero since none are emitted yet.
-  current_particle_count_ = 0;
-
-  // Clear the initial accumulated time for the particle per second emission
-  // rate.
-  accumulated_time_ = 0.0f;
+  // Particles only drift between frames, so last frame's order is nearly
+  // sorted already.
+  sorter_.SetTemporalCoherence(true);
 
   return true;
 }
 
 void ParticleSystemClass::ShutdownParticleSystem() {
 
-  if (particle_list_) {
-    delete[] particle_list_;
-    particle_list_ = 0;
-  }
+  particles_.Shutdown();
+
+  sorter_.Shutdown();
+
+  std::vector<std::uint32_t>().swap(draw_order_);
 }
 
 bool ParticleSystemClass::InitializeBuffers() {
 
+  if (instanced_) {
+    return InitializeInstanceBuffers();
+  }
+
   // Set the maximum number of vertices in the vertex array.
   vertex_count_ = max_particles_ * 6;
 
   // Set the maximum number of indices in the index array.
   index_count_ = vertex_count_;
 
-  vertices_ = new VertexType[vertex_count_];
-  if (!vertices_) {
-    return false;
-  }
-
   auto indices = new unsigned long[index_count_];
   if (!indices) {
     return false;
   }
 
-  memset(vertices_, 0, (sizeof(VertexType) * vertex_count_));
-
   for (int i = 0; i < index_count_; i++) {
     indices[i] = i;
   }
@@ -185,16 +182,11 @@ bool ParticleSystemClass::InitializeBuffers() {
   vertex_buffer_desc.MiscFlags = 0;
   vertex_buffer_desc.StructureByteStride = 0;
 
-  D3D11_SUBRESOURCE_DATA vertex_data;
-
-  vertex_data.pSysMem = vertices_;
-  vertex_data.SysMemPitch = 0;
-  vertex_data.SysMemSlicePitch = 0;
-
   auto device = DirectX11Device::GetD3d11DeviceInstance()->GetDevice();
 
+  // The vertices are written every frame before anything is drawn.
   auto result =
-      device->CreateBuffer(&vertex_buffer_desc, &vertex_data, &vertex_buffer_);
+      device->CreateBuffer(&vertex_buffer_desc, nullptr, &vertex_buffer_);
   if (FAILED(result)) {
     return false;
   }
@@ -225,218 +217,125 @@ bool ParticleSystemClass::InitializeBuffers() {
   return true;
 }
 
-void ParticleSystemClass::ShutdownBuffers() {
+bool ParticleSystemClass::InitializeInstanceBuffers() {
 
-  if (index_buffer_) {
-    index_buffer_->Release();
-    index_buffer_ = nullptr;
-  }
+  // The corners of the quad every particle is drawn with, as a strip:
+  // bottom left, top left, bottom right, top right.
+  const XMFLOAT2 corners[4] = {XMFLOAT2(-1.0f, -1.0f), XMFLOAT2(-1.0f, 1.0f),
+                               XMFLOAT2(1.0f, -1.0f), XMFLOAT2(1.0f, 1.0f)};
 
-  if (vertex_buffer_) {
-    vertex_buffer_->Release();
-    vertex_buffer_ = nullptr;
+  D3D11_BUFFER_DESC quad_buffer_desc;
+
+  quad_buffer_desc.Usage = D3D11_USAGE_IMMUTABLE;
+  quad_buffer_desc.ByteWidth = sizeof(corners);
+  quad_buffer_desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+  quad_buffer_desc.CPUAccessFlags = 0;
+  quad_buffer_desc.MiscFlags = 0;
+  quad_buffer_desc.StructureByteStride = 0;
+
+  D3D11_SUBRESOURCE_DATA quadData;
+
+  quadData.pSysMem = corners;
+  quadData.SysMemPitch = 0;
+  quadData.SysMemSlicePitch = 0;
+
+  auto device = DirectX11Device::GetD3d11DeviceInstance()->GetDevice();
+
+  auto result =
+      device->CreateBuffer(&quad_buffer_desc, &quadData, &quad_buffer_);
+  if (FAILED(result)) {
+    return false;
   }
-}
 
-void ParticleSystemClass::EmitParticles(float frameTime) {
+  // Room for a full pool in every frame in flight, so in the steady state
+  // the ring never has to wait for the GPU.
+  if (!instance_ring_.Initialize(max_particles_ * kFramesInFlight)) {
+    return false;
+  }
 
-  // Increment the frame time.
-  accumulated_time_ += frameTime;
+  D3D11_BUFFER_DESC instance_buffer_desc;
 
-  // Set emit particle to false for now.
-  auto emitParticle = false, found = false;
+  instance_buffer_desc.Usage = D3D11_USAGE_DYNAMIC;
+  instance_buffer_desc.ByteWidth =
+      sizeof(ParticleInstanceType) * instance_ring_.GetCapacity();
+  instance_buffer_desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+  instance_buffer_desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+  instance_buffer_desc.MiscFlags = 0;
+  instance_buffer_desc.StructureByteStride = 0;
 
-  // Check if it is time to emit a new particle or not.
-  if (accumulated_time_ > (1000.0f / particles_per_second_)) {
-    accumulated_time_ = 0.0f;
-    emitParticle = true;
+  result = device->CreateBuffer(&instance_buffer_desc, nullptr,
+                                &instance_buffer_);
+  if (FAILED(result)) {
+    return false;
   }
 
-  float positionX, positionY, positionZ, velocity, red, green, blue;
-  int index, i, j;
-
-  // If there are particles to emit then emit one per frame.
-  if ((emitParticle == true) &&
-      (current_particle_count_ < (max_particles_ - 1))) {
-
-    current_particle_count_++;
-
-    // Now generate the randomized particle properties.
-    positionX =
-        (((float)rand() - (float)rand()) / RAND_MAX) * particle_deviatio_x_;
-    positionY =
-        (((float)rand() - (float)rand()) / RAND_MAX) * particle_deviation_y_;
-    positionZ =
-        (((float)rand() - (float)rand()) / RAND_MAX) * particle_deviation_z_;
-
-    velocity =
-        particle_velocity_ + (((float)rand() - (float)rand()) / RAND_MAX) *
-                                 particle_velocity_variation_;
-
-    red = (((float)rand() - (float)rand()) / RAND_MAX) + 0.5f;
-    green = (((float)rand() - (float)rand()) / RAND_MAX) + 0.5f;
-    blue = (((float)rand() - (float)rand()) / RAND_MAX) + 0.5f;
-
-    // Now since the particles need to be rendered from back to front for
-    // blending we have to sort the particle array. We will sort using Z depth
-    // so we need to find where in the list the particle should be inserted.
-    index = 0;
-    found = false;
-    while (!found) {
-      if ((particle_list_[index].active == false) ||
-          (particle_list_[index].positionZ < positionZ)) {
-        found = true;
-      } else {
-        index++;
-      }
+  D3D11_QUERY_DESC fence_desc;
+
+  fence_desc.Query = D3D11_QUERY_EVENT;
+  fence_desc.MiscFlags = 0;
+
+  for (auto &fence : fences_) {
+    result = device->CreateQuery(&fence_desc, &fence);
+    if (FAILED(result)) {
+      return false;
     }
+  }
+
+  instance_buffer_written_ = false;
+  fence_first_ = 0;
+  fence_count_ = 0;
 
-    // Now that we know the location to insert into we need to copy the array
-    // over by one position from the index to make room for the new particle.
-    i = current_particle_count_;
-    j = i - 1;
-
-    while (i != index) {
-      particle_list_[i].positionX = particle_list_[j].positionX;
-      particle_list_[i].positionY = particle_list_[j].positionY;
-      particle_list_[i].positionZ = particle_list_[j].positionZ;
-      particle_list_[i].red = particle_list_[j].red;
-      particle_list_[i].green = particle_list_[j].green;
-      particle_list_[i].blue = particle_list_[j].blue;
-      particle_list_[i].velocity = particle_list_[j].velocity;
-      particle_list_[i].active = particle_list_[j].active;
-      i--;
-      j--;
+  return true;
+}
+
+void ParticleSystemClass::ShutdownBuffers() {
+
+  for (auto &fence : fences_) {
+    if (fence) {
+      fence->Release();
+      fence = nullptr;
     }
+  }
 
-    // Now insert it into the particle array in the correct depth order.
-    particle_list_[index].positionX = positionX;
-    particle_list_[index].positionY = positionY;
-    particle_list_[index].positionZ = positionZ;
-    particle_list_[index].red = red;
-    particle_list_[index].green = green;
-    particle_list_[index].blue = blue;
-    particle_list_[index].velocity = velocity;
-    particle_list_[index].active = true;
+  if (instance_buffer_) {
+    instance_buffer_->Release();
+    instance_buffer_ = nullptr;
   }
-}
 
-void ParticleSystemClass::UpdateParticles(float frameTime) {
+  if (quad_buffer_) {
+    quad_buffer_->Release();
+    quad_buffer_ = nullptr;
+  }
+
+  instance_ring_.Shutdown();
 
-  // Each frame we update all the particles by making them move downwards using
-  // their position, velocity, and the frame time.
-  for (int i = 0; i < current_particle_count_; i++) {
-    particle_list_[i].positionY =
-        particle_list_[i].positionY -
-        (particle_list_[i].velocity * frameTime * 0.001f);
+  if (index_buffer_) {
+    index_buffer_->Release();
+    index_buffer_ = nullptr;
   }
-}
 
-void ParticleSystemClass::KillParticles() {
-
-  int j = 0;
-
-  // Kill all the particles that have gone below a certain height range.
-  for (int i = 0; i < max_particles_; i++) {
-    if ((particle_list_[i].active == true) &&
-        (particle_list_[i].positionY < -3.0f)) {
-      particle_list_[i].active = false;
-      current_particle_count_--;
-
-      // Now shift all the live particles back up the array to erase the
-      // destroyed particle and keep the array sorted correctly.
-      for (j = i; j < max_particles_ - 1; j++) {
-        particle_list_[j].positionX = particle_list_[j + 1].positionX;
-        particle_list_[j].positionY = particle_list_[j + 1].positionY;
-        particle_list_[j].positionZ = particle_list_[j + 1].positionZ;
-        particle_list_[j].red = particle_list_[j + 1].red;
-        particle_list_[j].green = particle_list_[j + 1].green;
-        particle_list_[j].blue = particle_list_[j + 1].blue;
-        particle_list_[j].velocity = particle_list_[j + 1].velocity;
-        particle_list_[j].active = particle_list_[j + 1].active;
-      }
-    }
+  if (vertex_buffer_) {
+    vertex_buffer_->Release();
+    vertex_buffer_ = nullptr;
   }
 }
 
 bool ParticleSystemClass::UpdateBuffers() {
 
-  D3D11_MAPPED_SUBRESOURCE mappedResource;
+  // Sort the alive particles back to front in view space for blending.
+  sorter_.Sort(particles_, view_depth_, draw_order_);
 
-  memset(vertices_, 0, (sizeof(VertexType) * vertex_count_));
-
-  // Now build the vertex array from the particle list array.  Each particle is
-  // a quad made out of two triangles.
-  int index = 0;
-
-  for (int i = 0; i < current_particle_count_; i++) {
-    // Bottom left.
-    vertices_[index].position =
-        XMFLOAT3(particle_list_[i].positionX - particle_size_,
-                 particle_list_[i].positionY - particle_size_,
-                 particle_list_[i].positionZ);
-    vertices_[index].texture = XMFLOAT2(0.0f, 1.0f);
-    vertices_[index].color =
-        XMFLOAT4(particle_list_[i].red, particle_list_[i].green,
-                 particle_list_[i].blue, 1.0f);
-    index++;
-
-    // Top left.
-    vertices_[index].position =
-        XMFLOAT3(particle_list_[i].positionX - particle_size_,
-                 particle_list_[i].positionY + particle_size_,
-                 particle_list_[i].positionZ);
-    vertices_[index].texture = XMFLOAT2(0.0f, 0.0f);
-    vertices_[index].color =
-        XMFLOAT4(particle_list_[i].red, particle_list_[i].green,
-                 particle_list_[i].blue, 1.0f);
-    index++;
-
-    // Bottom right.
-    vertices_[index].position =
-        XMFLOAT3(particle_list_[i].positionX + particle_size_,
-                 particle_list_[i].positionY - particle_size_,
-                 particle_list_[i].positionZ);
-    vertices_[index].texture = XMFLOAT2(1.0f, 1.0f);
-    vertices_[index].color =
-        XMFLOAT4(particle_list_[i].red, particle_list_[i].green,
-                 particle_list_[i].blue, 1.0f);
-    index++;
-
-    // Bottom right.
-    vertices_[index].position =
-        XMFLOAT3(particle_list_[i].positionX + particle_size_,
-                 particle_list_[i].positionY - particle_size_,
-                 particle_list_[i].positionZ);
-    vertices_[index].texture = XMFLOAT2(1.0f, 1.0f);
-    vertices_[index].color =
-        XMFLOAT4(particle_list_[i].red, particle_list_[i].green,
-                 particle_list_[i].blue, 1.0f);
-    index++;
-
-    // Top left.
-    vertices_[index].position =
-        XMFLOAT3(particle_list_[i].positionX - particle_size_,
-                 particle_list_[i].positionY + particle_size_,
-                 particle_list_[i].positionZ);
-    vertices_[index].texture = XMFLOAT2(0.0f, 0.0f);
-    vertices_[index].color =
-        XMFLOAT4(particle_list_[i].red, particle_list_[i].green,
-                 particle_list_[i].blue, 1.0f);
-    index++;
-
-    // Top right.
-    vertices_[index].position =
-        XMFLOAT3(particle_list_[i].positionX + particle_size_,
-                 particle_list_[i].positionY + particle_size_,
-                 particle_list_[i].positionZ);
-    vertices_[index].texture = XMFLOAT2(1.0f, 0.0f);
-    vertices_[index].color =
-        XMFLOAT4(particle_list_[i].red, particle_list_[i].green,
-                 particle_list_[i].blue, 1.0f);
-    index++;
+  if (instanced_) {
+    return UpdateInstanceBuffer();
   }
 
+  return UpdateVertexBuffer();
+}
+
+bool ParticleSystemClass::UpdateVertexBuffer() {
+
+  D3D11_MAPPED_SUBRESOURCE mappedResource;
+
   auto device_context =
       DirectX11Device::GetD3d11DeviceInstance()->GetDeviceContext();
 
@@ -446,25 +345,127 @@ bool ParticleSystemClass::UpdateBuffers() {
     return false;
   }
 
-  VertexType *verticesPtr;
+  // Build the quads of the alive particles straight into the buffer. Each
+  // particle is a quad made out of two triangles; only the alive ones are
+  // written and drawn.
+  auto vertices = static_cast<VertexType *>(mappedResource.pData);
+
+  const float *position_x = particles_.GetPositionX();
+  const float *position_y = particles_.GetPositionY();
+  const float *position_z = particles_.GetPositionZ();
+  const float *red = particles_.GetRed();
+  const float *green = particles_.GetGreen();
+  const float *blue = particles_.GetBlue();
+
+  // Corner offsets and texture coordinates of the two triangles: bottom
+  // left, top left, bottom right, bottom right, top left, top right.
+  const float corner_x[6] = {-1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f};
+  const float corner_y[6] = {-1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f};
+
+  for (auto i : draw_order_) {
+    const XMFLOAT4 color(red[i], green[i], blue[i], 1.0f);
+    for (int corner = 0; corner < 6; corner++) {
+      vertices->position =
+          XMFLOAT3(position_x[i] + corner_x[corner] * particle_size_,
+                   position_y[i] + corner_y[corner] * particle_size_,
+                   position_z[i]);
+      vertices->texture = XMFLOAT2((corner_x[corner] + 1.0f) * 0.5f,
+                                   (1.0f - corner_y[corner]) * 0.5f);
+      vertices->color = color;
+      vertices++;
+    }
+  }
 
-  verticesPtr = (VertexType *)mappedResource.pData;
+  device_context->Unmap(vertex_buffer_, 0);
 
-  memcpy(verticesPtr, (void *)vertices_, (sizeof(VertexType) * vertex_count_));
+  return true;
+}
 
-  device_context->Unmap(vertex_buffer_, 0);
+bool ParticleSystemClass::UpdateInstanceBuffer() {
+
+  auto device_context =
+      DirectX11Device::GetD3d11DeviceInstance()->GetDeviceContext();
+
+  // The first write has to discard; so does a GPU that is too far behind
+  // to fence another frame.
+  auto discard = !instance_buffer_written_;
+
+  // Fence everything submitted so far, which closes the frame drawn last.
+  if (fence_count_ < kFramesInFlight) {
+    const int fence = (fence_first_ + fence_count_) % kFramesInFlight;
+    device_context->End(fences_[fence]);
+    fence_frames_[fence] = instance_ring_.EndFrame();
+    fence_count_++;
+  } else {
+    discard = true;
+  }
+
+  // Give back the ranges of the frames the GPU has finished, oldest first,
+  // without waiting for the others.
+  while (fence_count_ > 0 &&
+         device_context->GetData(fences_[fence_first_], nullptr, 0,
+                                 D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK) {
+    instance_ring_.Retire(fence_frames_[fence_first_]);
+    fence_first_ = (fence_first_ + 1) % kFramesInFlight;
+    fence_count_--;
+  }
+
+  instance_count_ = particles_.GetParticleCount();
+  start_instance_ = discard ? -1 : instance_ring_.Allocate(instance_count_);
+
+  // No room without touching a frame in flight: discard the buffer, which
+  // leaves the GPU its old memory and frees the whole ring.
+  if (start_instance_ < 0) {
+    instance_ring_.Reset();
+    fence_first_ = 0;
+    fence_count_ = 0;
+    start_instance_ = instance_ring_.Allocate(instance_count_);
+    discard = true;
+  }
+
+  D3D11_MAPPED_SUBRESOURCE mappedResource;
+
+  auto result = device_context->Map(
+      instance_buffer_, 0,
+      discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0,
+      &mappedResource);
+  if (FAILED(result)) {
+    return false;
+  }
+
+  // One instance per alive particle, straight into this frame's range.
+  auto instances = static_cast<ParticleInstanceType *>(mappedResource.pData);
+  PackParticleInstances(particles_, draw_order_, particle_size_,
+                        instances + start_instance_);
+
+  device_context->Unmap(instance_buffer_, 0);
+
+  instance_buffer_written_ = true;
 
   return true;
 }
 
 void ParticleSystemClass::RenderBuffers() {
 
-  unsigned int stride = sizeof(VertexType);
-  unsigned int offset = 0;
-
   auto device_context =
       DirectX11Device::GetD3d11DeviceInstance()->GetDeviceContext();
 
+  if (instanced_) {
+    unsigned int strides[2] = {sizeof(XMFLOAT2), sizeof(ParticleInstanceType)};
+    unsigned int offsets[2] = {0, 0};
+    ID3D11Buffer *buffers[2] = {quad_buffer_, instance_buffer_};
+
+    device_context->IASetVertexBuffers(0, 2, buffers, strides, offsets);
+
+    device_context->IASetPrimitiveTopology(
+        D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+
+    return;
+  }
+
+  unsigned int stride = sizeof(VertexType);
+  unsigned int offset = 0;
+
   device_context->IASetVertexBuffers(0, 1, &vertex_buffer_, &stride, &offset);
 
   device_context->IASetIndexBuffer(index_buffer_, DXGI_FORMAT_R32_UINT, 0);
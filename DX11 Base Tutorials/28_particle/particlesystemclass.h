@@ -1,8 +1,15 @@
 #pragma once
 
+#include <DirectXMath.h>
 #include <d3d11.h>
 
-struct ParticleType;
+#include <cstdint>
+#include <vector>
+
+#include "particlepoolclass.h"
+#include "particleringallocatorclass.h"
+#include "particlesortclass.h"
+
 struct VertexType;
 
 struct TextureClass;
@@ -20,7 +27,7 @@ public:
 
   void Shutdown();
 
-  bool Frame(float);
+  bool Frame(float, const DirectX::XMMATRIX &);
 
   void Render();
 
@@ -28,6 +35,16 @@ public:
 
   int GetIndexCount();
 
+  // With instancing every particle is one instance of a four-vertex quad
+  // strip, read from the instance ring buffer starting at GetStartInstance.
+  bool IsInstanced() const { return instanced_; }
+
+  int GetQuadVertexCount() const { return 4; }
+
+  int GetInstanceCount() const { return instance_count_; }
+
+  int GetStartInstance() const { return start_instance_; }
+
 private:
   bool LoadTexture(WCHAR *);
 
@@ -39,38 +56,62 @@ private:
 
   bool InitializeBuffers();
 
+  bool InitializeInstanceBuffers();
+
   void ShutdownBuffers();
 
-  void EmitParticles(float);
+  bool UpdateBuffers();
 
-  void UpdateParticles(float);
+  bool UpdateVertexBuffer();
 
-  void KillParticles();
-
-  bool UpdateBuffers();
+  bool UpdateInstanceBuffer();
 
   void RenderBuffers();
 
 private:
-  float particle_deviatio_x_, particle_deviation_y_, particle_deviation_z_;
-
-  float particle_velocity_, particle_velocity_variation_;
-
   float particle_size_, particles_per_second_;
 
   int max_particles_;
 
-  int current_particle_count_;
+  ParticlePoolClass particles_;
+
+  ParticleSortClass sorter_;
+
+  // Alive particles in back to front order, rebuilt every frame from the
+  // one before.
+  std::vector<std::uint32_t> draw_order_;
 
-  float accumulated_time_;
+  // Third column of the view matrix: weights of x, y, z and the offset that
+  // give the view-space depth of a particle.
+  float view_depth_[4] = {0.0f, 0.0f, 1.0f, 0.0f};
 
   TextureClass *texture_;
 
-  ParticleType *particle_list_;
+  // Instanced billboards by default; otherwise six vertices per particle
+  // are built on the CPU as the tutorial originally did.
+  bool instanced_ = true;
 
   int vertex_count_, index_count_;
 
-  VertexType *vertices_;
+  ID3D11Buffer *vertex_buffer_ = nullptr, *index_buffer_ = nullptr;
+
+  // Frames the GPU may be behind before the instance buffer is discarded
+  // instead of written without overwrite.
+  static const int kFramesInFlight = 3;
+
+  ID3D11Buffer *quad_buffer_ = nullptr, *instance_buffer_ = nullptr;
+
+  ParticleRingAllocatorClass instance_ring_;
+
+  bool instance_buffer_written_ = false;
+
+  // Event queries fencing the frames in flight, oldest first from
+  // fence_first_, with the ring frame each one closes.
+  ID3D11Query *fences_[kFramesInFlight] = {};
+
+  std::uint64_t fence_frames_[kFramesInFlight] = {};
+
+  int fence_first_ = 0, fence_count_ = 0;
 
-  ID3D11Buffer *vertex_buffer_, *index_buffer_;
+  int instance_count_ = 0, start_instance_ = 0;
 };
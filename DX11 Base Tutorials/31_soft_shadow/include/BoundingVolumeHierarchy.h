@@ -0,0 +1,154 @@
+#pragma once
+
+#include "BoundingVolume.h"
+#include "RenderTag.h"
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Object handed to BoundingVolumeHierarchy::Build(). Only the AABB of
+// bounds is used.
+struct BvhItem {
+  std::uint32_t id = 0;
+  BoundingVolume bounds;
+  TagMask tags = 0;
+};
+
+struct BvhRayHit {
+  std::uint32_t id = 0xffffffffu;
+  float distance = 0.0f;
+};
+
+// ============================================================================
+// BoundingVolumeHierarchy - dynamic AABB tree
+// ============================================================================
+
+// Binary AABB tree with one object per leaf. Build() creates the tree top
+// down with a binned surface area heuristic (SAH); Insert() and Remove()
+// change it incrementally, choosing the sibling with the lowest SAH cost
+// increase. Moving objects call Update() and then Refit() once per frame,
+// which recomputes every internal box bottom up without changing the
+// topology. GetSahCost() tells how far refits have degraded the tree, so
+// the owner can decide when to Build() again.
+//
+// Leaves carry a tag mask and internal nodes the OR of their children, so
+// tag-filtered queries (shadow casters) skip subtrees without a match.
+//
+// Queries reuse traversal stacks kept in the tree, so one tree must not be
+// queried from several threads at once.
+class BoundingVolumeHierarchy {
+public:
+  static constexpr int kNullNode = -1;
+
+  // Exact test for ray queries: returns true and the hit distance when the
+  // ray hits the object. Without one, the leaf AABB counts as the object.
+  using RayLeafTest = std::function<bool(std::uint32_t id, float &distance)>;
+
+  // Replaces the tree. When proxies is given, (*proxies)[i] receives the
+  // proxy of items[i].
+  void Build(const std::vector<BvhItem> &items,
+             std::vector<int> *proxies = nullptr);
+
+  int Insert(std::uint32_t id, const BoundingVolume &bounds, TagMask tags);
+
+  void Remove(int proxy);
+
+  // Changes a leaf. Internal boxes are stale until Refit().
+  void Update(int proxy, const BoundingVolume &bounds, TagMask tags);
+
+  // Recomputes internal boxes and tag masks after Update(); no-op when
+  // nothing changed.
+  void Refit();
+
+  void Clear();
+
+  // Ids of leaves intersecting the frustum, appended to out. Planes as in
+  // FrustumCuller::SetPlanes(). With a non-zero mask, only leaves sharing a
+  // tag with it are returned.
+  void QueryFrustum(const DirectX::XMFLOAT4 (&planes)[6],
+                    std::vector<std::uint32_t> &out, TagMask mask = 0) const;
+
+  // Objects tagged with caster_mask inside the light's frustum, appended to
+  // out. The light frustum usually covers casters the camera cannot see.
+  void QueryShadowCasters(const DirectX::XMFLOAT4 (&light_planes)[6],
+                          TagMask caster_mask,
+                          std::vector<std::uint32_t> &out) const {
+    QueryFrustum(light_planes, out, caster_mask);
+  }
+
+  // Nearest hit along the ray within max_distance. direction need not be
+  // normalized; distances are in units of its length.
+  bool Raycast(const DirectX::XMFLOAT3 &origin,
+               const DirectX::XMFLOAT3 &direction, float max_distance,
+               BvhRayHit &hit, const RayLeafTest &leaf_test = {}) const;
+
+  std::size_t GetLeafCount() const { return leaf_count_; }
+
+  std::size_t GetNodeCount() const {
+    return nodes_.size() - free_nodes_.size();
+  }
+
+  int GetHeight() const;
+
+  // Sum of internal node surface areas relative to the root's, as of the
+  // last Build() or Refit(). Lower is better.
+  float GetSahCost() const { return sah_cost_; }
+
+  std::uint32_t GetId(int proxy) const { return nodes_[proxy].id; }
+
+private:
+  struct Node {
+    DirectX::XMFLOAT3 min;
+    DirectX::XMFLOAT3 max;
+    int parent = kNullNode;
+    int left = kNullNode; // kNullNode for leaves
+    int right = kNullNode;
+    std::uint32_t id = 0;
+    TagMask tags = 0;
+
+    bool IsLeaf() const { return left == kNullNode; }
+  };
+
+  // Traversal stack entries of QueryFrustum() and Raycast().
+  struct FrustumEntry {
+    int node;
+    int active_planes;
+  };
+
+  struct RayEntry {
+    int node;
+    float distance;
+  };
+
+  struct BuildRef {
+    DirectX::XMFLOAT3 min;
+    DirectX::XMFLOAT3 max;
+    DirectX::XMFLOAT3 centroid;
+    std::size_t item;
+  };
+
+  int AllocateNode();
+  void FreeNode(int node);
+  int BuildRange(std::vector<BuildRef> &refs, std::size_t begin,
+                 std::size_t end, const std::vector<BvhItem> &items,
+                 std::vector<int> *proxies);
+  void RefitNode(int node);
+  void RefitAncestors(int node);
+
+  std::vector<Node> nodes_;
+  std::vector<int> free_nodes_;
+  int root_ = kNullNode;
+  std::size_t leaf_count_ = 0;
+  bool needs_refit_ = false;
+  float sah_cost_ = 0.0f;
+
+  // Scratch for Refit() and the queries, kept to avoid per-frame
+  // allocations.
+  std::vector<int> refit_order_;
+  std::vector<int> refit_stack_;
+  mutable std::vector<FrustumEntry> frustum_stack_;
+  mutable std::vector<RayEntry> ray_stack_;
+};
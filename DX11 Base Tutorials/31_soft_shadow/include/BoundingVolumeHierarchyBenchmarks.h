@@ -0,0 +1,7 @@
+#pragma once
+
+// Headless benchmark of the scene BVH: SAH build, incremental insert, refit
+// after moving objects, frustum queries against the flat FrustumCuller and
+// ray queries, for 10k to 1M boxes. Prints timings to stdout. Returns false
+// if the BVH and the flat culler disagree on the visible count.
+bool RunBoundingVolumeHierarchyBenchmarks();
@@ -0,0 +1,6 @@
+#pragma once
+
+// Executes the BoundingVolumeHierarchy unit tests: SAH build, incremental
+// insert/remove, refit, frustum, shadow caster and ray queries against brute
+// force. Returns true when all tests pass without runtime errors.
+bool RunBoundingVolumeHierarchyTests();
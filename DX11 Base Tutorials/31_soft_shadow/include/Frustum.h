@@ -33,6 +33,15 @@ public:
   // Test using bounding volume (prefer AABB for more precision)
   bool CheckBoundingVolume(const BoundingVolume &bounds) const;
 
+  // Plane equations (near, far, left, right, top, bottom), normals pointing
+  // inwards. Used to feed the batched FrustumCuller.
+  void GetPlanes(DirectX::XMFLOAT4 (&planes)[6]) const;
+
+  // Planes of any view * projection (e.g. a light's), in the same order and
+  // orientation as GetPlanes(). Uses the D3D clip volume 0 <= z <= w.
+  static void ExtractPlanes(const DirectX::XMMATRIX &view_projection,
+                            DirectX::XMFLOAT4 (&planes)[6]);
+
 private:
   DirectX::XMVECTOR planes_[6];
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "SceneStorage.h"
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct CullStats {
+  std::size_t tested = 0;
+  std::size_t visible = 0;
+  std::size_t coherent_rejects = 0; // Rejected by the cached plane alone
+};
+
+// ============================================================================
+// FrustumCuller - batched AABB vs frustum test over SoA bounds
+// ============================================================================
+
+// Tests four boxes per iteration against the six planes with SSE, using the
+// center/extent form: a box is outside a plane when
+// dot(n, c) + d + dot(|n|, e) < 0. This gives the same answer as
+// FrustumClass::CheckAABB without building the eight corners.
+//
+// The culler remembers which plane rejected each box last time and tries
+// that plane first (plane coherency), so boxes that stay outside usually cost
+// one plane test. The cache is indexed by dense index; when indices are
+// reshuffled it only loses its hint, never correctness.
+class FrustumCuller {
+public:
+  // Planes as (a, b, c, d), inside where a*x + b*y + c*z + d >= 0, in the
+  // order produced by FrustumClass::GetPlanes().
+  void SetPlanes(const DirectX::XMFLOAT4 (&planes)[6]);
+
+  // Fills visible with the ascending indices of boxes that intersect the
+  // frustum. Entries whose has_bounds is 0 are always reported visible.
+  void Cull(const WorldBoundsColumns &bounds,
+            std::vector<std::uint32_t> &visible);
+
+  void ResetCoherency() { last_plane_.clear(); }
+
+  const CullStats &GetLastStats() const { return stats_; }
+
+private:
+  static constexpr int kPlaneCount = 6;
+
+  // Planes (a, b, c, d) and |normal| (|a|, |b|, |c|, 0) for the extent term,
+  // one row each so the cached plane of four lanes is gathered with four
+  // loads and a transpose.
+  float planes_[kPlaneCount][4] = {};
+  float abs_normals_[kPlaneCount][4] = {};
+
+  std::vector<std::uint8_t> last_plane_;
+  CullStats stats_;
+};
@@ -0,0 +1,6 @@
+#pragma once
+
+// Headless benchmark comparing per-object FrustumClass::CheckBoundingVolume
+// against the batched FrustumCuller for 10k to 1M boxes. Prints timings to
+// stdout. Returns false if the two disagree on the visible count.
+bool RunFrustumCullerBenchmarks();
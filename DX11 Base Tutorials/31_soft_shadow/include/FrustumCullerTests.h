@@ -0,0 +1,6 @@
+#pragma once
+
+// Executes the FrustumCuller unit tests: agreement with the per-corner AABB
+// test, unbounded entries, batch tails and the plane coherency cache.
+// Returns true when all tests pass without runtime errors.
+bool RunFrustumCullerTests();
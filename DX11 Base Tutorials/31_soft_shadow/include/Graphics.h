@@ -5,6 +5,7 @@
 #include "../../CommonFramework2/Camera.h"
 #include "../../CommonFramework2/GraphicsBase.h"
 #include "Frustum.h"
+#include "FrustumCuller.h"
 #include "Light.h"
 #include "RenderGraph.h"
 #include "Scene.h"
@@ -65,6 +66,10 @@ public:
     rot_z_ = z;
   }
 
+  // Casts a ray from the camera through the mouse position and returns the
+  // nearest scene object it hits (by world AABB), or null.
+  std::shared_ptr<IRenderable> PickObject(int mouse_x, int mouse_y);
+
 private:
   bool InitializeDevice(int screenWidth, int screenHeight, HWND hwnd);
 
@@ -94,9 +99,11 @@ private:
   // Returns false if any shader fails reflection-based registration.
   bool RegisterShaderParameters();
 
-  // Frustum culling helper
-  bool IsObjectVisible(std::shared_ptr<IRenderable> renderable,
-                       const FrustumClass &frustum) const;
+  // World AABB used to cull an object outside the scene BVH. Returns false
+  // for objects that are always drawn (null, skip_culling).
+  bool GetCullingBounds(const std::shared_ptr<IRenderable> &renderable,
+                        DirectX::XMFLOAT3 &min_bounds,
+                        DirectX::XMFLOAT3 &max_bounds) const;
 
 private:
   struct SceneAssets {
@@ -112,13 +119,10 @@ private:
     } refraction;
   };
 
+  // The shadow map, blur chain and upsampled shadow are transient textures
+  // declared on the RenderGraph, which pools them by lifetime.
   struct RenderTargetAssets {
     std::shared_ptr<RenderTexture> shadow_depth;
-    std::shared_ptr<RenderTexture> shadow_map;
-    std::shared_ptr<RenderTexture> downsampled_shadow;
-    std::shared_ptr<RenderTexture> horizontal_blur;
-    std::shared_ptr<RenderTexture> vertical_blur;
-    std::shared_ptr<RenderTexture> upsampled_shadow;
     std::shared_ptr<RenderTexture> reflection_map;
   };
 
@@ -164,6 +168,26 @@ private:
 
   std::unique_ptr<FrustumClass> frustum_;
 
+  // Culling results from the scene BVH, reused every frame. Flags hold
+  // kCameraVisible and kShadowCaster bits per dense scene index.
+  static constexpr std::uint8_t kCameraVisible = 1;
+  static constexpr std::uint8_t kShadowCaster = 2;
+  TagMask caster_mask_ = 0;
+  std::vector<std::uint32_t> visible_entities_;
+  std::vector<std::uint32_t> caster_entities_;
+  std::vector<std::uint8_t> visible_flags_;
+
+  // Depth writers in the light frustum, drawn only by the depth pass.
+  std::vector<std::shared_ptr<IRenderable>> shadow_casters_;
+
+  // Objects the BVH does not index are culled in one batch: their scene
+  // positions and bounds are gathered here every frame.
+  FrustumCuller frustum_culler_;
+  WorldBoundsColumns unindexed_bounds_;
+  std::vector<std::uint32_t> unindexed_objects_;
+  std::vector<std::uint32_t> unindexed_visible_;
+  std::vector<std::uint8_t> object_visible_;
+
   std::unique_ptr<Text> text_;
   std::shared_ptr<Font> font_;
   std::shared_ptr<FontShader> font_shader_;
@@ -15,6 +15,6 @@ public:
 public:
   bool Initialize(HWND hwnd, ID3D11Device *device) override;
 
-  bool Render(int indexCount, const ShaderParameterContainer &parameters,
+  bool Render(int indexCount, const LayeredParameterView &parameters,
               ID3D11DeviceContext *deviceContext) const override;
 };
\ No newline at end of file
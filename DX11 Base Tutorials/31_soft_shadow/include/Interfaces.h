@@ -7,6 +7,10 @@
 #include <unordered_set>
 #include <vector>
 
+#include "BoundingVolume.h"
+#include "LayeredParameterView.h"
+#include "RenderTag.h"
+#include "SceneStorage.h"
 #include "ShaderParameter.h"
 
 // ============================================================================
@@ -31,7 +35,7 @@ public:
   virtual void Shutdown() = 0;
 
   virtual bool Render(int indexCount,
-                      const ShaderParameterContainer &parameters,
+                      const LayeredParameterView &parameters,
                       ID3D11DeviceContext *deviceContext) const = 0;
 };
 
@@ -43,11 +47,15 @@ class IRenderable {
 public:
   IRenderable() = default;
 
-  virtual ~IRenderable() = default;
+  virtual ~IRenderable() {
+    if (storage_) {
+      storage_->Destroy(entity_);
+    }
+  }
 
 public:
   virtual void Render(const IShader &shader,
-                      const ShaderParameterContainer &parameterContainer,
+                      const LayeredParameterView &parameterContainer,
                       ID3D11DeviceContext *deviceContext) const = 0;
 
   virtual DirectX::XMMATRIX GetWorldMatrix() const noexcept = 0;
@@ -56,26 +64,62 @@ public:
 
   virtual void SetParameterCallback(ShaderParameterCallback callback) = 0;
 
-  virtual ShaderParameterCallback GetParameterCallback() const = 0;
+  // Returned by reference so the per-draw path does not copy the callback.
+  virtual const ShaderParameterCallback &GetParameterCallback() const = 0;
 
   virtual const ShaderParameterContainer &GetObjectParameters() const {
     static ShaderParameterContainer empty_parameters;
     return empty_parameters;
   }
 
+  // Object-space bounds used for culling; false when the object has none.
+  virtual bool GetLocalBounds(BoundingVolume &bounds) const {
+    (void)bounds;
+    return false;
+  }
+
 public:
-  void AddTag(const std::string &tag) { tags_.insert(tag); }
+  void AddTag(const std::string &tag) {
+    tags_.insert(tag);
+    SetTagMask(tag_mask_ | TagRegistry::GetInstance().GetBit(tag));
+  }
 
-  void RemoveTag(const std::string &tag) { tags_.erase(tag); }
+  void RemoveTag(const std::string &tag) {
+    tags_.erase(tag);
+    SetTagMask(tag_mask_ & ~TagRegistry::GetInstance().FindBit(tag));
+  }
 
   bool HasTag(const std::string &tag) const {
     return tags_.find(tag) != tags_.end();
   }
 
+  // Per-pass filtering: true when the object carries any tag of mask.
+  bool HasAnyTag(TagMask mask) const { return (tag_mask_ & mask) != 0; }
+
+  TagMask GetTagMask() const { return tag_mask_; }
+
   const std::unordered_set<std::string> &GetTags() const { return tags_; }
 
+  // Handle into the SceneStorage holding this object's frame data; null and
+  // kInvalidEntity while the object is not part of a scene.
+  SceneStorage *GetSceneStorage() const { return storage_; }
+
+  EntityId GetEntityId() const { return entity_; }
+
 private:
+  friend class SceneStorage;
+
+  void SetTagMask(TagMask mask) {
+    tag_mask_ = mask;
+    if (storage_) {
+      storage_->SetTagMask(entity_, mask);
+    }
+  }
+
   std::unordered_set<std::string> tags_;
+  TagMask tag_mask_ = 0;
+  SceneStorage *storage_ = nullptr;
+  EntityId entity_ = kInvalidEntity;
 };
 
 // ============================================================================
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// Job System
+// ============================================================================
+
+// Counts outstanding jobs of one batch. A counter must outlive the jobs
+// submitted against it.
+class JobCounter {
+public:
+  bool IsDone() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+private:
+  friend class JobSystem;
+  std::atomic<int> pending_{0};
+};
+
+// Fixed pool of worker threads fed from one FIFO queue. Waiting threads help
+// by running queued jobs, so Wait() never deadlocks even with zero workers.
+class JobSystem {
+public:
+  using Job = std::function<void()>;
+
+  // worker_count == 0 picks DefaultWorkerCount().
+  explicit JobSystem(std::size_t worker_count = 0);
+
+  JobSystem(const JobSystem &) = delete;
+
+  JobSystem &operator=(const JobSystem &) = delete;
+
+  ~JobSystem();
+
+  void Submit(Job job, JobCounter &counter);
+
+  // Blocks until every job submitted against counter has finished.
+  void Wait(const JobCounter &counter);
+
+  // Calls func(i) for i in [0, count) on the workers and the calling thread,
+  // each taking the next index from a shared counter so uneven items
+  // balance themselves. Returns when every call has finished. Kept free of
+  // min and max so it can follow windows.h.
+  template <typename Func> void ParallelFor(int count, const Func &func);
+
+  // Process-wide pool for code that does not own one, created on first use.
+  static JobSystem &GetShared();
+
+  std::size_t GetWorkerCount() const { return workers_.size(); }
+
+  // 1..N on worker threads, 0 on any other thread.
+  static std::size_t GetCurrentWorkerIndex();
+
+  // One worker per hardware thread, minus the submitting thread.
+  static std::size_t DefaultWorkerCount();
+
+private:
+  struct QueuedJob {
+    Job job;
+    JobCounter *counter = nullptr;
+  };
+
+  void WorkerLoop(std::size_t worker_index);
+
+  // Pops and runs one job if available; returns false when the queue is
+  // empty.
+  bool TryRunOne();
+
+  void Run(QueuedJob &queued);
+
+  std::mutex mutex_;
+
+  std::condition_variable work_available_;
+
+  std::condition_variable job_finished_;
+
+  std::deque<QueuedJob> queue_;
+
+  std::vector<std::thread> workers_;
+
+  bool stopping_ = false;
+};
+
+template <typename Func>
+void JobSystem::ParallelFor(int count, const Func &func) {
+  if (count < 1) {
+    return;
+  }
+
+  std::atomic<int> next(0);
+  auto run = [&next, count, &func]() {
+    for (int i = next++; i < count; i = next++) {
+      func(i);
+    }
+  };
+
+  // The calling thread takes part, so a single item never leaves it.
+  auto helpers = workers_.size();
+  if (helpers > static_cast<std::size_t>(count - 1)) {
+    helpers = static_cast<std::size_t>(count - 1);
+  }
+  JobCounter counter;
+  for (std::size_t i = 0; i < helpers; ++i) {
+    Submit(run, counter);
+  }
+  // The helpers reference this frame, so they finish before a throw leaves.
+  try {
+    run();
+  } catch (...) {
+    Wait(counter);
+    throw;
+  }
+  Wait(counter);
+}
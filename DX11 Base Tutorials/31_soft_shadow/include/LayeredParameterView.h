@@ -0,0 +1,249 @@
+#pragma once
+
+#include "ShaderParameter.h"
+
+#include <DirectXMath.h>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// ============================================================================
+// Layered Parameter View
+// ============================================================================
+
+// Read-only view over a stack of parameter containers, ordered from lowest to
+// highest priority (global -> pass -> object -> callback). Lookups walk the
+// layers lazily instead of merging them into a new container, so a draw can
+// be described without any heap allocation. Locks follow the merge rules of
+// ShaderParameterContainer: the lowest layer that locks a parameter wins and
+// higher layers cannot override it.
+//
+// A single container converts implicitly, so existing call sites that pass a
+// ShaderParameterContainer to IShader::Render keep working.
+class LayeredParameterView {
+public:
+  using ParamValue = ShaderParameterContainer::ParamValue;
+
+  static constexpr std::size_t kMaxLayers = 6;
+
+  LayeredParameterView() = default;
+
+  LayeredParameterView(const ShaderParameterContainer &container) {
+    PushLayer(container);
+  }
+
+  // Layers are pushed lowest priority first. The view does not own them.
+  void PushLayer(const ShaderParameterContainer &layer) {
+    if (layer_count_ == kMaxLayers) {
+      throw std::runtime_error("LayeredParameterView: too many layers");
+    }
+    layers_[layer_count_++] = &layer;
+  }
+
+  void Reset() { layer_count_ = 0; }
+
+  std::size_t GetLayerCount() const { return layer_count_; }
+
+  // Returns the resolved value, or nullptr when no layer defines it.
+  const ParamValue *Find(ShaderParameterId id) const {
+    bool locked = false;
+    return Resolve(id, locked);
+  }
+
+  bool HasParameter(ShaderParameterId id) const {
+    return Find(id) != nullptr;
+  }
+
+  bool HasParameter(std::string_view name) const {
+    return Find(ShaderParameterRegistry::Find(name)) != nullptr;
+  }
+
+  bool IsLocked(ShaderParameterId id) const {
+    bool locked = false;
+    Resolve(id, locked);
+    return locked;
+  }
+
+  bool IsLocked(std::string_view name) const {
+    return IsLocked(ShaderParameterRegistry::Find(name));
+  }
+
+  ShaderParameterType GetType(std::string_view name) const {
+    const ParamValue *value = Find(ShaderParameterRegistry::Find(name));
+    if (value == nullptr) {
+      return ShaderParameterType::Unknown;
+    }
+    return std::visit(TypeOf{}, *value);
+  }
+
+  template <typename T> T Get(ShaderParameterId id) const {
+    const ParamValue *value = Find(id);
+    if (value == nullptr) {
+      throw std::runtime_error(
+          "Parameter not found: " +
+          (id == kInvalidShaderParameterId
+               ? std::string("<invalid id>")
+               : ShaderParameterRegistry::GetName(id)));
+    }
+    if (const auto *typed = std::get_if<T>(value)) {
+      return *typed;
+    }
+    throw std::runtime_error("Type mismatch for parameter: " +
+                             ShaderParameterRegistry::GetName(id));
+  }
+
+  template <typename T> T Get(std::string_view name) const {
+    const ShaderParameterId id = ShaderParameterRegistry::Find(name);
+    if (id == kInvalidShaderParameterId) {
+      throw std::runtime_error("Parameter not found: " + std::string(name));
+    }
+    return Get<T>(id);
+  }
+
+  template <typename T> bool TryGet(ShaderParameterId id, T &out) const {
+    const ParamValue *value = Find(id);
+    if (value == nullptr) {
+      return false;
+    }
+    if (const auto *typed = std::get_if<T>(value)) {
+      out = *typed;
+      return true;
+    }
+    return false;
+  }
+
+  template <typename T> bool TryGet(std::string_view name, T &out) const {
+    return TryGet<T>(ShaderParameterRegistry::Find(name), out);
+  }
+
+  float GetFloat(std::string_view name) const { return Get<float>(name); }
+
+  DirectX::XMMATRIX GetMatrix(std::string_view name) const {
+    return Get<DirectX::XMMATRIX>(name);
+  }
+
+  DirectX::XMFLOAT3 GetVector3(std::string_view name) const {
+    return Get<DirectX::XMFLOAT3>(name);
+  }
+
+  DirectX::XMFLOAT4 GetVector4(std::string_view name) const {
+    return Get<DirectX::XMFLOAT4>(name);
+  }
+
+  ID3D11ShaderResourceView *GetTexture(std::string_view name) const {
+    return Get<ID3D11ShaderResourceView *>(name);
+  }
+
+  // Materializes the view into a standalone container. Allocates; meant for
+  // debugging and validation, not for the draw path.
+  ShaderParameterContainer Flatten() const {
+    ShaderParameterContainer result;
+    for (std::size_t i = 0; i < layer_count_; ++i) {
+      result = ShaderParameterContainer::MergeWithPriority(result,
+                                                           *layers_[i]);
+    }
+    return result;
+  }
+
+private:
+  struct TypeOf {
+    ShaderParameterType operator()(const DirectX::XMMATRIX &) const {
+      return ShaderParameterType::Matrix;
+    }
+    ShaderParameterType operator()(const DirectX::XMFLOAT3 &) const {
+      return ShaderParameterType::Vector3;
+    }
+    ShaderParameterType operator()(const DirectX::XMFLOAT4 &) const {
+      return ShaderParameterType::Vector4;
+    }
+    ShaderParameterType operator()(float) const {
+      return ShaderParameterType::Float;
+    }
+    ShaderParameterType operator()(ID3D11ShaderResourceView *) const {
+      return ShaderParameterType::Texture;
+    }
+  };
+
+  const ParamValue *Resolve(ShaderParameterId id, bool &locked) const {
+    locked = false;
+    if (id == kInvalidShaderParameterId) {
+      return nullptr;
+    }
+    const ParamValue *resolved = nullptr;
+    for (std::size_t i = 0; i < layer_count_; ++i) {
+      bool layer_locked = false;
+      const ParamValue *value = layers_[i]->Find(id, layer_locked);
+      if (value == nullptr) {
+        continue;
+      }
+      resolved = value;
+      if (layer_locked) {
+        locked = true;
+        if (ShaderParameterContainer::IsStrictValidationEnabled()) {
+          ThrowIfOverriddenAbove(id, i);
+        }
+        break;
+      }
+    }
+    return resolved;
+  }
+
+  void ThrowIfOverriddenAbove(ShaderParameterId id, std::size_t layer) const {
+    for (std::size_t i = layer + 1; i < layer_count_; ++i) {
+      if (layers_[i]->HasParameter(id)) {
+        throw std::runtime_error(
+            std::string(
+                "StrictValidation: attempt to override locked parameter: ") +
+            ShaderParameterRegistry::GetName(id));
+      }
+    }
+  }
+
+  const ShaderParameterContainer *layers_[kMaxLayers] = {};
+
+  std::size_t layer_count_ = 0;
+};
+
+// ============================================================================
+// Per-Draw Parameters
+// ============================================================================
+
+// Reusable per-pass scratch for building a draw's LayeredParameterView. The
+// world matrix and the object's callback output are written into a scratch
+// container that is cleared, not reallocated, between draws. The base view
+// holds the global and pass layers and must not already contain more than
+// kMaxLayers - 2 layers.
+class PerDrawParameters {
+public:
+  const LayeredParameterView &
+  Prepare(const LayeredParameterView &base,
+          const ShaderParameterContainer &object_params,
+          const DirectX::XMMATRIX &world_matrix,
+          const ShaderParameterCallback &callback) {
+    static const ShaderParameterId world_matrix_id =
+        ShaderParameterRegistry::Intern("worldMatrix");
+
+    scratch_.Clear();
+    scratch_.SetValue(world_matrix_id, ParamValue(world_matrix),
+                      ShaderParameterContainer::ParameterOrigin::Object);
+    if (callback) {
+      auto origin_guard = scratch_.OverrideDefaultOrigin(
+          ShaderParameterContainer::ParameterOrigin::Callback);
+      callback(scratch_);
+    }
+
+    view_ = base;
+    view_.PushLayer(object_params);
+    view_.PushLayer(scratch_);
+    return view_;
+  }
+
+private:
+  using ParamValue = ShaderParameterContainer::ParamValue;
+
+  ShaderParameterContainer scratch_;
+
+  LayeredParameterView view_;
+};
@@ -0,0 +1,7 @@
+#pragma once
+
+// Executes the LayeredParameterView unit tests. Builds that define
+// LAYERED_PARAMETER_VIEW_COUNT_ALLOCATIONS also check that a frame of draws
+// performs no heap allocations in the parameter system.
+// Returns true when all tests pass without runtime errors.
+bool RunLayeredParameterViewTests();
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// ============================================================================
+// MappedFile - read-only memory-mapped file
+// ============================================================================
+
+// Maps a whole file into the address space so loaders can read it in place
+// without copying it into a buffer first. The view stays valid until
+// Close() or destruction.
+class MappedFile {
+public:
+  MappedFile() = default;
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  MappedFile(MappedFile &&other) noexcept;
+
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  // Fails for missing or empty files.
+  bool Open(const std::string &path);
+
+  void Close();
+
+  bool IsOpen() const { return data_ != nullptr; }
+
+  const std::uint8_t *GetData() const { return data_; }
+
+  std::size_t GetSize() const { return size_; }
+
+private:
+  const std::uint8_t *data_ = nullptr;
+  std::size_t size_ = 0;
+#ifdef _WIN32
+  void *file_ = nullptr;    // HANDLE
+  void *mapping_ = nullptr; // HANDLE
+#endif
+};
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "BoundingVolume.h"
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// Binary mesh container (.mesh)
+// ============================================================================
+//
+// Little-endian file, every section aligned to 16 bytes:
+//
+//   MeshFileHeader
+//   MeshAttribute[attribute_count]   vertex layout
+//   vertex data                      vertex_count * vertex_stride bytes
+//   index data                       index_count * index_size bytes
+//
+// Vertices are interleaved 32-bit floats, deduplicated and in first-use
+// order; indices are 16-bit when every vertex fits, 32-bit otherwise.
+// Bounds are stored so loaders need not touch the vertices. Readers reject
+// files whose version differs from kMeshFileVersion; a new version means
+// reconverting.
+
+enum class MeshSemantic : std::uint32_t {
+  Position = 0,
+  TexCoord = 1,
+  Normal = 2,
+  Tangent = 3,
+  Binormal = 4,
+};
+
+struct MeshAttribute {
+  MeshSemantic semantic = MeshSemantic::Position;
+  std::uint32_t components = 0; // 32-bit floats
+  std::uint32_t offset = 0;     // Bytes from the start of the vertex
+};
+
+constexpr std::uint32_t kMeshFileMagic = 0x4853454du; // "MESH"
+constexpr std::uint32_t kMeshFileVersion = 1;
+
+struct MeshFileHeader {
+  std::uint32_t magic = kMeshFileMagic;
+  std::uint32_t version = kMeshFileVersion;
+  std::uint32_t vertex_count = 0;
+  std::uint32_t index_count = 0;
+  std::uint32_t vertex_stride = 0; // Bytes
+  std::uint32_t index_size = 0;    // 2 or 4
+  std::uint32_t attribute_count = 0;
+  std::uint32_t flags = 0; // Reserved, 0
+  float aabb_min[3] = {};
+  float aabb_max[3] = {};
+  float sphere_center[3] = {};
+  float sphere_radius = 0.0f;
+  std::uint64_t attributes_offset = 0;
+  std::uint64_t vertices_offset = 0;
+  std::uint64_t indices_offset = 0;
+  std::uint64_t file_size = 0;
+};
+
+static_assert(sizeof(MeshAttribute) == 12, "MeshAttribute is on disk");
+static_assert(sizeof(MeshFileHeader) == 104, "MeshFileHeader is on disk");
+
+// Mesh in memory, as produced by converters and written by WriteMeshFile().
+struct MeshData {
+  std::vector<MeshAttribute> layout;
+  std::uint32_t vertex_stride = 0;   // Bytes
+  std::vector<float> vertices;       // Interleaved, vertex_stride / 4 each
+  std::vector<std::uint32_t> indices;
+  BoundingVolume bounds;
+
+  std::size_t GetVertexCount() const {
+    return vertex_stride == 0 ? 0 : vertices.size() * 4 / vertex_stride;
+  }
+};
+
+// Layouts of the RasterTek-style text models and of their PBR variant.
+const std::vector<MeshAttribute> &GetTextModelLayout();       // P3 T2 N3
+const std::vector<MeshAttribute> &GetTangentFrameModelLayout(); // + T3 B3
+
+bool WriteMeshFile(const std::string &path, const MeshData &mesh);
+
+// Locale-independent decimal float ("-1.5", "2e-3") at cursor, skipping
+// leading whitespace; advances cursor past it. Returns false if there is
+// none. Precise to the last digit for the six-digit values exporters write.
+bool ParseDecimalFloat(const char *&cursor, const char *end, float &value);
+
+// Parses a text model ("Vertex Count: N", "Data:", then N lines of
+// x y z tu tv nx ny nz; every three vertices form a triangle) into 8 floats
+// per vertex. Works on a buffer, so callers can hand it a mapped file.
+bool ParseTextModel(const char *text, std::size_t size,
+                    std::vector<float> &vertices);
+
+bool LoadTextModel(const std::string &path, std::vector<float> &vertices);
+
+// Turns the unindexed triangle list of a text model into an indexed mesh by
+// welding bit-identical vertices. With tangents, per-vertex tangent and
+// binormal (GenerateTangentFrames()) are appended to the welded vertices.
+void BuildIndexedMesh(const std::vector<float> &triangle_vertices,
+                      bool with_tangents, MeshData &mesh);
+
+// Offline conversion of a text model into a .mesh file, with the index
+// buffer reordered for the vertex cache (OptimizeMesh()).
+bool ConvertTextModel(const std::string &text_path,
+                      const std::string &mesh_path, bool with_tangents);
+
+// ============================================================================
+// MeshFile - memory-mapped .mesh reader
+// ============================================================================
+
+// Validates the container on Open() and then exposes the vertex and index
+// sections in place, ready to be passed to buffer creation.
+class MeshFile {
+public:
+  bool Open(const std::string &path);
+
+  void Close();
+
+  bool IsOpen() const { return header_ != nullptr; }
+
+  std::uint32_t GetVertexCount() const { return header_->vertex_count; }
+
+  std::uint32_t GetIndexCount() const { return header_->index_count; }
+
+  std::uint32_t GetVertexStride() const { return header_->vertex_stride; }
+
+  std::uint32_t GetIndexSize() const { return header_->index_size; }
+
+  const void *GetVertices() const {
+    return file_.GetData() + header_->vertices_offset;
+  }
+
+  const void *GetIndices() const {
+    return file_.GetData() + header_->indices_offset;
+  }
+
+  const MeshAttribute *GetAttributes() const {
+    return reinterpret_cast<const MeshAttribute *>(
+        file_.GetData() + header_->attributes_offset);
+  }
+
+  std::uint32_t GetAttributeCount() const {
+    return header_->attribute_count;
+  }
+
+  // True when the file's layout begins with the expected attributes, so a
+  // loader can read it with its own vertex type and the file's stride.
+  bool HasLayoutPrefix(const std::vector<MeshAttribute> &expected) const;
+
+  BoundingVolume GetBounds() const;
+
+private:
+  MappedFile file_;
+  const MeshFileHeader *header_ = nullptr;
+};
+
+// The .mesh file next to a text model ("data/cube.txt" -> "data/cube.mesh")
+// when it exists and is not older than the text model, else empty. A path
+// that already names a .mesh file is returned unchanged.
+std::string FindConvertedMesh(const std::string &text_path);
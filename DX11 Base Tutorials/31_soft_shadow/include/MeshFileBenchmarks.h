@@ -0,0 +1,7 @@
+#pragma once
+
+// Headless benchmark comparing the old istream text model loader, the
+// single-pass text parser and memory-mapped .mesh loading on a generated
+// grid, plus the vertex cache optimization of the conversion. Prints
+// timings and ACMR/ATVR to stdout. Returns false if the loaders disagree.
+bool RunMeshFileBenchmarks();
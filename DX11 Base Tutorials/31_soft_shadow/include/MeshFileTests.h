@@ -0,0 +1,6 @@
+#pragma once
+
+// Executes the MeshFile unit tests: text model parsing, vertex welding,
+// .mesh round trips with 16- and 32-bit indices and rejection of damaged
+// files. Returns true when all tests pass without runtime errors.
+bool RunMeshFileTests();
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "MeshFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// Mesh optimization for indexed triangle lists
+// ============================================================================
+//
+// Stages, in the order OptimizeMesh() runs them:
+//
+//   DeduplicateVertices()   weld bit-identical vertices
+//   OptimizeVertexCache()   reorder triangles for the post-transform cache
+//                           (Tipsify, Sander et al. 2007)
+//   OptimizeOverdraw()      order Tipsify's clusters front-facing-out first
+//   OptimizeVertexFetch()   renumber vertices in first-use order
+//
+// Vertices are opaque interleaved records of vertex_size bytes (a multiple
+// of 4), so every model class can run the stages on its own vertex type.
+// Only OptimizeOverdraw() reads them and expects the position as the first
+// three floats. The stages work offline (converters) and at load time.
+
+// Entries of the FIFO post-transform cache the statistics and Tipsify
+// assume; current GPUs behave like a cache of at least this size.
+constexpr std::size_t kVertexCacheSize = 16;
+
+struct VertexCacheStatistics {
+  std::size_t vertices_transformed = 0; // Cache misses
+  // Average cache miss ratio: transformed vertices per triangle. 3 is the
+  // worst case (no reuse); about 0.5 is the best a regular grid allows.
+  float acmr = 0.0f;
+  // Average transform to vertex ratio: transformed per unique vertex. 1
+  // means each vertex is transformed exactly once.
+  float atvr = 0.0f;
+};
+
+// Simulates a FIFO cache of cache_size entries over the index buffer.
+VertexCacheStatistics AnalyzeVertexCache(const std::uint32_t *indices,
+                                         std::size_t index_count,
+                                         std::size_t vertex_count,
+                                         std::size_t cache_size =
+                                             kVertexCacheSize);
+
+// Moves the first occurrence of each distinct vertex to the front, in
+// order, and rewrites indices to match. Returns the distinct vertex count;
+// the remaining records are left unspecified.
+std::size_t DeduplicateVertices(void *vertices, std::size_t vertex_count,
+                                std::size_t vertex_size,
+                                std::vector<std::uint32_t> &indices);
+
+// Reorders whole triangles so that consecutive triangles reuse cached
+// vertices. When clusters is given it receives the first index of every
+// cluster Tipsify started after its cache ran dry, for OptimizeOverdraw().
+void OptimizeVertexCache(std::vector<std::uint32_t> &indices,
+                         std::size_t vertex_count,
+                         std::size_t cache_size = kVertexCacheSize,
+                         std::vector<std::size_t> *clusters = nullptr);
+
+// Sorts the clusters so that those facing away from the mesh centre (the
+// ones most likely to occlude the rest) are drawn first. Triangle order
+// inside a cluster, and therefore most of the cache reuse, is kept.
+void OptimizeOverdraw(std::vector<std::uint32_t> &indices,
+                      const void *vertices, std::size_t vertex_size,
+                      const std::vector<std::size_t> &clusters);
+
+// Renumbers vertices in the order the index buffer first uses them, so the
+// vertex fetch walks memory forward, and drops unreferenced vertices.
+// Returns the new vertex count.
+std::size_t OptimizeVertexFetch(void *vertices, std::size_t vertex_count,
+                                std::size_t vertex_size,
+                                std::vector<std::uint32_t> &indices);
+
+struct MeshOptimizationReport {
+  std::size_t vertices_before = 0;
+  std::size_t vertices_after = 0;
+  VertexCacheStatistics cache_before;
+  VertexCacheStatistics cache_after;
+};
+
+// Runs every stage. Returns the new vertex count; the records past it are
+// left unspecified for the caller to trim.
+std::size_t OptimizeMesh(void *vertices, std::size_t vertex_count,
+                         std::size_t vertex_size,
+                         std::vector<std::uint32_t> &indices,
+                         MeshOptimizationReport *report = nullptr);
+
+// Runs every stage on a converted mesh and trims its vertices.
+MeshOptimizationReport OptimizeMesh(MeshData &mesh);
@@ -0,0 +1,6 @@
+#pragma once
+
+// Executes the MeshOptimizer unit tests on synthetic grids: cache
+// statistics, vertex welding, Tipsify, overdraw cluster order and vertex
+// fetch order. Returns true when all tests pass without runtime errors.
+bool RunMeshOptimizerTests();
@@ -33,12 +33,12 @@ public:
   void Shutdown();
 
   void Render(const IShader &shader,
-              const ShaderParameterContainer &parameterContainer,
+              const LayeredParameterView &parameterContainer,
               ID3D11DeviceContext *deviceContext) const override;
 
   void SetParameterCallback(ShaderParameterCallback callback) override;
 
-  ShaderParameterCallback GetParameterCallback() const override;
+  const ShaderParameterCallback &GetParameterCallback() const override;
 
   int GetIndexCount() const { return index_count_; }
 
@@ -48,10 +48,12 @@ public:
 
   void SetWorldMatrix(const DirectX::XMMATRIX &worldMatrix) override {
     world_matrix_ = worldMatrix;
+    world_bounds_dirty_ = true;
   }
 
   const BoundingVolume &GetLocalBoundingVolume() const;
 
+  // Cached; recomputed only after the world matrix changes.
   BoundingVolume GetWorldBoundingVolume() const;
 
 private:
@@ -65,6 +67,9 @@ private:
 
   bool LoadModel(const std::string &filename);
 
+  // Binary .mesh: buffers are created from the mapped file.
+  bool LoadMesh(const std::string &filename, ID3D11Device *device);
+
   void ReleaseModel();
 
   void CalculateBoundingVolume(); // Calculate bounding volume
@@ -87,6 +92,8 @@ private:
 
   int vertex_count_ = 0;
   int index_count_ = 0;
+  UINT vertex_stride_ = sizeof(Vertex);
+  DXGI_FORMAT index_format_ = DXGI_FORMAT_R32_UINT;
 
   std::unique_ptr<DDSTexture> texture_;
 
@@ -95,6 +102,9 @@ private:
   DirectX::XMMATRIX world_matrix_ = DirectX::XMMatrixIdentity();
 
   BoundingVolume bounding_volume_; // Bounding volume in local space
+
+  mutable BoundingVolume world_bounding_volume_;
+  mutable bool world_bounds_dirty_ = true;
 };
 
 class PBRModel : IRenderable {
@@ -111,18 +121,6 @@ private:
     float x, y, z;
     float tu, tv;
     float nx, ny, nz;
-    float tx, ty, tz;
-    float bx, by, bz;
-  };
-
-  struct TempVertexType {
-    float x, y, z;
-    float tu, tv;
-    float nx, ny, nz;
-  };
-
-  struct VectorType {
-    float x, y, z;
   };
 
 public:
@@ -145,12 +143,12 @@ public:
   void Shutdown();
 
   void Render(const IShader &shader,
-              const ShaderParameterContainer &parameterContainer,
+              const LayeredParameterView &parameterContainer,
               ID3D11DeviceContext *deviceContext) const override;
 
   void SetParameterCallback(ShaderParameterCallback callback) override;
 
-  ShaderParameterCallback GetParameterCallback() const override;
+  const ShaderParameterCallback &GetParameterCallback() const override;
 
   int GetIndexCount() const { return index_count_; }
 
@@ -174,10 +172,8 @@ private:
 
   bool LoadModel(const char *);
 
-  void CalculateModelVectors();
-
-  void CalculateTangentBinormal(TempVertexType, TempVertexType, TempVertexType,
-                                VectorType &, VectorType &);
+  // Binary .mesh converted with tangent frames.
+  bool LoadMesh(const std::string &filename, ID3D11Device *device);
 
 private:
   Microsoft::WRL::ComPtr<ID3D11Buffer> vertex_buffer_;
@@ -185,6 +181,7 @@ private:
 
   int vertex_count_ = 0;
   int index_count_ = 0;
+  DXGI_FORMAT index_format_ = DXGI_FORMAT_R32_UINT;
 
   std::unique_ptr<TGATexture[]> textures_;
 
@@ -26,12 +26,12 @@ public:
   void Shutdown();
 
   void Render(const IShader &shader,
-              const ShaderParameterContainer &parameterContainer,
+              const LayeredParameterView &parameterContainer,
               ID3D11DeviceContext *deviceContext) const override;
 
   void SetParameterCallback(ShaderParameterCallback callback) override;
 
-  ShaderParameterCallback GetParameterCallback() const override;
+  const ShaderParameterCallback &GetParameterCallback() const override;
 
   int GetIndexCount() const;
 
@@ -46,7 +46,7 @@ private:
 
   void ShutdownBuffers();
 
-  void RenderBuffers() const;
+  void RenderBuffers(ID3D11DeviceContext *) const;
 
 private:
   Microsoft::WRL::ComPtr<ID3D11Buffer> vertex_buffer_, index_buffer_;
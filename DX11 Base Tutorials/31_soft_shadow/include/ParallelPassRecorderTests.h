@@ -0,0 +1,7 @@
+#pragma once
+
+// Executes the JobSystem and ParallelPassRecorder unit tests against a mock
+// command backend: submission order, worker usage, immediate-only passes,
+// error propagation and per-pass timings.
+// Returns true when all tests pass without runtime errors.
+bool RunParallelPassRecorderTests();
@@ -12,7 +12,7 @@ public:
 
   void Shutdown() override;
 
-  bool Render(int indexCount, const ShaderParameterContainer &parameters,
+  bool Render(int indexCount, const LayeredParameterView &parameters,
               ID3D11DeviceContext *deviceContext) const override;
 
 private:
@@ -1,5 +1,9 @@
 #pragma once
 
+#include "ParallelPassRecorder.h"
+#include "RenderGraphCompiler.h"
+#include "RenderTag.h"
+
 #include <DirectXMath.h>
 #include <d3d11.h>
 #include <functional>
@@ -8,18 +12,28 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
+#include <wrl/client.h>
 
 class RenderTexture;
 class IShader;
 class IRenderable;
 class ShaderParameterContainer;
 class ShaderParameterValidator;
+class ShaderBindingPlan;
+class JobSystem;
 
-// Minimal resource record used by current implementation.
+// Resource record: either imported, or declared and allocated by Compile().
 struct GraphResource {
   std::string name;
   std::shared_ptr<RenderTexture> texture; // Provided or allocated.
   bool is_external = false;               // Imported from ResourceManager.
+
+  // Declaration of a transient texture.
+  int width = 0;
+  int height = 0;
+  float depth = 100.0f;
+  float near_plane = 0.1f;
+  int physical_index = -1; // Pool slot assigned by Compile(), -1 if unused.
 };
 
 class RenderGraphPass;
@@ -50,6 +64,7 @@ class RenderGraphPass {
 public:
   explicit RenderGraphPass(const std::string &name);
   const std::string &GetName() const { return name_; }
+  const std::shared_ptr<IShader> &GetShader() const { return shader_; }
   RenderGraphPassBuilder GetBuilder();
 
   void Execute(std::vector<std::shared_ptr<IRenderable>> &renderables,
@@ -61,18 +76,17 @@ private:
   friend class RenderGraphPassBuilder;
   friend class RenderGraph;
 
-  // Merge parameters in priority order: pass -> global -> input textures
-  // Returns merged parameter container ready for object-level customization
-  ShaderParameterContainer
-  MergeParameters(const ShaderParameterContainer &global_params) const;
-
   std::string name_;
   std::shared_ptr<IShader> shader_;
   std::vector<std::string> input_resources_;
   std::string output_resource_;
   std::vector<std::string> render_tags_;
+  TagMask render_tag_mask_ = 0; // Bits of render_tags_, 0 draws everything.
+  // Drawn instead of the renderables passed to Execute() when set.
+  std::vector<std::shared_ptr<IRenderable>> *renderables_ = nullptr;
   std::shared_ptr<ShaderParameterContainer> pass_parameters_;
   bool disable_z_buffer_ = false;
+  bool record_on_immediate_ = false;
 
   using ExecuteFunc = std::function<void(RenderPassContext &)>;
   ExecuteFunc custom_execute_;
@@ -91,6 +105,10 @@ private:
   // for Compile() to match against shader reflection
   std::unordered_map<std::string, std::vector<std::string>>
       resource_candidates_;
+
+  // Plan compiled from the shader's reflection (null when the shader uses
+  // by-name binding)
+  std::shared_ptr<const ShaderBindingPlan> binding_plan_;
 };
 
 class RenderGraphPassBuilder {
@@ -100,7 +118,14 @@ public:
   RenderGraphPassBuilder &Read(const std::string &resource_name);
   RenderGraphPassBuilder &Write(const std::string &resource_name);
   RenderGraphPassBuilder &AddRenderTag(const std::string &tag);
+  // Draw this list instead of the one the graph is executed with, e.g. the
+  // shadow casters for a depth pass. The list must outlive the graph.
+  RenderGraphPassBuilder &
+  SetRenderables(std::vector<std::shared_ptr<IRenderable>> *renderables);
   RenderGraphPassBuilder &DisableZBuffer(bool disable = true);
+  // Keep this pass on the immediate context when parallel recording is on,
+  // e.g. because it updates resources through the immediate context.
+  RenderGraphPassBuilder &RecordOnImmediateContext(bool immediate = true);
   RenderGraphPassBuilder &SetParameter(const std::string &name,
                                        const DirectX::XMMATRIX &value);
   RenderGraphPassBuilder &SetParameter(const std::string &name, float value);
@@ -126,13 +151,21 @@ private:
 
 class RenderGraph {
 public:
+  RenderGraph();
+  ~RenderGraph();
+
   void Initialize(ID3D11Device *device, ID3D11DeviceContext *context);
-  void DeclareTexture(
-      const std::string &name, int width, int height, float depth = 100.0f,
-      float nearPlane = 0.1f); // Currently unused but kept for future.
+  // Transient texture owned by the graph. Compile() allocates it from a pool
+  // and may share the allocation with other transient textures of the same
+  // size whose lifetimes do not overlap, so its projection/ortho matrices
+  // are not guaranteed to come from this declaration.
+  void DeclareTexture(const std::string &name, int width, int height,
+                      float depth = 100.0f, float nearPlane = 0.1f);
   void ImportTexture(const std::string &name,
                      std::shared_ptr<RenderTexture> texture);
   RenderGraphPassBuilder AddPass(const std::string &name);
+  // Orders passes by their resource dependencies, culls passes whose output
+  // is never consumed and allocates transient textures.
   bool Compile();
   void Execute(std::vector<std::shared_ptr<IRenderable>> &renderables,
                const ShaderParameterContainer &global_params);
@@ -142,6 +175,17 @@ public:
                      const ShaderParameterContainer &global_params,
                      bool &back_buffer_depth_cleared);
 
+  // Records passes into deferred contexts on worker threads and executes the
+  // command lists in schedule order. Passes marked RecordOnImmediateContext()
+  // run on the immediate context at their place in the schedule.
+  // worker_count == 0 picks JobSystem::DefaultWorkerCount().
+  bool EnableParallelRecording(bool enable, std::size_t worker_count = 0);
+  bool IsParallelRecordingEnabled() const { return job_system_ != nullptr; }
+
+  // CPU timings of the last ExecutePasses(), serial or parallel.
+  const FrameRecordTiming &GetPassTimings() const { return pass_timings_; }
+  void PrintPassTimings() const;
+
   std::shared_ptr<RenderTexture> GetTexture(const std::string &name) const;
   void Clear();
   void PrintGraph() const; // Detailed debug: resources, passes, bindings.
@@ -155,15 +199,31 @@ public:
   }
 
 private:
-  void AllocateResources();
+  struct PooledTexture {
+    RenderGraphTextureDesc desc;
+    std::shared_ptr<RenderTexture> texture;
+  };
+
+  bool AllocateResources(const RenderGraphSchedule &schedule,
+                         const std::vector<std::string> &resource_names);
   bool ValidatePassParameters(std::shared_ptr<RenderGraphPass> &pass) const;
+  bool EnsureDeferredContexts(std::size_t count);
   ID3D11Device *device_ = nullptr;
   ID3D11DeviceContext *context_ = nullptr;
   std::unordered_map<std::string, GraphResource> resources_;
   std::vector<std::shared_ptr<RenderGraphPass>> passes_;
   std::vector<std::shared_ptr<RenderGraphPass>> sorted_passes_;
+  std::vector<std::shared_ptr<RenderGraphPass>> culled_passes_;
+  std::vector<PooledTexture> texture_pool_;
   bool compiled_ = false;
 
+  // Parallel recording: one deferred context and command list per schedule
+  // position.
+  std::unique_ptr<JobSystem> job_system_;
+  std::vector<Microsoft::WRL::ComPtr<ID3D11DeviceContext>> deferred_contexts_;
+  std::vector<Microsoft::WRL::ComPtr<ID3D11CommandList>> command_lists_;
+  FrameRecordTiming pass_timings_;
+
   // Parameter validation
   ShaderParameterValidator *parameter_validator_ = nullptr;
   bool enable_parameter_validation_ = true;
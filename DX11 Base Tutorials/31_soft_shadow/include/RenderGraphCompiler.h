@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// Render Graph Compiler
+// ============================================================================
+
+// Physical properties that decide whether two transient textures can share
+// one allocation. Depth/near planes only feed the CPU-side matrices of a
+// RenderTexture, so they are not part of the key.
+struct RenderGraphTextureDesc {
+  int width = 0;
+  int height = 0;
+  std::uint32_t format = 0;
+
+  bool operator==(const RenderGraphTextureDesc &other) const {
+    return width == other.width && height == other.height &&
+           format == other.format;
+  }
+
+  bool operator!=(const RenderGraphTextureDesc &other) const {
+    return !(*this == other);
+  }
+};
+
+struct RenderGraphResourceNode {
+  std::string name;
+  RenderGraphTextureDesc desc;
+  // Imported textures are owned outside the graph: they are never aliased and
+  // passes writing them are never culled.
+  bool is_external = false;
+};
+
+struct RenderGraphPassNode {
+  std::string name;
+  std::vector<std::string> reads;
+  std::string write; // Empty when the pass renders to the back buffer.
+};
+
+// Inclusive range of schedule positions during which a resource must stay
+// intact (first write to last read). -1 when the resource is not used.
+struct RenderGraphResourceLifetime {
+  int first = -1;
+  int last = -1;
+};
+
+struct RenderGraphSchedule {
+  // Pass indices in execution order; culled passes are omitted.
+  std::vector<std::size_t> order;
+  // Pass indices removed because nothing consumes their output.
+  std::vector<std::size_t> culled;
+  // Indexed like the resource list.
+  std::vector<RenderGraphResourceLifetime> lifetimes;
+  // Physical texture per resource; -1 for imported or unused resources.
+  std::vector<int> physical_index;
+  std::vector<RenderGraphTextureDesc> physical_textures;
+};
+
+// Device-independent core of RenderGraph::Compile(). Builds the dependency
+// DAG from pass reads/writes, orders it topologically (declaration order
+// breaks ties, back-buffer passes keep their relative order), culls passes
+// whose outputs never reach the back buffer or an imported texture, and
+// assigns transient textures with disjoint lifetimes and matching
+// descriptions to shared physical textures.
+class RenderGraphCompiler {
+public:
+  // Returns false and describes the problem in error for undeclared
+  // resources, transient resources read but never written, resources with
+  // several writers, and dependency cycles (reported as "A -> B -> A").
+  static bool Compile(const std::vector<RenderGraphResourceNode> &resources,
+                      const std::vector<RenderGraphPassNode> &passes,
+                      RenderGraphSchedule &schedule, std::string &error);
+};
@@ -0,0 +1,6 @@
+#pragma once
+
+// Executes the RenderGraphCompiler unit tests: scheduling, cycle reporting,
+// pass culling and transient texture aliasing on device-free graphs.
+// Returns true when all tests pass without runtime errors.
+bool RunRenderGraphCompilerTests();
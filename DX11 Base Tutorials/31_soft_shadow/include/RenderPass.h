@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "Interfaces.h"
+#include "RenderTag.h"
 #include "RenderTexture.h"
 
 class RenderPass {
@@ -32,9 +33,15 @@ public:
 
   const std::string &GetName() const { return pass_name_; }
 
-  void AddRenderTag(const std::string &tag) { render_tags_.insert(tag); }
+  void AddRenderTag(const std::string &tag) {
+    render_tags_.insert(tag);
+    render_tag_mask_ |= TagRegistry::GetInstance().GetBit(tag);
+  }
 
-  void RemoveRenderTag(const std::string &tag) { render_tags_.erase(tag); }
+  void RemoveRenderTag(const std::string &tag) {
+    render_tags_.erase(tag);
+    render_tag_mask_ &= ~TagRegistry::GetInstance().FindBit(tag);
+  }
 
   bool ShouldRenderObject(const IRenderable &object) const;
 
@@ -51,5 +58,7 @@ private:
 
   std::unordered_set<std::string> render_tags_;
 
+  TagMask render_tag_mask_ = 0;
+
   bool need_turn_z_buffer_off_ = false;
 };
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One bit per render tag; an object's tags and a pass's tag filter are both
+// masks, so filtering is a single AND.
+using TagMask = std::uint64_t;
+
+// Assigns mask bits to tag names on first use. Registration happens while
+// the scene and graph are built; lookups are safe from any thread.
+class TagRegistry {
+public:
+  static constexpr std::size_t kMaxTags = 64;
+
+  static TagRegistry &GetInstance();
+
+  TagRegistry(const TagRegistry &) = delete;
+
+  TagRegistry &operator=(const TagRegistry &) = delete;
+
+  // Bit for tag, registering it if needed. Returns 0 (and logs) once all
+  // kMaxTags bits are taken.
+  TagMask GetBit(const std::string &tag);
+
+  // Bit for an already registered tag, 0 otherwise.
+  TagMask FindBit(const std::string &tag) const;
+
+  TagMask MakeMask(const std::vector<std::string> &tags);
+
+  // Registered names of the bits set in mask, in bit order.
+  std::vector<std::string> GetNames(TagMask mask) const;
+
+  std::size_t GetTagCount() const;
+
+private:
+  TagRegistry() = default;
+
+  mutable std::mutex mutex_;
+
+  std::unordered_map<std::string, TagMask> bits_;
+
+  std::vector<std::string> names_; // Indexed by bit position.
+};
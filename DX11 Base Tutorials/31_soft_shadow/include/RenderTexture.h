@@ -19,8 +19,12 @@ public:
 
   void SetRenderTarget();
 
+  void SetRenderTarget(ID3D11DeviceContext *);
+
   void ClearRenderTarget(float, float, float, float);
 
+  void ClearRenderTarget(ID3D11DeviceContext *, float, float, float, float);
+
   ID3D11ShaderResourceView *GetShaderResourceView() const;
 
   void GetProjectionMatrix(DirectX::XMMATRIX &) const;
@@ -31,20 +31,22 @@ public:
 
   virtual ~RenderableObject() = default;
 
-  void Render(const IShader &shader, const ShaderParameterContainer &parameters,
+  void Render(const IShader &shader, const LayeredParameterView &parameters,
               ID3D11DeviceContext *deviceContext) const override;
 
   DirectX::XMMATRIX GetWorldMatrix() const noexcept override;
 
   void SetParameterCallback(ShaderParameterCallback callback) override;
 
-  ShaderParameterCallback GetParameterCallback() const override;
+  const ShaderParameterCallback &GetParameterCallback() const override;
 
   const ShaderParameterContainer &GetObjectParameters() const override;
 
   void SetObjectParameters(const ShaderParameterContainer &params);
 
-  void SetWorldMatrix(const DirectX::XMMATRIX &worldMatrix);
+  void SetWorldMatrix(const DirectX::XMMATRIX &worldMatrix) override;
+
+  bool GetLocalBounds(BoundingVolume &bounds) const override;
 
   // Get world-space bounding volume (for frustum culling)
   BoundingVolume GetWorldBoundingVolume() const;
@@ -62,7 +64,14 @@ private:
 
   ShaderParameterContainer object_parameters_;
 
+  // Authoritative only while detached; attached objects read and write the
+  // scene storage.
   DirectX::XMMATRIX world_matrix_ = DirectX::XMMatrixIdentity();
 
+  // World bounds of a detached object, recomputed after world_matrix_
+  // changes.
+  mutable BoundingVolume world_bounds_;
+  mutable bool world_bounds_dirty_ = true;
+
   ShaderParameterCallback parameter_callback_;
 };
\ No newline at end of file
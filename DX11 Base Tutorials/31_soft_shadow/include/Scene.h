@@ -6,8 +6,10 @@
 #include <unordered_map>
 #include <vector>
 
+#include "BoundingVolumeHierarchy.h"
 #include "Interfaces.h"
 #include "RenderableObject.h"
+#include "SceneStorage.h"
 
 // Forward declarations
 class Model;
@@ -19,20 +21,6 @@ class IShader;
 // Include nlohmann/json in header to avoid symbol conflicts
 #include <nlohmann/json.hpp>
 
-// Animation configuration structure
-struct AnimationConfig {
-  enum class RotationAxis { X, Y, Z };
-
-  bool enabled = false;
-  RotationAxis axis = RotationAxis::Y;
-  float speed = 0.0f;   // Degrees per second
-  float initial = 0.0f; // Initial angle in degrees
-
-  AnimationConfig() = default;
-  AnimationConfig(RotationAxis axis, float speed, float initial = 0.0f)
-      : enabled(true), axis(axis), speed(speed), initial(initial) {}
-};
-
 // StandardRenderGroup forward declaration
 class StandardRenderGroup;
 
@@ -65,32 +53,45 @@ public:
   // Get specific renderable (for special handling like diffuse_lighting_cube)
   std::shared_ptr<IRenderable> GetRenderable(const std::string &name) const;
 
-  // Add a renderable object to the scene
+  // Add a renderable object to the scene; it becomes a handle into the
+  // scene storage
   void AddRenderable(std::shared_ptr<IRenderable> renderable);
 
   // Clear all renderable objects
   void Clear();
 
-  // Update scene (for animations, etc.)
+  // Advance animations stored in the scene storage and bring world bounds
+  // of moved objects up to date
   void Update(float deltaTime);
 
+  // Objects whose transform changed since the previous Update()
+  std::size_t GetChangedObjectCount() const { return changed_objects_; }
+
+  // Packed transforms, bounds, tag masks and animation of all objects
+  const SceneStorage &GetStorage() const { return storage_; }
+
+  // Brings the BVH over the objects' world bounds up to date with the
+  // storage: inserts, removals and refits for what changed since the last
+  // call, or a full SAH rebuild when refits have degraded the tree. Call
+  // once per frame before querying. Leaf ids are EntityIds.
+  void UpdateSpatialIndex();
+
+  const BoundingVolumeHierarchy &GetSpatialIndex() const {
+    return spatial_index_;
+  }
+
+  // Nearest object whose world AABB the ray hits, or null. Uses the spatial
+  // index as of the last UpdateSpatialIndex().
+  std::shared_ptr<IRenderable> Pick(const DirectX::XMFLOAT3 &origin,
+                                    const DirectX::XMFLOAT3 &direction,
+                                    float max_distance,
+                                    float *distance = nullptr) const;
+
 public:
   // Get animation configuration for a renderable object
   const AnimationConfig &
   GetAnimationConfig(std::shared_ptr<IRenderable> renderable) const;
 
-  // Get initial transform for a renderable object (for animation)
-  const DirectX::XMMATRIX &
-  GetInitialTransform(std::shared_ptr<IRenderable> renderable) const;
-
-  // Animation state management
-  // Get rotation state for an animated object (used by Graphics::Frame)
-  float &GetRotationState(std::shared_ptr<IRenderable> renderable);
-
-  // Clean up animation states for objects that no longer exist
-  void CleanupAnimationStates(
-      const std::vector<std::shared_ptr<IRenderable>> &active_objects);
-
 private:
   // Helper functions for creating different types of objects
   std::shared_ptr<RenderableObject> CreateTexturedModelObject(
@@ -137,16 +138,23 @@ private:
   // Helper: Parse animation from JSON
   AnimationConfig ParseAnimation(const nlohmann::json &animation_json) const;
 
+  void RebuildSpatialIndex();
+
+  void SyncSpatialProxy(EntityId entity);
+
 private:
+  // Declared first so it outlives the objects attached to it.
+  SceneStorage storage_;
   std::vector<std::shared_ptr<IRenderable>> renderable_objects_;
   std::unordered_map<std::string, std::shared_ptr<IRenderable>>
       named_renderables_;
-  // Store animation configs for each renderable object
-  std::unordered_map<std::shared_ptr<IRenderable>, AnimationConfig>
-      animation_configs_;
-  // Store initial transforms for animated objects
-  std::unordered_map<std::shared_ptr<IRenderable>, DirectX::XMMATRIX>
-      initial_transforms_;
-  // Store rotation states for animated objects (used by Graphics::Frame)
-  std::unordered_map<std::shared_ptr<IRenderable>, float> rotation_states_;
+
+  // Spatial index over storage_ world bounds
+  BoundingVolumeHierarchy spatial_index_;
+  std::vector<int> spatial_proxies_; // EntityId -> BVH proxy
+  SceneStorage::ChangeJournal spatial_changes_;
+  bool spatial_index_built_ = false;
+  float built_sah_cost_ = 0.0f;
+
+  std::size_t changed_objects_ = 0;
 };
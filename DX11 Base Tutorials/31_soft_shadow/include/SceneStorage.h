@@ -0,0 +1,181 @@
+#pragma once
+
+#include "BoundingVolume.h"
+#include "RenderTag.h"
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class IRenderable;
+
+using EntityId = std::uint32_t;
+
+constexpr EntityId kInvalidEntity = 0xffffffffu;
+
+// Animation configuration structure
+struct AnimationConfig {
+  enum class RotationAxis { X, Y, Z };
+
+  bool enabled = false;
+  RotationAxis axis = RotationAxis::Y;
+  float speed = 0.0f;   // Degrees per second
+  float initial = 0.0f; // Initial angle in degrees
+
+  AnimationConfig() = default;
+  AnimationConfig(RotationAxis axis, float speed, float initial = 0.0f)
+      : enabled(true), axis(axis), speed(speed), initial(initial) {}
+};
+
+// World-space bounds of every entity, one column per component so culling
+// can stream through them. has_bounds is 0 for entities without local
+// bounds (ortho windows), whose columns hold zeros.
+struct WorldBoundsColumns {
+  std::vector<float> min_x, min_y, min_z;
+  std::vector<float> max_x, max_y, max_z;
+  std::vector<float> center_x, center_y, center_z, radius;
+  std::vector<std::uint8_t> has_bounds;
+};
+
+// ============================================================================
+// SceneStorage - packed per-object frame data
+// ============================================================================
+
+// Structure-of-arrays storage for the data the frame loop touches: world
+// matrices, local and world bounds, tag masks and rotation animation.
+// Entities keep a stable EntityId while the arrays stay dense: Destroy()
+// moves the last entity into the hole, so systems iterate [0, GetCount())
+// by index. IRenderable objects attached here act as handles and forward
+// their transform and tags to it.
+//
+// Transforms carry a dirty flag: SetWorldMatrix() and the animation update
+// only mark the entity, and UpdateTransforms() recomputes world bounds for
+// the marked ones once per frame. Static entities cost nothing per frame.
+class SceneStorage {
+public:
+  SceneStorage() = default;
+
+  ~SceneStorage();
+
+  SceneStorage(const SceneStorage &) = delete;
+
+  SceneStorage &operator=(const SceneStorage &) = delete;
+
+  // Adds an entity, attaching renderable (may be null) as its handle. The
+  // renderable must stay alive until it is destroyed or the storage cleared.
+  EntityId Create(IRenderable *renderable, const DirectX::XMMATRIX &world,
+                  TagMask tags);
+
+  void Destroy(EntityId id);
+
+  void Clear();
+
+  bool IsAlive(EntityId id) const;
+
+  std::size_t GetCount() const { return entities_.size(); }
+
+  // Dense index of a live entity.
+  std::size_t GetIndex(EntityId id) const { return dense_index_[id]; }
+
+  EntityId GetEntity(std::size_t index) const { return entities_[index]; }
+
+  IRenderable *GetRenderable(std::size_t index) const {
+    return renderables_[index];
+  }
+
+  // Transform. Setting the matrix the entity already has is a no-op.
+  DirectX::XMMATRIX GetWorldMatrix(EntityId id) const;
+
+  void SetWorldMatrix(EntityId id, const DirectX::XMMATRIX &world);
+
+  bool IsTransformDirty(EntityId id) const {
+    return transform_dirty_[GetIndex(id)] != 0;
+  }
+
+  // Recomputes world bounds of entities whose transform or local bounds
+  // changed since the last call and returns how many there were.
+  std::size_t UpdateTransforms();
+
+  // Bounds. World bounds are as of the last UpdateTransforms().
+  void SetLocalBounds(EntityId id, const BoundingVolume &bounds);
+
+  bool HasBounds(EntityId id) const;
+
+  BoundingVolume GetWorldBounds(EntityId id) const;
+
+  const WorldBoundsColumns &GetWorldBoundsColumns() const {
+    return world_bounds_;
+  }
+
+  // Tags
+  TagMask GetTagMask(EntityId id) const { return tag_masks_[GetIndex(id)]; }
+
+  void SetTagMask(EntityId id, TagMask mask);
+
+  const std::vector<TagMask> &GetTagMasks() const { return tag_masks_; }
+
+  // Dense indices of entities sharing at least one tag with mask.
+  void CollectByMask(TagMask mask, std::vector<std::uint32_t> &indices) const;
+
+  // Animation: rotates about config.axis on top of the entity's current
+  // world matrix, which becomes the initial transform.
+  void SetAnimation(EntityId id, const AnimationConfig &config);
+
+  const AnimationConfig &GetAnimation(EntityId id) const {
+    return animations_[GetIndex(id)];
+  }
+
+  // Advances enabled animations only; their transforms become dirty.
+  void UpdateAnimations(float delta_time);
+
+  std::size_t GetAnimatedCount() const { return animated_.size(); }
+
+  // Change journal for spatial indices. While enabled, created, destroyed
+  // and changed (transform, bounds or tags) entities are recorded until
+  // DrainChanges() hands them over. Changed entities are listed once. Call
+  // UpdateTransforms() first so their world bounds are current.
+  struct ChangeJournal {
+    std::vector<EntityId> created;
+    std::vector<EntityId> destroyed;
+    std::vector<EntityId> changed;
+  };
+
+  void EnableChangeJournal(bool enable);
+
+  void DrainChanges(ChangeJournal &changes);
+
+private:
+  void UpdateWorldBounds(std::size_t index);
+
+  void MarkChanged(std::size_t index);
+
+  void MarkTransformDirty(std::size_t index);
+
+  // Id indirection
+  std::vector<std::uint32_t> dense_index_; // EntityId -> dense index
+  std::vector<EntityId> free_ids_;
+
+  // Dense columns
+  std::vector<EntityId> entities_;
+  std::vector<IRenderable *> renderables_;
+  std::vector<DirectX::XMFLOAT4X4> world_matrices_;
+  std::vector<BoundingVolume> local_bounds_;
+  WorldBoundsColumns world_bounds_;
+  std::vector<TagMask> tag_masks_;
+
+  std::vector<AnimationConfig> animations_;
+  std::vector<float> rotation_angles_; // Radians, wrapped to [0, 2*pi)
+  std::vector<DirectX::XMFLOAT4X4> initial_transforms_;
+  std::vector<DirectX::XMFLOAT3> initial_scales_;
+  std::vector<DirectX::XMFLOAT3> initial_translations_;
+  std::vector<std::uint8_t> initial_decomposed_;
+  std::vector<EntityId> animated_; // Entities with an enabled animation
+
+  std::vector<std::uint8_t> transform_dirty_;
+  std::vector<EntityId> dirty_entities_; // Marked since UpdateTransforms()
+
+  bool journal_enabled_ = false;
+  ChangeJournal journal_;
+  std::vector<std::uint8_t> journal_changed_; // Already in journal_.changed
+};
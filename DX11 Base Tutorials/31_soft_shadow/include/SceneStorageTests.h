@@ -0,0 +1,6 @@
+#pragma once
+
+// Executes the SceneStorage and TagRegistry unit tests: dense entity ids,
+// world bounds, tag masks, animation and IRenderable handles.
+// Returns true when all tests pass without runtime errors.
+bool RunSceneStorageTests();
@@ -1,11 +1,16 @@
 #pragma once
 
 #include "Interfaces.h"
+#include "ShaderBindingPlan.h"
 #include "ShaderParameterValidator.h"
 
 #include <DirectXMath.h>
+#include <cstdint>
 #include <d3d11.h>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <wrl/client.h>
 
@@ -22,7 +27,7 @@ public:
   void Shutdown() override;
 
   virtual bool Render(int indexCount,
-                      const ShaderParameterContainer &parameters,
+                      const LayeredParameterView &parameters,
                       ID3D11DeviceContext *deviceContext) const override = 0;
 
   const std::vector<ReflectedParameter> &GetReflectedParameters() const {
@@ -31,6 +36,29 @@ public:
 
   const std::string &GetShaderName() const { return shader_name_; }
 
+  const ShaderReflectionLayout &GetReflectionLayout() const {
+    return reflection_layout_;
+  }
+
+  // Binding plans: shaders that call EnableBindingPlan() get a plan installed
+  // by RenderGraph::Compile() and fill their constant buffers through it.
+  bool IsBindingPlanEnabled() const { return binding_plan_enabled_; }
+
+  ShaderBindingPlan BuildBindingPlan() const;
+
+  bool SetBindingPlan(std::shared_ptr<const ShaderBindingPlan> plan,
+                      ID3D11Device *device);
+
+  bool HasBindingPlan() const { return binding_plan_ != nullptr; }
+
+  const ConstantBufferUploadCache &GetUploadCache() const {
+    return upload_cache_;
+  }
+
+  // The upload cache tracks what the immediate context last wrote. Call after
+  // executing command lists that may have written this shader's buffers.
+  void InvalidateUploadCache() { upload_cache_.Invalidate(); }
+
 protected:
   // Protected utility methods for shader compilation and setup
   bool InitializeShaderFromFile(HWND hwnd, const std::wstring &vsFilename,
@@ -47,6 +75,17 @@ protected:
       ID3D11SamplerState **samplerState, ID3D11Device *device,
       D3D11_TEXTURE_ADDRESS_MODE addressMode = D3D11_TEXTURE_ADDRESS_WRAP);
 
+  // aliases: reflected name -> parameter name; defaults: values used when a
+  // parameter is absent at draw time.
+  void EnableBindingPlan(ShaderBindingPlan::AliasMap aliases = {},
+                         ShaderParameterContainer defaults = {});
+
+  // Gathers, uploads and binds every constant buffer and SRV of the installed
+  // plan. Safe to call concurrently on different contexts; unchanged buffers
+  // are only skipped on the immediate context.
+  bool ApplyBindingPlan(const LayeredParameterView &parameters,
+                        ID3D11DeviceContext *deviceContext) const;
+
   // Shader resources
   Microsoft::WRL::ComPtr<ID3D11VertexShader> vertex_shader_;
   Microsoft::WRL::ComPtr<ID3D11PixelShader> pixel_shader_;
@@ -54,9 +93,22 @@ protected:
   Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler_state_;
 
   std::vector<ReflectedParameter> reflected_parameters_;
+  ShaderReflectionLayout reflection_layout_;
   std::string shader_name_;
 
 private:
+  bool binding_plan_enabled_ = false;
+  ShaderBindingPlan::AliasMap binding_aliases_;
+  ShaderParameterContainer binding_defaults_;
+  std::shared_ptr<const ShaderBindingPlan> binding_plan_;
+  std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>> plan_buffers_;
+  // Staging memory per context, so deferred contexts can record in parallel.
+  mutable std::mutex plan_staging_mutex_;
+  mutable std::unordered_map<ID3D11DeviceContext *,
+                             std::vector<std::vector<std::uint8_t>>>
+      plan_staging_;
+  mutable ConstantBufferUploadCache upload_cache_;
+
   void OutputShaderErrorMessage(ID3D10Blob *errorMessage, HWND hwnd,
                                 const std::wstring &shaderFilename);
 };
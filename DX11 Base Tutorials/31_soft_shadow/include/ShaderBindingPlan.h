@@ -0,0 +1,124 @@
+#pragma once
+
+#include "LayeredParameterView.h"
+#include "ShaderParameter.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ============================================================================
+// Shader Binding Plan
+// ============================================================================
+
+// One constant buffer field: where a parameter lands inside the buffer.
+struct ConstantBufferFieldBinding {
+  ShaderParameterId parameter = kInvalidShaderParameterId;
+  // Reflected (HLSL) name, tried when the aliased parameter is not present.
+  ShaderParameterId fallback_parameter = kInvalidShaderParameterId;
+  ShaderParameterType type = ShaderParameterType::Unknown;
+  std::uint32_t offset = 0;
+  std::uint32_t size = 0;
+  bool transpose = false;   // column_major matrices are uploaded transposed
+  bool has_default = false; // default bytes live in initial_contents
+};
+
+struct ConstantBufferBinding {
+  std::string name;
+  ShaderStage stage = ShaderStage::Vertex;
+  std::uint32_t slot = 0;
+  std::uint32_t size = 0;
+  std::vector<ConstantBufferFieldBinding> fields;
+  // Buffer image with defaults applied and padding zeroed; gathers start here.
+  std::vector<std::uint8_t> initial_contents;
+};
+
+struct ShaderResourceBinding {
+  ShaderParameterId parameter = kInvalidShaderParameterId;
+  ShaderParameterId fallback_parameter = kInvalidShaderParameterId;
+  ShaderStage stage = ShaderStage::Pixel;
+  std::uint32_t slot = 0;
+  bool has_default = false;
+  ID3D11ShaderResourceView *default_value = nullptr;
+};
+
+// Precomputed mapping from parameter ids to constant buffer bytes and SRV
+// slots, built once from shader reflection. At draw time a shader gathers
+// each buffer with straight copies instead of looking parameters up by name
+// and filling hand-written structs. Device-independent so it can be built and
+// tested from fake reflection data.
+class ShaderBindingPlan {
+public:
+  // Maps reflected (HLSL) names to parameter names, e.g. "shaderTexture" ->
+  // "texture". Unmapped names bind to the parameter of the same name.
+  using AliasMap = std::unordered_map<std::string, std::string>;
+
+  static ShaderBindingPlan Build(const ShaderReflectionLayout &layout,
+                                 const AliasMap &aliases = {},
+                                 const ShaderParameterContainer *defaults =
+                                     nullptr);
+
+  const std::vector<ConstantBufferBinding> &GetConstantBuffers() const {
+    return constant_buffers_;
+  }
+
+  const std::vector<ShaderResourceBinding> &GetResources() const {
+    return resources_;
+  }
+
+  bool IsEmpty() const {
+    return constant_buffers_.empty() && resources_.empty();
+  }
+
+  // Writes constant buffer `index` into destination, which must hold at least
+  // GetConstantBuffers()[index].size bytes. Throws std::runtime_error when a
+  // field without a default is missing, like LayeredParameterView::Get.
+  void GatherConstantBuffer(std::size_t index,
+                            const LayeredParameterView &parameters,
+                            std::uint8_t *destination) const;
+
+  ID3D11ShaderResourceView *
+  ResolveResource(std::size_t index,
+                  const LayeredParameterView &parameters) const;
+
+  std::string Describe() const;
+
+private:
+  std::vector<ConstantBufferBinding> constant_buffers_;
+
+  std::vector<ShaderResourceBinding> resources_;
+};
+
+// ============================================================================
+// Constant Buffer Upload Cache
+// ============================================================================
+
+// Remembers the last bytes uploaded to each constant buffer of a plan so a
+// draw whose gathered contents are byte-identical can skip Map/Unmap.
+class ConstantBufferUploadCache {
+public:
+  void Reset(const ShaderBindingPlan &plan);
+
+  // Returns true (and records the contents) when they differ from the last
+  // upload for this buffer, or when nothing has been uploaded yet.
+  bool ShouldUpload(std::size_t index, const std::uint8_t *contents,
+                    std::size_t size);
+
+  // Forgets previous contents, e.g. after the device buffers were recreated.
+  void Invalidate();
+
+  std::uint64_t GetUploadCount() const { return upload_count_; }
+
+  std::uint64_t GetSkippedUploadCount() const { return skipped_count_; }
+
+private:
+  std::vector<std::vector<std::uint8_t>> last_contents_;
+
+  std::vector<bool> valid_;
+
+  std::uint64_t upload_count_ = 0;
+
+  std::uint64_t skipped_count_ = 0;
+};
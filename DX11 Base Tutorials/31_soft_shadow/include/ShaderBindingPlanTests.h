@@ -0,0 +1,6 @@
+#pragma once
+
+// Executes the ShaderBindingPlan unit tests against fake reflection layouts,
+// including the byte-identical constant buffer upload skip.
+// Returns true when all tests pass without runtime errors.
+bool RunShaderBindingPlanTests();
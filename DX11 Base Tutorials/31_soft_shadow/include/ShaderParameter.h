@@ -4,17 +4,19 @@
 #include <d3d11.h>
 
 #include "Logger.h"
+#include "SmallVector.h"
 
+#include <algorithm>
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
-#include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -96,19 +98,80 @@ struct ReflectedParameter : public ShaderParameterInfo {
         stage_mask(stage_mask) {}
 };
 
+// Constant buffer layout as reported by D3DReflect, used to build binding
+// plans (see ShaderBindingPlan.h).
+struct ReflectedConstantBufferVariable {
+  std::string name;
+  ShaderParameterType type = ShaderParameterType::Unknown;
+  std::uint32_t offset = 0; // Byte offset inside the constant buffer
+  std::uint32_t size = 0;   // Byte size as laid out by the compiler
+  bool column_major = false;
+  bool used = true;
+};
+
+struct ReflectedConstantBuffer {
+  std::string name;
+  ShaderStage stage = ShaderStage::Vertex;
+  std::uint32_t bind_slot = 0;
+  std::uint32_t size = 0;
+  std::vector<ReflectedConstantBufferVariable> variables;
+};
+
+struct ReflectedResourceBinding {
+  std::string name;
+  ShaderParameterType type = ShaderParameterType::Unknown;
+  ShaderStage stage = ShaderStage::Pixel;
+  std::uint32_t bind_slot = 0;
+};
+
+struct ShaderReflectionLayout {
+  std::vector<ReflectedConstantBuffer> constant_buffers;
+  std::vector<ReflectedResourceBinding> resources;
+};
+
 using ShaderParameterValueVariant =
     std::variant<DirectX::XMMATRIX, DirectX::XMFLOAT3, DirectX::XMFLOAT4, float,
                  ID3D11ShaderResourceView *>;
 
+// ============================================================================
+// Shader Parameter Registry
+// ============================================================================
+
+// Dense integer handle for an interned parameter name. Ids are process-wide
+// and never recycled, so they can be cached in static locals by shaders and
+// passes and compared without touching the string.
+using ShaderParameterId = std::uint32_t;
+
+constexpr ShaderParameterId kInvalidShaderParameterId = 0xFFFFFFFFU;
+
+class ShaderParameterRegistry {
+public:
+  // Returns the id for name, registering it on first use. Thread-safe.
+  static ShaderParameterId Intern(std::string_view name);
+
+  // Returns the id for name, or kInvalidShaderParameterId if the name was
+  // never interned. Never grows the table.
+  static ShaderParameterId Find(std::string_view name);
+
+  static const std::string &GetName(ShaderParameterId id);
+
+  static std::size_t GetCount();
+};
+
 // ============================================================================
 // Shader Parameter Container
 // ============================================================================
 
+// Parameters are stored in a flat array of slots sorted by ShaderParameterId.
+// A presence bitmask covering the first kPresenceMaskBits ids turns lookups
+// into a popcount rank, so the hot path (merge, get) does no string hashing.
+// Origin and lock state live inside each slot instead of in side tables.
+// The string-based API is kept as a thin layer that interns the name first.
 class ShaderParameterContainer {
 public:
   using ParamValue = ShaderParameterValueVariant;
 
-  enum class ParameterOrigin {
+  enum class ParameterOrigin : std::uint8_t {
     Unknown,
     Manual,
     Global,
@@ -198,11 +261,23 @@ public:
   void SetFloatLocked(const std::string &name, float value,
                       ParameterOrigin origin = ParameterOrigin::Manual);
 
+  // Id-based setters (no string hashing)
+  void SetValue(ShaderParameterId id, const ParamValue &value,
+                ParameterOrigin origin = ParameterOrigin::Manual);
+
+  void SetFloatLocked(ShaderParameterId id, float value,
+                      ParameterOrigin origin = ParameterOrigin::Manual);
+
   template <typename T> auto Get(const std::string &name) const -> T;
 
   template <typename T>
   auto TryGet(const std::string &name, T &out) const -> bool;
 
+  template <typename T> auto Get(ShaderParameterId id) const -> T;
+
+  template <typename T>
+  auto TryGet(ShaderParameterId id, T &out) const -> bool;
+
   auto GetFloat(const std::string &name) const -> float;
 
   DirectX::XMMATRIX GetMatrix(const std::string &name) const;
@@ -215,14 +290,28 @@ public:
 
   bool HasParameter(const std::string &name) const;
 
+  bool HasParameter(ShaderParameterId id) const;
+
   ShaderParameterType GetType(const std::string &name) const;
 
   std::optional<ParamValue> TryGet(const std::string &name) const;
 
+  // Returns a pointer into the container, or nullptr when absent. The pointer
+  // is invalidated by the next insertion.
+  const ParamValue *Find(ShaderParameterId id) const;
+
+  // Same as Find, also reporting whether the slot is locked.
+  const ParamValue *Find(ShaderParameterId id, bool &is_locked) const;
+
+  // Removes all parameters but keeps any heap capacity for reuse.
+  void Clear();
+
   std::vector<ShaderParameterInfo> GetAllParameterEntries() const;
 
   std::vector<std::string> GetAllParameterNames() const;
 
+  std::size_t GetParameterCount() const { return slots_.size(); }
+
   static ShaderParameterContainer
   MergeWithPriority(const ShaderParameterContainer &lower,
                     const ShaderParameterContainer &higher,
@@ -246,10 +335,12 @@ public:
 
   bool IsLocked(const std::string &name) const;
 
+  bool IsLocked(ShaderParameterId id) const;
+
   inline std::vector<std::pair<std::string, std::string>>
   GetPrefixedNamePairs() const {
     std::vector<std::pair<std::string, std::string>> out;
-    out.reserve(typed_parameters_.size());
+    out.reserve(slots_.size());
     auto prefixFor = [](ParameterOrigin o) -> const char * {
       switch (o) {
       case ParameterOrigin::Global:
@@ -266,16 +357,13 @@ public:
         return "unknown_";
       }
     };
-    for (const auto &kv : typed_parameters_) {
-      auto origin_it = parameter_origins_.find(kv.first);
-      ParameterOrigin origin = origin_it == parameter_origins_.end()
-                                   ? ParameterOrigin::Unknown
-                                   : origin_it->second;
-      std::string prefixed = std::string(prefixFor(origin)) + kv.first;
-      if (IsLocked(kv.first)) {
+    for (const auto &slot : slots_) {
+      const std::string &name = ShaderParameterRegistry::GetName(slot.id);
+      std::string prefixed = std::string(prefixFor(slot.origin)) + name;
+      if (slot.locked) {
         prefixed += "[locked]";
       }
-      out.emplace_back(std::move(prefixed), kv.first);
+      out.emplace_back(std::move(prefixed), name);
     }
     return out;
   }
@@ -287,19 +375,19 @@ public:
       const auto &prefixed = p.first;
       const auto &original = p.second;
       oss << "  " << prefixed << " = ";
-      auto it = typed_parameters_.find(original);
-      if (it != typed_parameters_.end()) {
-        switch (DeduceType(it->second)) {
+      const ParamValue *value = Find(ShaderParameterRegistry::Find(original));
+      if (value != nullptr) {
+        switch (DeduceType(*value)) {
         case ShaderParameterType::Float:
-          oss << std::get<float>(it->second);
+          oss << std::get<float>(*value);
           break;
         case ShaderParameterType::Vector3: {
-          auto v = std::get<DirectX::XMFLOAT3>(it->second);
+          auto v = std::get<DirectX::XMFLOAT3>(*value);
           oss << "(" << v.x << "," << v.y << "," << v.z << ")";
           break;
         }
         case ShaderParameterType::Vector4: {
-          auto v = std::get<DirectX::XMFLOAT4>(it->second);
+          auto v = std::get<DirectX::XMFLOAT4>(*value);
           oss << "(" << v.x << "," << v.y << "," << v.z << "," << v.w << ")";
           break;
         }
@@ -320,7 +408,34 @@ public:
   }
 
 private:
-  void AssignValue(const std::string &name, const ParamValue &value,
+  struct ParameterSlot {
+    ParamValue value;
+    ShaderParameterId id = kInvalidShaderParameterId;
+    ParameterOrigin origin = ParameterOrigin::Unknown;
+    bool locked = false;
+
+    ParameterSlot(ShaderParameterId id, const ParamValue &value,
+                  ParameterOrigin origin)
+        : value(value), id(id), origin(origin) {}
+  };
+
+  // Typical containers hold < 16 parameters; only the global frame container
+  // of a large pass spills to the heap.
+  static constexpr std::size_t kInlineSlotCount = 16;
+
+  static constexpr std::size_t kPresenceMaskWords = 2;
+
+  static constexpr ShaderParameterId kPresenceMaskBits =
+      static_cast<ShaderParameterId>(kPresenceMaskWords * 64);
+
+  // Index of the first slot whose id is >= id (sorted insertion point).
+  std::size_t LowerBound(ShaderParameterId id) const;
+
+  const ParameterSlot *FindSlot(ShaderParameterId id) const;
+
+  ParameterSlot *FindSlot(ShaderParameterId id);
+
+  void AssignValue(ShaderParameterId id, const ParamValue &value,
                    ParameterOrigin origin = ParameterOrigin::Manual);
 
   void ApplyOverrides(const ShaderParameterContainer &other,
@@ -330,15 +445,15 @@ private:
 
   static const char *ParameterOriginToString(ParameterOrigin origin);
 
-  void LockParameter(const std::string &name);
+  static std::uint32_t PopCount(std::uint64_t bits);
 
-  std::unordered_map<std::string, ParamValue> typed_parameters_;
+  void LockParameter(ShaderParameterId id);
 
-  std::unordered_map<std::string, ParameterOrigin> parameter_origins_;
+  SmallVector<ParameterSlot, kInlineSlotCount> slots_;
 
-  ParameterOrigin default_origin_ = ParameterOrigin::Manual;
+  std::uint64_t present_mask_[kPresenceMaskWords] = {};
 
-  std::unordered_set<std::string> locked_parameters_;
+  ParameterOrigin default_origin_ = ParameterOrigin::Manual;
 
   // Use atomic for thread-safe global configuration flags
   static std::atomic<bool> type_mismatch_logging_enabled_;
@@ -397,11 +512,11 @@ ShaderParameterContainer &ShaderParameterContainer::Set(const std::string &name,
 
 template <typename T>
 T ShaderParameterContainer::Get(const std::string &name) const {
-  auto it = typed_parameters_.find(name);
-  if (it == typed_parameters_.end()) {
+  const ParameterSlot *slot = FindSlot(ShaderParameterRegistry::Find(name));
+  if (slot == nullptr) {
     throw std::runtime_error("Parameter not found: " + name);
   }
-  if (const auto *value = std::get_if<T>(&it->second)) {
+  if (const auto *value = std::get_if<T>(&slot->value)) {
     return *value;
   }
   throw std::runtime_error("Type mismatch for parameter: " + name);
@@ -409,11 +524,32 @@ T ShaderParameterContainer::Get(const std::string &name) const {
 
 template <typename T>
 bool ShaderParameterContainer::TryGet(const std::string &name, T &out) const {
-  auto it = typed_parameters_.find(name);
-  if (it == typed_parameters_.end()) {
+  return TryGet<T>(ShaderParameterRegistry::Find(name), out);
+}
+
+template <typename T>
+T ShaderParameterContainer::Get(ShaderParameterId id) const {
+  const ParameterSlot *slot = FindSlot(id);
+  if (slot == nullptr) {
+    throw std::runtime_error(
+        "Parameter not found: " +
+        (id == kInvalidShaderParameterId ? std::string("<invalid id>")
+                                         : ShaderParameterRegistry::GetName(id)));
+  }
+  if (const auto *value = std::get_if<T>(&slot->value)) {
+    return *value;
+  }
+  throw std::runtime_error("Type mismatch for parameter: " +
+                           ShaderParameterRegistry::GetName(id));
+}
+
+template <typename T>
+bool ShaderParameterContainer::TryGet(ShaderParameterId id, T &out) const {
+  const ParameterSlot *slot = FindSlot(id);
+  if (slot == nullptr) {
     return false;
   }
-  if (const auto *value = std::get_if<T>(&it->second)) {
+  if (const auto *value = std::get_if<T>(&slot->value)) {
     out = *value;
     return true;
   }
@@ -423,8 +559,8 @@ bool ShaderParameterContainer::TryGet(const std::string &name, T &out) const {
 inline void ShaderParameterContainer::SetFloat(const std::string &name,
                                                float value,
                                                ParameterOrigin origin) {
-  auto param_value = decltype(typed_parameters_)::mapped_type(value);
-  AssignValue(name, param_value, origin);
+  AssignValue(ShaderParameterRegistry::Intern(name), ParamValue(value),
+              origin);
 }
 
 inline void ShaderParameterContainer::SetGlobalDynamicMatrix(
@@ -435,8 +571,8 @@ inline void ShaderParameterContainer::SetGlobalDynamicMatrix(
 inline void ShaderParameterContainer::SetMatrix(const std::string &name,
                                                 const DirectX::XMMATRIX &matrix,
                                                 ParameterOrigin origin) {
-  auto param_value = decltype(typed_parameters_)::mapped_type(matrix);
-  AssignValue(name, param_value, origin);
+  AssignValue(ShaderParameterRegistry::Intern(name), ParamValue(matrix),
+              origin);
 }
 
 inline void ShaderParameterContainer::SetGlobalDynamicVector3(
@@ -448,24 +584,30 @@ inline void
 ShaderParameterContainer::SetVector3(const std::string &name,
                                      const DirectX::XMFLOAT3 &vector,
                                      ParameterOrigin origin) {
-  auto param_value = decltype(typed_parameters_)::mapped_type(vector);
-  AssignValue(name, param_value, origin);
+  AssignValue(ShaderParameterRegistry::Intern(name), ParamValue(vector),
+              origin);
 }
 
 inline void
 ShaderParameterContainer::SetVector4(const std::string &name,
                                      const DirectX::XMFLOAT4 &vector,
                                      ParameterOrigin origin) {
-  auto param_value = decltype(typed_parameters_)::mapped_type(vector);
-  AssignValue(name, param_value, origin);
+  AssignValue(ShaderParameterRegistry::Intern(name), ParamValue(vector),
+              origin);
 }
 
 inline void
 ShaderParameterContainer::SetTexture(const std::string &name,
                                      ID3D11ShaderResourceView *texture,
                                      ParameterOrigin origin) {
-  auto param_value = decltype(typed_parameters_)::mapped_type(texture);
-  AssignValue(name, param_value, origin);
+  AssignValue(ShaderParameterRegistry::Intern(name), ParamValue(texture),
+              origin);
+}
+
+inline void ShaderParameterContainer::SetValue(ShaderParameterId id,
+                                               const ParamValue &value,
+                                               ParameterOrigin origin) {
+  AssignValue(id, value, origin);
 }
 
 inline float ShaderParameterContainer::GetFloat(const std::string &name) const {
@@ -494,33 +636,62 @@ ShaderParameterContainer::GetTexture(const std::string &name) const {
 
 inline bool
 ShaderParameterContainer::HasParameter(const std::string &name) const {
-  return typed_parameters_.find(name) != typed_parameters_.end();
+  return FindSlot(ShaderParameterRegistry::Find(name)) != nullptr;
+}
+
+inline bool ShaderParameterContainer::HasParameter(ShaderParameterId id) const {
+  return FindSlot(id) != nullptr;
 }
 
 inline ShaderParameterType
 ShaderParameterContainer::GetType(const std::string &name) const {
-  auto iter = typed_parameters_.find(name);
-  if (iter == typed_parameters_.end()) {
+  const ParameterSlot *slot = FindSlot(ShaderParameterRegistry::Find(name));
+  if (slot == nullptr) {
     return ShaderParameterType::Unknown;
   }
-  return DeduceType(iter->second);
+  return DeduceType(slot->value);
 }
 
 inline std::optional<ShaderParameterContainer::ParamValue>
 ShaderParameterContainer::TryGet(const std::string &name) const {
-  auto iter = typed_parameters_.find(name);
-  if (iter == typed_parameters_.end()) {
+  const ParameterSlot *slot = FindSlot(ShaderParameterRegistry::Find(name));
+  if (slot == nullptr) {
     return std::nullopt;
   }
-  return iter->second;
+  return slot->value;
+}
+
+inline const ShaderParameterContainer::ParamValue *
+ShaderParameterContainer::Find(ShaderParameterId id) const {
+  const ParameterSlot *slot = FindSlot(id);
+  return slot != nullptr ? &slot->value : nullptr;
+}
+
+inline const ShaderParameterContainer::ParamValue *
+ShaderParameterContainer::Find(ShaderParameterId id, bool &is_locked) const {
+  const ParameterSlot *slot = FindSlot(id);
+  if (slot == nullptr) {
+    is_locked = false;
+    return nullptr;
+  }
+  is_locked = slot->locked;
+  return &slot->value;
+}
+
+inline void ShaderParameterContainer::Clear() {
+  slots_.clear();
+  for (std::size_t w = 0; w < kPresenceMaskWords; ++w) {
+    present_mask_[w] = 0;
+  }
 }
 
 inline std::vector<ShaderParameterInfo>
 ShaderParameterContainer::GetAllParameterEntries() const {
   std::vector<ShaderParameterInfo> entries;
-  entries.reserve(typed_parameters_.size());
-  for (const auto &kv : typed_parameters_) {
-    entries.emplace_back(kv.first, DeduceType(kv.second));
+  entries.reserve(slots_.size());
+  for (const auto &slot : slots_) {
+    entries.emplace_back(ShaderParameterRegistry::GetName(slot.id),
+                         DeduceType(slot.value));
   }
   return entries;
 }
@@ -528,9 +699,9 @@ ShaderParameterContainer::GetAllParameterEntries() const {
 inline std::vector<std::string>
 ShaderParameterContainer::GetAllParameterNames() const {
   std::vector<std::string> names;
-  names.reserve(typed_parameters_.size());
-  for (const auto &kv : typed_parameters_) {
-    names.push_back(kv.first);
+  names.reserve(slots_.size());
+  for (const auto &slot : slots_) {
+    names.push_back(ShaderParameterRegistry::GetName(slot.id));
   }
   return names;
 }
@@ -564,6 +735,9 @@ ShaderParameterContainer::ChainMerge(const ShaderParameterContainer &global,
 
 inline ShaderParameterContainer ShaderParameterContainer::BuildFinalParameters(
     const BuildParametersInput &input) {
+  static const ShaderParameterId world_matrix_id =
+      ShaderParameterRegistry::Intern("worldMatrix");
+
   ShaderParameterContainer result;
 
   if (input.base_params) {
@@ -582,8 +756,8 @@ inline ShaderParameterContainer ShaderParameterContainer::BuildFinalParameters(
   }
 
   if (input.world_matrix) {
-    result.SetMatrix("worldMatrix", *input.world_matrix,
-                     ParameterOrigin::Object);
+    result.AssignValue(world_matrix_id, ParamValue(*input.world_matrix),
+                       ParameterOrigin::Object);
   }
 
   if (input.callback) {
@@ -599,7 +773,64 @@ ShaderParameterContainer::OverrideDefaultOrigin(ParameterOrigin origin) {
   return ScopedOriginOverride(*this, origin);
 }
 
-inline void ShaderParameterContainer::AssignValue(const std::string &name,
+inline std::uint32_t ShaderParameterContainer::PopCount(std::uint64_t bits) {
+  // SWAR popcount; portable across the Win32 and x64 configurations.
+  bits = bits - ((bits >> 1) & 0x5555555555555555ULL);
+  bits = (bits & 0x3333333333333333ULL) + ((bits >> 2) & 0x3333333333333333ULL);
+  bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return static_cast<std::uint32_t>((bits * 0x0101010101010101ULL) >> 56);
+}
+
+inline std::size_t
+ShaderParameterContainer::LowerBound(ShaderParameterId id) const {
+  if (id < kPresenceMaskBits) {
+    // Slots are sorted by id, so the insertion point is the number of present
+    // ids below this one.
+    const std::size_t word = id / 64;
+    std::size_t rank = 0;
+    for (std::size_t w = 0; w < word; ++w) {
+      rank += PopCount(present_mask_[w]);
+    }
+    const std::uint64_t below = (std::uint64_t{1} << (id % 64)) - 1;
+    return rank + PopCount(present_mask_[word] & below);
+  }
+
+  std::size_t masked_count = 0;
+  for (std::size_t w = 0; w < kPresenceMaskWords; ++w) {
+    masked_count += PopCount(present_mask_[w]);
+  }
+  auto first = slots_.begin() + masked_count;
+  auto it = std::lower_bound(
+      first, slots_.end(), id,
+      [](const ParameterSlot &slot, ShaderParameterId value) {
+        return slot.id < value;
+      });
+  return static_cast<std::size_t>(it - slots_.begin());
+}
+
+inline const ShaderParameterContainer::ParameterSlot *
+ShaderParameterContainer::FindSlot(ShaderParameterId id) const {
+  if (id == kInvalidShaderParameterId) {
+    return nullptr;
+  }
+  if (id < kPresenceMaskBits &&
+      (present_mask_[id / 64] & (std::uint64_t{1} << (id % 64))) == 0) {
+    return nullptr;
+  }
+  const std::size_t index = LowerBound(id);
+  if (index < slots_.size() && slots_[index].id == id) {
+    return &slots_[index];
+  }
+  return nullptr;
+}
+
+inline ShaderParameterContainer::ParameterSlot *
+ShaderParameterContainer::FindSlot(ShaderParameterId id) {
+  return const_cast<ParameterSlot *>(
+      static_cast<const ShaderParameterContainer *>(this)->FindSlot(id));
+}
+
+inline void ShaderParameterContainer::AssignValue(ShaderParameterId id,
                                                   const ParamValue &value,
                                                   ParameterOrigin origin) {
   ParameterOrigin effective_origin = origin;
@@ -607,12 +838,14 @@ inline void ShaderParameterContainer::AssignValue(const std::string &name,
       default_origin_ != ParameterOrigin::Manual) {
     effective_origin = default_origin_;
   }
-  auto iter = typed_parameters_.find(name);
-  if (locked_parameters_.find(name) != locked_parameters_.end() &&
-      iter != typed_parameters_.end()) {
+  const std::size_t index = LowerBound(id);
+  ParameterSlot *existing =
+      index < slots_.size() && slots_[index].id == id ? &slots_[index]
+                                                      : nullptr;
+  if (existing != nullptr && existing->locked) {
     if (override_logging_enabled_.load(std::memory_order_relaxed)) {
       std::ostringstream oss;
-      oss << "Parameter \"" << name
+      oss << "Parameter \"" << ShaderParameterRegistry::GetName(id)
           << "\" locked; ignoring override attempt from "
           << ParameterOriginToString(origin) << ".";
       Logger::SetModule("ShaderParameterContainer");
@@ -622,16 +855,12 @@ inline void ShaderParameterContainer::AssignValue(const std::string &name,
       throw std::runtime_error(
           std::string(
               "StrictValidation: attempt to override locked parameter: ") +
-          name);
+          ShaderParameterRegistry::GetName(id));
     }
     return;
   }
-  if (iter != typed_parameters_.end()) {
-    const auto previous_origin_iter = parameter_origins_.find(name);
-    const ParameterOrigin previous_origin =
-        previous_origin_iter != parameter_origins_.end()
-            ? previous_origin_iter->second
-            : ParameterOrigin::Unknown;
+  if (existing != nullptr) {
+    const ParameterOrigin previous_origin = existing->origin;
 
     ParameterOrigin resolved_origin = effective_origin;
     if (resolved_origin == ParameterOrigin::Unknown) {
@@ -640,11 +869,12 @@ inline void ShaderParameterContainer::AssignValue(const std::string &name,
                             : ParameterOrigin::Manual;
     }
 
-    auto existing_type = DeduceType(iter->second);
-    auto incoming_type = DeduceType(value);
-    if (existing_type != incoming_type) {
+    if (existing->value.index() != value.index()) {
+      auto existing_type = DeduceType(existing->value);
+      auto incoming_type = DeduceType(value);
       std::ostringstream oss;
-      oss << "Parameter \"" << name << "\" type mismatch: existing="
+      oss << "Parameter \"" << ShaderParameterRegistry::GetName(id)
+          << "\" type mismatch: existing="
           << ShaderParameterTypeToString(existing_type)
           << ", incoming=" << ShaderParameterTypeToString(incoming_type);
       if (type_mismatch_logging_enabled_.load(std::memory_order_relaxed)) {
@@ -659,47 +889,60 @@ inline void ShaderParameterContainer::AssignValue(const std::string &name,
         resolved_origin != ParameterOrigin::Unknown &&
         previous_origin != ParameterOrigin::Unknown) {
       std::ostringstream oss;
-      oss << "Parameter \"" << name
+      oss << "Parameter \"" << ShaderParameterRegistry::GetName(id)
           << "\" overridden: " << ParameterOriginToString(previous_origin)
           << " -> " << ParameterOriginToString(resolved_origin);
       Logger::SetModule("ShaderParameterContainer");
       Logger::LogWarning(oss.str());
     }
 
-    iter->second = value;
-    parameter_origins_[name] = resolved_origin;
+    existing->value = value;
+    existing->origin = resolved_origin;
     return;
   }
   ParameterOrigin resolved_origin = effective_origin;
   if (resolved_origin == ParameterOrigin::Unknown) {
     resolved_origin = ParameterOrigin::Manual;
   }
-  typed_parameters_.emplace(name, value);
-  parameter_origins_[name] = resolved_origin;
+  slots_.emplace(slots_.begin() + index, id, value, resolved_origin);
+  if (id < kPresenceMaskBits) {
+    present_mask_[id / 64] |= std::uint64_t{1} << (id % 64);
+  }
 }
 
 inline void
 ShaderParameterContainer::ApplyOverrides(const ShaderParameterContainer &other,
                                          ParameterOrigin origin) {
-  for (const auto &kv : other.typed_parameters_) {
+  if (slots_.empty() && default_origin_ == ParameterOrigin::Manual &&
+      origin != ParameterOrigin::Unknown &&
+      origin != ParameterOrigin::Manual) {
+    // Fast path: merging into an empty container is a straight copy with the
+    // origin rewritten; no per-slot lookups are needed.
+    slots_ = other.slots_;
+    for (std::size_t w = 0; w < kPresenceMaskWords; ++w) {
+      present_mask_[w] = other.present_mask_[w];
+    }
+    for (auto &slot : slots_) {
+      slot.origin = origin;
+    }
+    return;
+  }
+  for (const auto &slot : other.slots_) {
     ParameterOrigin resolved_origin = origin;
     if (resolved_origin == ParameterOrigin::Unknown) {
-      auto origin_iter = other.parameter_origins_.find(kv.first);
-      if (origin_iter != other.parameter_origins_.end()) {
-        resolved_origin = origin_iter->second;
-      } else {
-        resolved_origin = ParameterOrigin::Manual;
-      }
+      resolved_origin = slot.origin != ParameterOrigin::Unknown
+                            ? slot.origin
+                            : ParameterOrigin::Manual;
     }
-    AssignValue(kv.first, kv.second, resolved_origin);
-    if (other.IsLocked(kv.first)) {
-      LockParameter(kv.first);
+    AssignValue(slot.id, slot.value, resolved_origin);
+    if (slot.locked) {
+      LockParameter(slot.id);
     }
   }
 }
 
-inline ShaderParameterType ShaderParameterContainer::DeduceType(
-    const typename decltype(typed_parameters_)::mapped_type &value) {
+inline ShaderParameterType
+ShaderParameterContainer::DeduceType(const ParamValue &value) {
   return std::visit(
       [](auto &&arg) -> ShaderParameterType {
         using T = std::decay_t<decltype(arg)>;
@@ -740,17 +983,34 @@ ShaderParameterContainer::ParameterOriginToString(ParameterOrigin origin) {
 inline void ShaderParameterContainer::SetFloatLocked(const std::string &name,
                                                      float value,
                                                      ParameterOrigin origin) {
-  SetFloat(name, value, origin);
-  LockParameter(name);
+  SetFloatLocked(ShaderParameterRegistry::Intern(name), value, origin);
+}
+
+inline void ShaderParameterContainer::SetFloatLocked(ShaderParameterId id,
+                                                     float value,
+                                                     ParameterOrigin origin) {
+  AssignValue(id, ParamValue(value), origin);
+  LockParameter(id);
 }
 
 inline bool ShaderParameterContainer::IsLocked(const std::string &name) const {
-  return locked_parameters_.find(name) != locked_parameters_.end();
+  return IsLocked(ShaderParameterRegistry::Find(name));
+}
+
+inline bool ShaderParameterContainer::IsLocked(ShaderParameterId id) const {
+  const ParameterSlot *slot = FindSlot(id);
+  return slot != nullptr && slot->locked;
 }
 
-inline void ShaderParameterContainer::LockParameter(const std::string &name) {
-  locked_parameters_.insert(name);
+inline void ShaderParameterContainer::LockParameter(ShaderParameterId id) {
+  ParameterSlot *slot = FindSlot(id);
+  if (slot != nullptr) {
+    slot->locked = true;
+  }
 }
 
 std::vector<ReflectedParameter>
 ReflectShader(ID3D11Device *device, ID3D10Blob *vs_blob, ID3D10Blob *ps_blob);
+
+ShaderReflectionLayout ReflectShaderLayout(ID3D10Blob *vs_blob,
+                                           ID3D10Blob *ps_blob);
@@ -0,0 +1,6 @@
+#pragma once
+
+// Headless micro-benchmark comparing per-object parameter merging of the
+// slot-indexed ShaderParameterContainer against the previous map-based layout.
+// Prints timings to stdout. Returns false if the two produce different results.
+bool RunShaderParameterBenchmarks();
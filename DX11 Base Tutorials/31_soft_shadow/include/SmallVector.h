@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// ============================================================================
+// SmallVector - vector with inline storage for the first N elements
+// ============================================================================
+
+// Keeps up to N elements inside the object itself and only touches the heap
+// once that capacity is exceeded. Used for hot per-draw containers where the
+// typical element count is small and known (e.g. shader parameters).
+template <typename T, std::size_t N> class SmallVector {
+  static_assert(N > 0, "SmallVector requires a non-zero inline capacity");
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = T *;
+  using const_iterator = const T *;
+
+  SmallVector() = default;
+
+  SmallVector(std::initializer_list<T> values) {
+    reserve(values.size());
+    for (const auto &value : values) {
+      push_back(value);
+    }
+  }
+
+  SmallVector(const SmallVector &other) {
+    reserve(other.size_);
+    std::uninitialized_copy(other.begin(), other.end(), data_);
+    size_ = other.size_;
+  }
+
+  SmallVector(SmallVector &&other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) {
+    MoveFrom(std::move(other));
+  }
+
+  ~SmallVector() {
+    clear();
+    ReleaseHeap();
+  }
+
+  SmallVector &operator=(const SmallVector &other) {
+    if (this == &other) {
+      return *this;
+    }
+    clear();
+    reserve(other.size_);
+    std::uninitialized_copy(other.begin(), other.end(), data_);
+    size_ = other.size_;
+    return *this;
+  }
+
+  SmallVector &operator=(SmallVector &&other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) {
+    if (this == &other) {
+      return *this;
+    }
+    clear();
+    ReleaseHeap();
+    MoveFrom(std::move(other));
+    return *this;
+  }
+
+  T &operator[](size_type index) { return data_[index]; }
+  const T &operator[](size_type index) const { return data_[index]; }
+
+  T *data() { return data_; }
+  const T *data() const { return data_; }
+
+  iterator begin() { return data_; }
+  iterator end() { return data_ + size_; }
+  const_iterator begin() const { return data_; }
+  const_iterator end() const { return data_ + size_; }
+
+  T &back() { return data_[size_ - 1]; }
+  const T &back() const { return data_[size_ - 1]; }
+
+  size_type size() const { return size_; }
+  size_type capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+
+  // True while the elements still live in the inline buffer.
+  bool is_inline() const { return data_ == InlineData(); }
+
+  void reserve(size_type new_capacity) {
+    if (new_capacity <= capacity_) {
+      return;
+    }
+    T *new_data = Allocate(new_capacity);
+    std::uninitialized_move(data_, data_ + size_, new_data);
+    std::destroy(data_, data_ + size_);
+    ReleaseHeap();
+    data_ = new_data;
+    capacity_ = new_capacity;
+  }
+
+  void clear() {
+    std::destroy(data_, data_ + size_);
+    size_ = 0;
+  }
+
+  void push_back(const T &value) { emplace_back(value); }
+
+  void push_back(T &&value) { emplace_back(std::move(value)); }
+
+  template <typename... Args> T &emplace_back(Args &&...args) {
+    if (size_ == capacity_) {
+      reserve(capacity_ * 2);
+    }
+    T *slot = ::new (static_cast<void *>(data_ + size_))
+        T(std::forward<Args>(args)...);
+    ++size_;
+    return *slot;
+  }
+
+  // Inserts before position and returns an iterator to the new element.
+  template <typename... Args>
+  iterator emplace(const_iterator position, Args &&...args) {
+    const size_type index = static_cast<size_type>(position - data_);
+    emplace_back(std::forward<Args>(args)...);
+    std::rotate(data_ + index, data_ + size_ - 1, data_ + size_);
+    return data_ + index;
+  }
+
+  iterator erase(const_iterator position) {
+    const size_type index = static_cast<size_type>(position - data_);
+    std::move(data_ + index + 1, data_ + size_, data_ + index);
+    --size_;
+    std::destroy_at(data_ + size_);
+    return data_ + index;
+  }
+
+private:
+  T *InlineData() { return reinterpret_cast<T *>(inline_storage_); }
+  const T *InlineData() const {
+    return reinterpret_cast<const T *>(inline_storage_);
+  }
+
+  static T *Allocate(size_type count) {
+    return static_cast<T *>(
+        ::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+  }
+
+  void ReleaseHeap() {
+    if (!is_inline()) {
+      ::operator delete(data_, std::align_val_t(alignof(T)));
+      data_ = InlineData();
+      capacity_ = N;
+    }
+  }
+
+  void MoveFrom(SmallVector &&other) {
+    if (other.is_inline()) {
+      std::uninitialized_move(other.begin(), other.end(), data_);
+      size_ = other.size_;
+      other.clear();
+      return;
+    }
+    // Steal the heap block.
+    data_ = other.data_;
+    size_ = other.size_;
+    capacity_ = other.capacity_;
+    other.data_ = other.InlineData();
+    other.size_ = 0;
+    other.capacity_ = N;
+  }
+
+  alignas(T) unsigned char inline_storage_[sizeof(T) * N];
+  T *data_ = InlineData();
+  size_type size_ = 0;
+  size_type capacity_ = N;
+};
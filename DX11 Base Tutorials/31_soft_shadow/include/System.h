@@ -28,6 +28,9 @@ private:
   std::unique_ptr<Graphics> graphics_;
 
   std::unique_ptr<Position> position_;
+
+  // Picking fires once per left-button press.
+  bool left_button_was_down_ = false;
 };
 
 static LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
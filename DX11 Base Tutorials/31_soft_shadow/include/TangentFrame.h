@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class JobSystem;
+
+// ============================================================================
+// Tangent frame generation for indexed triangle meshes
+// ============================================================================
+//
+// Per-vertex tangent and binormal in the spirit of MikkTSpace: each face's
+// UV-space tangent and binormal are normalized and summed into its vertices
+// weighted by the corner angle, then the frame is orthogonalized against
+// the vertex normal (Gram-Schmidt). Vertices with distinct UVs or normals
+// (seams, mirrored halves) are distinct records, so they keep separate
+// frames; the binormal is accumulated rather than rebuilt from a cross
+// product, so mirrored UVs keep their handedness.
+//
+// Faces are processed four at a time with SSE and vertices are finalized
+// four at a time from the SoA streams. With a JobSystem, meshes of at least
+// kTangentFrameParallelTriangles triangles compute face frames and finalize
+// vertices across its workers; the sums are added in triangle order, so
+// the result does not depend on the worker count.
+
+// Vertex streams, one component per array. Positions, texcoords and
+// normals are inputs; tangents and binormals are written.
+struct TangentFrameStreams {
+  std::vector<float> px, py, pz;
+  std::vector<float> u, v;
+  std::vector<float> nx, ny, nz;
+  std::vector<float> tx, ty, tz;
+  std::vector<float> bx, by, bz;
+
+  std::size_t GetVertexCount() const { return px.size(); }
+
+  void Resize(std::size_t vertex_count);
+
+  // Reads position, texcoord and normal from the first eight floats of
+  // interleaved records (the text model layout); stride is in floats.
+  void Gather(const float *vertices, std::size_t vertex_count,
+              std::size_t stride);
+
+  // Writes tangent then binormal at offset floats into each record.
+  void Scatter(float *vertices, std::size_t stride, std::size_t offset) const;
+};
+
+constexpr std::size_t kTangentFrameParallelTriangles = 65536;
+
+// Worker pool for one GenerateTangentFrames() call on a mesh of
+// triangle_count triangles; null when the mesh is too small to split.
+std::unique_ptr<JobSystem>
+CreateTangentFrameJobSystem(std::size_t triangle_count);
+
+// Fills the tangent and binormal streams for the triangle list. Every
+// output is unit length and perpendicular to the (unit) normal; vertices no
+// triangle gives a UV direction get an arbitrary perpendicular frame.
+void GenerateTangentFrames(const std::uint32_t *indices,
+                           std::size_t index_count,
+                           TangentFrameStreams &streams,
+                           JobSystem *job_system = nullptr);
+
+// Runs GenerateTangentFrames() on interleaved records holding the text
+// model layout followed by tangent and binormal (14 floats or more).
+void GenerateTangentFrames(float *vertices, std::size_t vertex_count,
+                           std::size_t stride,
+                           const std::vector<std::uint32_t> &indices,
+                           JobSystem *job_system = nullptr);
@@ -0,0 +1,7 @@
+#pragma once
+
+// Headless benchmark of tangent frame generation on a 4M-triangle terrain
+// grid: the scalar per-face accumulation the loaders used before, the SSE
+// path on one thread and the SSE path on the JobSystem. Prints timings to
+// stdout. Returns false if any generated frame is not orthonormal.
+bool RunTangentFrameBenchmarks();
@@ -0,0 +1,6 @@
+#pragma once
+
+// Executes the tangent frame unit tests: planar and shared-vertex frames,
+// mirrored UV handedness, degenerate UV fallback, threaded determinism and
+// the interleaved overload. Returns true when all tests pass.
+bool RunTangentFrameTests();
@@ -20,13 +20,13 @@ void BoundingVolume::CalculateFromVertices(const XMFLOAT3 *vertices,
   aabb_max = vertices[0];
 
   for (size_t i = 1; i < count; ++i) {
-    aabb_min.x = std::min(aabb_min.x, vertices[i].x);
-    aabb_min.y = std::min(aabb_min.y, vertices[i].y);
-    aabb_min.z = std::min(aabb_min.z, vertices[i].z);
+    aabb_min.x = (std::min)(aabb_min.x, vertices[i].x);
+    aabb_min.y = (std::min)(aabb_min.y, vertices[i].y);
+    aabb_min.z = (std::min)(aabb_min.z, vertices[i].z);
 
-    aabb_max.x = std::max(aabb_max.x, vertices[i].x);
-    aabb_max.y = std::max(aabb_max.y, vertices[i].y);
-    aabb_max.z = std::max(aabb_max.z, vertices[i].z);
+    aabb_max.x = (std::max)(aabb_max.x, vertices[i].x);
+    aabb_max.y = (std::max)(aabb_max.y, vertices[i].y);
+    aabb_max.z = (std::max)(aabb_max.z, vertices[i].z);
   }
 
   // Calculate bounding sphere from AABB
@@ -44,13 +44,13 @@ void BoundingVolume::CalculateFromVertices(const XMFLOAT3 *vertices,
 
 void BoundingVolume::Merge(const BoundingVolume &other) {
   // Merge AABB
-  aabb_min.x = std::min(aabb_min.x, other.aabb_min.x);
-  aabb_min.y = std::min(aabb_min.y, other.aabb_min.y);
-  aabb_min.z = std::min(aabb_min.z, other.aabb_min.z);
+  aabb_min.x = (std::min)(aabb_min.x, other.aabb_min.x);
+  aabb_min.y = (std::min)(aabb_min.y, other.aabb_min.y);
+  aabb_min.z = (std::min)(aabb_min.z, other.aabb_min.z);
 
-  aabb_max.x = std::max(aabb_max.x, other.aabb_max.x);
-  aabb_max.y = std::max(aabb_max.y, other.aabb_max.y);
-  aabb_max.z = std::max(aabb_max.z, other.aabb_max.z);
+  aabb_max.x = (std::max)(aabb_max.x, other.aabb_max.x);
+  aabb_max.y = (std::max)(aabb_max.y, other.aabb_max.y);
+  aabb_max.z = (std::max)(aabb_max.z, other.aabb_max.z);
 
   // Recalculate bounding sphere
   sphere_center.x = (aabb_min.x + aabb_max.x) * 0.5f;
@@ -0,0 +1,584 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+using namespace DirectX;
+
+namespace {
+
+constexpr int kBinCount = 16;
+constexpr int kAllPlanes = 0x3f;
+
+XMFLOAT3 Min(const XMFLOAT3 &a, const XMFLOAT3 &b) {
+  return XMFLOAT3((std::min)(a.x, b.x), (std::min)(a.y, b.y),
+                  (std::min)(a.z, b.z));
+}
+
+XMFLOAT3 Max(const XMFLOAT3 &a, const XMFLOAT3 &b) {
+  return XMFLOAT3((std::max)(a.x, b.x), (std::max)(a.y, b.y),
+                  (std::max)(a.z, b.z));
+}
+
+// Half the surface area; the factor cancels out in every SAH comparison.
+float HalfArea(const XMFLOAT3 &min, const XMFLOAT3 &max) {
+  const float dx = max.x - min.x;
+  const float dy = max.y - min.y;
+  const float dz = max.z - min.z;
+  return dx * dy + dy * dz + dz * dx;
+}
+
+float Component(const XMFLOAT3 &v, int axis) {
+  return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+// Entry distance of the ray into the box, or false if it misses within
+// [0, max_distance].
+bool RayBox(const XMFLOAT3 &origin, const XMFLOAT3 &direction,
+            const XMFLOAT3 &min, const XMFLOAT3 &max, float max_distance,
+            float &entry) {
+  const float o[3] = {origin.x, origin.y, origin.z};
+  const float d[3] = {direction.x, direction.y, direction.z};
+  const float lo[3] = {min.x, min.y, min.z};
+  const float hi[3] = {max.x, max.y, max.z};
+
+  float t_min = 0.0f;
+  float t_max = max_distance;
+  for (int axis = 0; axis < 3; ++axis) {
+    if (d[axis] == 0.0f) {
+      if (o[axis] < lo[axis] || o[axis] > hi[axis]) {
+        return false;
+      }
+      continue;
+    }
+    const float inv = 1.0f / d[axis];
+    float t0 = (lo[axis] - o[axis]) * inv;
+    float t1 = (hi[axis] - o[axis]) * inv;
+    if (t0 > t1) {
+      std::swap(t0, t1);
+    }
+    t_min = (std::max)(t_min, t0);
+    t_max = (std::min)(t_max, t1);
+    if (t_min > t_max) {
+      return false;
+    }
+  }
+  entry = t_min;
+  return true;
+}
+
+} // namespace
+
+void BoundingVolumeHierarchy::Build(const std::vector<BvhItem> &items,
+                                    std::vector<int> *proxies) {
+  Clear();
+  if (proxies) {
+    proxies->assign(items.size(), kNullNode);
+  }
+  if (items.empty()) {
+    return;
+  }
+
+  std::vector<BuildRef> refs(items.size());
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    const auto &bounds = items[i].bounds;
+    refs[i].min = bounds.aabb_min;
+    refs[i].max = bounds.aabb_max;
+    refs[i].centroid = XMFLOAT3((bounds.aabb_min.x + bounds.aabb_max.x) * 0.5f,
+                                (bounds.aabb_min.y + bounds.aabb_max.y) * 0.5f,
+                                (bounds.aabb_min.z + bounds.aabb_max.z) * 0.5f);
+    refs[i].item = i;
+  }
+
+  nodes_.reserve(items.size() * 2 - 1);
+  root_ = BuildRange(refs, 0, refs.size(), items, proxies);
+  leaf_count_ = items.size();
+
+  // Internal boxes once all leaves exist.
+  needs_refit_ = true;
+  Refit();
+}
+
+int BoundingVolumeHierarchy::BuildRange(std::vector<BuildRef> &refs,
+                                        std::size_t begin, std::size_t end,
+                                        const std::vector<BvhItem> &items,
+                                        std::vector<int> *proxies) {
+  // Explicit work stack: SAH splits can be unbalanced, and a recursive build
+  // of a million objects must not depend on the thread's stack size.
+  struct Task {
+    std::size_t begin;
+    std::size_t end;
+    int parent;
+    bool is_left;
+  };
+  std::vector<Task> tasks;
+  tasks.push_back({begin, end, kNullNode, false});
+  int first_node = kNullNode;
+
+  while (!tasks.empty()) {
+    const Task task = tasks.back();
+    tasks.pop_back();
+
+    const int node = AllocateNode();
+    if (first_node == kNullNode) {
+      first_node = node;
+    }
+    nodes_[node].parent = task.parent;
+    if (task.parent != kNullNode) {
+      (task.is_left ? nodes_[task.parent].left : nodes_[task.parent].right) =
+          node;
+    }
+
+    if (task.end - task.begin == 1) {
+      const BuildRef &ref = refs[task.begin];
+      nodes_[node].min = ref.min;
+      nodes_[node].max = ref.max;
+      nodes_[node].id = items[ref.item].id;
+      nodes_[node].tags = items[ref.item].tags;
+      if (proxies) {
+        (*proxies)[ref.item] = node;
+      }
+      continue;
+    }
+
+    // Bin centroids along the axis of largest centroid extent.
+    XMFLOAT3 centroid_min = refs[task.begin].centroid;
+    XMFLOAT3 centroid_max = centroid_min;
+    for (std::size_t i = task.begin + 1; i < task.end; ++i) {
+      centroid_min = Min(centroid_min, refs[i].centroid);
+      centroid_max = Max(centroid_max, refs[i].centroid);
+    }
+    const XMFLOAT3 extent(centroid_max.x - centroid_min.x,
+                          centroid_max.y - centroid_min.y,
+                          centroid_max.z - centroid_min.z);
+    int axis = 0;
+    if (extent.y > extent.x) {
+      axis = 1;
+    }
+    if (extent.z > Component(extent, axis)) {
+      axis = 2;
+    }
+    const float axis_min = Component(centroid_min, axis);
+    const float axis_extent = Component(extent, axis);
+
+    std::size_t mid = task.begin + (task.end - task.begin) / 2;
+    if (axis_extent > 0.0f) {
+      struct Bin {
+        XMFLOAT3 min;
+        XMFLOAT3 max;
+        std::size_t count = 0;
+      };
+      Bin bins[kBinCount];
+      const float scale = kBinCount / axis_extent;
+      auto bin_of = [&](const BuildRef &ref) {
+        const int bin = static_cast<int>(
+            (Component(ref.centroid, axis) - axis_min) * scale);
+        return (std::min)(bin, kBinCount - 1);
+      };
+      for (std::size_t i = task.begin; i < task.end; ++i) {
+        Bin &bin = bins[bin_of(refs[i])];
+        bin.min = bin.count == 0 ? refs[i].min : Min(bin.min, refs[i].min);
+        bin.max = bin.count == 0 ? refs[i].max : Max(bin.max, refs[i].max);
+        ++bin.count;
+      }
+
+      // Sweep from the right to get the cost of every right-hand side, then
+      // from the left to evaluate each split plane.
+      float right_area[kBinCount] = {};
+      std::size_t right_count[kBinCount] = {};
+      XMFLOAT3 acc_min, acc_max;
+      std::size_t acc_count = 0;
+      for (int b = kBinCount - 1; b > 0; --b) {
+        if (bins[b].count > 0) {
+          acc_min = acc_count == 0 ? bins[b].min : Min(acc_min, bins[b].min);
+          acc_max = acc_count == 0 ? bins[b].max : Max(acc_max, bins[b].max);
+          acc_count += bins[b].count;
+        }
+        right_area[b] = acc_count > 0 ? HalfArea(acc_min, acc_max) : 0.0f;
+        right_count[b] = acc_count;
+      }
+
+      float best_cost = (std::numeric_limits<float>::max)();
+      int best_split = -1;
+      acc_count = 0;
+      for (int b = 0; b < kBinCount - 1; ++b) {
+        if (bins[b].count > 0) {
+          acc_min = acc_count == 0 ? bins[b].min : Min(acc_min, bins[b].min);
+          acc_max = acc_count == 0 ? bins[b].max : Max(acc_max, bins[b].max);
+          acc_count += bins[b].count;
+        }
+        if (acc_count == 0 || right_count[b + 1] == 0) {
+          continue;
+        }
+        const float cost = HalfArea(acc_min, acc_max) * acc_count +
+                           right_area[b + 1] * right_count[b + 1];
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_split = b;
+        }
+      }
+
+      if (best_split >= 0) {
+        const auto split =
+            std::partition(refs.begin() + task.begin, refs.begin() + task.end,
+                           [&](const BuildRef &ref) {
+                             return bin_of(ref) <= best_split;
+                           });
+        mid = static_cast<std::size_t>(split - refs.begin());
+      }
+    }
+
+    // Coincident centroids or an empty side: split at the median.
+    if (mid == task.begin || mid == task.end) {
+      mid = task.begin + (task.end - task.begin) / 2;
+      std::nth_element(refs.begin() + task.begin, refs.begin() + mid,
+                       refs.begin() + task.end,
+                       [axis](const BuildRef &a, const BuildRef &b) {
+                         return Component(a.centroid, axis) <
+                                Component(b.centroid, axis);
+                       });
+    }
+
+    tasks.push_back({mid, task.end, node, false});
+    tasks.push_back({task.begin, mid, node, true});
+  }
+
+  return first_node;
+}
+
+int BoundingVolumeHierarchy::Insert(std::uint32_t id,
+                                    const BoundingVolume &bounds,
+                                    TagMask tags) {
+  const int leaf = AllocateNode();
+  nodes_[leaf].min = bounds.aabb_min;
+  nodes_[leaf].max = bounds.aabb_max;
+  nodes_[leaf].id = id;
+  nodes_[leaf].tags = tags;
+  ++leaf_count_;
+  needs_refit_ = true;
+
+  if (root_ == kNullNode) {
+    root_ = leaf;
+    return leaf;
+  }
+
+  // Descend towards the sibling with the lowest cost increase: creating a
+  // parent at a node costs its combined area, and every ancestor above it
+  // grows by the difference.
+  const XMFLOAT3 leaf_min = nodes_[leaf].min;
+  const XMFLOAT3 leaf_max = nodes_[leaf].max;
+  int index = root_;
+  while (!nodes_[index].IsLeaf()) {
+    const Node &node = nodes_[index];
+    const float area = HalfArea(node.min, node.max);
+    const float combined =
+        HalfArea(Min(node.min, leaf_min), Max(node.max, leaf_max));
+    const float cost = 2.0f * combined;
+    const float inheritance = 2.0f * (combined - area);
+
+    auto descend_cost = [&](int child) {
+      const Node &c = nodes_[child];
+      const float merged = HalfArea(Min(c.min, leaf_min), Max(c.max, leaf_max));
+      return c.IsLeaf() ? merged + inheritance
+                        : merged - HalfArea(c.min, c.max) + inheritance;
+    };
+    const float cost_left = descend_cost(node.left);
+    const float cost_right = descend_cost(node.right);
+
+    if (cost < cost_left && cost < cost_right) {
+      break;
+    }
+    index = cost_left < cost_right ? node.left : node.right;
+  }
+
+  const int sibling = index;
+  const int old_parent = nodes_[sibling].parent;
+  const int new_parent = AllocateNode();
+  nodes_[new_parent].parent = old_parent;
+  nodes_[new_parent].left = sibling;
+  nodes_[new_parent].right = leaf;
+  nodes_[sibling].parent = new_parent;
+  nodes_[leaf].parent = new_parent;
+
+  if (old_parent == kNullNode) {
+    root_ = new_parent;
+  } else if (nodes_[old_parent].left == sibling) {
+    nodes_[old_parent].left = new_parent;
+  } else {
+    nodes_[old_parent].right = new_parent;
+  }
+
+  RefitAncestors(new_parent);
+  return leaf;
+}
+
+void BoundingVolumeHierarchy::Remove(int proxy) {
+  --leaf_count_;
+  needs_refit_ = true;
+  if (proxy == root_) {
+    root_ = kNullNode;
+    FreeNode(proxy);
+    return;
+  }
+
+  const int parent = nodes_[proxy].parent;
+  const int grand_parent = nodes_[parent].parent;
+  const int sibling = nodes_[parent].left == proxy ? nodes_[parent].right
+                                                   : nodes_[parent].left;
+
+  if (grand_parent == kNullNode) {
+    root_ = sibling;
+    nodes_[sibling].parent = kNullNode;
+  } else {
+    if (nodes_[grand_parent].left == parent) {
+      nodes_[grand_parent].left = sibling;
+    } else {
+      nodes_[grand_parent].right = sibling;
+    }
+    nodes_[sibling].parent = grand_parent;
+    RefitAncestors(grand_parent);
+  }
+  FreeNode(parent);
+  FreeNode(proxy);
+}
+
+void BoundingVolumeHierarchy::Update(int proxy, const BoundingVolume &bounds,
+                                     TagMask tags) {
+  nodes_[proxy].min = bounds.aabb_min;
+  nodes_[proxy].max = bounds.aabb_max;
+  nodes_[proxy].tags = tags;
+  needs_refit_ = true;
+}
+
+void BoundingVolumeHierarchy::Refit() {
+  if (!needs_refit_) {
+    return;
+  }
+  needs_refit_ = false;
+  if (root_ == kNullNode) {
+    sah_cost_ = 0.0f;
+    return;
+  }
+
+  // Depth-first pre-order, which is also the allocation order of Build();
+  // visiting it backwards sees children before parents.
+  refit_order_.clear();
+  refit_order_.reserve(nodes_.size());
+  refit_stack_.clear();
+  refit_stack_.push_back(root_);
+  while (!refit_stack_.empty()) {
+    const int node = refit_stack_.back();
+    refit_stack_.pop_back();
+    refit_order_.push_back(node);
+    if (!nodes_[node].IsLeaf()) {
+      refit_stack_.push_back(nodes_[node].right);
+      refit_stack_.push_back(nodes_[node].left);
+    }
+  }
+
+  double internal_area = 0.0;
+  for (auto it = refit_order_.rbegin(); it != refit_order_.rend(); ++it) {
+    if (!nodes_[*it].IsLeaf()) {
+      RefitNode(*it);
+      internal_area += HalfArea(nodes_[*it].min, nodes_[*it].max);
+    }
+  }
+  const float root_area = HalfArea(nodes_[root_].min, nodes_[root_].max);
+  sah_cost_ =
+      root_area > 0.0f ? static_cast<float>(internal_area / root_area) : 0.0f;
+}
+
+void BoundingVolumeHierarchy::Clear() {
+  nodes_.clear();
+  free_nodes_.clear();
+  root_ = kNullNode;
+  leaf_count_ = 0;
+  needs_refit_ = false;
+  sah_cost_ = 0.0f;
+}
+
+void BoundingVolumeHierarchy::QueryFrustum(const XMFLOAT4 (&planes)[6],
+                                           std::vector<std::uint32_t> &out,
+                                           TagMask mask) const {
+  if (root_ == kNullNode) {
+    return;
+  }
+
+  float abs_normals[6][3];
+  for (int p = 0; p < 6; ++p) {
+    abs_normals[p][0] = std::fabs(planes[p].x);
+    abs_normals[p][1] = std::fabs(planes[p].y);
+    abs_normals[p][2] = std::fabs(planes[p].z);
+  }
+
+  // Each entry carries the planes its box still straddles; once a box is
+  // inside all of them, its whole subtree is accepted without tests.
+  std::vector<FrustumEntry> &stack = frustum_stack_;
+  stack.clear();
+  stack.push_back({root_, kAllPlanes});
+
+  while (!stack.empty()) {
+    const FrustumEntry entry = stack.back();
+    stack.pop_back();
+    const Node &node = nodes_[entry.node];
+    if (mask != 0 && (node.tags & mask) == 0) {
+      continue;
+    }
+
+    int active = entry.active_planes;
+    if (active != 0) {
+      const float cx = (node.min.x + node.max.x) * 0.5f;
+      const float cy = (node.min.y + node.max.y) * 0.5f;
+      const float cz = (node.min.z + node.max.z) * 0.5f;
+      const float ex = (node.max.x - node.min.x) * 0.5f;
+      const float ey = (node.max.y - node.min.y) * 0.5f;
+      const float ez = (node.max.z - node.min.z) * 0.5f;
+      bool outside = false;
+      for (int p = 0; p < 6; ++p) {
+        if ((active & (1 << p)) == 0) {
+          continue;
+        }
+        const float dist = planes[p].x * cx + planes[p].y * cy +
+                           planes[p].z * cz + planes[p].w;
+        const float radius = abs_normals[p][0] * ex + abs_normals[p][1] * ey +
+                             abs_normals[p][2] * ez;
+        if (dist + radius < 0.0f) {
+          outside = true;
+          break;
+        }
+        if (dist - radius >= 0.0f) {
+          active &= ~(1 << p);
+        }
+      }
+      if (outside) {
+        continue;
+      }
+    }
+
+    if (node.IsLeaf()) {
+      out.push_back(node.id);
+    } else {
+      stack.push_back({node.right, active});
+      stack.push_back({node.left, active});
+    }
+  }
+}
+
+bool BoundingVolumeHierarchy::Raycast(const XMFLOAT3 &origin,
+                                      const XMFLOAT3 &direction,
+                                      float max_distance, BvhRayHit &hit,
+                                      const RayLeafTest &leaf_test) const {
+  if (root_ == kNullNode) {
+    return false;
+  }
+
+  float best = max_distance;
+  bool found = false;
+  float entry;
+  if (!RayBox(origin, direction, nodes_[root_].min, nodes_[root_].max, best,
+              entry)) {
+    return false;
+  }
+
+  std::vector<RayEntry> &stack = ray_stack_;
+  stack.clear();
+  stack.push_back({root_, entry});
+
+  while (!stack.empty()) {
+    const RayEntry current = stack.back();
+    stack.pop_back();
+    if (current.distance > best) {
+      continue; // A closer hit was found after this node was pushed.
+    }
+
+    const Node &node = nodes_[current.node];
+    if (node.IsLeaf()) {
+      float distance = current.distance;
+      if (leaf_test && !leaf_test(node.id, distance)) {
+        continue;
+      }
+      if (distance <= best) {
+        best = distance;
+        hit.id = node.id;
+        hit.distance = distance;
+        found = true;
+      }
+      continue;
+    }
+
+    // Visit the nearer child first so the farther one is usually pruned.
+    float left_entry = 0.0f;
+    float right_entry = 0.0f;
+    const bool left_hit = RayBox(origin, direction, nodes_[node.left].min,
+                                 nodes_[node.left].max, best, left_entry);
+    const bool right_hit = RayBox(origin, direction, nodes_[node.right].min,
+                                  nodes_[node.right].max, best, right_entry);
+    if (left_hit && right_hit) {
+      if (left_entry <= right_entry) {
+        stack.push_back({node.right, right_entry});
+        stack.push_back({node.left, left_entry});
+      } else {
+        stack.push_back({node.left, left_entry});
+        stack.push_back({node.right, right_entry});
+      }
+    } else if (left_hit) {
+      stack.push_back({node.left, left_entry});
+    } else if (right_hit) {
+      stack.push_back({node.right, right_entry});
+    }
+  }
+  return found;
+}
+
+int BoundingVolumeHierarchy::GetHeight() const {
+  if (root_ == kNullNode) {
+    return 0;
+  }
+  int height = 0;
+  std::vector<std::pair<int, int>> stack{{root_, 1}};
+  while (!stack.empty()) {
+    const auto [node, depth] = stack.back();
+    stack.pop_back();
+    height = (std::max)(height, depth);
+    if (!nodes_[node].IsLeaf()) {
+      stack.push_back({nodes_[node].left, depth + 1});
+      stack.push_back({nodes_[node].right, depth + 1});
+    }
+  }
+  return height;
+}
+
+int BoundingVolumeHierarchy::AllocateNode() {
+  if (!free_nodes_.empty()) {
+    const int node = free_nodes_.back();
+    free_nodes_.pop_back();
+    nodes_[node] = Node{};
+    return node;
+  }
+  nodes_.emplace_back();
+  return static_cast<int>(nodes_.size() - 1);
+}
+
+void BoundingVolumeHierarchy::FreeNode(int node) {
+  nodes_[node].parent = kNullNode;
+  nodes_[node].left = kNullNode;
+  nodes_[node].right = kNullNode;
+  free_nodes_.push_back(node);
+}
+
+void BoundingVolumeHierarchy::RefitNode(int node) {
+  Node &n = nodes_[node];
+  const Node &left = nodes_[n.left];
+  const Node &right = nodes_[n.right];
+  n.min = Min(left.min, right.min);
+  n.max = Max(left.max, right.max);
+  n.tags = left.tags | right.tags;
+}
+
+void BoundingVolumeHierarchy::RefitAncestors(int node) {
+  for (; node != kNullNode; node = nodes_[node].parent) {
+    RefitNode(node);
+  }
+}
@@ -0,0 +1,179 @@
+#include "BoundingVolumeHierarchyBenchmarks.h"
+
+#include "BoundingVolumeHierarchy.h"
+#include "Frustum.h"
+#include "FrustumCuller.h"
+
+#include <DirectXMath.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr float kScreenDepth = 1000.0f;
+constexpr int kQueryFrames = 5;
+constexpr int kRayCount = 10000;
+
+template <typename Func> double MeasureMilliseconds(Func &&func) {
+  const auto start = Clock::now();
+  func();
+  const auto end = Clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Same distribution as the frustum culling benchmark.
+std::vector<BvhItem> BuildItems(std::size_t count) {
+  std::mt19937 rng(1234u);
+  std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+  std::uniform_real_distribution<float> size(0.5f, 6.0f);
+
+  std::vector<BvhItem> items(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const XMFLOAT3 min(position(rng), position(rng) * 0.1f, position(rng));
+    const XMFLOAT3 corners[2] = {
+        min, XMFLOAT3(min.x + size(rng), min.y + size(rng), min.z + size(rng))};
+    items[i].id = static_cast<std::uint32_t>(i);
+    items[i].bounds.CalculateFromVertices(corners, 2);
+    items[i].tags = TagMask{1} << (i % 4);
+  }
+  return items;
+}
+
+WorldBoundsColumns ToColumns(const std::vector<BvhItem> &items) {
+  WorldBoundsColumns columns;
+  for (const auto &item : items) {
+    const auto &b = item.bounds;
+    columns.min_x.push_back(b.aabb_min.x);
+    columns.min_y.push_back(b.aabb_min.y);
+    columns.min_z.push_back(b.aabb_min.z);
+    columns.max_x.push_back(b.aabb_max.x);
+    columns.max_y.push_back(b.aabb_max.y);
+    columns.max_z.push_back(b.aabb_max.z);
+    columns.center_x.push_back(b.sphere_center.x);
+    columns.center_y.push_back(b.sphere_center.y);
+    columns.center_z.push_back(b.sphere_center.z);
+    columns.radius.push_back(b.sphere_radius);
+    columns.has_bounds.push_back(1);
+  }
+  return columns;
+}
+
+bool RunBvhBenchmark(std::size_t item_count) {
+  auto items = BuildItems(item_count);
+
+  BoundingVolumeHierarchy bvh;
+  std::vector<int> proxies;
+  const double build_ms =
+      MeasureMilliseconds([&] { bvh.Build(items, &proxies); });
+  const float built_cost = bvh.GetSahCost();
+
+  BoundingVolumeHierarchy incremental;
+  const double insert_ms = MeasureMilliseconds([&] {
+    for (const auto &item : items) {
+      incremental.Insert(item.id, item.bounds, item.tags);
+    }
+    incremental.Refit();
+  });
+
+  // Move 10% of the objects a short distance, as animation would.
+  const double refit_ms = MeasureMilliseconds([&] {
+    for (std::size_t i = 0; i < items.size(); i += 10) {
+      auto &b = items[i].bounds;
+      b.aabb_min.x += 1.5f;
+      b.aabb_max.x += 1.5f;
+      bvh.Update(proxies[i], b, items[i].tags);
+    }
+    bvh.Refit();
+  });
+
+  const XMMATRIX projection =
+      XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, kScreenDepth);
+  const XMMATRIX view =
+      XMMatrixLookAtLH(XMVectorSet(0.0f, 10.0f, -20.0f, 1.0f),
+                       XMVectorSet(0.0f, 0.0f, 100.0f, 1.0f),
+                       XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+  FrustumClass frustum;
+  frustum.ConstructFrustum(kScreenDepth, projection, view);
+  XMFLOAT4 planes[6];
+  frustum.GetPlanes(planes);
+
+  std::vector<std::uint32_t> visible;
+  visible.reserve(item_count);
+  const double bvh_query_ms = MeasureMilliseconds([&] {
+    for (int frame = 0; frame < kQueryFrames; ++frame) {
+      visible.clear();
+      bvh.QueryFrustum(planes, visible);
+    }
+  }) / kQueryFrames;
+  const std::size_t bvh_visible = visible.size();
+
+  // One tag out of four, as for shadow casters.
+  const double caster_query_ms = MeasureMilliseconds([&] {
+    for (int frame = 0; frame < kQueryFrames; ++frame) {
+      visible.clear();
+      bvh.QueryShadowCasters(planes, TagMask{1}, visible);
+    }
+  }) / kQueryFrames;
+
+  const WorldBoundsColumns columns = ToColumns(items);
+  FrustumCuller culler;
+  culler.SetPlanes(planes);
+  culler.Cull(columns, visible); // Warm the coherency cache
+  const double flat_query_ms = MeasureMilliseconds([&] {
+    for (int frame = 0; frame < kQueryFrames; ++frame) {
+      culler.Cull(columns, visible);
+    }
+  }) / kQueryFrames;
+  const std::size_t flat_visible = visible.size();
+
+  std::mt19937 rng(77u);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  int ray_hits = 0;
+  const double ray_ms = MeasureMilliseconds([&] {
+    for (int ray = 0; ray < kRayCount; ++ray) {
+      const XMFLOAT3 origin(unit(rng) * 500.0f, 40.0f, unit(rng) * 500.0f);
+      const XMFLOAT3 direction(unit(rng), -1.0f, unit(rng));
+      BvhRayHit hit;
+      ray_hits += bvh.Raycast(origin, direction, 1000.0f, hit) ? 1 : 0;
+    }
+  });
+
+  std::cout << std::setw(8) << item_count << " boxes | build " << std::fixed
+            << std::setprecision(2) << std::setw(8) << build_ms
+            << " ms (SAH " << built_cost << ") | insert " << std::setw(8)
+            << insert_ms << " ms (SAH " << incremental.GetSahCost()
+            << ") | refit 10% " << std::setw(7) << refit_ms << " ms"
+            << std::endl;
+  std::cout << "         frustum: bvh " << std::setprecision(3)
+            << std::setw(8) << bvh_query_ms << " ms, flat culler "
+            << std::setw(8) << flat_query_ms << " ms, casters "
+            << std::setw(8) << caster_query_ms << " ms | visible "
+            << bvh_visible << " | rays " << std::setprecision(1)
+            << (ray_ms > 0.0 ? kRayCount / ray_ms : 0.0) << "k/s ("
+            << ray_hits << " hits)" << std::endl;
+
+  return bvh_visible == flat_visible;
+}
+
+} // namespace
+
+bool RunBoundingVolumeHierarchyBenchmarks() {
+  std::cout << "=== Bounding volume hierarchy benchmark ===" << std::endl;
+  bool consistent = true;
+  for (std::size_t item_count : {10000u, 100000u, 1000000u}) {
+    consistent = RunBvhBenchmark(item_count) && consistent;
+  }
+  if (!consistent) {
+    std::cout << "Visible counts differ between BVH and flat culling"
+              << std::endl;
+  }
+  return consistent;
+}
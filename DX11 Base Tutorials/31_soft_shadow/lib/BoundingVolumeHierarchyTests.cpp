@@ -0,0 +1,401 @@
+#include "BoundingVolumeHierarchyTests.h"
+
+#include "BoundingVolumeHierarchy.h"
+#include "Frustum.h"
+#include "Logger.h"
+
+#include <DirectXMath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+// 90 degree frustum looking down +z, near 1, far 100.
+void MakeTestPlanes(XMFLOAT4 (&planes)[6]) {
+  const float s = 1.0f / std::sqrt(2.0f);
+  planes[0] = XMFLOAT4(0.0f, 0.0f, 1.0f, -1.0f);
+  planes[1] = XMFLOAT4(0.0f, 0.0f, -1.0f, 100.0f);
+  planes[2] = XMFLOAT4(s, 0.0f, s, 0.0f);
+  planes[3] = XMFLOAT4(-s, 0.0f, s, 0.0f);
+  planes[4] = XMFLOAT4(0.0f, -s, s, 0.0f);
+  planes[5] = XMFLOAT4(0.0f, s, s, 0.0f);
+}
+
+BoundingVolume MakeBox(const XMFLOAT3 &min, const XMFLOAT3 &max) {
+  const XMFLOAT3 corners[2] = {min, max};
+  BoundingVolume bounds;
+  bounds.CalculateFromVertices(corners, 2);
+  return bounds;
+}
+
+std::vector<BvhItem> MakeRandomItems(std::size_t count, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> position(-120.0f, 120.0f);
+  std::uniform_real_distribution<float> size(0.1f, 6.0f);
+  std::vector<BvhItem> items(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const XMFLOAT3 min(position(rng), position(rng), position(rng));
+    items[i].id = static_cast<std::uint32_t>(i);
+    items[i].bounds = MakeBox(
+        min, XMFLOAT3(min.x + size(rng), min.y + size(rng), min.z + size(rng)));
+    items[i].tags = TagMask{1} << (i % 3);
+  }
+  return items;
+}
+
+bool BoxOutsideFrustum(const BoundingVolume &b, const XMFLOAT4 (&planes)[6]) {
+  for (const auto &p : planes) {
+    const float x = p.x >= 0.0f ? b.aabb_max.x : b.aabb_min.x;
+    const float y = p.y >= 0.0f ? b.aabb_max.y : b.aabb_min.y;
+    const float z = p.z >= 0.0f ? b.aabb_max.z : b.aabb_min.z;
+    if (p.x * x + p.y * y + p.z * z + p.w < 0.0f) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<std::uint32_t> BruteFrustum(const std::vector<BvhItem> &items,
+                                        const XMFLOAT4 (&planes)[6],
+                                        TagMask mask = 0) {
+  std::vector<std::uint32_t> ids;
+  for (const auto &item : items) {
+    if ((mask == 0 || (item.tags & mask) != 0) &&
+        !BoxOutsideFrustum(item.bounds, planes)) {
+      ids.push_back(item.id);
+    }
+  }
+  return ids;
+}
+
+std::vector<std::uint32_t> Sorted(std::vector<std::uint32_t> ids) {
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+bool TestBuildMatchesBruteForce(std::string &message) {
+  const auto items = MakeRandomItems(2000, 11u);
+  BoundingVolumeHierarchy bvh;
+  std::vector<int> proxies;
+  bvh.Build(items, &proxies);
+
+  if (bvh.GetLeafCount() != items.size() ||
+      bvh.GetNodeCount() != items.size() * 2 - 1) {
+    message = "unexpected node count";
+    return false;
+  }
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    if (bvh.GetId(proxies[i]) != items[i].id) {
+      message = "proxy does not map back to its item";
+      return false;
+    }
+  }
+  // A balanced-ish tree: far below a degenerate list.
+  if (bvh.GetHeight() > 40 || bvh.GetSahCost() <= 1.0f) {
+    message = "unexpected tree shape";
+    return false;
+  }
+
+  XMFLOAT4 planes[6];
+  MakeTestPlanes(planes);
+  std::vector<std::uint32_t> visible;
+  bvh.QueryFrustum(planes, visible);
+  const auto expected = BruteFrustum(items, planes);
+  if (Sorted(visible) != expected || expected.empty()) {
+    message = "frustum query differs from brute force";
+    return false;
+  }
+  return true;
+}
+
+bool TestShadowCasterQuery(std::string &message) {
+  const auto items = MakeRandomItems(1500, 12u);
+  BoundingVolumeHierarchy bvh;
+  bvh.Build(items);
+
+  XMFLOAT4 planes[6];
+  MakeTestPlanes(planes);
+  const TagMask caster_mask = TagMask{1} << 1;
+  std::vector<std::uint32_t> casters;
+  bvh.QueryShadowCasters(planes, caster_mask, casters);
+  const auto expected = BruteFrustum(items, planes, caster_mask);
+  if (Sorted(casters) != expected || expected.empty()) {
+    message = "caster query differs from brute force";
+    return false;
+  }
+  // A mask no leaf carries prunes at the root.
+  casters.clear();
+  bvh.QueryShadowCasters(planes, TagMask{1} << 40, casters);
+  return casters.empty();
+}
+
+bool TestRaycastReturnsNearest(std::string &message) {
+  const auto items = MakeRandomItems(1000, 13u);
+  BoundingVolumeHierarchy bvh;
+  bvh.Build(items);
+
+  std::mt19937 rng(99u);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  int hits = 0;
+  for (int ray = 0; ray < 200; ++ray) {
+    const XMFLOAT3 origin(unit(rng) * 150.0f, unit(rng) * 150.0f,
+                          unit(rng) * 150.0f);
+    XMFLOAT3 direction(unit(rng), unit(rng), unit(rng));
+    if (ray % 10 == 0) {
+      direction.y = 0.0f; // Axis-parallel slabs
+    }
+
+    // Brute force: slab test against every box.
+    float best = 1000.0f;
+    std::uint32_t best_id = 0xffffffffu;
+    for (const auto &item : items) {
+      float t_min = 0.0f;
+      float t_max = best;
+      const float o[3] = {origin.x, origin.y, origin.z};
+      const float d[3] = {direction.x, direction.y, direction.z};
+      const float lo[3] = {item.bounds.aabb_min.x, item.bounds.aabb_min.y,
+                           item.bounds.aabb_min.z};
+      const float hi[3] = {item.bounds.aabb_max.x, item.bounds.aabb_max.y,
+                           item.bounds.aabb_max.z};
+      bool hit = true;
+      for (int a = 0; a < 3 && hit; ++a) {
+        if (d[a] == 0.0f) {
+          hit = o[a] >= lo[a] && o[a] <= hi[a];
+          continue;
+        }
+        float t0 = (lo[a] - o[a]) / d[a];
+        float t1 = (hi[a] - o[a]) / d[a];
+        if (t0 > t1) {
+          std::swap(t0, t1);
+        }
+        t_min = (std::max)(t_min, t0);
+        t_max = (std::min)(t_max, t1);
+        hit = t_min <= t_max;
+      }
+      if (hit && t_min < best) {
+        best = t_min;
+        best_id = item.id;
+      }
+    }
+
+    BvhRayHit hit;
+    const bool found = bvh.Raycast(origin, direction, 1000.0f, hit);
+    if (found != (best_id != 0xffffffffu)) {
+      message = "ray " + std::to_string(ray) + " hit/miss mismatch";
+      return false;
+    }
+    if (found && std::fabs(hit.distance - best) > 1e-4f) {
+      message = "ray " + std::to_string(ray) + " did not return the nearest";
+      return false;
+    }
+    hits += found ? 1 : 0;
+  }
+  if (hits == 0) {
+    message = "no ray hit anything";
+    return false;
+  }
+
+  // The leaf test can reject objects; the query then continues past them.
+  const XMFLOAT3 origin(0.0f, 0.0f, -200.0f);
+  const XMFLOAT3 direction(0.0f, 0.0f, 1.0f);
+  BoundingVolumeHierarchy line;
+  std::vector<BvhItem> row(3);
+  for (int i = 0; i < 3; ++i) {
+    const float z = 10.0f * i;
+    row[i].id = static_cast<std::uint32_t>(i);
+    row[i].bounds =
+        MakeBox(XMFLOAT3(-1.0f, -1.0f, z), XMFLOAT3(1.0f, 1.0f, z + 1.0f));
+  }
+  line.Build(row);
+  BvhRayHit filtered;
+  const bool found = line.Raycast(
+      origin, direction, 1000.0f, filtered,
+      [](std::uint32_t id, float &) { return id != 0; });
+  return found && filtered.id == 1 &&
+         std::fabs(filtered.distance - 210.0f) < 1e-3f;
+}
+
+bool TestIncrementalInsertRemove(std::string &message) {
+  auto items = MakeRandomItems(600, 14u);
+  BoundingVolumeHierarchy bvh;
+  std::vector<int> proxies(items.size());
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    proxies[i] = bvh.Insert(items[i].id, items[i].bounds, items[i].tags);
+  }
+  bvh.Refit();
+
+  // Remove every other item.
+  std::vector<BvhItem> kept;
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    if (i % 2 == 0) {
+      bvh.Remove(proxies[i]);
+    } else {
+      kept.push_back(items[i]);
+    }
+  }
+  bvh.Refit();
+
+  if (bvh.GetLeafCount() != kept.size() ||
+      bvh.GetNodeCount() != kept.size() * 2 - 1) {
+    message = "counts wrong after removals";
+    return false;
+  }
+
+  XMFLOAT4 planes[6];
+  MakeTestPlanes(planes);
+  std::vector<std::uint32_t> visible;
+  bvh.QueryFrustum(planes, visible);
+  if (Sorted(visible) != BruteFrustum(kept, planes)) {
+    message = "query wrong after incremental changes";
+    return false;
+  }
+
+  // Removing everything leaves an empty tree that accepts new leaves.
+  for (std::size_t i = 1; i < items.size(); i += 2) {
+    bvh.Remove(proxies[i]);
+  }
+  const int proxy = bvh.Insert(7u, items[0].bounds, 0);
+  return bvh.GetLeafCount() == 1 && bvh.GetNodeCount() == 1 &&
+         bvh.GetId(proxy) == 7u;
+}
+
+bool TestUpdateAndRefit(std::string &message) {
+  auto items = MakeRandomItems(1000, 15u);
+  BoundingVolumeHierarchy bvh;
+  std::vector<int> proxies;
+  bvh.Build(items, &proxies);
+  const float built_cost = bvh.GetSahCost();
+
+  // Shift a third of the boxes far along x.
+  for (std::size_t i = 0; i < items.size(); i += 3) {
+    auto &b = items[i].bounds;
+    b.aabb_min.x += 60.0f;
+    b.aabb_max.x += 60.0f;
+    bvh.Update(proxies[i], b, items[i].tags);
+  }
+  bvh.Refit();
+
+  XMFLOAT4 planes[6];
+  MakeTestPlanes(planes);
+  std::vector<std::uint32_t> visible;
+  bvh.QueryFrustum(planes, visible);
+  if (Sorted(visible) != BruteFrustum(items, planes)) {
+    message = "query wrong after refit";
+    return false;
+  }
+  // Refitting keeps the topology, so scattering objects raises the cost.
+  if (!(bvh.GetSahCost() > built_cost)) {
+    message = "refit did not report a worse tree";
+    return false;
+  }
+  const float refit_cost = bvh.GetSahCost();
+  bvh.Build(items);
+  if (!(bvh.GetSahCost() < refit_cost)) {
+    message = "rebuild did not improve the tree";
+    return false;
+  }
+  return true;
+}
+
+bool TestExtractPlanesFromLightMatrix(std::string &message) {
+  const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 10.0f, 0.0f, 1.0f),
+                                         XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f),
+                                         XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f));
+  const XMMATRIX projection =
+      XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 1.0f, 50.0f);
+  XMFLOAT4 planes[6];
+  FrustumClass::ExtractPlanes(view * projection, planes);
+
+  auto inside = [&planes](float x, float y, float z) {
+    for (const auto &p : planes) {
+      if (p.x * x + p.y * y + p.z * z + p.w < -1e-4f) {
+        return false;
+      }
+    }
+    return true;
+  };
+  // The light looks straight down from y = 10.
+  if (!inside(0.0f, 0.0f, 0.0f) || !inside(3.0f, 0.0f, -3.0f)) {
+    message = "point below the light reported outside";
+    return false;
+  }
+  if (inside(0.0f, 11.0f, 0.0f) || inside(0.0f, -45.0f, 0.0f) ||
+      inside(20.0f, 5.0f, 0.0f)) {
+    message = "point outside the light frustum reported inside";
+    return false;
+  }
+  return true;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(6);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("SAH build matches brute force", TestBuildMatchesBruteForce);
+  run("Shadow caster query filters by tag", TestShadowCasterQuery);
+  run("Raycast returns the nearest hit", TestRaycastReturnsNearest);
+  run("Incremental insert and remove", TestIncrementalInsertRemove);
+  run("Update and refit", TestUpdateAndRefit);
+  run("Light frustum planes from view-projection",
+      TestExtractPlanesFromLightMatrix);
+
+  return results;
+}
+
+} // namespace
+
+bool RunBoundingVolumeHierarchyTests() {
+  const auto results = RunAllTestsInternal();
+  bool all_passed = true;
+
+  for (const auto &result : results) {
+    if (!result.passed) {
+      all_passed = false;
+      std::ostringstream oss;
+      oss << "Test failed: " << result.name;
+      if (!result.message.empty()) {
+        oss << " - " << result.message;
+      }
+      Logger::SetModule("BoundingVolumeHierarchyTests");
+      Logger::LogError(oss.str());
+    }
+  }
+
+  if (all_passed) {
+    Logger::SetModule("BoundingVolumeHierarchyTests");
+    Logger::LogInfo("All BoundingVolumeHierarchy tests passed");
+  }
+
+  return all_passed;
+}
@@ -31,7 +31,7 @@ bool DepthShader::Initialize(HWND hwnd, ID3D11Device *device) {
 }
 
 bool DepthShader::Render(int indexCount,
-                         const ShaderParameterContainer &parameters,
+                         const LayeredParameterView &parameters,
                          ID3D11DeviceContext *deviceContext) const {
   // Get all required matrices from parameters
   auto worldMatrix = parameters.GetMatrix("worldMatrix");
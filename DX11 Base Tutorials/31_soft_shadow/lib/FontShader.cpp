@@ -55,7 +55,7 @@ bool FontShader::Initialize(HWND hwnd, ID3D11Device *device) {
 }
 
 bool FontShader::Render(int indexCount,
-                        const ShaderParameterContainer &parameters,
+                        const LayeredParameterView &parameters,
                         ID3D11DeviceContext *deviceContext) const {
 
   auto worldMatrix = parameters.GetMatrix("deviceWorldMatrix");
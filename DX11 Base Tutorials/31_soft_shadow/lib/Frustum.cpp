@@ -327,3 +327,30 @@ bool FrustumClass::CheckBoundingVolume(const BoundingVolume &bounds) const {
   // Bounding sphere is visible, use AABB for precise test
   return CheckAABB(bounds.aabb_min, bounds.aabb_max);
 }
+
+void FrustumClass::GetPlanes(XMFLOAT4 (&planes)[6]) const {
+  for (int i = 0; i < 6; ++i) {
+    XMStoreFloat4(&planes[i], planes_[i]);
+  }
+}
+
+void FrustumClass::ExtractPlanes(const XMMATRIX &view_projection,
+                                 XMFLOAT4 (&planes)[6]) {
+  XMFLOAT4X4 m;
+  XMStoreFloat4x4(&m, view_projection);
+
+  // Column j of the matrix dotted with (x, y, z, 1) gives clip component j.
+  auto column = [&m](int j) {
+    return XMVectorSet(m.m[0][j], m.m[1][j], m.m[2][j], m.m[3][j]);
+  };
+  const XMVECTOR x = column(0);
+  const XMVECTOR y = column(1);
+  const XMVECTOR z = column(2);
+  const XMVECTOR w = column(3);
+
+  const XMVECTOR clip_planes[6] = {z,     w - z, w + x,
+                                   w - x, w - y, w + y};
+  for (int i = 0; i < 6; ++i) {
+    XMStoreFloat4(&planes[i], XMPlaneNormalize(clip_planes[i]));
+  }
+}
@@ -0,0 +1,168 @@
+#include "FrustumCuller.h"
+
+#include <cmath>
+#include <xmmintrin.h>
+
+namespace {
+
+struct BoxBatch {
+  __m128 cx, cy, cz;
+  __m128 ex, ey, ez;
+};
+
+BoxBatch LoadBatch(const WorldBoundsColumns &bounds, std::size_t i) {
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 min_x = _mm_loadu_ps(&bounds.min_x[i]);
+  const __m128 min_y = _mm_loadu_ps(&bounds.min_y[i]);
+  const __m128 min_z = _mm_loadu_ps(&bounds.min_z[i]);
+  const __m128 max_x = _mm_loadu_ps(&bounds.max_x[i]);
+  const __m128 max_y = _mm_loadu_ps(&bounds.max_y[i]);
+  const __m128 max_z = _mm_loadu_ps(&bounds.max_z[i]);
+
+  BoxBatch batch;
+  batch.cx = _mm_mul_ps(_mm_add_ps(min_x, max_x), half);
+  batch.cy = _mm_mul_ps(_mm_add_ps(min_y, max_y), half);
+  batch.cz = _mm_mul_ps(_mm_add_ps(min_z, max_z), half);
+  batch.ex = _mm_mul_ps(_mm_sub_ps(max_x, min_x), half);
+  batch.ey = _mm_mul_ps(_mm_sub_ps(max_y, min_y), half);
+  batch.ez = _mm_mul_ps(_mm_sub_ps(max_z, min_z), half);
+  return batch;
+}
+
+// Lane mask (bits 0-3) of boxes entirely on the negative side of the plane
+// given per lane by (nx, ny, nz, d) and its absolute normal (ax, ay, az).
+int OutsideMask(const BoxBatch &box, __m128 nx, __m128 ny, __m128 nz,
+                __m128 d, __m128 ax, __m128 ay, __m128 az) {
+  __m128 dist = _mm_add_ps(_mm_mul_ps(nx, box.cx), d);
+  dist = _mm_add_ps(dist, _mm_mul_ps(ny, box.cy));
+  dist = _mm_add_ps(dist, _mm_mul_ps(nz, box.cz));
+  __m128 radius = _mm_mul_ps(ax, box.ex);
+  radius = _mm_add_ps(radius, _mm_mul_ps(ay, box.ey));
+  radius = _mm_add_ps(radius, _mm_mul_ps(az, box.ez));
+  const __m128 farthest = _mm_add_ps(dist, radius);
+  return _mm_movemask_ps(_mm_cmplt_ps(farthest, _mm_setzero_ps()));
+}
+
+} // namespace
+
+void FrustumCuller::SetPlanes(const DirectX::XMFLOAT4 (&planes)[6]) {
+  for (int p = 0; p < kPlaneCount; ++p) {
+    planes_[p][0] = planes[p].x;
+    planes_[p][1] = planes[p].y;
+    planes_[p][2] = planes[p].z;
+    planes_[p][3] = planes[p].w;
+    abs_normals_[p][0] = std::fabs(planes[p].x);
+    abs_normals_[p][1] = std::fabs(planes[p].y);
+    abs_normals_[p][2] = std::fabs(planes[p].z);
+  }
+}
+
+void FrustumCuller::Cull(const WorldBoundsColumns &bounds,
+                         std::vector<std::uint32_t> &visible) {
+  const std::size_t count = bounds.min_x.size();
+  stats_ = CullStats{};
+  stats_.tested = count;
+  if (last_plane_.size() != count) {
+    last_plane_.resize(count, 0);
+  }
+
+  // Written through a raw cursor; trimmed at the end.
+  visible.resize(count);
+  std::uint32_t *out = visible.data();
+  std::uint8_t *cache = last_plane_.data();
+
+  const std::size_t batched = count & ~std::size_t{3};
+  for (std::size_t i = 0; i < batched; i += 4) {
+    const BoxBatch box = LoadBatch(bounds, i);
+
+    // Unbounded entries skip the test.
+    const int unbounded = (bounds.has_bounds[i] == 0) |
+                          (bounds.has_bounds[i + 1] == 0) << 1 |
+                          (bounds.has_bounds[i + 2] == 0) << 2 |
+                          (bounds.has_bounds[i + 3] == 0) << 3;
+
+    // Cached plane per lane first: gather the four rows and transpose them
+    // into per-component lanes.
+    __m128 nx = _mm_loadu_ps(planes_[cache[i]]);
+    __m128 ny = _mm_loadu_ps(planes_[cache[i + 1]]);
+    __m128 nz = _mm_loadu_ps(planes_[cache[i + 2]]);
+    __m128 d = _mm_loadu_ps(planes_[cache[i + 3]]);
+    _MM_TRANSPOSE4_PS(nx, ny, nz, d);
+    __m128 ax = _mm_loadu_ps(abs_normals_[cache[i]]);
+    __m128 ay = _mm_loadu_ps(abs_normals_[cache[i + 1]]);
+    __m128 az = _mm_loadu_ps(abs_normals_[cache[i + 2]]);
+    __m128 unused = _mm_loadu_ps(abs_normals_[cache[i + 3]]);
+    _MM_TRANSPOSE4_PS(ax, ay, az, unused);
+    const int cached_out =
+        OutsideMask(box, nx, ny, nz, d, ax, ay, az) & ~unbounded;
+    stats_.coherent_rejects += (cached_out & 1) + ((cached_out >> 1) & 1) +
+                               ((cached_out >> 2) & 1) + (cached_out >> 3);
+
+    int remaining = 0xf & ~cached_out & ~unbounded;
+    // The remaining lanes are tested against every plane; breaking out early
+    // mispredicts more than it saves.
+    if (remaining != 0) {
+      for (int p = 0; p < kPlaneCount; ++p) {
+        const int outside = OutsideMask(
+            box, _mm_set1_ps(planes_[p][0]), _mm_set1_ps(planes_[p][1]),
+            _mm_set1_ps(planes_[p][2]), _mm_set1_ps(planes_[p][3]),
+            _mm_set1_ps(abs_normals_[p][0]), _mm_set1_ps(abs_normals_[p][1]),
+            _mm_set1_ps(abs_normals_[p][2]));
+        const int rejected = outside & remaining;
+        for (int k = 0; k < 4; ++k) {
+          cache[i + k] = ((rejected >> k) & 1)
+                             ? static_cast<std::uint8_t>(p)
+                             : cache[i + k];
+        }
+        remaining &= ~outside;
+      }
+    }
+
+    // Branchless compaction: always write, advance only for visible lanes.
+    const int lanes = remaining | unbounded;
+    for (int k = 0; k < 4; ++k) {
+      *out = static_cast<std::uint32_t>(i + k);
+      out += (lanes >> k) & 1;
+    }
+  }
+
+  // Tail, same test one box at a time.
+  for (std::size_t i = batched; i < count; ++i) {
+    if (bounds.has_bounds[i] == 0) {
+      *out++ = static_cast<std::uint32_t>(i);
+      continue;
+    }
+    const float c[3] = {(bounds.min_x[i] + bounds.max_x[i]) * 0.5f,
+                        (bounds.min_y[i] + bounds.max_y[i]) * 0.5f,
+                        (bounds.min_z[i] + bounds.max_z[i]) * 0.5f};
+    const float e[3] = {(bounds.max_x[i] - bounds.min_x[i]) * 0.5f,
+                        (bounds.max_y[i] - bounds.min_y[i]) * 0.5f,
+                        (bounds.max_z[i] - bounds.min_z[i]) * 0.5f};
+    auto outside = [&](int p) {
+      const float *n = planes_[p];
+      const float *a = abs_normals_[p];
+      return n[0] * c[0] + n[1] * c[1] + n[2] * c[2] + n[3] + a[0] * e[0] +
+                 a[1] * e[1] + a[2] * e[2] <
+             0.0f;
+    };
+
+    if (outside(cache[i])) {
+      ++stats_.coherent_rejects;
+      continue;
+    }
+    bool inside = true;
+    for (int p = 0; p < kPlaneCount; ++p) {
+      if (outside(p)) {
+        cache[i] = static_cast<std::uint8_t>(p);
+        inside = false;
+        break;
+      }
+    }
+    if (inside) {
+      *out++ = static_cast<std::uint32_t>(i);
+    }
+  }
+
+  visible.resize(static_cast<std::size_t>(out - visible.data()));
+  stats_.visible = visible.size();
+}
@@ -0,0 +1,129 @@
+#include "FrustumCullerBenchmarks.h"
+
+#include "BoundingVolume.h"
+#include "Frustum.h"
+#include "FrustumCuller.h"
+
+#include <DirectXMath.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr float kScreenDepth = 1000.0f;
+constexpr int kFrames = 5;
+
+template <typename Func> double MeasureMilliseconds(Func &&func) {
+  const auto start = Clock::now();
+  func();
+  const auto end = Clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Boxes scattered around the camera so roughly a fifth are visible.
+void BuildBoxes(std::size_t count, std::vector<BoundingVolume> &volumes,
+                WorldBoundsColumns &columns) {
+  std::mt19937 rng(1234u);
+  std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+  std::uniform_real_distribution<float> size(0.5f, 6.0f);
+
+  volumes.resize(count);
+  for (auto &volume : volumes) {
+    const XMFLOAT3 min(position(rng), position(rng) * 0.1f, position(rng));
+    const XMFLOAT3 corners[2] = {
+        min, XMFLOAT3(min.x + size(rng), min.y + size(rng), min.z + size(rng))};
+    volume.CalculateFromVertices(corners, 2);
+  }
+
+  columns = WorldBoundsColumns{};
+  for (const auto &volume : volumes) {
+    columns.min_x.push_back(volume.aabb_min.x);
+    columns.min_y.push_back(volume.aabb_min.y);
+    columns.min_z.push_back(volume.aabb_min.z);
+    columns.max_x.push_back(volume.aabb_max.x);
+    columns.max_y.push_back(volume.aabb_max.y);
+    columns.max_z.push_back(volume.aabb_max.z);
+    columns.center_x.push_back(volume.sphere_center.x);
+    columns.center_y.push_back(volume.sphere_center.y);
+    columns.center_z.push_back(volume.sphere_center.z);
+    columns.radius.push_back(volume.sphere_radius);
+    columns.has_bounds.push_back(1);
+  }
+}
+
+bool RunCullBenchmark(std::size_t box_count) {
+  std::vector<BoundingVolume> volumes;
+  WorldBoundsColumns columns;
+  BuildBoxes(box_count, volumes, columns);
+
+  const XMMATRIX projection =
+      XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, kScreenDepth);
+  const XMMATRIX view =
+      XMMatrixLookAtLH(XMVectorSet(0.0f, 10.0f, -20.0f, 1.0f),
+                       XMVectorSet(0.0f, 0.0f, 100.0f, 1.0f),
+                       XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+  FrustumClass frustum;
+  frustum.ConstructFrustum(kScreenDepth, projection, view);
+
+  // Per-object FrustumClass path.
+  std::size_t scalar_visible = 0;
+  const double scalar_ms = MeasureMilliseconds([&] {
+    for (int frame = 0; frame < kFrames; ++frame) {
+      scalar_visible = 0;
+      for (const auto &volume : volumes) {
+        scalar_visible += frustum.CheckBoundingVolume(volume) ? 1 : 0;
+      }
+    }
+  }) / kFrames;
+
+  XMFLOAT4 planes[6];
+  frustum.GetPlanes(planes);
+  FrustumCuller culler;
+  culler.SetPlanes(planes);
+  std::vector<std::uint32_t> visible;
+  visible.reserve(box_count);
+
+  // First frame: empty coherency cache.
+  const double cold_ms =
+      MeasureMilliseconds([&] { culler.Cull(columns, visible); });
+
+  const double warm_ms = MeasureMilliseconds([&] {
+    for (int frame = 0; frame < kFrames; ++frame) {
+      culler.Cull(columns, visible);
+    }
+  }) / kFrames;
+  const auto &stats = culler.GetLastStats();
+
+  std::cout << std::setw(8) << box_count << " boxes | FrustumClass "
+            << std::fixed << std::setprecision(3) << std::setw(9) << scalar_ms
+            << " ms | batched cold " << std::setw(8) << cold_ms
+            << " ms | warm " << std::setw(8) << warm_ms << " ms | speedup "
+            << std::setprecision(2)
+            << (warm_ms > 0.0 ? scalar_ms / warm_ms : 0.0) << "x | visible "
+            << stats.visible << " | cached-plane rejects "
+            << stats.coherent_rejects << std::endl;
+
+  return stats.visible == scalar_visible;
+}
+
+} // namespace
+
+bool RunFrustumCullerBenchmarks() {
+  std::cout << "=== Frustum culling benchmark ===" << std::endl;
+  bool consistent = true;
+  for (std::size_t box_count : {10000u, 100000u, 1000000u}) {
+    consistent = RunCullBenchmark(box_count) && consistent;
+  }
+  if (!consistent) {
+    std::cout << "Visible counts differ between culling paths" << std::endl;
+  }
+  return consistent;
+}
@@ -0,0 +1,257 @@
+#include "FrustumCullerTests.h"
+
+#include "FrustumCuller.h"
+#include "Logger.h"
+
+#include <DirectXMath.h>
+
+#include <cmath>
+#include <exception>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+// 90 degree frustum looking down +z, near 1, far 100.
+void MakeTestPlanes(XMFLOAT4 (&planes)[6]) {
+  const float s = 1.0f / std::sqrt(2.0f);
+  planes[0] = XMFLOAT4(0.0f, 0.0f, 1.0f, -1.0f);  // near
+  planes[1] = XMFLOAT4(0.0f, 0.0f, -1.0f, 100.0f); // far
+  planes[2] = XMFLOAT4(s, 0.0f, s, 0.0f);          // left
+  planes[3] = XMFLOAT4(-s, 0.0f, s, 0.0f);         // right
+  planes[4] = XMFLOAT4(0.0f, -s, s, 0.0f);         // top
+  planes[5] = XMFLOAT4(0.0f, s, s, 0.0f);          // bottom
+}
+
+void AddBox(WorldBoundsColumns &bounds, const XMFLOAT3 &min,
+            const XMFLOAT3 &max, bool has_bounds = true) {
+  bounds.min_x.push_back(min.x);
+  bounds.min_y.push_back(min.y);
+  bounds.min_z.push_back(min.z);
+  bounds.max_x.push_back(max.x);
+  bounds.max_y.push_back(max.y);
+  bounds.max_z.push_back(max.z);
+  bounds.center_x.push_back((min.x + max.x) * 0.5f);
+  bounds.center_y.push_back((min.y + max.y) * 0.5f);
+  bounds.center_z.push_back((min.z + max.z) * 0.5f);
+  bounds.radius.push_back(0.0f);
+  bounds.has_bounds.push_back(has_bounds ? 1 : 0);
+}
+
+void AddRandomBoxes(WorldBoundsColumns &bounds, std::size_t count,
+                    unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> position(-120.0f, 120.0f);
+  std::uniform_real_distribution<float> size(0.1f, 8.0f);
+  for (std::size_t i = 0; i < count; ++i) {
+    const XMFLOAT3 min(position(rng), position(rng), position(rng));
+    AddBox(bounds, min,
+           XMFLOAT3(min.x + size(rng), min.y + size(rng), min.z + size(rng)));
+  }
+}
+
+// Same rule as FrustumClass::CheckAABB: culled when all eight corners are
+// outside one plane.
+std::vector<std::uint32_t> ReferenceCull(const WorldBoundsColumns &bounds,
+                                         const XMFLOAT4 (&planes)[6]) {
+  std::vector<std::uint32_t> visible;
+  for (std::size_t i = 0; i < bounds.min_x.size(); ++i) {
+    if (bounds.has_bounds[i] == 0) {
+      visible.push_back(static_cast<std::uint32_t>(i));
+      continue;
+    }
+    bool inside = true;
+    for (int p = 0; p < 6 && inside; ++p) {
+      bool any_corner_inside = false;
+      for (int corner = 0; corner < 8; ++corner) {
+        const float x = (corner & 1) ? bounds.max_x[i] : bounds.min_x[i];
+        const float y = (corner & 2) ? bounds.max_y[i] : bounds.min_y[i];
+        const float z = (corner & 4) ? bounds.max_z[i] : bounds.min_z[i];
+        if (planes[p].x * x + planes[p].y * y + planes[p].z * z +
+                planes[p].w >=
+            0.0f) {
+          any_corner_inside = true;
+          break;
+        }
+      }
+      inside = any_corner_inside;
+    }
+    if (inside) {
+      visible.push_back(static_cast<std::uint32_t>(i));
+    }
+  }
+  return visible;
+}
+
+bool TestMatchesCornerTest(std::string &message) {
+  XMFLOAT4 planes[6];
+  MakeTestPlanes(planes);
+  WorldBoundsColumns bounds;
+  AddRandomBoxes(bounds, 4099, 7u);
+
+  FrustumCuller culler;
+  culler.SetPlanes(planes);
+  std::vector<std::uint32_t> visible;
+  culler.Cull(bounds, visible);
+
+  const auto expected = ReferenceCull(bounds, planes);
+  if (visible != expected) {
+    std::ostringstream oss;
+    oss << "visible " << visible.size() << ", expected " << expected.size();
+    message = oss.str();
+    return false;
+  }
+  return !expected.empty() && expected.size() < bounds.min_x.size();
+}
+
+bool TestTailAndEmptyInputs(std::string &message) {
+  XMFLOAT4 planes[6];
+  MakeTestPlanes(planes);
+  FrustumCuller culler;
+  culler.SetPlanes(planes);
+  std::vector<std::uint32_t> visible{42};
+
+  WorldBoundsColumns bounds;
+  culler.Cull(bounds, visible);
+  if (!visible.empty()) {
+    message = "empty input produced output";
+    return false;
+  }
+
+  // Counts around the batch width exercise the scalar tail.
+  for (std::size_t count = 1; count <= 9; ++count) {
+    WorldBoundsColumns small;
+    AddRandomBoxes(small, count, static_cast<unsigned>(count));
+    AddBox(small, XMFLOAT3(-1.0f, -1.0f, 10.0f), XMFLOAT3(1.0f, 1.0f, 12.0f));
+    culler.Cull(small, visible);
+    if (visible != ReferenceCull(small, planes)) {
+      message = "mismatch for count " + std::to_string(count + 1);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestUnboundedAlwaysVisible(std::string &message) {
+  XMFLOAT4 planes[6];
+  MakeTestPlanes(planes);
+  WorldBoundsColumns bounds;
+  // Behind the camera, but without bounds.
+  for (int i = 0; i < 5; ++i) {
+    AddBox(bounds, XMFLOAT3(0.0f, 0.0f, -50.0f), XMFLOAT3(0.0f, 0.0f, -50.0f),
+           i != 2);
+  }
+
+  FrustumCuller culler;
+  culler.SetPlanes(planes);
+  std::vector<std::uint32_t> visible;
+  culler.Cull(bounds, visible);
+  if (visible != std::vector<std::uint32_t>{2}) {
+    message = "only the unbounded entry should be visible";
+    return false;
+  }
+  return true;
+}
+
+bool TestPlaneCoherency(std::string &message) {
+  XMFLOAT4 planes[6];
+  MakeTestPlanes(planes);
+  WorldBoundsColumns bounds;
+  // All beyond the far plane (index 1), never the first plane tested.
+  for (int i = 0; i < 10; ++i) {
+    const float x = static_cast<float>(i);
+    AddBox(bounds, XMFLOAT3(x, 0.0f, 150.0f), XMFLOAT3(x + 1.0f, 1.0f, 151.0f));
+  }
+
+  FrustumCuller culler;
+  culler.SetPlanes(planes);
+  std::vector<std::uint32_t> visible;
+  culler.Cull(bounds, visible);
+  if (!visible.empty() || culler.GetLastStats().coherent_rejects != 0) {
+    message = "first frame should find the rejecting plane the slow way";
+    return false;
+  }
+
+  culler.Cull(bounds, visible);
+  if (!visible.empty() || culler.GetLastStats().coherent_rejects != 10) {
+    message = "second frame should reject every box with the cached plane";
+    return false;
+  }
+
+  // A box that moved into view is still reported despite its cached plane.
+  bounds.min_z[3] = 10.0f;
+  bounds.max_z[3] = 11.0f;
+  culler.Cull(bounds, visible);
+  if (visible != std::vector<std::uint32_t>{3}) {
+    message = "stale cache hid a visible box";
+    return false;
+  }
+  return culler.GetLastStats().visible == 1 &&
+         culler.GetLastStats().tested == 10;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(4);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("Batched cull matches the corner test", TestMatchesCornerTest);
+  run("Tail and empty inputs", TestTailAndEmptyInputs);
+  run("Unbounded entries are always visible", TestUnboundedAlwaysVisible);
+  run("Plane coherency cache", TestPlaneCoherency);
+
+  return results;
+}
+
+} // namespace
+
+bool RunFrustumCullerTests() {
+  const auto results = RunAllTestsInternal();
+  bool all_passed = true;
+
+  for (const auto &result : results) {
+    if (!result.passed) {
+      all_passed = false;
+      std::ostringstream oss;
+      oss << "Test failed: " << result.name;
+      if (!result.message.empty()) {
+        oss << " - " << result.message;
+      }
+      Logger::SetModule("FrustumCullerTests");
+      Logger::LogError(oss.str());
+    }
+  }
+
+  if (all_passed) {
+    Logger::SetModule("FrustumCullerTests");
+    Logger::LogInfo("All FrustumCuller tests passed");
+  }
+
+  return all_passed;
+}
@@ -17,11 +17,13 @@
 #include "Frustum.h"
 #include "HorizontalBlurShader.h"
 #include "Interfaces.h"
+#include "LayeredParameterView.h"
 #include "Logger.h"
 #include "Model.h"
 #include "OrthoWindow.h"
 #include "PbrShader.h"
 #include "RefractionShader.h"
+#include "RenderTag.h"
 #include "RenderTexture.h"
 #include "RenderableObject.h"
 #include "ResourceManager.h"
@@ -71,6 +73,11 @@ static constexpr const char *REFLECTION_TAG = "reflection";
 static constexpr const char *DIFFUSE_LIGHTING_TAG = "diffuse_lighting";
 
 namespace {
+TagMask SkipCullingMask() {
+  static const TagMask mask = TagRegistry::GetInstance().GetBit("skip_culling");
+  return mask;
+}
+
 void LogGraphicsError(const std::wstring &message) {
   Logger::SetModule("Graphics");
   Logger::LogError(message);
@@ -155,6 +162,9 @@ bool Graphics::InitializeCamera() {
     return false;
   }
 
+  // Depth writers are also culled against the light's frustum
+  caster_mask_ = TagRegistry::GetInstance().GetBit(WRITE_DEPTH_TAG);
+
   return true;
 }
 
@@ -221,44 +231,13 @@ bool Graphics::InitializeRenderTargets() {
     return config.height == -1 ? screenHeight : config.height;
   };
 
-  // Create shadow-related render targets from configuration
+  // Create the light depth target from configuration
   auto &shadow_depth_config = scene_config_.render_targets["shadow_depth"];
   render_targets_.shadow_depth = resource_manager.CreateRenderTexture(
       shadow_depth_config.name, getWidth(shadow_depth_config),
       getHeight(shadow_depth_config), shadow_depth_config.depth,
       shadow_depth_config.near_plane);
 
-  auto &shadow_map_config = scene_config_.render_targets["shadow_map"];
-  render_targets_.shadow_map = resource_manager.CreateRenderTexture(
-      shadow_map_config.name, getWidth(shadow_map_config),
-      getHeight(shadow_map_config), shadow_map_config.depth,
-      shadow_map_config.near_plane);
-
-  auto &downsampled_config = scene_config_.render_targets["downsampled_shadow"];
-  render_targets_.downsampled_shadow = resource_manager.CreateRenderTexture(
-      downsampled_config.name, getWidth(downsampled_config),
-      getHeight(downsampled_config), downsampled_config.depth,
-      downsampled_config.near_plane);
-
-  auto &horizontal_blur_config =
-      scene_config_.render_targets["horizontal_blur"];
-  render_targets_.horizontal_blur = resource_manager.CreateRenderTexture(
-      horizontal_blur_config.name, getWidth(horizontal_blur_config),
-      getHeight(horizontal_blur_config), horizontal_blur_config.depth,
-      horizontal_blur_config.near_plane);
-
-  auto &vertical_blur_config = scene_config_.render_targets["vertical_blur"];
-  render_targets_.vertical_blur = resource_manager.CreateRenderTexture(
-      vertical_blur_config.name, getWidth(vertical_blur_config),
-      getHeight(vertical_blur_config), vertical_blur_config.depth,
-      vertical_blur_config.near_plane);
-
-  auto &upsampled_config = scene_config_.render_targets["upsampled_shadow"];
-  render_targets_.upsampled_shadow = resource_manager.CreateRenderTexture(
-      upsampled_config.name, getWidth(upsampled_config),
-      getHeight(upsampled_config), upsampled_config.depth,
-      upsampled_config.near_plane);
-
   // Create reflection/refraction render targets from configuration
   auto &reflection_map_config = scene_config_.render_targets["reflection_map"];
   render_targets_.reflection_map = resource_manager.CreateRenderTexture(
@@ -267,10 +246,7 @@ bool Graphics::InitializeRenderTargets() {
       reflection_map_config.near_plane);
 
   // Validate all render targets were created successfully
-  if (!render_targets_.shadow_depth || !render_targets_.shadow_map ||
-      !render_targets_.downsampled_shadow || !render_targets_.horizontal_blur ||
-      !render_targets_.vertical_blur || !render_targets_.upsampled_shadow ||
-      !render_targets_.reflection_map) {
+  if (!render_targets_.shadow_depth || !render_targets_.reflection_map) {
     LogGraphicsError(L"Could not create render textures.");
     return false;
   }
@@ -488,71 +464,10 @@ void Graphics::Frame(float deltaTime) {
   }
   light_->SetPosition(light_position_x_, LIGHT_Y_POSITION, LIGHT_Z_POSITION);
 
-  // Update animations based on animation config from JSON
-  const auto &scene_objects = scene_.GetRenderables();
-
-  for (const auto &renderable : scene_objects) {
-    const auto &anim_config = scene_.GetAnimationConfig(renderable);
-    if (!anim_config.enabled) {
-      continue;
-    }
-
-    // Get initial transform from Scene (stored when object was created)
-    const XMMATRIX &initial_transform = scene_.GetInitialTransform(renderable);
-
-    // Calculate rotation based on animation config
-    // Speed is in degrees per second, convert to radians
-    float &rotation_angle = scene_.GetRotationState(renderable);
-    rotation_angle +=
-        DirectX::XMConvertToRadians(anim_config.speed) * deltaTime;
-
-    // Wrap rotation to [0, 2π)
-    const float TWO_PI = 2.0f * DirectX::XM_PI;
-    if (rotation_angle >= TWO_PI) {
-      rotation_angle -= TWO_PI;
-    }
-
-    // Apply initial rotation offset
-    float total_rotation =
-        rotation_angle + DirectX::XMConvertToRadians(anim_config.initial);
-
-    // Create rotation matrix based on axis
-    XMMATRIX rotation_matrix;
-    switch (anim_config.axis) {
-    case AnimationConfig::RotationAxis::X:
-      rotation_matrix = XMMatrixRotationX(total_rotation);
-      break;
-    case AnimationConfig::RotationAxis::Z:
-      rotation_matrix = XMMatrixRotationZ(total_rotation);
-      break;
-    case AnimationConfig::RotationAxis::Y:
-    default:
-      rotation_matrix = XMMatrixRotationY(total_rotation);
-      break;
-    }
-
-    // Decompose initial transform to get translation, rotation, and scale
-    XMVECTOR scale_vec, rotation_quat, translation_vec;
-    if (XMMatrixDecompose(&scale_vec, &rotation_quat, &translation_vec,
-                          initial_transform)) {
-      // Rebuild matrix with new rotation: Scale * Rotation * Translation
-      XMMATRIX scale_matrix = XMMatrixScalingFromVector(scale_vec);
-      XMMATRIX translation_matrix =
-          XMMatrixTranslationFromVector(translation_vec);
-
-      // Apply rotation: Scale * NewRotation * Translation
-      XMMATRIX new_world_matrix =
-          scale_matrix * rotation_matrix * translation_matrix;
-      renderable->SetWorldMatrix(new_world_matrix);
-    } else {
-      // Fallback: if decomposition fails, just apply rotation to initial
-      // transform
-      renderable->SetWorldMatrix(rotation_matrix * initial_transform);
-    }
-  }
-
-  // Clean up rotation states for objects that no longer exist
-  scene_.CleanupAnimationStates(scene_objects);
+  // Update animations based on animation config from JSON; the scene
+  // storage advances the rotating objects and refreshes world bounds of
+  // whatever moved, leaving static objects untouched
+  scene_.Update(deltaTime);
 
 #ifdef _DEBUG
   // Periodically log resource usage for debugging
@@ -570,6 +485,10 @@ void Graphics::Frame(float deltaTime) {
          << resource_manager.GetModelRefCount("ground") << endl;
     cout << "  Total cached: " << resource_manager.GetTotalCachedResources()
          << endl;
+    cout << "  Transforms changed this frame: "
+         << scene_.GetChangedObjectCount() << " of "
+         << scene_.GetStorage().GetCount() << endl;
+    render_graph_.PrintPassTimings();
   }
 #endif
 }
@@ -623,32 +542,43 @@ bool Graphics::SetupRenderGraph() {
   registry.Register<IShader>("diffuse_lighting",
                              shader_assets_.diffuse_lighting);
 
-  // Register render textures
-  registry.Register("shadow_map", render_targets_.shadow_map);
-  registry.Register("downsampled_shadow", render_targets_.downsampled_shadow);
-  registry.Register("horizontal_blur", render_targets_.horizontal_blur);
-  registry.Register("vertical_blur", render_targets_.vertical_blur);
-
   // Register ortho windows
   registry.Register("small_window", ortho_windows_.small_window);
   registry.Register("fullscreen_window", ortho_windows_.fullscreen_window);
 
-  // Load scene from JSON configuration
-  if (!scene_.Initialize("./data/scene.json", cube_group_.get(),
-                         pbr_group_.get())) {
-    LogGraphicsError("Failed to initialize Scene!");
-    return false;
-  }
-
   // Setup render passes
   SetupRenderPasses();
 
-  // Compile render graph to validate dependencies and build execution order
+  // Compile render graph to build execution order and allocate transient
+  // textures
   if (!render_graph_.Compile()) {
     LogGraphicsError("Failed to compile RenderGraph!");
     return false;
   }
 
+  // Record independent passes on worker threads; the graph falls back to
+  // serial execution if deferred contexts are unavailable.
+  if (!render_graph_.EnableParallelRecording(true)) {
+    Logger::SetModule("Graphics");
+    Logger::LogWarning("Parallel pass recording unavailable, running serially");
+  }
+
+  // Register render textures (post-process objects sample them); transient
+  // ones only exist after Compile()
+  registry.Register("shadow_map", render_graph_.GetTexture("ShadowMap"));
+  registry.Register("downsampled_shadow",
+                    render_graph_.GetTexture("DownsampledShadow"));
+  registry.Register("horizontal_blur",
+                    render_graph_.GetTexture("HorizontalBlur"));
+  registry.Register("vertical_blur", render_graph_.GetTexture("VerticalBlur"));
+
+  // Load scene from JSON configuration
+  if (!scene_.Initialize("./data/scene.json", cube_group_.get(),
+                         pbr_group_.get())) {
+    LogGraphicsError("Failed to initialize Scene!");
+    return false;
+  }
+
   cout << "=== RenderGraph Setup Complete ===\n" << endl;
 
   render_graph_.PrintGraph();
@@ -656,23 +586,43 @@ bool Graphics::SetupRenderGraph() {
 }
 
 void Graphics::SetupRenderPasses() {
-  // Import existing textures into RenderGraph for pass dependencies
+  // Import long-lived textures into RenderGraph for pass dependencies
   render_graph_.ImportTexture("DepthMap", render_targets_.shadow_depth);
-  render_graph_.ImportTexture("ShadowMap", render_targets_.shadow_map);
-  render_graph_.ImportTexture("DownsampledShadow",
-                              render_targets_.downsampled_shadow);
-  render_graph_.ImportTexture("HorizontalBlur",
-                              render_targets_.horizontal_blur);
-  render_graph_.ImportTexture("VerticalBlur", render_targets_.vertical_blur);
-  render_graph_.ImportTexture("UpsampledShadow",
-                              render_targets_.upsampled_shadow);
   render_graph_.ImportTexture("ReflectionMap", render_targets_.reflection_map);
 
+  // Intermediate targets are transient: the graph allocates them and lets
+  // targets of equal size with disjoint lifetimes share memory. Because a
+  // shared texture's own ortho matrix may belong to another declaration, the
+  // matrix for each pass is built from its configuration here.
+  auto declareTransient = [this](const std::string &resource_name,
+                                 const std::string &config_name) {
+    const auto &config = scene_config_.render_targets[config_name];
+    const int width =
+        config.width == -1 ? static_cast<int>(screenWidth) : config.width;
+    const int height =
+        config.height == -1 ? static_cast<int>(screenHeight) : config.height;
+    render_graph_.DeclareTexture(resource_name, width, height, config.depth,
+                                 config.near_plane);
+    return XMMatrixOrthographicLH(static_cast<float>(width),
+                                  static_cast<float>(height),
+                                  config.near_plane, config.depth);
+  };
+  declareTransient("ShadowMap", "shadow_map");
+  const XMMATRIX downsampledOrtho =
+      declareTransient("DownsampledShadow", "downsampled_shadow");
+  const XMMATRIX horizontalBlurOrtho =
+      declareTransient("HorizontalBlur", "horizontal_blur");
+  const XMMATRIX verticalBlurOrtho =
+      declareTransient("VerticalBlur", "vertical_blur");
+  const XMMATRIX upsampledOrtho =
+      declareTransient("UpsampledShadow", "upsampled_shadow");
+
   // Pass 1: Depth Pass - Render depth map from light's perspective
   render_graph_.AddPass("DepthPass")
       .SetShader(shader_assets_.depth)
       .Write("DepthMap")
-      .AddRenderTag(WRITE_DEPTH_TAG);
+      .AddRenderTag(WRITE_DEPTH_TAG)
+      .SetRenderables(&shadow_casters_);
 
   // Pass 2: Shadow Pass - Generate shadow map using depth map
   render_graph_.AddPass("ShadowPass")
@@ -682,53 +632,46 @@ void Graphics::SetupRenderPasses() {
       .AddRenderTag(WRITE_SHADOW_TAG);
 
   // Pass 3: Downsample - Reduce shadow map resolution for blur processing
-  XMMATRIX orthoMatrix;
-  render_targets_.downsampled_shadow->GetOrthoMatrix(orthoMatrix);
-
   render_graph_.AddPass("DownsamplePass")
       .SetShader(shader_assets_.texture)
       .ReadAsParameter("ShadowMap")
       .Write("DownsampledShadow")
       .AddRenderTag(DOWN_SAMPLE_TAG)
       .DisableZBuffer(true)
-      .SetParameter("orthoMatrix", orthoMatrix);
+      .SetParameter("orthoMatrix", downsampledOrtho);
 
   // Pass 4: Horizontal Blur - Apply horizontal Gaussian blur
-  render_targets_.horizontal_blur->GetOrthoMatrix(orthoMatrix);
-
   render_graph_.AddPass("HorizontalBlurPass")
       .SetShader(shader_assets_.horizontal_blur)
       .ReadAsParameter("DownsampledShadow")
       .Write("HorizontalBlur")
       .AddRenderTag(HORIZONTAL_BLUR_TAG)
       .DisableZBuffer(true)
-      .SetParameter("orthoMatrix", orthoMatrix)
+      .SetParameter("orthoMatrix", horizontalBlurOrtho)
       .SetParameter("screenWidth", static_cast<float>(DOWN_SAMPLE_WIDTH));
 
   // Pass 5: Vertical Blur - Apply vertical Gaussian blur (completes 2D blur)
-  render_targets_.vertical_blur->GetOrthoMatrix(orthoMatrix);
-
   render_graph_.AddPass("VerticalBlurPass")
       .SetShader(shader_assets_.vertical_blur)
       .ReadAsParameter("HorizontalBlur")
       .Write("VerticalBlur")
       .AddRenderTag(VERTICAL_BLUR_TAG)
       .DisableZBuffer(true)
-      .SetParameter("orthoMatrix", orthoMatrix)
+      .SetParameter("orthoMatrix", verticalBlurOrtho)
       .SetParameter("screenHeight", static_cast<float>(DOWN_SAMPLE_HEIGHT));
 
   // Pass 6: Upsample - Scale blurred shadow map back to original resolution
-  render_targets_.upsampled_shadow->GetOrthoMatrix(orthoMatrix);
-
   render_graph_.AddPass("UpsamplePass")
       .SetShader(shader_assets_.texture)
       .ReadAsParameter("VerticalBlur")
       .Write("UpsampledShadow")
       .AddRenderTag(UP_SAMPLE_TAG)
       .DisableZBuffer(true)
-      .SetParameter("orthoMatrix", orthoMatrix);
+      .SetParameter("orthoMatrix", upsampledOrtho);
 
   // Pass 7: Reflection Scene Pass - Render scene from reflection camera view
+  const TagMask reflection_mask =
+      TagRegistry::GetInstance().GetBit(REFLECTION_TAG);
   render_graph_.AddPass("ReflectionScenePass")
       .SetShader(shader_assets_.soft_shadow)
       .ReadAsParameter("UpsampledShadow", "shadowTexture")
@@ -739,7 +682,7 @@ void Graphics::SetupRenderPasses() {
       // Lock these parameters so object callbacks cannot re-enable them.
       .LockFloatParameter("reflectionBlend", 0.0f)
       .LockFloatParameter("shadowStrength", 0.0f)
-      .Execute([this](RenderPassContext &ctx) {
+      .Execute([this, reflection_mask](RenderPassContext &ctx) {
         if (!ctx.shader)
           return;
 
@@ -763,23 +706,15 @@ void Graphics::SetupRenderPasses() {
         }
 
         // Render only objects tagged for reflection
+        const LayeredParameterView base_view(base_params);
+        PerDrawParameters per_draw;
         for (const auto &renderable : *ctx.renderables) {
-          if (!renderable->HasTag(REFLECTION_TAG))
+          if (!renderable->HasAnyTag(reflection_mask))
             continue;
 
-          ShaderParameterContainer::BuildParametersInput inputs;
-          inputs.base_params = &base_params;
-
-          const auto &object_params = renderable->GetObjectParameters();
-          inputs.object_params = &object_params;
-
-          DirectX::XMMATRIX world_matrix = renderable->GetWorldMatrix();
-          inputs.world_matrix = &world_matrix;
-
-          inputs.callback = renderable->GetParameterCallback();
-
-          ShaderParameterContainer objParams =
-              ShaderParameterContainer::BuildFinalParameters(inputs);
+          const LayeredParameterView &objParams = per_draw.Prepare(
+              base_view, renderable->GetObjectParameters(),
+              renderable->GetWorldMatrix(), renderable->GetParameterCallback());
 
           renderable->Render(*ctx.shader, objParams, ctx.device_context);
         }
@@ -814,8 +749,10 @@ void Graphics::SetupRenderPasses() {
       .SetParameter("lightDirection", light_->GetDirection());
 
   // Pass 11: Text Overlay - Render debug text and UI elements
+  // Text updates its vertex buffers through the immediate context.
   render_graph_.AddPass("TextOverlayPass")
       .DisableZBuffer(true)
+      .RecordOnImmediateContext()
       .Execute([this](RenderPassContext &ctx) {
         if (!text_) {
           return;
@@ -1025,17 +962,33 @@ auto Graphics::RegisterShaderParameters() -> bool {
   return true;
 }
 
-// Helper function to check if a renderable object is visible in the frustum
-auto Graphics::IsObjectVisible(std::shared_ptr<IRenderable> renderable,
-                               const FrustumClass &frustum) const -> bool {
+// World AABB of an object the scene BVH does not index, for the batched
+// FrustumCuller. The AABB test alone is a little looser than
+// FrustumClass::CheckBoundingVolume, never tighter.
+auto Graphics::GetCullingBounds(const std::shared_ptr<IRenderable> &renderable,
+                                XMFLOAT3 &min_bounds,
+                                XMFLOAT3 &max_bounds) const -> bool {
   if (!renderable) {
-    return true; // If object is null, skip it
+    return false; // If object is null, skip it
   }
 
+  static const TagMask final_mask = TagRegistry::GetInstance().GetBit("final");
+
   // Check if object has "skip_culling" tag (for UI elements, post-processing,
   // etc.)
-  if (renderable->HasTag("skip_culling")) {
-    return true;
+  if (renderable->HasAnyTag(SkipCullingMask())) {
+    return false;
+  }
+
+  // Scene objects carry their world bounds in the scene storage
+  if (auto *storage = renderable->GetSceneStorage()) {
+    if (storage->HasBounds(renderable->GetEntityId())) {
+      const BoundingVolume worldBounds =
+          storage->GetWorldBounds(renderable->GetEntityId());
+      min_bounds = worldBounds.aabb_min;
+      max_bounds = worldBounds.aabb_max;
+      return true;
+    }
   }
 
   // Prefer Model's bounding volume data (if available)
@@ -1044,9 +997,9 @@ auto Graphics::IsObjectVisible(std::shared_ptr<IRenderable> renderable,
   if (model) {
     // Get world-space bounding volume
     BoundingVolume worldBounds = model->GetWorldBoundingVolume();
-
-    // Use optimized bounding volume test (AABB + bounding sphere)
-    return frustum.CheckBoundingVolume(worldBounds);
+    min_bounds = worldBounds.aabb_min;
+    max_bounds = worldBounds.aabb_max;
+    return true;
   }
 
   // If wrapped by RenderableObject, use RenderableObject's bounding volume
@@ -1056,8 +1009,9 @@ auto Graphics::IsObjectVisible(std::shared_ptr<IRenderable> renderable,
 
     // Check if bounding volume is valid (non-empty)
     if (worldBounds.sphere_radius > 0.0f) {
-      // Use optimized bounding volume test
-      return frustum.CheckBoundingVolume(worldBounds);
+      min_bounds = worldBounds.aabb_min;
+      max_bounds = worldBounds.aabb_max;
+      return true;
     }
     // If bounding volume is invalid, continue with fallback method
   }
@@ -1071,7 +1025,7 @@ auto Graphics::IsObjectVisible(std::shared_ptr<IRenderable> renderable,
   float boundingRadius = 2.0f;
 
   // Use smaller radius for small objects
-  if (renderable->HasTag("final")) {
+  if (renderable->HasAnyTag(final_mask)) {
     XMVECTOR scale;
     XMVECTOR rotation;
     XMVECTOR translation;
@@ -1082,8 +1036,14 @@ auto Graphics::IsObjectVisible(std::shared_ptr<IRenderable> renderable,
     }
   }
 
-  return frustum.CheckSphere(position.x, position.y, position.z,
-                             boundingRadius);
+  // The cube around the sphere
+  min_bounds = XMFLOAT3(position.x - boundingRadius,
+                        position.y - boundingRadius,
+                        position.z - boundingRadius);
+  max_bounds = XMFLOAT3(position.x + boundingRadius,
+                        position.y + boundingRadius,
+                        position.z + boundingRadius);
+  return true;
 }
 
 void Graphics::Render() {
@@ -1137,14 +1097,90 @@ void Graphics::Render() {
   std::vector<std::shared_ptr<IRenderable>> culled_objects;
   const auto &scene_objects = scene_.GetRenderables();
   if (frustum_) {
-    for (const auto &renderable : scene_objects) {
-      if (IsObjectVisible(renderable, *frustum_)) {
-        culled_objects.push_back(renderable);
+    // Bounded scene objects come from the scene BVH: those in the camera
+    // frustum are drawn, and depth writers in the light frustum go to the
+    // depth pass so shadows of off-screen casters still reach the shadow
+    // map. The rest (skip_culling, ortho windows) are culled in one batch by
+    // the FrustumCuller. Scene order is kept for drawing.
+    scene_.UpdateSpatialIndex();
+    const auto &storage = scene_.GetStorage();
+    const auto &spatial_index = scene_.GetSpatialIndex();
+
+    XMFLOAT4 planes[6];
+    frustum_->GetPlanes(planes);
+    frustum_culler_.SetPlanes(planes);
+    visible_entities_.clear();
+    spatial_index.QueryFrustum(planes, visible_entities_);
+    FrustumClass::ExtractPlanes(lightViewMatrix * lightProjectionMatrix,
+                                planes);
+    caster_entities_.clear();
+    spatial_index.QueryShadowCasters(planes, caster_mask_, caster_entities_);
+
+    visible_flags_.assign(storage.GetCount(), 0);
+    for (const auto entity : visible_entities_) {
+      visible_flags_[storage.GetIndex(entity)] |= kCameraVisible;
+    }
+    for (const auto entity : caster_entities_) {
+      visible_flags_[storage.GetIndex(entity)] |= kShadowCaster;
+    }
+
+    // Only min/max and has_bounds are read by the culler.
+    object_visible_.assign(scene_objects.size(), 0);
+    unindexed_objects_.clear();
+    unindexed_bounds_.min_x.clear();
+    unindexed_bounds_.min_y.clear();
+    unindexed_bounds_.min_z.clear();
+    unindexed_bounds_.max_x.clear();
+    unindexed_bounds_.max_y.clear();
+    unindexed_bounds_.max_z.clear();
+    unindexed_bounds_.has_bounds.clear();
+    for (std::size_t i = 0; i < scene_objects.size(); ++i) {
+      const auto &renderable = scene_objects[i];
+      if (renderable && renderable->GetSceneStorage() == &storage &&
+          storage.HasBounds(renderable->GetEntityId()) &&
+          !renderable->HasAnyTag(SkipCullingMask())) {
+        object_visible_[i] =
+            visible_flags_[storage.GetIndex(renderable->GetEntityId())];
+        continue;
+      }
+
+      XMFLOAT3 min_bounds(0.0f, 0.0f, 0.0f), max_bounds(0.0f, 0.0f, 0.0f);
+      const bool bounded = GetCullingBounds(renderable, min_bounds, max_bounds);
+      unindexed_objects_.push_back(static_cast<std::uint32_t>(i));
+      unindexed_bounds_.min_x.push_back(min_bounds.x);
+      unindexed_bounds_.min_y.push_back(min_bounds.y);
+      unindexed_bounds_.min_z.push_back(min_bounds.z);
+      unindexed_bounds_.max_x.push_back(max_bounds.x);
+      unindexed_bounds_.max_y.push_back(max_bounds.y);
+      unindexed_bounds_.max_z.push_back(max_bounds.z);
+      unindexed_bounds_.has_bounds.push_back(bounded ? 1 : 0);
+    }
+
+    // Visible depth writers outside the BVH keep feeding the depth pass.
+    frustum_culler_.Cull(unindexed_bounds_, unindexed_visible_);
+    for (const auto index : unindexed_visible_) {
+      const auto object = unindexed_objects_[index];
+      const auto &renderable = scene_objects[object];
+      object_visible_[object] =
+          kCameraVisible | (renderable && renderable->HasAnyTag(caster_mask_)
+                                ? kShadowCaster
+                                : 0);
+    }
+
+    culled_objects.reserve(scene_objects.size());
+    shadow_casters_.clear();
+    for (std::size_t i = 0; i < scene_objects.size(); ++i) {
+      if (object_visible_[i] & kCameraVisible) {
+        culled_objects.push_back(scene_objects[i]);
+      }
+      if (object_visible_[i] & kShadowCaster) {
+        shadow_casters_.push_back(scene_objects[i]);
       }
     }
   } else {
     // If frustum not initialized, render all objects
     culled_objects = scene_objects;
+    shadow_casters_ = scene_objects;
   }
 
   // Update render count for debug display
@@ -1154,4 +1190,52 @@ void Graphics::Render() {
 
   // Execute render graph with culled objects
   render_graph_.Execute(culled_objects, globalParams);
+}
+
+std::shared_ptr<IRenderable> Graphics::PickObject(int mouse_x, int mouse_y) {
+  if (!camera_ || screenWidth == 0 || screenHeight == 0) {
+    return nullptr;
+  }
+
+  // Mouse position to the -1..+1 range, adjusted for the projection's
+  // aspect ratio and field of view.
+  XMMATRIX projectionMatrix, viewMatrix;
+  DirectX11Device::GetD3d11DeviceInstance()->GetProjectionMatrix(
+      projectionMatrix);
+  camera_->GetViewMatrix(viewMatrix);
+  XMFLOAT4X4 projection;
+  XMStoreFloat4x4(&projection, projectionMatrix);
+  const float point_x =
+      ((2.0f * mouse_x) / static_cast<float>(screenWidth) - 1.0f) /
+      projection._11;
+  const float point_y =
+      (1.0f - (2.0f * mouse_y) / static_cast<float>(screenHeight)) /
+      projection._22;
+
+  // View-space direction to world space; the ray starts at the camera.
+  const XMMATRIX inverseView = XMMatrixInverse(nullptr, viewMatrix);
+  XMFLOAT3 direction;
+  XMStoreFloat3(&direction,
+                XMVector3Normalize(XMVector3TransformNormal(
+                    XMVectorSet(point_x, point_y, 1.0f, 0.0f), inverseView)));
+
+  scene_.UpdateSpatialIndex();
+  float distance = 0.0f;
+  auto picked = scene_.Pick(camera_->GetPosition(), direction, SCREEN_DEPTH,
+                            &distance);
+
+  Logger::SetModule("Graphics");
+  if (picked) {
+    std::string tags;
+    for (const auto &tag :
+         TagRegistry::GetInstance().GetNames(picked->GetTagMask())) {
+      tags += tags.empty() ? tag : ", " + tag;
+    }
+    Logger::LogInfo("Picked entity " + std::to_string(picked->GetEntityId()) +
+                    " at distance " + std::to_string(distance) + " [" + tags +
+                    "]");
+  } else {
+    Logger::LogInfo("Picked nothing");
+  }
+  return picked;
 }
\ No newline at end of file
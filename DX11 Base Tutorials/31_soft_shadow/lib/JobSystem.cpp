@@ -0,0 +1,108 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+thread_local std::size_t t_worker_index = 0;
+} // namespace
+
+JobSystem::JobSystem(std::size_t worker_count) {
+  if (worker_count == 0) {
+    worker_count = DefaultWorkerCount();
+  }
+  workers_.reserve(worker_count);
+  for (std::size_t i = 0; i < worker_count; ++i) {
+    workers_.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  work_available_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void JobSystem::Submit(Job job, JobCounter &counter) {
+  counter.pending_.fetch_add(1, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back({std::move(job), &counter});
+  }
+  work_available_.notify_one();
+}
+
+void JobSystem::Wait(const JobCounter &counter) {
+  while (!counter.IsDone()) {
+    if (TryRunOne()) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_finished_.wait(lock,
+                       [&] { return counter.IsDone() || !queue_.empty(); });
+  }
+}
+
+JobSystem &JobSystem::GetShared() {
+  static JobSystem shared;
+  return shared;
+}
+
+std::size_t JobSystem::GetCurrentWorkerIndex() { return t_worker_index; }
+
+std::size_t JobSystem::DefaultWorkerCount() {
+  const unsigned int hardware_threads = std::thread::hardware_concurrency();
+  return hardware_threads > 1 ? hardware_threads - 1 : 1;
+}
+
+void JobSystem::WorkerLoop(std::size_t worker_index) {
+  t_worker_index = worker_index;
+  for (;;) {
+    QueuedJob queued;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_available_.wait(lock,
+                           [this] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return; // stopping_ and drained
+      }
+      queued = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    Run(queued);
+  }
+}
+
+bool JobSystem::TryRunOne() {
+  QueuedJob queued;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.empty()) {
+      return false;
+    }
+    queued = std::move(queue_.front());
+    queue_.pop_front();
+  }
+  Run(queued);
+  return true;
+}
+
+void JobSystem::Run(QueuedJob &queued) {
+  // Jobs report their own failures; an escaping exception would terminate a
+  // worker thread.
+  try {
+    queued.job();
+  } catch (...) {
+  }
+  queued.counter->pending_.fetch_sub(1, std::memory_order_acq_rel);
+  {
+    // Taking the lock orders the decrement before a waiter's predicate check.
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  job_finished_.notify_all();
+}
@@ -0,0 +1,350 @@
+#include "LayeredParameterViewTests.h"
+
+#include "LayeredParameterView.h"
+#include "Logger.h"
+#include "ShaderParameter.h"
+
+#include <DirectXMath.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// Counting allocator
+// ============================================================================
+
+// Global operator new/delete replacements that count allocations while a
+// measurement is armed. Replacing them affects the whole executable, so they
+// are only compiled into test builds that define
+// LAYERED_PARAMETER_VIEW_COUNT_ALLOCATIONS; without it the allocation test is
+// skipped.
+#ifdef LAYERED_PARAMETER_VIEW_COUNT_ALLOCATIONS
+namespace {
+std::atomic<bool> g_count_allocations{false};
+std::atomic<std::size_t> g_allocation_count{0};
+
+void *CountedAllocate(std::size_t size) {
+  if (g_count_allocations.load(std::memory_order_relaxed)) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  }
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void *CountedAllocateAligned(std::size_t size, std::size_t alignment) {
+  if (g_count_allocations.load(std::memory_order_relaxed)) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (size == 0) {
+    size = 1;
+  }
+#ifdef _MSC_VER
+  return _aligned_malloc(size, alignment);
+#else
+  const std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+  return std::aligned_alloc(alignment, rounded);
+#endif
+}
+
+void CountedFreeAligned(void *ptr) {
+#ifdef _MSC_VER
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+} // namespace
+
+void *operator new(std::size_t size) {
+  if (void *ptr = CountedAllocate(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return CountedAllocate(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  if (void *ptr =
+          CountedAllocateAligned(size, static_cast<std::size_t>(alignment))) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+  CountedFreeAligned(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+  CountedFreeAligned(ptr);
+}
+#endif
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+namespace {
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+constexpr float kFloatTolerance = 1e-5f;
+
+bool AreFloatsEqual(float lhs, float rhs) {
+  return std::fabs(lhs - rhs) <= kFloatTolerance;
+}
+
+// Reads parameters the way SoftShadowShader::Render does.
+float ReadLikeShader(const LayeredParameterView &parameters) {
+  auto world = parameters.GetMatrix("worldMatrix");
+  auto view = parameters.GetMatrix("viewMatrix");
+  auto projection = parameters.GetMatrix("projectionMatrix");
+  auto texture = parameters.GetTexture("texture");
+  auto ambient = parameters.GetVector4("ambientColor");
+  auto light_position = parameters.GetVector3("lightPosition");
+  float reflection_blend = 0.0f;
+  if (parameters.HasParameter("reflectionBlend")) {
+    reflection_blend = parameters.GetFloat("reflectionBlend");
+  }
+  float shadow_strength = 1.0f;
+  if (parameters.HasParameter("shadowStrength")) {
+    shadow_strength = parameters.GetFloat("shadowStrength");
+  }
+  DirectX::XMFLOAT4X4 world_values;
+  DirectX::XMStoreFloat4x4(&world_values, world);
+  (void)view;
+  (void)projection;
+  return world_values._41 + ambient.x + light_position.y + reflection_blend +
+         shadow_strength + (texture == nullptr ? 0.0f : 1.0f);
+}
+
+bool TestViewMatchesBuildFinalParameters() {
+  ShaderParameterContainer global_parameters;
+  ShaderParameterContainer pass_parameters;
+  ShaderParameterContainer object_parameters;
+
+  global_parameters.SetFloat("shadowStrength", 0.1f);
+  global_parameters.SetFloat("reflectionBlend", 0.2f);
+  global_parameters.SetMatrix("worldMatrix",
+                              DirectX::XMMatrixTranslation(9.0f, 0.0f, 0.0f));
+  pass_parameters.SetFloat("shadowStrength", 0.4f);
+  object_parameters.SetFloat("shadowStrength", 0.7f);
+  object_parameters.SetFloat("reflectionBlend", 0.3f);
+
+  const DirectX::XMMATRIX world = DirectX::XMMatrixTranslation(2.0f, 0.0f, 0.0f);
+  const ShaderParameterCallback callback = [](ShaderParameterContainer &p) {
+    p.SetFloat("shadowStrength", 1.0f);
+  };
+
+  ShaderParameterContainer::BuildParametersInput inputs;
+  inputs.global_params = &global_parameters;
+  inputs.pass_params = &pass_parameters;
+  inputs.object_params = &object_parameters;
+  inputs.world_matrix = &world;
+  inputs.callback = callback;
+  const auto expected = ShaderParameterContainer::BuildFinalParameters(inputs);
+
+  LayeredParameterView base(global_parameters);
+  base.PushLayer(pass_parameters);
+  PerDrawParameters per_draw;
+  const auto &view = per_draw.Prepare(base, object_parameters, world, callback);
+
+  DirectX::XMFLOAT4X4 expected_world;
+  DirectX::XMFLOAT4X4 view_world;
+  DirectX::XMStoreFloat4x4(&expected_world,
+                           expected.GetMatrix("worldMatrix"));
+  DirectX::XMStoreFloat4x4(&view_world, view.GetMatrix("worldMatrix"));
+
+  return AreFloatsEqual(view.GetFloat("shadowStrength"),
+                        expected.GetFloat("shadowStrength")) &&
+         AreFloatsEqual(view.GetFloat("reflectionBlend"),
+                        expected.GetFloat("reflectionBlend")) &&
+         AreFloatsEqual(view_world._41, expected_world._41) &&
+         !view.HasParameter("neverSetParameter");
+}
+
+bool TestViewHonorsLocks() {
+  ShaderParameterContainer global_parameters;
+  ShaderParameterContainer pass_parameters;
+  ShaderParameterContainer object_parameters;
+
+  global_parameters.SetFloat("shadowStrength", 0.1f);
+  pass_parameters.SetFloatLocked("shadowStrength", 0.0f);
+  object_parameters.SetFloat("shadowStrength", 0.7f);
+
+  LayeredParameterView base(global_parameters);
+  base.PushLayer(pass_parameters);
+  PerDrawParameters per_draw;
+  const auto &view = per_draw.Prepare(
+      base, object_parameters, DirectX::XMMatrixIdentity(),
+      [](ShaderParameterContainer &p) { p.SetFloat("shadowStrength", 1.0f); });
+
+  return view.IsLocked("shadowStrength") &&
+         AreFloatsEqual(view.GetFloat("shadowStrength"), 0.0f);
+}
+
+bool TestStrictValidationThrowsOnLockedOverride() {
+  ShaderParameterContainer pass_parameters;
+  ShaderParameterContainer object_parameters;
+  pass_parameters.SetFloatLocked("lockedParam", 0.0f);
+  object_parameters.SetFloat("lockedParam", 1.0f);
+
+  LayeredParameterView view(pass_parameters);
+  view.PushLayer(object_parameters);
+
+  ShaderParameterContainer::SetStrictValidationEnabled(true);
+  bool threw = false;
+  try {
+    view.GetFloat("lockedParam");
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ShaderParameterContainer::SetStrictValidationEnabled(false);
+  return threw;
+}
+
+#ifdef LAYERED_PARAMETER_VIEW_COUNT_ALLOCATIONS
+bool TestFrameDoesNotAllocatePerDraw(std::string &message) {
+  constexpr int kObjectCount = 4000;
+
+  ShaderParameterContainer global_parameters;
+  global_parameters.SetMatrix("viewMatrix", DirectX::XMMatrixIdentity());
+  global_parameters.SetMatrix("projectionMatrix", DirectX::XMMatrixIdentity());
+  global_parameters.SetVector3("lightPosition",
+                               DirectX::XMFLOAT3(0.0f, 8.0f, -5.0f));
+  global_parameters.SetFloat("shadowStrength", 1.0f);
+
+  ShaderParameterContainer pass_parameters;
+  pass_parameters.SetVector4("ambientColor",
+                             DirectX::XMFLOAT4(0.15f, 0.15f, 0.15f, 1.0f));
+  pass_parameters.SetFloatLocked("reflectionBlend", 0.0f);
+
+  // Callbacks capture a pointer, like the Scene lambdas capturing a model.
+  auto *fake_texture = reinterpret_cast<ID3D11ShaderResourceView *>(0x10);
+  std::vector<ShaderParameterContainer> object_parameters(kObjectCount);
+  std::vector<ShaderParameterCallback> callbacks(kObjectCount);
+  std::vector<DirectX::XMMATRIX> world_matrices(kObjectCount);
+  for (int i = 0; i < kObjectCount; ++i) {
+    object_parameters[i].SetFloat("shadowStrength", 0.5f);
+    callbacks[i] = [fake_texture](ShaderParameterContainer &p) {
+      p.SetTexture("texture", fake_texture);
+      p.SetFloat("reflectionBlend", 0.5f);
+    };
+    world_matrices[i] =
+        DirectX::XMMatrixTranslation(static_cast<float>(i), 0.0f, 0.0f);
+  }
+
+  auto render_frame = [&]() {
+    LayeredParameterView pass_view(global_parameters);
+    pass_view.PushLayer(pass_parameters);
+    PerDrawParameters per_draw;
+    float checksum = 0.0f;
+    for (int i = 0; i < kObjectCount; ++i) {
+      const auto &view = per_draw.Prepare(pass_view, object_parameters[i],
+                                          world_matrices[i], callbacks[i]);
+      checksum += ReadLikeShader(view);
+    }
+    return checksum;
+  };
+
+  // Warm-up frame interns every parameter name.
+  const float expected = render_frame();
+
+  g_allocation_count.store(0, std::memory_order_relaxed);
+  g_count_allocations.store(true, std::memory_order_relaxed);
+  const float checksum = render_frame();
+  g_count_allocations.store(false, std::memory_order_relaxed);
+
+  const std::size_t allocations =
+      g_allocation_count.load(std::memory_order_relaxed);
+  if (allocations != 0) {
+    message = std::to_string(allocations) + " allocations for " +
+              std::to_string(kObjectCount) + " draws";
+    return false;
+  }
+  return checksum == expected;
+}
+#endif
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(4);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("View matches BuildFinalParameters precedence",
+      [](std::string &) { return TestViewMatchesBuildFinalParameters(); });
+  run("View honors locks from lower layers",
+      [](std::string &) { return TestViewHonorsLocks(); });
+  run("StrictValidation throws on locked override read", [](std::string &) {
+    return TestStrictValidationThrowsOnLockedOverride();
+  });
+#ifdef LAYERED_PARAMETER_VIEW_COUNT_ALLOCATIONS
+  run("Frame of draws does not allocate", [](std::string &message) {
+    return TestFrameDoesNotAllocatePerDraw(message);
+  });
+#endif
+
+  return results;
+}
+
+} // namespace
+
+bool RunLayeredParameterViewTests() {
+  const auto results = RunAllTestsInternal();
+  bool all_passed = true;
+
+  for (const auto &result : results) {
+    if (!result.passed) {
+      all_passed = false;
+      std::ostringstream oss;
+      oss << "Test failed: " << result.name;
+      if (!result.message.empty()) {
+        oss << " - " << result.message;
+      }
+      Logger::SetModule("LayeredParameterViewTests");
+      Logger::LogError(oss.str());
+    }
+  }
+
+  if (all_passed) {
+    Logger::SetModule("LayeredParameterViewTests");
+    Logger::LogInfo("All LayeredParameterView tests passed");
+  }
+
+  return all_passed;
+}
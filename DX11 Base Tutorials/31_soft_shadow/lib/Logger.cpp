@@ -5,7 +5,9 @@
 
 namespace Logger {
 namespace {
-std::string current_module_ = "[Unknown]";
+// Per thread: SetModule() and the Log call that follows must pair up even
+// when render passes record on worker threads.
+thread_local std::string current_module_ = "[Unknown]";
 Level min_level_ = Level::Warning; // Default: only Warning and Error
 
 const char *GetLevelString(Level level) {
@@ -0,0 +1,117 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() { Close(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+  *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    Close();
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+#ifdef _WIN32
+    std::swap(file_, other.file_);
+    std::swap(mapping_, other.mapping_);
+#endif
+  }
+  return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string &path) {
+  Close();
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 ||
+      static_cast<unsigned long long>(size.QuadPart) >
+          static_cast<unsigned long long>(SIZE_MAX)) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return false;
+  }
+  void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (view == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+  file_ = file;
+  mapping_ = mapping;
+  data_ = static_cast<const std::uint8_t *>(view);
+  size_ = static_cast<std::size_t>(size.QuadPart);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_ != nullptr) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_ != nullptr) {
+    CloseHandle(mapping_);
+  }
+  if (file_ != nullptr) {
+    CloseHandle(file_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  mapping_ = nullptr;
+  file_ = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const std::string &path) {
+  Close();
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+  void *view = ::mmap(nullptr, static_cast<std::size_t>(info.st_size),
+                      PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // The mapping keeps the file referenced.
+  if (view == MAP_FAILED) {
+    return false;
+  }
+  data_ = static_cast<const std::uint8_t *>(view);
+  size_ = static_cast<std::size_t>(info.st_size);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<std::uint8_t *>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+}
+
+#endif
@@ -0,0 +1,443 @@
+#include "MeshFile.h"
+
+#include "JobSystem.h"
+#include "Logger.h"
+#include "MeshOptimizer.h"
+#include "TangentFrame.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+using namespace DirectX;
+
+namespace {
+
+constexpr std::uint64_t kSectionAlignment = 16;
+
+std::uint64_t AlignUp(std::uint64_t value) {
+  return (value + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+}
+
+void LogMeshError(const std::string &message) {
+  Logger::SetModule("MeshFile");
+  Logger::LogError(message);
+}
+
+bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+} // namespace
+
+bool ParseDecimalFloat(const char *&cursor, const char *end, float &value) {
+  const char *p = cursor;
+  while (p < end && IsSpace(*p)) {
+    ++p;
+  }
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+
+  std::uint64_t mantissa = 0;
+  int exponent = 0;
+  int digits = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p, ++digits) {
+    if (mantissa < 100000000000000000ull) {
+      mantissa = mantissa * 10 + static_cast<std::uint64_t>(*p - '0');
+    } else {
+      ++exponent; // Digits past double precision only scale
+    }
+  }
+  if (p < end && *p == '.') {
+    for (++p; p < end && *p >= '0' && *p <= '9'; ++p, ++digits) {
+      if (mantissa < 100000000000000000ull) {
+        mantissa = mantissa * 10 + static_cast<std::uint64_t>(*p - '0');
+        --exponent;
+      }
+    }
+  }
+  if (digits == 0) {
+    return false;
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    bool exponent_negative = false;
+    if (q < end && (*q == '-' || *q == '+')) {
+      exponent_negative = *q == '-';
+      ++q;
+    }
+    if (q < end && *q >= '0' && *q <= '9') {
+      int written = 0;
+      for (; q < end && *q >= '0' && *q <= '9'; ++q) {
+        written = (std::min)(written * 10 + (*q - '0'), 1000);
+      }
+      exponent += exponent_negative ? -written : written;
+      p = q;
+    }
+  }
+
+  // Powers of ten up to 1e22 are exact doubles, so the common case is one
+  // correctly rounded multiply or divide.
+  static const double kPowersOf10[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  double result = static_cast<double>(mantissa);
+  if (exponent < 0 && exponent >= -22) {
+    result /= kPowersOf10[-exponent];
+  } else if (exponent > 0 && exponent <= 22) {
+    result *= kPowersOf10[exponent];
+  } else if (exponent != 0) {
+    result *= std::pow(10.0, exponent);
+  }
+  value = static_cast<float>(negative ? -result : result);
+  cursor = p;
+  return true;
+}
+
+namespace {
+
+// Positions of a vertex array with the given stride (in floats).
+BoundingVolume ComputeBounds(const std::vector<float> &vertices,
+                             std::size_t stride) {
+  const std::size_t count = vertices.size() / stride;
+  std::vector<XMFLOAT3> positions(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const float *v = &vertices[i * stride];
+    positions[i] = XMFLOAT3(v[0], v[1], v[2]);
+  }
+  BoundingVolume bounds;
+  bounds.CalculateFromVertices(positions.data(), positions.size());
+  return bounds;
+}
+
+} // namespace
+
+const std::vector<MeshAttribute> &GetTextModelLayout() {
+  static const std::vector<MeshAttribute> layout = {
+      {MeshSemantic::Position, 3, 0},
+      {MeshSemantic::TexCoord, 2, 12},
+      {MeshSemantic::Normal, 3, 20},
+  };
+  return layout;
+}
+
+const std::vector<MeshAttribute> &GetTangentFrameModelLayout() {
+  static const std::vector<MeshAttribute> layout = {
+      {MeshSemantic::Position, 3, 0},  {MeshSemantic::TexCoord, 2, 12},
+      {MeshSemantic::Normal, 3, 20},   {MeshSemantic::Tangent, 3, 32},
+      {MeshSemantic::Binormal, 3, 44},
+  };
+  return layout;
+}
+
+bool WriteMeshFile(const std::string &path, const MeshData &mesh) {
+  const std::size_t vertex_count = mesh.GetVertexCount();
+  if (mesh.vertex_stride == 0 || mesh.vertex_stride % 4 != 0 ||
+      vertex_count > 0xffffffffu || mesh.indices.size() > 0xffffffffu) {
+    LogMeshError("Invalid mesh for " + path);
+    return false;
+  }
+
+  MeshFileHeader header;
+  header.vertex_count = static_cast<std::uint32_t>(vertex_count);
+  header.index_count = static_cast<std::uint32_t>(mesh.indices.size());
+  header.vertex_stride = mesh.vertex_stride;
+  header.index_size = vertex_count <= 0x10000 ? 2 : 4;
+  header.attribute_count = static_cast<std::uint32_t>(mesh.layout.size());
+  const BoundingVolume &b = mesh.bounds;
+  std::memcpy(header.aabb_min, &b.aabb_min, sizeof(header.aabb_min));
+  std::memcpy(header.aabb_max, &b.aabb_max, sizeof(header.aabb_max));
+  std::memcpy(header.sphere_center, &b.sphere_center,
+              sizeof(header.sphere_center));
+  header.sphere_radius = b.sphere_radius;
+
+  const std::uint64_t attributes_size =
+      mesh.layout.size() * sizeof(MeshAttribute);
+  const std::uint64_t vertices_size =
+      static_cast<std::uint64_t>(vertex_count) * mesh.vertex_stride;
+  const std::uint64_t indices_size =
+      static_cast<std::uint64_t>(mesh.indices.size()) * header.index_size;
+  header.attributes_offset = AlignUp(sizeof(MeshFileHeader));
+  header.vertices_offset = AlignUp(header.attributes_offset + attributes_size);
+  header.indices_offset = AlignUp(header.vertices_offset + vertices_size);
+  header.file_size = header.indices_offset + indices_size;
+
+  std::vector<std::uint8_t> bytes(static_cast<std::size_t>(header.file_size));
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  if (attributes_size > 0) {
+    std::memcpy(&bytes[header.attributes_offset], mesh.layout.data(),
+                attributes_size);
+  }
+  if (vertices_size > 0) {
+    std::memcpy(&bytes[header.vertices_offset], mesh.vertices.data(),
+                vertices_size);
+  }
+  std::uint8_t *indices = bytes.data() + header.indices_offset;
+  for (std::size_t i = 0; i < mesh.indices.size(); ++i) {
+    if (header.index_size == 2) {
+      const auto index = static_cast<std::uint16_t>(mesh.indices[i]);
+      std::memcpy(indices + i * 2, &index, 2);
+    } else {
+      std::memcpy(indices + i * 4, &mesh.indices[i], 4);
+    }
+  }
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char *>(bytes.data()),
+            static_cast<std::streamsize>(bytes.size()));
+  if (!out) {
+    LogMeshError("Failed to write " + path);
+    return false;
+  }
+  return true;
+}
+
+bool ParseTextModel(const char *text, std::size_t size,
+                    std::vector<float> &vertices) {
+  const char *cursor = text;
+  const char *end = text + size;
+
+  const char *colon = std::find(cursor, end, ':');
+  if (colon == end) {
+    return false;
+  }
+  cursor = colon + 1;
+  float count_value = 0.0f;
+  if (!ParseDecimalFloat(cursor, end, count_value) || count_value <= 0.0f) {
+    return false;
+  }
+  // Every vertex takes at least 16 characters, which bounds the count by the
+  // file size before anything is allocated.
+  const std::size_t vertex_count = static_cast<std::size_t>(count_value);
+  if (vertex_count > size / 16) {
+    return false;
+  }
+
+  colon = std::find(cursor, end, ':');
+  if (colon == end) {
+    return false;
+  }
+  cursor = colon + 1;
+
+  vertices.resize(vertex_count * 8);
+  float *out = vertices.data();
+  for (std::size_t i = 0; i < vertex_count * 8; ++i) {
+    if (!ParseDecimalFloat(cursor, end, out[i])) {
+      vertices.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool LoadTextModel(const std::string &path, std::vector<float> &vertices) {
+  MappedFile file;
+  if (!file.Open(path)) {
+    LogMeshError("Failed to open " + path);
+    return false;
+  }
+  if (!ParseTextModel(reinterpret_cast<const char *>(file.GetData()),
+                      file.GetSize(), vertices)) {
+    LogMeshError("Malformed text model " + path);
+    return false;
+  }
+  return true;
+}
+
+void BuildIndexedMesh(const std::vector<float> &triangle_vertices,
+                      bool with_tangents, MeshData &mesh) {
+  const std::size_t in_stride = 8;
+  const std::size_t out_stride = with_tangents ? 14 : 8;
+  const std::size_t vertex_count = triangle_vertices.size() / in_stride;
+
+  // Expand to the output layout; tangent frames are filled in after
+  // welding, once vertices know the faces they share.
+  std::vector<float> expanded(vertex_count * out_stride, 0.0f);
+  for (std::size_t i = 0; i < vertex_count; ++i) {
+    std::memcpy(&expanded[i * out_stride], &triangle_vertices[i * in_stride],
+                in_stride * sizeof(float));
+  }
+
+  // -0 becomes 0 so equal values weld. Bitwise, since /fp:fast may drop a
+  // comparison against 0.0f.
+  for (float &value : expanded) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if (bits == 0x80000000u) {
+      value = 0.0f;
+    }
+  }
+
+  mesh.layout = with_tangents ? GetTangentFrameModelLayout()
+                              : GetTextModelLayout();
+  mesh.vertex_stride = static_cast<std::uint32_t>(out_stride * sizeof(float));
+  mesh.indices.resize(vertex_count);
+  for (std::size_t i = 0; i < vertex_count; ++i) {
+    mesh.indices[i] = static_cast<std::uint32_t>(i);
+  }
+  const std::size_t unique_count = DeduplicateVertices(
+      expanded.data(), vertex_count, mesh.vertex_stride, mesh.indices);
+  expanded.resize(unique_count * out_stride);
+  if (with_tangents) {
+    const auto job_system =
+        CreateTangentFrameJobSystem(mesh.indices.size() / 3);
+    GenerateTangentFrames(expanded.data(), unique_count, out_stride,
+                          mesh.indices, job_system.get());
+  }
+  mesh.vertices = std::move(expanded);
+  mesh.bounds = ComputeBounds(mesh.vertices, out_stride);
+}
+
+bool ConvertTextModel(const std::string &text_path,
+                      const std::string &mesh_path, bool with_tangents) {
+  std::vector<float> vertices;
+  if (!LoadTextModel(text_path, vertices)) {
+    return false;
+  }
+  MeshData mesh;
+  BuildIndexedMesh(vertices, with_tangents, mesh);
+  const MeshOptimizationReport report = OptimizeMesh(mesh);
+  if (!WriteMeshFile(mesh_path, mesh)) {
+    return false;
+  }
+  Logger::SetModule("MeshFile");
+  Logger::LogInfo("Converted " + text_path + ": " +
+                  std::to_string(vertices.size() / 8) + " -> " +
+                  std::to_string(mesh.GetVertexCount()) + " vertices, " +
+                  std::to_string(mesh.indices.size()) + " indices, ACMR " +
+                  std::to_string(report.cache_before.acmr) + " -> " +
+                  std::to_string(report.cache_after.acmr));
+  return true;
+}
+
+bool MeshFile::Open(const std::string &path) {
+  Close();
+  if (!file_.Open(path)) {
+    return false;
+  }
+
+  const std::uint64_t size = file_.GetSize();
+  const auto *header = reinterpret_cast<const MeshFileHeader *>(
+      size >= sizeof(MeshFileHeader) ? file_.GetData() : nullptr);
+  std::string error;
+  if (header == nullptr || header->magic != kMeshFileMagic) {
+    error = "not a mesh file";
+  } else if (header->version != kMeshFileVersion) {
+    error = "unsupported version " + std::to_string(header->version);
+  } else if (header->index_size != 2 && header->index_size != 4) {
+    error = "bad index size";
+  } else if (header->vertex_stride == 0 || header->vertex_stride % 4 != 0) {
+    error = "bad vertex stride";
+  } else if (header->file_size != size || header->attributes_offset > size ||
+             header->vertices_offset > size ||
+             header->indices_offset > size ||
+             header->attributes_offset < sizeof(MeshFileHeader) ||
+             header->attributes_offset +
+                     header->attribute_count * sizeof(MeshAttribute) >
+                 header->vertices_offset ||
+             header->vertices_offset +
+                     std::uint64_t{header->vertex_count} *
+                         header->vertex_stride >
+                 header->indices_offset ||
+             header->indices_offset +
+                     std::uint64_t{header->index_count} * header->index_size >
+                 size) {
+    error = "truncated or inconsistent sections";
+  } else if (header->vertices_offset % kSectionAlignment != 0 ||
+             header->indices_offset % kSectionAlignment != 0) {
+    error = "misaligned sections";
+  }
+
+  if (error.empty()) {
+    header_ = header;
+    for (std::uint32_t i = 0; i < header->attribute_count; ++i) {
+      const MeshAttribute &attribute = GetAttributes()[i];
+      if (attribute.components == 0 || attribute.components > 4 ||
+          std::uint64_t{attribute.offset} + attribute.components * 4 >
+              header->vertex_stride) {
+        error = "attribute outside the vertex";
+        break;
+      }
+    }
+  }
+  if (error.empty()) {
+    // Drawing with an index past the vertex section reads outside the
+    // vertex buffer, so refuse the file rather than trusting the converter.
+    const std::uint32_t vertex_count = header->vertex_count;
+    const std::uint8_t *indices = file_.GetData() + header->indices_offset;
+    for (std::uint32_t i = 0; i < header->index_count; ++i) {
+      const std::uint32_t index =
+          header->index_size == 2
+              ? reinterpret_cast<const std::uint16_t *>(indices)[i]
+              : reinterpret_cast<const std::uint32_t *>(indices)[i];
+      if (index >= vertex_count) {
+        error = "index " + std::to_string(index) + " past vertex count " +
+                std::to_string(vertex_count);
+        break;
+      }
+    }
+  }
+  if (!error.empty()) {
+    LogMeshError(path + ": " + error);
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void MeshFile::Close() {
+  header_ = nullptr;
+  file_.Close();
+}
+
+bool MeshFile::HasLayoutPrefix(
+    const std::vector<MeshAttribute> &expected) const {
+  if (expected.size() > header_->attribute_count) {
+    return false;
+  }
+  const MeshAttribute *attributes = GetAttributes();
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    if (attributes[i].semantic != expected[i].semantic ||
+        attributes[i].components != expected[i].components ||
+        attributes[i].offset != expected[i].offset) {
+      return false;
+    }
+  }
+  return true;
+}
+
+BoundingVolume MeshFile::GetBounds() const {
+  BoundingVolume bounds;
+  bounds.aabb_min = XMFLOAT3(header_->aabb_min);
+  bounds.aabb_max = XMFLOAT3(header_->aabb_max);
+  bounds.sphere_center = XMFLOAT3(header_->sphere_center);
+  bounds.sphere_radius = header_->sphere_radius;
+  return bounds;
+}
+
+std::string FindConvertedMesh(const std::string &text_path) {
+  namespace fs = std::filesystem;
+  std::error_code error;
+  if (fs::path(text_path).extension() == ".mesh") {
+    return text_path;
+  }
+  const fs::path mesh_path = fs::path(text_path).replace_extension(".mesh");
+  if (!fs::exists(mesh_path, error)) {
+    return {};
+  }
+  const auto mesh_time = fs::last_write_time(mesh_path, error);
+  if (error) {
+    return {};
+  }
+  const auto text_time = fs::last_write_time(text_path, error);
+  if (!error && text_time > mesh_time) {
+    return {}; // Stale; the text model was edited after conversion
+  }
+  return mesh_path.string();
+}
@@ -0,0 +1,159 @@
+#include "MeshFileBenchmarks.h"
+
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <typename Func> double MeasureMilliseconds(Func &&func) {
+  const auto start = Clock::now();
+  func();
+  const auto end = Clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Unindexed cells x cells grid in the text model format, as the RasterTek
+// exporter writes it: two triangles per cell, six-digit values.
+void WriteGridModel(const std::string &path, int cells) {
+  std::FILE *file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return;
+  }
+  std::fprintf(file, "Vertex Count: %d\n\nData:\n\n", cells * cells * 6);
+  const float scale = 1.0f / static_cast<float>(cells);
+  auto vertex = [&](int x, int z) {
+    const float u = static_cast<float>(x) * scale;
+    const float v = static_cast<float>(z) * scale;
+    std::fprintf(file, "%f %f %f %f %f %f %f %f\n", u * 100.0f,
+                 std::sin(u * 6.0f) * std::cos(v * 6.0f), v * 100.0f, u,
+                 1.0f - v, 0.0f, 1.0f, 0.0f);
+  };
+  for (int z = 0; z < cells; ++z) {
+    for (int x = 0; x < cells; ++x) {
+      vertex(x, z);
+      vertex(x, z + 1);
+      vertex(x + 1, z);
+      vertex(x + 1, z);
+      vertex(x, z + 1);
+      vertex(x + 1, z + 1);
+    }
+  }
+  std::fclose(file);
+}
+
+// The loader Model used before: one float at a time through operator>>.
+bool LoadWithStream(const std::string &path, std::vector<float> &vertices) {
+  std::ifstream fin(path);
+  char input;
+  while (fin.get(input) && input != ':') {
+  }
+  int vertex_count = 0;
+  fin >> vertex_count;
+  while (fin.get(input) && input != ':') {
+  }
+  vertices.resize(static_cast<std::size_t>(vertex_count) * 8);
+  for (float &value : vertices) {
+    fin >> value;
+  }
+  return !fin.fail();
+}
+
+} // namespace
+
+bool RunMeshFileBenchmarks() {
+  std::cout << "=== Mesh loading benchmark ===" << std::endl;
+
+  constexpr int kCells = 256;
+  const auto directory = std::filesystem::temp_directory_path();
+  const std::string text_path = (directory / "mesh_benchmark.txt").string();
+  const std::string mesh_path = (directory / "mesh_benchmark.mesh").string();
+  WriteGridModel(text_path, kCells);
+
+  std::vector<float> stream_vertices;
+  bool stream_ok = false;
+  const double stream_ms = MeasureMilliseconds(
+      [&] { stream_ok = LoadWithStream(text_path, stream_vertices); });
+
+  std::vector<float> parsed_vertices;
+  bool parse_ok = false;
+  const double parse_ms = MeasureMilliseconds(
+      [&] { parse_ok = LoadTextModel(text_path, parsed_vertices); });
+
+  MeshData mesh;
+  bool write_ok = false;
+  MeshOptimizationReport report;
+  double optimize_ms = 0.0;
+  const double convert_ms = MeasureMilliseconds([&] {
+    BuildIndexedMesh(parsed_vertices, false, mesh);
+    optimize_ms = MeasureMilliseconds([&] { report = OptimizeMesh(mesh); });
+    write_ok = WriteMeshFile(mesh_path, mesh);
+  });
+
+  // Open and read every vertex once, as buffer creation would.
+  MeshFile file;
+  bool open_ok = false;
+  float checksum = 0.0f;
+  const double mapped_ms = MeasureMilliseconds([&] {
+    open_ok = file.Open(mesh_path);
+    if (open_ok) {
+      const float *vertices = static_cast<const float *>(file.GetVertices());
+      const std::size_t floats =
+          std::size_t{file.GetVertexCount()} * file.GetVertexStride() / 4;
+      for (std::size_t i = 0; i < floats; ++i) {
+        checksum += vertices[i];
+      }
+    }
+  });
+
+  bool consistent = stream_ok && parse_ok && write_ok && open_ok &&
+                    stream_vertices.size() == parsed_vertices.size();
+  for (std::size_t i = 0; consistent && i < parsed_vertices.size(); ++i) {
+    consistent = std::fabs(stream_vertices[i] - parsed_vertices[i]) <=
+                 1e-6f * (1.0f + std::fabs(stream_vertices[i]));
+  }
+  const std::size_t expected_vertices =
+      static_cast<std::size_t>(kCells + 1) * (kCells + 1);
+  consistent = consistent && file.GetVertexCount() == expected_vertices &&
+               checksum == checksum; // NaN check
+
+  std::cout << std::fixed << std::setprecision(3) << kCells * kCells * 2
+            << " triangles | istream " << stream_ms << " ms | parser "
+            << parse_ms << " ms | speedup " << std::setprecision(2)
+            << (parse_ms > 0.0 ? stream_ms / parse_ms : 0.0) << "x"
+            << std::endl;
+  const std::uintmax_t text_kib = std::filesystem::file_size(text_path) / 1024;
+  const std::uintmax_t mesh_kib = std::filesystem::file_size(mesh_path) / 1024;
+  std::cout << std::setprecision(3) << "  convert " << convert_ms
+            << " ms | mapped .mesh " << mapped_ms << " ms | vertices "
+            << parsed_vertices.size() / 8 << " -> " << file.GetVertexCount()
+            << " | " << text_kib << " KiB -> " << mesh_kib << " KiB"
+            << std::endl;
+  // Before: the welded indices in the exporter's row order.
+  std::cout << "  vertex cache optimization " << optimize_ms << " ms | ACMR "
+            << report.cache_before.acmr << " -> " << report.cache_after.acmr
+            << " | ATVR " << report.cache_before.atvr << " -> "
+            << report.cache_after.atvr << " (" << kVertexCacheSize
+            << "-entry FIFO)" << std::endl;
+
+  file.Close();
+  std::error_code error;
+  std::filesystem::remove(text_path, error);
+  std::filesystem::remove(mesh_path, error);
+
+  if (!consistent) {
+    std::cout << "Mesh loaders disagree" << std::endl;
+  }
+  return consistent;
+}
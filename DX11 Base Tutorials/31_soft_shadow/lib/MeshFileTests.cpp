@@ -0,0 +1,336 @@
+#include "MeshFileTests.h"
+
+#include "Logger.h"
+#include "MeshFile.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+bool NearlyEqual(float a, float b, float epsilon = 1e-6f) {
+  return std::fabs(a - b) <= epsilon;
+}
+
+// Scratch file in the temp directory, removed when the test ends.
+class TempFile {
+public:
+  explicit TempFile(const std::string &name)
+      : path_((std::filesystem::temp_directory_path() / name).string()) {}
+
+  ~TempFile() {
+    std::error_code error;
+    std::filesystem::remove(path_, error);
+  }
+
+  const std::string &GetPath() const { return path_; }
+
+  void Write(const std::string &bytes) const {
+    std::ofstream out(path_, std::ios::binary | std::ios::trunc);
+    out << bytes;
+  }
+
+  std::string Read() const {
+    std::ifstream in(path_, std::ios::binary);
+    std::ostringstream bytes;
+    bytes << in.rdbuf();
+    return bytes.str();
+  }
+
+private:
+  std::string path_;
+};
+
+// Two triangles sharing the edge (1,0,0)-(0,1,0): 6 vertices, 4 unique.
+const char kQuadModel[] = "Vertex Count: 6\n"
+                          "\n"
+                          "Data:\n"
+                          "\n"
+                          "0 0 0 0 1 0 0 -1\n"
+                          "1 0 0 1 1 0 0 -1\n"
+                          "0 1 0 0 0 0 0 -1\n"
+                          "0 1 0 0 0 0 0 -1\n"
+                          "1 0 0 1 1 0 0 -1\n"
+                          "1 1 0 1 0 0 0 -1\n";
+
+bool TestParseTextModel(std::string &message) {
+  const std::string text = "Vertex Count: 1\r\n\r\nData:\r\n\r\n"
+                           "-1.5 2.25e2 +0.125 1E-3 -0 0.5 -0.5 1.0\r\n";
+  std::vector<float> vertices;
+  if (!ParseTextModel(text.data(), text.size(), vertices) ||
+      vertices.size() != 8) {
+    message = "valid model rejected";
+    return false;
+  }
+  const float expected[8] = {-1.5f, 225.0f, 0.125f, 0.001f,
+                             0.0f,  0.5f,   -0.5f,  1.0f};
+  for (int i = 0; i < 8; ++i) {
+    if (!NearlyEqual(vertices[i], expected[i])) {
+      message = "value " + std::to_string(i) + " parsed wrong";
+      return false;
+    }
+  }
+
+  // Too few values, and a count the file cannot possibly hold.
+  const std::string truncated = "Vertex Count: 2\nData:\n1 2 3 4 5 6 7 8\n";
+  const std::string oversized = "Vertex Count: 99999999\nData:\n1 2 3\n";
+  if (ParseTextModel(truncated.data(), truncated.size(), vertices) ||
+      ParseTextModel(oversized.data(), oversized.size(), vertices)) {
+    message = "malformed model accepted";
+    return false;
+  }
+  return true;
+}
+
+bool TestBuildIndexedMeshWeldsVertices(std::string &message) {
+  std::vector<float> vertices;
+  if (!ParseTextModel(kQuadModel, sizeof(kQuadModel) - 1, vertices)) {
+    message = "quad model rejected";
+    return false;
+  }
+
+  MeshData mesh;
+  BuildIndexedMesh(vertices, false, mesh);
+  const std::vector<std::uint32_t> expected_indices = {0, 1, 2, 2, 1, 3};
+  if (mesh.GetVertexCount() != 4 || mesh.indices != expected_indices ||
+      mesh.vertex_stride != 32) {
+    message = "shared vertices not welded";
+    return false;
+  }
+  if (!NearlyEqual(mesh.bounds.aabb_max.x, 1.0f) ||
+      !NearlyEqual(mesh.bounds.aabb_max.y, 1.0f) ||
+      !NearlyEqual(mesh.bounds.aabb_min.z, 0.0f)) {
+    message = "bounds wrong";
+    return false;
+  }
+
+  // Both triangles have the same UV mapping, so the shared vertices keep
+  // welding with tangent frames appended: +x tangent, -y binormal.
+  BuildIndexedMesh(vertices, true, mesh);
+  if (mesh.GetVertexCount() != 4 || mesh.vertex_stride != 56 ||
+      mesh.layout.size() != 5) {
+    message = "tangent layout wrong";
+    return false;
+  }
+  const float *first = mesh.vertices.data();
+  if (!NearlyEqual(first[8], 1.0f) || !NearlyEqual(first[12], -1.0f)) {
+    message = "tangent frame wrong";
+    return false;
+  }
+  return true;
+}
+
+bool TestMeshFileRoundTrip(std::string &message) {
+  std::vector<float> vertices;
+  ParseTextModel(kQuadModel, sizeof(kQuadModel) - 1, vertices);
+  MeshData mesh;
+  BuildIndexedMesh(vertices, true, mesh);
+
+  TempFile file("meshfile_test_round_trip.mesh");
+  if (!WriteMeshFile(file.GetPath(), mesh)) {
+    message = "write failed";
+    return false;
+  }
+
+  MeshFile loaded;
+  if (!loaded.Open(file.GetPath())) {
+    message = "open failed";
+    return false;
+  }
+  if (loaded.GetVertexCount() != 4 || loaded.GetIndexCount() != 6 ||
+      loaded.GetIndexSize() != 2 || loaded.GetVertexStride() != 56 ||
+      !loaded.HasLayoutPrefix(GetTextModelLayout()) ||
+      !loaded.HasLayoutPrefix(GetTangentFrameModelLayout())) {
+    message = "header or layout differs";
+    return false;
+  }
+  if (reinterpret_cast<std::uintptr_t>(loaded.GetVertices()) % 16 != 0 ||
+      std::memcmp(loaded.GetVertices(), mesh.vertices.data(),
+                  mesh.vertices.size() * sizeof(float)) != 0) {
+    message = "vertex section differs";
+    return false;
+  }
+  const auto *indices = static_cast<const std::uint16_t *>(loaded.GetIndices());
+  for (std::size_t i = 0; i < mesh.indices.size(); ++i) {
+    if (indices[i] != mesh.indices[i]) {
+      message = "index section differs";
+      return false;
+    }
+  }
+  const BoundingVolume bounds = loaded.GetBounds();
+  return NearlyEqual(bounds.sphere_radius, mesh.bounds.sphere_radius) &&
+         NearlyEqual(bounds.aabb_max.x, 1.0f);
+}
+
+bool TestLargeMeshUses32BitIndices(std::string &message) {
+  // One more vertex than 16-bit indices can address.
+  MeshData mesh;
+  mesh.layout = GetTextModelLayout();
+  mesh.vertex_stride = 32;
+  const std::uint32_t vertex_count = 0x10001;
+  mesh.vertices.assign(std::size_t{vertex_count} * 8, 0.0f);
+  mesh.indices = {0, 1, vertex_count - 1};
+
+  TempFile file("meshfile_test_32bit.mesh");
+  MeshFile loaded;
+  if (!WriteMeshFile(file.GetPath(), mesh) || !loaded.Open(file.GetPath())) {
+    message = "round trip failed";
+    return false;
+  }
+  const auto *indices = static_cast<const std::uint32_t *>(loaded.GetIndices());
+  return loaded.GetIndexSize() == 4 && indices[2] == vertex_count - 1;
+}
+
+bool TestOpenRejectsDamagedFiles(std::string &message) {
+  std::vector<float> vertices;
+  ParseTextModel(kQuadModel, sizeof(kQuadModel) - 1, vertices);
+  MeshData mesh;
+  BuildIndexedMesh(vertices, false, mesh);
+
+  TempFile file("meshfile_test_damaged.mesh");
+  WriteMeshFile(file.GetPath(), mesh);
+  const std::string good = file.Read();
+  MeshFile loaded;
+
+  file.Write(good.substr(0, good.size() - 2));
+  if (loaded.Open(file.GetPath())) {
+    message = "truncated file accepted";
+    return false;
+  }
+
+  std::string wrong_version = good;
+  const std::uint32_t version = kMeshFileVersion + 1;
+  std::memcpy(&wrong_version[offsetof(MeshFileHeader, version)], &version,
+              sizeof(version));
+  file.Write(wrong_version);
+  if (loaded.Open(file.GetPath())) {
+    message = "unknown version accepted";
+    return false;
+  }
+
+  std::string huge_count = good;
+  const std::uint32_t count = 0xfffffff0u;
+  std::memcpy(&huge_count[offsetof(MeshFileHeader, vertex_count)], &count,
+              sizeof(count));
+  file.Write(huge_count);
+  if (loaded.Open(file.GetPath())) {
+    message = "vertex count beyond the file accepted";
+    return false;
+  }
+
+  std::string bad_index = good;
+  std::uint64_t indices_offset = 0;
+  std::memcpy(&indices_offset, &good[offsetof(MeshFileHeader, indices_offset)],
+              sizeof(indices_offset));
+  const auto index = static_cast<std::uint16_t>(mesh.GetVertexCount());
+  std::memcpy(&bad_index[indices_offset], &index, sizeof(index));
+  file.Write(bad_index);
+  if (loaded.Open(file.GetPath())) {
+    message = "index past the vertex count accepted";
+    return false;
+  }
+
+  file.Write("Vertex Count: 3\n");
+  if (loaded.Open(file.GetPath())) {
+    message = "text file accepted";
+    return false;
+  }
+
+  file.Write(good);
+  return loaded.Open(file.GetPath()) && loaded.GetVertexCount() == 4;
+}
+
+bool TestConvertTextModel(std::string &message) {
+  TempFile text("meshfile_test_convert.txt");
+  TempFile converted("meshfile_test_convert.mesh");
+  text.Write(kQuadModel);
+
+  if (!FindConvertedMesh(text.GetPath()).empty()) {
+    message = "missing .mesh reported as converted";
+    return false;
+  }
+  if (!ConvertTextModel(text.GetPath(), converted.GetPath(), false)) {
+    message = "conversion failed";
+    return false;
+  }
+  if (FindConvertedMesh(text.GetPath()) != converted.GetPath() ||
+      FindConvertedMesh(converted.GetPath()) != converted.GetPath()) {
+    message = "converted .mesh not found next to the text model";
+    return false;
+  }
+  MeshFile loaded;
+  return loaded.Open(converted.GetPath()) && loaded.GetIndexCount() == 6 &&
+         loaded.GetVertexCount() == 4;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(6);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("Text model parsing", TestParseTextModel);
+  run("BuildIndexedMesh welds shared vertices",
+      TestBuildIndexedMeshWeldsVertices);
+  run(".mesh round trip", TestMeshFileRoundTrip);
+  run("Large meshes use 32-bit indices", TestLargeMeshUses32BitIndices);
+  run("Open rejects damaged files", TestOpenRejectsDamagedFiles);
+  run("Text models convert next to their source", TestConvertTextModel);
+
+  return results;
+}
+
+} // namespace
+
+bool RunMeshFileTests() {
+  const auto results = RunAllTestsInternal();
+  bool all_passed = true;
+
+  for (const auto &result : results) {
+    if (!result.passed) {
+      all_passed = false;
+      std::ostringstream oss;
+      oss << "Test failed: " << result.name;
+      if (!result.message.empty()) {
+        oss << " - " << result.message;
+      }
+      Logger::SetModule("MeshFileTests");
+      Logger::LogError(oss.str());
+    }
+  }
+
+  if (all_passed) {
+    Logger::SetModule("MeshFileTests");
+    Logger::LogInfo("All MeshFile tests passed");
+  }
+
+  return all_passed;
+}
@@ -0,0 +1,370 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+
+constexpr std::uint32_t kUnused = 0xffffffffu;
+
+// Hash and equality over the raw bits of one vertex record.
+struct VertexKey {
+  const std::uint8_t *data;
+};
+
+struct VertexKeyHash {
+  std::size_t words;
+  std::size_t operator()(const VertexKey &key) const {
+    std::uint64_t hash = 14695981039346656037ull; // FNV-1a
+    for (std::size_t i = 0; i < words; ++i) {
+      std::uint32_t bits;
+      std::memcpy(&bits, key.data + i * 4, sizeof(bits));
+      hash = (hash ^ bits) * 1099511628211ull;
+    }
+    return static_cast<std::size_t>(hash);
+  }
+};
+
+struct VertexKeyEqual {
+  std::size_t size;
+  bool operator()(const VertexKey &a, const VertexKey &b) const {
+    return std::memcmp(a.data, b.data, size) == 0;
+  }
+};
+
+const float *PositionOf(const void *vertices, std::size_t vertex_size,
+                        std::uint32_t index) {
+  return reinterpret_cast<const float *>(
+      static_cast<const std::uint8_t *>(vertices) + index * vertex_size);
+}
+
+} // namespace
+
+VertexCacheStatistics AnalyzeVertexCache(const std::uint32_t *indices,
+                                         std::size_t index_count,
+                                         std::size_t vertex_count,
+                                         std::size_t cache_size) {
+  // A vertex is cached while fewer than cache_size misses happened since
+  // its own, which is exactly FIFO replacement.
+  std::vector<std::size_t> timestamps(vertex_count, 0);
+  std::size_t timestamp = cache_size + 1;
+  VertexCacheStatistics statistics;
+  for (std::size_t i = 0; i < index_count; ++i) {
+    std::size_t &cached = timestamps[indices[i]];
+    if (timestamp - cached > cache_size) {
+      cached = timestamp++;
+      ++statistics.vertices_transformed;
+    }
+  }
+
+  std::size_t used = 0;
+  for (const std::size_t cached : timestamps) {
+    used += cached != 0 ? 1 : 0;
+  }
+  if (index_count >= 3) {
+    statistics.acmr = static_cast<float>(statistics.vertices_transformed) /
+                      static_cast<float>(index_count / 3);
+  }
+  if (used > 0) {
+    statistics.atvr = static_cast<float>(statistics.vertices_transformed) /
+                      static_cast<float>(used);
+  }
+  return statistics;
+}
+
+std::size_t DeduplicateVertices(void *vertices, std::size_t vertex_count,
+                                std::size_t vertex_size,
+                                std::vector<std::uint32_t> &indices) {
+  auto *bytes = static_cast<std::uint8_t *>(vertices);
+
+  // Keys point at the records, so compaction waits for the map.
+  std::vector<std::uint32_t> remap(vertex_count);
+  std::uint32_t next = 0;
+  {
+    std::unordered_map<VertexKey, std::uint32_t, VertexKeyHash,
+                       VertexKeyEqual>
+        unique(vertex_count, VertexKeyHash{vertex_size / 4},
+               VertexKeyEqual{vertex_size});
+    for (std::size_t i = 0; i < vertex_count; ++i) {
+      const auto inserted =
+          unique.emplace(VertexKey{bytes + i * vertex_size}, next);
+      next += inserted.second ? 1 : 0;
+      remap[i] = inserted.first->second;
+    }
+  }
+
+  // First occurrences are in increasing order, so each one moves down
+  // over records already consumed.
+  std::uint32_t written = 0;
+  for (std::size_t i = 0; i < vertex_count; ++i) {
+    if (remap[i] == written) {
+      if (written != i) {
+        std::memcpy(bytes + written * vertex_size, bytes + i * vertex_size,
+                    vertex_size);
+      }
+      ++written;
+    }
+  }
+  for (std::uint32_t &index : indices) {
+    index = remap[index];
+  }
+  return next;
+}
+
+void OptimizeVertexCache(std::vector<std::uint32_t> &indices,
+                         std::size_t vertex_count, std::size_t cache_size,
+                         std::vector<std::size_t> *clusters) {
+  if (clusters != nullptr) {
+    clusters->assign(indices.empty() ? 0 : 1, 0);
+  }
+  const std::size_t triangle_count = indices.size() / 3;
+  if (triangle_count == 0) {
+    return;
+  }
+
+  // Vertex -> triangle adjacency, and the live (unemitted) triangle count
+  // of every vertex.
+  std::vector<std::uint32_t> live(vertex_count, 0);
+  for (const std::uint32_t index : indices) {
+    ++live[index];
+  }
+  std::vector<std::uint32_t> first(vertex_count + 1, 0);
+  for (std::size_t v = 0; v < vertex_count; ++v) {
+    first[v + 1] = first[v] + live[v];
+  }
+  std::vector<std::uint32_t> adjacency(triangle_count * 3);
+  {
+    std::vector<std::uint32_t> fill(first.begin(), first.end() - 1);
+    for (std::size_t i = 0; i < triangle_count * 3; ++i) {
+      adjacency[fill[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+    }
+  }
+
+  std::vector<std::size_t> timestamps(vertex_count, 0);
+  std::size_t timestamp = cache_size + 1;
+  std::vector<std::uint8_t> emitted(triangle_count, 0);
+  std::vector<std::uint32_t> dead_end;
+  dead_end.reserve(triangle_count * 3);
+  std::vector<std::uint32_t> candidates;
+  std::vector<std::uint32_t> output;
+  output.reserve(triangle_count * 3);
+  std::size_t cursor = 0;
+
+  // Fan around one vertex at a time, emitting all its live triangles.
+  for (std::uint32_t fan = indices[0];;) {
+    candidates.clear();
+    for (std::uint32_t k = first[fan]; k < first[fan + 1]; ++k) {
+      const std::uint32_t triangle = adjacency[k];
+      if (emitted[triangle]) {
+        continue;
+      }
+      emitted[triangle] = 1;
+      for (std::size_t c = 0; c < 3; ++c) {
+        const std::uint32_t v = indices[triangle * 3 + c];
+        output.push_back(v);
+        dead_end.push_back(v);
+        candidates.push_back(v);
+        --live[v];
+        if (timestamp - timestamps[v] > cache_size) {
+          timestamps[v] = timestamp++;
+        }
+      }
+    }
+
+    // Next fan: the candidate that will still be cached after its
+    // remaining triangles are emitted, preferring the oldest entry.
+    std::uint32_t next = kUnused;
+    std::int64_t best = -1;
+    for (const std::uint32_t v : candidates) {
+      if (live[v] == 0) {
+        continue;
+      }
+      std::int64_t priority = 0;
+      const std::size_t age = timestamp - timestamps[v];
+      if (age + 2 * live[v] <= cache_size) {
+        priority = static_cast<std::int64_t>(age);
+      }
+      if (priority > best) {
+        best = priority;
+        next = v;
+      }
+    }
+    if (next != kUnused) {
+      fan = next;
+      continue;
+    }
+
+    // Dead end: the most recently used vertex with work left, else the
+    // next one in input order. Either starts a new cluster.
+    while (!dead_end.empty() && next == kUnused) {
+      next = live[dead_end.back()] > 0 ? dead_end.back() : kUnused;
+      dead_end.pop_back();
+    }
+    for (; next == kUnused && cursor < vertex_count; ++cursor) {
+      next = live[cursor] > 0 ? static_cast<std::uint32_t>(cursor) : kUnused;
+    }
+    if (next == kUnused) {
+      break;
+    }
+    if (clusters != nullptr) {
+      clusters->push_back(output.size());
+    }
+    fan = next;
+  }
+  indices.swap(output);
+}
+
+void OptimizeOverdraw(std::vector<std::uint32_t> &indices,
+                      const void *vertices, std::size_t vertex_size,
+                      const std::vector<std::size_t> &clusters) {
+  if (clusters.size() < 2) {
+    return;
+  }
+
+  struct Cluster {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    float centroid[3] = {};
+    float normal[3] = {};
+    float sort_key = 0.0f;
+  };
+  std::vector<Cluster> order(clusters.size());
+  float mesh_centroid[3] = {};
+  float mesh_area = 0.0f;
+
+  // Area-weighted centroid and normal of each cluster; the cross product
+  // length is twice the area, which cancels in the averages.
+  for (std::size_t c = 0; c < clusters.size(); ++c) {
+    Cluster &cluster = order[c];
+    cluster.begin = clusters[c];
+    cluster.end = c + 1 < clusters.size() ? clusters[c + 1] : indices.size();
+    float area = 0.0f;
+    for (std::size_t i = cluster.begin; i + 2 < cluster.end; i += 3) {
+      const float *a = PositionOf(vertices, vertex_size, indices[i]);
+      const float *b = PositionOf(vertices, vertex_size, indices[i + 1]);
+      const float *p = PositionOf(vertices, vertex_size, indices[i + 2]);
+      const float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+      const float e2[3] = {p[0] - a[0], p[1] - a[1], p[2] - a[2]};
+      const float n[3] = {e1[1] * e2[2] - e1[2] * e2[1],
+                          e1[2] * e2[0] - e1[0] * e2[2],
+                          e1[0] * e2[1] - e1[1] * e2[0]};
+      const float weight = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      for (int k = 0; k < 3; ++k) {
+        cluster.centroid[k] += (a[k] + b[k] + p[k]) * weight / 3.0f;
+        cluster.normal[k] += n[k];
+      }
+      area += weight;
+    }
+    for (int k = 0; k < 3; ++k) {
+      mesh_centroid[k] += cluster.centroid[k];
+      if (area > 0.0f) {
+        cluster.centroid[k] /= area;
+      }
+    }
+    mesh_area += area;
+  }
+  if (mesh_area <= 0.0f) {
+    return;
+  }
+  for (float &value : mesh_centroid) {
+    value /= mesh_area;
+  }
+
+  // How far the cluster faces out from the centre; with clockwise front
+  // faces the cross product points out of the surface.
+  for (Cluster &cluster : order) {
+    const float *n = cluster.normal;
+    const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (length > 0.0f) {
+      cluster.sort_key = ((cluster.centroid[0] - mesh_centroid[0]) * n[0] +
+                          (cluster.centroid[1] - mesh_centroid[1]) * n[1] +
+                          (cluster.centroid[2] - mesh_centroid[2]) * n[2]) /
+                         length;
+    }
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [](const Cluster &a, const Cluster &b) {
+                     return a.sort_key > b.sort_key;
+                   });
+
+  std::vector<std::uint32_t> output;
+  output.reserve(indices.size());
+  for (const Cluster &cluster : order) {
+    output.insert(output.end(), indices.begin() + cluster.begin,
+                  indices.begin() + cluster.end);
+  }
+  indices.swap(output);
+}
+
+std::size_t OptimizeVertexFetch(void *vertices, std::size_t vertex_count,
+                                std::size_t vertex_size,
+                                std::vector<std::uint32_t> &indices) {
+  std::vector<std::uint32_t> remap(vertex_count, kUnused);
+  std::uint32_t next = 0;
+  for (std::uint32_t &index : indices) {
+    if (remap[index] == kUnused) {
+      remap[index] = next++;
+    }
+    index = remap[index];
+  }
+
+  auto *bytes = static_cast<std::uint8_t *>(vertices);
+  const std::vector<std::uint8_t> source(bytes,
+                                         bytes + vertex_count * vertex_size);
+  for (std::size_t v = 0; v < vertex_count; ++v) {
+    if (remap[v] != kUnused) {
+      std::memcpy(bytes + remap[v] * vertex_size, &source[v * vertex_size],
+                  vertex_size);
+    }
+  }
+  return next;
+}
+
+std::size_t OptimizeMesh(void *vertices, std::size_t vertex_count,
+                         std::size_t vertex_size,
+                         std::vector<std::uint32_t> &indices,
+                         MeshOptimizationReport *report) {
+  if (report != nullptr) {
+    report->vertices_before = vertex_count;
+    report->cache_before =
+        AnalyzeVertexCache(indices.data(), indices.size(), vertex_count);
+  }
+
+  vertex_count =
+      DeduplicateVertices(vertices, vertex_count, vertex_size, indices);
+
+  std::vector<std::size_t> clusters;
+  OptimizeVertexCache(indices, vertex_count, kVertexCacheSize, &clusters);
+
+  // Cluster order costs the reuse across cluster seams; keep it only when
+  // the cache loses little (Sander et al. use a similar threshold).
+  const float tipsify_acmr =
+      AnalyzeVertexCache(indices.data(), indices.size(), vertex_count).acmr;
+  std::vector<std::uint32_t> tipsified = indices;
+  OptimizeOverdraw(indices, vertices, vertex_size, clusters);
+  if (AnalyzeVertexCache(indices.data(), indices.size(), vertex_count).acmr >
+      tipsify_acmr * 1.05f) {
+    indices.swap(tipsified);
+  }
+
+  vertex_count =
+      OptimizeVertexFetch(vertices, vertex_count, vertex_size, indices);
+
+  if (report != nullptr) {
+    report->vertices_after = vertex_count;
+    report->cache_after =
+        AnalyzeVertexCache(indices.data(), indices.size(), vertex_count);
+  }
+  return vertex_count;
+}
+
+MeshOptimizationReport OptimizeMesh(MeshData &mesh) {
+  MeshOptimizationReport report;
+  const std::size_t vertex_count =
+      OptimizeMesh(mesh.vertices.data(), mesh.GetVertexCount(),
+                   mesh.vertex_stride, mesh.indices, &report);
+  mesh.vertices.resize(vertex_count * (mesh.vertex_stride / 4));
+  return report;
+}
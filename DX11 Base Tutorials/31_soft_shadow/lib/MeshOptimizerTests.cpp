@@ -0,0 +1,310 @@
+#include "MeshOptimizerTests.h"
+
+#include "Logger.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+struct GridVertex {
+  float x, y, z;
+};
+
+// cells x cells grid, indexed row by row; every (x, z) vertex is unique.
+void MakeGrid(int cells, std::vector<GridVertex> &vertices,
+              std::vector<std::uint32_t> &indices) {
+  vertices.clear();
+  indices.clear();
+  for (int z = 0; z <= cells; ++z) {
+    for (int x = 0; x <= cells; ++x) {
+      vertices.push_back(
+          {static_cast<float>(x), 0.0f, static_cast<float>(z)});
+    }
+  }
+  const auto at = [cells](int x, int z) {
+    return static_cast<std::uint32_t>(z * (cells + 1) + x);
+  };
+  for (int z = 0; z < cells; ++z) {
+    for (int x = 0; x < cells; ++x) {
+      indices.insert(indices.end(), {at(x, z), at(x, z + 1), at(x + 1, z),
+                                     at(x + 1, z), at(x, z + 1),
+                                     at(x + 1, z + 1)});
+    }
+  }
+}
+
+// Triangles as position triples, rotated so the smallest index leads;
+// sorted, two index buffers over the same vertices then compare equal
+// exactly when they draw the same triangles with the same winding.
+std::vector<std::array<float, 9>>
+CanonicalTriangles(const std::vector<GridVertex> &vertices,
+                   const std::vector<std::uint32_t> &indices) {
+  std::vector<std::array<float, 9>> triangles;
+  for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+    std::uint32_t corner[3] = {indices[i], indices[i + 1], indices[i + 2]};
+    const auto less = [&vertices](std::uint32_t a, std::uint32_t b) {
+      const GridVertex &va = vertices[a];
+      const GridVertex &vb = vertices[b];
+      return std::tie(va.x, va.y, va.z) < std::tie(vb.x, vb.y, vb.z);
+    };
+    std::rotate(corner, std::min_element(corner, corner + 3, less),
+                corner + 3);
+    std::array<float, 9> triangle;
+    for (int c = 0; c < 3; ++c) {
+      triangle[c * 3] = vertices[corner[c]].x;
+      triangle[c * 3 + 1] = vertices[corner[c]].y;
+      triangle[c * 3 + 2] = vertices[corner[c]].z;
+    }
+    triangles.push_back(triangle);
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+bool TestAnalyzeVertexCache(std::string &message) {
+  // The same triangle twice: three misses, then three hits.
+  const std::vector<std::uint32_t> repeated = {0, 1, 2, 0, 1, 2};
+  const VertexCacheStatistics hits =
+      AnalyzeVertexCache(repeated.data(), repeated.size(), 3);
+  if (hits.vertices_transformed != 3 || hits.acmr != 1.5f ||
+      hits.atvr != 1.0f) {
+    message = "repeated triangle statistics wrong";
+    return false;
+  }
+
+  // With a 3-entry FIFO, vertex 0 is evicted by 3, 4 and 5 before reuse.
+  const std::vector<std::uint32_t> evicted = {0, 1, 2, 3, 4, 5, 0, 1, 2};
+  const VertexCacheStatistics misses =
+      AnalyzeVertexCache(evicted.data(), evicted.size(), 6, 3);
+  if (misses.vertices_transformed != 9 || misses.acmr != 3.0f ||
+      misses.atvr != 1.5f) {
+    message = "FIFO eviction not simulated";
+    return false;
+  }
+  return true;
+}
+
+bool TestDeduplicateVertices(std::string &message) {
+  // A quad as an unindexed triangle list: two corners are repeated.
+  std::vector<GridVertex> vertices = {{0, 0, 0}, {0, 0, 1}, {1, 0, 0},
+                                      {1, 0, 0}, {0, 0, 1}, {1, 0, 1}};
+  std::vector<std::uint32_t> indices = {0, 1, 2, 3, 4, 5};
+  const std::size_t count = DeduplicateVertices(
+      vertices.data(), vertices.size(), sizeof(GridVertex), indices);
+  const std::vector<std::uint32_t> expected = {0, 1, 2, 2, 1, 3};
+  if (count != 4 || indices != expected) {
+    message = "duplicates not welded";
+    return false;
+  }
+  if (vertices[3].x != 1.0f || vertices[3].z != 1.0f) {
+    message = "unique vertices not compacted in order";
+    return false;
+  }
+  return true;
+}
+
+bool TestOptimizeVertexCacheImprovesAcmr(std::string &message) {
+  std::vector<GridVertex> vertices;
+  std::vector<std::uint32_t> indices;
+  MakeGrid(64, vertices, indices);
+
+  // Shuffled triangles: the worst realistic input.
+  std::vector<std::array<std::uint32_t, 3>> triangles(indices.size() / 3);
+  for (std::size_t t = 0; t < triangles.size(); ++t) {
+    triangles[t] = {indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2]};
+  }
+  std::shuffle(triangles.begin(), triangles.end(), std::mt19937(7));
+  for (std::size_t t = 0; t < triangles.size(); ++t) {
+    std::copy(triangles[t].begin(), triangles[t].end(),
+              indices.begin() + t * 3);
+  }
+
+  const auto original = CanonicalTriangles(vertices, indices);
+  const float shuffled_acmr =
+      AnalyzeVertexCache(indices.data(), indices.size(), vertices.size())
+          .acmr;
+  std::vector<std::size_t> clusters;
+  OptimizeVertexCache(indices, vertices.size(), kVertexCacheSize, &clusters);
+  const VertexCacheStatistics optimized =
+      AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+  if (CanonicalTriangles(vertices, indices) != original) {
+    message = "triangles or winding changed";
+    return false;
+  }
+  if (shuffled_acmr < 2.0f || optimized.acmr > 0.8f) {
+    message = "ACMR " + std::to_string(shuffled_acmr) + " -> " +
+              std::to_string(optimized.acmr);
+    return false;
+  }
+  if (clusters.empty() || clusters.front() != 0 ||
+      !std::is_sorted(clusters.begin(), clusters.end()) ||
+      clusters.back() >= indices.size() || clusters.back() % 3 != 0) {
+    message = "cluster starts invalid";
+    return false;
+  }
+  return true;
+}
+
+bool TestOptimizeOverdrawOrdersOutwardClustersFirst(std::string &message) {
+  // Two triangles on x = -1 and x = +1, both with +x normals: the one at
+  // +1 faces away from the centre, the one at -1 faces into it.
+  const std::vector<GridVertex> vertices = {{-1, 0, 0}, {-1, 1, 0},
+                                            {-1, 0, 1}, {1, 0, 0},
+                                            {1, 1, 0},  {1, 0, 1}};
+  std::vector<std::uint32_t> indices = {0, 1, 2, 3, 4, 5};
+  OptimizeOverdraw(indices, vertices.data(), sizeof(GridVertex), {0, 3});
+  const std::vector<std::uint32_t> expected = {3, 4, 5, 0, 1, 2};
+  if (indices != expected) {
+    message = "outward cluster not drawn first";
+    return false;
+  }
+  return true;
+}
+
+bool TestOptimizeVertexFetch(std::string &message) {
+  std::vector<GridVertex> vertices = {
+      {0, 0, 0}, {1, 0, 0}, {2, 0, 0}, {3, 0, 0}, {4, 0, 0}};
+  std::vector<std::uint32_t> indices = {4, 2, 0, 0, 2, 3};
+  const std::size_t count = OptimizeVertexFetch(
+      vertices.data(), vertices.size(), sizeof(GridVertex), indices);
+  const std::vector<std::uint32_t> expected = {0, 1, 2, 2, 1, 3};
+  if (count != 4 || indices != expected) {
+    message = "indices not in first-use order";
+    return false;
+  }
+  if (vertices[0].x != 4.0f || vertices[1].x != 2.0f ||
+      vertices[2].x != 0.0f || vertices[3].x != 3.0f) {
+    message = "vertices not moved with their indices";
+    return false;
+  }
+  return true;
+}
+
+bool TestOptimizeMeshData(std::string &message) {
+  // Unindexed text model grid through the converter path.
+  constexpr int kCells = 32;
+  std::vector<GridVertex> grid;
+  std::vector<std::uint32_t> grid_indices;
+  MakeGrid(kCells, grid, grid_indices);
+  std::vector<float> triangle_vertices;
+  for (const std::uint32_t index : grid_indices) {
+    const GridVertex &v = grid[index];
+    triangle_vertices.insert(triangle_vertices.end(),
+                             {v.x, v.y, v.z, v.x / kCells, v.z / kCells,
+                              0.0f, 1.0f, 0.0f});
+  }
+  MeshData mesh;
+  BuildIndexedMesh(triangle_vertices, false, mesh);
+  const MeshOptimizationReport report = OptimizeMesh(mesh);
+
+  const std::size_t unique = (kCells + 1) * (kCells + 1);
+  if (mesh.GetVertexCount() != unique || report.vertices_after != unique ||
+      mesh.indices.size() != grid_indices.size()) {
+    message = "vertex or index count changed";
+    return false;
+  }
+  if (!(report.cache_after.acmr < report.cache_before.acmr) ||
+      report.cache_after.atvr > 1.5f) {
+    message = "cache statistics did not improve";
+    return false;
+  }
+
+  std::vector<GridVertex> positions(mesh.GetVertexCount());
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    positions[i] = {mesh.vertices[i * 8], mesh.vertices[i * 8 + 1],
+                    mesh.vertices[i * 8 + 2]};
+  }
+  if (CanonicalTriangles(positions, mesh.indices) !=
+      CanonicalTriangles(grid, grid_indices)) {
+    message = "geometry changed";
+    return false;
+  }
+  // First-use order: each index is at most one past the largest so far.
+  std::uint32_t next = 0;
+  for (const std::uint32_t index : mesh.indices) {
+    if (index > next) {
+      message = "vertices not in first-use order";
+      return false;
+    }
+    next = (std::max)(next, index + 1);
+  }
+  return true;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(6);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("FIFO cache statistics", TestAnalyzeVertexCache);
+  run("DeduplicateVertices welds and compacts", TestDeduplicateVertices);
+  run("Tipsify lowers ACMR of a shuffled grid",
+      TestOptimizeVertexCacheImprovesAcmr);
+  run("Overdraw order draws outward clusters first",
+      TestOptimizeOverdrawOrdersOutwardClustersFirst);
+  run("Vertex fetch follows first use", TestOptimizeVertexFetch);
+  run("OptimizeMesh keeps the geometry", TestOptimizeMeshData);
+
+  return results;
+}
+
+} // namespace
+
+bool RunMeshOptimizerTests() {
+  const auto results = RunAllTestsInternal();
+  bool all_passed = true;
+
+  for (const auto &result : results) {
+    if (!result.passed) {
+      all_passed = false;
+      std::ostringstream oss;
+      oss << "Test failed: " << result.name;
+      if (!result.message.empty()) {
+        oss << " - " << result.message;
+      }
+      Logger::SetModule("MeshOptimizerTests");
+      Logger::LogError(oss.str());
+    }
+  }
+
+  if (all_passed) {
+    Logger::SetModule("MeshOptimizerTests");
+    Logger::LogInfo("All MeshOptimizer tests passed");
+  }
+
+  return all_passed;
+}
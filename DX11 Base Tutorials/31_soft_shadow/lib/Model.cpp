@@ -3,25 +3,76 @@
 #include "../../CommonFramework2/DirectX11Device.h"
 #include "BoundingVolume.h"
 #include "Interfaces.h"
+#include "JobSystem.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
 #include "ShaderParameter.h"
+#include "TangentFrame.h"
 
 #include <DirectXMath.h>
 #include <algorithm>
-#include <fstream>
+#include <cstring>
+#include <iostream>
 
 using namespace std;
 using namespace DirectX;
 
+namespace {
+
+// Creates immutable vertex and index buffers straight from the given
+// memory, which may be a mapped .mesh file.
+bool CreateMeshBuffers(ID3D11Device *device, const void *vertices,
+                       std::uint64_t vertex_bytes, const void *indices,
+                       std::uint64_t index_bytes,
+                       Microsoft::WRL::ComPtr<ID3D11Buffer> &vertex_buffer,
+                       Microsoft::WRL::ComPtr<ID3D11Buffer> &index_buffer) {
+  // Use (max)() to avoid Windows.h max macro conflict
+  constexpr UINT MAX_BUFFER_SIZE = (std::numeric_limits<UINT>::max)();
+  if (vertex_bytes > MAX_BUFFER_SIZE || index_bytes > MAX_BUFFER_SIZE) {
+    std::cerr << "Error: Mesh too large for a single buffer" << std::endl;
+    return false;
+  }
+
+  D3D11_BUFFER_DESC vertexBufferDesc = {};
+  vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+  vertexBufferDesc.ByteWidth = static_cast<UINT>(vertex_bytes);
+  vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+  D3D11_SUBRESOURCE_DATA vertexData = {};
+  vertexData.pSysMem = vertices;
+
+  HRESULT result =
+      device->CreateBuffer(&vertexBufferDesc, &vertexData, &vertex_buffer);
+  if (FAILED(result)) {
+    return false;
+  }
+
+  D3D11_BUFFER_DESC indexBufferDesc = {};
+  indexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+  indexBufferDesc.ByteWidth = static_cast<UINT>(index_bytes);
+  indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+
+  D3D11_SUBRESOURCE_DATA indexData = {};
+  indexData.pSysMem = indices;
+
+  result = device->CreateBuffer(&indexBufferDesc, &indexData, &index_buffer);
+  return SUCCEEDED(result);
+}
+
+} // namespace
+
 Model::~Model() { Shutdown(); }
 
 bool Model::Initialize(const std::string &modelFilename,
                        const std::wstring &textureFilename,
                        ID3D11Device *device) {
-  if (!LoadModel(modelFilename) || !InitializeBuffers(device) ||
-      !LoadTexture(textureFilename, device)) {
+  // A converted .mesh file is used as-is; the text model is the fallback.
+  const std::string mesh_path = FindConvertedMesh(modelFilename);
+  const bool loaded = !mesh_path.empty() && LoadMesh(mesh_path, device);
+  if (!loaded && (!LoadModel(modelFilename) || !InitializeBuffers(device))) {
     return false;
   }
-  return true;
+  return LoadTexture(textureFilename, device);
 }
 
 void Model::Shutdown() {
@@ -30,7 +81,7 @@ void Model::Shutdown() {
 }
 
 void Model::Render(const IShader &shader,
-                   const ShaderParameterContainer &parameterContainer,
+                   const LayeredParameterView &parameterContainer,
                    ID3D11DeviceContext *deviceContext) const {
 
   RenderBuffers(deviceContext);
@@ -43,10 +94,11 @@ void Model::SetParameterCallback(ShaderParameterCallback callback) {
   // Derived classes can override if needed
 }
 
-ShaderParameterCallback Model::GetParameterCallback() const {
+const ShaderParameterCallback &Model::GetParameterCallback() const {
   // Return empty callback - Model uses default parameter behavior
   // This is safe and allows objects to render without custom parameter logic
-  return nullptr;
+  static const ShaderParameterCallback empty_callback;
+  return empty_callback;
 }
 
 ID3D11ShaderResourceView *Model::GetTexture() const {
@@ -54,20 +106,8 @@ ID3D11ShaderResourceView *Model::GetTexture() const {
 }
 
 bool Model::InitializeBuffers(ID3D11Device *device) {
-  // Check for overflow in buffer size calculation
-  // Use (max)() to avoid Windows.h max macro conflict
-  constexpr UINT MAX_BUFFER_SIZE = (std::numeric_limits<UINT>::max)();
-  if (vertex_count_ > MAX_BUFFER_SIZE / sizeof(Vertex)) {
-    std::cerr << "Error: Vertex count too large, would overflow buffer size calculation" << std::endl;
-    return false;
-  }
-  if (index_count_ > MAX_BUFFER_SIZE / sizeof(unsigned long)) {
-    std::cerr << "Error: Index count too large, would overflow buffer size calculation" << std::endl;
-    return false;
-  }
-
   std::vector<Vertex> vertices(vertex_count_);
-  std::vector<unsigned long> indices(index_count_);
+  std::vector<std::uint32_t> indices(index_count_);
 
   for (int i = 0; i < vertex_count_; i++) {
     vertices[i].position = XMFLOAT3(model_[i].x, model_[i].y, model_[i].z);
@@ -76,33 +116,46 @@ bool Model::InitializeBuffers(ID3D11Device *device) {
     indices[i] = i;
   }
 
-  D3D11_BUFFER_DESC vertexBufferDesc = {};
-  vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-  vertexBufferDesc.ByteWidth = static_cast<UINT>(sizeof(Vertex) * vertex_count_);
-  vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+  // Text models are unindexed; weld and reorder them as the converter would.
+  vertex_count_ = static_cast<int>(
+      OptimizeMesh(vertices.data(), vertices.size(), sizeof(Vertex), indices));
 
-  D3D11_SUBRESOURCE_DATA vertexData = {};
-  vertexData.pSysMem = vertices.data();
+  vertex_stride_ = sizeof(Vertex);
+  index_format_ = DXGI_FORMAT_R32_UINT;
+  return CreateMeshBuffers(
+      device, vertices.data(), std::uint64_t{sizeof(Vertex)} * vertex_count_,
+      indices.data(), std::uint64_t{sizeof(std::uint32_t)} * index_count_,
+      vertex_buffer_, index_buffer_);
+}
 
-  HRESULT result =
-      device->CreateBuffer(&vertexBufferDesc, &vertexData, &vertex_buffer_);
-  if (FAILED(result)) {
+bool Model::LoadMesh(const std::string &filename, ID3D11Device *device) {
+  MeshFile mesh;
+  if (!mesh.Open(filename)) {
     return false;
   }
-
-  D3D11_BUFFER_DESC indexBufferDesc = {};
-  indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-  indexBufferDesc.ByteWidth = static_cast<UINT>(sizeof(unsigned long) * index_count_);
-  indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-
-  D3D11_SUBRESOURCE_DATA indexData = {};
-  indexData.pSysMem = indices.data();
-
-  result = device->CreateBuffer(&indexBufferDesc, &indexData, &index_buffer_);
-  if (FAILED(result)) {
+  // Extra attributes (tangent frames) after the prefix are skipped by the
+  // stride.
+  if (!mesh.HasLayoutPrefix(GetTextModelLayout())) {
+    std::cerr << "Error: Mesh layout lacks position/texcoord/normal: "
+              << filename << std::endl;
+    return false;
+  }
+  if (!CreateMeshBuffers(
+          device, mesh.GetVertices(),
+          std::uint64_t{mesh.GetVertexStride()} * mesh.GetVertexCount(),
+          mesh.GetIndices(),
+          std::uint64_t{mesh.GetIndexSize()} * mesh.GetIndexCount(),
+          vertex_buffer_, index_buffer_)) {
     return false;
   }
 
+  vertex_count_ = static_cast<int>(mesh.GetVertexCount());
+  index_count_ = static_cast<int>(mesh.GetIndexCount());
+  vertex_stride_ = mesh.GetVertexStride();
+  index_format_ = mesh.GetIndexSize() == 2 ? DXGI_FORMAT_R16_UINT
+                                           : DXGI_FORMAT_R32_UINT;
+  bounding_volume_ = mesh.GetBounds();
+  world_bounds_dirty_ = true;
   return true;
 }
 
@@ -113,12 +166,12 @@ void Model::ShutdownBuffers() {
 
 void Model::RenderBuffers(ID3D11DeviceContext *deviceContext) const {
 
-  UINT stride = sizeof(Vertex);
+  UINT stride = vertex_stride_;
   UINT offset = 0;
 
   deviceContext->IASetVertexBuffers(0, 1, vertex_buffer_.GetAddressOf(),
                                     &stride, &offset);
-  deviceContext->IASetIndexBuffer(index_buffer_.Get(), DXGI_FORMAT_R32_UINT, 0);
+  deviceContext->IASetIndexBuffer(index_buffer_.Get(), index_format_, 0);
   deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 }
 
@@ -128,70 +181,18 @@ bool Model::LoadTexture(const std::wstring &filename, ID3D11Device *device) {
 }
 
 bool Model::LoadModel(const std::string &filename) {
-  std::ifstream fin(filename);
-  if (!fin) {
+  // Text models: ParseTextModel() reads the mapped file in one pass.
+  std::vector<float> vertices;
+  if (!LoadTextModel(filename, vertices)) {
     return false;
   }
 
-  char input;
-  // Add safety limit to prevent infinite loops on malformed files
-  constexpr int MAX_PARSE_ITERATIONS = 10000;
-  int iterations = 0;
-
-  // Search for first delimiter with bounds checking
-  while (fin.get(input) && input != ':' && ++iterations < MAX_PARSE_ITERATIONS) {
-    // Continue searching
-  }
-  
-  if (iterations >= MAX_PARSE_ITERATIONS || !fin) {
-    std::cerr << "Error: Model file format error - first delimiter not found or file corrupted: " 
-              << filename << std::endl;
-    return false;
-  }
-
-  fin >> vertex_count_;
-  
-  // Validate vertex count to prevent excessive memory allocation or overflow
-  constexpr int MAX_VERTEX_COUNT = 1000000; // Reasonable maximum
-  if (vertex_count_ <= 0 || vertex_count_ > MAX_VERTEX_COUNT) {
-    std::cerr << "Error: Invalid vertex count (" << vertex_count_ 
-              << ") in model file: " << filename << std::endl;
-    return false;
-  }
-  
+  static_assert(sizeof(ModelType) == 8 * sizeof(float),
+                "ModelType matches the text model's vertex");
+  vertex_count_ = static_cast<int>(vertices.size() / 8);
   index_count_ = vertex_count_;
   model_.resize(vertex_count_);
-
-  // Search for second delimiter with bounds checking
-  iterations = 0;
-  while (fin.get(input) && input != ':' && ++iterations < MAX_PARSE_ITERATIONS) {
-    // Continue searching
-  }
-  
-  if (iterations >= MAX_PARSE_ITERATIONS || !fin) {
-    std::cerr << "Error: Model file format error - second delimiter not found: " 
-              << filename << std::endl;
-    return false;
-  }
-  
-  fin.get(input);
-  fin.get(input);
-
-  // Read vertex data with stream state checking
-  for (int i = 0; i < vertex_count_; i++) {
-    fin >> model_[i].x >> model_[i].y >> model_[i].z;
-    fin >> model_[i].tu >> model_[i].tv;
-    fin >> model_[i].nx >> model_[i].ny >> model_[i].nz;
-    
-    // Check for read errors after each vertex
-    if (fin.fail()) {
-      std::cerr << "Error: Failed to read vertex data at index " << i 
-                << " in model file: " << filename << std::endl;
-      return false;
-    }
-  }
-
-  fin.close();
+  std::memcpy(model_.data(), vertices.data(), vertices.size() * sizeof(float));
 
   // Calculate bounding volume
   CalculateBoundingVolume();
@@ -211,6 +212,7 @@ void Model::CalculateBoundingVolume() {
   }
 
   bounding_volume_.CalculateFromVertices(positions.data(), positions.size());
+  world_bounds_dirty_ = true;
 }
 
 const BoundingVolume &Model::GetLocalBoundingVolume() const {
@@ -218,7 +220,11 @@ const BoundingVolume &Model::GetLocalBoundingVolume() const {
 }
 
 BoundingVolume Model::GetWorldBoundingVolume() const {
-  return bounding_volume_.Transform(world_matrix_);
+  if (world_bounds_dirty_) {
+    world_bounding_volume_ = bounding_volume_.Transform(world_matrix_);
+    world_bounds_dirty_ = false;
+  }
+  return world_bounding_volume_;
 }
 
 void Model::ReleaseModel() { model_.clear(); }
@@ -229,17 +235,19 @@ bool PBRModel::Initialize(const char *modelFilename,
                           const string &textureFilename3,
                           ID3D11Device *device) {
 
-  auto result = LoadModel(modelFilename);
+  // A converted .mesh file with tangent frames is used as-is.
+  const std::string mesh_path = FindConvertedMesh(modelFilename);
+  auto result = !mesh_path.empty() && LoadMesh(mesh_path, device);
   if (!result) {
-    return false;
-  }
-
-  // Calculate the tangent and binormal vectors for the model.
-  CalculateModelVectors();
+    result = LoadModel(modelFilename);
+    if (!result) {
+      return false;
+    }
 
-  result = InitializeBuffers(device);
-  if (!result) {
-    return false;
+    result = InitializeBuffers(device);
+    if (!result) {
+      return false;
+    }
   }
 
   result = LoadTextures(textureFilename1, textureFilename2, textureFilename3,
@@ -254,7 +262,7 @@ bool PBRModel::Initialize(const char *modelFilename,
 void PBRModel::Shutdown() { ReleaseTextures(); }
 
 void PBRModel::Render(const IShader &shader,
-                      const ShaderParameterContainer &parameterContainer,
+                      const LayeredParameterView &parameterContainer,
                       ID3D11DeviceContext *deviceContext) const {
 
   RenderBuffers(deviceContext);
@@ -268,71 +276,60 @@ ID3D11ShaderResourceView *PBRModel::GetTexture(int index) {
 
 bool PBRModel::InitializeBuffers(ID3D11Device *device) {
 
-  // Check for overflow in buffer size calculation
-  // Use (max)() to avoid Windows.h max macro conflict
-  constexpr UINT MAX_BUFFER_SIZE = (std::numeric_limits<UINT>::max)();
-  if (vertex_count_ > MAX_BUFFER_SIZE / sizeof(VertexType)) {
-    std::cerr << "Error: PBR vertex count too large, would overflow buffer size calculation" << std::endl;
-    return false;
-  }
-  if (index_count_ > MAX_BUFFER_SIZE / sizeof(unsigned long)) {
-    std::cerr << "Error: PBR index count too large, would overflow buffer size calculation" << std::endl;
-    return false;
-  }
-
-  D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
-  D3D11_SUBRESOURCE_DATA vertexData, indexData;
-
   // Use std::vector for automatic memory management and exception safety
   std::vector<VertexType> vertices(vertex_count_);
-  std::vector<unsigned long> indices(index_count_);
+  std::vector<std::uint32_t> indices(index_count_);
 
   for (int i = 0; i < vertex_count_; i++) {
     vertices[i].position = XMFLOAT3(model_[i].x, model_[i].y, model_[i].z);
     vertices[i].texture = XMFLOAT2(model_[i].tu, model_[i].tv);
     vertices[i].normal = XMFLOAT3(model_[i].nx, model_[i].ny, model_[i].nz);
-    vertices[i].tangent = XMFLOAT3(model_[i].tx, model_[i].ty, model_[i].tz);
-    vertices[i].binormal = XMFLOAT3(model_[i].bx, model_[i].by, model_[i].bz);
+    vertices[i].tangent = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    vertices[i].binormal = XMFLOAT3(0.0f, 0.0f, 0.0f);
 
     indices[i] = i;
   }
 
-  vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-  vertexBufferDesc.ByteWidth = static_cast<UINT>(sizeof(VertexType) * vertex_count_);
-  vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-  vertexBufferDesc.CPUAccessFlags = 0;
-  vertexBufferDesc.MiscFlags = 0;
-  vertexBufferDesc.StructureByteStride = 0;
-
-  vertexData.pSysMem = vertices.data();
-  vertexData.SysMemPitch = 0;
-  vertexData.SysMemSlicePitch = 0;
+  // Weld first so every vertex averages the frames of all faces sharing it.
+  vertex_count_ = static_cast<int>(OptimizeMesh(
+      vertices.data(), vertices.size(), sizeof(VertexType), indices));
+  static_assert(sizeof(VertexType) == 14 * sizeof(float),
+                "VertexType is the tangent frame model layout");
+  const auto job_system = CreateTangentFrameJobSystem(indices.size() / 3);
+  GenerateTangentFrames(reinterpret_cast<float *>(vertices.data()),
+                        vertex_count_, 14, indices, job_system.get());
+
+  index_format_ = DXGI_FORMAT_R32_UINT;
+  return CreateMeshBuffers(
+      device, vertices.data(),
+      std::uint64_t{sizeof(VertexType)} * vertex_count_, indices.data(),
+      std::uint64_t{sizeof(std::uint32_t)} * index_count_, vertex_buffer_,
+      index_buffer_);
+}
 
-  auto result =
-      device->CreateBuffer(&vertexBufferDesc, &vertexData, &vertex_buffer_);
-  if (FAILED(result)) {
+bool PBRModel::LoadMesh(const std::string &filename, ID3D11Device *device) {
+  MeshFile mesh;
+  if (!mesh.Open(filename)) {
     return false;
   }
-
-  indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-  indexBufferDesc.ByteWidth = static_cast<UINT>(sizeof(unsigned long) * index_count_);
-  indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-  indexBufferDesc.CPUAccessFlags = 0;
-  indexBufferDesc.MiscFlags = 0;
-  indexBufferDesc.StructureByteStride = 0;
-
-  indexData.pSysMem = indices.data();
-  indexData.SysMemPitch = 0;
-  indexData.SysMemSlicePitch = 0;
-
-  result = device->CreateBuffer(&indexBufferDesc, &indexData, &index_buffer_);
-  if (FAILED(result)) {
+  if (!mesh.HasLayoutPrefix(GetTangentFrameModelLayout()) ||
+      mesh.GetVertexStride() != sizeof(VertexType)) {
+    // Converted without --tangents; the text model computes them.
+    return false;
+  }
+  if (!CreateMeshBuffers(
+          device, mesh.GetVertices(),
+          std::uint64_t{sizeof(VertexType)} * mesh.GetVertexCount(),
+          mesh.GetIndices(),
+          std::uint64_t{mesh.GetIndexSize()} * mesh.GetIndexCount(),
+          vertex_buffer_, index_buffer_)) {
     return false;
   }
 
-  // No need to manually delete - std::vector handles cleanup automatically
-  // Memory is exception-safe and will be freed even if an exception is thrown
-
+  vertex_count_ = static_cast<int>(mesh.GetVertexCount());
+  index_count_ = static_cast<int>(mesh.GetIndexCount());
+  index_format_ = mesh.GetIndexSize() == 2 ? DXGI_FORMAT_R16_UINT
+                                           : DXGI_FORMAT_R32_UINT;
   return true;
 }
 
@@ -341,10 +338,11 @@ void PBRModel::SetParameterCallback(ShaderParameterCallback callback) {
   // Derived classes can override if needed
 }
 
-ShaderParameterCallback PBRModel::GetParameterCallback() const {
+const ShaderParameterCallback &PBRModel::GetParameterCallback() const {
   // Return empty callback - PBRModel uses default parameter behavior
   // This is safe and allows objects to render without custom parameter logic
-  return nullptr;
+  static const ShaderParameterCallback empty_callback;
+  return empty_callback;
 }
 
 void PBRModel::RenderBuffers(ID3D11DeviceContext *deviceContext) const {
@@ -355,7 +353,7 @@ void PBRModel::RenderBuffers(ID3D11DeviceContext *deviceContext) const {
   deviceContext->IASetVertexBuffers(0, 1, vertex_buffer_.GetAddressOf(),
                                     &stride, &offset);
 
-  deviceContext->IASetIndexBuffer(index_buffer_.Get(), DXGI_FORMAT_R32_UINT, 0);
+  deviceContext->IASetIndexBuffer(index_buffer_.Get(), index_format_, 0);
 
   deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 }
@@ -386,199 +384,21 @@ bool PBRModel::LoadTextures(const string &filename1, const string &filename2,
 void PBRModel::ReleaseTextures() { textures_.reset(); }
 
 bool PBRModel::LoadModel(const char *filename) {
-  ifstream fin;
-  char input;
-
-  fin.open(filename);
-
-  // If it could not open the file then exit.
-  if (fin.fail()) {
-    return false;
-  }
-
-  // Add safety limit to prevent infinite loops on malformed files
-  constexpr int MAX_PARSE_ITERATIONS = 10000;
-  int iterations = 0;
-
-  // Read up to the value of vertex count with bounds checking
-  while (fin.get(input) && input != ':' && ++iterations < MAX_PARSE_ITERATIONS) {
-    // Continue searching
-  }
-
-  if (iterations >= MAX_PARSE_ITERATIONS || !fin) {
-    std::cerr << "Error: PBR model file format error - first delimiter not found: " 
-              << filename << std::endl;
+  // Text models: ParseTextModel() reads the mapped file in one pass.
+  std::vector<float> vertices;
+  if (!LoadTextModel(filename, vertices)) {
     return false;
   }
 
-  // Read in the vertex count.
-  fin >> vertex_count_;
-
-  // Validate vertex count to prevent excessive memory allocation or overflow
-  constexpr int MAX_VERTEX_COUNT = 1000000; // Reasonable maximum
-  if (vertex_count_ <= 0 || vertex_count_ > MAX_VERTEX_COUNT) {
-    std::cerr << "Error: Invalid vertex count (" << vertex_count_ 
-              << ") in PBR model file: " << filename << std::endl;
-    return false;
-  }
+  vertex_count_ = static_cast<int>(vertices.size() / 8);
 
   // Set the number of indices to be the same as the vertex count.
   index_count_ = vertex_count_;
 
-  // Create the model using the vertex count that was read in.
+  static_assert(sizeof(ModelType) == 8 * sizeof(float),
+                "ModelType matches the text model's vertex");
   model_.resize(vertex_count_);
-
-  // Read up to the beginning of the data with bounds checking
-  iterations = 0;
-  while (fin.get(input) && input != ':' && ++iterations < MAX_PARSE_ITERATIONS) {
-    // Continue searching
-  }
-
-  if (iterations >= MAX_PARSE_ITERATIONS || !fin) {
-    std::cerr << "Error: PBR model file format error - second delimiter not found: " 
-              << filename << std::endl;
-    return false;
-  }
-
-  fin.get(input);
-  fin.get(input);
-
-  // Read in the vertex data with stream state checking
-  for (int i = 0; i < vertex_count_; i++) {
-    fin >> model_[i].x >> model_[i].y >> model_[i].z;
-    fin >> model_[i].tu >> model_[i].tv;
-    fin >> model_[i].nx >> model_[i].ny >> model_[i].nz;
-
-    // Check for read errors after each vertex
-    if (fin.fail()) {
-      std::cerr << "Error: Failed to read vertex data at index " << i 
-                << " in PBR model file: " << filename << std::endl;
-      return false;
-    }
-  }
-
-  // Close the model file.
-  fin.close();
+  std::memcpy(model_.data(), vertices.data(), vertices.size() * sizeof(float));
 
   return true;
 }
-
-void PBRModel::CalculateModelVectors() {
-
-  TempVertexType vertex1, vertex2, vertex3;
-  VectorType tangent, binormal;
-
-  // Calculate the number of faces in the model.
-  auto faceCount = vertex_count_ / 3;
-
-  // Initialize the index to the model data.
-  auto index = 0;
-
-  // Go through all the faces and calculate the the tangent and binormal
-  // vectors.
-  for (int i = 0; i < faceCount; i++) {
-    // Get the three vertices for this face from the model.
-    vertex1.x = model_[index].x;
-    vertex1.y = model_[index].y;
-    vertex1.z = model_[index].z;
-    vertex1.tu = model_[index].tu;
-    vertex1.tv = model_[index].tv;
-    index++;
-
-    vertex2.x = model_[index].x;
-    vertex2.y = model_[index].y;
-    vertex2.z = model_[index].z;
-    vertex2.tu = model_[index].tu;
-    vertex2.tv = model_[index].tv;
-    index++;
-
-    vertex3.x = model_[index].x;
-    vertex3.y = model_[index].y;
-    vertex3.z = model_[index].z;
-    vertex3.tu = model_[index].tu;
-    vertex3.tv = model_[index].tv;
-    index++;
-
-    // Calculate the tangent and binormal of that face.
-    CalculateTangentBinormal(vertex1, vertex2, vertex3, tangent, binormal);
-
-    // Store the tangent and binormal for this face back in the model structure.
-    model_[index - 1].tx = tangent.x;
-    model_[index - 1].ty = tangent.y;
-    model_[index - 1].tz = tangent.z;
-    model_[index - 1].bx = binormal.x;
-    model_[index - 1].by = binormal.y;
-    model_[index - 1].bz = binormal.z;
-
-    model_[index - 2].tx = tangent.x;
-    model_[index - 2].ty = tangent.y;
-    model_[index - 2].tz = tangent.z;
-    model_[index - 2].bx = binormal.x;
-    model_[index - 2].by = binormal.y;
-    model_[index - 2].bz = binormal.z;
-
-    model_[index - 3].tx = tangent.x;
-    model_[index - 3].ty = tangent.y;
-    model_[index - 3].tz = tangent.z;
-    model_[index - 3].bx = binormal.x;
-    model_[index - 3].by = binormal.y;
-    model_[index - 3].bz = binormal.z;
-  }
-}
-
-void PBRModel::CalculateTangentBinormal(TempVertexType vertex1,
-                                        TempVertexType vertex2,
-                                        TempVertexType vertex3,
-                                        VectorType &tangent,
-                                        VectorType &binormal) {
-
-  float vector1[3], vector2[3];
-  float tuVector[2], tvVector[2];
-
-  // Calculate the two vectors for this face.
-  vector1[0] = vertex2.x - vertex1.x;
-  vector1[1] = vertex2.y - vertex1.y;
-  vector1[2] = vertex2.z - vertex1.z;
-
-  vector2[0] = vertex3.x - vertex1.x;
-  vector2[1] = vertex3.y - vertex1.y;
-  vector2[2] = vertex3.z - vertex1.z;
-
-  // Calculate the tu and tv texture space vectors.
-  tuVector[0] = vertex2.tu - vertex1.tu;
-  tvVector[0] = vertex2.tv - vertex1.tv;
-
-  tuVector[1] = vertex3.tu - vertex1.tu;
-  tvVector[1] = vertex3.tv - vertex1.tv;
-
-  // Calculate the denominator of the tangent/binormal equation.
-  auto den = 1.0f / (tuVector[0] * tvVector[1] - tuVector[1] * tvVector[0]);
-
-  // Calculate the cross products and multiply by the coefficient to get the
-  // tangent and binormal.
-  tangent.x = (tvVector[1] * vector1[0] - tvVector[0] * vector2[0]) * den;
-  tangent.y = (tvVector[1] * vector1[1] - tvVector[0] * vector2[1]) * den;
-  tangent.z = (tvVector[1] * vector1[2] - tvVector[0] * vector2[2]) * den;
-
-  binormal.x = (tuVector[0] * vector2[0] - tuVector[1] * vector1[0]) * den;
-  binormal.y = (tuVector[0] * vector2[1] - tuVector[1] * vector1[1]) * den;
-  binormal.z = (tuVector[0] * vector2[2] - tuVector[1] * vector1[2]) * den;
-
-  // Calculate the length of this normal.
-  auto length = sqrt((tangent.x * tangent.x) + (tangent.y * tangent.y) +
-                     (tangent.z * tangent.z));
-
-  // Normalize the normal and then store it
-  tangent.x = tangent.x / length;
-  tangent.y = tangent.y / length;
-  tangent.z = tangent.z / length;
-
-  // Calculate the length of this normal.
-  length = sqrt((binormal.x * binormal.x) + (binormal.y * binormal.y) +
-                (binormal.z * binormal.z));
-
-  // Normalize the normal and then store it
-  binormal.x = binormal.x / length;
-  binormal.y = binormal.y / length;
-  binormal.z = binormal.z / length;
-}
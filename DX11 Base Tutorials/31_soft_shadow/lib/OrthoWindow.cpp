@@ -20,18 +20,20 @@ bool OrthoWindow::Initialize(int windowWidth, int windowHeight) {
 void OrthoWindow::Shutdown() { ShutdownBuffers(); }
 
 void OrthoWindow::Render(const IShader &shader,
-                         const ShaderParameterContainer &parameterContainer,
+                         const LayeredParameterView &parameterContainer,
                          ID3D11DeviceContext *deviceContext) const {
 
-  RenderBuffers();
+  RenderBuffers(deviceContext);
 
   shader.Render(GetIndexCount(), parameterContainer, deviceContext);
 }
 
 void OrthoWindow::SetParameterCallback(ShaderParameterCallback callback) {}
 
-ShaderParameterCallback OrthoWindow::GetParameterCallback() const {
-  return [this](ShaderParameterContainer &params) { assert(0); };
+const ShaderParameterCallback &OrthoWindow::GetParameterCallback() const {
+  static const ShaderParameterCallback unexpected_callback =
+      [](ShaderParameterContainer &params) { assert(0); };
+  return unexpected_callback;
 }
 
 int OrthoWindow::GetIndexCount() const { return index_count_; }
@@ -151,14 +153,11 @@ void OrthoWindow::ShutdownBuffers() {
   }
 }
 
-void OrthoWindow::RenderBuffers() const {
+void OrthoWindow::RenderBuffers(ID3D11DeviceContext *device_context) const {
 
   unsigned int stride = sizeof(VertexType);
   unsigned int offset = 0;
 
-  auto device_context =
-      DirectX11Device::GetD3d11DeviceInstance()->GetDeviceContext();
-
   device_context->IASetVertexBuffers(0, 1, vertex_buffer_.GetAddressOf(),
                                      &stride, &offset);
 
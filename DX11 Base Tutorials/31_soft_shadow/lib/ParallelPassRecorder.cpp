@@ -0,0 +1,121 @@
+#include "ParallelPassRecorder.h"
+
+#include "JobSystem.h"
+
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ElapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+} // namespace
+
+double FrameRecordTiming::GetTotalPassMs() const {
+  double total = 0.0;
+  for (const auto &pass : passes) {
+    total += pass.record_ms + pass.submit_ms;
+  }
+  return total;
+}
+
+std::string FrameRecordTiming::Describe() const {
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(3);
+  for (const auto &pass : passes) {
+    oss << "  " << std::left << std::setw(22) << pass.name << std::right
+        << (pass.deferred ? " deferred" : " immediate") << " worker "
+        << pass.worker << " | record " << pass.record_ms << " ms | submit "
+        << pass.submit_ms << " ms\n";
+  }
+  oss << "  frame " << frame_ms << " ms (serial pass time "
+      << GetTotalPassMs() << " ms)\n";
+  return oss.str();
+}
+
+FrameRecordTiming
+ParallelPassRecorder::Run(const std::vector<std::string> &names,
+                          const std::vector<bool> &deferred,
+                          IPassCommandBackend &backend) {
+  const auto frame_start = Clock::now();
+  const std::size_t pass_count = names.size();
+
+  FrameRecordTiming timing;
+  timing.passes.resize(pass_count);
+  for (std::size_t i = 0; i < pass_count; ++i) {
+    timing.passes[i].name = names[i];
+    timing.passes[i].deferred = job_system_ != nullptr && deferred[i];
+  }
+
+  // One counter per pass so submission can wait on exactly that pass.
+  std::unique_ptr<JobCounter[]> recorded(new JobCounter[pass_count]);
+  std::vector<std::exception_ptr> failures(pass_count);
+  if (job_system_ != nullptr) {
+    for (std::size_t i = 0; i < pass_count; ++i) {
+      if (!timing.passes[i].deferred) {
+        continue;
+      }
+      job_system_->Submit(
+          [&backend, &timing, &failures, i]() {
+            const auto start = Clock::now();
+            try {
+              backend.Record(i, i);
+            } catch (...) {
+              failures[i] = std::current_exception();
+            }
+            timing.passes[i].record_ms = ElapsedMs(start);
+            timing.passes[i].worker = JobSystem::GetCurrentWorkerIndex();
+          },
+          recorded[i]);
+    }
+  }
+
+  std::exception_ptr failure;
+  for (std::size_t i = 0; i < pass_count && !failure; ++i) {
+    auto &pass = timing.passes[i];
+    if (!pass.deferred) {
+      const auto start = Clock::now();
+      try {
+        backend.ExecuteImmediate(i);
+      } catch (...) {
+        failure = std::current_exception();
+      }
+      pass.record_ms = ElapsedMs(start);
+      continue;
+    }
+
+    job_system_->Wait(recorded[i]);
+    if (failures[i]) {
+      failure = failures[i];
+      break;
+    }
+    const auto start = Clock::now();
+    try {
+      backend.Submit(i, i);
+    } catch (...) {
+      failure = std::current_exception();
+    }
+    pass.submit_ms = ElapsedMs(start);
+  }
+
+  // Jobs reference locals; never leave while any is still queued or running.
+  if (job_system_ != nullptr) {
+    for (std::size_t i = 0; i < pass_count; ++i) {
+      job_system_->Wait(recorded[i]);
+    }
+  }
+  if (failure) {
+    std::rethrow_exception(failure);
+  }
+
+  timing.frame_ms = ElapsedMs(frame_start);
+  return timing;
+}
@@ -0,0 +1,312 @@
+#include "ParallelPassRecorderTests.h"
+
+#include "JobSystem.h"
+#include "Logger.h"
+#include "ParallelPassRecorder.h"
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+// Stands in for the deferred-context backend: "recording" sleeps for a
+// while on the worker, submission and immediate execution are logged in the
+// order they happen on the calling thread.
+class MockBackend : public IPassCommandBackend {
+public:
+  explicit MockBackend(std::size_t pass_count)
+      : recorded_(pass_count, false), record_threads_(pass_count) {}
+
+  void Record(std::size_t pass, std::size_t slot) override {
+    if (pass != slot) {
+      throw std::logic_error("slot does not match pass");
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(record_sleep_ms));
+    if (pass == failing_pass) {
+      throw std::runtime_error("record failed");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    recorded_[pass] = true;
+    record_threads_[pass] = std::this_thread::get_id();
+  }
+
+  void Submit(std::size_t pass, std::size_t) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!recorded_[pass]) {
+      throw std::logic_error("submitted before recording finished");
+    }
+    events_.push_back("S" + std::to_string(pass));
+  }
+
+  void ExecuteImmediate(std::size_t pass) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.push_back("I" + std::to_string(pass));
+  }
+
+  std::vector<std::string> GetEvents() const { return events_; }
+
+  std::size_t CountRecordThreads() const {
+    std::set<std::thread::id> threads;
+    for (std::size_t i = 0; i < record_threads_.size(); ++i) {
+      if (recorded_[i]) {
+        threads.insert(record_threads_[i]);
+      }
+    }
+    return threads.size();
+  }
+
+  int record_sleep_ms = 5;
+
+  std::size_t failing_pass = static_cast<std::size_t>(-1);
+
+private:
+  mutable std::mutex mutex_;
+  std::vector<bool> recorded_;
+  std::vector<std::thread::id> record_threads_;
+  std::vector<std::string> events_;
+};
+
+std::vector<std::string> MakeNames(std::size_t count) {
+  std::vector<std::string> names;
+  for (std::size_t i = 0; i < count; ++i) {
+    names.push_back("Pass" + std::to_string(i));
+  }
+  return names;
+}
+
+bool TestJobSystemRunsEveryJob(std::string &message) {
+  JobSystem jobs(3);
+  std::atomic<int> sum{0};
+  JobCounter counter;
+  for (int i = 1; i <= 100; ++i) {
+    jobs.Submit([&sum, i]() { sum.fetch_add(i); }, counter);
+  }
+  jobs.Wait(counter);
+  if (!counter.IsDone() || sum.load() != 5050) {
+    message = "sum " + std::to_string(sum.load()) + ", expected 5050";
+    return false;
+  }
+  return true;
+}
+
+bool TestWaitHelpsWithoutWorkers(std::string &message) {
+  // Occupy the only worker; Wait() must then run the job on this thread.
+  JobSystem jobs(1);
+  JobCounter blocker_counter;
+  std::atomic<bool> blocker_started{false};
+  std::atomic<bool> release{false};
+  jobs.Submit(
+      [&blocker_started, &release]() {
+        blocker_started.store(true);
+        while (!release.load()) {
+          std::this_thread::yield();
+        }
+      },
+      blocker_counter);
+  while (!blocker_started.load()) {
+    std::this_thread::yield();
+  }
+
+  JobCounter counter;
+  std::size_t ran_on = 99;
+  jobs.Submit([&ran_on]() { ran_on = JobSystem::GetCurrentWorkerIndex(); },
+              counter);
+  jobs.Wait(counter);
+  release.store(true);
+  jobs.Wait(blocker_counter);
+  if (ran_on != 0) {
+    message = "job ran on worker " + std::to_string(ran_on);
+    return false;
+  }
+  return true;
+}
+
+bool TestSubmissionFollowsSchedule(std::string &message) {
+  constexpr std::size_t kPasses = 8;
+  JobSystem jobs(4);
+  ParallelPassRecorder recorder(&jobs);
+  MockBackend backend(kPasses);
+  std::vector<bool> deferred(kPasses, true);
+  recorder.Run(MakeNames(kPasses), deferred, backend);
+
+  const auto events = backend.GetEvents();
+  for (std::size_t i = 0; i < kPasses; ++i) {
+    if (i >= events.size() || events[i] != "S" + std::to_string(i)) {
+      message = "submission out of schedule order at position " +
+                std::to_string(i);
+      return false;
+    }
+  }
+  if (backend.CountRecordThreads() < 2) {
+    message = "all passes were recorded on one thread";
+    return false;
+  }
+  return true;
+}
+
+bool TestImmediatePassesRunInOrder(std::string &message) {
+  constexpr std::size_t kPasses = 5;
+  JobSystem jobs(2);
+  ParallelPassRecorder recorder(&jobs);
+  MockBackend backend(kPasses);
+  const std::vector<bool> deferred = {true, false, true, true, false};
+  recorder.Run(MakeNames(kPasses), deferred, backend);
+
+  const std::vector<std::string> expected = {"S0", "I1", "S2", "S3", "I4"};
+  if (backend.GetEvents() != expected) {
+    message = "immediate passes were not interleaved in schedule order";
+    return false;
+  }
+  return true;
+}
+
+bool TestSerialFallbackWithoutJobSystem(std::string &message) {
+  constexpr std::size_t kPasses = 3;
+  ParallelPassRecorder recorder(nullptr);
+  MockBackend backend(kPasses);
+  const auto timing =
+      recorder.Run(MakeNames(kPasses), std::vector<bool>(kPasses, true),
+                   backend);
+
+  const std::vector<std::string> expected = {"I0", "I1", "I2"};
+  if (backend.GetEvents() != expected) {
+    message = "passes did not run inline";
+    return false;
+  }
+  for (const auto &pass : timing.passes) {
+    if (pass.deferred) {
+      message = pass.name + " reported as deferred";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestRecordErrorsPropagate(std::string &message) {
+  constexpr std::size_t kPasses = 4;
+  JobSystem jobs(2);
+  ParallelPassRecorder recorder(&jobs);
+  MockBackend backend(kPasses);
+  backend.failing_pass = 2;
+  try {
+    recorder.Run(MakeNames(kPasses), std::vector<bool>(kPasses, true),
+                 backend);
+  } catch (const std::runtime_error &ex) {
+    const std::vector<std::string> expected = {"S0", "S1"};
+    if (backend.GetEvents() != expected) {
+      message = "passes after the failing one were submitted";
+      return false;
+    }
+    return std::string(ex.what()) == "record failed";
+  }
+  message = "recording error was swallowed";
+  return false;
+}
+
+bool TestTimingsAreReported(std::string &message) {
+  constexpr std::size_t kPasses = 4;
+  JobSystem jobs(2);
+  ParallelPassRecorder recorder(&jobs);
+  MockBackend backend(kPasses);
+  const std::vector<bool> deferred = {true, true, false, true};
+  const auto names = MakeNames(kPasses);
+  const auto timing = recorder.Run(names, deferred, backend);
+
+  if (timing.passes.size() != kPasses) {
+    message = "missing pass timings";
+    return false;
+  }
+  for (std::size_t i = 0; i < kPasses; ++i) {
+    const auto &pass = timing.passes[i];
+    if (pass.name != names[i] || pass.deferred != deferred[i]) {
+      message = "timing entry " + std::to_string(i) + " mislabelled";
+      return false;
+    }
+    // Deferred passes sleep in Record, so their recording time is visible.
+    if (pass.deferred && pass.record_ms < 1.0) {
+      message = pass.name + " record time not measured";
+      return false;
+    }
+  }
+  if (timing.frame_ms <= 0.0 || timing.Describe().empty()) {
+    message = "frame timing not reported";
+    return false;
+  }
+  return true;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(7);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("JobSystem runs every submitted job", TestJobSystemRunsEveryJob);
+  run("Wait runs queued jobs on the waiting thread",
+      TestWaitHelpsWithoutWorkers);
+  run("Submission follows the schedule", TestSubmissionFollowsSchedule);
+  run("Immediate passes run in schedule order",
+      TestImmediatePassesRunInOrder);
+  run("Serial fallback without a job system",
+      TestSerialFallbackWithoutJobSystem);
+  run("Recording errors reach the caller", TestRecordErrorsPropagate);
+  run("Per-pass timings are reported", TestTimingsAreReported);
+
+  return results;
+}
+
+} // namespace
+
+bool RunParallelPassRecorderTests() {
+  const auto results = RunAllTestsInternal();
+  bool all_passed = true;
+
+  for (const auto &result : results) {
+    if (!result.passed) {
+      all_passed = false;
+      std::ostringstream oss;
+      oss << "Test failed: " << result.name;
+      if (!result.message.empty()) {
+        oss << " - " << result.message;
+      }
+      Logger::SetModule("ParallelPassRecorderTests");
+      Logger::LogError(oss.str());
+    }
+  }
+
+  if (all_passed) {
+    Logger::SetModule("ParallelPassRecorderTests");
+    Logger::LogInfo("All ParallelPassRecorder tests passed");
+  }
+
+  return all_passed;
+}
@@ -54,7 +54,7 @@ bool PbrShader::Initialize(HWND hwnd, ID3D11Device *device) {
 }
 
 bool PbrShader::Render(int indexCount,
-                       const ShaderParameterContainer &parameters,
+                       const LayeredParameterView &parameters,
                        ID3D11DeviceContext *deviceContext) const {
 
   // Get required parameters from container
@@ -47,7 +47,7 @@ bool RefractionShader::Initialize(HWND hwnd, ID3D11Device *device) {
 void RefractionShader::Shutdown() { ShaderBase::Shutdown(); }
 
 bool RefractionShader::Render(int indexCount,
-                              const ShaderParameterContainer &parameters,
+                              const LayeredParameterView &parameters,
                               ID3D11DeviceContext *deviceContext) const {
 
   auto worldMatrix = parameters.GetMatrix("worldMatrix");
@@ -4,9 +4,12 @@
 
 #include "../../CommonFramework2/DirectX11Device.h"
 #include "Interfaces.h"
+#include "JobSystem.h"
+#include "LayeredParameterView.h"
 #include "RenderTexture.h"
 #include "ResourceManager.h"
 #include "ShaderBase.h"
+#include "ShaderBindingPlan.h"
 #include "ShaderParameter.h"
 #include "ShaderParameterValidator.h"
 
@@ -26,11 +29,16 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cstdint>
 #include <iostream>
+#include <stdexcept>
 #include <typeinfo>
 
 // Helper functions for parameter name generation and matching
 namespace {
+// RenderTexture::Initialize always creates this color format.
+constexpr std::uint32_t kRenderTextureFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
+
 bool EndsWith(const std::string &str, const std::string &suffix) {
   return str.size() >= suffix.size() &&
          str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
@@ -160,6 +168,12 @@ RenderGraphPassBuilder::Write(const std::string &resource_name) {
 RenderGraphPassBuilder &
 RenderGraphPassBuilder::AddRenderTag(const std::string &tag) {
   pass_->render_tags_.push_back(tag);
+  pass_->render_tag_mask_ |= TagRegistry::GetInstance().GetBit(tag);
+  return *this;
+}
+RenderGraphPassBuilder &RenderGraphPassBuilder::SetRenderables(
+    std::vector<std::shared_ptr<IRenderable>> *renderables) {
+  pass_->renderables_ = renderables;
   return *this;
 }
 RenderGraphPassBuilder &RenderGraphPassBuilder::DisableZBuffer(bool disable) {
@@ -167,6 +181,11 @@ RenderGraphPassBuilder &RenderGraphPassBuilder::DisableZBuffer(bool disable) {
   return *this;
 }
 RenderGraphPassBuilder &
+RenderGraphPassBuilder::RecordOnImmediateContext(bool immediate) {
+  pass_->record_on_immediate_ = immediate;
+  return *this;
+}
+RenderGraphPassBuilder &
 RenderGraphPassBuilder::SetParameter(const std::string &name,
                                      const DirectX::XMMATRIX &value) {
   pass_->pass_parameters_->SetMatrix(name, value);
@@ -234,37 +253,32 @@ RenderGraphPassBuilder RenderGraphPass::GetBuilder() {
   return RenderGraphPassBuilder(this);
 }
 
-ShaderParameterContainer RenderGraphPass::MergeParameters(
-    const ShaderParameterContainer &global_params) const {
-  // Merge global (lowest priority) and pass-specific parameters (higher
-  // priority). Resource bindings injected during Compile() live inside
-  // pass_parameters_.
-  return ShaderParameterContainer::MergeWithPriority(
-      global_params, *pass_parameters_,
-      ShaderParameterContainer::ParameterOrigin::Global,
-      ShaderParameterContainer::ParameterOrigin::Pass);
-}
-
 void RenderGraphPass::Execute(
-    std::vector<std::shared_ptr<IRenderable>> &renderables,
+    std::vector<std::shared_ptr<IRenderable>> &graph_renderables,
     const ShaderParameterContainer &global_params,
     ID3D11DeviceContext *device_context, bool &back_buffer_depth_cleared) {
+  auto *dx = DirectX11Device::GetD3d11DeviceInstance();
+  auto &renderables = renderables_ ? *renderables_ : graph_renderables;
+
   // Set target or back buffer.
   if (output_texture_) {
-    output_texture_->SetRenderTarget();
-    output_texture_->ClearRenderTarget(0.0f, 0.0f, 0.0f, 1.0f);
+    output_texture_->SetRenderTarget(device_context);
+    output_texture_->ClearRenderTarget(device_context, 0.0f, 0.0f, 0.0f,
+                                       1.0f);
   } else {
-    auto dx = DirectX11Device::GetD3d11DeviceInstance();
-    dx->SetBackBufferRenderTarget();
+    dx->SetBackBufferRenderTarget(device_context);
     if (!back_buffer_depth_cleared)
       back_buffer_depth_cleared = true; // depth cleared by BeginScene.
   }
 
-  // Merge pass and global parameters once per pass
-  ShaderParameterContainer merged = MergeParameters(global_params);
+  // Global (lowest priority) and pass-specific parameters are layered, not
+  // merged. Resource bindings injected during Compile() live inside
+  // pass_parameters_.
+  LayeredParameterView pass_view(global_params);
+  pass_view.PushLayer(*pass_parameters_);
 
   if (disable_z_buffer_)
-    DirectX11Device::GetD3d11DeviceInstance()->TurnZBufferOff();
+    dx->TurnZBufferOff(device_context);
 
   if (custom_execute_) {
     RenderPassContext ctx;
@@ -277,53 +291,37 @@ void RenderGraphPass::Execute(
     ctx.output_ = output_texture_;
     custom_execute_(ctx);
   } else {
+    PerDrawParameters per_draw;
     for (auto &r : renderables) {
-      bool draw = render_tags_.empty();
-      if (!draw) {
-        for (auto &t : r->GetTags()) {
-          if (std::find(render_tags_.begin(), render_tags_.end(), t) !=
-              render_tags_.end()) {
-            draw = true;
-            break;
-          }
-        }
-      }
-      if (!draw)
+      if (render_tag_mask_ != 0 && !r->HasAnyTag(render_tag_mask_))
         continue;
 
-      ShaderParameterContainer::BuildParametersInput inputs;
-      inputs.base_params = &merged;
-
-      const auto &object_params = r->GetObjectParameters();
-      inputs.object_params = &object_params;
-
-      DirectX::XMMATRIX world_matrix = r->GetWorldMatrix();
-      inputs.world_matrix = &world_matrix;
-
-      inputs.callback = r->GetParameterCallback();
-
-      ShaderParameterContainer final_params =
-          ShaderParameterContainer::BuildFinalParameters(inputs);
+      const LayeredParameterView &final_params = per_draw.Prepare(
+          pass_view, r->GetObjectParameters(), r->GetWorldMatrix(),
+          r->GetParameterCallback());
 
       r->Render(*shader_, final_params, device_context);
     }
   }
 
   if (disable_z_buffer_)
-    DirectX11Device::GetD3d11DeviceInstance()->TurnZBufferOn();
+    dx->TurnZBufferOn(device_context);
 
   // Always restore back buffer render target after rendering to texture
   // This ensures consistent state for subsequent passes or text rendering
   if (output_texture_) {
-    auto dx = DirectX11Device::GetD3d11DeviceInstance();
-    dx->SetBackBufferRenderTarget();
-    dx->ResetViewport();
+    dx->SetBackBufferRenderTarget(device_context);
+    dx->ResetViewport(device_context);
     // Ensure Z buffer is on after restoring back buffer (for 3D rendering)
-    dx->TurnZBufferOn();
+    dx->TurnZBufferOn(device_context);
   }
 }
 
 // Graph implementation
+RenderGraph::RenderGraph() = default;
+
+RenderGraph::~RenderGraph() = default;
+
 void RenderGraph::Initialize(ID3D11Device *device,
                              ID3D11DeviceContext *context) {
   device_ = device;
@@ -332,12 +330,13 @@ void RenderGraph::Initialize(ID3D11Device *device,
 
 void RenderGraph::DeclareTexture(const std::string &name, int width, int height,
                                  float depth, float nearPlane) {
-  // Currently unused simplified path; keep placeholder for future.
-  (void)depth;
-  (void)nearPlane; // silence unused warnings.
   GraphResource res;
   res.name = name;
   res.is_external = false;
+  res.width = width;
+  res.height = height;
+  res.depth = depth;
+  res.near_plane = nearPlane;
   resources_[name] = res;
 }
 
@@ -357,8 +356,60 @@ RenderGraphPassBuilder RenderGraph::AddPass(const std::string &name) {
 }
 
 bool RenderGraph::Compile() {
-  // Simple: execution order == declaration order.
-  sorted_passes_ = passes_;
+  compiled_ = false;
+
+  // Describe the graph without device objects; sorted names keep physical
+  // texture assignment stable between runs.
+  std::vector<std::string> resource_names;
+  resource_names.reserve(resources_.size());
+  for (const auto &kv : resources_) {
+    resource_names.push_back(kv.first);
+  }
+  std::sort(resource_names.begin(), resource_names.end());
+
+  std::vector<RenderGraphResourceNode> resource_nodes;
+  resource_nodes.reserve(resource_names.size());
+  for (const auto &name : resource_names) {
+    const auto &res = resources_.at(name);
+    RenderGraphResourceNode node;
+    node.name = name;
+    node.desc = {res.width, res.height, kRenderTextureFormat};
+    node.is_external = res.is_external;
+    resource_nodes.push_back(node);
+  }
+
+  std::vector<RenderGraphPassNode> pass_nodes;
+  pass_nodes.reserve(passes_.size());
+  for (const auto &pass : passes_) {
+    pass_nodes.push_back(
+        {pass->GetName(), pass->input_resources_, pass->output_resource_});
+  }
+
+  RenderGraphSchedule schedule;
+  std::string error;
+  if (!RenderGraphCompiler::Compile(resource_nodes, pass_nodes, schedule,
+                                    error)) {
+    Logger::SetModule("RenderGraph");
+    Logger::LogError("Compile Error: " + error);
+    return false;
+  }
+
+  sorted_passes_.clear();
+  for (std::size_t index : schedule.order) {
+    sorted_passes_.push_back(passes_[index]);
+  }
+  culled_passes_.clear();
+  for (std::size_t index : schedule.culled) {
+    culled_passes_.push_back(passes_[index]);
+    Logger::SetModule("RenderGraph");
+    Logger::LogInfo("Culled pass '" + passes_[index]->GetName() +
+                    "': its output '" + passes_[index]->output_resource_ +
+                    "' is never read");
+  }
+
+  if (!AllocateResources(schedule, resource_names)) {
+    return false;
+  }
 
   // Auto-register shader parameters using reflection if validator is available
   if (parameter_validator_) {
@@ -560,6 +611,39 @@ bool RenderGraph::Compile() {
     }
   }
 
+  // Compile binding plans once per shader; passes sharing a shader share it.
+  std::unordered_map<const IShader *, std::shared_ptr<const ShaderBindingPlan>>
+      compiled_plans;
+  for (auto &pass : sorted_passes_) {
+    auto *shader_base = dynamic_cast<ShaderBase *>(pass->shader_.get());
+    if (!shader_base || !shader_base->IsBindingPlanEnabled()) {
+      continue;
+    }
+    auto plan_it = compiled_plans.find(shader_base);
+    if (plan_it == compiled_plans.end()) {
+      std::shared_ptr<const ShaderBindingPlan> plan;
+      try {
+        plan = std::make_shared<const ShaderBindingPlan>(
+            shader_base->BuildBindingPlan());
+      } catch (const std::exception &e) {
+        Logger::SetModule("RenderGraph");
+        Logger::LogWarning("Pass '" + pass->GetName() +
+                           "': binding plan not built, using by-name "
+                           "binding: " +
+                           e.what());
+      }
+      // An empty plan means reflection failed; keep the by-name path then.
+      if (plan && plan->IsEmpty()) {
+        plan.reset();
+      }
+      if (plan && !shader_base->SetBindingPlan(plan, device_)) {
+        plan.reset();
+      }
+      plan_it = compiled_plans.emplace(shader_base, std::move(plan)).first;
+    }
+    pass->binding_plan_ = plan_it->second;
+  }
+
   // Validate parameters if enabled
   if (enable_parameter_validation_ && parameter_validator_) {
     for (auto &pass : sorted_passes_) {
@@ -591,6 +675,102 @@ void RenderGraph::Execute(
   DirectX11Device::GetD3d11DeviceInstance()->EndScene();
 }
 
+namespace {
+// D3D11 side of ParallelPassRecorder. Deferred passes are recorded into
+// their own deferred context and finished into a command list, which the
+// submitting thread executes on the immediate context in schedule order.
+// Passes kept on the immediate context run there directly.
+class GraphPassBackend : public IPassCommandBackend {
+public:
+  GraphPassBackend(
+      const std::vector<std::shared_ptr<RenderGraphPass>> &passes,
+      std::vector<std::shared_ptr<IRenderable>> &renderables,
+      const ShaderParameterContainer &global_params,
+      ID3D11DeviceContext *context,
+      std::vector<Microsoft::WRL::ComPtr<ID3D11DeviceContext>>
+          &deferred_contexts,
+      std::vector<Microsoft::WRL::ComPtr<ID3D11CommandList>> &command_lists,
+      bool &back_buffer_depth_cleared)
+      : passes_(passes), renderables_(renderables),
+        global_params_(global_params), context_(context),
+        deferred_contexts_(deferred_contexts), command_lists_(command_lists),
+        back_buffer_depth_cleared_(back_buffer_depth_cleared) {
+    for (const auto &pass : passes_) {
+      auto *shader = dynamic_cast<ShaderBase *>(pass->GetShader().get());
+      if (shader && std::find(shaders_.begin(), shaders_.end(), shader) ==
+                        shaders_.end()) {
+        shaders_.push_back(shader);
+      }
+    }
+  }
+
+  void Record(std::size_t pass, std::size_t slot) override {
+    ID3D11DeviceContext *deferred = deferred_contexts_[slot].Get();
+    // A deferred context starts every command list with cleared state.
+    DirectX11Device::GetD3d11DeviceInstance()->ApplyDefaultState(deferred);
+
+    // BeginScene cleared the back buffer depth before recording started.
+    bool depth_cleared = true;
+    command_lists_[slot].Reset();
+    try {
+      passes_[pass]->Execute(renderables_, global_params_, deferred,
+                             depth_cleared);
+    } catch (...) {
+      // Drop the partial recording so the next frame starts clean.
+      deferred->FinishCommandList(FALSE, command_lists_[slot].GetAddressOf());
+      command_lists_[slot].Reset();
+      throw;
+    }
+
+    if (FAILED(deferred->FinishCommandList(
+            FALSE, command_lists_[slot].GetAddressOf()))) {
+      throw std::runtime_error("FinishCommandList failed for pass '" +
+                               passes_[pass]->GetName() + "'");
+    }
+  }
+
+  void Submit(std::size_t, std::size_t slot) override {
+    // FALSE: the command list resets the immediate context state when done.
+    context_->ExecuteCommandList(command_lists_[slot].Get(), FALSE);
+    command_lists_[slot].Reset();
+    immediate_state_reset_ = true;
+
+    // The command list rewrote constant buffers behind the upload caches,
+    // which only track what the immediate context wrote.
+    for (auto *shader : shaders_) {
+      shader->InvalidateUploadCache();
+    }
+  }
+
+  void ExecuteImmediate(std::size_t pass) override {
+    RestoreImmediateState();
+    passes_[pass]->Execute(renderables_, global_params_, context_,
+                           back_buffer_depth_cleared_);
+  }
+
+  // Puts the immediate context back into the state passes expect after a
+  // command list left it cleared. No-op if none ran since the last call.
+  void RestoreImmediateState() {
+    if (!immediate_state_reset_) {
+      return;
+    }
+    DirectX11Device::GetD3d11DeviceInstance()->ApplyDefaultState(context_);
+    immediate_state_reset_ = false;
+  }
+
+private:
+  const std::vector<std::shared_ptr<RenderGraphPass>> &passes_;
+  std::vector<std::shared_ptr<IRenderable>> &renderables_;
+  const ShaderParameterContainer &global_params_;
+  ID3D11DeviceContext *context_;
+  std::vector<Microsoft::WRL::ComPtr<ID3D11DeviceContext>> &deferred_contexts_;
+  std::vector<Microsoft::WRL::ComPtr<ID3D11CommandList>> &command_lists_;
+  bool &back_buffer_depth_cleared_;
+  std::vector<ShaderBase *> shaders_;
+  bool immediate_state_reset_ = false;
+};
+} // namespace
+
 void RenderGraph::ExecutePasses(
     std::vector<std::shared_ptr<IRenderable>> &renderables,
     const ShaderParameterContainer &global_params,
@@ -600,8 +780,96 @@ void RenderGraph::ExecutePasses(
     Logger::LogError("ExecutePasses Error: not compiled");
     return;
   }
-  for (auto &p : sorted_passes_)
-    p->Execute(renderables, global_params, context_, back_buffer_depth_cleared);
+
+  std::vector<std::string> names;
+  std::vector<bool> deferred;
+  names.reserve(sorted_passes_.size());
+  deferred.reserve(sorted_passes_.size());
+  for (const auto &p : sorted_passes_) {
+    names.push_back(p->GetName());
+    deferred.push_back(!p->record_on_immediate_);
+  }
+
+  JobSystem *job_system = job_system_.get();
+  if (job_system && !EnsureDeferredContexts(sorted_passes_.size())) {
+    job_system = nullptr;
+  }
+
+  GraphPassBackend backend(sorted_passes_, renderables, global_params,
+                           context_, deferred_contexts_, command_lists_,
+                           back_buffer_depth_cleared);
+  try {
+    pass_timings_ = ParallelPassRecorder(job_system).Run(names, deferred,
+                                                         backend);
+  } catch (...) {
+    backend.RestoreImmediateState();
+    throw;
+  }
+  backend.RestoreImmediateState();
+
+  // Deferred back buffer passes never touch the caller's flag.
+  for (const auto &p : sorted_passes_) {
+    if (!p->output_texture_) {
+      back_buffer_depth_cleared = true;
+    }
+  }
+}
+
+bool RenderGraph::EnableParallelRecording(bool enable,
+                                          std::size_t worker_count) {
+  if (!enable) {
+    job_system_.reset();
+    command_lists_.clear();
+    deferred_contexts_.clear();
+    return true;
+  }
+  if (!device_) {
+    Logger::SetModule("RenderGraph");
+    Logger::LogError("EnableParallelRecording Error: not initialized");
+    return false;
+  }
+
+  D3D11_FEATURE_DATA_THREADING threading = {};
+  if (SUCCEEDED(device_->CheckFeatureSupport(
+          D3D11_FEATURE_THREADING, &threading, sizeof(threading))) &&
+      !threading.DriverCommandLists) {
+    // Still correct, the runtime emulates command lists in software.
+    Logger::SetModule("RenderGraph");
+    Logger::LogInfo("Driver has no native command lists; using emulation");
+  }
+
+  job_system_ = std::make_unique<JobSystem>(worker_count);
+  if (compiled_ && !EnsureDeferredContexts(sorted_passes_.size())) {
+    job_system_.reset();
+    return false;
+  }
+  return true;
+}
+
+bool RenderGraph::EnsureDeferredContexts(std::size_t count) {
+  while (deferred_contexts_.size() < count) {
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> deferred;
+    if (FAILED(device_->CreateDeferredContext(0, deferred.GetAddressOf()))) {
+      Logger::SetModule("RenderGraph");
+      Logger::LogWarning(
+          "CreateDeferredContext failed; recording passes serially");
+      job_system_.reset();
+      return false;
+    }
+    deferred_contexts_.push_back(deferred);
+  }
+  command_lists_.resize(deferred_contexts_.size());
+  return true;
+}
+
+void RenderGraph::PrintPassTimings() const {
+  std::cout << "\n=== RenderGraph Pass Timings (";
+  if (job_system_) {
+    std::cout << "parallel, " << job_system_->GetWorkerCount() << " workers";
+  } else {
+    std::cout << "serial";
+  }
+  std::cout << ") ===\n" << pass_timings_.Describe() << std::endl;
 }
 
 std::shared_ptr<RenderTexture>
@@ -613,7 +881,9 @@ RenderGraph::GetTexture(const std::string &name) const {
 void RenderGraph::Clear() {
   passes_.clear();
   sorted_passes_.clear();
+  culled_passes_.clear();
   resources_.clear();
+  texture_pool_.clear();
   compiled_ = false;
 }
 
@@ -644,8 +914,15 @@ void RenderGraph::PrintGraph() const {
     if (producer == "(imported)" && consumers.empty())
       unusedResources.push_back(rname);
     std::cout << "  - " << rname << (res.texture ? " [OK]" : " [MISSING]")
-              << (res.is_external ? " (external)" : "")
-              << " | producer: " << producer << " | consumers: ";
+              << (res.is_external ? " (external)" : "");
+    if (!res.is_external) {
+      if (res.physical_index >= 0)
+        std::cout << " (transient " << res.width << "x" << res.height
+                  << ", physical #" << res.physical_index << ")";
+      else
+        std::cout << " (transient, not allocated)";
+    }
+    std::cout << " | producer: " << producer << " | consumers: ";
     if (consumers.empty())
       std::cout << "none";
     else {
@@ -729,10 +1006,14 @@ void RenderGraph::PrintGraph() const {
     }
     if (p->disable_z_buffer_)
       std::cout << " ZDisabled";
+    if (p->record_on_immediate_)
+      std::cout << " ImmediateContext";
     if (!hasResolvedInput && hasOutput)
       std::cout
           << " [INFO: writes without inputs (first pass or scene rendering)]";
     std::cout << std::endl;
+    if (p->binding_plan_)
+      std::cout << "    binding plan:\n" << p->binding_plan_->Describe();
   }
   if (!isolatedPasses.empty()) {
     std::cout << "Isolated passes (no inputs & no outputs):" << std::endl;
@@ -748,6 +1029,19 @@ void RenderGraph::PrintGraph() const {
     for (auto &u : unusedOutputs)
       std::cout << "  * " << u << std::endl;
   }
+  if (!culled_passes_.empty()) {
+    std::cout << "Culled passes (output never consumed):" << std::endl;
+    for (auto &p : culled_passes_)
+      std::cout << "  * " << p->GetName() << " -> " << p->output_resource_
+                << std::endl;
+  }
+  size_t transientCount = 0;
+  for (auto &kv : resources_)
+    if (!kv.second.is_external && kv.second.physical_index >= 0)
+      ++transientCount;
+  if (transientCount > 0)
+    std::cout << "Transient textures: " << transientCount << " -> "
+              << texture_pool_.size() << " physical" << std::endl;
   std::cout << "==========================\n" << std::endl;
 }
 
@@ -769,7 +1063,7 @@ bool RenderGraph::ValidatePassParameters(
   }
 
   // Note: input_textures_ contains resource names as keys, not parameter names
-  // They are only used for binding textures in MergeParameters()
+  // They are only used for binding textures in Compile()
   // Actual parameter names come from pass_parameters_ (set via SetTexture)
 
   // Get shader name from type
@@ -803,6 +1097,54 @@ bool RenderGraph::ValidatePassParameters(
       parameter_validator_->GetValidationMode());
 }
 
-void RenderGraph::AllocateResources() { /* simplified - allocation handled
-                                           externally via ImportTexture */
+bool RenderGraph::AllocateResources(
+    const RenderGraphSchedule &schedule,
+    const std::vector<std::string> &resource_names) {
+  // Textures from a previous Compile() are reused when the description
+  // still matches.
+  std::vector<PooledTexture> previous_pool = std::move(texture_pool_);
+  texture_pool_.clear();
+
+  for (size_t t = 0; t < schedule.physical_textures.size(); ++t) {
+    const auto &desc = schedule.physical_textures[t];
+
+    // The first resource assigned to a physical texture provides the planes
+    // used for its matrices.
+    const GraphResource *owner = nullptr;
+    for (size_t r = 0; r < resource_names.size() && !owner; ++r) {
+      if (schedule.physical_index[r] == static_cast<int>(t))
+        owner = &resources_.at(resource_names[r]);
+    }
+
+    std::shared_ptr<RenderTexture> texture;
+    auto reuse = std::find_if(
+        previous_pool.begin(), previous_pool.end(),
+        [&desc](const PooledTexture &pooled) { return pooled.desc == desc; });
+    if (reuse != previous_pool.end()) {
+      texture = std::move(reuse->texture);
+      previous_pool.erase(reuse);
+    } else {
+      texture = std::make_shared<RenderTexture>();
+      if (!texture->Initialize(desc.width, desc.height, owner->depth,
+                               owner->near_plane)) {
+        Logger::SetModule("RenderGraph");
+        Logger::LogError(
+            "Compile Error: failed to allocate transient texture " +
+            owner->name);
+        return false;
+      }
+    }
+    texture_pool_.push_back({desc, texture});
+  }
+
+  for (size_t r = 0; r < resource_names.size(); ++r) {
+    auto &res = resources_.at(resource_names[r]);
+    if (res.is_external)
+      continue;
+    res.physical_index = schedule.physical_index[r];
+    res.texture = res.physical_index >= 0
+                      ? texture_pool_[res.physical_index].texture
+                      : nullptr;
+  }
+  return true;
 }
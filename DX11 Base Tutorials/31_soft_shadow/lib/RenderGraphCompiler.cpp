@@ -0,0 +1,267 @@
+#include "RenderGraphCompiler.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+
+namespace {
+
+constexpr int kNoPass = -1;
+
+struct DependencyGraph {
+  explicit DependencyGraph(std::size_t pass_count)
+      : successors(pass_count), predecessors(pass_count),
+        in_degree(pass_count, 0) {}
+
+  void AddEdge(std::size_t from, std::size_t to) {
+    auto &targets = successors[from];
+    if (std::find(targets.begin(), targets.end(), to) != targets.end()) {
+      return;
+    }
+    targets.push_back(to);
+    predecessors[to].push_back(from);
+    ++in_degree[to];
+  }
+
+  std::vector<std::vector<std::size_t>> successors;
+  std::vector<std::vector<std::size_t>> predecessors;
+  std::vector<int> in_degree;
+};
+
+// Every pass left over by Kahn's algorithm still has an unsorted
+// predecessor, so walking predecessors from any of them must revisit a pass;
+// the revisited stretch is a cycle, listed here in edge direction.
+std::string DescribeCycle(const std::vector<RenderGraphPassNode> &passes,
+                          const DependencyGraph &graph,
+                          const std::vector<bool> &sorted) {
+  std::size_t current = 0;
+  while (sorted[current]) {
+    ++current;
+  }
+
+  std::vector<std::size_t> walk;
+  std::vector<int> walk_position(passes.size(), -1);
+  while (walk_position[current] == -1) {
+    walk_position[current] = static_cast<int>(walk.size());
+    walk.push_back(current);
+    for (std::size_t predecessor : graph.predecessors[current]) {
+      if (!sorted[predecessor]) {
+        current = predecessor;
+        break;
+      }
+    }
+  }
+
+  std::vector<std::size_t> cycle(walk.begin() + walk_position[current],
+                                 walk.end());
+  std::reverse(cycle.begin(), cycle.end());
+  // Start at the earliest declared pass so the report is stable.
+  std::rotate(cycle.begin(), std::min_element(cycle.begin(), cycle.end()),
+              cycle.end());
+
+  std::string path;
+  for (std::size_t pass : cycle) {
+    path += passes[pass].name + " -> ";
+  }
+  path += passes[cycle.front()].name;
+  return path;
+}
+
+} // namespace
+
+bool RenderGraphCompiler::Compile(
+    const std::vector<RenderGraphResourceNode> &resources,
+    const std::vector<RenderGraphPassNode> &passes,
+    RenderGraphSchedule &schedule, std::string &error) {
+  schedule = RenderGraphSchedule{};
+  error.clear();
+
+  const std::size_t pass_count = passes.size();
+  std::unordered_map<std::string, std::size_t> resource_index;
+  resource_index.reserve(resources.size());
+  for (std::size_t i = 0; i < resources.size(); ++i) {
+    resource_index.emplace(resources[i].name, i);
+  }
+
+  // Resolve names once; each resource may have at most one writer.
+  std::vector<int> writer(resources.size(), kNoPass);
+  std::vector<int> write_index(pass_count, -1);
+  std::vector<std::vector<std::size_t>> read_indices(pass_count);
+  for (std::size_t p = 0; p < pass_count; ++p) {
+    const auto &pass = passes[p];
+    if (!pass.write.empty()) {
+      auto it = resource_index.find(pass.write);
+      if (it == resource_index.end()) {
+        error = "pass '" + pass.name + "' writes undeclared resource '" +
+                pass.write + "'";
+        return false;
+      }
+      if (writer[it->second] != kNoPass) {
+        error = "resource '" + pass.write + "' is written by both '" +
+                passes[writer[it->second]].name + "' and '" + pass.name + "'";
+        return false;
+      }
+      writer[it->second] = static_cast<int>(p);
+      write_index[p] = static_cast<int>(it->second);
+    }
+
+    for (const auto &read : pass.reads) {
+      auto it = resource_index.find(read);
+      if (it == resource_index.end()) {
+        error = "pass '" + pass.name + "' reads undeclared resource '" + read +
+                "'";
+        return false;
+      }
+      read_indices[p].push_back(it->second);
+    }
+  }
+
+  // Read-after-write edges, plus a chain through the passes that share the
+  // back buffer so their declared order is preserved.
+  DependencyGraph graph(pass_count);
+  int previous_back_buffer_pass = kNoPass;
+  for (std::size_t p = 0; p < pass_count; ++p) {
+    for (std::size_t r : read_indices[p]) {
+      if (writer[r] == kNoPass) {
+        if (!resources[r].is_external) {
+          error = "pass '" + passes[p].name + "' reads '" + resources[r].name +
+                  "', which no pass writes";
+          return false;
+        }
+        continue;
+      }
+      graph.AddEdge(static_cast<std::size_t>(writer[r]), p);
+    }
+    if (write_index[p] == -1) {
+      if (previous_back_buffer_pass != kNoPass) {
+        graph.AddEdge(static_cast<std::size_t>(previous_back_buffer_pass), p);
+      }
+      previous_back_buffer_pass = static_cast<int>(p);
+    }
+  }
+
+  // Kahn's algorithm; the min-heap keeps independent passes in declaration
+  // order.
+  std::vector<int> in_degree = graph.in_degree;
+  std::priority_queue<std::size_t, std::vector<std::size_t>,
+                      std::greater<std::size_t>>
+      ready;
+  for (std::size_t p = 0; p < pass_count; ++p) {
+    if (in_degree[p] == 0) {
+      ready.push(p);
+    }
+  }
+  std::vector<std::size_t> topological;
+  std::vector<bool> sorted(pass_count, false);
+  topological.reserve(pass_count);
+  while (!ready.empty()) {
+    const std::size_t p = ready.top();
+    ready.pop();
+    topological.push_back(p);
+    sorted[p] = true;
+    for (std::size_t successor : graph.successors[p]) {
+      if (--in_degree[successor] == 0) {
+        ready.push(successor);
+      }
+    }
+  }
+  if (topological.size() != pass_count) {
+    error = "dependency cycle: " + DescribeCycle(passes, graph, sorted);
+    return false;
+  }
+
+  // A pass survives when its work reaches the back buffer or an imported
+  // texture, directly or through the passes that read its output.
+  std::vector<bool> live(pass_count, false);
+  std::vector<std::size_t> pending;
+  for (std::size_t p = 0; p < pass_count; ++p) {
+    if (write_index[p] == -1 || resources[write_index[p]].is_external) {
+      live[p] = true;
+      pending.push_back(p);
+    }
+  }
+  while (!pending.empty()) {
+    const std::size_t p = pending.back();
+    pending.pop_back();
+    for (std::size_t predecessor : graph.predecessors[p]) {
+      if (!live[predecessor]) {
+        live[predecessor] = true;
+        pending.push_back(predecessor);
+      }
+    }
+  }
+
+  for (std::size_t p : topological) {
+    if (live[p]) {
+      schedule.order.push_back(p);
+    }
+  }
+  for (std::size_t p = 0; p < pass_count; ++p) {
+    if (!live[p]) {
+      schedule.culled.push_back(p);
+    }
+  }
+
+  // Lifetimes in schedule positions.
+  schedule.lifetimes.assign(resources.size(), RenderGraphResourceLifetime{});
+  auto touch = [&schedule](std::size_t resource, int position) {
+    auto &lifetime = schedule.lifetimes[resource];
+    if (lifetime.first == -1 || position < lifetime.first) {
+      lifetime.first = position;
+    }
+    if (position > lifetime.last) {
+      lifetime.last = position;
+    }
+  };
+  for (std::size_t i = 0; i < schedule.order.size(); ++i) {
+    const std::size_t p = schedule.order[i];
+    const int position = static_cast<int>(i);
+    if (write_index[p] != -1) {
+      touch(static_cast<std::size_t>(write_index[p]), position);
+    }
+    for (std::size_t r : read_indices[p]) {
+      touch(r, position);
+    }
+  }
+
+  // Greedy interval assignment in order of first use: reuse the first
+  // physical texture with a matching description that is free before this
+  // resource is written.
+  std::vector<std::size_t> transient;
+  for (std::size_t r = 0; r < resources.size(); ++r) {
+    if (!resources[r].is_external && schedule.lifetimes[r].first != -1) {
+      transient.push_back(r);
+    }
+  }
+  std::sort(transient.begin(), transient.end(),
+            [&schedule](std::size_t lhs, std::size_t rhs) {
+              const int lhs_first = schedule.lifetimes[lhs].first;
+              const int rhs_first = schedule.lifetimes[rhs].first;
+              return lhs_first != rhs_first ? lhs_first < rhs_first
+                                            : lhs < rhs;
+            });
+
+  schedule.physical_index.assign(resources.size(), -1);
+  std::vector<int> physical_last_use;
+  for (std::size_t r : transient) {
+    const auto &lifetime = schedule.lifetimes[r];
+    int chosen = -1;
+    for (std::size_t t = 0; t < schedule.physical_textures.size(); ++t) {
+      if (schedule.physical_textures[t] == resources[r].desc &&
+          physical_last_use[t] < lifetime.first) {
+        chosen = static_cast<int>(t);
+        break;
+      }
+    }
+    if (chosen == -1) {
+      chosen = static_cast<int>(schedule.physical_textures.size());
+      schedule.physical_textures.push_back(resources[r].desc);
+      physical_last_use.push_back(-1);
+    }
+    schedule.physical_index[r] = chosen;
+    physical_last_use[chosen] = lifetime.last;
+  }
+
+  return true;
+}
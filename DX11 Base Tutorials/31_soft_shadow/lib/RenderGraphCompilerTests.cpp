@@ -0,0 +1,331 @@
+#include "RenderGraphCompilerTests.h"
+
+#include "Logger.h"
+#include "RenderGraphCompiler.h"
+
+#include <algorithm>
+#include <exception>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+RenderGraphResourceNode Transient(const std::string &name, int width,
+                                  int height) {
+  RenderGraphResourceNode node;
+  node.name = name;
+  node.desc = {width, height, 2};
+  return node;
+}
+
+RenderGraphResourceNode Imported(const std::string &name) {
+  RenderGraphResourceNode node;
+  node.name = name;
+  node.is_external = true;
+  return node;
+}
+
+RenderGraphPassNode Pass(const std::string &name,
+                         std::vector<std::string> reads,
+                         const std::string &write = "") {
+  return {name, std::move(reads), write};
+}
+
+std::vector<std::string>
+OrderedNames(const std::vector<RenderGraphPassNode> &passes,
+             const std::vector<std::size_t> &indices) {
+  std::vector<std::string> names;
+  for (std::size_t index : indices) {
+    names.push_back(passes[index].name);
+  }
+  return names;
+}
+
+std::size_t IndexOf(const std::vector<RenderGraphResourceNode> &resources,
+                    const std::string &name) {
+  for (std::size_t i = 0; i < resources.size(); ++i) {
+    if (resources[i].name == name) {
+      return i;
+    }
+  }
+  return resources.size();
+}
+
+// The soft shadow chain from Graphics::SetupRenderPasses with the default
+// render target sizes.
+void MakeSoftShadowGraph(std::vector<RenderGraphResourceNode> &resources,
+                         std::vector<RenderGraphPassNode> &passes) {
+  resources = {Imported("DepthMap"),
+               Transient("ShadowMap", 1024, 1024),
+               Transient("DownsampledShadow", 512, 512),
+               Transient("HorizontalBlur", 512, 512),
+               Transient("VerticalBlur", 512, 512),
+               Transient("UpsampledShadow", 1024, 1024),
+               Imported("ReflectionMap")};
+  passes = {Pass("DepthPass", {}, "DepthMap"),
+            Pass("ShadowPass", {"DepthMap"}, "ShadowMap"),
+            Pass("DownsamplePass", {"ShadowMap"}, "DownsampledShadow"),
+            Pass("HorizontalBlurPass", {"DownsampledShadow"}, "HorizontalBlur"),
+            Pass("VerticalBlurPass", {"HorizontalBlur"}, "VerticalBlur"),
+            Pass("UpsamplePass", {"VerticalBlur"}, "UpsampledShadow"),
+            Pass("ReflectionScenePass", {"UpsampledShadow"}, "ReflectionMap"),
+            Pass("FinalPass", {"UpsampledShadow", "ReflectionMap"}),
+            Pass("PBRPass", {}),
+            Pass("TextOverlayPass", {})};
+}
+
+bool TestSortFollowsDependencies(std::string &message) {
+  // Declared consumer-first; producers must still run before consumers.
+  std::vector<RenderGraphResourceNode> resources = {Transient("A", 64, 64),
+                                                    Transient("B", 64, 64)};
+  std::vector<RenderGraphPassNode> passes = {Pass("Final", {"B"}),
+                                             Pass("MakeB", {"A"}, "B"),
+                                             Pass("MakeA", {}, "A"),
+                                             Pass("Overlay", {})};
+  RenderGraphSchedule schedule;
+  std::string error;
+  if (!RenderGraphCompiler::Compile(resources, passes, schedule, error)) {
+    message = error;
+    return false;
+  }
+  const std::vector<std::string> expected = {"MakeA", "MakeB", "Final",
+                                             "Overlay"};
+  return OrderedNames(passes, schedule.order) == expected;
+}
+
+bool TestSoftShadowChainKeepsOrder(std::string &message) {
+  std::vector<RenderGraphResourceNode> resources;
+  std::vector<RenderGraphPassNode> passes;
+  MakeSoftShadowGraph(resources, passes);
+
+  RenderGraphSchedule schedule;
+  std::string error;
+  if (!RenderGraphCompiler::Compile(resources, passes, schedule, error)) {
+    message = error;
+    return false;
+  }
+  std::vector<std::size_t> declared(passes.size());
+  for (std::size_t i = 0; i < declared.size(); ++i) {
+    declared[i] = i;
+  }
+  return schedule.order == declared && schedule.culled.empty();
+}
+
+bool TestCycleIsReportedWithPath(std::string &message) {
+  std::vector<RenderGraphResourceNode> resources = {
+      Transient("A", 64, 64), Transient("B", 64, 64), Transient("C", 64, 64)};
+  std::vector<RenderGraphPassNode> passes = {
+      Pass("First", {"C"}, "A"), Pass("Second", {"A"}, "B"),
+      Pass("Third", {"B"}, "C"), Pass("Present", {"C"})};
+  RenderGraphSchedule schedule;
+  std::string error;
+  if (RenderGraphCompiler::Compile(resources, passes, schedule, error)) {
+    message = "cycle not detected";
+    return false;
+  }
+  if (error != "dependency cycle: First -> Second -> Third -> First") {
+    message = error;
+    return false;
+  }
+
+  // A pass reading its own output is a cycle of length one.
+  std::vector<RenderGraphPassNode> self_loop = {Pass("Feedback", {"A"}, "A"),
+                                                Pass("Present", {"A"})};
+  if (RenderGraphCompiler::Compile(resources, self_loop, schedule, error) ||
+      error != "dependency cycle: Feedback -> Feedback") {
+    message = error;
+    return false;
+  }
+  return true;
+}
+
+bool TestUnconsumedPassesAreCulled(std::string &message) {
+  std::vector<RenderGraphResourceNode> resources = {
+      Transient("Debug", 64, 64), Transient("DebugBlur", 64, 64),
+      Transient("Scene", 64, 64), Imported("Export")};
+  std::vector<RenderGraphPassNode> passes = {
+      Pass("DebugPass", {}, "Debug"),
+      Pass("DebugBlurPass", {"Debug"}, "DebugBlur"),
+      Pass("ScenePass", {}, "Scene"), Pass("ExportPass", {}, "Export"),
+      Pass("Composite", {"Scene"})};
+  RenderGraphSchedule schedule;
+  std::string error;
+  if (!RenderGraphCompiler::Compile(resources, passes, schedule, error)) {
+    message = error;
+    return false;
+  }
+  const std::vector<std::string> expected_order = {"ScenePass", "ExportPass",
+                                                   "Composite"};
+  const std::vector<std::string> expected_culled = {"DebugPass",
+                                                    "DebugBlurPass"};
+  return OrderedNames(passes, schedule.order) == expected_order &&
+         OrderedNames(passes, schedule.culled) == expected_culled &&
+         schedule.physical_index[IndexOf(resources, "Debug")] == -1 &&
+         schedule.physical_index[IndexOf(resources, "DebugBlur")] == -1;
+}
+
+bool TestInvalidGraphsAreRejected(std::string &message) {
+  std::vector<RenderGraphResourceNode> resources = {Transient("A", 64, 64),
+                                                    Imported("External")};
+  RenderGraphSchedule schedule;
+  std::string error;
+
+  if (RenderGraphCompiler::Compile(resources, {Pass("P", {"Missing"})},
+                                   schedule, error) ||
+      error != "pass 'P' reads undeclared resource 'Missing'") {
+    message = "undeclared read: " + error;
+    return false;
+  }
+  if (RenderGraphCompiler::Compile(
+          resources, {Pass("P", {}, "A"), Pass("Q", {}, "A")}, schedule,
+          error) ||
+      error != "resource 'A' is written by both 'P' and 'Q'") {
+    message = "double write: " + error;
+    return false;
+  }
+  if (RenderGraphCompiler::Compile(resources, {Pass("P", {"A"})}, schedule,
+                                   error) ||
+      error != "pass 'P' reads 'A', which no pass writes") {
+    message = "unwritten transient: " + error;
+    return false;
+  }
+  // Imported textures may be read without a writer.
+  if (!RenderGraphCompiler::Compile(resources, {Pass("P", {"External"})},
+                                    schedule, error)) {
+    message = "imported read: " + error;
+    return false;
+  }
+  return true;
+}
+
+bool TestLifetimesAndAliasing(std::string &message) {
+  std::vector<RenderGraphResourceNode> resources;
+  std::vector<RenderGraphPassNode> passes;
+  MakeSoftShadowGraph(resources, passes);
+
+  RenderGraphSchedule schedule;
+  std::string error;
+  if (!RenderGraphCompiler::Compile(resources, passes, schedule, error)) {
+    message = error;
+    return false;
+  }
+
+  auto lifetime = [&](const std::string &name) {
+    return schedule.lifetimes[IndexOf(resources, name)];
+  };
+  auto physical = [&](const std::string &name) {
+    return schedule.physical_index[IndexOf(resources, name)];
+  };
+
+  if (lifetime("ShadowMap").first != 1 || lifetime("ShadowMap").last != 2 ||
+      lifetime("UpsampledShadow").first != 5 ||
+      lifetime("UpsampledShadow").last != 7) {
+    message = "unexpected lifetimes";
+    return false;
+  }
+
+  // Five transient targets fit in three: the shadow map is dead before the
+  // upsample writes, and the downsampled target before the vertical blur.
+  if (schedule.physical_textures.size() != 3) {
+    message = std::to_string(schedule.physical_textures.size()) +
+              " physical textures";
+    return false;
+  }
+  return physical("ShadowMap") == physical("UpsampledShadow") &&
+         physical("DownsampledShadow") == physical("VerticalBlur") &&
+         physical("DownsampledShadow") != physical("HorizontalBlur") &&
+         physical("ShadowMap") != physical("DownsampledShadow") &&
+         physical("DepthMap") == -1 && physical("ReflectionMap") == -1;
+}
+
+bool TestAliasingRequiresMatchingDescription(std::string &message) {
+  // Same lifetimes pattern as a ping-pong chain, but the middle target has
+  // a different size and the last one a different format.
+  std::vector<RenderGraphResourceNode> resources = {
+      Transient("A", 256, 256), Transient("B", 128, 128),
+      Transient("C", 256, 256), Transient("D", 256, 256)};
+  resources[3].desc.format = 10;
+  std::vector<RenderGraphPassNode> passes = {
+      Pass("WriteA", {}, "A"), Pass("WriteB", {"A"}, "B"),
+      Pass("WriteC", {"B"}, "C"), Pass("WriteD", {"C"}, "D"),
+      Pass("Present", {"D"})};
+  RenderGraphSchedule schedule;
+  std::string error;
+  if (!RenderGraphCompiler::Compile(resources, passes, schedule, error)) {
+    message = error;
+    return false;
+  }
+  const auto &physical = schedule.physical_index;
+  return physical[0] == physical[2] && physical[1] != physical[0] &&
+         physical[3] != physical[0] && physical[3] != physical[1] &&
+         schedule.physical_textures.size() == 3;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(7);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("Schedule follows read/write dependencies", TestSortFollowsDependencies);
+  run("Soft shadow chain keeps declared order", TestSoftShadowChainKeepsOrder);
+  run("Cycles are reported with their path", TestCycleIsReportedWithPath);
+  run("Passes with unconsumed output are culled",
+      TestUnconsumedPassesAreCulled);
+  run("Invalid graphs are rejected", TestInvalidGraphsAreRejected);
+  run("Lifetimes and aliasing of the soft shadow chain",
+      TestLifetimesAndAliasing);
+  run("Aliasing requires a matching description",
+      TestAliasingRequiresMatchingDescription);
+
+  return results;
+}
+
+} // namespace
+
+bool RunRenderGraphCompilerTests() {
+  const auto results = RunAllTestsInternal();
+  bool all_passed = true;
+
+  for (const auto &result : results) {
+    if (!result.passed) {
+      all_passed = false;
+      std::ostringstream oss;
+      oss << "Test failed: " << result.name;
+      if (!result.message.empty()) {
+        oss << " - " << result.message;
+      }
+      Logger::SetModule("RenderGraphCompilerTests");
+      Logger::LogError(oss.str());
+    }
+  }
+
+  if (all_passed) {
+    Logger::SetModule("RenderGraphCompilerTests");
+    Logger::LogInfo("All RenderGraphCompiler tests passed");
+  }
+
+  return all_passed;
+}
@@ -1,6 +1,7 @@
 #include "RenderPass.h"
 
 #include "../../CommonFramework2/DirectX11Device.h"
+#include "LayeredParameterView.h"
 
 RenderPass::RenderPass(const std::string &name, std::shared_ptr<IShader> shader)
     : pass_name_(name), shader_(shader) {}
@@ -43,21 +44,13 @@ void RenderPass::Execute(
   if (need_turn_z_buffer_off_)
     DirectX11Device::GetD3d11DeviceInstance()->TurnZBufferOff();
 
+  const LayeredParameterView pass_view(globalFramePassParams);
+  PerDrawParameters per_draw;
   for (const auto &renderable : renderables) {
     if (ShouldRenderObject(*renderable)) {
-      ShaderParameterContainer::BuildParametersInput inputs;
-      inputs.base_params = &globalFramePassParams;
-
-      const auto &object_params = renderable->GetObjectParameters();
-      inputs.object_params = &object_params;
-
-      DirectX::XMMATRIX world_matrix = renderable->GetWorldMatrix();
-      inputs.world_matrix = &world_matrix;
-
-      inputs.callback = renderable->GetParameterCallback();
-
-      ShaderParameterContainer final_params =
-          ShaderParameterContainer::BuildFinalParameters(inputs);
+      const LayeredParameterView &final_params = per_draw.Prepare(
+          pass_view, renderable->GetObjectParameters(),
+          renderable->GetWorldMatrix(), renderable->GetParameterCallback());
 
       renderable->Render(*shader_, final_params, deviceContext);
     }
@@ -76,10 +69,5 @@ bool RenderPass::ShouldRenderObject(const IRenderable &object) const {
   if (render_tags_.empty()) {
     return true; // If no tags specified, render all objects
   }
-  for (const auto &tag : object.GetTags()) {
-    if (render_tags_.find(tag) != render_tags_.end()) {
-      return true;
-    }
-  }
-  return false;
+  return object.HasAnyTag(render_tag_mask_);
 }
@@ -0,0 +1,56 @@
+#include "RenderTag.h"
+
+#include "Logger.h"
+
+TagRegistry &TagRegistry::GetInstance() {
+  static TagRegistry instance;
+  return instance;
+}
+
+TagMask TagRegistry::GetBit(const std::string &tag) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = bits_.find(tag);
+  if (it != bits_.end()) {
+    return it->second;
+  }
+  if (names_.size() == kMaxTags) {
+    Logger::SetModule("TagRegistry");
+    Logger::LogError("Too many render tags, '" + tag +
+                     "' cannot be used for mask filtering");
+    return 0;
+  }
+  const TagMask bit = TagMask{1} << names_.size();
+  names_.push_back(tag);
+  bits_.emplace(tag, bit);
+  return bit;
+}
+
+TagMask TagRegistry::FindBit(const std::string &tag) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = bits_.find(tag);
+  return it != bits_.end() ? it->second : 0;
+}
+
+TagMask TagRegistry::MakeMask(const std::vector<std::string> &tags) {
+  TagMask mask = 0;
+  for (const auto &tag : tags) {
+    mask |= GetBit(tag);
+  }
+  return mask;
+}
+
+std::vector<std::string> TagRegistry::GetNames(TagMask mask) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::string> names;
+  for (std::size_t bit = 0; bit < names_.size(); ++bit) {
+    if (mask & (TagMask{1} << bit)) {
+      names.push_back(names_[bit]);
+    }
+  }
+  return names;
+}
+
+std::size_t TagRegistry::GetTagCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return names_.size();
+}
@@ -107,9 +107,11 @@ bool RenderTexture::Initialize(int textureWidth, int textureHeight,
 }
 
 void RenderTexture::SetRenderTarget() {
+  SetRenderTarget(
+      DirectX11Device::GetD3d11DeviceInstance()->GetDeviceContext());
+}
 
-  auto device_context =
-      DirectX11Device::GetD3d11DeviceInstance()->GetDeviceContext();
+void RenderTexture::SetRenderTarget(ID3D11DeviceContext *device_context) {
   device_context->OMSetRenderTargets(1, render_target_view_.GetAddressOf(),
                                      depth_stencil_view_.Get());
 
@@ -118,6 +120,14 @@ void RenderTexture::SetRenderTarget() {
 
 void RenderTexture::ClearRenderTarget(float red, float green, float blue,
                                       float alpha) {
+  ClearRenderTarget(
+      DirectX11Device::GetD3d11DeviceInstance()->GetDeviceContext(), red,
+      green, blue, alpha);
+}
+
+void RenderTexture::ClearRenderTarget(ID3D11DeviceContext *device_context,
+                                      float red, float green, float blue,
+                                      float alpha) {
   float color[4];
 
   color[0] = red;
@@ -125,9 +135,6 @@ void RenderTexture::ClearRenderTarget(float red, float green, float blue,
   color[2] = blue;
   color[3] = alpha;
 
-  auto device_context =
-      DirectX11Device::GetD3d11DeviceInstance()->GetDeviceContext();
-
   device_context->ClearRenderTargetView(render_target_view_.Get(), color);
 
   device_context->ClearDepthStencilView(depth_stencil_view_.Get(),
@@ -21,9 +21,9 @@ RenderableObject::RenderableObject(std::shared_ptr<OrthoWindow> windowModel,
     : window_model_(windowModel), shader_(shader), is_window_model_(true) {}
 
 void RenderableObject::Render(const IShader &shader,
-                              const ShaderParameterContainer &parameters,
+                              const LayeredParameterView &parameters,
                               ID3D11DeviceContext *deviceContext) const {
-  // NOTE: Object-level parameters and callback have already been merged
+  // NOTE: Object-level parameters and callback have already been layered
   // upstream (RenderGraphPass / RenderPass). We intentionally avoid a second
   // merge here to prevent Object parameters from overriding Callback results.
   // If direct per-object invocation is needed outside the graph, caller must
@@ -41,7 +41,8 @@ void RenderableObject::SetParameterCallback(ShaderParameterCallback callback) {
   parameter_callback_ = callback;
 }
 
-ShaderParameterCallback RenderableObject::GetParameterCallback() const {
+const ShaderParameterCallback &
+RenderableObject::GetParameterCallback() const {
   return parameter_callback_;
 }
 
@@ -50,6 +51,9 @@ const ShaderParameterContainer &RenderableObject::GetObjectParameters() const {
 }
 
 XMMATRIX RenderableObject::GetWorldMatrix() const noexcept {
+  if (auto *storage = GetSceneStorage()) {
+    return storage->GetWorldMatrix(GetEntityId());
+  }
   return world_matrix_;
 }
 
@@ -60,12 +64,31 @@ void RenderableObject::SetObjectParameters(
 
 void RenderableObject::SetWorldMatrix(const XMMATRIX &worldMatrix) {
   world_matrix_ = worldMatrix;
+  world_bounds_dirty_ = true;
+  if (auto *storage = GetSceneStorage()) {
+    storage->SetWorldMatrix(GetEntityId(), worldMatrix);
+  }
+}
+
+bool RenderableObject::GetLocalBounds(BoundingVolume &bounds) const {
+  if (!model_) {
+    return false;
+  }
+  bounds = model_->GetLocalBoundingVolume();
+  return true;
 }
 
 BoundingVolume RenderableObject::GetWorldBoundingVolume() const {
+  auto *storage = GetSceneStorage();
+  if (storage && storage->HasBounds(GetEntityId())) {
+    return storage->GetWorldBounds(GetEntityId());
+  }
   if (model_) {
-    BoundingVolume localBounds = model_->GetLocalBoundingVolume();
-    return localBounds.Transform(world_matrix_);
+    if (world_bounds_dirty_) {
+      world_bounds_ = model_->GetLocalBoundingVolume().Transform(world_matrix_);
+      world_bounds_dirty_ = false;
+    }
+    return world_bounds_;
   }
 
   BoundingVolume emptyBounds;
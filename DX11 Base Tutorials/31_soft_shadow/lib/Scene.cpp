@@ -1,6 +1,7 @@
 #include "Scene.h"
 
 #include <DirectXMath.h>
+#include <algorithm>
 #include <fstream>
 #include <unordered_map>
 
@@ -18,6 +19,10 @@
 using namespace DirectX;
 using namespace SceneConfig;
 
+// Rebuild the spatial index once refits have made it this much worse than
+// a fresh SAH build.
+static constexpr float spatial_rebuild_factor = 1.5f;
+
 // Render tags (moved from Graphics.cpp)
 static constexpr auto write_depth_tag = "write_depth";
 static constexpr auto write_shadow_tag = "write_shadow";
@@ -99,9 +104,16 @@ bool Scene::LoadFromJson(const std::string &scene_file,
 }
 
 void Scene::AddRenderable(std::shared_ptr<IRenderable> renderable) {
-  if (renderable) {
-    renderable_objects_.push_back(renderable);
+  if (!renderable || renderable->GetSceneStorage()) {
+    return;
+  }
+  const EntityId entity = storage_.Create(
+      renderable.get(), renderable->GetWorldMatrix(), renderable->GetTagMask());
+  BoundingVolume local_bounds;
+  if (renderable->GetLocalBounds(local_bounds)) {
+    storage_.SetLocalBounds(entity, local_bounds);
   }
+  renderable_objects_.push_back(std::move(renderable));
 }
 
 std::shared_ptr<IRenderable>
@@ -116,51 +128,132 @@ Scene::GetRenderable(const std::string &name) const {
 void Scene::Clear() {
   renderable_objects_.clear();
   named_renderables_.clear();
-  animation_configs_.clear();
-  initial_transforms_.clear();
-  rotation_states_.clear(); // Clear animation states
+  // Detach objects still referenced elsewhere (render groups)
+  storage_.Clear();
 }
 
 const AnimationConfig &
 Scene::GetAnimationConfig(std::shared_ptr<IRenderable> renderable) const {
   static const AnimationConfig default_config; // Returns disabled config
-  auto it = animation_configs_.find(renderable);
-  if (it != animation_configs_.end()) {
-    return it->second;
+  if (renderable && renderable->GetSceneStorage() == &storage_) {
+    return storage_.GetAnimation(renderable->GetEntityId());
   }
   return default_config;
 }
 
-const DirectX::XMMATRIX &
-Scene::GetInitialTransform(std::shared_ptr<IRenderable> renderable) const {
-  static const DirectX::XMMATRIX identity = DirectX::XMMatrixIdentity();
-  auto it = initial_transforms_.find(renderable);
-  if (it != initial_transforms_.end()) {
-    return it->second;
+void Scene::Update(float deltaTime) {
+  storage_.UpdateAnimations(deltaTime);
+  changed_objects_ = storage_.UpdateTransforms();
+}
+
+void Scene::UpdateSpatialIndex() {
+  // Picks up transforms set after Update(); free when there are none.
+  changed_objects_ += storage_.UpdateTransforms();
+  if (!spatial_index_built_) {
+    RebuildSpatialIndex();
+    return;
+  }
+
+  storage_.DrainChanges(spatial_changes_);
+  // Removals first: a destroyed id may already be reused by a created one.
+  for (const EntityId entity : spatial_changes_.destroyed) {
+    if (entity < spatial_proxies_.size() &&
+        spatial_proxies_[entity] != BoundingVolumeHierarchy::kNullNode) {
+      spatial_index_.Remove(spatial_proxies_[entity]);
+      spatial_proxies_[entity] = BoundingVolumeHierarchy::kNullNode;
+    }
+  }
+  for (const EntityId entity : spatial_changes_.created) {
+    SyncSpatialProxy(entity);
+  }
+  for (const EntityId entity : spatial_changes_.changed) {
+    SyncSpatialProxy(entity);
+  }
+  spatial_index_.Refit();
+
+  if (spatial_index_.GetSahCost() >
+      built_sah_cost_ * spatial_rebuild_factor) {
+    RebuildSpatialIndex();
   }
-  return identity;
 }
 
-float &Scene::GetRotationState(std::shared_ptr<IRenderable> renderable) {
-  return rotation_states_[renderable];
+void Scene::RebuildSpatialIndex() {
+  storage_.EnableChangeJournal(true);
+  storage_.DrainChanges(spatial_changes_); // Covered by the rebuild
+
+  std::vector<BvhItem> items;
+  items.reserve(storage_.GetCount());
+  EntityId max_entity = 0;
+  for (std::size_t i = 0; i < storage_.GetCount(); ++i) {
+    const EntityId entity = storage_.GetEntity(i);
+    max_entity = (std::max)(max_entity, entity);
+    if (!storage_.HasBounds(entity)) {
+      continue;
+    }
+    BvhItem item;
+    item.id = entity;
+    item.bounds = storage_.GetWorldBounds(entity);
+    item.tags = storage_.GetTagMask(entity);
+    items.push_back(item);
+  }
+
+  std::vector<int> proxies;
+  spatial_index_.Build(items, &proxies);
+  spatial_proxies_.assign(static_cast<std::size_t>(max_entity) + 1,
+                          BoundingVolumeHierarchy::kNullNode);
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    spatial_proxies_[items[i].id] = proxies[i];
+  }
+  built_sah_cost_ = spatial_index_.GetSahCost();
+  spatial_index_built_ = true;
 }
 
-void Scene::CleanupAnimationStates(
-    const std::vector<std::shared_ptr<IRenderable>> &active_objects) {
-  // Remove rotation states for objects that no longer exist
-  for (auto it = rotation_states_.begin(); it != rotation_states_.end();) {
-    if (std::find(active_objects.begin(), active_objects.end(), it->first) ==
-        active_objects.end()) {
-      it = rotation_states_.erase(it);
-    } else {
-      ++it;
+void Scene::SyncSpatialProxy(EntityId entity) {
+  if (!storage_.IsAlive(entity)) {
+    return;
+  }
+  if (entity >= spatial_proxies_.size()) {
+    spatial_proxies_.resize(static_cast<std::size_t>(entity) + 1,
+                            BoundingVolumeHierarchy::kNullNode);
+  }
+  int &proxy = spatial_proxies_[entity];
+  if (!storage_.HasBounds(entity)) {
+    if (proxy != BoundingVolumeHierarchy::kNullNode) {
+      spatial_index_.Remove(proxy);
+      proxy = BoundingVolumeHierarchy::kNullNode;
     }
+    return;
+  }
+
+  const BoundingVolume bounds = storage_.GetWorldBounds(entity);
+  const TagMask tags = storage_.GetTagMask(entity);
+  if (proxy == BoundingVolumeHierarchy::kNullNode) {
+    proxy = spatial_index_.Insert(entity, bounds, tags);
+  } else {
+    spatial_index_.Update(proxy, bounds, tags);
   }
 }
 
-void Scene::Update(float deltaTime) {
-  // Placeholder for future scene updates (animations, etc.)
-  (void)deltaTime;
+std::shared_ptr<IRenderable> Scene::Pick(const XMFLOAT3 &origin,
+                                         const XMFLOAT3 &direction,
+                                         float max_distance,
+                                         float *distance) const {
+  BvhRayHit hit;
+  if (!spatial_index_.Raycast(origin, direction, max_distance, hit) ||
+      !storage_.IsAlive(hit.id)) {
+    return nullptr;
+  }
+  const IRenderable *picked =
+      storage_.GetRenderable(storage_.GetIndex(hit.id));
+  for (const auto &renderable : renderable_objects_) {
+    if (renderable.get() == picked) {
+      if (distance) {
+        *distance = hit.distance;
+      }
+      return renderable;
+    }
+  }
+  return nullptr;
 }
 
 std::shared_ptr<RenderableObject> Scene::CreateTexturedModelObject(
@@ -213,7 +306,7 @@ void Scene::BuildSceneObjects(StandardRenderGroup *cube_group,
   {
     auto cube_object = CreateTexturedModelObject(
         cube_model, soft_shadow_shader, XMMatrixTranslation(-2.5f, 2.0f, 0.0f));
-    renderable_objects_.push_back(cube_object);
+    AddRenderable(cube_object);
   }
 
   {
@@ -221,7 +314,7 @@ void Scene::BuildSceneObjects(StandardRenderGroup *cube_group,
     auto sphere_object =
         CreateTexturedModelObject(sphere_model, soft_shadow_shader,
                                   XMMatrixTranslation(2.5f, 2.0f, 0.0f));
-    renderable_objects_.push_back(sphere_object);
+    AddRenderable(sphere_object);
   }
 
   {
@@ -233,7 +326,7 @@ void Scene::BuildSceneObjects(StandardRenderGroup *cube_group,
     if (pbr_group) {
       pbr_group->AddRenderable(pbr_sphere_object);
     }
-    renderable_objects_.push_back(pbr_sphere_object);
+    AddRenderable(pbr_sphere_object);
   }
 
   auto texture_shader = ResourceRegistry::GetInstance().Get<IShader>("texture");
@@ -246,7 +339,7 @@ void Scene::BuildSceneObjects(StandardRenderGroup *cube_group,
     auto down_sample_object = CreatePostProcessObject(
         small_window, texture_shader, down_sample_tag, shadow_tex);
     down_sample_object->AddTag("skip_culling");
-    renderable_objects_.push_back(down_sample_object);
+    AddRenderable(down_sample_object);
   }
 
   {
@@ -258,7 +351,7 @@ void Scene::BuildSceneObjects(StandardRenderGroup *cube_group,
         CreatePostProcessObject(small_window, horizontal_blur_shader,
                                 horizontal_blur_tag, downsample_tex);
     horizontal_blur_object->AddTag("skip_culling");
-    renderable_objects_.push_back(horizontal_blur_object);
+    AddRenderable(horizontal_blur_object);
   }
 
   {
@@ -269,7 +362,7 @@ void Scene::BuildSceneObjects(StandardRenderGroup *cube_group,
     auto vertical_blur_object = CreatePostProcessObject(
         small_window, vertical_blur_shader, vertical_blur_tag, h_blur_tex);
     vertical_blur_object->AddTag("skip_culling");
-    renderable_objects_.push_back(vertical_blur_object);
+    AddRenderable(vertical_blur_object);
   }
 
   {
@@ -280,7 +373,7 @@ void Scene::BuildSceneObjects(StandardRenderGroup *cube_group,
     auto up_sample_object = CreatePostProcessObject(
         fullscreen_window, texture_shader, up_sample_tag, v_blur_tex);
     up_sample_object->AddTag("skip_culling");
-    renderable_objects_.push_back(up_sample_object);
+    AddRenderable(up_sample_object);
   }
 
   {
@@ -293,7 +386,7 @@ void Scene::BuildSceneObjects(StandardRenderGroup *cube_group,
           params.SetTexture("texture", ground_model->GetTexture());
           params.SetFloat("reflectionBlend", 0.5f);
         });
-    renderable_objects_.push_back(ground_object);
+    AddRenderable(ground_object);
   }
 
   // Add diffuse lighting shader demo object
@@ -310,7 +403,7 @@ void Scene::BuildSceneObjects(StandardRenderGroup *cube_group,
           params.SetTexture("texture", cube_model->GetTexture());
         });
     named_renderables_["diffuse_lighting_cube"] = diffuse_lighting_cube_obj;
-    renderable_objects_.push_back(diffuse_lighting_cube_obj);
+    AddRenderable(diffuse_lighting_cube_obj);
   }
 
   for (int i = 0; i < 5; i++) {
@@ -327,7 +420,7 @@ void Scene::BuildSceneObjects(StandardRenderGroup *cube_group,
     if (cube_group) {
       cube_group->AddRenderable(cube_obj);
     }
-    renderable_objects_.push_back(cube_obj);
+    AddRenderable(cube_obj);
   }
 }
 
@@ -597,11 +690,6 @@ bool Scene::BuildSceneObjectsFromJson(const nlohmann::json &j,
       AnimationConfig animation_config;
       if (obj_json.find("animation") != obj_json.end()) {
         animation_config = ParseAnimation(obj_json["animation"]);
-        if (animation_config.enabled) {
-          animation_configs_[obj] = animation_config;
-          // Store initial transform for animated objects
-          initial_transforms_[obj] = world_matrix;
-        }
       }
 
       // Add to groups (for backward compatibility, but animation takes
@@ -625,7 +713,11 @@ bool Scene::BuildSceneObjectsFromJson(const nlohmann::json &j,
         named_renderables_[name] = obj;
       }
 
-      renderable_objects_.push_back(obj);
+      AddRenderable(obj);
+      // The world matrix set at creation becomes the initial transform
+      if (animation_config.enabled) {
+        storage_.SetAnimation(obj->GetEntityId(), animation_config);
+      }
     }
 
     Logger::LogInfo("Loaded " + std::to_string(renderable_objects_.size()) +
@@ -41,7 +41,7 @@ bool SceneLightShader::Initialize(HWND hwnd, ID3D11Device *device) {
 void SceneLightShader::Shutdown() { ShaderBase::Shutdown(); }
 
 bool SceneLightShader::Render(int indexCount,
-                              const ShaderParameterContainer &parameters,
+                              const LayeredParameterView &parameters,
                               ID3D11DeviceContext *deviceContext) const {
 
   auto worldMatrix = parameters.GetMatrix("worldMatrix");
@@ -0,0 +1,340 @@
+#include "SceneStorage.h"
+
+#include "Interfaces.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+
+using namespace DirectX;
+
+namespace {
+
+constexpr std::uint32_t kNoIndex = 0xffffffffu;
+
+// Fills the hole at index with the last element.
+template <typename T> void RemoveSwap(std::vector<T> &column, std::size_t i) {
+  column[i] = column.back();
+  column.pop_back();
+}
+
+std::array<std::vector<float> *, 10>
+FloatColumns(WorldBoundsColumns &bounds) {
+  return {&bounds.min_x,    &bounds.min_y,    &bounds.min_z,
+          &bounds.max_x,    &bounds.max_y,    &bounds.max_z,
+          &bounds.center_x, &bounds.center_y, &bounds.center_z,
+          &bounds.radius};
+}
+
+} // namespace
+
+SceneStorage::~SceneStorage() { Clear(); }
+
+EntityId SceneStorage::Create(IRenderable *renderable, const XMMATRIX &world,
+                              TagMask tags) {
+  EntityId id;
+  if (!free_ids_.empty()) {
+    id = free_ids_.back();
+    free_ids_.pop_back();
+  } else {
+    id = static_cast<EntityId>(dense_index_.size());
+    dense_index_.push_back(kNoIndex);
+  }
+  dense_index_[id] = static_cast<std::uint32_t>(entities_.size());
+
+  XMFLOAT4X4 world_matrix;
+  XMStoreFloat4x4(&world_matrix, world);
+
+  entities_.push_back(id);
+  renderables_.push_back(renderable);
+  world_matrices_.push_back(world_matrix);
+  local_bounds_.emplace_back();
+  for (auto *column : FloatColumns(world_bounds_)) {
+    column->push_back(0.0f);
+  }
+  world_bounds_.has_bounds.push_back(0);
+  tag_masks_.push_back(tags);
+
+  animations_.emplace_back();
+  rotation_angles_.push_back(0.0f);
+  initial_transforms_.push_back(world_matrix);
+  initial_scales_.emplace_back(1.0f, 1.0f, 1.0f);
+  initial_translations_.emplace_back(0.0f, 0.0f, 0.0f);
+  initial_decomposed_.push_back(0);
+  transform_dirty_.push_back(0);
+  journal_changed_.push_back(0);
+  if (journal_enabled_) {
+    journal_.created.push_back(id);
+  }
+
+  if (renderable) {
+    renderable->storage_ = this;
+    renderable->entity_ = id;
+  }
+  return id;
+}
+
+void SceneStorage::Destroy(EntityId id) {
+  if (!IsAlive(id)) {
+    return;
+  }
+  const std::size_t index = dense_index_[id];
+  if (auto *renderable = renderables_[index]) {
+    renderable->storage_ = nullptr;
+    renderable->entity_ = kInvalidEntity;
+  }
+
+  if (animations_[index].enabled) {
+    auto it = std::find(animated_.begin(), animated_.end(), id);
+    *it = animated_.back();
+    animated_.pop_back();
+  }
+  // A stale entry in dirty_entities_ is skipped by UpdateTransforms().
+
+  const EntityId moved = entities_.back();
+  RemoveSwap(entities_, index);
+  RemoveSwap(renderables_, index);
+  RemoveSwap(world_matrices_, index);
+  RemoveSwap(local_bounds_, index);
+  for (auto *column : FloatColumns(world_bounds_)) {
+    RemoveSwap(*column, index);
+  }
+  RemoveSwap(world_bounds_.has_bounds, index);
+  RemoveSwap(tag_masks_, index);
+  RemoveSwap(animations_, index);
+  RemoveSwap(rotation_angles_, index);
+  RemoveSwap(initial_transforms_, index);
+  RemoveSwap(initial_scales_, index);
+  RemoveSwap(initial_translations_, index);
+  RemoveSwap(initial_decomposed_, index);
+  RemoveSwap(transform_dirty_, index);
+  RemoveSwap(journal_changed_, index);
+  if (journal_enabled_) {
+    journal_.destroyed.push_back(id);
+  }
+
+  if (moved != id) {
+    dense_index_[moved] = static_cast<std::uint32_t>(index);
+  }
+  dense_index_[id] = kNoIndex;
+  free_ids_.push_back(id);
+}
+
+void SceneStorage::Clear() {
+  while (!entities_.empty()) {
+    Destroy(entities_.back());
+  }
+  dense_index_.clear();
+  free_ids_.clear();
+  dirty_entities_.clear();
+}
+
+bool SceneStorage::IsAlive(EntityId id) const {
+  return id < dense_index_.size() && dense_index_[id] != kNoIndex;
+}
+
+XMMATRIX SceneStorage::GetWorldMatrix(EntityId id) const {
+  return XMLoadFloat4x4(&world_matrices_[GetIndex(id)]);
+}
+
+void SceneStorage::SetWorldMatrix(EntityId id, const XMMATRIX &world) {
+  const std::size_t index = GetIndex(id);
+  XMFLOAT4X4 stored;
+  XMStoreFloat4x4(&stored, world);
+  // Callers often re-set the same matrix every frame.
+  if (std::memcmp(&stored, &world_matrices_[index], sizeof(stored)) == 0) {
+    return;
+  }
+  world_matrices_[index] = stored;
+  MarkTransformDirty(index);
+}
+
+std::size_t SceneStorage::UpdateTransforms() {
+  std::size_t changed = 0;
+  for (const EntityId id : dirty_entities_) {
+    if (!IsAlive(id)) {
+      continue;
+    }
+    const std::size_t index = GetIndex(id);
+    if (!transform_dirty_[index]) {
+      continue; // Destroyed and re-created within the frame
+    }
+    transform_dirty_[index] = 0;
+    UpdateWorldBounds(index);
+    ++changed;
+  }
+  dirty_entities_.clear();
+  return changed;
+}
+
+void SceneStorage::SetLocalBounds(EntityId id, const BoundingVolume &bounds) {
+  const std::size_t index = GetIndex(id);
+  local_bounds_[index] = bounds;
+  world_bounds_.has_bounds[index] = 1;
+  MarkTransformDirty(index);
+}
+
+bool SceneStorage::HasBounds(EntityId id) const {
+  return world_bounds_.has_bounds[GetIndex(id)] != 0;
+}
+
+BoundingVolume SceneStorage::GetWorldBounds(EntityId id) const {
+  const std::size_t i = GetIndex(id);
+  BoundingVolume bounds;
+  bounds.aabb_min = XMFLOAT3(world_bounds_.min_x[i], world_bounds_.min_y[i],
+                             world_bounds_.min_z[i]);
+  bounds.aabb_max = XMFLOAT3(world_bounds_.max_x[i], world_bounds_.max_y[i],
+                             world_bounds_.max_z[i]);
+  bounds.sphere_center =
+      XMFLOAT3(world_bounds_.center_x[i], world_bounds_.center_y[i],
+               world_bounds_.center_z[i]);
+  bounds.sphere_radius = world_bounds_.radius[i];
+  return bounds;
+}
+
+void SceneStorage::SetTagMask(EntityId id, TagMask mask) {
+  const std::size_t index = GetIndex(id);
+  if (tag_masks_[index] != mask) {
+    tag_masks_[index] = mask;
+    MarkChanged(index);
+  }
+}
+
+void SceneStorage::CollectByMask(TagMask mask,
+                                 std::vector<std::uint32_t> &indices) const {
+  indices.clear();
+  const std::size_t count = tag_masks_.size();
+  for (std::size_t i = 0; i < count; ++i) {
+    if (tag_masks_[i] & mask) {
+      indices.push_back(static_cast<std::uint32_t>(i));
+    }
+  }
+}
+
+void SceneStorage::SetAnimation(EntityId id, const AnimationConfig &config) {
+  const std::size_t index = GetIndex(id);
+  if (config.enabled != animations_[index].enabled) {
+    if (config.enabled) {
+      animated_.push_back(id);
+    } else {
+      auto it = std::find(animated_.begin(), animated_.end(), id);
+      *it = animated_.back();
+      animated_.pop_back();
+    }
+  }
+  animations_[index] = config;
+  rotation_angles_[index] = 0.0f;
+  initial_transforms_[index] = world_matrices_[index];
+
+  // Decompose once here instead of every frame.
+  XMVECTOR scale, rotation, translation;
+  const XMMATRIX initial = XMLoadFloat4x4(&initial_transforms_[index]);
+  initial_decomposed_[index] =
+      XMMatrixDecompose(&scale, &rotation, &translation, initial) ? 1 : 0;
+  if (initial_decomposed_[index]) {
+    XMStoreFloat3(&initial_scales_[index], scale);
+    XMStoreFloat3(&initial_translations_[index], translation);
+  }
+}
+
+void SceneStorage::UpdateAnimations(float delta_time) {
+  const float two_pi = 2.0f * XM_PI;
+  for (const EntityId id : animated_) {
+    const std::size_t i = GetIndex(id);
+    const AnimationConfig &config = animations_[i];
+
+    // Speed is in degrees per second; keep the angle in [0, 2*pi).
+    float &angle = rotation_angles_[i];
+    angle += XMConvertToRadians(config.speed) * delta_time;
+    if (angle >= two_pi) {
+      angle -= two_pi;
+    }
+    const float total = angle + XMConvertToRadians(config.initial);
+
+    XMMATRIX rotation;
+    switch (config.axis) {
+    case AnimationConfig::RotationAxis::X:
+      rotation = XMMatrixRotationX(total);
+      break;
+    case AnimationConfig::RotationAxis::Z:
+      rotation = XMMatrixRotationZ(total);
+      break;
+    case AnimationConfig::RotationAxis::Y:
+    default:
+      rotation = XMMatrixRotationY(total);
+      break;
+    }
+
+    // Scale * NewRotation * Translation of the initial transform; if it
+    // could not be decomposed, rotate the whole initial transform.
+    XMMATRIX world;
+    if (initial_decomposed_[i]) {
+      const XMFLOAT3 &s = initial_scales_[i];
+      const XMFLOAT3 &t = initial_translations_[i];
+      world = XMMatrixScaling(s.x, s.y, s.z) * rotation *
+              XMMatrixTranslation(t.x, t.y, t.z);
+    } else {
+      world = rotation * XMLoadFloat4x4(&initial_transforms_[i]);
+    }
+    XMStoreFloat4x4(&world_matrices_[i], world);
+    MarkTransformDirty(i);
+  }
+}
+
+void SceneStorage::EnableChangeJournal(bool enable) {
+  journal_enabled_ = enable;
+  if (!enable) {
+    journal_ = ChangeJournal{};
+    std::fill(journal_changed_.begin(), journal_changed_.end(), 0);
+  }
+}
+
+void SceneStorage::DrainChanges(ChangeJournal &changes) {
+  for (const EntityId id : journal_.changed) {
+    if (IsAlive(id)) {
+      journal_changed_[GetIndex(id)] = 0;
+    }
+  }
+  changes.created.clear();
+  changes.destroyed.clear();
+  changes.changed.clear();
+  std::swap(changes, journal_);
+}
+
+void SceneStorage::UpdateWorldBounds(std::size_t index) {
+  if (!world_bounds_.has_bounds[index]) {
+    return;
+  }
+  const BoundingVolume world = local_bounds_[index].Transform(
+      XMLoadFloat4x4(&world_matrices_[index]));
+  world_bounds_.min_x[index] = world.aabb_min.x;
+  world_bounds_.min_y[index] = world.aabb_min.y;
+  world_bounds_.min_z[index] = world.aabb_min.z;
+  world_bounds_.max_x[index] = world.aabb_max.x;
+  world_bounds_.max_y[index] = world.aabb_max.y;
+  world_bounds_.max_z[index] = world.aabb_max.z;
+  world_bounds_.center_x[index] = world.sphere_center.x;
+  world_bounds_.center_y[index] = world.sphere_center.y;
+  world_bounds_.center_z[index] = world.sphere_center.z;
+  world_bounds_.radius[index] = world.sphere_radius;
+}
+
+void SceneStorage::MarkTransformDirty(std::size_t index) {
+  // Journal now, so the order of changes matches the order of calls; the
+  // bounds are recomputed in UpdateTransforms().
+  if (world_bounds_.has_bounds[index]) {
+    MarkChanged(index);
+  }
+  if (!transform_dirty_[index]) {
+    transform_dirty_[index] = 1;
+    dirty_entities_.push_back(entities_[index]);
+  }
+}
+
+void SceneStorage::MarkChanged(std::size_t index) {
+  if (journal_enabled_ && !journal_changed_[index]) {
+    journal_changed_[index] = 1;
+    journal_.changed.push_back(entities_[index]);
+  }
+}
@@ -0,0 +1,407 @@
+#include "SceneStorageTests.h"
+
+#include "Interfaces.h"
+#include "Logger.h"
+#include "RenderTag.h"
+#include "SceneStorage.h"
+
+#include <cmath>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+// Minimal handle: transform lives in the storage while attached.
+class HandleRenderable : public IRenderable {
+public:
+  void Render(const IShader &, const LayeredParameterView &,
+              ID3D11DeviceContext *) const override {}
+
+  XMMATRIX GetWorldMatrix() const noexcept override {
+    if (auto *storage = GetSceneStorage()) {
+      return storage->GetWorldMatrix(GetEntityId());
+    }
+    return world_;
+  }
+
+  void SetWorldMatrix(const XMMATRIX &world) override {
+    world_ = world;
+    if (auto *storage = GetSceneStorage()) {
+      storage->SetWorldMatrix(GetEntityId(), world);
+    }
+  }
+
+  void SetParameterCallback(ShaderParameterCallback callback) override {
+    callback_ = callback;
+  }
+
+  const ShaderParameterCallback &GetParameterCallback() const override {
+    return callback_;
+  }
+
+private:
+  XMMATRIX world_ = XMMatrixIdentity();
+  ShaderParameterCallback callback_;
+};
+
+bool NearlyEqual(float a, float b, float epsilon = 1e-4f) {
+  return std::fabs(a - b) <= epsilon;
+}
+
+bool MatricesEqual(const XMMATRIX &a, const XMMATRIX &b) {
+  XMFLOAT4X4 fa, fb;
+  XMStoreFloat4x4(&fa, a);
+  XMStoreFloat4x4(&fb, b);
+  for (int r = 0; r < 4; ++r) {
+    for (int c = 0; c < 4; ++c) {
+      if (!NearlyEqual(fa.m[r][c], fb.m[r][c])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+BoundingVolume UnitBox() {
+  const XMFLOAT3 corners[2] = {XMFLOAT3(-1.0f, -1.0f, -1.0f),
+                               XMFLOAT3(1.0f, 1.0f, 1.0f)};
+  BoundingVolume bounds;
+  bounds.CalculateFromVertices(corners, 2);
+  return bounds;
+}
+
+bool TestTagRegistryAssignsStableBits(std::string &message) {
+  auto &registry = TagRegistry::GetInstance();
+  const TagMask a = registry.GetBit("test_tag_a");
+  const TagMask b = registry.GetBit("test_tag_b");
+  if (a == 0 || b == 0 || a == b || (a & (a - 1)) != 0) {
+    message = "tags must map to distinct single bits";
+    return false;
+  }
+  if (registry.GetBit("test_tag_a") != a ||
+      registry.FindBit("test_tag_b") != b) {
+    message = "tag bits are not stable";
+    return false;
+  }
+  if (registry.FindBit("test_tag_never_registered") != 0) {
+    message = "FindBit registered a tag";
+    return false;
+  }
+  const auto names = registry.GetNames(a | b);
+  return registry.MakeMask({"test_tag_a", "test_tag_b"}) == (a | b) &&
+         names.size() == 2 && names[0] == "test_tag_a" &&
+         names[1] == "test_tag_b";
+}
+
+bool TestDestroyKeepsArraysDense(std::string &message) {
+  SceneStorage storage;
+  std::vector<EntityId> ids;
+  for (int i = 0; i < 4; ++i) {
+    ids.push_back(storage.Create(nullptr,
+                                 XMMatrixTranslation(float(i), 0.0f, 0.0f),
+                                 TagMask{1} << i));
+  }
+  storage.Destroy(ids[1]);
+
+  if (storage.GetCount() != 3 || storage.IsAlive(ids[1])) {
+    message = "destroyed entity still present";
+    return false;
+  }
+  // The last entity moved into the hole; its data moved with it.
+  if (storage.GetIndex(ids[3]) != 1 ||
+      storage.GetTagMask(ids[3]) != (TagMask{1} << 3) ||
+      !MatricesEqual(storage.GetWorldMatrix(ids[3]),
+                     XMMatrixTranslation(3.0f, 0.0f, 0.0f))) {
+    message = "moved entity lost its data";
+    return false;
+  }
+
+  // Ids are reused, never duplicated among live entities.
+  const EntityId reused = storage.Create(nullptr, XMMatrixIdentity(), 0);
+  if (reused != ids[1] || storage.GetEntity(storage.GetIndex(reused)) !=
+                              reused) {
+    message = "free id was not reused";
+    return false;
+  }
+  return storage.GetCount() == 4;
+}
+
+bool TestWorldBoundsFollowTransform(std::string &message) {
+  SceneStorage storage;
+  const EntityId id = storage.Create(nullptr, XMMatrixIdentity(), 0);
+  if (storage.HasBounds(id)) {
+    message = "entity without local bounds reports bounds";
+    return false;
+  }
+  storage.SetLocalBounds(id, UnitBox());
+  storage.SetWorldMatrix(id, XMMatrixScaling(2.0f, 2.0f, 2.0f) *
+                                 XMMatrixTranslation(10.0f, 0.0f, -5.0f));
+  if (!storage.IsTransformDirty(id) || storage.UpdateTransforms() != 1 ||
+      storage.IsTransformDirty(id)) {
+    message = "transform change not flushed by UpdateTransforms";
+    return false;
+  }
+
+  const BoundingVolume world = storage.GetWorldBounds(id);
+  const auto &columns = storage.GetWorldBoundsColumns();
+  const std::size_t i = storage.GetIndex(id);
+  if (!NearlyEqual(world.aabb_min.x, 8.0f) ||
+      !NearlyEqual(world.aabb_max.x, 12.0f) ||
+      !NearlyEqual(world.aabb_min.z, -7.0f) ||
+      !NearlyEqual(world.aabb_max.z, -3.0f)) {
+    message = "world AABB does not follow the transform";
+    return false;
+  }
+  return columns.has_bounds[i] == 1 && NearlyEqual(columns.min_x[i], 8.0f) &&
+         NearlyEqual(world.sphere_center.x, 10.0f) &&
+         world.sphere_radius > 0.0f;
+}
+
+bool TestCollectByMask(std::string &message) {
+  SceneStorage storage;
+  const TagMask depth = TagMask{1} << 0;
+  const TagMask final_pass = TagMask{1} << 1;
+  const TagMask pbr = TagMask{1} << 2;
+  storage.Create(nullptr, XMMatrixIdentity(), depth | final_pass);
+  storage.Create(nullptr, XMMatrixIdentity(), pbr);
+  storage.Create(nullptr, XMMatrixIdentity(), depth | pbr);
+  storage.Create(nullptr, XMMatrixIdentity(), 0);
+
+  std::vector<std::uint32_t> indices;
+  storage.CollectByMask(final_pass | pbr, indices);
+  if (indices != std::vector<std::uint32_t>{0, 1, 2}) {
+    message = "wrong entities for final|pbr";
+    return false;
+  }
+  storage.CollectByMask(depth, indices);
+  return indices == std::vector<std::uint32_t>{0, 2};
+}
+
+bool TestAnimationRotatesAboutInitialTransform(std::string &message) {
+  SceneStorage storage;
+  const XMMATRIX initial = XMMatrixScaling(0.5f, 0.5f, 0.5f) *
+                           XMMatrixTranslation(1.0f, 2.0f, 3.0f);
+  const EntityId id = storage.Create(nullptr, initial, 0);
+  storage.SetAnimation(
+      id, AnimationConfig(AnimationConfig::RotationAxis::Y, 90.0f, 0.0f));
+
+  storage.UpdateAnimations(1.0f); // 90 degrees
+  const XMMATRIX expected = XMMatrixScaling(0.5f, 0.5f, 0.5f) *
+                            XMMatrixRotationY(XM_PI / 2.0f) *
+                            XMMatrixTranslation(1.0f, 2.0f, 3.0f);
+  if (!MatricesEqual(storage.GetWorldMatrix(id), expected)) {
+    message = "rotation after one step differs from S*R*T";
+    return false;
+  }
+
+  // Four more quarter turns wrap back to the same pose.
+  for (int i = 0; i < 4; ++i) {
+    storage.UpdateAnimations(1.0f);
+  }
+  if (!MatricesEqual(storage.GetWorldMatrix(id), expected)) {
+    message = "rotation did not wrap";
+    return false;
+  }
+  return storage.GetAnimation(id).enabled;
+}
+
+bool TestRenderableActsAsHandle(std::string &message) {
+  auto storage = std::make_unique<SceneStorage>();
+  auto renderable = std::make_unique<HandleRenderable>();
+  renderable->AddTag("test_handle_before");
+
+  const EntityId id = storage->Create(
+      renderable.get(), renderable->GetWorldMatrix(), renderable->GetTagMask());
+  if (renderable->GetSceneStorage() != storage.get() ||
+      renderable->GetEntityId() != id) {
+    message = "renderable not attached";
+    return false;
+  }
+
+  // Tags and transforms set through the handle land in the storage.
+  renderable->AddTag("test_handle_after");
+  const TagMask after = TagRegistry::GetInstance().FindBit("test_handle_after");
+  renderable->SetWorldMatrix(XMMatrixTranslation(0.0f, 5.0f, 0.0f));
+  if ((storage->GetTagMask(id) & after) == 0 ||
+      !MatricesEqual(storage->GetWorldMatrix(id),
+                     XMMatrixTranslation(0.0f, 5.0f, 0.0f))) {
+    message = "handle writes did not reach the storage";
+    return false;
+  }
+  renderable->RemoveTag("test_handle_after");
+  if (storage->GetTagMask(id) & after) {
+    message = "removed tag still in the storage mask";
+    return false;
+  }
+
+  // Destroying the object removes its entity.
+  renderable.reset();
+  if (storage->IsAlive(id) || storage->GetCount() != 0) {
+    message = "destroyed renderable left its entity behind";
+    return false;
+  }
+
+  // Destroying the storage detaches surviving objects.
+  auto survivor = std::make_unique<HandleRenderable>();
+  storage->Create(survivor.get(), XMMatrixIdentity(), 0);
+  storage.reset();
+  return survivor->GetSceneStorage() == nullptr &&
+         survivor->GetEntityId() == kInvalidEntity;
+}
+
+bool TestChangeJournal(std::string &message) {
+  SceneStorage storage;
+  const EntityId before = storage.Create(nullptr, XMMatrixIdentity(), 0);
+  storage.EnableChangeJournal(true);
+
+  const EntityId a = storage.Create(nullptr, XMMatrixIdentity(), 0);
+  storage.SetLocalBounds(a, UnitBox());
+  storage.SetLocalBounds(before, UnitBox());
+  storage.SetWorldMatrix(before, XMMatrixTranslation(1.0f, 0.0f, 0.0f));
+  storage.SetTagMask(before, TagMask{4});
+
+  SceneStorage::ChangeJournal changes;
+  storage.DrainChanges(changes);
+  if (changes.created != std::vector<EntityId>{a} ||
+      changes.changed != std::vector<EntityId>{a, before} ||
+      !changes.destroyed.empty()) {
+    message = "first frame journal wrong";
+    return false;
+  }
+
+  // Drained: the next frame starts empty and records again.
+  storage.SetTagMask(before, TagMask{4}); // Unchanged value
+  storage.Destroy(a);
+  storage.DrainChanges(changes);
+  if (!changes.created.empty() || !changes.changed.empty() ||
+      changes.destroyed != std::vector<EntityId>{a}) {
+    message = "second frame journal wrong";
+    return false;
+  }
+
+  storage.EnableChangeJournal(false);
+  storage.SetWorldMatrix(before, XMMatrixIdentity());
+  storage.DrainChanges(changes);
+  return changes.changed.empty();
+}
+
+bool TestOnlyChangedTransformsAreUpdated(std::string &message) {
+  SceneStorage storage;
+  std::vector<EntityId> ids;
+  for (int i = 0; i < 100; ++i) {
+    const EntityId id = storage.Create(
+        nullptr, XMMatrixTranslation(static_cast<float>(i), 0.0f, 0.0f), 0);
+    storage.SetLocalBounds(id, UnitBox());
+    ids.push_back(id);
+  }
+  if (storage.UpdateTransforms() != 100 || storage.UpdateTransforms() != 0) {
+    message = "initial bounds not computed exactly once";
+    return false;
+  }
+
+  // Re-setting identical matrices does not dirty static entities.
+  for (int i = 0; i < 100; ++i) {
+    storage.SetWorldMatrix(
+        ids[i], XMMatrixTranslation(static_cast<float>(i), 0.0f, 0.0f));
+  }
+  if (storage.UpdateTransforms() != 0) {
+    message = "identical matrix marked the transform dirty";
+    return false;
+  }
+
+  // Moving one entity twice and animating another: two updates.
+  storage.SetWorldMatrix(ids[5], XMMatrixTranslation(0.0f, 1.0f, 0.0f));
+  storage.SetWorldMatrix(ids[5], XMMatrixTranslation(0.0f, 2.0f, 0.0f));
+  storage.SetAnimation(
+      ids[7], AnimationConfig(AnimationConfig::RotationAxis::Y, 90.0f));
+  storage.UpdateAnimations(1.0f);
+  if (storage.GetAnimatedCount() != 1 || storage.UpdateTransforms() != 2 ||
+      !NearlyEqual(storage.GetWorldBounds(ids[5]).aabb_min.y, 1.0f)) {
+    message = "changed entities not updated once each";
+    return false;
+  }
+
+  // Dirty entities destroyed before the flush are skipped.
+  storage.SetWorldMatrix(ids[9], XMMatrixIdentity());
+  storage.Destroy(ids[9]);
+  storage.Destroy(ids[7]);
+  storage.UpdateAnimations(1.0f);
+  if (storage.GetAnimatedCount() != 0 || storage.UpdateTransforms() != 0) {
+    message = "destroyed entity still updated";
+    return false;
+  }
+  return true;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(8);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("TagRegistry assigns stable bits", TestTagRegistryAssignsStableBits);
+  run("Destroy keeps arrays dense", TestDestroyKeepsArraysDense);
+  run("World bounds follow the transform", TestWorldBoundsFollowTransform);
+  run("CollectByMask matches any tag", TestCollectByMask);
+  run("Animation rotates about the initial transform",
+      TestAnimationRotatesAboutInitialTransform);
+  run("IRenderable acts as a handle", TestRenderableActsAsHandle);
+  run("Only changed transforms are updated",
+      TestOnlyChangedTransformsAreUpdated);
+  run("Change journal records each entity once", TestChangeJournal);
+
+  return results;
+}
+
+} // namespace
+
+bool RunSceneStorageTests() {
+  const auto results = RunAllTestsInternal();
+  bool all_passed = true;
+
+  for (const auto &result : results) {
+    if (!result.passed) {
+      all_passed = false;
+      std::ostringstream oss;
+      oss << "Test failed: " << result.name;
+      if (!result.message.empty()) {
+        oss << " - " << result.message;
+      }
+      Logger::SetModule("SceneStorageTests");
+      Logger::LogError(oss.str());
+    }
+  }
+
+  if (all_passed) {
+    Logger::SetModule("SceneStorageTests");
+    Logger::LogInfo("All SceneStorage tests passed");
+  }
+
+  return all_passed;
+}
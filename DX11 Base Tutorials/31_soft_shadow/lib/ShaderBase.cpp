@@ -2,6 +2,7 @@
 
 #include "../../CommonFramework2/DirectX11Device.h"
 #include "Logger.h"
+#include <cstring>
 #include <d3dcompiler.h>
 #include <fstream>
 #include <iostream>
@@ -16,6 +17,111 @@ void ShaderBase::Shutdown() {
   pixel_shader_.Reset();
   layout_.Reset();
   sampler_state_.Reset();
+  plan_buffers_.clear();
+  binding_plan_.reset();
+}
+
+void ShaderBase::EnableBindingPlan(ShaderBindingPlan::AliasMap aliases,
+                                   ShaderParameterContainer defaults) {
+  binding_plan_enabled_ = true;
+  binding_aliases_ = std::move(aliases);
+  binding_defaults_ = std::move(defaults);
+}
+
+ShaderBindingPlan ShaderBase::BuildBindingPlan() const {
+  return ShaderBindingPlan::Build(reflection_layout_, binding_aliases_,
+                                  &binding_defaults_);
+}
+
+bool ShaderBase::SetBindingPlan(std::shared_ptr<const ShaderBindingPlan> plan,
+                                ID3D11Device *device) {
+  plan_buffers_.clear();
+  {
+    std::lock_guard<std::mutex> lock(plan_staging_mutex_);
+    plan_staging_.clear();
+  }
+  binding_plan_.reset();
+  if (!plan || device == nullptr) {
+    return plan == nullptr;
+  }
+
+  for (const auto &buffer : plan->GetConstantBuffers()) {
+    Microsoft::WRL::ComPtr<ID3D11Buffer> device_buffer;
+    if (!CreateConstantBuffer(buffer.size, device_buffer.GetAddressOf(),
+                              device)) {
+      Logger::SetModule("ShaderBase");
+      Logger::LogError("Failed to create plan constant buffer '" +
+                       buffer.name + "' for " + shader_name_);
+      plan_buffers_.clear();
+      return false;
+    }
+    plan_buffers_.push_back(device_buffer);
+  }
+
+  upload_cache_.Reset(*plan);
+  binding_plan_ = std::move(plan);
+  return true;
+}
+
+bool ShaderBase::ApplyBindingPlan(const LayeredParameterView &parameters,
+                                  ID3D11DeviceContext *deviceContext) const {
+  const auto &buffers = binding_plan_->GetConstantBuffers();
+
+  // A context is only ever used by one thread at a time, so the staging set
+  // is exclusive once looked up; map nodes stay put across inserts.
+  std::vector<std::vector<std::uint8_t>> *staging_set = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(plan_staging_mutex_);
+    staging_set = &plan_staging_[deviceContext];
+  }
+  if (staging_set->empty()) {
+    for (const auto &buffer : buffers) {
+      staging_set->emplace_back(buffer.size, std::uint8_t{0});
+    }
+  }
+
+  // Deferred contexts start every command list with discarded buffers, so
+  // skipping an upload is only valid on the immediate context.
+  const bool immediate =
+      deviceContext->GetType() == D3D11_DEVICE_CONTEXT_IMMEDIATE;
+  for (std::size_t i = 0; i < buffers.size(); ++i) {
+    auto &staging = (*staging_set)[i];
+    binding_plan_->GatherConstantBuffer(i, parameters, staging.data());
+
+    ID3D11Buffer *device_buffer = plan_buffers_[i].Get();
+    if (!immediate ||
+        upload_cache_.ShouldUpload(i, staging.data(), staging.size())) {
+      D3D11_MAPPED_SUBRESOURCE mappedResource;
+      if (FAILED(deviceContext->Map(device_buffer, 0, D3D11_MAP_WRITE_DISCARD,
+                                    0, &mappedResource))) {
+        if (immediate) {
+          upload_cache_.Invalidate();
+        }
+        return false;
+      }
+      std::memcpy(mappedResource.pData, staging.data(), staging.size());
+      deviceContext->Unmap(device_buffer, 0);
+    }
+
+    if (buffers[i].stage == ShaderStage::Vertex) {
+      deviceContext->VSSetConstantBuffers(buffers[i].slot, 1, &device_buffer);
+    } else if (buffers[i].stage == ShaderStage::Pixel) {
+      deviceContext->PSSetConstantBuffers(buffers[i].slot, 1, &device_buffer);
+    }
+  }
+
+  const auto &resources = binding_plan_->GetResources();
+  for (std::size_t i = 0; i < resources.size(); ++i) {
+    ID3D11ShaderResourceView *srv =
+        binding_plan_->ResolveResource(i, parameters);
+    if (resources[i].stage == ShaderStage::Vertex) {
+      deviceContext->VSSetShaderResources(resources[i].slot, 1, &srv);
+    } else if (resources[i].stage == ShaderStage::Pixel) {
+      deviceContext->PSSetShaderResources(resources[i].slot, 1, &srv);
+    }
+  }
+
+  return true;
 }
 
 bool ShaderBase::InitializeShaderFromFile(
@@ -79,6 +185,8 @@ bool ShaderBase::InitializeShaderFromFile(
 
   reflected_parameters_ =
       ReflectShader(device, vertexShaderBuffer.Get(), pixelShaderBuffer.Get());
+  reflection_layout_ =
+      ReflectShaderLayout(vertexShaderBuffer.Get(), pixelShaderBuffer.Get());
 
   // Create input layout
   result = device->CreateInputLayout(
@@ -0,0 +1,305 @@
+#include "ShaderBindingPlan.h"
+
+#include <DirectXMath.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+std::uint32_t ValueSize(ShaderParameterType type) {
+  switch (type) {
+  case ShaderParameterType::Matrix:
+    return sizeof(DirectX::XMFLOAT4X4);
+  case ShaderParameterType::Vector4:
+    return sizeof(DirectX::XMFLOAT4);
+  case ShaderParameterType::Vector3:
+    return sizeof(DirectX::XMFLOAT3);
+  case ShaderParameterType::Float:
+    return sizeof(float);
+  default:
+    return 0;
+  }
+}
+
+bool IsConstantBufferType(ShaderParameterType type) {
+  return ValueSize(type) != 0;
+}
+
+const char *StageLabel(ShaderStage stage) {
+  switch (stage) {
+  case ShaderStage::Vertex:
+    return "VS";
+  case ShaderStage::Pixel:
+    return "PS";
+  case ShaderStage::Geometry:
+    return "GS";
+  case ShaderStage::Hull:
+    return "HS";
+  case ShaderStage::Domain:
+    return "DS";
+  case ShaderStage::Compute:
+    return "CS";
+  default:
+    return "??";
+  }
+}
+
+// Resolves the parameter id for a reflected name and, when aliased, the id of
+// the reflected name itself as a fallback.
+void ResolveIds(const std::string &reflected_name,
+                const ShaderBindingPlan::AliasMap &aliases,
+                ShaderParameterId &parameter, ShaderParameterId &fallback) {
+  auto alias_it = aliases.find(reflected_name);
+  if (alias_it == aliases.end()) {
+    parameter = ShaderParameterRegistry::Intern(reflected_name);
+    fallback = kInvalidShaderParameterId;
+    return;
+  }
+  parameter = ShaderParameterRegistry::Intern(alias_it->second);
+  fallback = ShaderParameterRegistry::Intern(reflected_name);
+}
+
+const ShaderParameterContainer::ParamValue *
+FindDefault(const ShaderParameterContainer *defaults,
+            ShaderParameterId parameter, ShaderParameterId fallback) {
+  if (defaults == nullptr) {
+    return nullptr;
+  }
+  if (const auto *value = defaults->Find(parameter)) {
+    return value;
+  }
+  return defaults->Find(fallback);
+}
+
+const ShaderParameterContainer::ParamValue *
+FindValue(const LayeredParameterView &parameters, ShaderParameterId parameter,
+          ShaderParameterId fallback) {
+  if (const auto *value = parameters.Find(parameter)) {
+    return value;
+  }
+  if (fallback != kInvalidShaderParameterId) {
+    return parameters.Find(fallback);
+  }
+  return nullptr;
+}
+
+[[noreturn]] void ThrowTypeMismatch(ShaderParameterId parameter) {
+  throw std::runtime_error("Type mismatch for parameter: " +
+                           ShaderParameterRegistry::GetName(parameter));
+}
+
+void WriteField(const ConstantBufferFieldBinding &field,
+                const ShaderParameterContainer::ParamValue &value,
+                std::uint8_t *destination) {
+  std::uint8_t *target = destination + field.offset;
+  switch (field.type) {
+  case ShaderParameterType::Matrix: {
+    const auto *matrix = std::get_if<DirectX::XMMATRIX>(&value);
+    if (matrix == nullptr) {
+      ThrowTypeMismatch(field.parameter);
+    }
+    DirectX::XMFLOAT4X4 stored;
+    DirectX::XMStoreFloat4x4(
+        &stored, field.transpose ? DirectX::XMMatrixTranspose(*matrix)
+                                 : *matrix);
+    std::memcpy(target, &stored, field.size);
+    break;
+  }
+  case ShaderParameterType::Vector4: {
+    const auto *vector = std::get_if<DirectX::XMFLOAT4>(&value);
+    if (vector == nullptr) {
+      ThrowTypeMismatch(field.parameter);
+    }
+    std::memcpy(target, vector, field.size);
+    break;
+  }
+  case ShaderParameterType::Vector3: {
+    const auto *vector = std::get_if<DirectX::XMFLOAT3>(&value);
+    if (vector == nullptr) {
+      ThrowTypeMismatch(field.parameter);
+    }
+    std::memcpy(target, vector, field.size);
+    break;
+  }
+  case ShaderParameterType::Float: {
+    const auto *scalar = std::get_if<float>(&value);
+    if (scalar == nullptr) {
+      ThrowTypeMismatch(field.parameter);
+    }
+    std::memcpy(target, scalar, field.size);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+} // namespace
+
+ShaderBindingPlan
+ShaderBindingPlan::Build(const ShaderReflectionLayout &layout,
+                         const AliasMap &aliases,
+                         const ShaderParameterContainer *defaults) {
+  ShaderBindingPlan plan;
+
+  for (const auto &reflected_buffer : layout.constant_buffers) {
+    ConstantBufferBinding buffer;
+    buffer.name = reflected_buffer.name;
+    buffer.stage = reflected_buffer.stage;
+    buffer.slot = reflected_buffer.bind_slot;
+    buffer.size = reflected_buffer.size;
+    buffer.initial_contents.assign(buffer.size, 0);
+
+    for (const auto &variable : reflected_buffer.variables) {
+      // Padding and compiler-stripped variables keep their zero bytes.
+      if (!variable.used || !IsConstantBufferType(variable.type)) {
+        continue;
+      }
+
+      ConstantBufferFieldBinding field;
+      ResolveIds(variable.name, aliases, field.parameter,
+                 field.fallback_parameter);
+      field.type = variable.type;
+      field.offset = variable.offset;
+      field.size = (std::min)(variable.size, ValueSize(variable.type));
+      field.transpose = variable.column_major;
+      if (field.offset + field.size > buffer.size) {
+        throw std::runtime_error("ShaderBindingPlan: variable '" +
+                                 variable.name + "' exceeds constant buffer '" +
+                                 buffer.name + "'");
+      }
+
+      if (const auto *default_value =
+              FindDefault(defaults, field.parameter, field.fallback_parameter)) {
+        WriteField(field, *default_value, buffer.initial_contents.data());
+        field.has_default = true;
+      }
+      buffer.fields.push_back(field);
+    }
+
+    // Gathering in offset order keeps the writes sequential.
+    std::sort(buffer.fields.begin(), buffer.fields.end(),
+              [](const ConstantBufferFieldBinding &lhs,
+                 const ConstantBufferFieldBinding &rhs) {
+                return lhs.offset < rhs.offset;
+              });
+    plan.constant_buffers_.push_back(std::move(buffer));
+  }
+
+  for (const auto &reflected_resource : layout.resources) {
+    if (reflected_resource.type != ShaderParameterType::Texture) {
+      continue; // Samplers stay owned by the shader.
+    }
+
+    ShaderResourceBinding resource;
+    ResolveIds(reflected_resource.name, aliases, resource.parameter,
+               resource.fallback_parameter);
+    resource.stage = reflected_resource.stage;
+    resource.slot = reflected_resource.bind_slot;
+    if (const auto *default_value = FindDefault(
+            defaults, resource.parameter, resource.fallback_parameter)) {
+      if (const auto *srv =
+              std::get_if<ID3D11ShaderResourceView *>(default_value)) {
+        resource.has_default = true;
+        resource.default_value = *srv;
+      }
+    }
+    plan.resources_.push_back(resource);
+  }
+
+  return plan;
+}
+
+void ShaderBindingPlan::GatherConstantBuffer(
+    std::size_t index, const LayeredParameterView &parameters,
+    std::uint8_t *destination) const {
+  const auto &buffer = constant_buffers_[index];
+  std::memcpy(destination, buffer.initial_contents.data(), buffer.size);
+
+  for (const auto &field : buffer.fields) {
+    const auto *value =
+        FindValue(parameters, field.parameter, field.fallback_parameter);
+    if (value == nullptr) {
+      if (field.has_default) {
+        continue;
+      }
+      throw std::runtime_error("Parameter not found: " +
+                               ShaderParameterRegistry::GetName(field.parameter));
+    }
+    WriteField(field, *value, destination);
+  }
+}
+
+ID3D11ShaderResourceView *
+ShaderBindingPlan::ResolveResource(std::size_t index,
+                                   const LayeredParameterView &parameters) const {
+  const auto &resource = resources_[index];
+  const auto *value =
+      FindValue(parameters, resource.parameter, resource.fallback_parameter);
+  if (value == nullptr) {
+    if (resource.has_default) {
+      return resource.default_value;
+    }
+    throw std::runtime_error(
+        "Parameter not found: " +
+        ShaderParameterRegistry::GetName(resource.parameter));
+  }
+  if (const auto *srv = std::get_if<ID3D11ShaderResourceView *>(value)) {
+    return *srv;
+  }
+  ThrowTypeMismatch(resource.parameter);
+}
+
+std::string ShaderBindingPlan::Describe() const {
+  std::ostringstream oss;
+  for (const auto &buffer : constant_buffers_) {
+    oss << "    cbuffer " << buffer.name << " (" << StageLabel(buffer.stage)
+        << " b" << buffer.slot << ", " << buffer.size << " bytes)\n";
+    for (const auto &field : buffer.fields) {
+      oss << "      +" << field.offset << " "
+          << ShaderParameterRegistry::GetName(field.parameter) << " ["
+          << ShaderParameterTypeToString(field.type) << ", " << field.size
+          << " bytes" << (field.transpose ? ", transposed" : "")
+          << (field.has_default ? ", default" : "") << "]\n";
+    }
+  }
+  for (const auto &resource : resources_) {
+    oss << "    srv " << ShaderParameterRegistry::GetName(resource.parameter)
+        << " (" << StageLabel(resource.stage) << " t" << resource.slot << ")"
+        << (resource.has_default ? " [default]" : "") << "\n";
+  }
+  return oss.str();
+}
+
+void ConstantBufferUploadCache::Reset(const ShaderBindingPlan &plan) {
+  const auto &buffers = plan.GetConstantBuffers();
+  last_contents_.resize(buffers.size());
+  for (std::size_t i = 0; i < buffers.size(); ++i) {
+    last_contents_[i].assign(buffers[i].size, 0);
+  }
+  valid_.assign(buffers.size(), false);
+  upload_count_ = 0;
+  skipped_count_ = 0;
+}
+
+bool ConstantBufferUploadCache::ShouldUpload(std::size_t index,
+                                             const std::uint8_t *contents,
+                                             std::size_t size) {
+  auto &last = last_contents_[index];
+  if (valid_[index] && last.size() == size &&
+      std::memcmp(last.data(), contents, size) == 0) {
+    ++skipped_count_;
+    return false;
+  }
+  last.assign(contents, contents + size);
+  valid_[index] = true;
+  ++upload_count_;
+  return true;
+}
+
+void ConstantBufferUploadCache::Invalidate() {
+  std::fill(valid_.begin(), valid_.end(), false);
+}
@@ -0,0 +1,318 @@
+#include "ShaderBindingPlanTests.h"
+
+#include "LayeredParameterView.h"
+#include "Logger.h"
+#include "ShaderBindingPlan.h"
+#include "ShaderParameter.h"
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+ReflectedConstantBufferVariable MakeVariable(const std::string &name,
+                                             ShaderParameterType type,
+                                             std::uint32_t offset,
+                                             std::uint32_t size,
+                                             bool column_major = false) {
+  ReflectedConstantBufferVariable variable;
+  variable.name = name;
+  variable.type = type;
+  variable.offset = offset;
+  variable.size = size;
+  variable.column_major = column_major;
+  return variable;
+}
+
+ReflectedResourceBinding MakeTexture(const std::string &name,
+                                     std::uint32_t slot) {
+  ReflectedResourceBinding resource;
+  resource.name = name;
+  resource.type = ShaderParameterType::Texture;
+  resource.stage = ShaderStage::Pixel;
+  resource.bind_slot = slot;
+  return resource;
+}
+
+// Mirrors softshadow.vs/ps: a column_major MatrixBuffer, a float3 with
+// trailing padding, a scalar buffer and three pixel shader textures.
+ShaderReflectionLayout MakeSoftShadowLayout() {
+  ShaderReflectionLayout layout;
+
+  ReflectedConstantBuffer matrices;
+  matrices.name = "MatrixBuffer";
+  matrices.stage = ShaderStage::Vertex;
+  matrices.bind_slot = 0;
+  matrices.size = 192;
+  matrices.variables = {
+      MakeVariable("worldMatrix", ShaderParameterType::Matrix, 0, 64, true),
+      MakeVariable("viewMatrix", ShaderParameterType::Matrix, 64, 64, true),
+      MakeVariable("projectionMatrix", ShaderParameterType::Matrix, 128, 64,
+                   true)};
+  layout.constant_buffers.push_back(matrices);
+
+  ReflectedConstantBuffer light;
+  light.name = "LightBuffer2";
+  light.stage = ShaderStage::Vertex;
+  light.bind_slot = 1;
+  light.size = 16;
+  light.variables = {
+      MakeVariable("lightPosition", ShaderParameterType::Vector3, 0, 12),
+      MakeVariable("padding", ShaderParameterType::Float, 12, 4)};
+  light.variables[1].used = false;
+  layout.constant_buffers.push_back(light);
+
+  ReflectedConstantBuffer shadow;
+  shadow.name = "ShadowControlBuffer";
+  shadow.stage = ShaderStage::Pixel;
+  shadow.bind_slot = 1;
+  shadow.size = 16;
+  shadow.variables = {
+      MakeVariable("shadowStrength", ShaderParameterType::Float, 0, 4)};
+  layout.constant_buffers.push_back(shadow);
+
+  layout.resources = {MakeTexture("shaderTexture", 0),
+                      MakeTexture("shadowTexture", 1),
+                      MakeTexture("reflectionTexture", 2)};
+  ReflectedResourceBinding sampler;
+  sampler.name = "SampleTypeClamp";
+  sampler.type = ShaderParameterType::Sampler;
+  sampler.stage = ShaderStage::Pixel;
+  layout.resources.push_back(sampler);
+  return layout;
+}
+
+ShaderParameterContainer MakeDrawParameters() {
+  ShaderParameterContainer parameters;
+  parameters.SetMatrix("worldMatrix",
+                       DirectX::XMMatrixTranslation(1.0f, 2.0f, 3.0f));
+  parameters.SetMatrix("viewMatrix", DirectX::XMMatrixIdentity());
+  parameters.SetMatrix("projectionMatrix", DirectX::XMMatrixIdentity());
+  parameters.SetVector3("lightPosition", DirectX::XMFLOAT3(4.0f, 5.0f, 6.0f));
+  parameters.SetFloat("shadowStrength", 0.25f);
+  parameters.SetTexture("texture",
+                        reinterpret_cast<ID3D11ShaderResourceView *>(0x10));
+  parameters.SetTexture("shadowTexture",
+                        reinterpret_cast<ID3D11ShaderResourceView *>(0x20));
+  return parameters;
+}
+
+ShaderBindingPlan BuildSoftShadowPlan() {
+  ShaderParameterContainer defaults;
+  defaults.SetTexture("reflectionTexture", nullptr);
+  return ShaderBindingPlan::Build(MakeSoftShadowLayout(),
+                                  {{"shaderTexture", "texture"}}, &defaults);
+}
+
+std::vector<std::uint8_t> Gather(const ShaderBindingPlan &plan,
+                                 std::size_t index,
+                                 const LayeredParameterView &parameters) {
+  std::vector<std::uint8_t> bytes(plan.GetConstantBuffers()[index].size, 0xCD);
+  plan.GatherConstantBuffer(index, parameters, bytes.data());
+  return bytes;
+}
+
+float ReadFloat(const std::vector<std::uint8_t> &bytes, std::size_t offset) {
+  float value = 0.0f;
+  std::memcpy(&value, bytes.data() + offset, sizeof(float));
+  return value;
+}
+
+bool TestMatrixOffsetsAndTranspose() {
+  const auto plan = BuildSoftShadowPlan();
+  const auto parameters = MakeDrawParameters();
+  const auto bytes = Gather(plan, 0, parameters);
+
+  // Translation sits in row 3 of the row-major XMMATRIX; transposed for a
+  // column_major cbuffer it lands in column 3 (_14, _24, _34).
+  return ReadFloat(bytes, 3 * sizeof(float)) == 1.0f &&
+         ReadFloat(bytes, 7 * sizeof(float)) == 2.0f &&
+         ReadFloat(bytes, 11 * sizeof(float)) == 3.0f &&
+         ReadFloat(bytes, 12 * sizeof(float)) == 0.0f &&
+         ReadFloat(bytes, 64) == 1.0f && ReadFloat(bytes, 128 + 20) == 1.0f;
+}
+
+bool TestPaddingIsZeroed() {
+  const auto plan = BuildSoftShadowPlan();
+  const auto parameters = MakeDrawParameters();
+  const auto light = Gather(plan, 1, parameters);
+  const auto shadow = Gather(plan, 2, parameters);
+
+  return plan.GetConstantBuffers()[1].fields.size() == 1 &&
+         ReadFloat(light, 0) == 4.0f && ReadFloat(light, 8) == 6.0f &&
+         ReadFloat(light, 12) == 0.0f && ReadFloat(shadow, 0) == 0.25f &&
+         ReadFloat(shadow, 4) == 0.0f && ReadFloat(shadow, 12) == 0.0f;
+}
+
+bool TestLayersResolveThroughPlan() {
+  const auto plan = BuildSoftShadowPlan();
+  const auto global_parameters = MakeDrawParameters();
+  ShaderParameterContainer pass_parameters;
+  pass_parameters.SetFloat("shadowStrength", 0.75f);
+
+  LayeredParameterView view(global_parameters);
+  view.PushLayer(pass_parameters);
+  return ReadFloat(Gather(plan, 2, view), 0) == 0.75f;
+}
+
+bool TestMissingFieldThrowsAndDefaultApplies() {
+  ShaderParameterContainer defaults;
+  defaults.SetFloat("shadowStrength", 1.0f);
+  const auto plan =
+      ShaderBindingPlan::Build(MakeSoftShadowLayout(), {}, &defaults);
+
+  ShaderParameterContainer without_strength;
+  without_strength.SetVector3("lightPosition",
+                              DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f));
+  if (ReadFloat(Gather(plan, 2, without_strength), 0) != 1.0f) {
+    return false;
+  }
+
+  // lightPosition has no default: gathering without it must throw.
+  ShaderParameterContainer empty;
+  try {
+    Gather(plan, 1, empty);
+  } catch (const std::runtime_error &) {
+    return true;
+  }
+  return false;
+}
+
+bool TestResourceSlotsAliasesAndDefaults() {
+  const auto plan = BuildSoftShadowPlan();
+  const auto &resources = plan.GetResources();
+  if (resources.size() != 3) {
+    return false; // the sampler must not become an SRV binding
+  }
+
+  auto parameters = MakeDrawParameters();
+  if (resources[0].slot != 0 || resources[1].slot != 1 ||
+      resources[2].slot != 2 ||
+      plan.ResolveResource(0, parameters) !=
+          reinterpret_cast<ID3D11ShaderResourceView *>(0x10) ||
+      plan.ResolveResource(1, parameters) !=
+          reinterpret_cast<ID3D11ShaderResourceView *>(0x20) ||
+      plan.ResolveResource(2, parameters) != nullptr) {
+    return false;
+  }
+
+  // The reflected name works as a fallback for an aliased parameter.
+  ShaderParameterContainer reflected_names;
+  reflected_names.SetTexture(
+      "shaderTexture", reinterpret_cast<ID3D11ShaderResourceView *>(0x30));
+  return plan.ResolveResource(0, reflected_names) ==
+         reinterpret_cast<ID3D11ShaderResourceView *>(0x30);
+}
+
+bool TestTypeMismatchThrows() {
+  const auto plan = BuildSoftShadowPlan();
+  ShaderParameterContainer parameters;
+  parameters.SetVector4("shadowStrength",
+                        DirectX::XMFLOAT4(1.0f, 0.0f, 0.0f, 0.0f));
+  try {
+    Gather(plan, 2, parameters);
+  } catch (const std::runtime_error &) {
+    return true;
+  }
+  return false;
+}
+
+bool TestUploadCacheSkipsIdenticalContents() {
+  const auto plan = BuildSoftShadowPlan();
+  ConstantBufferUploadCache cache;
+  cache.Reset(plan);
+
+  auto parameters = MakeDrawParameters();
+  auto bytes = Gather(plan, 2, parameters);
+  const bool first = cache.ShouldUpload(2, bytes.data(), bytes.size());
+  const bool repeated = cache.ShouldUpload(2, bytes.data(), bytes.size());
+
+  parameters.SetFloat("shadowStrength", 0.5f);
+  bytes = Gather(plan, 2, parameters);
+  const bool changed = cache.ShouldUpload(2, bytes.data(), bytes.size());
+
+  // Buffers are tracked independently.
+  const auto light = Gather(plan, 1, parameters);
+  const bool other_buffer = cache.ShouldUpload(1, light.data(), light.size());
+
+  cache.Invalidate();
+  const bool after_invalidate =
+      cache.ShouldUpload(2, bytes.data(), bytes.size());
+
+  return first && !repeated && changed && other_buffer && after_invalidate &&
+         cache.GetUploadCount() == 4 && cache.GetSkippedUploadCount() == 1;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(7);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable();
+      if (!result.passed) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("Matrix fields land at reflected offsets, transposed",
+      TestMatrixOffsetsAndTranspose);
+  run("Padding and unused variables stay zero", TestPaddingIsZeroed);
+  run("Layered view resolves through the plan", TestLayersResolveThroughPlan);
+  run("Missing field throws, defaults fill in",
+      TestMissingFieldThrowsAndDefaultApplies);
+  run("SRV slots, aliases and defaults", TestResourceSlotsAliasesAndDefaults);
+  run("Type mismatch throws", TestTypeMismatchThrows);
+  run("Upload cache skips byte-identical contents",
+      TestUploadCacheSkipsIdenticalContents);
+
+  return results;
+}
+
+} // namespace
+
+bool RunShaderBindingPlanTests() {
+  const auto results = RunAllTestsInternal();
+  bool all_passed = true;
+
+  for (const auto &result : results) {
+    if (!result.passed) {
+      all_passed = false;
+      std::ostringstream oss;
+      oss << "Test failed: " << result.name;
+      if (!result.message.empty()) {
+        oss << " - " << result.message;
+      }
+      Logger::SetModule("ShaderBindingPlanTests");
+      Logger::LogError(oss.str());
+    }
+  }
+
+  if (all_passed) {
+    Logger::SetModule("ShaderBindingPlanTests");
+    Logger::LogInfo("All ShaderBindingPlan tests passed");
+  }
+
+  return all_passed;
+}
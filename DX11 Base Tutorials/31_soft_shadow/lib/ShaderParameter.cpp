@@ -3,7 +3,11 @@
 #include <algorithm>
 #include <d3d11shader.h>
 #include <d3dcompiler.h>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
 #include <sstream>
+#include <string_view>
 #include <unordered_map>
 
 // Static member initialization - use atomic for thread safety
@@ -23,6 +27,67 @@ void ShaderParameterContainer::SetOverrideLoggingEnabled(bool enabled) {
 
 namespace {
 
+// Names live in a deque so references returned by GetName (and the views used
+// as map keys) stay valid while the table grows. Keying by string_view lets
+// lookups from string literals avoid building a std::string.
+struct ParameterNameTable {
+  std::shared_mutex mutex;
+  std::unordered_map<std::string_view, ShaderParameterId> ids;
+  std::deque<std::string> names;
+};
+
+ParameterNameTable &GetParameterNameTable() {
+  static ParameterNameTable table;
+  return table;
+}
+
+} // namespace
+
+ShaderParameterId ShaderParameterRegistry::Intern(std::string_view name) {
+  auto &table = GetParameterNameTable();
+  {
+    std::shared_lock<std::shared_mutex> read_lock(table.mutex);
+    auto it = table.ids.find(name);
+    if (it != table.ids.end()) {
+      return it->second;
+    }
+  }
+  std::unique_lock<std::shared_mutex> write_lock(table.mutex);
+  auto it = table.ids.find(name);
+  if (it != table.ids.end()) {
+    return it->second;
+  }
+  const auto id = static_cast<ShaderParameterId>(table.names.size());
+  table.names.emplace_back(name);
+  table.ids.emplace(std::string_view(table.names.back()), id);
+  return id;
+}
+
+ShaderParameterId ShaderParameterRegistry::Find(std::string_view name) {
+  auto &table = GetParameterNameTable();
+  std::shared_lock<std::shared_mutex> read_lock(table.mutex);
+  auto it = table.ids.find(name);
+  return it != table.ids.end() ? it->second : kInvalidShaderParameterId;
+}
+
+const std::string &ShaderParameterRegistry::GetName(ShaderParameterId id) {
+  static const std::string kUnknownName = "<unknown>";
+  auto &table = GetParameterNameTable();
+  std::shared_lock<std::shared_mutex> read_lock(table.mutex);
+  if (id >= table.names.size()) {
+    return kUnknownName;
+  }
+  return table.names[id];
+}
+
+std::size_t ShaderParameterRegistry::GetCount() {
+  auto &table = GetParameterNameTable();
+  std::shared_lock<std::shared_mutex> read_lock(table.mutex);
+  return table.names.size();
+}
+
+namespace {
+
 ShaderStageMask StageToMask(ShaderStage stage) {
   return static_cast<ShaderStageMask>(stage);
 }
@@ -229,10 +294,10 @@ void ReflectResourceBindings(ID3D11ShaderReflection *reflection,
   }
 }
 
-void CollectStageParameters(ID3D10Blob *shader_blob, ShaderStage stage,
-                            const char *stage_label, ReflectionCache &cache) {
+ID3D11ShaderReflection *CreateReflection(ID3D10Blob *shader_blob,
+                                         const char *stage_label) {
   if (shader_blob == nullptr) {
-    return;
+    return nullptr;
   }
 
   ID3D11ShaderReflection *reflection = nullptr;
@@ -246,15 +311,156 @@ void CollectStageParameters(ID3D10Blob *shader_blob, ShaderStage stage,
            << static_cast<uint32_t>(reflect_result);
     Logger::SetModule("ShaderParameterReflection");
     Logger::LogWarning(stream.str());
+    return nullptr;
+  }
+  return reflection;
+}
+
+void CollectStageParameters(ID3D10Blob *shader_blob, ShaderStage stage,
+                            const char *stage_label, ReflectionCache &cache) {
+  ID3D11ShaderReflection *reflection =
+      CreateReflection(shader_blob, stage_label);
+  if (reflection == nullptr) {
     return;
   }
 
   ReflectConstantBuffers(reflection, stage, stage_label, cache);
   ReflectResourceBindings(reflection, stage, stage_label, cache);
 
-  if (reflection != nullptr) {
+  reflection->Release();
+}
+
+// Struct members only report their offset relative to the parent, so sizes of
+// nested members are derived from the type shape (registers are 16 bytes).
+std::uint32_t EstimateTypeSize(const D3D11_SHADER_TYPE_DESC &type_desc) {
+  if (type_desc.Class == D3D_SVC_MATRIX_COLUMNS) {
+    return 16U * type_desc.Columns;
+  }
+  if (type_desc.Class == D3D_SVC_MATRIX_ROWS) {
+    return 16U * type_desc.Rows;
+  }
+  return 4U * type_desc.Rows * type_desc.Columns;
+}
+
+void CollectLayoutVariables(ID3D11ShaderReflectionType *type,
+                            const std::string &qualified_name,
+                            std::uint32_t offset, std::uint32_t size,
+                            bool used, ReflectedConstantBuffer &buffer) {
+  D3D11_SHADER_TYPE_DESC type_desc = {};
+  if (type == nullptr || FAILED(type->GetDesc(&type_desc))) {
+    return;
+  }
+
+  if (type_desc.Class == D3D_SVC_STRUCT && type_desc.Elements == 0) {
+    for (UINT member_index = 0; member_index < type_desc.Members;
+         ++member_index) {
+      ID3D11ShaderReflectionType *member_type =
+          type->GetMemberTypeByIndex(member_index);
+      const char *member_name = type->GetMemberTypeName(member_index);
+      D3D11_SHADER_TYPE_DESC member_desc = {};
+      if (member_type == nullptr || member_name == nullptr ||
+          FAILED(member_type->GetDesc(&member_desc))) {
+        continue;
+      }
+      CollectLayoutVariables(member_type, qualified_name + "." + member_name,
+                             offset + member_desc.Offset,
+                             EstimateTypeSize(member_desc), used, buffer);
+    }
+    return;
+  }
+
+  ReflectedConstantBufferVariable variable;
+  variable.name = qualified_name;
+  // Arrays are laid out per element; the plan treats them as opaque bytes.
+  variable.type = type_desc.Elements > 0 ? ShaderParameterType::Unknown
+                                         : MapShaderType(type_desc);
+  variable.offset = offset;
+  variable.size = size;
+  variable.column_major = type_desc.Class == D3D_SVC_MATRIX_COLUMNS;
+  variable.used = used;
+  buffer.variables.push_back(std::move(variable));
+}
+
+void CollectStageLayout(ID3D10Blob *shader_blob, ShaderStage stage,
+                        const char *stage_label,
+                        ShaderReflectionLayout &layout) {
+  ID3D11ShaderReflection *reflection =
+      CreateReflection(shader_blob, stage_label);
+  if (reflection == nullptr) {
+    return;
+  }
+
+  D3D11_SHADER_DESC shader_desc = {};
+  if (FAILED(reflection->GetDesc(&shader_desc))) {
     reflection->Release();
+    return;
   }
+
+  for (UINT buffer_index = 0; buffer_index < shader_desc.ConstantBuffers;
+       ++buffer_index) {
+    ID3D11ShaderReflectionConstantBuffer *cbuffer =
+        reflection->GetConstantBufferByIndex(buffer_index);
+    D3D11_SHADER_BUFFER_DESC buffer_desc = {};
+    if (cbuffer == nullptr || FAILED(cbuffer->GetDesc(&buffer_desc)) ||
+        buffer_desc.Type != D3D_CT_CBUFFER) {
+      continue;
+    }
+
+    D3D11_SHADER_INPUT_BIND_DESC bind_desc = {};
+    if (FAILED(reflection->GetResourceBindingDescByName(buffer_desc.Name,
+                                                        &bind_desc))) {
+      continue;
+    }
+
+    ReflectedConstantBuffer buffer;
+    buffer.name = buffer_desc.Name;
+    buffer.stage = stage;
+    buffer.bind_slot = bind_desc.BindPoint;
+    buffer.size = buffer_desc.Size;
+
+    for (UINT variable_index = 0; variable_index < buffer_desc.Variables;
+         ++variable_index) {
+      ID3D11ShaderReflectionVariable *variable =
+          cbuffer->GetVariableByIndex(variable_index);
+      D3D11_SHADER_VARIABLE_DESC variable_desc = {};
+      if (variable == nullptr || FAILED(variable->GetDesc(&variable_desc))) {
+        continue;
+      }
+      CollectLayoutVariables(variable->GetType(), variable_desc.Name,
+                             variable_desc.StartOffset, variable_desc.Size,
+                             (variable_desc.uFlags & D3D_SVF_USED) != 0,
+                             buffer);
+    }
+
+    layout.constant_buffers.push_back(std::move(buffer));
+  }
+
+  for (UINT resource_index = 0; resource_index < shader_desc.BoundResources;
+       ++resource_index) {
+    D3D11_SHADER_INPUT_BIND_DESC bind_desc = {};
+    if (FAILED(
+            reflection->GetResourceBindingDesc(resource_index, &bind_desc))) {
+      continue;
+    }
+
+    ReflectedResourceBinding resource;
+    switch (bind_desc.Type) {
+    case D3D_SIT_TEXTURE:
+      resource.type = ShaderParameterType::Texture;
+      break;
+    case D3D_SIT_SAMPLER:
+      resource.type = ShaderParameterType::Sampler;
+      break;
+    default:
+      continue;
+    }
+    resource.name = bind_desc.Name;
+    resource.stage = stage;
+    resource.bind_slot = bind_desc.BindPoint;
+    layout.resources.push_back(std::move(resource));
+  }
+
+  reflection->Release();
 }
 
 } // namespace
@@ -280,3 +486,11 @@ ReflectShader(ID3D11Device *device, ID3D10Blob *vs_blob, ID3D10Blob *ps_blob) {
 
   return parameters;
 }
+
+ShaderReflectionLayout ReflectShaderLayout(ID3D10Blob *vs_blob,
+                                           ID3D10Blob *ps_blob) {
+  ShaderReflectionLayout layout;
+  CollectStageLayout(vs_blob, ShaderStage::Vertex, "VS", layout);
+  CollectStageLayout(ps_blob, ShaderStage::Pixel, "PS", layout);
+  return layout;
+}
@@ -0,0 +1,206 @@
+#include "ShaderParameterBenchmarks.h"
+
+#include "ShaderParameter.h"
+
+#include <DirectXMath.h>
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+using ParamValue = ShaderParameterValueVariant;
+using Clock = std::chrono::steady_clock;
+
+// Reduced copy of the map-based container this benchmark replaces: one hash
+// map for values, one for origins and a set for locks, all keyed by string.
+class LegacyParameterContainer {
+public:
+  void Set(const std::string &name, const ParamValue &value, int origin) {
+    if (locked_.count(name) != 0) {
+      return;
+    }
+    auto it = values_.find(name);
+    if (it != values_.end()) {
+      if (it->second.index() != value.index()) {
+        throw std::runtime_error("Type mismatch for parameter: " + name);
+      }
+      it->second = value;
+    } else {
+      values_.emplace(name, value);
+    }
+    origins_[name] = origin;
+  }
+
+  void ApplyOverrides(const LegacyParameterContainer &other, int origin) {
+    for (const auto &entry : other.values_) {
+      Set(entry.first, entry.second, origin);
+      if (other.locked_.count(entry.first) != 0) {
+        locked_.insert(entry.first);
+      }
+    }
+  }
+
+  float GetFloat(const std::string &name) const {
+    return std::get<float>(values_.at(name));
+  }
+
+private:
+  std::unordered_map<std::string, ParamValue> values_;
+  std::unordered_map<std::string, int> origins_;
+  std::unordered_set<std::string> locked_;
+};
+
+// Mirrors the parameter mix of a typical Graphics::Render frame.
+const char *const kGlobalNames[] = {
+    "viewMatrix",       "projectionMatrix", "baseViewMatrix",
+    "orthoMatrix",      "lightViewMatrix",  "lightProjectionMatrix",
+    "lightPosition",    "lightDirection",   "cameraPosition",
+    "ambientColor",     "diffuseColor",     "specularColor",
+    "specularPower",    "shadowStrength",   "time",
+    "screenWidth",      "screenHeight"};
+
+const char *const kPassNames[] = {"shadowMapBias", "blurScale", "texelSize",
+                                  "fogStart",      "fogEnd"};
+
+const char *const kObjectNames[] = {"objectTint", "reflectance", "roughness"};
+
+struct LegacyScene {
+  LegacyParameterContainer global;
+  LegacyParameterContainer pass;
+  std::vector<LegacyParameterContainer> objects;
+};
+
+struct SlotScene {
+  ShaderParameterContainer global;
+  ShaderParameterContainer pass;
+  std::vector<ShaderParameterContainer> objects;
+};
+
+ParamValue MakeValue(const std::string &name, float seed) {
+  if (name.find("Matrix") != std::string::npos) {
+    return ParamValue(DirectX::XMMatrixTranslation(seed, seed, seed));
+  }
+  if (name.find("Color") != std::string::npos) {
+    return ParamValue(DirectX::XMFLOAT4(seed, seed, seed, 1.0f));
+  }
+  if (name.find("Position") != std::string::npos ||
+      name.find("Direction") != std::string::npos) {
+    return ParamValue(DirectX::XMFLOAT3(seed, seed, seed));
+  }
+  return ParamValue(seed);
+}
+
+void BuildScenes(std::size_t object_count, LegacyScene &legacy,
+                 SlotScene &slots) {
+  using Origin = ShaderParameterContainer::ParameterOrigin;
+  for (const char *name : kGlobalNames) {
+    legacy.global.Set(name, MakeValue(name, 1.0f), 1);
+    slots.global.SetValue(ShaderParameterRegistry::Intern(name),
+                          MakeValue(name, 1.0f), Origin::Global);
+  }
+  for (const char *name : kPassNames) {
+    legacy.pass.Set(name, MakeValue(name, 2.0f), 2);
+    slots.pass.SetValue(ShaderParameterRegistry::Intern(name),
+                        MakeValue(name, 2.0f), Origin::Pass);
+  }
+  legacy.objects.resize(object_count);
+  slots.objects.resize(object_count);
+  for (std::size_t i = 0; i < object_count; ++i) {
+    const float seed = static_cast<float>(i % 97);
+    for (const char *name : kObjectNames) {
+      legacy.objects[i].Set(name, MakeValue(name, seed), 3);
+      slots.objects[i].SetValue(ShaderParameterRegistry::Intern(name),
+                                MakeValue(name, seed), Origin::Object);
+    }
+  }
+}
+
+template <typename Func> double MeasureMilliseconds(Func &&func) {
+  const auto start = Clock::now();
+  func();
+  const auto end = Clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+bool RunMergeBenchmark(std::size_t object_count) {
+  LegacyScene legacy;
+  SlotScene slots;
+  BuildScenes(object_count, legacy, slots);
+
+  const DirectX::XMMATRIX world = DirectX::XMMatrixIdentity();
+  const ParamValue world_value(world);
+  const auto tint_id = ShaderParameterRegistry::Intern("objectTint");
+
+  // Checksums keep the optimizer from discarding the merges and double as a
+  // correctness check between the two layouts.
+  float legacy_sum = 0.0f;
+  const double legacy_ms = MeasureMilliseconds([&] {
+    for (const auto &object : legacy.objects) {
+      LegacyParameterContainer merged;
+      merged.ApplyOverrides(legacy.global, 1);
+      merged.ApplyOverrides(legacy.pass, 2);
+      merged.ApplyOverrides(object, 3);
+      merged.Set("worldMatrix", world_value, 3);
+      legacy_sum += merged.GetFloat("roughness");
+    }
+  });
+
+  float slot_sum = 0.0f;
+  const double slot_ms = MeasureMilliseconds([&] {
+    for (const auto &object : slots.objects) {
+      ShaderParameterContainer::BuildParametersInput input;
+      input.global_params = &slots.global;
+      input.pass_params = &slots.pass;
+      input.object_params = &object;
+      input.world_matrix = &world;
+      const auto merged = ShaderParameterContainer::BuildFinalParameters(input);
+      slot_sum += merged.GetFloat("roughness");
+    }
+  });
+
+  // Id-based lookups, as used by shaders that cache their parameter ids.
+  float id_sum = 0.0f;
+  const double lookup_ms = MeasureMilliseconds([&] {
+    for (const auto &object : slots.objects) {
+      const auto *value = object.Find(tint_id);
+      if (value != nullptr) {
+        id_sum += std::get<float>(*value);
+      }
+    }
+  });
+
+  const double per_object_legacy_ns = legacy_ms * 1.0e6 / object_count;
+  const double per_object_slot_ns = slot_ms * 1.0e6 / object_count;
+  std::cout << std::setw(8) << object_count << " objects | map-based "
+            << std::fixed << std::setprecision(2) << std::setw(9) << legacy_ms
+            << " ms (" << std::setw(7) << per_object_legacy_ns
+            << " ns/obj) | slot-indexed " << std::setw(9) << slot_ms << " ms ("
+            << std::setw(7) << per_object_slot_ns << " ns/obj) | speedup "
+            << std::setprecision(2) << (slot_ms > 0.0 ? legacy_ms / slot_ms : 0.0)
+            << "x | id lookup " << std::setprecision(3) << lookup_ms << " ms"
+            << std::endl;
+
+  (void)id_sum;
+  return std::fabs(legacy_sum - slot_sum) <= 1e-3f * (1.0f + legacy_sum);
+}
+
+} // namespace
+
+bool RunShaderParameterBenchmarks() {
+  std::cout << "=== ShaderParameterContainer merge benchmark ===" << std::endl;
+  bool consistent = true;
+  for (std::size_t object_count : {1000u, 10000u, 100000u}) {
+    consistent = RunMergeBenchmark(object_count) && consistent;
+  }
+  if (!consistent) {
+    std::cout << "Merge results differ between layouts" << std::endl;
+  }
+  return consistent;
+}
@@ -188,9 +188,67 @@ bool TestLockedParametersPreventOverrides() {
                         kLockedStrength);
 }
 
+bool TestInternedIdsMatchStringApi() {
+  const auto id = ShaderParameterRegistry::Intern("internedStrength");
+  if (id != ShaderParameterRegistry::Intern("internedStrength") ||
+      ShaderParameterRegistry::Find("internedStrength") != id ||
+      ShaderParameterRegistry::GetName(id) != "internedStrength") {
+    return false;
+  }
+  if (ShaderParameterRegistry::Find("neverInternedParameter") !=
+      kInvalidShaderParameterId) {
+    return false;
+  }
+
+  ShaderParameterContainer params;
+  params.SetFloat("internedStrength", 0.75f);
+  float value = 0.0f;
+  if (!params.HasParameter(id) || !params.TryGet(id, value) ||
+      !AreFloatsEqual(value, 0.75f)) {
+    return false;
+  }
+
+  params.SetFloatLocked(id, 0.25f,
+                        ShaderParameterContainer::ParameterOrigin::Pass);
+  params.SetFloat("internedStrength", 1.0f);
+  return params.IsLocked("internedStrength") &&
+         AreFloatsEqual(params.Get<float>(id), 0.25f);
+}
+
+bool TestManySlotsStaySorted() {
+  // Enough names to spill past the inline slots and past the presence mask.
+  constexpr int kParameterCount = 200;
+  ShaderParameterContainer params;
+  for (int i = kParameterCount - 1; i >= 0; --i) {
+    params.SetFloat("slotParam" + std::to_string(i), static_cast<float>(i));
+  }
+  if (params.GetParameterCount() != kParameterCount) {
+    return false;
+  }
+
+  ShaderParameterContainer overrides;
+  overrides.SetFloat("slotParam7", -7.0f);
+  overrides.SetFloat("slotParam199", -199.0f);
+  const auto merged = ShaderParameterContainer::MergeWithPriority(
+      params, overrides, ShaderParameterContainer::ParameterOrigin::Global,
+      ShaderParameterContainer::ParameterOrigin::Pass);
+
+  for (int i = 0; i < kParameterCount; ++i) {
+    float expected = static_cast<float>(i);
+    if (i == 7 || i == 199) {
+      expected = -expected;
+    }
+    if (!AreFloatsEqual(merged.GetFloat("slotParam" + std::to_string(i)),
+                        expected)) {
+      return false;
+    }
+  }
+  return merged.GetParameterCount() == kParameterCount;
+}
+
 std::vector<TestCaseResult> RunAllTestsInternal() {
   std::vector<TestCaseResult> results;
-  results.reserve(5);
+  results.reserve(9);
 
   auto run = [&results](const std::string &name, auto &&callable) {
     TestCaseResult result{name};
@@ -274,6 +332,10 @@ std::vector<TestCaseResult> RunAllTestsInternal() {
     ShaderParameterContainer::SetStrictValidationEnabled(false);
     return threw;
   });
+  run("Interned ids match string API",
+      [] { return TestInternedIdsMatchStringApi(); });
+  run("Slots stay sorted past inline capacity",
+      [] { return TestManySlotsStaySorted(); });
 
   return results;
 }
@@ -9,14 +9,6 @@
 #include <sstream>
 #include <vector>
 
-// Undefine Windows macros that conflict with std::min/max
-#ifdef max
-#undef max
-#endif
-#ifdef min
-#undef min
-#endif
-
 void ShaderParameterValidator::RegisterShader(
     const std::string &shader_name,
     const std::vector<ShaderParameterInfo> &parameters) {
@@ -48,7 +48,7 @@ bool ShadowShader::Initialize(HWND hwnd, ID3D11Device *device) {
 }
 
 bool ShadowShader::Render(int indexCount,
-                          const ShaderParameterContainer &parameters,
+                          const LayeredParameterView &parameters,
                           ID3D11DeviceContext *deviceContext) const {
 
   auto worldMatrix = parameters.GetMatrix("worldMatrix");
@@ -41,7 +41,7 @@ bool SimpleLightShader::Initialize(HWND hwnd, ID3D11Device *device) {
 }
 
 bool SimpleLightShader::Render(int indexCount,
-                               const ShaderParameterContainer &parameters,
+                               const LayeredParameterView &parameters,
                                ID3D11DeviceContext *deviceContext) const {
 
   auto worldMatrix = parameters.GetMatrix("worldMatrix");
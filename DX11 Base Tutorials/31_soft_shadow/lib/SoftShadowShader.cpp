@@ -26,6 +26,14 @@ bool SoftShadowShader::Initialize(HWND hwnd, ID3D11Device *device) {
     return false;
   }
 
+  // Reflection names that differ from the parameter names used by passes,
+  // and values for parameters that are optional.
+  ShaderParameterContainer plan_defaults;
+  plan_defaults.SetTexture("reflectionTexture", nullptr);
+  plan_defaults.SetFloat("reflectionBlend", 0.0f);
+  plan_defaults.SetFloat("shadowStrength", 1.0f);
+  EnableBindingPlan({{"shaderTexture", "texture"}}, std::move(plan_defaults));
+
   // Create constant buffers
   if (!CreateConstantBuffer(sizeof(MatrixBufferType),
                             matrix_buffer_.GetAddressOf(), device)) {
@@ -68,40 +76,48 @@ bool SoftShadowShader::Initialize(HWND hwnd, ID3D11Device *device) {
 }
 
 bool SoftShadowShader::Render(int indexCount,
-                              const ShaderParameterContainer &parameters,
+                              const LayeredParameterView &parameters,
                               ID3D11DeviceContext *deviceContext) const {
 
-  auto worldMatrix = parameters.GetMatrix("worldMatrix");
-  auto viewMatrix = parameters.GetMatrix("viewMatrix");
-  auto projectionMatrix = parameters.GetMatrix("projectionMatrix");
-
-  auto texture = parameters.GetTexture("texture");
-  auto shadowTexture = parameters.GetTexture("shadowTexture");
-  ID3D11ShaderResourceView *reflectionTexture = nullptr;
-  if (parameters.HasParameter("reflectionTexture")) {
-    reflectionTexture = parameters.GetTexture("reflectionTexture");
-  }
-
-  auto ambientColor = parameters.GetVector4("ambientColor");
-  auto diffuseColor = parameters.GetVector4("diffuseColor");
-
-  auto lightPosition = parameters.GetVector3("lightPosition");
-
-  auto reflectionMatrix = parameters.GetMatrix("reflectionMatrix");
-  float reflectionBlend = 0.0f;
-  if (parameters.HasParameter("reflectionBlend")) {
-    reflectionBlend = parameters.GetFloat("reflectionBlend");
-  }
-  float shadowStrength = 1.0f;
-  if (parameters.HasParameter("shadowStrength")) {
-    shadowStrength = parameters.GetFloat("shadowStrength");
-  }
-
-  if (!SetShaderParameters(worldMatrix, viewMatrix, projectionMatrix, texture,
-                           shadowTexture, reflectionTexture, reflectionMatrix,
-                           reflectionBlend, shadowStrength, lightPosition,
-                           ambientColor, diffuseColor, deviceContext)) {
-    return false;
+  // Plan path: constant buffers and SRVs are gathered from reflection offsets.
+  // The by-name path remains for when no plan was compiled.
+  if (HasBindingPlan()) {
+    if (!ApplyBindingPlan(parameters, deviceContext)) {
+      return false;
+    }
+  } else {
+    auto worldMatrix = parameters.GetMatrix("worldMatrix");
+    auto viewMatrix = parameters.GetMatrix("viewMatrix");
+    auto projectionMatrix = parameters.GetMatrix("projectionMatrix");
+
+    auto texture = parameters.GetTexture("texture");
+    auto shadowTexture = parameters.GetTexture("shadowTexture");
+    ID3D11ShaderResourceView *reflectionTexture = nullptr;
+    if (parameters.HasParameter("reflectionTexture")) {
+      reflectionTexture = parameters.GetTexture("reflectionTexture");
+    }
+
+    auto ambientColor = parameters.GetVector4("ambientColor");
+    auto diffuseColor = parameters.GetVector4("diffuseColor");
+
+    auto lightPosition = parameters.GetVector3("lightPosition");
+
+    auto reflectionMatrix = parameters.GetMatrix("reflectionMatrix");
+    float reflectionBlend = 0.0f;
+    if (parameters.HasParameter("reflectionBlend")) {
+      reflectionBlend = parameters.GetFloat("reflectionBlend");
+    }
+    float shadowStrength = 1.0f;
+    if (parameters.HasParameter("shadowStrength")) {
+      shadowStrength = parameters.GetFloat("shadowStrength");
+    }
+
+    if (!SetShaderParameters(worldMatrix, viewMatrix, projectionMatrix, texture,
+                             shadowTexture, reflectionTexture, reflectionMatrix,
+                             reflectionBlend, shadowStrength, lightPosition,
+                             ambientColor, diffuseColor, deviceContext)) {
+      return false;
+    }
   }
 
   // Set the vertex input layout
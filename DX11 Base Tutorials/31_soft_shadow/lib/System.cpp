@@ -129,6 +129,14 @@ bool System::HandleInput(float frameTime) {
   keyDown = GetInputComponent().IsPgDownPressed();
   position_->LookDownward(keyDown);
 
+  const bool left_button_down = GetInputComponent().IsLeftMouseButtonDown();
+  if (left_button_down && !left_button_was_down_) {
+    int mouseX, mouseY;
+    GetInputComponent().GetMouseLocation(mouseX, mouseY);
+    graphics_->PickObject(mouseX, mouseY);
+  }
+  left_button_was_down_ = left_button_down;
+
   return true;
 }
 
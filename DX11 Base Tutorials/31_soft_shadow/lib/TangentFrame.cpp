@@ -0,0 +1,454 @@
+#include "TangentFrame.h"
+
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <xmmintrin.h>
+
+namespace {
+
+// Face frames stored by the parallel pass: per-triangle unit tangent and
+// binormal, zero where the UVs give no direction, and the corner angles.
+struct FaceFrames {
+  std::vector<float> tx, ty, tz;
+  std::vector<float> bx, by, bz;
+  std::vector<float> angle0, angle1, angle2;
+};
+
+// Angle-weighted sums of the face frames around a vertex (w unused).
+struct FrameSum {
+  __m128 tangent;
+  __m128 binormal;
+};
+
+// Face frames of four consecutive triangles, one per lane.
+struct FaceBatch {
+  __m128 tx, ty, tz;
+  __m128 bx, by, bz;
+  __m128 angle[3];
+};
+
+// Four consecutive stream entries from i; past count the last one repeats,
+// so a partial batch runs the same code as a full one.
+__m128 Load4(const std::vector<float> &stream, std::size_t i,
+             std::size_t count) {
+  if (i + 4 <= count) {
+    return _mm_loadu_ps(&stream[i]);
+  }
+  float lanes[4];
+  for (std::size_t k = 0; k < 4; ++k) {
+    lanes[k] = stream[(std::min)(i + k, count - 1)];
+  }
+  return _mm_loadu_ps(lanes);
+}
+
+void Store4(std::vector<float> &stream, std::size_t i, std::size_t count,
+            __m128 value) {
+  if (i + 4 <= count) {
+    _mm_storeu_ps(&stream[i], value);
+    return;
+  }
+  float lanes[4];
+  _mm_storeu_ps(lanes, value);
+  for (std::size_t k = 0; i + k < count; ++k) {
+    stream[i + k] = lanes[k];
+  }
+}
+
+__m128 Dot3(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by,
+            __m128 bz) {
+  return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)),
+                    _mm_mul_ps(az, bz));
+}
+
+// 1 / length where the squared length is usable, else 0.
+__m128 SafeInverseLength(__m128 length_sq) {
+  const __m128 usable = _mm_cmpgt_ps(length_sq, _mm_set1_ps(1e-30f));
+  return _mm_and_ps(usable, _mm_div_ps(_mm_set1_ps(1.0f),
+                                       _mm_sqrt_ps(length_sq)));
+}
+
+// acos to within 7e-5 rad (Abramowitz and Stegun 4.4.45), enough for
+// weights.
+__m128 AcosApprox(__m128 x) {
+  const __m128 one = _mm_set1_ps(1.0f);
+  x = _mm_max_ps(_mm_min_ps(x, one), _mm_set1_ps(-1.0f));
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  const __m128 ax = _mm_andnot_ps(sign, x);
+  __m128 p = _mm_set1_ps(-0.0187293f);
+  p = _mm_add_ps(_mm_mul_ps(p, ax), _mm_set1_ps(0.0742610f));
+  p = _mm_add_ps(_mm_mul_ps(p, ax), _mm_set1_ps(-0.2121144f));
+  p = _mm_add_ps(_mm_mul_ps(p, ax), _mm_set1_ps(1.5707288f));
+  const __m128 r = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(one, ax)), p);
+  const __m128 negative = _mm_cmplt_ps(x, _mm_setzero_ps());
+  const __m128 mirrored = _mm_sub_ps(_mm_set1_ps(3.14159265f), r);
+  return _mm_or_ps(_mm_and_ps(negative, mirrored),
+                   _mm_andnot_ps(negative, r));
+}
+
+// Approximate 1 / length (12 bits) where the squared length is usable,
+// else 0; enough for face frames, which are only weighted and summed.
+__m128 FastInverseLength(__m128 length_sq) {
+  const __m128 usable = _mm_cmpgt_ps(length_sq, _mm_set1_ps(1e-30f));
+  return _mm_and_ps(usable, _mm_rsqrt_ps(length_sq));
+}
+
+// Face frames of triangles t .. t + 3; past end the last triangle repeats.
+FaceBatch ComputeFaceBatch(const std::uint32_t *indices,
+                           const TangentFrameStreams &s, std::size_t t,
+                           std::size_t end) {
+  __m128 x[3], y[3], z[3], u[3], v[3];
+  for (int c = 0; c < 3; ++c) {
+    float lx[4], ly[4], lz[4], lu[4], lv[4];
+    for (std::size_t k = 0; k < 4; ++k) {
+      const std::uint32_t i = indices[(std::min)(t + k, end - 1) * 3 + c];
+      lx[k] = s.px[i];
+      ly[k] = s.py[i];
+      lz[k] = s.pz[i];
+      lu[k] = s.u[i];
+      lv[k] = s.v[i];
+    }
+    x[c] = _mm_loadu_ps(lx);
+    y[c] = _mm_loadu_ps(ly);
+    z[c] = _mm_loadu_ps(lz);
+    u[c] = _mm_loadu_ps(lu);
+    v[c] = _mm_loadu_ps(lv);
+  }
+
+  const __m128 e1x = _mm_sub_ps(x[1], x[0]);
+  const __m128 e1y = _mm_sub_ps(y[1], y[0]);
+  const __m128 e1z = _mm_sub_ps(z[1], z[0]);
+  const __m128 e2x = _mm_sub_ps(x[2], x[0]);
+  const __m128 e2y = _mm_sub_ps(y[2], y[0]);
+  const __m128 e2z = _mm_sub_ps(z[2], z[0]);
+  const __m128 du1 = _mm_sub_ps(u[1], u[0]);
+  const __m128 dv1 = _mm_sub_ps(v[1], v[0]);
+  const __m128 du2 = _mm_sub_ps(u[2], u[0]);
+  const __m128 dv2 = _mm_sub_ps(v[2], v[0]);
+
+  // Only the sign of 1 / det survives normalization, but it carries the
+  // handedness of mirrored UVs.
+  const __m128 det = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(du2, dv1));
+  const __m128 usable = _mm_cmpgt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), det),
+                                     _mm_set1_ps(1e-20f));
+  const __m128 r = _mm_and_ps(usable, _mm_div_ps(_mm_set1_ps(1.0f), det));
+
+  FaceBatch batch;
+  batch.tx = _mm_mul_ps(
+      _mm_sub_ps(_mm_mul_ps(dv2, e1x), _mm_mul_ps(dv1, e2x)), r);
+  batch.ty = _mm_mul_ps(
+      _mm_sub_ps(_mm_mul_ps(dv2, e1y), _mm_mul_ps(dv1, e2y)), r);
+  batch.tz = _mm_mul_ps(
+      _mm_sub_ps(_mm_mul_ps(dv2, e1z), _mm_mul_ps(dv1, e2z)), r);
+  batch.bx = _mm_mul_ps(
+      _mm_sub_ps(_mm_mul_ps(du1, e2x), _mm_mul_ps(du2, e1x)), r);
+  batch.by = _mm_mul_ps(
+      _mm_sub_ps(_mm_mul_ps(du1, e2y), _mm_mul_ps(du2, e1y)), r);
+  batch.bz = _mm_mul_ps(
+      _mm_sub_ps(_mm_mul_ps(du1, e2z), _mm_mul_ps(du2, e1z)), r);
+  const __m128 t_scale = FastInverseLength(
+      Dot3(batch.tx, batch.ty, batch.tz, batch.tx, batch.ty, batch.tz));
+  const __m128 b_scale = FastInverseLength(
+      Dot3(batch.bx, batch.by, batch.bz, batch.bx, batch.by, batch.bz));
+  batch.tx = _mm_mul_ps(batch.tx, t_scale);
+  batch.ty = _mm_mul_ps(batch.ty, t_scale);
+  batch.tz = _mm_mul_ps(batch.tz, t_scale);
+  batch.bx = _mm_mul_ps(batch.bx, b_scale);
+  batch.by = _mm_mul_ps(batch.by, b_scale);
+  batch.bz = _mm_mul_ps(batch.bz, b_scale);
+
+  // Corner angles from the cosines between the unit edges.
+  const __m128 e3x = _mm_sub_ps(x[2], x[1]);
+  const __m128 e3y = _mm_sub_ps(y[2], y[1]);
+  const __m128 e3z = _mm_sub_ps(z[2], z[1]);
+  const __m128 l1 = FastInverseLength(Dot3(e1x, e1y, e1z, e1x, e1y, e1z));
+  const __m128 l2 = FastInverseLength(Dot3(e2x, e2y, e2z, e2x, e2y, e2z));
+  const __m128 l3 = FastInverseLength(Dot3(e3x, e3y, e3z, e3x, e3y, e3z));
+  const __m128 d12 = Dot3(e1x, e1y, e1z, e2x, e2y, e2z);
+  const __m128 d13 = Dot3(e1x, e1y, e1z, e3x, e3y, e3z);
+  const __m128 d23 = Dot3(e2x, e2y, e2z, e3x, e3y, e3z);
+  batch.angle[0] = AcosApprox(_mm_mul_ps(d12, _mm_mul_ps(l1, l2)));
+  batch.angle[1] = AcosApprox(
+      _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(d13, _mm_mul_ps(l1, l3))));
+  batch.angle[2] = AcosApprox(_mm_mul_ps(d23, _mm_mul_ps(l2, l3)));
+  return batch;
+}
+
+void StoreFaceBatch(FaceFrames &faces, std::size_t t, std::size_t end,
+                    const FaceBatch &batch) {
+  Store4(faces.tx, t, end, batch.tx);
+  Store4(faces.ty, t, end, batch.ty);
+  Store4(faces.tz, t, end, batch.tz);
+  Store4(faces.bx, t, end, batch.bx);
+  Store4(faces.by, t, end, batch.by);
+  Store4(faces.bz, t, end, batch.bz);
+  Store4(faces.angle0, t, end, batch.angle[0]);
+  Store4(faces.angle1, t, end, batch.angle[1]);
+  Store4(faces.angle2, t, end, batch.angle[2]);
+}
+
+FaceBatch LoadFaceBatch(const FaceFrames &faces, std::size_t t,
+                        std::size_t end) {
+  FaceBatch batch;
+  batch.tx = Load4(faces.tx, t, end);
+  batch.ty = Load4(faces.ty, t, end);
+  batch.tz = Load4(faces.tz, t, end);
+  batch.bx = Load4(faces.bx, t, end);
+  batch.by = Load4(faces.by, t, end);
+  batch.bz = Load4(faces.bz, t, end);
+  batch.angle[0] = Load4(faces.angle0, t, end);
+  batch.angle[1] = Load4(faces.angle1, t, end);
+  batch.angle[2] = Load4(faces.angle2, t, end);
+  return batch;
+}
+
+// Adds each face's frame, weighted by the corner angle, to its three
+// vertices.
+void AccumulateFaceBatch(const std::uint32_t *indices, std::size_t t,
+                         std::size_t end, FaceBatch batch,
+                         std::vector<FrameSum> &sums) {
+  __m128 tangent[4] = {batch.tx, batch.ty, batch.tz, _mm_setzero_ps()};
+  __m128 binormal[4] = {batch.bx, batch.by, batch.bz, _mm_setzero_ps()};
+  _MM_TRANSPOSE4_PS(tangent[0], tangent[1], tangent[2], tangent[3]);
+  _MM_TRANSPOSE4_PS(binormal[0], binormal[1], binormal[2], binormal[3]);
+  float angles[3][4];
+  for (int c = 0; c < 3; ++c) {
+    _mm_storeu_ps(angles[c], batch.angle[c]);
+  }
+  for (std::size_t k = 0; k < 4 && t + k < end; ++k) {
+    for (int c = 0; c < 3; ++c) {
+      const std::size_t v = indices[(t + k) * 3 + c];
+      const __m128 weight = _mm_set1_ps(angles[c][k]);
+      FrameSum &sum = sums[v];
+      sum.tangent = _mm_add_ps(sum.tangent, _mm_mul_ps(tangent[k], weight));
+      sum.binormal =
+          _mm_add_ps(sum.binormal, _mm_mul_ps(binormal[k], weight));
+    }
+  }
+}
+
+// Frame for a vertex whose sums vanished: any unit tangent perpendicular
+// to the normal; keeps a usable binormal.
+void RepairFrame(TangentFrameStreams &s, std::size_t v, bool tangent_ok) {
+  float n[3] = {s.nx[v], s.ny[v], s.nz[v]};
+  const float n_length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+  if (n_length < 1e-15f) {
+    n[0] = 0.0f;
+    n[1] = 1.0f;
+    n[2] = 0.0f;
+  } else {
+    for (float &c : n) {
+      c /= n_length;
+    }
+  }
+  float t[3] = {s.tx[v], s.ty[v], s.tz[v]};
+  if (!tangent_ok) {
+    const float axis[3] = {std::fabs(n[0]) < 0.9f ? 1.0f : 0.0f,
+                           std::fabs(n[0]) < 0.9f ? 0.0f : 1.0f, 0.0f};
+    const float d = n[0] * axis[0] + n[1] * axis[1];
+    float length = 0.0f;
+    for (int c = 0; c < 3; ++c) {
+      t[c] = axis[c] - n[c] * d;
+      length += t[c] * t[c];
+    }
+    length = std::sqrt(length);
+    for (float &c : t) {
+      c /= length;
+    }
+  }
+  s.tx[v] = t[0];
+  s.ty[v] = t[1];
+  s.tz[v] = t[2];
+  s.bx[v] = n[1] * t[2] - n[2] * t[1];
+  s.by[v] = n[2] * t[0] - n[0] * t[2];
+  s.bz[v] = n[0] * t[1] - n[1] * t[0];
+}
+
+// Gram-Schmidt of the sums of vertices [begin, end) against their normals,
+// written to the tangent and binormal streams.
+void OrthonormalizeFrames(const std::vector<FrameSum> &sums, std::size_t begin,
+                          std::size_t end, TangentFrameStreams &s) {
+  for (std::size_t v = begin; v < end; v += 4) {
+    __m128 nx = Load4(s.nx, v, end);
+    __m128 ny = Load4(s.ny, v, end);
+    __m128 nz = Load4(s.nz, v, end);
+    const __m128 n_scale = SafeInverseLength(Dot3(nx, ny, nz, nx, ny, nz));
+    nx = _mm_mul_ps(nx, n_scale);
+    ny = _mm_mul_ps(ny, n_scale);
+    nz = _mm_mul_ps(nz, n_scale);
+    __m128 tx, ty, tz, tw, bx, by, bz, bw;
+    {
+      const std::size_t i[4] = {v, (std::min)(v + 1, end - 1),
+                                (std::min)(v + 2, end - 1),
+                                (std::min)(v + 3, end - 1)};
+      tx = sums[i[0]].tangent;
+      ty = sums[i[1]].tangent;
+      tz = sums[i[2]].tangent;
+      tw = sums[i[3]].tangent;
+      bx = sums[i[0]].binormal;
+      by = sums[i[1]].binormal;
+      bz = sums[i[2]].binormal;
+      bw = sums[i[3]].binormal;
+      _MM_TRANSPOSE4_PS(tx, ty, tz, tw);
+      _MM_TRANSPOSE4_PS(bx, by, bz, bw);
+    }
+
+    const __m128 nt = Dot3(nx, ny, nz, tx, ty, tz);
+    tx = _mm_sub_ps(tx, _mm_mul_ps(nx, nt));
+    ty = _mm_sub_ps(ty, _mm_mul_ps(ny, nt));
+    tz = _mm_sub_ps(tz, _mm_mul_ps(nz, nt));
+    const __m128 t_scale = SafeInverseLength(Dot3(tx, ty, tz, tx, ty, tz));
+    tx = _mm_mul_ps(tx, t_scale);
+    ty = _mm_mul_ps(ty, t_scale);
+    tz = _mm_mul_ps(tz, t_scale);
+
+    const __m128 nb = Dot3(nx, ny, nz, bx, by, bz);
+    const __m128 tb = Dot3(tx, ty, tz, bx, by, bz);
+    bx = _mm_sub_ps(bx, _mm_add_ps(_mm_mul_ps(nx, nb), _mm_mul_ps(tx, tb)));
+    by = _mm_sub_ps(by, _mm_add_ps(_mm_mul_ps(ny, nb), _mm_mul_ps(ty, tb)));
+    bz = _mm_sub_ps(bz, _mm_add_ps(_mm_mul_ps(nz, nb), _mm_mul_ps(tz, tb)));
+    const __m128 b_scale = SafeInverseLength(Dot3(bx, by, bz, bx, by, bz));
+
+    Store4(s.tx, v, end, tx);
+    Store4(s.ty, v, end, ty);
+    Store4(s.tz, v, end, tz);
+    Store4(s.bx, v, end, _mm_mul_ps(bx, b_scale));
+    Store4(s.by, v, end, _mm_mul_ps(by, b_scale));
+    Store4(s.bz, v, end, _mm_mul_ps(bz, b_scale));
+
+    const __m128 zero = _mm_setzero_ps();
+    const int bad_tangent = _mm_movemask_ps(_mm_cmpeq_ps(t_scale, zero));
+    const int bad_binormal = _mm_movemask_ps(_mm_cmpeq_ps(b_scale, zero));
+    for (std::size_t k = 0; k < 4 && v + k < end; ++k) {
+      if ((bad_tangent | bad_binormal) & (1 << k)) {
+        RepairFrame(s, v + k, (bad_tangent & (1 << k)) == 0);
+      }
+    }
+  }
+}
+
+// Runs func(begin, end) over [0, count) in ranges of a multiple of four,
+// on the job system's workers when one is given and parallel is set.
+template <typename Func>
+void ForEachRange(JobSystem *job_system, bool parallel, std::size_t count,
+                  const Func &func) {
+  if (job_system == nullptr || !parallel || count == 0) {
+    func(std::size_t{0}, count);
+    return;
+  }
+  const std::size_t ranges = (job_system->GetWorkerCount() + 1) * 4;
+  const std::size_t size =
+      ((count + ranges - 1) / ranges + 3) & ~std::size_t{3};
+  JobCounter counter;
+  for (std::size_t begin = 0; begin < count; begin += size) {
+    const std::size_t end = (std::min)(begin + size, count);
+    job_system->Submit([&func, begin, end] { func(begin, end); }, counter);
+  }
+  job_system->Wait(counter);
+}
+
+} // namespace
+
+void TangentFrameStreams::Resize(std::size_t vertex_count) {
+  for (auto *stream : {&px, &py, &pz, &u, &v, &nx, &ny, &nz, &tx, &ty, &tz,
+                       &bx, &by, &bz}) {
+    stream->resize(vertex_count);
+  }
+}
+
+void TangentFrameStreams::Gather(const float *vertices,
+                                 std::size_t vertex_count,
+                                 std::size_t stride) {
+  Resize(vertex_count);
+  for (std::size_t i = 0; i < vertex_count; ++i) {
+    const float *vertex = vertices + i * stride;
+    px[i] = vertex[0];
+    py[i] = vertex[1];
+    pz[i] = vertex[2];
+    u[i] = vertex[3];
+    v[i] = vertex[4];
+    nx[i] = vertex[5];
+    ny[i] = vertex[6];
+    nz[i] = vertex[7];
+  }
+}
+
+void TangentFrameStreams::Scatter(float *vertices, std::size_t stride,
+                                  std::size_t offset) const {
+  for (std::size_t i = 0; i < GetVertexCount(); ++i) {
+    float *frame = vertices + i * stride + offset;
+    frame[0] = tx[i];
+    frame[1] = ty[i];
+    frame[2] = tz[i];
+    frame[3] = bx[i];
+    frame[4] = by[i];
+    frame[5] = bz[i];
+  }
+}
+
+void GenerateTangentFrames(const std::uint32_t *indices,
+                           std::size_t index_count,
+                           TangentFrameStreams &streams,
+                           JobSystem *job_system) {
+  const std::size_t vertex_count = streams.GetVertexCount();
+  const std::size_t triangle_count = index_count / 3;
+  const bool parallel = triangle_count >= kTangentFrameParallelTriangles;
+  streams.Resize(vertex_count);
+
+  // Angle-weighted sums of the face frames around each vertex. Projecting
+  // each face frame into the tangent plane before summing would give the
+  // same direction, since Gram-Schmidt below removes the normal part.
+  std::vector<FrameSum> sums(vertex_count,
+                             {_mm_setzero_ps(), _mm_setzero_ps()});
+  if (job_system == nullptr || !parallel) {
+    for (std::size_t t = 0; t < triangle_count; t += 4) {
+      AccumulateFaceBatch(indices, t, triangle_count,
+                          ComputeFaceBatch(indices, streams, t, triangle_count),
+                          sums);
+    }
+  } else {
+    // Faces in parallel, then the sums in triangle order, so the result
+    // does not depend on how the work was split.
+    FaceFrames faces;
+    for (auto *stream : {&faces.tx, &faces.ty, &faces.tz, &faces.bx,
+                         &faces.by, &faces.bz, &faces.angle0, &faces.angle1,
+                         &faces.angle2}) {
+      stream->resize(triangle_count);
+    }
+    ForEachRange(job_system, parallel, triangle_count,
+                 [&](std::size_t begin, std::size_t end) {
+                   for (std::size_t t = begin; t < end; t += 4) {
+                     StoreFaceBatch(faces, t, end,
+                                    ComputeFaceBatch(indices, streams, t, end));
+                   }
+                 });
+    for (std::size_t t = 0; t < triangle_count; t += 4) {
+      AccumulateFaceBatch(indices, t, triangle_count,
+                          LoadFaceBatch(faces, t, triangle_count), sums);
+    }
+  }
+
+  ForEachRange(job_system, parallel, vertex_count,
+               [&](std::size_t begin, std::size_t end) {
+                 OrthonormalizeFrames(sums, begin, end, streams);
+               });
+}
+
+std::unique_ptr<JobSystem>
+CreateTangentFrameJobSystem(std::size_t triangle_count) {
+  if (triangle_count < kTangentFrameParallelTriangles) {
+    return nullptr;
+  }
+  return std::make_unique<JobSystem>();
+}
+
+void GenerateTangentFrames(float *vertices, std::size_t vertex_count,
+                           std::size_t stride,
+                           const std::vector<std::uint32_t> &indices,
+                           JobSystem *job_system) {
+  TangentFrameStreams streams;
+  streams.Gather(vertices, vertex_count, stride);
+  GenerateTangentFrames(indices.data(), indices.size(), streams, job_system);
+  streams.Scatter(vertices, stride, 8);
+}
@@ -0,0 +1,202 @@
+#include "TangentFrameBenchmarks.h"
+
+#include "JobSystem.h"
+#include "TangentFrame.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 1449 x 1449 vertices: 4,193,408 triangles.
+constexpr int kGridVertices = 1449;
+
+template <typename Func> double MeasureMilliseconds(Func &&func) {
+  const auto start = Clock::now();
+  func();
+  const auto end = Clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Rolling heightfield with analytic normals, in 14-float records.
+void BuildTerrain(std::vector<float> &vertices,
+                  std::vector<std::uint32_t> &indices) {
+  constexpr int n = kGridVertices;
+  vertices.resize(static_cast<std::size_t>(n) * n * 14);
+  const float scale = 1.0f / static_cast<float>(n - 1);
+  for (int z = 0; z < n; ++z) {
+    for (int x = 0; x < n; ++x) {
+      const float u = static_cast<float>(x) * scale;
+      const float v = static_cast<float>(z) * scale;
+      const float dx = std::cos(u * 40.0f) * std::cos(v * 25.0f) * 40.0f;
+      const float dz = -std::sin(u * 40.0f) * std::sin(v * 25.0f) * 25.0f;
+      float *vertex = &vertices[(static_cast<std::size_t>(z) * n + x) * 14];
+      const float record[14] = {u * 1024.0f,
+                                std::sin(u * 40.0f) * std::cos(v * 25.0f),
+                                v * 1024.0f,
+                                u * 64.0f,
+                                (1.0f - v) * 64.0f,
+                                -dx / 1024.0f,
+                                1.0f,
+                                -dz / 1024.0f,
+                                0, 0, 0, 0, 0, 0};
+      std::copy(record, record + 14, vertex);
+    }
+  }
+  indices.clear();
+  indices.reserve(static_cast<std::size_t>(n - 1) * (n - 1) * 6);
+  const auto at = [](int x, int z) {
+    return static_cast<std::uint32_t>(z * n + x);
+  };
+  for (int z = 0; z < n - 1; ++z) {
+    for (int x = 0; x < n - 1; ++x) {
+      indices.insert(indices.end(), {at(x, z), at(x, z + 1), at(x + 1, z),
+                                     at(x + 1, z), at(x, z + 1),
+                                     at(x + 1, z + 1)});
+    }
+  }
+}
+
+void Normalize(float v[3]) {
+  const float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+  if (length > 1e-20f) {
+    v[0] /= length;
+    v[1] /= length;
+    v[2] /= length;
+  }
+}
+
+float Dot(const float a[3], const float b[3]) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// The scalar path the converter used before: unweighted sums of each
+// triangle's UV-space tangent and binormal, then Gram-Schmidt.
+void AccumulateScalar(std::vector<float> &vertices,
+                      const std::vector<std::uint32_t> &indices) {
+  constexpr std::size_t stride = 14;
+  for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+    float *v[3] = {&vertices[indices[i] * stride],
+                   &vertices[indices[i + 1] * stride],
+                   &vertices[indices[i + 2] * stride]};
+    float edge1[3], edge2[3];
+    for (int c = 0; c < 3; ++c) {
+      edge1[c] = v[1][c] - v[0][c];
+      edge2[c] = v[2][c] - v[0][c];
+    }
+    const float tu1 = v[1][3] - v[0][3];
+    const float tv1 = v[1][4] - v[0][4];
+    const float tu2 = v[2][3] - v[0][3];
+    const float tv2 = v[2][4] - v[0][4];
+    const float det = tu1 * tv2 - tu2 * tv1;
+    if (std::fabs(det) < 1e-20f) {
+      continue;
+    }
+    const float r = 1.0f / det;
+    for (int c = 0; c < 3; ++c) {
+      const float tangent = (tv2 * edge1[c] - tv1 * edge2[c]) * r;
+      const float binormal = (tu1 * edge2[c] - tu2 * edge1[c]) * r;
+      for (float *vertex : v) {
+        vertex[8 + c] += tangent;
+        vertex[11 + c] += binormal;
+      }
+    }
+  }
+
+  const std::size_t count = vertices.size() / stride;
+  for (std::size_t i = 0; i < count; ++i) {
+    float *vertex = &vertices[i * stride];
+    float n[3] = {vertex[5], vertex[6], vertex[7]};
+    Normalize(n);
+    float *t = vertex + 8;
+    float *b = vertex + 11;
+    const float tn = Dot(t, n);
+    for (int c = 0; c < 3; ++c) {
+      t[c] -= n[c] * tn;
+    }
+    Normalize(t);
+    const float bn = Dot(b, n);
+    const float bt = Dot(b, t);
+    for (int c = 0; c < 3; ++c) {
+      b[c] -= n[c] * bn + t[c] * bt;
+    }
+    Normalize(b);
+  }
+}
+
+bool FramesOrthonormal(const std::vector<float> &vertices) {
+  for (std::size_t i = 0; i < vertices.size(); i += 14) {
+    const float *t = &vertices[i + 8];
+    const float *b = &vertices[i + 11];
+    if (!(std::fabs(Dot(t, t) - 1.0f) < 1e-3f) ||
+        !(std::fabs(Dot(b, b) - 1.0f) < 1e-3f) ||
+        !(std::fabs(Dot(t, b)) < 1e-3f)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+bool RunTangentFrameBenchmarks() {
+  std::cout << "=== Tangent frame benchmark ===" << std::endl;
+
+  std::vector<float> source;
+  std::vector<std::uint32_t> indices;
+  BuildTerrain(source, indices);
+  const std::size_t vertex_count = source.size() / 14;
+
+  std::vector<float> scalar = source;
+  const double scalar_ms =
+      MeasureMilliseconds([&] { AccumulateScalar(scalar, indices); });
+
+  std::vector<float> serial = source;
+  const double serial_ms = MeasureMilliseconds([&] {
+    GenerateTangentFrames(serial.data(), vertex_count, 14, indices);
+  });
+
+  JobSystem job_system;
+  std::vector<float> threaded = source;
+  const double threaded_ms = MeasureMilliseconds([&] {
+    GenerateTangentFrames(threaded.data(), vertex_count, 14, indices,
+                          &job_system);
+  });
+
+  // Streams already in SoA form, as a terrain kept in streams would be.
+  TangentFrameStreams streams;
+  streams.Gather(source.data(), vertex_count, 14);
+  const double streams_serial_ms = MeasureMilliseconds([&] {
+    GenerateTangentFrames(indices.data(), indices.size(), streams);
+  });
+  const double streams_threaded_ms = MeasureMilliseconds([&] {
+    GenerateTangentFrames(indices.data(), indices.size(), streams,
+                          &job_system);
+  });
+
+  std::cout << std::fixed << std::setprecision(3) << indices.size() / 3
+            << " triangles, " << vertex_count << " vertices | scalar "
+            << scalar_ms << " ms" << std::endl;
+  std::cout << "  interleaved: SSE " << serial_ms << " ms | SSE + "
+            << job_system.GetWorkerCount() << " workers " << threaded_ms
+            << " ms" << std::endl;
+  std::cout << "  SoA streams: SSE " << streams_serial_ms << " ms | SSE + "
+            << job_system.GetWorkerCount() << " workers "
+            << streams_threaded_ms << " ms" << std::endl;
+
+  const bool consistent = FramesOrthonormal(serial) &&
+                          FramesOrthonormal(threaded) &&
+                          serial == threaded;
+  if (!consistent) {
+    std::cout << "Tangent frames not orthonormal or not deterministic"
+              << std::endl;
+  }
+  return consistent;
+}
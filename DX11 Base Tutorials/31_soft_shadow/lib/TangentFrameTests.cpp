@@ -0,0 +1,300 @@
+#include "TangentFrameTests.h"
+
+#include "JobSystem.h"
+#include "Logger.h"
+#include "TangentFrame.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+struct Vertex {
+  float x, y, z;
+  float u, v;
+  float nx, ny, nz;
+};
+
+void Load(const std::vector<Vertex> &vertices, TangentFrameStreams &streams) {
+  streams.Gather(&vertices[0].x, vertices.size(), sizeof(Vertex) / 4);
+}
+
+bool Near(float a, float b, float epsilon = 1e-4f) {
+  return std::fabs(a - b) <= epsilon;
+}
+
+bool FrameIs(const TangentFrameStreams &s, std::size_t i, float tx, float ty,
+             float tz, float bx, float by, float bz) {
+  return Near(s.tx[i], tx) && Near(s.ty[i], ty) && Near(s.tz[i], tz) &&
+         Near(s.bx[i], bx) && Near(s.by[i], by) && Near(s.bz[i], bz);
+}
+
+// Unit quad in the xy plane facing -z, u along +x and v down the texture
+// (the text model convention).
+std::vector<Vertex> MakeQuad(float x_offset, bool mirror_u) {
+  std::vector<Vertex> quad = {{0, 0, 0, 0, 1, 0, 0, -1},
+                              {0, 1, 0, 0, 0, 0, 0, -1},
+                              {1, 0, 0, 1, 1, 0, 0, -1},
+                              {1, 1, 0, 1, 0, 0, 0, -1}};
+  for (Vertex &vertex : quad) {
+    vertex.x += x_offset;
+    if (mirror_u) {
+      vertex.u = 1.0f - vertex.u;
+    }
+  }
+  return quad;
+}
+
+bool TestPlanarQuad(std::string &message) {
+  const std::vector<std::uint32_t> indices = {0, 1, 2, 2, 1, 3};
+  TangentFrameStreams streams;
+  Load(MakeQuad(0.0f, false), streams);
+  GenerateTangentFrames(indices.data(), indices.size(), streams);
+  for (std::size_t i = 0; i < 4; ++i) {
+    if (!FrameIs(streams, i, 1, 0, 0, 0, -1, 0)) {
+      message = "vertex " + std::to_string(i) + " frame wrong";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestSharedVertexProjectsIntoTangentPlane(std::string &message) {
+  // A tent: two slopes meeting at a ridge along x, v running across it.
+  // The ridge vertices carry the averaged +y normal, so both slopes'
+  // binormals project onto +z there.
+  const float s = std::sqrt(0.5f);
+  const std::vector<Vertex> vertices = {
+      {0, 1, 0, 0, 0.5f, 0, 1, 0},   {1, 1, 0, 1, 0.5f, 0, 1, 0},
+      {0, 0, -1, 0, 0, 0, s, -s},    {1, 0, -1, 1, 0, 0, s, -s},
+      {0, 0, 1, 0, 1, 0, s, s},      {1, 0, 1, 1, 1, 0, s, s}};
+  const std::vector<std::uint32_t> indices = {2, 0, 3, 3, 0, 1,
+                                              0, 4, 1, 1, 4, 5};
+  TangentFrameStreams streams;
+  Load(vertices, streams);
+  GenerateTangentFrames(indices.data(), indices.size(), streams);
+  for (std::size_t i = 0; i < 2; ++i) {
+    if (!FrameIs(streams, i, 1, 0, 0, 0, 0, 1)) {
+      message = "ridge vertex " + std::to_string(i) + " frame wrong";
+      return false;
+    }
+  }
+  if (!FrameIs(streams, 2, 1, 0, 0, 0, s, s) ||
+      !FrameIs(streams, 5, 1, 0, 0, 0, -s, s)) {
+    message = "slope vertices lost their face frames";
+    return false;
+  }
+  return true;
+}
+
+bool TestMirroredUvsKeepHandedness(std::string &message) {
+  std::vector<Vertex> vertices = MakeQuad(0.0f, false);
+  const std::vector<Vertex> mirrored = MakeQuad(2.0f, true);
+  vertices.insert(vertices.end(), mirrored.begin(), mirrored.end());
+  const std::vector<std::uint32_t> indices = {0, 1, 2, 2, 1, 3,
+                                              4, 5, 6, 6, 5, 7};
+  TangentFrameStreams streams;
+  Load(vertices, streams);
+  GenerateTangentFrames(indices.data(), indices.size(), streams);
+  for (std::size_t i = 4; i < 8; ++i) {
+    if (!FrameIs(streams, i, -1, 0, 0, 0, -1, 0)) {
+      message = "mirrored vertex " + std::to_string(i) + " frame wrong";
+      return false;
+    }
+  }
+  // (n x t) . b: the sign a shader would rebuild the binormal with.
+  const auto handedness = [&streams](std::size_t i) {
+    const float cx = streams.ny[i] * streams.tz[i] -
+                     streams.nz[i] * streams.ty[i];
+    const float cy = streams.nz[i] * streams.tx[i] -
+                     streams.nx[i] * streams.tz[i];
+    const float cz = streams.nx[i] * streams.ty[i] -
+                     streams.ny[i] * streams.tx[i];
+    return cx * streams.bx[i] + cy * streams.by[i] + cz * streams.bz[i];
+  };
+  if (!(handedness(0) * handedness(4) < 0.0f)) {
+    message = "mirrored half has the same handedness";
+    return false;
+  }
+  return true;
+}
+
+bool TestDegenerateUvsFallBack(std::string &message) {
+  // No UV area and a normal that is not unit length.
+  const std::vector<Vertex> vertices = {{0, 0, 0, 0.5f, 0.5f, 0, 0, -2},
+                                        {0, 1, 0, 0.5f, 0.5f, 0, 0, -2},
+                                        {1, 0, 0, 0.5f, 0.5f, 0, 0, -2}};
+  const std::vector<std::uint32_t> indices = {0, 1, 2};
+  TangentFrameStreams streams;
+  Load(vertices, streams);
+  GenerateTangentFrames(indices.data(), indices.size(), streams);
+  for (std::size_t i = 0; i < 3; ++i) {
+    const float t[3] = {streams.tx[i], streams.ty[i], streams.tz[i]};
+    const float b[3] = {streams.bx[i], streams.by[i], streams.bz[i]};
+    const float tt = t[0] * t[0] + t[1] * t[1] + t[2] * t[2];
+    const float bb = b[0] * b[0] + b[1] * b[1] + b[2] * b[2];
+    const float tb = t[0] * b[0] + t[1] * b[1] + t[2] * b[2];
+    if (!Near(tt, 1.0f) || !Near(bb, 1.0f) || !Near(tb, 0.0f) ||
+        !Near(t[2], 0.0f) || !Near(b[2], 0.0f)) {
+      message = "vertex " + std::to_string(i) + " has no orthonormal frame";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestThreadedMatchesSerial(std::string &message) {
+  // Large enough to take the parallel path.
+  constexpr int kCells = 184;
+  std::vector<Vertex> vertices;
+  for (int z = 0; z <= kCells; ++z) {
+    for (int x = 0; x <= kCells; ++x) {
+      const float u = static_cast<float>(x) / kCells;
+      const float v = static_cast<float>(z) / kCells;
+      const float height = std::sin(u * 17.0f) * std::cos(v * 11.0f);
+      vertices.push_back({u * 64.0f, height, v * 64.0f, u * 8.0f,
+                          (1.0f - v) * 8.0f, -std::cos(u * 17.0f), 4.0f,
+                          std::sin(v * 11.0f)});
+    }
+  }
+  std::vector<std::uint32_t> indices;
+  const auto at = [](int x, int z) {
+    return static_cast<std::uint32_t>(z * (kCells + 1) + x);
+  };
+  for (int z = 0; z < kCells; ++z) {
+    for (int x = 0; x < kCells; ++x) {
+      indices.insert(indices.end(), {at(x, z), at(x, z + 1), at(x + 1, z),
+                                     at(x + 1, z), at(x, z + 1),
+                                     at(x + 1, z + 1)});
+    }
+  }
+  if (indices.size() / 3 < kTangentFrameParallelTriangles) {
+    message = "grid below the parallel threshold";
+    return false;
+  }
+
+  TangentFrameStreams serial;
+  Load(vertices, serial);
+  GenerateTangentFrames(indices.data(), indices.size(), serial);
+  TangentFrameStreams threaded;
+  Load(vertices, threaded);
+  {
+    JobSystem job_system(3);
+    GenerateTangentFrames(indices.data(), indices.size(), threaded,
+                          &job_system);
+  }
+
+  const std::size_t bytes = vertices.size() * sizeof(float);
+  const std::vector<float> *outputs[2][6] = {
+      {&serial.tx, &serial.ty, &serial.tz, &serial.bx, &serial.by,
+       &serial.bz},
+      {&threaded.tx, &threaded.ty, &threaded.tz, &threaded.bx, &threaded.by,
+       &threaded.bz}};
+  for (int c = 0; c < 6; ++c) {
+    if (std::memcmp(outputs[0][c]->data(), outputs[1][c]->data(), bytes) !=
+        0) {
+      message = "threaded frames differ from serial ones";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestInterleavedOverload(std::string &message) {
+  const std::vector<Vertex> quad = MakeQuad(0.0f, false);
+  std::vector<float> records;
+  for (const Vertex &vertex : quad) {
+    records.insert(records.end(), &vertex.x, &vertex.x + 8);
+    records.insert(records.end(), 6, 7.0f); // Overwritten
+  }
+  const std::vector<float> original = records;
+  const std::vector<std::uint32_t> indices = {0, 1, 2, 2, 1, 3};
+  GenerateTangentFrames(records.data(), quad.size(), 14, indices);
+
+  for (std::size_t i = 0; i < quad.size(); ++i) {
+    const float *record = &records[i * 14];
+    if (std::memcmp(record, &original[i * 14], 8 * sizeof(float)) != 0) {
+      message = "inputs modified";
+      return false;
+    }
+    const float expected[6] = {1, 0, 0, 0, -1, 0};
+    for (int c = 0; c < 6; ++c) {
+      if (!Near(record[8 + c], expected[c])) {
+        message = "record " + std::to_string(i) + " frame wrong";
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(6);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("Planar quad frame", TestPlanarQuad);
+  run("Shared vertex frames project into the tangent plane",
+      TestSharedVertexProjectsIntoTangentPlane);
+  run("Mirrored UVs keep handedness", TestMirroredUvsKeepHandedness);
+  run("Degenerate UVs fall back to a perpendicular frame",
+      TestDegenerateUvsFallBack);
+  run("Threaded generation matches serial", TestThreadedMatchesSerial);
+  run("Interleaved records", TestInterleavedOverload);
+
+  return results;
+}
+
+} // namespace
+
+bool RunTangentFrameTests() {
+  const auto results = RunAllTestsInternal();
+  bool all_passed = true;
+
+  for (const auto &result : results) {
+    if (!result.passed) {
+      all_passed = false;
+      std::ostringstream oss;
+      oss << "Test failed: " << result.name;
+      if (!result.message.empty()) {
+        oss << " - " << result.message;
+      }
+      Logger::SetModule("TangentFrameTests");
+      Logger::LogError(oss.str());
+    }
+  }
+
+  if (all_passed) {
+    Logger::SetModule("TangentFrameTests");
+    Logger::LogInfo("All TangentFrame tests passed");
+  }
+
+  return all_passed;
+}
@@ -27,6 +27,12 @@ bool TextureShader::Initialize(HWND hwnd, ID3D11Device *device) {
     return false;
   }
 
+  // Post-process passes feed the ortho camera under these names.
+  EnableBindingPlan({{"worldMatrix", "deviceWorldMatrix"},
+                     {"viewMatrix", "baseViewMatrix"},
+                     {"projectionMatrix", "orthoMatrix"},
+                     {"shaderTexture", "texture"}});
+
   // Create matrix buffer
   if (!CreateConstantBuffer(sizeof(MatrixBufferType),
                             matrix_buffer_.GetAddressOf(), device)) {
@@ -42,19 +48,25 @@ bool TextureShader::Initialize(HWND hwnd, ID3D11Device *device) {
 }
 
 bool TextureShader::Render(int indexCount,
-                           const ShaderParameterContainer &parameters,
+                           const LayeredParameterView &parameters,
                            ID3D11DeviceContext *deviceContext) const {
 
-  auto worldMatrix = parameters.GetMatrix("deviceWorldMatrix");
-  auto viewMatrix = parameters.GetMatrix("baseViewMatrix");
+  if (HasBindingPlan()) {
+    if (!ApplyBindingPlan(parameters, deviceContext)) {
+      return false;
+    }
+  } else {
+    auto worldMatrix = parameters.GetMatrix("deviceWorldMatrix");
+    auto viewMatrix = parameters.GetMatrix("baseViewMatrix");
 
-  auto orthoMatrix = parameters.GetMatrix("orthoMatrix");
+    auto orthoMatrix = parameters.GetMatrix("orthoMatrix");
 
-  auto texture = parameters.GetTexture("texture");
+    auto texture = parameters.GetTexture("texture");
 
-  if (!SetShaderParameters(worldMatrix, viewMatrix, orthoMatrix, texture,
-                           deviceContext)) {
-    return false;
+    if (!SetShaderParameters(worldMatrix, viewMatrix, orthoMatrix, texture,
+                             deviceContext)) {
+      return false;
+    }
   }
 
   // Set the vertex input layout
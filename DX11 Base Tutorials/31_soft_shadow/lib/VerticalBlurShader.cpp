@@ -14,7 +14,7 @@ bool VerticalBlurShader::Initialize(HWND hwnd, ID3D11Device *device) {
 }
 
 bool VerticalBlurShader::Render(int indexCount,
-                                const ShaderParameterContainer &parameters,
+                                const LayeredParameterView &parameters,
                                 ID3D11DeviceContext *deviceContext) const {
 
   auto worldMatrix = parameters.GetMatrix("worldMatrix");
@@ -44,7 +44,7 @@ bool WaterShader::Initialize(HWND hwnd, ID3D11Device *device) {
 void WaterShader::Shutdown() { ShaderBase::Shutdown(); }
 
 bool WaterShader::Render(int indexCount,
-                         const ShaderParameterContainer &parameters,
+                         const LayeredParameterView &parameters,
                          ID3D11DeviceContext *deviceContext) const {
 
   auto worldMatrix = parameters.GetMatrix("worldMatrix");
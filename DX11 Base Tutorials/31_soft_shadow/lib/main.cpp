@@ -1,7 +1,95 @@
+#include "BoundingVolumeHierarchyBenchmarks.h"
+#include "BoundingVolumeHierarchyTests.h"
+#include "FrustumCullerBenchmarks.h"
+#include "FrustumCullerTests.h"
+#include "LayeredParameterViewTests.h"
+#include "MeshFile.h"
+#include "MeshFileBenchmarks.h"
+#include "MeshFileTests.h"
+#include "MeshOptimizerTests.h"
+#include "ParallelPassRecorderTests.h"
+#include "RenderGraphCompilerTests.h"
+#include "SceneStorageTests.h"
+#include "ShaderBindingPlanTests.h"
+#include "ShaderParameterBenchmarks.h"
 #include "ShaderParameterContainerTests.h"
 #include "System.h"
+#include "TangentFrameBenchmarks.h"
+#include "TangentFrameTests.h"
+#include <cstring>
+#include <filesystem>
 #include <iostream>
 #include <memory>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// --convert-mesh [--tangents] a.txt b.txt ... writes a.mesh, b.mesh next to
+// the text models, where Model and PBRModel pick them up. Meshes with
+// tangents serve both; without, PBRModel falls back to the text model.
+bool ConvertMeshes(const char *command_line) {
+  std::istringstream tokens(command_line);
+  std::string token;
+  bool after_flag = false;
+  bool with_tangents = false;
+  bool all_converted = true;
+  int converted = 0;
+  while (tokens >> token) {
+    if (token == "--convert-mesh") {
+      after_flag = true;
+    } else if (!after_flag) {
+      continue;
+    } else if (token == "--tangents") {
+      with_tangents = true;
+    } else {
+      const std::string mesh_path =
+          std::filesystem::path(token).replace_extension(".mesh").string();
+      all_converted =
+          ConvertTextModel(token, mesh_path, with_tangents) && all_converted;
+      ++converted;
+    }
+  }
+  return all_converted && converted > 0;
+}
+
+struct StartupTest {
+  const char *name;
+  bool (*run)();
+  // Slow or touching the file system: Debug builds and --self-test only.
+  bool heavy;
+};
+
+const StartupTest kStartupTests[] = {
+    {"ShaderParameterContainer", RunShaderParameterContainerTests, false},
+    {"LayeredParameterView", RunLayeredParameterViewTests, false},
+    {"ShaderBindingPlan", RunShaderBindingPlanTests, false},
+    {"RenderGraphCompiler", RunRenderGraphCompilerTests, false},
+    {"ParallelPassRecorder", RunParallelPassRecorderTests, true},
+    {"SceneStorage", RunSceneStorageTests, false},
+    {"FrustumCuller", RunFrustumCullerTests, false},
+    {"BoundingVolumeHierarchy", RunBoundingVolumeHierarchyTests, false},
+    {"MeshFile", RunMeshFileTests, true},
+    {"MeshOptimizer", RunMeshOptimizerTests, true},
+    {"TangentFrame", RunTangentFrameTests, true},
+};
+
+// Runs the startup tests in order, the heavy ones only when asked, and
+// stops at the first failure.
+bool RunStartupTests(bool include_heavy) {
+  for (const auto &test : kStartupTests) {
+    if (test.heavy && !include_heavy) {
+      continue;
+    }
+    if (!test.run()) {
+      std::cerr << test.name << " tests failed." << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR pScmdline,
                    int iCmdshow) {
@@ -17,15 +105,67 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR pScmdline,
   std::cout << "=== Debug Console Initialized ===" << std::endl;
 #endif
 
-  if (!RunShaderParameterContainerTests()) {
-    std::cerr << "ShaderParameterContainer tests failed. Aborting startup."
-              << std::endl;
+  // --self-test runs every test and exits without a window or device.
+  if (pScmdline != nullptr &&
+      std::strstr(pScmdline, "--self-test") != nullptr) {
+#ifndef _DEBUG
+    AllocConsole();
+    FILE *pTestOut = nullptr;
+    freopen_s(&pTestOut, "CONOUT$", "w", stdout);
+    freopen_s(&pTestOut, "CONOUT$", "w", stderr);
+    std::cout.clear();
+    std::cerr.clear();
+#endif
+    const bool passed = RunStartupTests(true);
+    FreeConsole();
+    return passed ? 0 : 1;
+  }
+
+#ifdef _DEBUG
+  const bool run_heavy_tests = true;
+#else
+  const bool run_heavy_tests = false;
+#endif
+  if (!RunStartupTests(run_heavy_tests)) {
+    std::cerr << "Aborting startup." << std::endl;
 #ifdef _DEBUG
     FreeConsole();
 #endif
     return 1;
   }
 
+  // Offline mesh conversion: no window or device either.
+  if (pScmdline != nullptr &&
+      std::strstr(pScmdline, "--convert-mesh") != nullptr) {
+#ifndef _DEBUG
+    AllocConsole();
+    FILE *pConvertOut = nullptr;
+    freopen_s(&pConvertOut, "CONOUT$", "w", stdout);
+    std::cout.clear();
+#endif
+    const bool converted = ConvertMeshes(pScmdline);
+    FreeConsole();
+    return converted ? 0 : 1;
+  }
+
+  // Headless benchmark mode: run micro-benchmarks and exit without creating
+  // a window or device.
+  if (pScmdline != nullptr && std::strstr(pScmdline, "--benchmark") != nullptr) {
+#ifndef _DEBUG
+    AllocConsole();
+    FILE *pBenchmarkOut = nullptr;
+    freopen_s(&pBenchmarkOut, "CONOUT$", "w", stdout);
+    std::cout.clear();
+#endif
+    bool benchmarks_ok = RunShaderParameterBenchmarks();
+    benchmarks_ok = RunFrustumCullerBenchmarks() && benchmarks_ok;
+    benchmarks_ok = RunBoundingVolumeHierarchyBenchmarks() && benchmarks_ok;
+    benchmarks_ok = RunMeshFileBenchmarks() && benchmarks_ok;
+    benchmarks_ok = RunTangentFrameBenchmarks() && benchmarks_ok;
+    FreeConsole();
+    return benchmarks_ok ? 0 : 1;
+  }
+
   // Use smart pointer to manage System lifetime, avoid manual new/delete
   auto system = std::make_unique<System>();
   if (!system) {
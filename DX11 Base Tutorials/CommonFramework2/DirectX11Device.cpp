@@ -387,16 +387,25 @@ void DirectX11Device::EndScene() {
   }
 }
 
-void DirectX11Device::TurnZBufferOn() {
-  device_context_->OMSetDepthStencilState(depth_stencil_state_.Get(), 1);
+void DirectX11Device::TurnZBufferOn() { TurnZBufferOn(device_context_.Get()); }
+
+void DirectX11Device::TurnZBufferOn(ID3D11DeviceContext *context) {
+  context->OMSetDepthStencilState(depth_stencil_state_.Get(), 1);
 }
 
 void DirectX11Device::TurnZBufferOff() {
-  device_context_->OMSetDepthStencilState(depth_disabled_stencil_state_.Get(),
-                                          1);
+  TurnZBufferOff(device_context_.Get());
+}
+
+void DirectX11Device::TurnZBufferOff(ID3D11DeviceContext *context) {
+  context->OMSetDepthStencilState(depth_disabled_stencil_state_.Get(), 1);
 }
 
 void DirectX11Device::TurnOnAlphaBlending() {
+  TurnOnAlphaBlending(device_context_.Get());
+}
+
+void DirectX11Device::TurnOnAlphaBlending(ID3D11DeviceContext *context) {
 
   float blendFactor[4];
 
@@ -405,11 +414,15 @@ void DirectX11Device::TurnOnAlphaBlending() {
   blendFactor[2] = 0.0f;
   blendFactor[3] = 0.0f;
 
-  device_context_->OMSetBlendState(alpha_enable_blending_state_.Get(),
-                                   blendFactor, 0xffffffff);
+  context->OMSetBlendState(alpha_enable_blending_state_.Get(), blendFactor,
+                           0xffffffff);
 }
 
 void DirectX11Device::TurnOffAlphaBlending() {
+  TurnOffAlphaBlending(device_context_.Get());
+}
+
+void DirectX11Device::TurnOffAlphaBlending(ID3D11DeviceContext *context) {
 
   float blendFactor[4];
 
@@ -418,8 +431,8 @@ void DirectX11Device::TurnOffAlphaBlending() {
   blendFactor[2] = 0.0f;
   blendFactor[3] = 0.0f;
 
-  device_context_->OMSetBlendState(alpha_disable_blending_state_.Get(),
-                                   blendFactor, 0xffffffff);
+  context->OMSetBlendState(alpha_disable_blending_state_.Get(), blendFactor,
+                           0xffffffff);
 }
 
 ID3D11Device *DirectX11Device::GetDevice() { return device_.Get(); }
@@ -450,18 +463,40 @@ ID3D11DepthStencilView *DirectX11Device::GetDepthStencilView() const {
 }
 
 void DirectX11Device::SetBackBufferRenderTarget() {
-  device_context_->OMSetRenderTargets(1, render_target_view_.GetAddressOf(),
-                                      depth_stencil_view_.Get());
+  SetBackBufferRenderTarget(device_context_.Get());
 }
 
-void DirectX11Device::ResetViewport() {
-  device_context_->RSSetViewports(1, &viewport_);
+void DirectX11Device::SetBackBufferRenderTarget(ID3D11DeviceContext *context) {
+  context->OMSetRenderTargets(1, render_target_view_.GetAddressOf(),
+                              depth_stencil_view_.Get());
+}
+
+void DirectX11Device::ResetViewport() { ResetViewport(device_context_.Get()); }
+
+void DirectX11Device::ResetViewport(ID3D11DeviceContext *context) {
+  context->RSSetViewports(1, &viewport_);
 }
 
 void DirectX11Device::TurnOnCulling() {
-  device_context_->RSSetState(raster_state_.Get());
+  TurnOnCulling(device_context_.Get());
+}
+
+void DirectX11Device::TurnOnCulling(ID3D11DeviceContext *context) {
+  context->RSSetState(raster_state_.Get());
 }
 
 void DirectX11Device::TurnOffCulling() {
-  device_context_->RSSetState(m_rasterStateNoCulling.Get());
+  TurnOffCulling(device_context_.Get());
+}
+
+void DirectX11Device::TurnOffCulling(ID3D11DeviceContext *context) {
+  context->RSSetState(m_rasterStateNoCulling.Get());
+}
+
+void DirectX11Device::ApplyDefaultState(ID3D11DeviceContext *context) {
+  TurnOnCulling(context);
+  TurnZBufferOn(context);
+  TurnOffAlphaBlending(context);
+  SetBackBufferRenderTarget(context);
+  ResetViewport(context);
 }
@@ -58,6 +58,28 @@ public:
 
   void ResetViewport();
 
+  // Same state changes issued on an explicit context, e.g. a deferred context
+  // recording on a worker thread.
+  void TurnZBufferOn(ID3D11DeviceContext *context);
+
+  void TurnZBufferOff(ID3D11DeviceContext *context);
+
+  void TurnOnAlphaBlending(ID3D11DeviceContext *context);
+
+  void TurnOffAlphaBlending(ID3D11DeviceContext *context);
+
+  void TurnOnCulling(ID3D11DeviceContext *context);
+
+  void TurnOffCulling(ID3D11DeviceContext *context);
+
+  void SetBackBufferRenderTarget(ID3D11DeviceContext *context);
+
+  void ResetViewport(ID3D11DeviceContext *context);
+
+  // Culling on, depth on, blending off, back buffer and full-screen viewport.
+  // Deferred contexts start from default pipeline state, not from this.
+  void ApplyDefaultState(ID3D11DeviceContext *context);
+
   ID3D11Device *GetDevice();
 
   ID3D11DeviceContext *GetDeviceContext();
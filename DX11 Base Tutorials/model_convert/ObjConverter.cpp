@@ -0,0 +1,384 @@
+#include "ObjConverter.h"
+
+#include "JobSystem.h"
+#include "TangentFrame.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+using namespace DirectX;
+
+namespace {
+
+enum Attribute { kPosition = 0, kTexcoord = 1, kNormal = 2 };
+
+// Output of one chunk. Relative indices are chunk-local until the join adds
+// the number of elements defined by earlier chunks.
+struct ObjChunk {
+  std::vector<float> positions;
+  std::vector<float> texcoords;
+  std::vector<float> normals;
+  std::vector<ObjMesh::Corner> corners;
+  std::vector<std::uint32_t> relative; // corner * 3 + Attribute
+  std::vector<std::uint8_t> present;   // Attribute bits per corner
+  std::string error;
+};
+
+bool IsBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+void SkipBlanks(const char *&p, const char *end) {
+  while (p < end && IsBlank(*p)) {
+    ++p;
+  }
+}
+
+bool ParseInt(const char *&p, const char *end, std::int64_t &value) {
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  if (p == end || *p < '0' || *p > '9') {
+    return false;
+  }
+  value = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+    value = std::min<std::int64_t>(value * 10 + (*p - '0'), INT32_MAX);
+  }
+  if (negative) {
+    value = -value;
+  }
+  return true;
+}
+
+// Reads count floats of a v/vt/vn line; extra values (w) are ignored.
+bool ParseFloats(const char *&p, const char *end, int count, float *out) {
+  for (int i = 0; i < count; ++i) {
+    if (!ParseDecimalFloat(p, end, out[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// 1-based OBJ index to 0-based; negative ones count back from the elements
+// defined so far in this chunk and are recorded for the join.
+bool ResolveIndex(std::int64_t raw, std::size_t defined, std::int32_t &index,
+                  bool &relative) {
+  if (raw == 0) {
+    return false;
+  }
+  relative = raw < 0;
+  index = static_cast<std::int32_t>(
+      relative ? static_cast<std::int64_t>(defined) + raw : raw - 1);
+  return true;
+}
+
+std::string LineSnippet(const char *line, const char *end) {
+  const char *eol = std::find(line, end, '\n');
+  return std::string(line, std::min<std::size_t>(eol - line, 60));
+}
+
+void ParseChunk(const char *begin, const char *end, ObjChunk &chunk) {
+  std::vector<ObjMesh::Corner> polygon;
+  std::vector<std::uint8_t> polygon_relative; // Attribute bits per corner
+  std::vector<std::uint8_t> polygon_present;  // Attribute bits per corner
+
+  for (const char *line = begin; line < end;) {
+    const char *p = line;
+    SkipBlanks(p, end);
+    const char *eol = std::find(p, end, '\n');
+    bool ok = true;
+
+    if (p + 1 < eol && p[0] == 'v' && IsBlank(p[1])) {
+      float xyz[3];
+      ++p;
+      ok = ParseFloats(p, eol, 3, xyz);
+      chunk.positions.insert(chunk.positions.end(), {xyz[0], xyz[1], -xyz[2]});
+    } else if (p + 2 < eol && p[0] == 'v' && p[1] == 't' && IsBlank(p[2])) {
+      float uv[2] = {0.0f, 0.0f};
+      p += 2;
+      ok = ParseFloats(p, eol, 1, uv);
+      ParseFloats(p, eol, 1, uv + 1); // v is optional
+      chunk.texcoords.insert(chunk.texcoords.end(), {uv[0], 1.0f - uv[1]});
+    } else if (p + 2 < eol && p[0] == 'v' && p[1] == 'n' && IsBlank(p[2])) {
+      float xyz[3];
+      p += 2;
+      ok = ParseFloats(p, eol, 3, xyz);
+      chunk.normals.insert(chunk.normals.end(), {xyz[0], xyz[1], -xyz[2]});
+    } else if (p + 1 < eol && p[0] == 'f' && IsBlank(p[1])) {
+      polygon.clear();
+      polygon_relative.clear();
+      polygon_present.clear();
+      ++p;
+      for (SkipBlanks(p, eol); ok && p < eol; SkipBlanks(p, eol)) {
+        ObjMesh::Corner corner{-1, -1, -1};
+        std::uint8_t relative_bits = 0;
+        std::uint8_t present_bits = 1u << kPosition;
+        bool relative = false;
+        std::int64_t raw = 0;
+        ok = ParseInt(p, eol, raw) &&
+             ResolveIndex(raw, chunk.positions.size() / 3, corner.position,
+                          relative);
+        relative_bits |= relative ? 1u << kPosition : 0u;
+        if (ok && p < eol && *p == '/') {
+          ++p;
+          if (p < eol && *p != '/') {
+            ok = ParseInt(p, eol, raw) &&
+                 ResolveIndex(raw, chunk.texcoords.size() / 2,
+                              corner.texcoord, relative);
+            relative_bits |= relative ? 1u << kTexcoord : 0u;
+            present_bits |= 1u << kTexcoord;
+          }
+          if (ok && p < eol && *p == '/') {
+            ++p;
+            ok = ParseInt(p, eol, raw) &&
+                 ResolveIndex(raw, chunk.normals.size() / 3, corner.normal,
+                              relative);
+            relative_bits |= relative ? 1u << kNormal : 0u;
+            present_bits |= 1u << kNormal;
+          }
+        }
+        polygon.push_back(corner);
+        polygon_relative.push_back(relative_bits);
+        polygon_present.push_back(present_bits);
+      }
+      ok = ok && polygon.size() >= 3;
+
+      // Fan, reversing each triangle's winding for the left-handed system.
+      for (std::size_t i = 1; ok && i + 1 < polygon.size(); ++i) {
+        for (std::size_t k : {i + 1, i, std::size_t{0}}) {
+          const std::size_t corner = chunk.corners.size();
+          for (int a = kPosition; a <= kNormal; ++a) {
+            if (polygon_relative[k] & (1u << a)) {
+              chunk.relative.push_back(
+                  static_cast<std::uint32_t>(corner * 3 + a));
+            }
+          }
+          chunk.corners.push_back(polygon[k]);
+          chunk.present.push_back(polygon_present[k]);
+        }
+      }
+    }
+    // Anything else (comments, groups, materials, smoothing) is skipped.
+
+    if (!ok) {
+      chunk.error = "malformed line \"" + LineSnippet(line, end) + "\"";
+      return;
+    }
+    line = eol + (eol < end ? 1 : 0);
+  }
+}
+
+std::int32_t &CornerField(ObjMesh::Corner &corner, int attribute) {
+  return attribute == kPosition   ? corner.position
+         : attribute == kTexcoord ? corner.texcoord
+                                  : corner.normal;
+}
+
+// Open-addressing map from index triple to welded vertex.
+class WeldTable {
+public:
+  explicit WeldTable(std::size_t expected) {
+    std::size_t capacity = 16;
+    while (capacity < expected * 2) {
+      capacity *= 2;
+    }
+    slots_.assign(capacity, Slot{});
+    mask_ = capacity - 1;
+  }
+
+  // Index of the vertex for corner, or next when it is new (inserted).
+  std::uint32_t FindOrInsert(const ObjMesh::Corner &corner,
+                             std::uint32_t next, bool &inserted) {
+    std::uint64_t hash = static_cast<std::uint32_t>(corner.position);
+    hash = hash * 0x9e3779b97f4a7c15ull ^
+           static_cast<std::uint32_t>(corner.texcoord);
+    hash = hash * 0x9e3779b97f4a7c15ull ^
+           static_cast<std::uint32_t>(corner.normal);
+    hash *= 0x9e3779b97f4a7c15ull;
+    for (std::size_t i = static_cast<std::size_t>(hash >> 32) & mask_;;
+         i = (i + 1) & mask_) {
+      Slot &slot = slots_[i];
+      if (slot.vertex == kEmpty) {
+        slot.key = corner;
+        slot.vertex = next;
+        inserted = true;
+        return next;
+      }
+      if (slot.key.position == corner.position &&
+          slot.key.texcoord == corner.texcoord &&
+          slot.key.normal == corner.normal) {
+        inserted = false;
+        return slot.vertex;
+      }
+    }
+  }
+
+private:
+  static constexpr std::uint32_t kEmpty = 0xffffffffu;
+
+  struct Slot {
+    ObjMesh::Corner key{};
+    std::uint32_t vertex = kEmpty;
+  };
+
+  std::vector<Slot> slots_;
+  std::size_t mask_ = 0;
+};
+
+} // namespace
+
+bool ParseObj(const char *text, std::size_t size, std::size_t thread_count,
+              ObjMesh &mesh, std::string &error) {
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  // Chunks below 1 MiB are not worth a thread.
+  thread_count =
+      std::max<std::size_t>(1, std::min(thread_count, size >> 20));
+
+  // Chunk boundaries just after a newline.
+  std::vector<const char *> bounds = {text};
+  const char *end = text + size;
+  for (std::size_t i = 1; i < thread_count; ++i) {
+    const char *split = std::max(bounds.back(), text + size * i / thread_count);
+    split = std::find(split, end, '\n');
+    bounds.push_back(split == end ? end : split + 1);
+  }
+  bounds.push_back(end);
+
+  std::vector<ObjChunk> chunks(thread_count);
+  std::vector<std::thread> workers;
+  for (std::size_t i = 1; i < thread_count; ++i) {
+    workers.emplace_back(ParseChunk, bounds[i], bounds[i + 1],
+                         std::ref(chunks[i]));
+  }
+  ParseChunk(bounds[0], bounds[1], chunks[0]);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  // Join in file order; relative indices get the preceding chunks' counts.
+  std::size_t totals[3] = {0, 0, 0};
+  std::size_t corner_total = 0;
+  for (const auto &chunk : chunks) {
+    if (!chunk.error.empty()) {
+      error = chunk.error;
+      return false;
+    }
+    totals[kPosition] += chunk.positions.size();
+    totals[kTexcoord] += chunk.texcoords.size();
+    totals[kNormal] += chunk.normals.size();
+    corner_total += chunk.corners.size();
+  }
+  mesh = ObjMesh{};
+  mesh.positions.reserve(totals[kPosition]);
+  mesh.texcoords.reserve(totals[kTexcoord]);
+  mesh.normals.reserve(totals[kNormal]);
+  mesh.corners.reserve(corner_total);
+  const std::int64_t counts[3] = {
+      static_cast<std::int64_t>(totals[kPosition] / 3),
+      static_cast<std::int64_t>(totals[kTexcoord] / 2),
+      static_cast<std::int64_t>(totals[kNormal] / 3)};
+  for (auto &chunk : chunks) {
+    const std::int32_t offsets[3] = {
+        static_cast<std::int32_t>(mesh.positions.size() / 3),
+        static_cast<std::int32_t>(mesh.texcoords.size() / 2),
+        static_cast<std::int32_t>(mesh.normals.size() / 3)};
+    for (const std::uint32_t slot : chunk.relative) {
+      CornerField(chunk.corners[slot / 3], slot % 3) += offsets[slot % 3];
+    }
+    // Omitted texcoords and normals stay -1; anything the face did give has
+    // to land on a defined element, including relative indices reaching
+    // back before the start of the file.
+    for (std::size_t c = 0; c < chunk.corners.size(); ++c) {
+      for (int a = kPosition; a <= kNormal; ++a) {
+        if (!(chunk.present[c] & (1u << a))) {
+          continue;
+        }
+        const std::int32_t index = CornerField(chunk.corners[c], a);
+        if (index < 0 || index >= counts[a]) {
+          error = "face index " + std::to_string(index + 1) + " out of range";
+          return false;
+        }
+      }
+    }
+    mesh.positions.insert(mesh.positions.end(), chunk.positions.begin(),
+                          chunk.positions.end());
+    mesh.texcoords.insert(mesh.texcoords.end(), chunk.texcoords.begin(),
+                          chunk.texcoords.end());
+    mesh.normals.insert(mesh.normals.end(), chunk.normals.begin(),
+                        chunk.normals.end());
+    mesh.corners.insert(mesh.corners.end(), chunk.corners.begin(),
+                        chunk.corners.end());
+    chunk = ObjChunk{};
+  }
+  return true;
+}
+
+void BuildMeshData(const ObjMesh &obj, bool with_tangents, MeshData &mesh) {
+  const std::size_t stride = with_tangents ? 14 : 8;
+  mesh.layout = with_tangents ? GetTangentFrameModelLayout()
+                              : GetTextModelLayout();
+  mesh.vertex_stride = static_cast<std::uint32_t>(stride * sizeof(float));
+  mesh.vertices.clear();
+  mesh.indices.resize(obj.corners.size());
+
+  WeldTable table(obj.corners.size());
+  std::uint32_t next = 0;
+  for (std::size_t i = 0; i < obj.corners.size(); ++i) {
+    const ObjMesh::Corner &corner = obj.corners[i];
+    bool inserted = false;
+    mesh.indices[i] = table.FindOrInsert(corner, next, inserted);
+    if (!inserted) {
+      continue;
+    }
+    ++next;
+    const float *p = &obj.positions[corner.position * 3];
+    const float *t = corner.texcoord >= 0 ? &obj.texcoords[corner.texcoord * 2]
+                                          : nullptr;
+    const float *n =
+        corner.normal >= 0 ? &obj.normals[corner.normal * 3] : nullptr;
+    mesh.vertices.insert(mesh.vertices.end(),
+                         {p[0], p[1], p[2], t ? t[0] : 0.0f, t ? t[1] : 0.0f,
+                          n ? n[0] : 0.0f, n ? n[1] : 0.0f, n ? n[2] : 0.0f});
+    if (with_tangents) {
+      mesh.vertices.insert(mesh.vertices.end(), 6, 0.0f);
+    }
+  }
+  if (with_tangents) {
+    const auto job_system =
+        CreateTangentFrameJobSystem(obj.GetTriangleCount());
+    GenerateTangentFrames(mesh.vertices.data(), next, stride, mesh.indices,
+                          job_system.get());
+  }
+
+  std::vector<XMFLOAT3> positions(next);
+  for (std::uint32_t i = 0; i < next; ++i) {
+    positions[i] = XMFLOAT3(&mesh.vertices[i * stride]);
+  }
+  mesh.bounds.CalculateFromVertices(positions.data(), positions.size());
+}
+
+bool WriteTextModel(const std::string &path, const MeshData &mesh) {
+  const std::size_t stride = mesh.vertex_stride / sizeof(float);
+  std::string text = "Vertex Count: " + std::to_string(mesh.indices.size()) +
+                     "\n\nData:\n\n";
+  text.reserve(text.size() + mesh.indices.size() * 64);
+  char line[256];
+  for (const std::uint32_t index : mesh.indices) {
+    const float *v = &mesh.vertices[index * stride];
+    const int length =
+        std::snprintf(line, sizeof(line), "%g %g %g %g %g %g %g %g\n", v[0],
+                      v[1], v[2], v[3], v[4], v[5], v[6], v[7]);
+    text.append(line, static_cast<std::size_t>(length));
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(text.data(), static_cast<std::streamsize>(text.size()));
+  return static_cast<bool>(file);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "MeshFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// OBJ contents after parsing, converted to the left-handed system the
+// tutorials use (z and normal z negated, v flipped, winding reversed).
+// Polygons are fanned into triangles; corners hold 0-based indices into the
+// attribute arrays, -1 where the face omits texcoord or normal.
+struct ObjMesh {
+  std::vector<float> positions; // xyz
+  std::vector<float> texcoords; // uv
+  std::vector<float> normals;   // xyz
+
+  struct Corner {
+    std::int32_t position;
+    std::int32_t texcoord;
+    std::int32_t normal;
+  };
+  std::vector<Corner> corners; // Three per triangle
+
+  std::size_t GetTriangleCount() const { return corners.size() / 3; }
+};
+
+// Parses an OBJ held in memory. The text is split at line boundaries into
+// one chunk per thread and the chunks are parsed concurrently, then joined;
+// relative (negative) indices are resolved across chunks. thread_count 0
+// uses every hardware thread. On failure, error names the first bad line's
+// problem.
+bool ParseObj(const char *text, std::size_t size, std::size_t thread_count,
+              ObjMesh &mesh, std::string &error);
+
+// Welds identical position/texcoord/normal index triples through a hash
+// table and emits the indexed mesh in the text model layout, or with
+// per-vertex tangent frames (GenerateTangentFrames()).
+void BuildMeshData(const ObjMesh &obj, bool with_tangents, MeshData &mesh);
+
+// Legacy unindexed text model ("Vertex Count: N"), for tutorials that still
+// load model.txt files.
+bool WriteTextModel(const std::string &path, const MeshData &mesh);
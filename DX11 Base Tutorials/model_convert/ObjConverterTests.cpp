@@ -0,0 +1,250 @@
+#include "ObjConverterTests.h"
+
+#include "Logger.h"
+#include "ObjConverter.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+bool SameCorners(const ObjMesh &a, const ObjMesh &b) {
+  if (a.corners.size() != b.corners.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < a.corners.size(); ++i) {
+    if (a.corners[i].position != b.corners[i].position ||
+        a.corners[i].texcoord != b.corners[i].texcoord ||
+        a.corners[i].normal != b.corners[i].normal) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SameMesh(const ObjMesh &a, const ObjMesh &b) {
+  return a.positions == b.positions && a.texcoords == b.texcoords &&
+         a.normals == b.normals && SameCorners(a, b);
+}
+
+bool Parse(const std::string &text, std::size_t thread_count, ObjMesh &mesh,
+           std::string &error) {
+  return ParseObj(text.data(), text.size(), thread_count, mesh, error);
+}
+
+// The same mesh written twice: once with relative (negative) face indices,
+// some reaching back into the previous block, and once with the absolute
+// indices they stand for. Each block adds 4 positions, 4 texcoords and 2
+// normals, so the three attributes count back from different totals.
+void BuildBlockObj(int block_count, std::string &relative,
+                   std::string &absolute) {
+  std::ostringstream rel;
+  std::ostringstream abs;
+  int positions = 0;
+  int texcoords = 0;
+  int normals = 0;
+  for (int b = 0; b < block_count; ++b) {
+    std::ostringstream defs;
+    for (int k = 0; k < 4; ++k) {
+      defs << "v " << b << ' ' << k << ".5 " << (b % 7) << "\n";
+      defs << "vt 0." << k << ' ' << (b % 10) << ".25\n";
+    }
+    defs << "vn 0 0 1\nvn 0 1 0\n";
+    rel << "# block " << b << "\n" << defs.str();
+    abs << "# block " << b << "\n" << defs.str();
+    positions += 4;
+    texcoords += 4;
+    normals += 2;
+
+    // 1-based absolute index of relative index -k.
+    const auto p = [&](int k) { return positions + 1 - k; };
+    const auto t = [&](int k) { return texcoords + 1 - k; };
+    const auto n = [&](int k) { return normals + 1 - k; };
+
+    rel << "f -4/-4/-2 -3/-3/-2 -2/-2/-1 -1/-1/-1\n";
+    abs << "f " << p(4) << '/' << t(4) << '/' << n(2) << ' ' << p(3) << '/'
+        << t(3) << '/' << n(2) << ' ' << p(2) << '/' << t(2) << '/' << n(1)
+        << ' ' << p(1) << '/' << t(1) << '/' << n(1) << "\n";
+    if (b > 0) {
+      rel << "f -8/-7 -5/-6 -1//-3\n";
+      abs << "f " << p(8) << '/' << t(7) << ' ' << p(5) << '/' << t(6) << ' '
+          << p(1) << "//" << n(3) << "\n";
+    }
+    rel << "f 1 -1 -2\n";
+    abs << "f 1 " << p(1) << ' ' << p(2) << "\n";
+  }
+  relative = rel.str();
+  absolute = abs.str();
+}
+
+bool TestFanAndHandedness(std::string &message) {
+  const std::string text = "v 0 0 1\n"
+                           "v 1 0 1\n"
+                           "v 1 1 1\n"
+                           "v 0 1 1\n"
+                           "vt 0.25 0.25\n"
+                           "vn 0 0 1\n"
+                           "f 1/1/1 2/1/1 3/1/1 4/1/1\n";
+  ObjMesh mesh;
+  if (!Parse(text, 1, mesh, message)) {
+    return false;
+  }
+  const int expected[] = {2, 1, 0, 3, 2, 0};
+  if (mesh.corners.size() != 6) {
+    message = "quad not fanned into two triangles";
+    return false;
+  }
+  for (std::size_t i = 0; i < 6; ++i) {
+    if (mesh.corners[i].position != expected[i]) {
+      message = "winding not reversed";
+      return false;
+    }
+  }
+  return mesh.positions[2] == -1.0f && mesh.normals[2] == -1.0f &&
+         mesh.texcoords[1] == 0.75f;
+}
+
+bool TestOmittedAttributesStayAbsent(std::string &message) {
+  const std::string text = "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\n"
+                           "f 1 2 3\n"
+                           "f 1/1 2/1 3/-1\n";
+  ObjMesh mesh;
+  if (!Parse(text, 1, mesh, message)) {
+    return false;
+  }
+  for (std::size_t i = 0; i < mesh.corners.size(); ++i) {
+    const ObjMesh::Corner &corner = mesh.corners[i];
+    if (corner.normal != -1 || corner.texcoord != (i < 3 ? -1 : 0)) {
+      message = "omitted attribute not -1";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestRejectsOutOfRangeIndices(std::string &message) {
+  const char *const bad_faces[] = {
+      "f 0 1 2\n",           // OBJ indices start at 1
+      "f 1 2 4\n",           // Past the last position
+      "f -4 -2 -1\n",        // Before the first position
+      "f 1/-2 2/-1 3/-1\n",  // Texcoord resolves to -1, not "absent"
+      "f 1//-2 2//-1 3//1\n" // Same for normals
+  };
+  const std::string defs = "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvn 0 0 1\n";
+  for (const char *face : bad_faces) {
+    ObjMesh mesh;
+    std::string error;
+    if (Parse(defs + face, 1, mesh, error)) {
+      message = std::string("accepted ") + face;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestChunkedParseMatchesAtEveryThreadCount(std::string &message) {
+  std::string relative;
+  std::string absolute;
+  BuildBlockObj(40000, relative, absolute);
+  // ParseObj gives each thread at least 1 MiB.
+  if (relative.size() < (std::size_t{4} << 20)) {
+    message = "test OBJ too small for four chunks";
+    return false;
+  }
+
+  ObjMesh expected;
+  if (!Parse(absolute, 1, expected, message)) {
+    return false;
+  }
+  MeshData expected_data;
+  BuildMeshData(expected, true, expected_data);
+
+  for (const std::size_t threads : {1u, 2u, 3u, 4u, 8u}) {
+    ObjMesh mesh;
+    if (!Parse(relative, threads, mesh, message)) {
+      message = std::to_string(threads) + " threads: " + message;
+      return false;
+    }
+    if (!SameMesh(mesh, expected)) {
+      message = std::to_string(threads) +
+                " threads: relative indices resolved differently";
+      return false;
+    }
+    MeshData data;
+    BuildMeshData(mesh, true, data);
+    if (data.vertices != expected_data.vertices ||
+        data.indices != expected_data.indices) {
+      message = std::to_string(threads) + " threads: welded mesh differs";
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(4);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("Polygons fan into left-handed triangles", TestFanAndHandedness);
+  run("Omitted texcoords and normals stay absent",
+      TestOmittedAttributesStayAbsent);
+  run("Out-of-range face indices are rejected", TestRejectsOutOfRangeIndices);
+  run("Chunked parse matches at every thread count",
+      TestChunkedParseMatchesAtEveryThreadCount);
+
+  return results;
+}
+
+} // namespace
+
+bool RunObjConverterTests() {
+  const auto results = RunAllTestsInternal();
+  bool all_passed = true;
+
+  for (const auto &result : results) {
+    if (!result.passed) {
+      all_passed = false;
+      std::ostringstream oss;
+      oss << "Test failed: " << result.name;
+      if (!result.message.empty()) {
+        oss << " - " << result.message;
+      }
+      Logger::SetModule("ObjConverterTests");
+      Logger::LogError(oss.str());
+    }
+  }
+
+  if (all_passed) {
+    Logger::SetModule("ObjConverterTests");
+    Logger::LogInfo("All ObjConverter tests passed");
+  }
+
+  return all_passed;
+}
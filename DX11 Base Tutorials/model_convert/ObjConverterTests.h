@@ -0,0 +1,7 @@
+#pragma once
+
+// Executes the ObjConverter unit tests: triangulation and the left-handed
+// conversion, omitted and out-of-range face indices, and a multi-chunk OBJ
+// with relative indices that must parse and weld the same at every thread
+// count. Returns true when all tests pass without runtime errors.
+bool RunObjConverterTests();
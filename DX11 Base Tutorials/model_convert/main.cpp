@@ -1,317 +1,178 @@
-#include <fstream>
+#include "ObjConverter.h"
+#include "ObjConverterTests.h"
+
+#include "MappedFile.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
 #include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
 
 using namespace std;
 
-typedef struct {
-  float x, y, z;
-} VertexType;
-
-typedef struct {
-  int vIndex1, vIndex2, vIndex3;
-  int tIndex1, tIndex2, tIndex3;
-  int nIndex1, nIndex2, nIndex3;
-} FaceType;
-
-void GetModelFilename(char *);
-
-bool ReadFileCounts(char *, int &, int &, int &, int &);
-
-bool LoadDataStructures(char *, int, int, int, int);
-
-int main() {
-
-  bool result;
-  char filename[256];
-  int vertexCount, textureCount, normalCount, faceCount;
-  char garbage;
-
-  GetModelFilename(filename);
-
-  result = ReadFileCounts(filename, vertexCount, textureCount, normalCount,
-                          faceCount);
-  if (!result) {
-    return -1;
-  }
-
-  cout << endl;
-  cout << "Vertices: " << vertexCount << endl;
-  cout << "UVs:      " << textureCount << endl;
-  cout << "Normals:  " << normalCount << endl;
-  cout << "Faces:    " << faceCount << endl;
-
-  result = LoadDataStructures(filename, vertexCount, textureCount, normalCount,
-                              faceCount);
-  if (!result) {
-    return -1;
-  }
-
-  cout << "\nFile has been converted." << endl;
-  cout << "\nDo you wish to exit (y/n)? ";
-  cin >> garbage;
-
-  return 0;
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Options {
+  fs::path output_directory; // Empty: next to each source
+  bool text_output = false;
+  bool with_tangents = false;
+  bool self_test = false;
+  size_t thread_count = 0;
+  vector<fs::path> inputs;
+};
+
+void PrintUsage() {
+  cout << "Usage: model_convert [options] <file.obj | directory>...\n"
+          "\n"
+          "Converts OBJ files (directories are searched recursively) to\n"
+          "indexed .mesh files next to the source.\n"
+          "\n"
+          "  -o <dir>       write outputs to dir instead\n"
+          "  --txt          write unindexed model .txt files instead\n"
+          "  --tangents     add per-vertex tangent frames (.mesh only)\n"
+          "  --threads <n>  parser threads per file (default: all cores)\n"
+          "  --self-test    run the converter unit tests and exit\n";
 }
-void GetModelFilename(char *filename) {
-
-  bool done;
-  ifstream fin;
 
-  done = false;
-  while (!done) {
-    // Ask the user for the filename.
-    cout << "Enter model filename: ";
-
-    // Read in the filename.
-    cin >> filename;
-
-    // Attempt to open the file.
-    fin.open(filename);
-
-    if (fin.good()) {
-      // If the file exists and there are no problems then exit since we have
-      // the file name.
-      done = true;
+bool ParseArguments(int argc, char *argv[], Options &options) {
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    if (strcmp(arg, "-o") == 0 && i + 1 < argc) {
+      options.output_directory = argv[++i];
+    } else if (strcmp(arg, "--txt") == 0) {
+      options.text_output = true;
+    } else if (strcmp(arg, "--tangents") == 0) {
+      options.with_tangents = true;
+    } else if (strcmp(arg, "--self-test") == 0) {
+      options.self_test = true;
+    } else if (strcmp(arg, "--threads") == 0 && i + 1 < argc) {
+      options.thread_count = strtoul(argv[++i], nullptr, 10);
+    } else if (arg[0] == '-') {
+      cerr << "Unknown option " << arg << endl;
+      return false;
     } else {
-      // If the file does not exist or there was an issue opening it then notify
-      // the user and repeat the process.
-      fin.clear();
-      cout << endl;
-      cout << "File " << filename << " could not be opened." << endl << endl;
+      options.inputs.push_back(arg);
     }
   }
+  return options.self_test || !options.inputs.empty();
 }
 
-bool ReadFileCounts(char *filename, int &vertexCount, int &textureCount,
-                    int &normalCount, int &faceCount) {
-
-  ifstream fin;
-  char input;
-
-  // Initialize the counts.
-  vertexCount = 0;
-  textureCount = 0;
-  normalCount = 0;
-  faceCount = 0;
-
-  // Open the file.
-  fin.open(filename);
-
-  // Check if it was successful in opening the file.
-  if (fin.fail() == true) {
-    return false;
+bool HasObjExtension(const fs::path &path) {
+  string extension = path.extension().string();
+  for (char &c : extension) {
+    c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
   }
+  return extension == ".obj";
+}
 
-  // Read from the file and continue to read until the end of the file is
-  // reached.
-  fin.get(input);
-  while (!fin.eof()) {
-    // If the line starts with 'v' then count either the vertex, the texture
-    // coordinates, or the normal vector.
-    if (input == 'v') {
-      fin.get(input);
-      if (input == ' ') {
-        vertexCount++;
-      }
-      if (input == 't') {
-        textureCount++;
-      }
-      if (input == 'n') {
-        normalCount++;
-      }
-    }
-
-    // If the line starts with 'f' then increment the face count.
-    if (input == 'f') {
-      fin.get(input);
-      if (input == ' ') {
-        faceCount++;
+bool CollectInputs(const vector<fs::path> &inputs, vector<fs::path> &files) {
+  for (const auto &input : inputs) {
+    error_code error;
+    if (fs::is_directory(input, error)) {
+      for (fs::recursive_directory_iterator it(input, error), end;
+           !error && it != end; it.increment(error)) {
+        if (it->is_regular_file() && HasObjExtension(it->path())) {
+          files.push_back(it->path());
+        }
       }
+    } else if (fs::is_regular_file(input, error)) {
+      files.push_back(input);
+    } else {
+      cerr << input.string() << ": not found" << endl;
+      return false;
     }
-
-    // Otherwise read in the remainder of the line.
-    while (input != '\n') {
-      fin.get(input);
-    }
-
-    // Start reading the beginning of the next line.
-    fin.get(input);
   }
-
-  fin.close();
-
   return true;
 }
 
-bool LoadDataStructures(char *filename, int vertexCount, int textureCount,
-                        int normalCount, int faceCount) {
+bool ConvertFile(const fs::path &input, const Options &options) {
+  const auto start = chrono::steady_clock::now();
 
-  VertexType *vertices, *texcoords, *normals;
-  FaceType *faces;
-  ifstream fin;
-  int vertexIndex, texcoordIndex, normalIndex, faceIndex, vIndex, tIndex,
-      nIndex;
-  char input, input2;
-  ofstream fout;
-
-  // Initialize the four data structures.
-  vertices = new VertexType[vertexCount];
-  if (!vertices) {
+  MappedFile file;
+  if (!file.Open(input.string())) {
+    cerr << input.string() << ": could not be opened" << endl;
     return false;
   }
-
-  texcoords = new VertexType[textureCount];
-  if (!texcoords) {
+  ObjMesh obj;
+  string error;
+  if (!ParseObj(reinterpret_cast<const char *>(file.GetData()),
+                file.GetSize(), options.thread_count, obj, error)) {
+    cerr << input.string() << ": " << error << endl;
     return false;
   }
+  file.Close();
 
-  normals = new VertexType[normalCount];
-  if (!normals) {
-    return false;
-  }
+  MeshData mesh;
+  BuildMeshData(obj, options.with_tangents && !options.text_output, mesh);
+  const MeshOptimizationReport report = OptimizeMesh(mesh);
 
-  faces = new FaceType[faceCount];
-  if (!faces) {
-    return false;
+  fs::path output = input;
+  output.replace_extension(options.text_output ? ".txt" : ".mesh");
+  if (!options.output_directory.empty()) {
+    output = options.output_directory / output.filename();
   }
-
-  // Initialize the indexes.
-  vertexIndex = 0;
-  texcoordIndex = 0;
-  normalIndex = 0;
-  faceIndex = 0;
-
-  // Open the file.
-  fin.open(filename);
-
-  // Check if it was successful in opening the file.
-  if (fin.fail() == true) {
+  const bool written = options.text_output
+                           ? WriteTextModel(output.string(), mesh)
+                           : WriteMeshFile(output.string(), mesh);
+  if (!written) {
+    cerr << output.string() << ": could not be written" << endl;
     return false;
   }
 
-  // Read in the vertices, texture coordinates, and normals into the data
-  // structures. Important: Also convert to left hand coordinate system since
-  // Maya uses right hand coordinate system.
-  fin.get(input);
-  while (!fin.eof()) {
-    if (input == 'v') {
-      fin.get(input);
-
-      // Read in the vertices.
-      if (input == ' ') {
-        fin >> vertices[vertexIndex].x >> vertices[vertexIndex].y >>
-            vertices[vertexIndex].z;
-
-        // Invert the Z vertex to change to left hand system.
-        vertices[vertexIndex].z = vertices[vertexIndex].z * -1.0f;
-        vertexIndex++;
-      }
-
-      // Read in the texture uv coordinates.
-      if (input == 't') {
-        fin >> texcoords[texcoordIndex].x >> texcoords[texcoordIndex].y;
-
-        // Invert the V texture coordinates to left hand system.
-        texcoords[texcoordIndex].y = 1.0f - texcoords[texcoordIndex].y;
-        texcoordIndex++;
-      }
-
-      // Read in the normals.
-      if (input == 'n') {
-        fin >> normals[normalIndex].x >> normals[normalIndex].y >>
-            normals[normalIndex].z;
-
-        // Invert the Z normal to change to left hand system.
-        normals[normalIndex].z = normals[normalIndex].z * -1.0f;
-        normalIndex++;
-      }
-    }
-
-    // Read in the faces.
-    if (input == 'f') {
-      fin.get(input);
-      if (input == ' ') {
-        // Read the face data in backwards to convert it to a left hand system
-        // from right hand system.
-        fin >> faces[faceIndex].vIndex3 >> input2 >> faces[faceIndex].tIndex3 >>
-            input2 >> faces[faceIndex].nIndex3 >> faces[faceIndex].vIndex2 >>
-            input2 >> faces[faceIndex].tIndex2 >> input2 >>
-            faces[faceIndex].nIndex2 >> faces[faceIndex].vIndex1 >> input2 >>
-            faces[faceIndex].tIndex1 >> input2 >> faces[faceIndex].nIndex1;
-        faceIndex++;
-      }
-    }
+  const double milliseconds =
+      chrono::duration<double, milli>(chrono::steady_clock::now() - start)
+          .count();
+  error_code size_error;
+  cout << input.string() << " -> " << output.string() << "\n  "
+       << obj.GetTriangleCount() << " triangles, " << obj.corners.size()
+       << " corners welded to " << mesh.GetVertexCount() << " vertices, "
+       << fs::file_size(output, size_error) / 1024 << " KiB, " << fixed
+       << setprecision(1) << milliseconds << " ms\n  ACMR " << setprecision(3)
+       << report.cache_before.acmr << " -> " << report.cache_after.acmr
+       << ", ATVR " << report.cache_before.atvr << " -> "
+       << report.cache_after.atvr << endl;
+  return true;
+}
 
-    // Read in the remainder of the line.
-    while (input != '\n') {
-      fin.get(input);
-    }
+} // namespace
 
-    // Start reading the beginning of the next line.
-    fin.get(input);
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!ParseArguments(argc, argv, options)) {
+    PrintUsage();
+    return 1;
   }
-
-  fin.close();
-
-  // Open the output file.
-  fout.open("model.txt");
-
-  // Write out the file header that our model format uses.
-  fout << "Vertex Count: " << (faceCount * 3) << endl;
-  fout << endl;
-  fout << "Data:" << endl;
-  fout << endl;
-
-  // Now loop through all the faces and output the three vertices for each face.
-  for (int i = 0; i < faceIndex; i++) {
-    vIndex = faces[i].vIndex1 - 1;
-    tIndex = faces[i].tIndex1 - 1;
-    nIndex = faces[i].nIndex1 - 1;
-
-    fout << vertices[vIndex].x << ' ' << vertices[vIndex].y << ' '
-         << vertices[vIndex].z << ' ' << texcoords[tIndex].x << ' '
-         << texcoords[tIndex].y << ' ' << normals[nIndex].x << ' '
-         << normals[nIndex].y << ' ' << normals[nIndex].z << endl;
-
-    vIndex = faces[i].vIndex2 - 1;
-    tIndex = faces[i].tIndex2 - 1;
-    nIndex = faces[i].nIndex2 - 1;
-
-    fout << vertices[vIndex].x << ' ' << vertices[vIndex].y << ' '
-         << vertices[vIndex].z << ' ' << texcoords[tIndex].x << ' '
-         << texcoords[tIndex].y << ' ' << normals[nIndex].x << ' '
-         << normals[nIndex].y << ' ' << normals[nIndex].z << endl;
-
-    vIndex = faces[i].vIndex3 - 1;
-    tIndex = faces[i].tIndex3 - 1;
-    nIndex = faces[i].nIndex3 - 1;
-
-    fout << vertices[vIndex].x << ' ' << vertices[vIndex].y << ' '
-         << vertices[vIndex].z << ' ' << texcoords[tIndex].x << ' '
-         << texcoords[tIndex].y << ' ' << normals[nIndex].x << ' '
-         << normals[nIndex].y << ' ' << normals[nIndex].z << endl;
+  if (options.self_test) {
+    return RunObjConverterTests() ? 0 : 1;
   }
 
-  // Close the output file.
-  fout.close();
-
-  // Release the four data structures.
-  if (vertices) {
-    delete[] vertices;
-    vertices = 0;
-  }
-  if (texcoords) {
-    delete[] texcoords;
-    texcoords = 0;
+  vector<fs::path> files;
+  if (!CollectInputs(options.inputs, files)) {
+    return 1;
   }
-  if (normals) {
-    delete[] normals;
-    normals = 0;
+  if (!options.output_directory.empty()) {
+    error_code error;
+    fs::create_directories(options.output_directory, error);
   }
-  if (faces) {
-    delete[] faces;
-    faces = 0;
+
+  size_t failed = 0;
+  for (const auto &file : files) {
+    if (!ConvertFile(file, options)) {
+      ++failed;
+    }
   }
 
-  return true;
-}
\ No newline at end of file
+  cout << files.size() - failed << " of " << files.size()
+       << " files converted." << endl;
+  return failed == 0 ? 0 : 1;
+}
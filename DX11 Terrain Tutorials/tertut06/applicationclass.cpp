@@ -19,6 +19,7 @@ ApplicationClass::ApplicationClass() {
   m_Light = 0;
   m_Frustum = 0;
   m_QuadTree = 0;
+  m_HeightField = 0;
 }
 
 ApplicationClass::ApplicationClass(const ApplicationClass &other) {}
@@ -32,6 +33,7 @@ bool ApplicationClass::Initialize(HINSTANCE hinstance, HWND hwnd,
   XMMATRIX baseViewMatrix;
   char videoCard[128];
   int videoMemory;
+  float *heightList;
 
   // Create the input object.  The input object will be used to handle reading
   // the keyboard and mouse input from the user.
@@ -233,10 +235,46 @@ bool ApplicationClass::Initialize(HINSTANCE hinstance, HWND hwnd,
     return false;
   }
 
+  // Create the height field object.
+  m_HeightField = new HeightFieldClass;
+  if (!m_HeightField) {
+    return false;
+  }
+
+  // Copy the terrain heights into a temporary array.
+  heightList = new float[m_Terrain->GetTerrainWidth() *
+                         m_Terrain->GetTerrainHeight()];
+  if (!heightList) {
+    return false;
+  }
+  m_Terrain->CopyHeightArray(heightList);
+
+  // Initialize the height field object from the terrain heights.
+  result = m_HeightField->Initialize(m_Terrain->GetTerrainWidth(),
+                                     m_Terrain->GetTerrainHeight(),
+                                     heightList);
+
+  // Release the temporary height array.
+  delete[] heightList;
+  heightList = 0;
+
+  if (!result) {
+    MessageBox(hwnd, L"Could not initialize the height field object.",
+               L"Error", MB_OK);
+    return false;
+  }
+
   return true;
 }
 
 void ApplicationClass::Shutdown() {
+  // Release the height field object.
+  if (m_HeightField) {
+    m_HeightField->Shutdown();
+    delete m_HeightField;
+    m_HeightField = 0;
+  }
+
   // Release the quad tree object.
   if (m_QuadTree) {
     m_QuadTree->Shutdown();
@@ -383,7 +421,8 @@ bool ApplicationClass::Frame() {
 
   // Get the height of the triangle that is directly underneath the given camera
   // position.
-  foundHeight = m_QuadTree->GetHeightAtPosition(position.x, position.z, height);
+  foundHeight =
+      m_HeightField->GetHeightAtPosition(position.x, position.z, height);
   if (foundHeight) {
     // If there was a triangle under the camera then position the camera just
     // above it by two units.
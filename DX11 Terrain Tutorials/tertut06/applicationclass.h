@@ -21,6 +21,7 @@ const float SCREEN_NEAR = 0.1f;
 #include "fontshaderclass.h"
 #include "fpsclass.h"
 #include "frustumclass.h"
+#include "heightfieldclass.h"
 #include "inputclass.h"
 #include "lightclass.h"
 #include "positionclass.h"
@@ -62,6 +63,7 @@ private:
   LightClass *m_Light;
   FrustumClass *m_Frustum;
   QuadTreeClass *m_QuadTree;
+  HeightFieldClass *m_HeightField;
 };
 
 #endif
\ No newline at end of file
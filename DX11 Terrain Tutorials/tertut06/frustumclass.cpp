@@ -258,3 +258,25 @@ bool FrustumClass::CheckRectangle(float xCenter, float yCenter, float zCenter,
 
   return true;
 }
+
+bool FrustumClass::CheckRectangleInside(float xCenter, float yCenter,
+                                        float zCenter, float xSize,
+                                        float ySize, float zSize) {
+  XMVECTOR tempVector;
+  XMFLOAT3 normal, temp;
+
+  // The rectangle is entirely inside if, for every plane, the corner that
+  // reaches furthest behind it is still in front of it.
+  for (int i = 0; i < 6; i++) {
+    XMStoreFloat3(&normal, m_planes[i]);
+    temp.x = (normal.x >= 0.0f) ? xCenter - xSize : xCenter + xSize;
+    temp.y = (normal.y >= 0.0f) ? yCenter - ySize : yCenter + ySize;
+    temp.z = (normal.z >= 0.0f) ? zCenter - zSize : zCenter + zSize;
+    tempVector = XMPlaneDotCoord(m_planes[i], XMLoadFloat3(&temp));
+    if (tempVector.m128_f32[0] < 0.0f) {
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -25,6 +25,7 @@ public:
   bool CheckCube(float, float, float, float);
   bool CheckSphere(float, float, float, float);
   bool CheckRectangle(float, float, float, float, float, float);
+  bool CheckRectangleInside(float, float, float, float, float, float);
 
 private:
   XMVECTOR m_planes[6];
@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: heightfieldbenchmarks.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "heightfieldbenchmarks.h"
+
+#include "heightfieldclass.h"
+#include "quadtreeclass.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int kTerrainSize = 1025;
+const int kQueries = 1 << 20;
+
+// The quad tree searches a whole leaf per query, so it gets fewer of them.
+const int kTreeQueries = 1 << 14;
+const int kRays = 20000;
+
+// Same layout as the vertices TerrainClass hands to the quad tree.
+struct BenchmarkVertex {
+  float x, y, z;
+  float tu, tv;
+  float nx, ny, nz;
+};
+
+template <typename Func> double MeasureMilliseconds(Func &&func) {
+  const auto start = Clock::now();
+  func();
+  const auto end = Clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+float SampleHeight(float x, float z) {
+  return 20.0f * sinf(x * 0.01f) * cosf(z * 0.013f) +
+         4.0f * sinf((x + z) * 0.07f);
+}
+
+} // namespace
+
+bool RunHeightFieldBenchmarks() {
+  const int cornerX[6] = {0, 1, 0, 0, 1, 1};
+  const int cornerZ[6] = {1, 1, 0, 0, 1, 0};
+  std::vector<float> heights((size_t)kTerrainSize * kTerrainSize);
+  std::vector<BenchmarkVertex> vertices;
+  std::vector<float> positionsX(kQueries), positionsZ(kQueries);
+  std::vector<float> single(kQueries), batched(kQueries);
+  HeightFieldClass field;
+  QuadTreeClass tree;
+  double buildMs, treeMs, singleMs, batchedMs, rayMs, sum;
+  float height, distance;
+  int hits;
+  bool matches;
+
+  printf("=== Height field query benchmark ===\n");
+
+  for (int z = 0; z < kTerrainSize; z++) {
+    for (int x = 0; x < kTerrainSize; x++) {
+      heights[(size_t)kTerrainSize * z + x] =
+          SampleHeight((float)x, (float)z);
+    }
+  }
+
+  // The quad tree needs the unindexed mesh TerrainClass would build.
+  vertices.resize((size_t)(kTerrainSize - 1) * (kTerrainSize - 1) * 6);
+  for (int j = 0; j < kTerrainSize - 1; j++) {
+    for (int i = 0; i < kTerrainSize - 1; i++) {
+      for (int k = 0; k < 6; k++) {
+        BenchmarkVertex &vertex =
+            vertices[((size_t)(kTerrainSize - 1) * j + i) * 6 + k];
+        vertex.x = (float)(i + cornerX[k]);
+        vertex.z = (float)(j + cornerZ[k]);
+        vertex.y = heights[(size_t)kTerrainSize * (j + cornerZ[k]) + i +
+                           cornerX[k]];
+        vertex.tu = vertex.tv = 0.0f;
+        vertex.nx = vertex.nz = 0.0f;
+        vertex.ny = 1.0f;
+      }
+    }
+  }
+  if (!tree.BuildTree(vertices.data(), (int)vertices.size())) {
+    return false;
+  }
+  std::vector<BenchmarkVertex>().swap(vertices);
+
+  buildMs = MeasureMilliseconds([&] {
+    field.Initialize(kTerrainSize, kTerrainSize, heights.data());
+  });
+
+  // Agents spread over the whole terrain.
+  for (int i = 0; i < kQueries; i++) {
+    positionsX[i] = fmodf(i * 0.6180339f * 97.0f, (float)(kTerrainSize - 1));
+    positionsZ[i] = fmodf(i * 0.4142135f * 89.0f, (float)(kTerrainSize - 1));
+  }
+
+  sum = 0.0;
+  treeMs = MeasureMilliseconds([&] {
+    for (int i = 0; i < kTreeQueries; i++) {
+      if (tree.GetHeightAtPosition(positionsX[i], positionsZ[i], height)) {
+        sum += height;
+      }
+    }
+  });
+  singleMs = MeasureMilliseconds([&] {
+    for (int i = 0; i < kQueries; i++) {
+      field.GetHeightAtPosition(positionsX[i], positionsZ[i], single[i]);
+    }
+  });
+  batchedMs = MeasureMilliseconds([&] {
+    field.GetHeights(positionsX.data(), positionsZ.data(), batched.data(),
+                     kQueries);
+  });
+
+  matches = true;
+  for (int i = 0; i < kQueries; i++) {
+    if (fabsf(single[i] - batched[i]) > 1e-3f) {
+      matches = false;
+    }
+  }
+
+  // Picking rays from above the terrain looking down at a slant.
+  hits = 0;
+  rayMs = MeasureMilliseconds([&] {
+    for (int i = 0; i < kRays; i++) {
+      const float angle = i * 2.399963f;
+      const float x = fmodf(i * 37.1f, (float)(kTerrainSize - 1));
+      const float z = fmodf(i * 53.3f, (float)(kTerrainSize - 1));
+      if (field.IntersectRay(x, SampleHeight(x, z) + 30.0f, z, cosf(angle),
+                             -0.15f, sinf(angle), 2000.0f, distance)) {
+        hits++;
+      }
+    }
+  });
+
+  printf("%dx%d height field, %d pyramid levels | build %.1f ms\n",
+         kTerrainSize, kTerrainSize, field.GetLevelCount(), buildMs);
+  printf("  ground clamps: quad tree %.1f ns (%d queries), single %.1f ns, "
+         "batched %.1f ns (%d queries)\n",
+         treeMs * 1e6 / kTreeQueries, kTreeQueries, singleMs * 1e6 / kQueries,
+         batchedMs * 1e6 / kQueries, kQueries);
+  printf("  %d rays: %.2f us per ray, %d hits\n", kRays,
+         rayMs * 1e3 / kRays, hits);
+
+  tree.Shutdown();
+  field.Shutdown();
+
+  if (!matches) {
+    printf("Batched heights differ from single queries\n");
+  }
+  return matches && sum != 0.0;
+}
@@ -0,0 +1,13 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: heightfieldbenchmarks.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _HEIGHTFIELDBENCHMARKS_H_
+#define _HEIGHTFIELDBENCHMARKS_H_
+
+// Headless ground clamp and ray cast timings on a 1025 x 1025 terrain:
+// prints the time per height query through the quad tree, through the
+// height field one at a time and batched, and per ray cast. Returns false
+// if the batched heights differ from the single ones.
+bool RunHeightFieldBenchmarks();
+
+#endif
@@ -0,0 +1,507 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: heightfieldclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "heightfieldclass.h"
+
+#include <emmintrin.h>
+#include <math.h>
+
+HeightFieldClass::HeightFieldClass() {
+  m_width = 0;
+  m_height = 0;
+}
+
+HeightFieldClass::HeightFieldClass(const HeightFieldClass &other) {}
+
+HeightFieldClass::~HeightFieldClass() {}
+
+bool HeightFieldClass::Initialize(int width, int height,
+                                  const float *heights) {
+  // A height field needs at least one cell.
+  if (width < 2 || height < 2 || !heights) {
+    return false;
+  }
+
+  // Store a copy of the heights, row by row along x.
+  m_width = width;
+  m_height = height;
+  m_heights.assign(heights, heights + (size_t)width * height);
+
+  // Build the min/max pyramid the ray queries walk down.
+  BuildPyramid();
+
+  return true;
+}
+
+void HeightFieldClass::Shutdown() {
+  // Release the heights and the pyramid.
+  m_heights.clear();
+  m_levels.clear();
+  m_stack.clear();
+  m_width = 0;
+  m_height = 0;
+
+  return;
+}
+
+int HeightFieldClass::GetWidth() { return m_width; }
+
+int HeightFieldClass::GetHeight() { return m_height; }
+
+int HeightFieldClass::GetLevelCount() { return (int)m_levels.size(); }
+
+bool HeightFieldClass::GetHeightAtPosition(float positionX, float positionZ,
+                                           float &height) {
+  // There is no height outside of the terrain.
+  if ((positionX < 0.0f) || (positionX > (float)(m_width - 1)) ||
+      (positionZ < 0.0f) || (positionZ > (float)(m_height - 1))) {
+    return false;
+  }
+
+  height = GetClampedHeight(positionX, positionZ);
+
+  return true;
+}
+
+bool HeightFieldClass::GetBilinearHeight(float positionX, float positionZ,
+                                         float &height) {
+  int cellX, cellZ;
+  float fractionX, fractionZ, height00, height10, height01, height11;
+  float bottom, top;
+  const float *row;
+
+  // There is no height outside of the terrain.
+  if ((positionX < 0.0f) || (positionX > (float)(m_width - 1)) ||
+      (positionZ < 0.0f) || (positionZ > (float)(m_height - 1))) {
+    return false;
+  }
+
+  // Find the cell, keeping the far edges in the last cell.
+  cellX = (int)positionX;
+  cellZ = (int)positionZ;
+  if (cellX > m_width - 2) {
+    cellX = m_width - 2;
+  }
+  if (cellZ > m_height - 2) {
+    cellZ = m_height - 2;
+  }
+  fractionX = positionX - (float)cellX;
+  fractionZ = positionZ - (float)cellZ;
+
+  // Blend the four corners of the cell.
+  row = &m_heights[(size_t)m_width * cellZ + cellX];
+  height00 = row[0];
+  height10 = row[1];
+  height01 = row[m_width];
+  height11 = row[m_width + 1];
+  bottom = height00 + (height10 - height00) * fractionX;
+  top = height01 + (height11 - height01) * fractionX;
+  height = bottom + (top - bottom) * fractionZ;
+
+  return true;
+}
+
+void HeightFieldClass::GetHeights(const float *positionsX,
+                                  const float *positionsZ, float *heights,
+                                  int count) {
+  __m128 zero, lastX, lastZ, lastCellX, lastCellZ;
+  __m128 x, z, cellX, cellZ, fractionX, fractionZ, upper;
+  __m128 height00, height10, height01, height11, upperHeight, lowerHeight;
+  int cellsX[4], cellsZ[4], i, lane;
+  float corners[4][4];
+  const float *row;
+
+  zero = _mm_setzero_ps();
+  lastX = _mm_set1_ps((float)(m_width - 1));
+  lastZ = _mm_set1_ps((float)(m_height - 1));
+  lastCellX = _mm_set1_ps((float)(m_width - 2));
+  lastCellZ = _mm_set1_ps((float)(m_height - 2));
+
+  // Sample four points at a time. Only the corner loads are done per point
+  // since SSE2 has no gather.
+  for (i = 0; i + 4 <= count; i += 4) {
+    // Clamp the points to the terrain.
+    x = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(positionsX + i), lastX), zero);
+    z = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(positionsZ + i), lastZ), zero);
+
+    // Find the cells, keeping the far edges in the last cell.
+    cellX = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(x)), lastCellX);
+    cellZ = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(z)), lastCellZ);
+    fractionX = _mm_sub_ps(x, cellX);
+    fractionZ = _mm_sub_ps(z, cellZ);
+    _mm_storeu_si128((__m128i *)cellsX, _mm_cvttps_epi32(cellX));
+    _mm_storeu_si128((__m128i *)cellsZ, _mm_cvttps_epi32(cellZ));
+
+    // Load the four corners of every cell.
+    for (lane = 0; lane < 4; lane++) {
+      row = &m_heights[(size_t)m_width * cellsZ[lane] + cellsX[lane]];
+      corners[0][lane] = row[0];
+      corners[1][lane] = row[1];
+      corners[2][lane] = row[m_width];
+      corners[3][lane] = row[m_width + 1];
+    }
+    height00 = _mm_loadu_ps(corners[0]);
+    height10 = _mm_loadu_ps(corners[1]);
+    height01 = _mm_loadu_ps(corners[2]);
+    height11 = _mm_loadu_ps(corners[3]);
+
+    // Work out both triangles of the cell and keep the one under the point.
+    upperHeight = _mm_add_ps(
+        height00,
+        _mm_add_ps(_mm_mul_ps(_mm_sub_ps(height11, height01), fractionX),
+                   _mm_mul_ps(_mm_sub_ps(height01, height00), fractionZ)));
+    lowerHeight = _mm_add_ps(
+        height00,
+        _mm_add_ps(_mm_mul_ps(_mm_sub_ps(height10, height00), fractionX),
+                   _mm_mul_ps(_mm_sub_ps(height11, height10), fractionZ)));
+    upper = _mm_cmple_ps(fractionX, fractionZ);
+    _mm_storeu_ps(heights + i,
+                  _mm_or_ps(_mm_and_ps(upper, upperHeight),
+                            _mm_andnot_ps(upper, lowerHeight)));
+  }
+
+  // Sample the points left over one at a time.
+  for (; i < count; i++) {
+    heights[i] = GetClampedHeight(positionsX[i], positionsZ[i]);
+  }
+
+  return;
+}
+
+bool HeightFieldClass::IntersectRay(float originX, float originY,
+                                    float originZ, float directionX,
+                                    float directionY, float directionZ,
+                                    float maxDistance, float &distance) {
+  float origin[3], direction[3], entry, hit;
+  int nearX, nearZ, i;
+  NodeType node, child;
+
+  origin[0] = originX;
+  origin[1] = originY;
+  origin[2] = originZ;
+  direction[0] = directionX;
+  direction[1] = directionY;
+  direction[2] = directionZ;
+
+  if (m_levels.empty()) {
+    return false;
+  }
+
+  // Start from the single block at the top of the pyramid.
+  node.level = (int)m_levels.size() - 1;
+  node.x = 0;
+  node.z = 0;
+  m_stack.clear();
+  m_stack.push_back(node);
+
+  // The children a ray passes through are visited in the order it reaches
+  // them, so the first triangle it hits is the nearest one.
+  nearX = (directionX >= 0.0f) ? 0 : 1;
+  nearZ = (directionZ >= 0.0f) ? 0 : 1;
+  while (!m_stack.empty()) {
+    node = m_stack.back();
+    m_stack.pop_back();
+
+    // Skip blocks whose height range the ray misses.
+    if (!IntersectBox(node, origin, direction, maxDistance, entry)) {
+      continue;
+    }
+
+    // At the bottom of the pyramid test the triangles of the cell.
+    if (node.level == 0) {
+      if (IntersectCell(node.x, node.z, origin, direction, maxDistance,
+                        hit)) {
+        distance = hit;
+        return true;
+      }
+      continue;
+    }
+
+    // Push the far child first so the near child is visited first.
+    child.level = node.level - 1;
+    for (i = 3; i >= 0; i--) {
+      child.x = node.x * 2 + ((i & 1) ^ nearX);
+      child.z = node.z * 2 + (((i >> 1) & 1) ^ nearZ);
+      if (child.x < m_levels[child.level].width &&
+          child.z < m_levels[child.level].height) {
+        m_stack.push_back(child);
+      }
+    }
+  }
+
+  return false;
+}
+
+void HeightFieldClass::BuildPyramid() {
+  int level, i, j, x, z, index;
+  float low, high, value;
+  const float *row;
+
+  m_levels.clear();
+
+  // The bottom level holds the range of the four corners of every cell.
+  m_levels.push_back(LevelType());
+  m_levels[0].width = m_width - 1;
+  m_levels[0].height = m_height - 1;
+  m_levels[0].minHeights.resize((size_t)(m_width - 1) * (m_height - 1));
+  m_levels[0].maxHeights.resize((size_t)(m_width - 1) * (m_height - 1));
+  for (j = 0; j < m_height - 1; j++) {
+    for (i = 0; i < m_width - 1; i++) {
+      row = &m_heights[(size_t)m_width * j + i];
+      low = high = row[0];
+      if (row[1] < low) {
+        low = row[1];
+      }
+      if (row[1] > high) {
+        high = row[1];
+      }
+      if (row[m_width] < low) {
+        low = row[m_width];
+      }
+      if (row[m_width] > high) {
+        high = row[m_width];
+      }
+      if (row[m_width + 1] < low) {
+        low = row[m_width + 1];
+      }
+      if (row[m_width + 1] > high) {
+        high = row[m_width + 1];
+      }
+      index = (m_width - 1) * j + i;
+      m_levels[0].minHeights[index] = low;
+      m_levels[0].maxHeights[index] = high;
+    }
+  }
+
+  // Every level above holds the range of two by two blocks of the one
+  // below, until a single block covers the whole terrain.
+  level = 0;
+  while (m_levels[level].width > 1 || m_levels[level].height > 1) {
+    LevelType next;
+    const LevelType &below = m_levels[level];
+
+    next.width = (below.width + 1) / 2;
+    next.height = (below.height + 1) / 2;
+    next.minHeights.resize((size_t)next.width * next.height);
+    next.maxHeights.resize((size_t)next.width * next.height);
+    for (j = 0; j < next.height; j++) {
+      for (i = 0; i < next.width; i++) {
+        low = below.minHeights[(size_t)below.width * (j * 2) + i * 2];
+        high = below.maxHeights[(size_t)below.width * (j * 2) + i * 2];
+        for (z = j * 2; z < j * 2 + 2 && z < below.height; z++) {
+          for (x = i * 2; x < i * 2 + 2 && x < below.width; x++) {
+            value = below.minHeights[(size_t)below.width * z + x];
+            if (value < low) {
+              low = value;
+            }
+            value = below.maxHeights[(size_t)below.width * z + x];
+            if (value > high) {
+              high = value;
+            }
+          }
+        }
+        next.minHeights[(size_t)next.width * j + i] = low;
+        next.maxHeights[(size_t)next.width * j + i] = high;
+      }
+    }
+
+    m_levels.push_back(next);
+    level++;
+  }
+
+  return;
+}
+
+float HeightFieldClass::GetClampedHeight(float positionX, float positionZ) {
+  int cellX, cellZ;
+  float fractionX, fractionZ, height00, height10, height01, height11;
+  const float *row;
+
+  // Clamp the position to the terrain.
+  if (positionX < 0.0f) {
+    positionX = 0.0f;
+  }
+  if (positionX > (float)(m_width - 1)) {
+    positionX = (float)(m_width - 1);
+  }
+  if (positionZ < 0.0f) {
+    positionZ = 0.0f;
+  }
+  if (positionZ > (float)(m_height - 1)) {
+    positionZ = (float)(m_height - 1);
+  }
+
+  // Find the cell, keeping the far edges in the last cell.
+  cellX = (int)positionX;
+  cellZ = (int)positionZ;
+  if (cellX > m_width - 2) {
+    cellX = m_width - 2;
+  }
+  if (cellZ > m_height - 2) {
+    cellZ = m_height - 2;
+  }
+  fractionX = positionX - (float)cellX;
+  fractionZ = positionZ - (float)cellZ;
+
+  row = &m_heights[(size_t)m_width * cellZ + cellX];
+  height00 = row[0];
+  height10 = row[1];
+  height01 = row[m_width];
+  height11 = row[m_width + 1];
+
+  // The upper left triangle of the cell lies above the diagonal, the bottom
+  // right one below it.
+  if (fractionX <= fractionZ) {
+    return height00 + (height11 - height01) * fractionX +
+           (height01 - height00) * fractionZ;
+  }
+
+  return height00 + (height10 - height00) * fractionX +
+         (height11 - height10) * fractionZ;
+}
+
+bool HeightFieldClass::IntersectBox(const NodeType &node,
+                                    const float origin[3],
+                                    const float direction[3],
+                                    float maxDistance, float &entry) {
+  const LevelType &level = m_levels[node.level];
+  float low[3], high[3], nearDistance, farDistance, t1, t2, swap;
+  int axis;
+
+  // The block covers 2^level cells along x and z, cut off at the terrain
+  // edge, and the range of heights in them.
+  low[0] = (float)(node.x << node.level);
+  high[0] = (float)((node.x + 1) << node.level);
+  if (high[0] > (float)(m_width - 1)) {
+    high[0] = (float)(m_width - 1);
+  }
+  low[2] = (float)(node.z << node.level);
+  high[2] = (float)((node.z + 1) << node.level);
+  if (high[2] > (float)(m_height - 1)) {
+    high[2] = (float)(m_height - 1);
+  }
+  low[1] = level.minHeights[(size_t)level.width * node.z + node.x];
+  high[1] = level.maxHeights[(size_t)level.width * node.z + node.x];
+
+  // Clip the ray against the three pairs of planes.
+  nearDistance = 0.0f;
+  farDistance = maxDistance;
+  for (axis = 0; axis < 3; axis++) {
+    if (fabsf(direction[axis]) < 1e-12f) {
+      if (origin[axis] < low[axis] || origin[axis] > high[axis]) {
+        return false;
+      }
+      continue;
+    }
+
+    t1 = (low[axis] - origin[axis]) / direction[axis];
+    t2 = (high[axis] - origin[axis]) / direction[axis];
+    if (t1 > t2) {
+      swap = t1;
+      t1 = t2;
+      t2 = swap;
+    }
+    if (t1 > nearDistance) {
+      nearDistance = t1;
+    }
+    if (t2 < farDistance) {
+      farDistance = t2;
+    }
+    if (nearDistance > farDistance) {
+      return false;
+    }
+  }
+
+  entry = nearDistance;
+
+  return true;
+}
+
+bool HeightFieldClass::IntersectCell(int cellX, int cellZ,
+                                     const float origin[3],
+                                     const float direction[3],
+                                     float maxDistance, float &distance) {
+  float bottomLeft[3], bottomRight[3], upperLeft[3], upperRight[3], hit;
+  const float *row;
+  bool found;
+
+  row = &m_heights[(size_t)m_width * cellZ + cellX];
+  bottomLeft[0] = (float)cellX;
+  bottomLeft[1] = row[0];
+  bottomLeft[2] = (float)cellZ;
+  bottomRight[0] = (float)(cellX + 1);
+  bottomRight[1] = row[1];
+  bottomRight[2] = (float)cellZ;
+  upperLeft[0] = (float)cellX;
+  upperLeft[1] = row[m_width];
+  upperLeft[2] = (float)(cellZ + 1);
+  upperRight[0] = (float)(cellX + 1);
+  upperRight[1] = row[m_width + 1];
+  upperRight[2] = (float)(cellZ + 1);
+
+  // Test both triangles of the cell and keep the nearer hit.
+  found = false;
+  distance = maxDistance;
+  if (IntersectTriangle(origin, direction, upperLeft, upperRight, bottomLeft,
+                        hit) &&
+      hit <= distance) {
+    distance = hit;
+    found = true;
+  }
+  if (IntersectTriangle(origin, direction, bottomLeft, upperRight,
+                        bottomRight, hit) &&
+      hit <= distance) {
+    distance = hit;
+    found = true;
+  }
+
+  return found;
+}
+
+bool HeightFieldClass::IntersectTriangle(const float origin[3],
+                                         const float direction[3],
+                                         const float vertex1[3],
+                                         const float vertex2[3],
+                                         const float vertex3[3],
+                                         float &distance) {
+  float edge1[3], edge2[3], p[3], s[3], q[3], determinant, inverse, u, v;
+  const float tolerance = 1e-6f;
+
+  // Moller-Trumbore, hitting the triangle from either side.
+  edge1[0] = vertex2[0] - vertex1[0];
+  edge1[1] = vertex2[1] - vertex1[1];
+  edge1[2] = vertex2[2] - vertex1[2];
+  edge2[0] = vertex3[0] - vertex1[0];
+  edge2[1] = vertex3[1] - vertex1[1];
+  edge2[2] = vertex3[2] - vertex1[2];
+
+  p[0] = direction[1] * edge2[2] - direction[2] * edge2[1];
+  p[1] = direction[2] * edge2[0] - direction[0] * edge2[2];
+  p[2] = direction[0] * edge2[1] - direction[1] * edge2[0];
+  determinant = edge1[0] * p[0] + edge1[1] * p[1] + edge1[2] * p[2];
+  if (fabsf(determinant) < 1e-12f) {
+    return false;
+  }
+  inverse = 1.0f / determinant;
+
+  s[0] = origin[0] - vertex1[0];
+  s[1] = origin[1] - vertex1[1];
+  s[2] = origin[2] - vertex1[2];
+  u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse;
+  if (u < -tolerance || u > 1.0f + tolerance) {
+    return false;
+  }
+
+  q[0] = s[1] * edge1[2] - s[2] * edge1[1];
+  q[1] = s[2] * edge1[0] - s[0] * edge1[2];
+  q[2] = s[0] * edge1[1] - s[1] * edge1[0];
+  v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) *
+      inverse;
+  if (v < -tolerance || u + v > 1.0f + tolerance) {
+    return false;
+  }
+
+  distance = (edge2[0] * q[0] + edge2[1] * q[1] + edge2[2] * q[2]) * inverse;
+
+  return distance >= 0.0f;
+}
@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: heightfieldclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _HEIGHTFIELDCLASS_H_
+#define _HEIGHTFIELDCLASS_H_
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: HeightFieldClass
+//
+// Height and ray queries straight on the terrain's height grid, where point
+// (i, j) of the grid sits at x = i, z = j. Heights come from the two
+// triangles of the grid cell under the point, split from its bottom left to
+// its upper right corner like TerrainClass builds them, so they match the
+// rendered mesh, or from a bilinear blend of the four corners. Batches of
+// points are clamped to the terrain and sampled four at a time with SSE2.
+//
+// Rays walk a pyramid of the lowest and highest height of every 2^k by 2^k
+// block of cells, front to back, and only test the triangles of the cells
+// whose height range the ray passes through.
+////////////////////////////////////////////////////////////////////////////////
+class HeightFieldClass {
+private:
+  struct LevelType {
+    int width, height;
+    std::vector<float> minHeights, maxHeights;
+  };
+
+  struct NodeType {
+    int level, x, z;
+  };
+
+public:
+  HeightFieldClass();
+  HeightFieldClass(const HeightFieldClass &);
+  ~HeightFieldClass();
+
+  bool Initialize(int, int, const float *);
+  void Shutdown();
+
+  int GetWidth();
+  int GetHeight();
+  int GetLevelCount();
+
+  bool GetHeightAtPosition(float, float, float &);
+  bool GetBilinearHeight(float, float, float &);
+  void GetHeights(const float *, const float *, float *, int);
+
+  bool IntersectRay(float, float, float, float, float, float, float, float &);
+
+private:
+  void BuildPyramid();
+  float GetClampedHeight(float, float);
+  bool IntersectBox(const NodeType &, const float[3], const float[3], float,
+                    float &);
+  bool IntersectCell(int, int, const float[3], const float[3], float,
+                     float &);
+  bool IntersectTriangle(const float[3], const float[3], const float[3],
+                         const float[3], const float[3], float &);
+
+private:
+  int m_width, m_height;
+  std::vector<float> m_heights;
+  std::vector<LevelType> m_levels;
+  std::vector<NodeType> m_stack;
+};
+
+#endif
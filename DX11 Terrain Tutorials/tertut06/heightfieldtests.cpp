@@ -0,0 +1,323 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: heightfieldtests.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "heightfieldtests.h"
+
+#include "heightfieldclass.h"
+#include "quadtreeclass.h"
+
+#include <windows.h>
+
+#include <exception>
+#include <math.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+// Same layout as the vertices TerrainClass hands to the quad tree.
+struct TestVertex {
+  float x, y, z;
+  float tu, tv;
+  float nx, ny, nz;
+};
+
+// Hills with some sharp ridges, heights row by row along x.
+std::vector<float> MakeHeights(int width, int height) {
+  std::vector<float> heights((size_t)width * height);
+  for (int z = 0; z < height; z++) {
+    for (int x = 0; x < width; x++) {
+      heights[(size_t)width * z + x] =
+          6.0f * sinf(x * 0.07f) * cosf(z * 0.045f) +
+          2.0f * fabsf(sinf((x - z) * 0.21f)) + 0.5f * sinf(x * 1.3f + z);
+    }
+  }
+  return heights;
+}
+
+// Six vertices per quad in the order TerrainClass writes them.
+std::vector<TestVertex> MakeMesh(const std::vector<float> &heights, int width,
+                                 int height) {
+  const int cornerX[6] = {0, 1, 0, 0, 1, 1};
+  const int cornerZ[6] = {1, 1, 0, 0, 1, 0};
+  std::vector<TestVertex> vertices;
+
+  for (int j = 0; j < height - 1; j++) {
+    for (int i = 0; i < width - 1; i++) {
+      for (int k = 0; k < 6; k++) {
+        TestVertex vertex = {};
+        vertex.x = (float)(i + cornerX[k]);
+        vertex.z = (float)(j + cornerZ[k]);
+        vertex.y = heights[(size_t)width * (j + cornerZ[k]) + i + cornerX[k]];
+        vertex.ny = 1.0f;
+        vertices.push_back(vertex);
+      }
+    }
+  }
+  return vertices;
+}
+
+// Reference ray cast: the nearest hit over both triangles of every cell.
+bool IntersectAllCells(const std::vector<float> &heights, int width,
+                       int height, const float origin[3],
+                       const float direction[3], float maxDistance,
+                       float &distance) {
+  bool found = false;
+  distance = maxDistance;
+  for (int j = 0; j < height - 1; j++) {
+    for (int i = 0; i < width - 1; i++) {
+      const float corners[4][3] = {
+          {(float)i, heights[(size_t)width * (j + 1) + i], (float)(j + 1)},
+          {(float)(i + 1), heights[(size_t)width * (j + 1) + i + 1],
+           (float)(j + 1)},
+          {(float)i, heights[(size_t)width * j + i], (float)j},
+          {(float)(i + 1), heights[(size_t)width * j + i + 1], (float)j}};
+      const int triangles[2][3] = {{0, 1, 2}, {2, 1, 3}};
+      for (int t = 0; t < 2; t++) {
+        const float *v0 = corners[triangles[t][0]];
+        const float *v1 = corners[triangles[t][1]];
+        const float *v2 = corners[triangles[t][2]];
+        const double e1[3] = {v1[0] - v0[0], v1[1] - v0[1], v1[2] - v0[2]};
+        const double e2[3] = {v2[0] - v0[0], v2[1] - v0[1], v2[2] - v0[2]};
+        const double p[3] = {direction[1] * e2[2] - direction[2] * e2[1],
+                             direction[2] * e2[0] - direction[0] * e2[2],
+                             direction[0] * e2[1] - direction[1] * e2[0]};
+        const double det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+        if (fabs(det) < 1e-12) {
+          continue;
+        }
+        const double s[3] = {origin[0] - v0[0], origin[1] - v0[1],
+                             origin[2] - v0[2]};
+        const double u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) / det;
+        const double q[3] = {s[1] * e1[2] - s[2] * e1[1],
+                             s[2] * e1[0] - s[0] * e1[2],
+                             s[0] * e1[1] - s[1] * e1[0]};
+        const double v = (direction[0] * q[0] + direction[1] * q[1] +
+                          direction[2] * q[2]) /
+                         det;
+        const double hit = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) / det;
+        if (u >= 0.0 && v >= 0.0 && u + v <= 1.0 && hit >= 0.0 &&
+            hit <= distance) {
+          distance = (float)hit;
+          found = true;
+        }
+      }
+    }
+  }
+  return found;
+}
+
+bool TestHeightsMatchQuadTree(std::string &message) {
+  const int width = 160;
+  const int height = 120;
+  std::vector<float> heights = MakeHeights(width, height);
+  std::vector<TestVertex> vertices = MakeMesh(heights, width, height);
+  HeightFieldClass field;
+  QuadTreeClass tree;
+  float x, z, expected, actual;
+
+  if (!field.Initialize(width, height, heights.data()) ||
+      !tree.BuildTree(vertices.data(), (int)vertices.size())) {
+    message = "initialize failed";
+    return false;
+  }
+
+  for (int i = 0; i < 2000; i++) {
+    x = fmodf(i * 13.37f, (float)(width - 1));
+    z = fmodf(i * 5.91f, (float)(height - 1));
+    if (!tree.GetHeightAtPosition(x, z, expected)) {
+      continue;
+    }
+    if (!field.GetHeightAtPosition(x, z, actual) ||
+        fabsf(actual - expected) > 1e-3f) {
+      message = "height differs from the quad tree at " + std::to_string(x) +
+                ", " + std::to_string(z);
+      return false;
+    }
+  }
+
+  // Grid points and the far corner are on the terrain, points past it not.
+  if (!field.GetHeightAtPosition((float)(width - 1), (float)(height - 1),
+                                 actual) ||
+      actual != heights.back() ||
+      !field.GetHeightAtPosition(7.0f, 9.0f, actual) ||
+      actual != heights[(size_t)width * 9 + 7]) {
+    message = "grid point height is not exact";
+    return false;
+  }
+  if (field.GetHeightAtPosition(-0.5f, 3.0f, actual) ||
+      field.GetHeightAtPosition(3.0f, (float)height, actual) ||
+      field.GetBilinearHeight((float)width, 3.0f, actual)) {
+    message = "height found outside the terrain";
+    return false;
+  }
+
+  // Bilinear heights agree with the triangles at the grid points and the
+  // cell edges.
+  if (!field.GetBilinearHeight(10.0f, 20.5f, actual) ||
+      !field.GetHeightAtPosition(10.0f, 20.5f, expected) ||
+      fabsf(actual - expected) > 1e-4f) {
+    message = "bilinear height differs on a cell edge";
+    return false;
+  }
+  return true;
+}
+
+bool TestBatchedHeights(std::string &message) {
+  const int width = 97;
+  const int height = 65;
+  const int count = 1003;
+  std::vector<float> heights = MakeHeights(width, height);
+  std::vector<float> positionsX(count), positionsZ(count), batched(count);
+  HeightFieldClass field;
+  float expected, x, z;
+
+  if (!field.Initialize(width, height, heights.data())) {
+    message = "initialize failed";
+    return false;
+  }
+
+  // Include points off every side of the terrain and a count that does not
+  // fill the last group of four.
+  for (int i = 0; i < count; i++) {
+    positionsX[i] = -10.0f + fmodf(i * 7.13f, (float)(width + 20));
+    positionsZ[i] = -10.0f + fmodf(i * 3.37f, (float)(height + 20));
+  }
+  field.GetHeights(positionsX.data(), positionsZ.data(), batched.data(),
+                   count);
+
+  for (int i = 0; i < count; i++) {
+    x = positionsX[i] < 0.0f ? 0.0f : positionsX[i];
+    x = x > (float)(width - 1) ? (float)(width - 1) : x;
+    z = positionsZ[i] < 0.0f ? 0.0f : positionsZ[i];
+    z = z > (float)(height - 1) ? (float)(height - 1) : z;
+    if (!field.GetHeightAtPosition(x, z, expected) ||
+        fabsf(batched[i] - expected) > 1e-4f) {
+      message = "batched height " + std::to_string(i) +
+                " differs from the single query";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestRaysMatchEveryCell(std::string &message) {
+  const int width = 67;
+  const int height = 41;
+  std::vector<float> heights = MakeHeights(width, height);
+  HeightFieldClass field;
+  float origin[3], direction[3], expected, actual;
+  bool expectedHit, actualHit;
+  int hits;
+
+  if (!field.Initialize(width, height, heights.data())) {
+    message = "initialize failed";
+    return false;
+  }
+  if (field.GetLevelCount() != 8) {
+    message = "wrong number of pyramid levels";
+    return false;
+  }
+
+  // Rays from above and around the terrain in every direction, some
+  // grazing the hills and some starting past the edges.
+  hits = 0;
+  for (int i = 0; i < 600; i++) {
+    const float angle = i * 2.399963f;
+    const float pitch = -0.05f - 0.9f * fmodf(i * 0.618034f, 1.0f);
+    origin[0] = -20.0f + fmodf(i * 11.3f, (float)(width + 40));
+    origin[1] = 4.0f + fmodf(i * 3.7f, 20.0f);
+    origin[2] = -20.0f + fmodf(i * 17.9f, (float)(height + 40));
+    direction[0] = cosf(angle) * cosf(pitch);
+    direction[1] = sinf(pitch);
+    direction[2] = sinf(angle) * cosf(pitch);
+
+    expectedHit = IntersectAllCells(heights, width, height, origin,
+                                    direction, 200.0f, expected);
+    actualHit = field.IntersectRay(origin[0], origin[1], origin[2],
+                                   direction[0], direction[1], direction[2],
+                                   200.0f, actual);
+    if (expectedHit != actualHit ||
+        (expectedHit && fabsf(expected - actual) > 1e-3f)) {
+      message = "ray " + std::to_string(i) + " differs from every cell test";
+      return false;
+    }
+    hits += actualHit ? 1 : 0;
+  }
+  if (hits < 100 || hits > 550) {
+    message = "rays do not mix hits and misses";
+    return false;
+  }
+
+  // Straight down onto a grid point, straight up and too short.
+  if (!field.IntersectRay(12.0f, 50.0f, 30.0f, 0.0f, -1.0f, 0.0f, 100.0f,
+                          actual) ||
+      fabsf(actual - (50.0f - heights[(size_t)width * 30 + 12])) > 1e-4f) {
+    message = "vertical ray missed the grid point";
+    return false;
+  }
+  if (field.IntersectRay(12.0f, 50.0f, 30.0f, 0.0f, 1.0f, 0.0f, 100.0f,
+                         actual) ||
+      field.IntersectRay(12.0f, 50.0f, 30.0f, 0.0f, -1.0f, 0.0f, 5.0f,
+                         actual)) {
+    message = "ray hit past its end";
+    return false;
+  }
+  return true;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(3);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("Heights match the quad tree", TestHeightsMatchQuadTree);
+  run("Batched heights", TestBatchedHeights);
+  run("Rays match every cell", TestRaysMatchEveryCell);
+
+  return results;
+}
+
+} // namespace
+
+bool RunHeightFieldTests() {
+  const std::vector<TestCaseResult> results = RunAllTestsInternal();
+  bool allPassed = true;
+  std::string line;
+
+  for (const TestCaseResult &result : results) {
+    if (!result.passed) {
+      allPassed = false;
+      line = "HeightFieldTests: Test failed: " + result.name;
+      if (!result.message.empty()) {
+        line += " - " + result.message;
+      }
+      line += "\n";
+      OutputDebugStringA(line.c_str());
+    }
+  }
+
+  return allPassed;
+}
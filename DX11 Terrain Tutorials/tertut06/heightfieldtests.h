@@ -0,0 +1,13 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: heightfieldtests.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _HEIGHTFIELDTESTS_H_
+#define _HEIGHTFIELDTESTS_H_
+
+// Headless tests of HeightFieldClass: heights against the quad tree's
+// triangle search, batched against single queries, and ray casts against a
+// test of every cell. Failures are written to the debugger output. Returns
+// false if any test fails.
+bool RunHeightFieldTests();
+
+#endif
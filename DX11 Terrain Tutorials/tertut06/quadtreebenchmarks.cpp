@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: quadtreebenchmarks.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "quadtreebenchmarks.h"
+
+#include "frustumclass.h"
+#include "quadtreeclass.h"
+
+#include <chrono>
+#include <math.h>
+#include <new>
+#include <stdio.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int kTerrainSizes[] = {1025, 2049, 4097, 8193};
+const int kFrames = 500;
+const float kScreenDepth = 1000.0f;
+
+// Same layout as the vertices TerrainClass hands to the quad tree.
+struct BenchmarkVertex {
+  float x, y, z;
+  float tu, tv;
+  float nx, ny, nz;
+};
+
+template <typename Func> double MeasureMilliseconds(Func &&func) {
+  const auto start = Clock::now();
+  func();
+  const auto end = Clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+float SampleHeight(float x, float z) {
+  return 20.0f * sinf(x * 0.01f) * cosf(z * 0.013f) +
+         4.0f * sinf((x + z) * 0.07f);
+}
+
+// Six vertices per quad in the order TerrainClass writes them.
+void MakeTerrain(int size, std::vector<BenchmarkVertex> &vertices) {
+  const int cornerX[6] = {0, 1, 0, 0, 1, 1};
+  const int cornerZ[6] = {1, 1, 0, 0, 1, 0};
+  size_t index = 0;
+
+  vertices.resize((size_t)(size - 1) * (size - 1) * 6);
+  for (int j = 0; j < size - 1; j++) {
+    for (int i = 0; i < size - 1; i++) {
+      for (int k = 0; k < 6; k++) {
+        BenchmarkVertex &vertex = vertices[index++];
+        vertex.x = (float)(i + cornerX[k]);
+        vertex.z = (float)(j + cornerZ[k]);
+        vertex.y = SampleHeight(vertex.x, vertex.z);
+        vertex.tu = (float)((i % 8) + cornerX[k]) / 8.0f;
+        vertex.tv = 1.0f - (float)((j % 8) + cornerZ[k]) / 8.0f;
+        vertex.nx = 0.0f;
+        vertex.ny = 1.0f;
+        vertex.nz = 0.0f;
+      }
+    }
+  }
+}
+
+bool RunSize(int size) {
+  std::vector<BenchmarkVertex> vertices;
+  QuadTreeClass tree;
+  FrustumClass frustum;
+  XMMATRIX projection, view;
+  double buildMs, cullMs, batches, triangles;
+  bool result;
+
+  try {
+    MakeTerrain(size, vertices);
+  } catch (const std::bad_alloc &) {
+    printf("%dx%d terrain: skipped, not enough memory\n", size, size);
+    return true;
+  }
+
+  try {
+    buildMs = MeasureMilliseconds([&] {
+      result = tree.BuildTree(vertices.data(), (int)vertices.size());
+    });
+  } catch (const std::bad_alloc &) {
+    printf("%dx%d terrain: skipped, not enough memory\n", size, size);
+    return true;
+  }
+  if (!result) {
+    printf("%dx%d terrain: build failed\n", size, size);
+    return false;
+  }
+
+  // Circle the middle of the terrain looking outwards, as the tutorial's
+  // camera would walking over it.
+  projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f,
+                                        kScreenDepth);
+  cullMs = 0.0;
+  batches = 0.0;
+  triangles = 0.0;
+  for (int frame = 0; frame < kFrames; frame++) {
+    const float t = 6.2831853f * (float)frame / (float)kFrames;
+    const float x = size * 0.5f + size * 0.2f * cosf(t);
+    const float z = size * 0.5f + size * 0.2f * sinf(t);
+    const float y = SampleHeight(x, z) + 10.0f;
+    view = XMMatrixLookAtLH(
+        XMVectorSet(x, y, z, 1.0f),
+        XMVectorSet(x + cosf(t), y - 0.1f, z + sinf(t), 1.0f),
+        XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    frustum.ConstructFrustum(kScreenDepth, projection, view);
+
+    cullMs += MeasureMilliseconds([&] { tree.CullTree(&frustum); });
+    batches += tree.GetBatchCount();
+    triangles += tree.GetDrawCount();
+  }
+
+  printf("%dx%d terrain: build %.1f ms | %d nodes, %d leaves\n", size, size,
+         buildMs, tree.GetNodeCount(), tree.GetLeafCount());
+  printf("  %d vertices pooled from %d (%.1f%%)\n",
+         tree.GetPooledVertexCount(), (int)vertices.size(),
+         100.0 * tree.GetPooledVertexCount() / vertices.size());
+  printf("  %d frames: cull %.4f ms, %.1f draw calls, %.0f triangles per "
+         "frame\n",
+         kFrames, cullMs / kFrames, batches / kFrames, triangles / kFrames);
+
+  tree.Shutdown();
+  return true;
+}
+
+} // namespace
+
+bool RunQuadTreeBenchmarks() {
+  bool result = true;
+
+  printf("=== Quad tree build and culling benchmark ===\n");
+
+  for (int size : kTerrainSizes) {
+    result = RunSize(size) && result;
+  }
+
+  return result;
+}
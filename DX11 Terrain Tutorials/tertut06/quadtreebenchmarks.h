@@ -0,0 +1,13 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: quadtreebenchmarks.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _QUADTREEBENCHMARKS_H_
+#define _QUADTREEBENCHMARKS_H_
+
+// Headless quad tree build and culling over 1025 to 8193 square terrains:
+// prints the build time, the tree and pool sizes, and the time and draw
+// calls per frame of a circling camera. Sizes that do not fit in memory are
+// skipped. Returns false if a build fails.
+bool RunQuadTreeBenchmarks();
+
+#endif
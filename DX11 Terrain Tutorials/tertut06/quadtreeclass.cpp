@@ -1,11 +1,30 @@
 ////////////////////////////////////////////////////////////////////////////////
-// Filename: quadtreeclass.h
+// Filename: quadtreeclass.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "quadtreeclass.h"
 
+#include <string.h>
+
+namespace {
+
+// Spreads the low 16 bits of value over the even bits, for Morton codes.
+unsigned int SpreadBits(unsigned int value) {
+  value &= 0x0000ffff;
+  value = (value | (value << 8)) & 0x00ff00ff;
+  value = (value | (value << 4)) & 0x0f0f0f0f;
+  value = (value | (value << 2)) & 0x33333333;
+  value = (value | (value << 1)) & 0x55555555;
+  return value;
+}
+
+} // namespace
+
 QuadTreeClass::QuadTreeClass() {
-  m_vertexList = 0;
-  m_parentNode = 0;
+  m_triangleCount = 0;
+  m_drawCount = 0;
+  m_leafCount = 0;
+  m_vertexBuffer = 0;
+  m_indexBuffer = 0;
 }
 
 QuadTreeClass::QuadTreeClass(const QuadTreeClass &other) {}
@@ -14,53 +33,53 @@ QuadTreeClass::~QuadTreeClass() {}
 
 bool QuadTreeClass::Initialize(TerrainClass *terrain, ID3D11Device *device) {
   int vertexCount;
-  float centerX, centerZ, width;
+  VertexType *vertexList;
+  bool result;
 
   // Get the number of vertices in the terrain vertex array.
   vertexCount = terrain->GetVertexCount();
 
-  // Store the total triangle count for the vertex list.
-  m_triangleCount = vertexCount / 3;
-
   // Create a vertex array to hold all of the terrain vertices.
-  m_vertexList = new VertexType[vertexCount];
-  if (!m_vertexList) {
+  vertexList = new VertexType[vertexCount];
+  if (!vertexList) {
     return false;
   }
 
   // Copy the terrain vertices into the vertex list.
-  terrain->CopyVertexArray((void *)m_vertexList);
+  terrain->CopyVertexArray((void *)vertexList);
 
-  // Calculate the center x,z and the width of the mesh.
-  CalculateMeshDimensions(vertexCount, centerX, centerZ, width);
+  // Build the quad tree and its pooled geometry from the vertex list.
+  result = BuildTree(vertexList, vertexCount);
+
+  // Release the vertex list since the quad tree now has its own copy of the
+  // vertices.
+  delete[] vertexList;
+  vertexList = 0;
 
-  // Create the parent node for the quad tree.
-  m_parentNode = new NodeType;
-  if (!m_parentNode) {
+  if (!result) {
     return false;
   }
 
-  // Recursively build the quad tree based on the vertex list data and mesh
-  // dimensions.
-  CreateTreeNode(m_parentNode, centerX, centerZ, width, device);
-
-  // Release the vertex list since the quad tree now has the vertices in each
-  // node.
-  if (m_vertexList) {
-    delete[] m_vertexList;
-    m_vertexList = 0;
+  // Create the vertex and index buffers shared by all the nodes.
+  result = InitializeBuffers(device);
+  if (!result) {
+    return false;
   }
 
   return true;
 }
 
 void QuadTreeClass::Shutdown() {
-  // Recursively release the quad tree data.
-  if (m_parentNode) {
-    ReleaseNode(m_parentNode);
-    delete m_parentNode;
-    m_parentNode = 0;
-  }
+  // Release the shared vertex and index buffers.
+  ShutdownBuffers();
+
+  // Release the quad tree data.
+  m_nodes.clear();
+  m_vertices.clear();
+  m_indices.clear();
+  m_positions.clear();
+  m_batches.clear();
+  m_stack.clear();
 
   return;
 }
@@ -68,19 +87,162 @@ void QuadTreeClass::Shutdown() {
 void QuadTreeClass::Render(FrustumClass *frustum,
                            ID3D11DeviceContext *deviceContext,
                            TerrainShaderClass *shader) {
+  unsigned int stride, offset;
+  int i;
+
+  // Find the visible parts of the tree as ranges of the shared index buffer.
+  CullTree(frustum);
+
+  // Set vertex buffer stride and offset.
+  stride = sizeof(VertexType);
+  offset = 0;
+
+  // Set the shared vertex and index buffers to active in the input assembler
+  // once for all the nodes.
+  deviceContext->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
+  deviceContext->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+
+  // Set the type of primitive that should be rendered from this vertex buffer,
+  // in this case triangles.
+  deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+  // Draw each batch of visible triangles with the terrain shader.
+  for (i = 0; i < (int)m_batches.size(); i++) {
+    shader->RenderShader(deviceContext, m_batches[i].indexCount,
+                         m_batches[i].startIndex);
+  }
+
+  return;
+}
+
+int QuadTreeClass::GetDrawCount() { return m_drawCount; }
+
+int QuadTreeClass::GetBatchCount() { return (int)m_batches.size(); }
+
+bool QuadTreeClass::BuildTree(void *vertexList, int vertexCount) {
+  const VertexType *vertices;
+  std::vector<int> cellStart, order;
+  float centerX, centerZ, width;
+  int depth;
+
+  vertices = (const VertexType *)vertexList;
+
+  // Store the total triangle count for the vertex list.
+  m_triangleCount = vertexCount / 3;
+  if (m_triangleCount < 1) {
+    return false;
+  }
+
+  // Calculate the center x,z and the width of the mesh.
+  CalculateMeshDimensions(vertices, vertexCount, centerX, centerZ, width);
+
+  // Sort the triangles into grid cells in Morton order in one pass, so that
+  // every node of the tree covers a contiguous run of them.
+  depth = ChooseDepth(m_triangleCount);
+  BucketTriangles(vertices, m_triangleCount, centerX, centerZ, width, depth,
+                  cellStart, order);
+
+  // Split the nodes breadth first straight from the cell counts.
+  CreateNodes(cellStart, depth);
+
+  // Weld the vertices of each leaf into the shared vertex pool and fill in
+  // the shared index list.
+  PoolLeafVertices(vertices, order);
+
+  // Fit the node bounds to the triangles they hold.
+  CalculateNodeBounds();
+
+  return true;
+}
+
+void QuadTreeClass::CullTree(FrustumClass *frustum) {
+  int index, i;
+  float centerX, centerY, centerZ, sizeX, sizeY, sizeZ;
+
   // Reset the number of triangles that are drawn for this frame.
   m_drawCount = 0;
+  m_batches.clear();
+
+  // Walk the tree with an explicit stack. Children are pushed in reverse so
+  // they come off in Morton order, which keeps the batches in index order.
+  m_stack.clear();
+  if (!m_nodes.empty()) {
+    m_stack.push_back(0);
+  }
+  while (!m_stack.empty()) {
+    index = m_stack.back();
+    m_stack.pop_back();
+    const NodeType &node = m_nodes[index];
+
+    centerX = (node.minX + node.maxX) / 2.0f;
+    centerY = (node.minY + node.maxY) / 2.0f;
+    centerZ = (node.minZ + node.maxZ) / 2.0f;
+    sizeX = (node.maxX - node.minX) / 2.0f;
+    sizeY = (node.maxY - node.minY) / 2.0f;
+    sizeZ = (node.maxZ - node.minZ) / 2.0f;
+
+    // If the node can't be seen then none of its children can either so
+    // don't continue down the tree.
+    if (!frustum->CheckRectangle(centerX, centerY, centerZ, sizeX, sizeY,
+                                 sizeZ)) {
+      continue;
+    }
 
-  // Render each node that is visible starting at the parent node and moving
-  // down the tree.
-  RenderNode(m_parentNode, frustum, deviceContext, shader);
+    // A leaf, or a node that is entirely inside the frustum, is drawn as
+    // its whole range without testing anything below it.
+    if (node.childCount == 0 ||
+        frustum->CheckRectangleInside(centerX, centerY, centerZ, sizeX, sizeY,
+                                      sizeZ)) {
+      AddBatch(node);
+      continue;
+    }
+
+    for (i = node.childCount - 1; i >= 0; i--) {
+      m_stack.push_back(node.firstChild + i);
+    }
+  }
 
   return;
 }
 
-int QuadTreeClass::GetDrawCount() { return m_drawCount; }
+int QuadTreeClass::GetNodeCount() { return (int)m_nodes.size(); }
+
+int QuadTreeClass::GetLeafCount() { return m_leafCount; }
+
+int QuadTreeClass::GetPooledVertexCount() { return (int)m_positions.size(); }
+
+void QuadTreeClass::GetBatch(int index, int &startIndex, int &indexCount) {
+  startIndex = m_batches[index].startIndex;
+  indexCount = m_batches[index].indexCount;
+
+  return;
+}
+
+void QuadTreeClass::GetTriangle(int index, float vertex1[3],
+                                float vertex2[3], float vertex3[3]) {
+  const VectorType *position;
+
+  // Triangles are numbered in the order of the shared index buffer.
+  position = &m_positions[m_indices[(size_t)index * 3]];
+  vertex1[0] = position->x;
+  vertex1[1] = position->y;
+  vertex1[2] = position->z;
 
-void QuadTreeClass::CalculateMeshDimensions(int vertexCount, float &centerX,
+  position = &m_positions[m_indices[(size_t)index * 3 + 1]];
+  vertex2[0] = position->x;
+  vertex2[1] = position->y;
+  vertex2[2] = position->z;
+
+  position = &m_positions[m_indices[(size_t)index * 3 + 2]];
+  vertex3[0] = position->x;
+  vertex3[1] = position->y;
+  vertex3[2] = position->z;
+
+  return;
+}
+
+void QuadTreeClass::CalculateMeshDimensions(const VertexType *vertices,
+                                            int vertexCount, float &centerX,
                                             float &centerZ, float &meshWidth) {
   int i;
   float maxWidth, maxDepth, minWidth, minDepth, width, depth, maxX, maxZ;
@@ -91,8 +253,8 @@ void QuadTreeClass::CalculateMeshDimensions(int vertexCount, float &centerX,
 
   // Sum all the vertices in the mesh.
   for (i = 0; i < vertexCount; i++) {
-    centerX += m_vertexList[i].position.x;
-    centerZ += m_vertexList[i].position.z;
+    centerX += vertices[i].position.x;
+    centerZ += vertices[i].position.z;
   }
 
   // And then divide it by the number of vertices to find the mid-point of the
@@ -104,14 +266,14 @@ void QuadTreeClass::CalculateMeshDimensions(int vertexCount, float &centerX,
   maxWidth = 0.0f;
   maxDepth = 0.0f;
 
-  minWidth = fabsf(m_vertexList[0].position.x - centerX);
-  minDepth = fabsf(m_vertexList[0].position.z - centerZ);
+  minWidth = fabsf(vertices[0].position.x - centerX);
+  minDepth = fabsf(vertices[0].position.z - centerZ);
 
   // Go through all the vertices and find the maximum and minimum width and
   // depth of the mesh.
   for (i = 0; i < vertexCount; i++) {
-    width = fabsf(m_vertexList[i].position.x - centerX);
-    depth = fabsf(m_vertexList[i].position.z - centerZ);
+    width = fabsf(vertices[i].position.x - centerX);
+    depth = fabsf(vertices[i].position.z - centerZ);
 
     if (width > maxWidth) {
       maxWidth = width;
@@ -137,453 +299,383 @@ void QuadTreeClass::CalculateMeshDimensions(int vertexCount, float &centerX,
   return;
 }
 
-void QuadTreeClass::CreateTreeNode(NodeType *node, float positionX,
-                                   float positionZ, float width,
-                                   ID3D11Device *device) {
-  int numTriangles, i, count, vertexCount, index, vertexIndex;
-  float offsetX, offsetZ;
-  VertexType *vertices;
-  unsigned long *indices;
-  bool result;
-  D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
-  D3D11_SUBRESOURCE_DATA vertexData, indexData;
+int QuadTreeClass::ChooseDepth(int triangleCount) {
+  int depth;
+
+  // Use a grid fine enough that a cell holds an eighth of a leaf on
+  // average, so the nodes can still split where the triangles are denser.
+  depth = 0;
+  while (depth < QUAD_TREE_MAX_DEPTH &&
+         (double)triangleCount >
+             (double)(MAX_TRIANGLES / 8) * (double)(1 << (2 * depth))) {
+    depth++;
+  }
 
-  // Store the node position and size.
-  node->positionX = positionX;
-  node->positionZ = positionZ;
-  node->width = width;
+  return depth;
+}
 
-  // Initialize the triangle count to zero for the node.
-  node->triangleCount = 0;
+void QuadTreeClass::BucketTriangles(const VertexType *vertices,
+                                    int triangleCount, float centerX,
+                                    float centerZ, float width, int depth,
+                                    std::vector<int> &cellStart,
+                                    std::vector<int> &order) {
+  std::vector<unsigned int> codes;
+  int cellsPerSide, cellCount, i, cellX, cellZ;
+  float minX, minZ, scale, x, z;
+
+  cellsPerSide = 1 << depth;
+  cellCount = cellsPerSide * cellsPerSide;
+  minX = centerX - (width / 2.0f);
+  minZ = centerZ - (width / 2.0f);
+  scale = (float)cellsPerSide / width;
+
+  // Find the cell of every triangle from its center and count the triangles
+  // in each cell.
+  codes.resize(triangleCount);
+  cellStart.assign(cellCount + 1, 0);
+  for (i = 0; i < triangleCount; i++) {
+    x = (vertices[i * 3].position.x + vertices[i * 3 + 1].position.x +
+         vertices[i * 3 + 2].position.x) /
+        3.0f;
+    z = (vertices[i * 3].position.z + vertices[i * 3 + 1].position.z +
+         vertices[i * 3 + 2].position.z) /
+        3.0f;
+    cellX = (int)((x - minX) * scale);
+    cellZ = (int)((z - minZ) * scale);
+    cellX = min(max(cellX, 0), cellsPerSide - 1);
+    cellZ = min(max(cellZ, 0), cellsPerSide - 1);
+
+    // Morton order: x in the even bits and z in the odd bits, the same
+    // order the four children of a node are kept in.
+    codes[i] = SpreadBits(cellX) | (SpreadBits(cellZ) << 1);
+    cellStart[codes[i] + 1]++;
+  }
 
-  // Initialize the vertex and index buffer to null.
-  node->vertexBuffer = 0;
-  node->indexBuffer = 0;
+  // Turn the counts into the first triangle of each cell.
+  for (i = 0; i < cellCount; i++) {
+    cellStart[i + 1] += cellStart[i];
+  }
 
-  // Initialize the vertex array to null.
-  node->vertexArray = 0;
+  // Scatter the triangles into cell order, keeping their original order
+  // within a cell.
+  order.resize(triangleCount);
+  std::vector<int> next(cellStart.begin(), cellStart.end() - 1);
+  for (i = 0; i < triangleCount; i++) {
+    order[next[codes[i]]++] = i;
+  }
 
-  // Initialize the children nodes of this node to null.
-  node->nodes[0] = 0;
-  node->nodes[1] = 0;
-  node->nodes[2] = 0;
-  node->nodes[3] = 0;
+  return;
+}
 
-  // Count the number of triangles that are inside this node.
-  numTriangles = CountTriangles(positionX, positionZ, width);
+void QuadTreeClass::CreateNodes(const std::vector<int> &cellStart, int depth) {
+  std::vector<int> levels, codes;
+  NodeType node;
+  int i, child, shift, childCode, begin, end;
+
+  // The root covers every cell.
+  m_nodes.clear();
+  m_leafCount = 0;
+  node.firstChild = -1;
+  node.childCount = 0;
+  node.firstTriangle = 0;
+  node.triangleCount = cellStart.back();
+  m_nodes.push_back(node);
+  levels.push_back(0);
+  codes.push_back(0);
+
+  // The nodes are visited in the order they are added, which appends the
+  // children of each node next to each other in breadth-first order. A node
+  // at a level has a Morton code prefix, and its triangles are the cells
+  // that start with it.
+  for (i = 0; i < (int)m_nodes.size(); i++) {
+    // If this node has few enough triangles, or can't be split any further,
+    // then it is a leaf.
+    if (m_nodes[i].triangleCount <= MAX_TRIANGLES || levels[i] == depth) {
+      m_leafCount++;
+      continue;
+    }
 
-  // Case 1: If there are no triangles in this node then return as it is empty
-  // and requires no processing.
-  if (numTriangles == 0) {
-    return;
+    // Otherwise add the children that have triangles in them.
+    m_nodes[i].firstChild = (int)m_nodes.size();
+    shift = 2 * (depth - levels[i] - 1);
+    for (child = 0; child < 4; child++) {
+      childCode = codes[i] * 4 + child;
+      begin = cellStart[childCode << shift];
+      end = cellStart[(childCode + 1) << shift];
+      if (end > begin) {
+        node.firstTriangle = begin;
+        node.triangleCount = end - begin;
+        m_nodes.push_back(node);
+        levels.push_back(levels[i] + 1);
+        codes.push_back(childCode);
+        m_nodes[i].childCount++;
+      }
+    }
   }
 
-  // Case 2: If there are too many triangles in this node then split it into
-  // four equal sized smaller tree nodes.
-  if (numTriangles > MAX_TRIANGLES) {
-    for (i = 0; i < 4; i++) {
-      // Calculate the position offsets for the new child node.
-      offsetX = (((i % 2) < 1) ? -1.0f : 1.0f) * (width / 4.0f);
-      offsetZ = (((i % 4) < 2) ? -1.0f : 1.0f) * (width / 4.0f);
-
-      // See if there are any triangles in the new node.
-      count = CountTriangles((positionX + offsetX), (positionZ + offsetZ),
-                             (width / 2.0f));
-      if (count > 0) {
-        // If there are triangles inside where this new node would be then
-        // create the child node.
-        node->nodes[i] = new NodeType;
-
-        // Extend the tree starting from this new child node now.
-        CreateTreeNode(node->nodes[i], (positionX + offsetX),
-                       (positionZ + offsetZ), (width / 2.0f), device);
+  return;
+}
+
+void QuadTreeClass::PoolLeafVertices(const VertexType *vertices,
+                                     const std::vector<int> &order) {
+  std::vector<int> table;
+  const unsigned int *words;
+  unsigned int hash, mask;
+  int i, j, k, slot, vertexIndex, pooled;
+
+  m_vertices.clear();
+  m_positions.clear();
+  m_indices.resize((size_t)m_triangleCount * 3);
+
+  for (i = 0; i < (int)m_nodes.size(); i++) {
+    const NodeType &node = m_nodes[i];
+    if (node.childCount != 0) {
+      continue;
+    }
+
+    // Size an open addressing table to at least twice the leaf's corners.
+    mask = 1;
+    while (mask < (unsigned int)node.triangleCount * 6) {
+      mask <<= 1;
+    }
+    table.assign(mask, -1);
+    mask--;
+
+    // Each leaf shares equal vertices between its triangles. Its vertices
+    // take the next run of the pool, its indices the run of its triangles.
+    for (j = node.firstTriangle; j < node.firstTriangle + node.triangleCount;
+         j++) {
+      for (k = 0; k < 3; k++) {
+        vertexIndex = order[j] * 3 + k;
+        words = (const unsigned int *)&vertices[vertexIndex];
+        hash = 2166136261u;
+        for (slot = 0; slot < (int)(sizeof(VertexType) / 4); slot++) {
+          hash = (hash ^ words[slot]) * 16777619u;
+        }
+
+        slot = (int)(hash & mask);
+        while (table[slot] != -1 &&
+               memcmp(&m_vertices[table[slot]], &vertices[vertexIndex],
+                      sizeof(VertexType)) != 0) {
+          slot = (int)((slot + 1) & mask);
+        }
+        if (table[slot] == -1) {
+          table[slot] = (int)m_vertices.size();
+          m_vertices.push_back(vertices[vertexIndex]);
+        }
+        pooled = table[slot];
+        m_indices[(size_t)j * 3 + k] = (unsigned int)pooled;
       }
     }
+  }
 
-    return;
+  // Keep the positions for height queries once the vertices are on the GPU.
+  m_positions.resize(m_vertices.size());
+  for (i = 0; i < (int)m_vertices.size(); i++) {
+    m_positions[i].x = m_vertices[i].position.x;
+    m_positions[i].y = m_vertices[i].position.y;
+    m_positions[i].z = m_vertices[i].position.z;
   }
 
-  // Case 3: If this node is not empty and the triangle count for it is less
-  // than the max then this node is at the bottom of the tree so create the list
-  // of triangles to store in it.
-  node->triangleCount = numTriangles;
-
-  // Calculate the number of vertices.
-  vertexCount = numTriangles * 3;
-
-  // Create the vertex array.
-  vertices = new VertexType[vertexCount];
-
-  // Create the index array.
-  indices = new unsigned long[vertexCount];
-
-  // Create the vertex array.
-  node->vertexArray = new VectorType[vertexCount];
-
-  // Initialize the index for this new vertex and index array.
-  index = 0;
-
-  // Go through all the triangles in the vertex list.
-  for (i = 0; i < m_triangleCount; i++) {
-    // If the triangle is inside this node then add it to the vertex array.
-    result = IsTriangleContained(i, positionX, positionZ, width);
-    if (result == true) {
-      // Calculate the index into the terrain vertex list.
-      vertexIndex = i * 3;
-
-      // Get the three vertices of this triangle from the vertex list.
-      vertices[index].position = m_vertexList[vertexIndex].position;
-      vertices[index].texture = m_vertexList[vertexIndex].texture;
-      vertices[index].normal = m_vertexList[vertexIndex].normal;
-      indices[index] = index;
-
-      // Also store the vertex position information in the node vertex array.
-      node->vertexArray[index].x = m_vertexList[vertexIndex].position.x;
-      node->vertexArray[index].y = m_vertexList[vertexIndex].position.y;
-      node->vertexArray[index].z = m_vertexList[vertexIndex].position.z;
-
-      // Increment the indexes.
-      index++;
-      vertexIndex++;
-
-      // Do the same for the next point.
-      vertices[index].position = m_vertexList[vertexIndex].position;
-      vertices[index].texture = m_vertexList[vertexIndex].texture;
-      vertices[index].normal = m_vertexList[vertexIndex].normal;
-      indices[index] = index;
-      node->vertexArray[index].x = m_vertexList[vertexIndex].position.x;
-      node->vertexArray[index].y = m_vertexList[vertexIndex].position.y;
-      node->vertexArray[index].z = m_vertexList[vertexIndex].position.z;
-      index++;
-      vertexIndex++;
-
-      // Do the same for the next point also.
-      vertices[index].position = m_vertexList[vertexIndex].position;
-      vertices[index].texture = m_vertexList[vertexIndex].texture;
-      vertices[index].normal = m_vertexList[vertexIndex].normal;
-      indices[index] = index;
-      node->vertexArray[index].x = m_vertexList[vertexIndex].position.x;
-      node->vertexArray[index].y = m_vertexList[vertexIndex].position.y;
-      node->vertexArray[index].z = m_vertexList[vertexIndex].position.z;
-      index++;
+  return;
+}
+
+void QuadTreeClass::CalculateNodeBounds() {
+  int i, j;
+  const VectorType *position;
+
+  // Children always come after their parent, so going backwards finishes
+  // every child before its parent needs it.
+  for (i = (int)m_nodes.size() - 1; i >= 0; i--) {
+    NodeType &node = m_nodes[i];
+    if (node.childCount == 0) {
+      position = &m_positions[m_indices[(size_t)node.firstTriangle * 3]];
+      node.minX = node.maxX = position->x;
+      node.minY = node.maxY = position->y;
+      node.minZ = node.maxZ = position->z;
+      for (j = node.firstTriangle * 3;
+           j < (node.firstTriangle + node.triangleCount) * 3; j++) {
+        position = &m_positions[m_indices[j]];
+        node.minX = min(node.minX, position->x);
+        node.minY = min(node.minY, position->y);
+        node.minZ = min(node.minZ, position->z);
+        node.maxX = max(node.maxX, position->x);
+        node.maxY = max(node.maxY, position->y);
+        node.maxZ = max(node.maxZ, position->z);
+      }
+      continue;
+    }
+
+    node.minX = m_nodes[node.firstChild].minX;
+    node.minY = m_nodes[node.firstChild].minY;
+    node.minZ = m_nodes[node.firstChild].minZ;
+    node.maxX = m_nodes[node.firstChild].maxX;
+    node.maxY = m_nodes[node.firstChild].maxY;
+    node.maxZ = m_nodes[node.firstChild].maxZ;
+    for (j = node.firstChild + 1; j < node.firstChild + node.childCount;
+         j++) {
+      node.minX = min(node.minX, m_nodes[j].minX);
+      node.minY = min(node.minY, m_nodes[j].minY);
+      node.minZ = min(node.minZ, m_nodes[j].minZ);
+      node.maxX = max(node.maxX, m_nodes[j].maxX);
+      node.maxY = max(node.maxY, m_nodes[j].maxY);
+      node.maxZ = max(node.maxZ, m_nodes[j].maxZ);
     }
   }
 
+  return;
+}
+
+bool QuadTreeClass::InitializeBuffers(ID3D11Device *device) {
+  D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
+  D3D11_SUBRESOURCE_DATA vertexData, indexData;
+  HRESULT result;
+
   // Set up the description of the vertex buffer.
   vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-  vertexBufferDesc.ByteWidth = sizeof(VertexType) * vertexCount;
+  vertexBufferDesc.ByteWidth = (UINT)(sizeof(VertexType) * m_vertices.size());
   vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
   vertexBufferDesc.CPUAccessFlags = 0;
   vertexBufferDesc.MiscFlags = 0;
   vertexBufferDesc.StructureByteStride = 0;
 
   // Give the subresource structure a pointer to the vertex data.
-  vertexData.pSysMem = vertices;
+  vertexData.pSysMem = m_vertices.data();
   vertexData.SysMemPitch = 0;
   vertexData.SysMemSlicePitch = 0;
 
-  // Now finally create the vertex buffer.
-  device->CreateBuffer(&vertexBufferDesc, &vertexData, &node->vertexBuffer);
+  // Now create the vertex buffer.
+  result = device->CreateBuffer(&vertexBufferDesc, &vertexData,
+                                &m_vertexBuffer);
+  if (FAILED(result)) {
+    return false;
+  }
 
   // Set up the description of the index buffer.
   indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-  indexBufferDesc.ByteWidth = sizeof(unsigned long) * vertexCount;
+  indexBufferDesc.ByteWidth = (UINT)(sizeof(unsigned int) * m_indices.size());
   indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
   indexBufferDesc.CPUAccessFlags = 0;
   indexBufferDesc.MiscFlags = 0;
   indexBufferDesc.StructureByteStride = 0;
 
   // Give the subresource structure a pointer to the index data.
-  indexData.pSysMem = indices;
+  indexData.pSysMem = m_indices.data();
   indexData.SysMemPitch = 0;
   indexData.SysMemSlicePitch = 0;
 
   // Create the index buffer.
-  device->CreateBuffer(&indexBufferDesc, &indexData, &node->indexBuffer);
-
-  // Release the vertex and index arrays now that the data is stored in the
-  // buffers in the node.
-  delete[] vertices;
-  vertices = 0;
-
-  delete[] indices;
-  indices = 0;
-
-  return;
-}
-
-int QuadTreeClass::CountTriangles(float positionX, float positionZ,
-                                  float width) {
-  int count, i;
-  bool result;
-
-  // Initialize the count to zero.
-  count = 0;
-
-  // Go through all the triangles in the entire mesh and check which ones should
-  // be inside this node.
-  for (i = 0; i < m_triangleCount; i++) {
-    // If the triangle is inside the node then increment the count by one.
-    result = IsTriangleContained(i, positionX, positionZ, width);
-    if (result == true) {
-      count++;
-    }
-  }
-
-  return count;
-}
-
-bool QuadTreeClass::IsTriangleContained(int index, float positionX,
-                                        float positionZ, float width) {
-  float radius;
-  int vertexIndex;
-  float x1, z1, x2, z2, x3, z3;
-  float minimumX, maximumX, minimumZ, maximumZ;
-
-  // Calculate the radius of this node.
-  radius = width / 2.0f;
-
-  // Get the index into the vertex list.
-  vertexIndex = index * 3;
-
-  // Get the three vertices of this triangle from the vertex list.
-  x1 = m_vertexList[vertexIndex].position.x;
-  z1 = m_vertexList[vertexIndex].position.z;
-  vertexIndex++;
-
-  x2 = m_vertexList[vertexIndex].position.x;
-  z2 = m_vertexList[vertexIndex].position.z;
-  vertexIndex++;
-
-  x3 = m_vertexList[vertexIndex].position.x;
-  z3 = m_vertexList[vertexIndex].position.z;
-
-  // Check to see if the minimum of the x coordinates of the triangle is inside
-  // the node.
-  minimumX = min(x1, min(x2, x3));
-  if (minimumX > (positionX + radius)) {
-    return false;
-  }
-
-  // Check to see if the maximum of the x coordinates of the triangle is inside
-  // the node.
-  maximumX = max(x1, max(x2, x3));
-  if (maximumX < (positionX - radius)) {
-    return false;
-  }
-
-  // Check to see if the minimum of the z coordinates of the triangle is inside
-  // the node.
-  minimumZ = min(z1, min(z2, z3));
-  if (minimumZ > (positionZ + radius)) {
+  result = device->CreateBuffer(&indexBufferDesc, &indexData, &m_indexBuffer);
+  if (FAILED(result)) {
     return false;
   }
 
-  // Check to see if the maximum of the z coordinates of the triangle is inside
-  // the node.
-  maximumZ = max(z1, max(z2, z3));
-  if (maximumZ < (positionZ - radius)) {
-    return false;
-  }
+  // Release the vertices now that they are in the vertex buffer. The
+  // indices and positions stay for the height queries.
+  std::vector<VertexType>().swap(m_vertices);
 
   return true;
 }
 
-void QuadTreeClass::ReleaseNode(NodeType *node) {
-  int i;
-
-  // Recursively go down the tree and release the bottom nodes first.
-  for (i = 0; i < 4; i++) {
-    if (node->nodes[i] != 0) {
-      ReleaseNode(node->nodes[i]);
-    }
-  }
-
-  // Release the vertex buffer for this node.
-  if (node->vertexBuffer) {
-    node->vertexBuffer->Release();
-    node->vertexBuffer = 0;
+void QuadTreeClass::ShutdownBuffers() {
+  // Release the index buffer.
+  if (m_indexBuffer) {
+    m_indexBuffer->Release();
+    m_indexBuffer = 0;
   }
 
-  // Release the index buffer for this node.
-  if (node->indexBuffer) {
-    node->indexBuffer->Release();
-    node->indexBuffer = 0;
-  }
-
-  // Release the vertex array for this node.
-  if (node->vertexArray) {
-    delete[] node->vertexArray;
-    node->vertexArray = 0;
-  }
-
-  // Release the four child nodes.
-  for (i = 0; i < 4; i++) {
-    if (node->nodes[i]) {
-      delete node->nodes[i];
-      node->nodes[i] = 0;
-    }
+  // Release the vertex buffer.
+  if (m_vertexBuffer) {
+    m_vertexBuffer->Release();
+    m_vertexBuffer = 0;
   }
 
   return;
 }
 
-void QuadTreeClass::RenderNode(NodeType *node, FrustumClass *frustum,
-                               ID3D11DeviceContext *deviceContext,
-                               TerrainShaderClass *shader) {
-  bool result;
-  int count, i, indexCount;
-  unsigned int stride, offset;
-
-  // Check to see if the node can be viewed, height doesn't matter in a quad
-  // tree.
-  result = frustum->CheckCube(node->positionX, 0.0f, node->positionZ,
-                              (node->width / 2.0f));
-
-  // If it can't be seen then none of its children can either so don't continue
-  // down the tree, this is where the speed is gained.
-  if (!result) {
-    return;
-  }
-
-  // If it can be seen then check all four child nodes to see if they can also
-  // be seen.
-  count = 0;
-  for (i = 0; i < 4; i++) {
-    if (node->nodes[i] != 0) {
-      count++;
-      RenderNode(node->nodes[i], frustum, deviceContext, shader);
-    }
-  }
-
-  // If there were any children nodes then there is no need to continue as
-  // parent nodes won't contain any triangles to render.
-  if (count != 0) {
-    return;
+void QuadTreeClass::AddBatch(const NodeType &node) {
+  int startIndex, indexCount;
+
+  startIndex = node.firstTriangle * 3;
+  indexCount = node.triangleCount * 3;
+
+  // Ranges visited in order that touch the previous one extend its draw.
+  if (!m_batches.empty() &&
+      m_batches.back().startIndex + m_batches.back().indexCount ==
+          startIndex) {
+    m_batches.back().indexCount += indexCount;
+  } else {
+    BatchType batch;
+    batch.startIndex = startIndex;
+    batch.indexCount = indexCount;
+    m_batches.push_back(batch);
   }
 
-  // Otherwise if this node can be seen and has triangles in it then render
-  // these triangles.
-
-  // Set vertex buffer stride and offset.
-  stride = sizeof(VertexType);
-  offset = 0;
-
-  // Set the vertex buffer to active in the input assembler so it can be
-  // rendered.
-  deviceContext->IASetVertexBuffers(0, 1, &node->vertexBuffer, &stride,
-                                    &offset);
-
-  // Set the index buffer to active in the input assembler so it can be
-  // rendered.
-  deviceContext->IASetIndexBuffer(node->indexBuffer, DXGI_FORMAT_R32_UINT, 0);
-
-  // Set the type of primitive that should be rendered from this vertex buffer,
-  // in this case triangles.
-  deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-  // Determine the number of indices in this node.
-  indexCount = node->triangleCount * 3;
-
-  // Call the terrain shader to render the polygons in this node.
-  shader->RenderShader(deviceContext, indexCount);
-
-  // Increase the count of the number of polygons that have been rendered during
-  // this frame.
-  m_drawCount += node->triangleCount;
+  // Increase the count of the number of polygons that have been rendered
+  // during this frame.
+  m_drawCount += node.triangleCount;
 
   return;
 }
 
 bool QuadTreeClass::GetHeightAtPosition(float positionX, float positionZ,
                                         float &height) {
-  float meshMinX, meshMaxX, meshMinZ, meshMaxZ;
-
-  meshMinX = m_parentNode->positionX - (m_parentNode->width / 2.0f);
-  meshMaxX = m_parentNode->positionX + (m_parentNode->width / 2.0f);
-
-  meshMinZ = m_parentNode->positionZ - (m_parentNode->width / 2.0f);
-  meshMaxZ = m_parentNode->positionZ + (m_parentNode->width / 2.0f);
-
-  // Make sure the coordinates are actually over a polygon.
-  if ((positionX < meshMinX) || (positionX > meshMaxX) ||
-      (positionZ < meshMinZ) || (positionZ > meshMaxZ)) {
-    return false;
-  }
-
-  // Find the node which contains the polygon for this position.
-  FindNode(m_parentNode, positionX, positionZ, height);
-
-  return true;
-}
-
-void QuadTreeClass::FindNode(NodeType *node, float x, float z, float &height) {
-  float xMin, xMax, zMin, zMax;
-  int count, i, index;
+  int index, i;
   float vertex1[3], vertex2[3], vertex3[3];
-  bool foundHeight;
-
-  // Calculate the dimensions of this node.
-  xMin = node->positionX - (node->width / 2.0f);
-  xMax = node->positionX + (node->width / 2.0f);
+  const VectorType *position;
 
-  zMin = node->positionZ - (node->width / 2.0f);
-  zMax = node->positionZ + (node->width / 2.0f);
-
-  // See if the x and z coordinate are in this node, if not then stop traversing
-  // this part of the tree.
-  if ((x < xMin) || (x > xMax) || (z < zMin) || (z > zMax)) {
-    return;
+  // Walk down every node whose bounds hold the position; neighbouring
+  // leaves may overlap a little along their shared edge.
+  m_stack.clear();
+  if (!m_nodes.empty()) {
+    m_stack.push_back(0);
   }
-
-  // If the coordinates are in this node then check first to see if children
-  // nodes exist.
-  count = 0;
-
-  for (i = 0; i < 4; i++) {
-    if (node->nodes[i] != 0) {
-      count++;
-      FindNode(node->nodes[i], x, z, height);
+  while (!m_stack.empty()) {
+    index = m_stack.back();
+    m_stack.pop_back();
+    const NodeType &node = m_nodes[index];
+
+    // See if the x and z coordinate are in this node, if not then stop
+    // traversing this part of the tree.
+    if ((positionX < node.minX) || (positionX > node.maxX) ||
+        (positionZ < node.minZ) || (positionZ > node.maxZ)) {
+      continue;
     }
-  }
 
-  // If there were children nodes then return since the polygon will be in one
-  // of the children.
-  if (count > 0) {
-    return;
-  }
+    if (node.childCount != 0) {
+      for (i = node.childCount - 1; i >= 0; i--) {
+        m_stack.push_back(node.firstChild + i);
+      }
+      continue;
+    }
 
-  // If there were no children then the polygon must be in this node.  Check all
-  // the polygons in this node to find the height of which one the polygon we
-  // are looking for.
-  for (i = 0; i < node->triangleCount; i++) {
-    index = i * 3;
-    vertex1[0] = node->vertexArray[index].x;
-    vertex1[1] = node->vertexArray[index].y;
-    vertex1[2] = node->vertexArray[index].z;
-
-    index++;
-    vertex2[0] = node->vertexArray[index].x;
-    vertex2[1] = node->vertexArray[index].y;
-    vertex2[2] = node->vertexArray[index].z;
-
-    index++;
-    vertex3[0] = node->vertexArray[index].x;
-    vertex3[1] = node->vertexArray[index].y;
-    vertex3[2] = node->vertexArray[index].z;
-
-    // Check to see if this is the polygon we are looking for.
-    foundHeight =
-        CheckHeightOfTriangle(x, z, height, vertex1, vertex2, vertex3);
-
-    // If this was the triangle then quit the function and the height will be
-    // returned to the calling function.
-    if (foundHeight) {
-      return;
+    // Check all the polygons in this leaf for the one under the position.
+    for (i = node.firstTriangle * 3;
+         i < (node.firstTriangle + node.triangleCount) * 3; i += 3) {
+      position = &m_positions[m_indices[i]];
+      vertex1[0] = position->x;
+      vertex1[1] = position->y;
+      vertex1[2] = position->z;
+
+      position = &m_positions[m_indices[i + 1]];
+      vertex2[0] = position->x;
+      vertex2[1] = position->y;
+      vertex2[2] = position->z;
+
+      position = &m_positions[m_indices[i + 2]];
+      vertex3[0] = position->x;
+      vertex3[1] = position->y;
+      vertex3[2] = position->z;
+
+      // If this was the triangle then the height is found.
+      if (CheckHeightOfTriangle(positionX, positionZ, height, vertex1, vertex2,
+                                vertex3)) {
+        return true;
+      }
     }
   }
 
-  return;
+  return false;
 }
 
 bool QuadTreeClass::CheckHeightOfTriangle(float x, float z, float &height,
@@ -9,6 +9,15 @@
 /////////////
 const int MAX_TRIANGLES = 10000;
 
+// Deepest level the tree may split to; the bucketing grid has
+// 4^QUAD_TREE_MAX_DEPTH cells at most.
+const int QUAD_TREE_MAX_DEPTH = 10;
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+
 ///////////////////////
 // MY CLASS INCLUDES //
 ///////////////////////
@@ -18,6 +27,15 @@ const int MAX_TRIANGLES = 10000;
 
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: QuadTreeClass
+//
+// The nodes live in one array in breadth-first order with the children of a
+// node next to each other. Triangles are bucketed once into a grid by their
+// centre and sorted in Morton order, so the triangles of every node, leaf or
+// not, form one contiguous range of the shared index buffer. Each leaf welds
+// its vertices into its own run of the shared vertex buffer. Rendering walks
+// the tree with an explicit stack, draws whole subtrees that are fully inside
+// the frustum without testing their children, and merges visible ranges that
+// touch into a single draw call.
 ////////////////////////////////////////////////////////////////////////////////
 class QuadTreeClass {
 private:
@@ -32,11 +50,16 @@ private:
   };
 
   struct NodeType {
-    float positionX, positionZ, width;
-    int triangleCount;
-    ID3D11Buffer *vertexBuffer, *indexBuffer;
-    VectorType *vertexArray;
-    NodeType *nodes[4];
+    // Bounds of the triangles in the node, which may reach a little past
+    // the grid cell the node was split along.
+    float minX, minY, minZ;
+    float maxX, maxY, maxZ;
+    int firstChild, childCount;
+    int firstTriangle, triangleCount;
+  };
+
+  struct BatchType {
+    int startIndex, indexCount;
   };
 
 public:
@@ -49,25 +72,42 @@ public:
   void Render(FrustumClass *, ID3D11DeviceContext *, TerrainShaderClass *);
 
   int GetDrawCount();
+  int GetBatchCount();
   bool GetHeightAtPosition(float, float, float &);
 
+  bool BuildTree(void *, int);
+  void CullTree(FrustumClass *);
+  int GetNodeCount();
+  int GetLeafCount();
+  int GetPooledVertexCount();
+  void GetBatch(int, int &, int &);
+  void GetTriangle(int, float[3], float[3], float[3]);
+
 private:
-  void CalculateMeshDimensions(int, float &, float &, float &);
-  void CreateTreeNode(NodeType *, float, float, float, ID3D11Device *);
-  int CountTriangles(float, float, float);
-  bool IsTriangleContained(int, float, float, float);
-  void ReleaseNode(NodeType *);
-  void RenderNode(NodeType *, FrustumClass *, ID3D11DeviceContext *,
-                  TerrainShaderClass *);
-
-  void FindNode(NodeType *, float, float, float &);
+  void CalculateMeshDimensions(const VertexType *, int, float &, float &,
+                               float &);
+  int ChooseDepth(int);
+  void BucketTriangles(const VertexType *, int, float, float, float, int,
+                       std::vector<int> &, std::vector<int> &);
+  void CreateNodes(const std::vector<int> &, int);
+  void PoolLeafVertices(const VertexType *, const std::vector<int> &);
+  void CalculateNodeBounds();
+  bool InitializeBuffers(ID3D11Device *);
+  void ShutdownBuffers();
+  void AddBatch(const NodeType &);
+
   bool CheckHeightOfTriangle(float, float, float &, float[3], float[3],
                              float[3]);
 
 private:
-  int m_triangleCount, m_drawCount;
-  VertexType *m_vertexList;
-  NodeType *m_parentNode;
+  int m_triangleCount, m_drawCount, m_leafCount;
+  std::vector<NodeType> m_nodes;
+  std::vector<VertexType> m_vertices;
+  std::vector<unsigned int> m_indices;
+  std::vector<VectorType> m_positions;
+  std::vector<BatchType> m_batches;
+  std::vector<int> m_stack;
+  ID3D11Buffer *m_vertexBuffer, *m_indexBuffer;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,324 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: quadtreetests.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "quadtreetests.h"
+
+#include "frustumclass.h"
+#include "quadtreeclass.h"
+
+#include <windows.h>
+
+#include <exception>
+#include <math.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+// Same layout as the vertices TerrainClass hands to the quad tree.
+struct TestVertex {
+  float x, y, z;
+  float tu, tv;
+  float nx, ny, nz;
+};
+
+float SampleHeight(float x, float z) {
+  return 6.0f * sinf(x * 0.07f) * cosf(z * 0.045f) + 0.5f * sinf(x + z);
+}
+
+// An unindexed list of six vertices per quad in the order TerrainClass
+// writes them, with the texture wrapping every eight quads.
+std::vector<TestVertex> MakeTerrain(int width, int height) {
+  std::vector<TestVertex> vertices;
+  const int cornerX[6] = {0, 1, 0, 0, 1, 1};
+  const int cornerZ[6] = {1, 1, 0, 0, 1, 0};
+
+  vertices.reserve((size_t)(width - 1) * (height - 1) * 6);
+  for (int j = 0; j < height - 1; j++) {
+    for (int i = 0; i < width - 1; i++) {
+      for (int k = 0; k < 6; k++) {
+        TestVertex vertex;
+        vertex.x = (float)(i + cornerX[k]);
+        vertex.z = (float)(j + cornerZ[k]);
+        vertex.y = SampleHeight(vertex.x, vertex.z);
+        vertex.tu = (float)((i % 8) + cornerX[k]) / 8.0f;
+        vertex.tv = 1.0f - (float)((j % 8) + cornerZ[k]) / 8.0f;
+        vertex.nx = 0.0f;
+        vertex.ny = 1.0f;
+        vertex.nz = 0.0f;
+        vertices.push_back(vertex);
+      }
+    }
+  }
+  return vertices;
+}
+
+bool BuildTree(QuadTreeClass &tree, std::vector<TestVertex> &vertices,
+               std::string &message) {
+  if (!tree.BuildTree(vertices.data(), (int)vertices.size())) {
+    message = "build failed";
+    return false;
+  }
+  return true;
+}
+
+void MakeFrustum(FrustumClass &frustum, float eyeX, float eyeY, float eyeZ,
+                 float atX, float atY, float atZ) {
+  const float screenDepth = 1000.0f;
+  XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f,
+                                                 0.1f, screenDepth);
+  XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(eyeX, eyeY, eyeZ, 1.0f),
+                                   XMVectorSet(atX, atY, atZ, 1.0f),
+                                   XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+  frustum.ConstructFrustum(screenDepth, projection, view);
+}
+
+// One coordinate of the center of a triangle.
+float Center(const float v1[3], const float v2[3], const float v3[3],
+             int axis) {
+  return (v1[axis] + v2[axis] + v3[axis]) / 3.0f;
+}
+
+bool TestPartition(std::string &message) {
+  const int size = 257;
+  std::vector<TestVertex> vertices = MakeTerrain(size, size);
+  const int triangleCount = (int)vertices.size() / 3;
+  std::vector<int> seen((size_t)(size - 1) * (size - 1) * 2, 0);
+  float v1[3], v2[3], v3[3];
+  QuadTreeClass tree;
+
+  if (!BuildTree(tree, vertices, message)) {
+    return false;
+  }
+  if (tree.GetLeafCount() < (triangleCount + MAX_TRIANGLES - 1) /
+                                MAX_TRIANGLES) {
+    message = "too few leaves for the triangle count";
+    return false;
+  }
+
+  // Every triangle comes back exactly once. The two halves of a quad are
+  // told apart by which side of the diagonal their center lies.
+  for (int i = 0; i < triangleCount; i++) {
+    tree.GetTriangle(i, v1, v2, v3);
+    const float x = Center(v1, v2, v3, 0);
+    const float z = Center(v1, v2, v3, 2);
+    const int quadX = (int)x;
+    const int quadZ = (int)z;
+    const int half = ((x - quadX) > (z - quadZ)) ? 1 : 0;
+    const int key = ((quadZ * (size - 1)) + quadX) * 2 + half;
+    if (quadX < 0 || quadX >= size - 1 || quadZ < 0 || quadZ >= size - 1) {
+      message = "triangle outside the terrain";
+      return false;
+    }
+    if (fabsf(v1[1] - SampleHeight(v1[0], v1[2])) > 1e-4f) {
+      message = "pooled vertex lost its height";
+      return false;
+    }
+    seen[key]++;
+  }
+  for (size_t i = 0; i < seen.size(); i++) {
+    if (seen[i] != 1) {
+      message = "triangle missing or duplicated";
+      return false;
+    }
+  }
+
+  // Vertices shared inside a leaf are stored once.
+  if (tree.GetPooledVertexCount() * 3 > (int)vertices.size()) {
+    message = "leaf vertices were not welded";
+    return false;
+  }
+  return true;
+}
+
+bool TestWholeTreeIsOneBatch(std::string &message) {
+  std::vector<TestVertex> vertices = MakeTerrain(129, 129);
+  QuadTreeClass tree;
+  FrustumClass frustum;
+  int startIndex, indexCount;
+
+  if (!BuildTree(tree, vertices, message)) {
+    return false;
+  }
+
+  // High above and far back, the whole terrain is in view and the root is
+  // accepted without visiting any child.
+  MakeFrustum(frustum, 64.0f, 300.0f, -300.0f, 64.0f, 0.0f, 64.0f);
+  tree.CullTree(&frustum);
+  if (tree.GetBatchCount() != 1 ||
+      tree.GetDrawCount() != (int)vertices.size() / 3) {
+    message = "a fully visible tree is not one draw";
+    return false;
+  }
+  tree.GetBatch(0, startIndex, indexCount);
+  if (startIndex != 0 || indexCount != (int)vertices.size()) {
+    message = "the single batch does not cover the index buffer";
+    return false;
+  }
+
+  // Looking away from the terrain draws nothing.
+  MakeFrustum(frustum, 64.0f, 10.0f, -20.0f, 64.0f, 10.0f, -100.0f);
+  tree.CullTree(&frustum);
+  if (tree.GetBatchCount() != 0 || tree.GetDrawCount() != 0) {
+    message = "terrain behind the camera was drawn";
+    return false;
+  }
+  return true;
+}
+
+bool TestCulledBatches(std::string &message) {
+  std::vector<TestVertex> vertices = MakeTerrain(257, 257);
+  const int triangleCount = (int)vertices.size() / 3;
+  std::vector<char> drawn(triangleCount, 0);
+  float v1[3], v2[3], v3[3];
+  int startIndex, indexCount, previousEnd, total;
+  QuadTreeClass tree;
+  FrustumClass frustum;
+
+  if (!BuildTree(tree, vertices, message)) {
+    return false;
+  }
+
+  // Standing inside the terrain looking across part of it.
+  MakeFrustum(frustum, 40.0f, 15.0f, 30.0f, 200.0f, 0.0f, 120.0f);
+  tree.CullTree(&frustum);
+
+  // Batches are in index order, never overlap and never touch, since
+  // touching ranges are merged into one draw.
+  previousEnd = -1;
+  total = 0;
+  for (int i = 0; i < tree.GetBatchCount(); i++) {
+    tree.GetBatch(i, startIndex, indexCount);
+    if (indexCount <= 0 || startIndex % 3 != 0 || indexCount % 3 != 0 ||
+        startIndex <= previousEnd) {
+      message = "batches overlap, touch or are out of order";
+      return false;
+    }
+    for (int j = startIndex / 3; j < (startIndex + indexCount) / 3; j++) {
+      drawn[j] = 1;
+    }
+    previousEnd = startIndex + indexCount;
+    total += indexCount / 3;
+  }
+  if (total != tree.GetDrawCount()) {
+    message = "draw count does not match the batches";
+    return false;
+  }
+  if (total == 0 || total == triangleCount) {
+    message = "view does not cull part of the terrain";
+    return false;
+  }
+
+  // No triangle with a corner in view may be culled.
+  for (int i = 0; i < triangleCount; i++) {
+    tree.GetTriangle(i, v1, v2, v3);
+    if (!drawn[i] && (frustum.CheckPoint(v1[0], v1[1], v1[2]) ||
+                      frustum.CheckPoint(v2[0], v2[1], v2[2]) ||
+                      frustum.CheckPoint(v3[0], v3[1], v3[2]))) {
+      message = "visible triangle was culled";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestHeightQueries(std::string &message) {
+  std::vector<TestVertex> vertices = MakeTerrain(200, 150);
+  QuadTreeClass tree;
+  float height, expected, x, z, fx, fz, h00, h10, h01, h11;
+
+  if (!BuildTree(tree, vertices, message)) {
+    return false;
+  }
+
+  for (int i = 0; i < 997; i++) {
+    x = 0.5f + fmodf(i * 17.31f, 198.0f);
+    z = 0.5f + fmodf(i * 7.77f, 148.0f);
+    if (!tree.GetHeightAtPosition(x, z, height)) {
+      message = "no height inside the terrain";
+      return false;
+    }
+
+    // Each quad is split along the diagonal from its bottom left to its
+    // upper right corner.
+    fx = x - floorf(x);
+    fz = z - floorf(z);
+    h00 = SampleHeight(floorf(x), floorf(z));
+    h10 = SampleHeight(floorf(x) + 1.0f, floorf(z));
+    h01 = SampleHeight(floorf(x), floorf(z) + 1.0f);
+    h11 = SampleHeight(floorf(x) + 1.0f, floorf(z) + 1.0f);
+    if (fx <= fz) {
+      expected = h00 + (h11 - h01) * fx + (h01 - h00) * fz;
+    } else {
+      expected = h00 + (h10 - h00) * fx + (h11 - h10) * fz;
+    }
+    if (fabsf(height - expected) > 1e-3f) {
+      message = "height does not match the terrain";
+      return false;
+    }
+  }
+
+  if (tree.GetHeightAtPosition(-5.0f, 20.0f, height) ||
+      tree.GetHeightAtPosition(50.0f, 400.0f, height)) {
+    message = "height found outside the terrain";
+    return false;
+  }
+  return true;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(4);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("Every triangle in one leaf", TestPartition);
+  run("Whole tree is one batch", TestWholeTreeIsOneBatch);
+  run("Culled batches", TestCulledBatches);
+  run("Height queries", TestHeightQueries);
+
+  return results;
+}
+
+} // namespace
+
+bool RunQuadTreeTests() {
+  const std::vector<TestCaseResult> results = RunAllTestsInternal();
+  bool allPassed = true;
+  std::string line;
+
+  for (const TestCaseResult &result : results) {
+    if (!result.passed) {
+      allPassed = false;
+      line = "QuadTreeTests: Test failed: " + result.name;
+      if (!result.message.empty()) {
+        line += " - " + result.message;
+      }
+      line += "\n";
+      OutputDebugStringA(line.c_str());
+    }
+  }
+
+  return allPassed;
+}
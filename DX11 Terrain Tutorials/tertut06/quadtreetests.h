@@ -0,0 +1,12 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: quadtreetests.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _QUADTREETESTS_H_
+#define _QUADTREETESTS_H_
+
+// Headless tests of QuadTreeClass: the triangle partition, the welded index
+// list, the culled batches and height queries. Failures are written to the
+// debugger output. Returns false if any test fails.
+bool RunQuadTreeTests();
+
+#endif
@@ -523,4 +523,22 @@ int TerrainClass::GetVertexCount() { return m_vertexCount; }
 void TerrainClass::CopyVertexArray(void *vertexList) {
   memcpy(vertexList, m_vertices, sizeof(VertexType) * m_vertexCount);
   return;
-}
\ No newline at end of file
+}
+
+int TerrainClass::GetTerrainWidth() { return m_terrainWidth; }
+
+int TerrainClass::GetTerrainHeight() { return m_terrainHeight; }
+
+void TerrainClass::CopyHeightArray(float *heightList) {
+  int i, j;
+
+  // Copy the heights row by row, with point (i, j) at x = i and z = j.
+  for (j = 0; j < m_terrainHeight; j++) {
+    for (i = 0; i < m_terrainWidth; i++) {
+      heightList[(m_terrainWidth * j) + i] =
+          m_heightMap[(m_terrainHeight * j) + i].y;
+    }
+  }
+
+  return;
+}
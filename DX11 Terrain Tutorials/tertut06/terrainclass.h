@@ -56,6 +56,10 @@ public:
   int GetVertexCount();
   void CopyVertexArray(void *);
 
+  int GetTerrainWidth();
+  int GetTerrainHeight();
+  void CopyHeightArray(float *);
+
 private:
   bool LoadHeightMap(char *);
   void NormalizeHeightMap();
@@ -363,7 +363,7 @@ bool TerrainShaderClass::SetShaderParameters(
 }
 
 void TerrainShaderClass::RenderShader(ID3D11DeviceContext *deviceContext,
-                                      int indexCount) {
+                                      int indexCount, int startIndex) {
   // Set the vertex input layout.
   deviceContext->IASetInputLayout(m_layout);
 
@@ -374,8 +374,8 @@ void TerrainShaderClass::RenderShader(ID3D11DeviceContext *deviceContext,
   // Set the sampler state in the pixel shader.
   deviceContext->PSSetSamplers(0, 1, &m_sampleState);
 
-  // Render the triangle.
-  deviceContext->DrawIndexed(indexCount, 0, 0);
+  // Render the triangles starting at the given index.
+  deviceContext->DrawIndexed(indexCount, startIndex, 0);
 
   return;
 }
\ No newline at end of file
@@ -44,7 +44,7 @@ public:
                            const XMMATRIX &, const XMMATRIX &, const XMFLOAT4 &,
                            const XMFLOAT4 &, const XMFLOAT3 &,
                            ID3D11ShaderResourceView *);
-  void RenderShader(ID3D11DeviceContext *, int);
+  void RenderShader(ID3D11DeviceContext *, int, int);
 
 private:
   bool InitializeShader(ID3D11Device *, HWND, WCHAR *, WCHAR *);
@@ -566,42 +566,86 @@ bool TerrainClass::LoadMaterialMap(char *filename) {
 }
 
 bool TerrainClass::LoadMaterialBuffers(ID3D11Device *device) {
-  int maxVertexCount, maxIndexCount, i, j, index1, index2, index3, index4,
-      redIndex, greenIndex, blueIndex, index, vIndex;
-  bool found;
+  int i, j, index1, index2, index3, index4, color, index, vIndex;
+  vector<unsigned char> materialLookup, quadMaterials;
   D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
   D3D11_SUBRESOURCE_DATA vertexData, indexData;
   HRESULT result;
 
-  // Create the value for the maximum number of vertices a material group could
-  // possibly have.
-  maxVertexCount = (m_terrainWidth - 1) * (m_terrainHeight - 1) * 6;
+  // The lookup table stores material indexes in a byte, with the last value
+  // left for colors that have no material.
+  if (m_materialCount >= NO_MATERIAL) {
+    return false;
+  }
+
+  // Create a lookup table from every 24 bit material map color to its
+  // material group.
+  materialLookup.assign(1 << 24, (unsigned char)NO_MATERIAL);
+  for (i = 0; i < m_materialCount; i++) {
+    if ((m_Materials[i].red < 0) || (m_Materials[i].red > 255) ||
+        (m_Materials[i].green < 0) || (m_Materials[i].green > 255) ||
+        (m_Materials[i].blue < 0) || (m_Materials[i].blue > 255)) {
+      return false;
+    }
+    color = (m_Materials[i].red << 16) | (m_Materials[i].green << 8) |
+            m_Materials[i].blue;
+    // When two materials share a color the first one listed wins, like a
+    // search of the material list in order.
+    if (materialLookup[color] == NO_MATERIAL) {
+      materialLookup[color] = (unsigned char)i;
+    }
+
+    // Initialize the counts to zero.
+    m_Materials[i].vertexCount = 0;
+    m_Materials[i].indexCount = 0;
+  }
+
+  // First pass: find the material group of every quad from its upper left
+  // corner and count the vertices each group needs.
+  quadMaterials.resize((m_terrainWidth - 1) * (m_terrainHeight - 1));
+  for (j = 0; j < (m_terrainHeight - 1); j++) {
+    for (i = 0; i < (m_terrainWidth - 1); i++) {
+      index3 = (m_terrainHeight * (j + 1)) + i; // Upper left.
 
-  // Set the index count to the same as the maximum vertex count.
-  maxIndexCount = maxVertexCount;
+      color = (m_heightMap[index3].rIndex << 16) |
+              (m_heightMap[index3].gIndex << 8) | m_heightMap[index3].bIndex;
+      index = materialLookup[color];
 
-  // Initialize vertex and index arrays for each material group to the maximum
-  // size.
+      // Fail on material map colors the material file does not list.
+      if (index == NO_MATERIAL) {
+        return false;
+      }
+
+      quadMaterials[((m_terrainWidth - 1) * j) + i] = (unsigned char)index;
+      m_Materials[index].vertexCount += 6;
+    }
+  }
+
+  // Create the vertex and index arrays for each material group at exactly
+  // the size it needs.
   for (i = 0; i < m_materialCount; i++) {
+    if (m_Materials[i].vertexCount == 0) {
+      continue;
+    }
+
     // Create the temporary vertex array for this material group.
-    m_Materials[i].vertices = new VertexType[maxVertexCount];
+    m_Materials[i].vertices = new VertexType[m_Materials[i].vertexCount];
     if (!m_Materials[i].vertices) {
       return false;
     }
 
     // Create the temporary index array for this material group.
-    m_Materials[i].indices = new unsigned long[maxIndexCount];
+    m_Materials[i].indices = new unsigned long[m_Materials[i].vertexCount];
     if (!m_Materials[i].indices) {
       return false;
     }
 
-    // Initialize the counts to zero.
+    // Reset the counts so the second pass can fill the arrays from the start.
     m_Materials[i].vertexCount = 0;
-    m_Materials[i].indexCount = 0;
   }
 
-  // Now loop through the terrain and build the vertex arrays for each material
-  // group.
+  // Second pass: loop through the terrain and fill the vertex arrays for each
+  // material group.
   for (j = 0; j < (m_terrainHeight - 1); j++) {
     for (i = 0; i < (m_terrainWidth - 1); i++) {
       index1 = (m_terrainHeight * j) + i;             // Bottom left.
@@ -609,23 +653,8 @@ bool TerrainClass::LoadMaterialBuffers(ID3D11Device *device) {
       index3 = (m_terrainHeight * (j + 1)) + i;       // Upper left.
       index4 = (m_terrainHeight * (j + 1)) + (i + 1); // Upper right.
 
-      // Query the upper left corner vertex for the material index.
-      redIndex = m_heightMap[index3].rIndex;
-      greenIndex = m_heightMap[index3].gIndex;
-      blueIndex = m_heightMap[index3].bIndex;
-
-      // Find which material group this vertex belongs to.
-      index = 0;
-      found = false;
-      while (!found) {
-        if ((redIndex == m_Materials[index].red) &&
-            (greenIndex == m_Materials[index].green) &&
-            (blueIndex == m_Materials[index].blue)) {
-          found = true;
-        } else {
-          index++;
-        }
-      }
+      // Get the material group found for this quad in the first pass.
+      index = quadMaterials[((m_terrainWidth - 1) * j) + i];
 
       // Set the index position in the vertex and index array to the count.
       vIndex = m_Materials[index].vertexCount;
@@ -715,8 +744,12 @@ bool TerrainClass::LoadMaterialBuffers(ID3D11Device *device) {
   }
 
   // Now create the vertex and index buffers from the vertex and index arrays
-  // for each material group.
+  // for each material group. Groups the map does not use get no buffers.
   for (i = 0; i < m_materialCount; i++) {
+    if (m_Materials[i].vertexCount == 0) {
+      continue;
+    }
+
     vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
     vertexBufferDesc.ByteWidth =
         sizeof(VertexType) * m_Materials[i].vertexCount;
@@ -835,6 +868,11 @@ bool TerrainClass::Render(
 
   // Render each material group.
   for (i = 0; i < m_materialCount; i++) {
+    // Skip material groups that are not used anywhere on the terrain.
+    if (m_Materials[i].indexCount == 0) {
+      continue;
+    }
+
     // Set the vertex buffer to active in the input assembler so it can be
     // rendered.
     deviceContext->IASetVertexBuffers(0, 1, &m_Materials[i].vertexBuffer,
@@ -4,6 +4,12 @@
 #ifndef _TERRAINCLASS_H_
 #define _TERRAINCLASS_H_
 
+/////////////
+// GLOBALS //
+/////////////
+// Material lookup value for material map colors with no material group.
+const int NO_MATERIAL = 255;
+
 //////////////
 // INCLUDES //
 //////////////
@@ -11,6 +17,7 @@
 #include <d3d11.h>
 #include <fstream>
 #include <stdio.h>
+#include <vector>
 using namespace std;
 using namespace DirectX;
 
@@ -13,6 +13,7 @@ ApplicationClass::ApplicationClass() {
   m_Light = 0;
   m_Terrain = 0;
   m_TerrainShader = 0;
+  m_terrainLodScale = 0.0f;
   m_ColorTexture1 = 0;
   m_ColorTexture2 = 0;
   m_ColorTexture3 = 0;
@@ -115,6 +116,12 @@ bool ApplicationClass::Initialize(HINSTANCE hinstance, HWND hwnd,
     return false;
   }
 
+  // Pixels per world unit at unit distance, for the projection D3DClass
+  // builds with a field of view of pi / 4. The terrain level of detail
+  // turns its height errors into screen space errors with it.
+  m_terrainLodScale =
+      (float)screenHeight / (2.0f * tanf((float)XM_PI / 8.0f));
+
   // Create the terrain shader object.
   m_TerrainShader =
       (TerrainShaderClass *)_aligned_malloc(sizeof(TerrainShaderClass), 16);
@@ -277,6 +284,13 @@ void ApplicationClass::Shutdown() {
     m_TerrainShader = 0;
   }
 
+  // Release the terrain object.
+  if (m_Terrain) {
+    m_Terrain->Shutdown();
+    delete m_Terrain;
+    m_Terrain = 0;
+  }
+
   // Release the light object.
   if (m_Light) {
     delete m_Light;
@@ -343,6 +357,14 @@ bool ApplicationClass::Frame() {
     return false;
   }
 
+#ifdef _DEBUG
+  // Edit the terrain.
+  result = HandleTerrainEdit(m_Timer->GetTime());
+  if (!result) {
+    return false;
+  }
+#endif
+
   // Render the graphics.
   result = Render();
   if (!result) {
@@ -395,8 +417,27 @@ bool ApplicationClass::HandleMovementInput(float frameTime) {
   return true;
 }
 
+#ifdef _DEBUG
+bool ApplicationClass::HandleTerrainEdit(float frameTime) {
+  float posX, posY, posZ;
+
+  // Dig into the terrain under the camera while space is held, to check the
+  // partial normal and vertex updates by eye. Only the normals and vertices
+  // around the crater are rebuilt.
+  if (m_Input->IsSpacePressed()) {
+    m_Position->GetPosition(posX, posY, posZ);
+    m_Terrain->AddCrater(m_Direct3D->GetDeviceContext(), posX, posZ,
+                         TERRAIN_CRATER_RADIUS,
+                         TERRAIN_CRATER_RATE * frameTime);
+  }
+
+  return true;
+}
+#endif
+
 bool ApplicationClass::Render() {
   XMMATRIX worldMatrix, viewMatrix, projectionMatrix;
+  float posX, posY, posZ;
   bool result;
 
   // Clear the scene.
@@ -411,19 +452,24 @@ bool ApplicationClass::Render() {
   m_Camera->GetViewMatrix(viewMatrix);
   m_Direct3D->GetProjectionMatrix(projectionMatrix);
 
-  // Render the terrain using the terrain shader.
-  m_Terrain->Render(m_Direct3D->GetDeviceContext());
-  result = m_TerrainShader->Render(
-      m_Direct3D->GetDeviceContext(), m_Terrain->GetIndexCount(), worldMatrix,
-      viewMatrix, projectionMatrix, m_Light->GetDirection(),
-      m_ColorTexture1->GetTexture(), m_ColorTexture2->GetTexture(),
-      m_ColorTexture3->GetTexture(), m_ColorTexture4->GetTexture(),
-      m_AlphaTexture1->GetTexture(), m_NormalTexture1->GetTexture(),
-      m_NormalTexture2->GetTexture());
+  // Set the terrain shader parameters once for all the terrain chunks.
+  result = m_TerrainShader->SetShaderParameters(
+      m_Direct3D->GetDeviceContext(), worldMatrix, viewMatrix,
+      projectionMatrix, m_Light->GetDirection(), m_ColorTexture1->GetTexture(),
+      m_ColorTexture2->GetTexture(), m_ColorTexture3->GetTexture(),
+      m_ColorTexture4->GetTexture(), m_AlphaTexture1->GetTexture(),
+      m_NormalTexture1->GetTexture(), m_NormalTexture2->GetTexture());
   if (!result) {
     return false;
   }
 
+  // Pick the terrain level of detail for the current view point, then
+  // render the terrain chunks.
+  m_Position->GetPosition(posX, posY, posZ);
+  m_Terrain->SelectLod(posX, posY, posZ, m_terrainLodScale,
+                       TERRAIN_PIXEL_ERROR);
+  m_Terrain->Render(m_Direct3D->GetDeviceContext(), m_TerrainShader);
+
   // Present the rendered scene to the screen.
   m_Direct3D->EndScene();
 
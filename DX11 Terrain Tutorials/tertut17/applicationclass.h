@@ -12,6 +12,14 @@ const bool VSYNC_ENABLED = true;
 const float SCREEN_DEPTH = 1000.0f;
 const float SCREEN_NEAR = 0.1f;
 
+// Largest height error, in pixels, a coarser terrain level may show.
+const float TERRAIN_PIXEL_ERROR = 2.0f;
+
+// In Debug builds, holding space digs a crater of this radius under the
+// camera, deepening at this rate in height units per millisecond.
+const float TERRAIN_CRATER_RADIUS = 8.0f;
+const float TERRAIN_CRATER_RATE = 0.005f;
+
 ///////////////////////
 // MY CLASS INCLUDES //
 ///////////////////////
@@ -40,6 +48,9 @@ public:
 
 private:
   bool HandleMovementInput(float);
+#ifdef _DEBUG
+  bool HandleTerrainEdit(float);
+#endif
   bool Render();
 
 private:
@@ -51,6 +62,7 @@ private:
   LightClass *m_Light;
   TerrainClass *m_Terrain;
   TerrainShaderClass *m_TerrainShader;
+  float m_terrainLodScale;
 
   TextureClass *m_ColorTexture1;
   TextureClass *m_ColorTexture2;
@@ -0,0 +1,669 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: heightmapclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "heightmapclass.h"
+
+#include <windows.h>
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+// Reads a zlib stream's deflate data a bit at a time, least significant bit
+// first.
+struct InflateStateType {
+  const unsigned char *data;
+  size_t size, position;
+  unsigned int bitBuffer;
+  int bitCount;
+  bool error;
+};
+
+// Canonical Huffman code: the number of codes of each length and the
+// symbols in code order.
+struct HuffmanType {
+  short counts[16];
+  short symbols[320];
+};
+
+const short LENGTH_BASE[29] = {3,  4,  5,  6,   7,   8,   9,   10,  11, 13,
+                               15, 17, 19, 23,  27,  31,  35,  43,  51, 59,
+                               67, 83, 99, 115, 131, 163, 195, 227, 258};
+const short LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const short DISTANCE_BASE[30] = {
+    1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,
+    97,  129, 193, 257, 385, 513,  769,  1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577};
+const short DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,
+                                  4, 4, 5, 5, 6, 6, 7, 7,  8,  8,
+                                  9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+const unsigned char CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8,  7, 9,
+                                             6,  10, 5,  11, 4, 12, 3,
+                                             13, 2,  14, 1,  15};
+
+int GetBits(InflateStateType &state, int count) {
+  unsigned int value;
+
+  // Refill a byte at a time; running out of input is an error.
+  value = state.bitBuffer;
+  while (state.bitCount < count) {
+    if (state.position >= state.size) {
+      state.error = true;
+      return 0;
+    }
+    value |= (unsigned int)state.data[state.position++] << state.bitCount;
+    state.bitCount += 8;
+  }
+
+  state.bitBuffer = value >> count;
+  state.bitCount -= count;
+
+  return (int)(value & ((1u << count) - 1));
+}
+
+// Returns a negative value for an over-subscribed set of lengths, zero for
+// a complete code and the number of missing codes for an incomplete one.
+int BuildHuffman(HuffmanType &code, const short *lengths, int count) {
+  short offsets[16];
+  int length, symbol, left;
+
+  memset(code.counts, 0, sizeof(code.counts));
+  for (symbol = 0; symbol < count; symbol++) {
+    code.counts[lengths[symbol]]++;
+  }
+  if (code.counts[0] == count) {
+    return 0;
+  }
+
+  left = 1;
+  for (length = 1; length < 16; length++) {
+    left <<= 1;
+    left -= code.counts[length];
+    if (left < 0) {
+      return left;
+    }
+  }
+
+  offsets[1] = 0;
+  for (length = 1; length < 15; length++) {
+    offsets[length + 1] = offsets[length] + code.counts[length];
+  }
+  for (symbol = 0; symbol < count; symbol++) {
+    if (lengths[symbol] != 0) {
+      code.symbols[offsets[lengths[symbol]]++] = (short)symbol;
+    }
+  }
+
+  return left;
+}
+
+int Decode(InflateStateType &state, const HuffmanType &code) {
+  int value, first, index, count, length;
+
+  // Codes are stored most significant bit first, so walk down the lengths
+  // one bit at a time.
+  value = first = index = 0;
+  for (length = 1; length < 16; length++) {
+    value |= GetBits(state, 1);
+    if (state.error) {
+      return -1;
+    }
+    count = code.counts[length];
+    if (value - count < first) {
+      return code.symbols[index + (value - first)];
+    }
+    index += count;
+    first += count;
+    first <<= 1;
+    value <<= 1;
+  }
+
+  return -1;
+}
+
+// Output never grows past maxSize, so a crafted stream cannot run a single
+// block out of memory before the caller's size check.
+bool InflateCodes(InflateStateType &state, const HuffmanType &lengthCode,
+                  const HuffmanType &distanceCode, size_t maxSize,
+                  std::vector<unsigned char> &output) {
+  int symbol, length, distance;
+  size_t from;
+
+  for (;;) {
+    symbol = Decode(state, lengthCode);
+    if (symbol < 0) {
+      return false;
+    }
+
+    // Literal byte.
+    if (symbol < 256) {
+      if (output.size() >= maxSize) {
+        return false;
+      }
+      output.push_back((unsigned char)symbol);
+      continue;
+    }
+
+    // End of the block.
+    if (symbol == 256) {
+      return true;
+    }
+
+    // Copy of earlier output, which may overlap what it writes.
+    symbol -= 257;
+    if (symbol >= 29) {
+      return false;
+    }
+    length = LENGTH_BASE[symbol] + GetBits(state, LENGTH_EXTRA[symbol]);
+
+    symbol = Decode(state, distanceCode);
+    if (symbol < 0 || symbol >= 30) {
+      return false;
+    }
+    distance = DISTANCE_BASE[symbol] + GetBits(state, DISTANCE_EXTRA[symbol]);
+    if (state.error || (size_t)distance > output.size() ||
+        (size_t)length > maxSize - output.size()) {
+      return false;
+    }
+
+    from = output.size() - distance;
+    while (length-- > 0) {
+      output.push_back(output[from++]);
+    }
+  }
+}
+
+bool InflateFixed(InflateStateType &state, size_t maxSize,
+                  std::vector<unsigned char> &output) {
+  HuffmanType lengthCode, distanceCode;
+  short lengths[288];
+  int symbol;
+
+  for (symbol = 0; symbol < 144; symbol++) {
+    lengths[symbol] = 8;
+  }
+  for (; symbol < 256; symbol++) {
+    lengths[symbol] = 9;
+  }
+  for (; symbol < 280; symbol++) {
+    lengths[symbol] = 7;
+  }
+  for (; symbol < 288; symbol++) {
+    lengths[symbol] = 8;
+  }
+  BuildHuffman(lengthCode, lengths, 288);
+
+  for (symbol = 0; symbol < 30; symbol++) {
+    lengths[symbol] = 5;
+  }
+  BuildHuffman(distanceCode, lengths, 30);
+
+  return InflateCodes(state, lengthCode, distanceCode, maxSize, output);
+}
+
+bool InflateDynamic(InflateStateType &state, size_t maxSize,
+                    std::vector<unsigned char> &output) {
+  HuffmanType lengthCode, distanceCode;
+  short lengths[320];
+  int lengthCount, distanceCount, codeCount, index, symbol, repeat;
+  short previous;
+
+  // Read the sizes of the two codes and of the code that encodes them.
+  lengthCount = GetBits(state, 5) + 257;
+  distanceCount = GetBits(state, 5) + 1;
+  codeCount = GetBits(state, 4) + 4;
+  if (state.error || lengthCount > 286 || distanceCount > 30) {
+    return false;
+  }
+
+  for (index = 0; index < codeCount; index++) {
+    lengths[CODE_LENGTH_ORDER[index]] = (short)GetBits(state, 3);
+  }
+  for (; index < 19; index++) {
+    lengths[CODE_LENGTH_ORDER[index]] = 0;
+  }
+  if (state.error || BuildHuffman(lengthCode, lengths, 19) != 0) {
+    return false;
+  }
+
+  // Read the code lengths of both codes, with runs of repeats and zeros.
+  index = 0;
+  while (index < lengthCount + distanceCount) {
+    symbol = Decode(state, lengthCode);
+    if (symbol < 0) {
+      return false;
+    }
+    if (symbol < 16) {
+      lengths[index++] = (short)symbol;
+      continue;
+    }
+
+    previous = 0;
+    if (symbol == 16) {
+      if (index == 0) {
+        return false;
+      }
+      previous = lengths[index - 1];
+      repeat = 3 + GetBits(state, 2);
+    } else if (symbol == 17) {
+      repeat = 3 + GetBits(state, 3);
+    } else {
+      repeat = 11 + GetBits(state, 7);
+    }
+    if (state.error || index + repeat > lengthCount + distanceCount) {
+      return false;
+    }
+    while (repeat-- > 0) {
+      lengths[index++] = previous;
+    }
+  }
+
+  // A block without an end code can't be decoded.
+  if (lengths[256] == 0) {
+    return false;
+  }
+
+  if (BuildHuffman(lengthCode, lengths, lengthCount) < 0 ||
+      BuildHuffman(distanceCode, lengths + lengthCount, distanceCount) < 0) {
+    return false;
+  }
+
+  return InflateCodes(state, lengthCode, distanceCode, maxSize, output);
+}
+
+// Decompresses a zlib stream. The checksum is not verified.
+bool Inflate(const unsigned char *data, size_t size, size_t expectedSize,
+             std::vector<unsigned char> &output) {
+  InflateStateType state;
+  int last, type;
+  unsigned int length;
+
+  // Check the zlib header: deflate, no preset dictionary.
+  if (size < 2 || (data[0] & 0x0f) != 8 ||
+      ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20)) {
+    return false;
+  }
+
+  state.data = data + 2;
+  state.size = size - 2;
+  state.position = 0;
+  state.bitBuffer = 0;
+  state.bitCount = 0;
+  state.error = false;
+
+  output.clear();
+  output.reserve(expectedSize);
+
+  do {
+    last = GetBits(state, 1);
+    type = GetBits(state, 2);
+    if (state.error) {
+      return false;
+    }
+
+    if (type == 0) {
+      // Stored block: skip to the next byte and copy it as it is.
+      state.bitBuffer = 0;
+      state.bitCount = 0;
+      if (state.position + 4 > state.size) {
+        return false;
+      }
+      length = state.data[state.position] |
+               (state.data[state.position + 1] << 8);
+      if ((length ^ 0xffff) != (unsigned int)(state.data[state.position + 2] |
+                                              (state.data[state.position + 3]
+                                               << 8))) {
+        return false;
+      }
+      state.position += 4;
+      if (state.position + length > state.size ||
+          length > expectedSize - output.size()) {
+        return false;
+      }
+      output.insert(output.end(), state.data + state.position,
+                    state.data + state.position + length);
+      state.position += length;
+    } else if (type == 1) {
+      if (!InflateFixed(state, expectedSize, output)) {
+        return false;
+      }
+    } else if (type == 2) {
+      if (!InflateDynamic(state, expectedSize, output)) {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  } while (!last);
+
+  return true;
+}
+
+unsigned int ReadBigEndian(const unsigned char *data) {
+  return ((unsigned int)data[0] << 24) | ((unsigned int)data[1] << 16) |
+         ((unsigned int)data[2] << 8) | (unsigned int)data[3];
+}
+
+int Paeth(int a, int b, int c) {
+  int p, pa, pb, pc;
+
+  p = a + b - c;
+  pa = abs(p - a);
+  pb = abs(p - b);
+  pc = abs(p - c);
+  if (pa <= pb && pa <= pc) {
+    return a;
+  }
+  if (pb <= pc) {
+    return b;
+  }
+  return c;
+}
+
+bool HasExtension(const char *filename, const char *extension) {
+  size_t length, extensionLength, i;
+
+  length = strlen(filename);
+  extensionLength = strlen(extension);
+  if (length < extensionLength) {
+    return false;
+  }
+  for (i = 0; i < extensionLength; i++) {
+    if (tolower((unsigned char)filename[length - extensionLength + i]) !=
+        extension[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+HeightMapClass::HeightMapClass() {
+  m_terrainWidth = 0;
+  m_terrainHeight = 0;
+  m_data = 0;
+}
+
+HeightMapClass::HeightMapClass(const HeightMapClass &other) {}
+
+HeightMapClass::~HeightMapClass() {}
+
+bool HeightMapClass::Initialize(char *filename) {
+  // Pick the loader from the file extension; anything else is a bitmap.
+  if (HasExtension(filename, ".png")) {
+    return InitializePng(filename);
+  }
+  if (HasExtension(filename, ".raw") || HasExtension(filename, ".r16")) {
+    return InitializeRaw(filename);
+  }
+
+  return InitializeBitmap(filename);
+}
+
+bool HeightMapClass::InitializeBitmap(char *filename) {
+  FILE *filePtr;
+  int error;
+  size_t count;
+  BITMAPFILEHEADER bitmapFileHeader;
+  BITMAPINFOHEADER bitmapInfoHeader;
+  int rowSize, i, j;
+  std::vector<unsigned char> row;
+
+  // Open the height map file in binary.
+  error = fopen_s(&filePtr, filename, "rb");
+  if (error != 0) {
+    return false;
+  }
+
+  // Read in the file and bitmap info headers.
+  count = fread(&bitmapFileHeader, sizeof(BITMAPFILEHEADER), 1, filePtr);
+  if (count == 1) {
+    count = fread(&bitmapInfoHeader, sizeof(BITMAPINFOHEADER), 1, filePtr);
+  }
+  if (count != 1 || bitmapInfoHeader.biBitCount != 24 ||
+      bitmapInfoHeader.biWidth < 2 || bitmapInfoHeader.biHeight < 2) {
+    fclose(filePtr);
+    return false;
+  }
+
+  // Save the dimensions of the terrain.
+  m_terrainWidth = bitmapInfoHeader.biWidth;
+  m_terrainHeight = bitmapInfoHeader.biHeight;
+
+  // Bitmap rows are padded to four bytes.
+  rowSize = (m_terrainWidth * 3 + 3) & ~3;
+  row.resize(rowSize);
+
+  // Move to the beginning of the bitmap data.
+  fseek(filePtr, bitmapFileHeader.bfOffBits, SEEK_SET);
+
+  // Bitmaps are stored bottom row first, so each row goes into the grid from
+  // the bottom up, widened to 16 bits.
+  m_samples.resize((size_t)m_terrainWidth * m_terrainHeight);
+  for (j = 0; j < m_terrainHeight; j++) {
+    count = fread(row.data(), 1, rowSize, filePtr);
+    if (count != (size_t)rowSize) {
+      fclose(filePtr);
+      return false;
+    }
+
+    for (i = 0; i < m_terrainWidth; i++) {
+      m_samples[(size_t)m_terrainWidth * (m_terrainHeight - 1 - j) + i] =
+          (unsigned short)(row[i * 3] * 257);
+    }
+  }
+
+  // Close the file.
+  error = fclose(filePtr);
+  if (error != 0) {
+    return false;
+  }
+
+  m_data = m_samples.data();
+
+  return true;
+}
+
+bool HeightMapClass::InitializePng(char *filename) {
+  bool result;
+
+  // Map the file so it can be decoded in place.
+  result = m_File.Initialize(filename);
+  if (!result) {
+    return false;
+  }
+
+  result = DecodePng(m_File.GetData(), m_File.GetSize(), m_terrainWidth,
+                     m_terrainHeight, m_samples);
+
+  // The decoded samples don't need the file any more.
+  m_File.Shutdown();
+
+  if (!result) {
+    return false;
+  }
+
+  m_data = m_samples.data();
+
+  return true;
+}
+
+bool HeightMapClass::InitializeRaw(char *filename) {
+  size_t sampleCount;
+  int size;
+  bool result;
+
+  // Map the file; its samples are read straight from the view.
+  result = m_File.Initialize(filename);
+  if (!result) {
+    return false;
+  }
+
+  // A RAW file has no header, so it has to be a square of 16-bit samples.
+  sampleCount = m_File.GetSize() / 2;
+  size = (int)sqrt((double)sampleCount);
+  while ((size_t)size * size > sampleCount) {
+    size--;
+  }
+  while ((size_t)(size + 1) * (size + 1) <= sampleCount) {
+    size++;
+  }
+  if ((m_File.GetSize() % 2 != 0) || ((size_t)size * size != sampleCount) ||
+      (size < 2)) {
+    m_File.Shutdown();
+    return false;
+  }
+
+  // The samples are little endian like the processor, and the view is page
+  // aligned.
+  m_terrainWidth = size;
+  m_terrainHeight = size;
+  m_data = (const unsigned short *)m_File.GetData();
+
+  return true;
+}
+
+void HeightMapClass::Shutdown() {
+  // Release the samples and any mapped file.
+  std::vector<unsigned short>().swap(m_samples);
+  m_File.Shutdown();
+  m_data = 0;
+  m_terrainWidth = 0;
+  m_terrainHeight = 0;
+
+  return;
+}
+
+int HeightMapClass::GetTerrainWidth() { return m_terrainWidth; }
+
+int HeightMapClass::GetTerrainHeight() { return m_terrainHeight; }
+
+unsigned short HeightMapClass::GetSample(int x, int z) {
+  // Rows are stored top row first like an image, and z grows upwards.
+  return m_data[(size_t)m_terrainWidth * (m_terrainHeight - 1 - z) + x];
+}
+
+float HeightMapClass::GetHeight(int x, int z) {
+  return (float)GetSample(x, z) * HEIGHT_MAP_SAMPLE_SCALE;
+}
+
+bool HeightMapClass::DecodePng(const unsigned char *data, size_t size,
+                               int &width, int &height,
+                               std::vector<unsigned short> &samples) {
+  const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+  std::vector<unsigned char> compressed, pixels;
+  unsigned int length;
+  int bitDepth, bytesPerSample, stride, i, j, left, up, upLeft;
+  size_t position, expectedSize;
+  unsigned char *row, *previous, filter;
+  bool header;
+
+  if (size < 8 || memcmp(data, signature, 8) != 0) {
+    return false;
+  }
+
+  // Walk the chunks: the header, the image data and the end.
+  header = false;
+  bitDepth = 0;
+  position = 8;
+  for (;;) {
+    if (position + 12 > size) {
+      return false;
+    }
+    length = ReadBigEndian(data + position);
+    if (length > size - position - 12) {
+      return false;
+    }
+
+    if (memcmp(data + position + 4, "IHDR", 4) == 0) {
+      // Only single channel images that are not interlaced are height maps.
+      if (length != 13) {
+        return false;
+      }
+      width = (int)ReadBigEndian(data + position + 8);
+      height = (int)ReadBigEndian(data + position + 12);
+      bitDepth = data[position + 16];
+      if ((width < 2) || (height < 2) || (width > 65536) || (height > 65536) ||
+          (bitDepth != 8 && bitDepth != 16) || (data[position + 17] != 0) ||
+          (data[position + 18] != 0) || (data[position + 19] != 0) ||
+          (data[position + 20] != 0)) {
+        return false;
+      }
+      header = true;
+    } else if (memcmp(data + position + 4, "IDAT", 4) == 0) {
+      compressed.insert(compressed.end(), data + position + 8,
+                        data + position + 8 + length);
+    } else if (memcmp(data + position + 4, "IEND", 4) == 0) {
+      break;
+    }
+
+    position += 12 + length;
+  }
+  if (!header) {
+    return false;
+  }
+
+  // Every row starts with its filter type.
+  bytesPerSample = bitDepth / 8;
+  stride = width * bytesPerSample;
+  expectedSize = (size_t)height * (stride + 1);
+  if (!Inflate(compressed.data(), compressed.size(), expectedSize, pixels) ||
+      pixels.size() != expectedSize) {
+    return false;
+  }
+  std::vector<unsigned char>().swap(compressed);
+
+  // Undo the filters in place, row by row.
+  previous = 0;
+  for (j = 0; j < height; j++) {
+    filter = pixels[(size_t)j * (stride + 1)];
+    row = &pixels[(size_t)j * (stride + 1) + 1];
+    for (i = 0; i < stride; i++) {
+      left = (i >= bytesPerSample) ? row[i - bytesPerSample] : 0;
+      up = previous ? previous[i] : 0;
+      upLeft = (previous && i >= bytesPerSample) ? previous[i - bytesPerSample]
+                                                 : 0;
+      switch (filter) {
+      case 0:
+        break;
+      case 1:
+        row[i] = (unsigned char)(row[i] + left);
+        break;
+      case 2:
+        row[i] = (unsigned char)(row[i] + up);
+        break;
+      case 3:
+        row[i] = (unsigned char)(row[i] + ((left + up) >> 1));
+        break;
+      case 4:
+        row[i] = (unsigned char)(row[i] + Paeth(left, up, upLeft));
+        break;
+      default:
+        return false;
+      }
+    }
+    previous = row;
+  }
+
+  // Store the samples, widening 8-bit ones to the full 16-bit range.
+  samples.resize((size_t)width * height);
+  for (j = 0; j < height; j++) {
+    row = &pixels[(size_t)j * (stride + 1) + 1];
+    for (i = 0; i < width; i++) {
+      if (bytesPerSample == 2) {
+        samples[(size_t)width * j + i] =
+            (unsigned short)((row[i * 2] << 8) | row[i * 2 + 1]);
+      } else {
+        samples[(size_t)width * j + i] = (unsigned short)(row[i] * 257);
+      }
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,60 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: heightmapclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _HEIGHTMAPCLASS_H_
+#define _HEIGHTMAPCLASS_H_
+
+/////////////
+// GLOBALS //
+/////////////
+// 16-bit samples span the 0 to 255 range of the 8-bit height maps, so a
+// sample of 257 * v is a height of v whatever the file format.
+const float HEIGHT_MAP_SAMPLE_SCALE = 1.0f / 257.0f;
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "mappedfileclass.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: HeightMapClass
+//
+// A height map as a grid of 16-bit samples, row by row along x, with x and
+// z following from the position in the grid. Loads 24-bit bitmaps (the
+// first channel, as the tutorials always have), 8 and 16-bit grayscale PNGs,
+// and square 16-bit little endian RAW files. RAW files are memory mapped and
+// read in place without a copy.
+////////////////////////////////////////////////////////////////////////////////
+class HeightMapClass {
+public:
+  HeightMapClass();
+  HeightMapClass(const HeightMapClass &);
+  ~HeightMapClass();
+
+  bool Initialize(char *);
+  bool InitializeBitmap(char *);
+  bool InitializePng(char *);
+  bool InitializeRaw(char *);
+  void Shutdown();
+
+  int GetTerrainWidth();
+  int GetTerrainHeight();
+  unsigned short GetSample(int, int);
+  float GetHeight(int, int);
+
+  static bool DecodePng(const unsigned char *, size_t, int &, int &,
+                        std::vector<unsigned short> &);
+
+private:
+  int m_terrainWidth, m_terrainHeight;
+  std::vector<unsigned short> m_samples;
+  const unsigned short *m_data;
+  MappedFileClass m_File;
+};
+
+#endif
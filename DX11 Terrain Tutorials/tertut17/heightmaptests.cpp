@@ -0,0 +1,533 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: heightmaptests.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "heightmaptests.h"
+
+#include "heightmapclass.h"
+
+#include <windows.h>
+
+#include <exception>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+// 24 x 16 16-bit grayscale PNG, compressed with dynamic Huffman codes, with
+// row r filtered with filter type r % 5 and split over two IDAT chunks.
+// Sample (x, r) is Sample16(x, r).
+const unsigned char PNG_16_BIT_DYNAMIC[624] = {
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d,
+    0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x10,
+    0x10, 0x00, 0x00, 0x00, 0x00, 0x79, 0xdf, 0x3c, 0x0a, 0x00, 0x00, 0x01,
+    0x15, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x55, 0x92, 0x4d, 0x68, 0x13,
+    0x51, 0x10, 0xc7, 0x77, 0xdf, 0xcc, 0xda, 0x52, 0xab, 0x96, 0x34, 0x28,
+    0xae, 0x36, 0x56, 0x8c, 0x69, 0x55, 0xac, 0xd6, 0x8f, 0xd0, 0x56, 0x5b,
+    0xd7, 0x52, 0xaa, 0x86, 0xa5, 0x0d, 0x4b, 0x2a, 0x2b, 0x2e, 0x56, 0xfc,
+    0xc0, 0x10, 0x6b, 0xa8, 0x52, 0x4a, 0xc0, 0x83, 0x0d, 0x2e, 0xad, 0xe4,
+    0x20, 0x39, 0x15, 0x2f, 0x42, 0x10, 0x4f, 0x92, 0xc3, 0x1e, 0x4a, 0xb0,
+    0xb0, 0xa7, 0xc5, 0x83, 0x07, 0x69, 0x7b, 0x92, 0x9e, 0x8a, 0x27, 0x59,
+    0x28, 0x04, 0x11, 0x0f, 0x39, 0x78, 0x70, 0xde, 0xee, 0x86, 0x8d, 0x0c,
+    0x6f, 0xdf, 0xfb, 0xbd, 0xff, 0x30, 0x8f, 0xff, 0xcc, 0x0a, 0x82, 0x00,
+    0x6e, 0xdb, 0xd6, 0xde, 0xcf, 0x07, 0x2a, 0xdd, 0x6f, 0x0e, 0xcd, 0x1f,
+    0xd1, 0x8f, 0x29, 0x27, 0xfa, 0xfb, 0xba, 0x4e, 0x37, 0x06, 0x7e, 0x5c,
+    0xf8, 0x9a, 0xb4, 0x46, 0xde, 0x8d, 0x2d, 0x8d, 0x67, 0x27, 0xd3, 0xa9,
+    0xa1, 0xa9, 0x5e, 0xad, 0x7d, 0xe6, 0xd7, 0x9d, 0x6d, 0x91, 0xd9, 0x28,
+    0xa3, 0x2c, 0xc9, 0xe8, 0x05, 0xd8, 0x28, 0x87, 0xd1, 0x4a, 0x92, 0xec,
+    0x67, 0x32, 0xb0, 0xa1, 0x8e, 0xbd, 0xa0, 0xb1, 0x04, 0xd3, 0x59, 0x89,
+    0x11, 0x41, 0x40, 0x50, 0x02, 0x8f, 0x90, 0x08, 0x48, 0x0b, 0x32, 0xf7,
+    0x34, 0x30, 0x89, 0x9b, 0xd0, 0x81, 0x45, 0xb8, 0x8a, 0x26, 0x5d, 0xd5,
+    0x70, 0x1a, 0x3a, 0xa4, 0x22, 0xc9, 0x26, 0xe4, 0x3d, 0x2a, 0xa1, 0x18,
+    0x68, 0x94, 0x89, 0x54, 0xd3, 0x12, 0x1d, 0xb0, 0x58, 0x02, 0x2d, 0xaa,
+    0xa2, 0xb1, 0x3a, 0xd3, 0xe0, 0x05, 0xfb, 0x08, 0x16, 0x68, 0x14, 0x75,
+    0xe6, 0xf0, 0xf7, 0xb8, 0x46, 0xf7, 0x94, 0x29, 0xec, 0xab, 0x46, 0xde,
+    0x1e, 0x8c, 0x1c, 0x5e, 0x8d, 0x15, 0x8e, 0xff, 0x3d, 0xb9, 0x74, 0x0a,
+    0xcf, 0xfe, 0x1c, 0xcc, 0x5d, 0xaa, 0x0f, 0x6f, 0x8d, 0x66, 0x94, 0xed,
+    0x09, 0xe3, 0xd6, 0x98, 0xea, 0xa4, 0x1b, 0x11, 0x7f, 0xf2, 0x00, 0x00,
+    0x01, 0x16, 0x49, 0x44, 0x41, 0x54, 0x27, 0x67, 0xfa, 0xf5, 0xaa, 0x71,
+    0x7e, 0x76, 0xed, 0xd1, 0x6a, 0x56, 0x16, 0xbb, 0xb2, 0x52, 0x14, 0x6b,
+    0x50, 0x43, 0x2f, 0xa0, 0xc6, 0x29, 0x64, 0x29, 0x1a, 0x2a, 0xe8, 0x69,
+    0x64, 0x9a, 0x95, 0x45, 0x87, 0xfd, 0xf1, 0x4d, 0x73, 0x62, 0x44, 0xe0,
+    0xd9, 0x64, 0xb6, 0xe8, 0x51, 0xb3, 0x05, 0x3c, 0x13, 0x3a, 0x37, 0xc0,
+    0x94, 0x7a, 0xa8, 0xc6, 0x26, 0xba, 0x64, 0xce, 0x46, 0xc4, 0x1e, 0x32,
+    0x37, 0x8d, 0xd9, 0x56, 0x92, 0x88, 0xa8, 0xad, 0x26, 0xbe, 0x47, 0xea,
+    0x86, 0x4a, 0x8d, 0x54, 0xc9, 0xac, 0xca, 0xbf, 0x44, 0x23, 0xc1, 0xae,
+    0x82, 0x47, 0x48, 0x3b, 0xbd, 0xae, 0xd2, 0x0b, 0xc4, 0x02, 0xcd, 0xf6,
+    0x7b, 0x3c, 0xd3, 0xb7, 0x70, 0xe6, 0xf7, 0xb9, 0xc8, 0xc5, 0x72, 0xd2,
+    0xba, 0x32, 0x70, 0xad, 0x3a, 0xfe, 0xed, 0x46, 0x2a, 0x95, 0x9b, 0x72,
+    0xb5, 0xf6, 0xdb, 0xcb, 0x77, 0xf1, 0x5e, 0xfc, 0xc1, 0x87, 0xc7, 0x4e,
+    0x4e, 0x79, 0x76, 0xff, 0xf9, 0xce, 0xa2, 0x21, 0xc6, 0xa2, 0x68, 0xa1,
+    0xd6, 0x5c, 0xa0, 0x49, 0x56, 0xb8, 0xfe, 0x27, 0x3f, 0x83, 0xf9, 0xb3,
+    0x25, 0x9b, 0x66, 0x73, 0x9a, 0x3e, 0xb1, 0x16, 0x42, 0x93, 0x9b, 0x0e,
+    0xfe, 0x82, 0xee, 0x38, 0x8a, 0xb8, 0x4b, 0x73, 0xcc, 0x43, 0x1b, 0x56,
+    0x60, 0x1d, 0x8b, 0x44, 0x88, 0x79, 0x58, 0xc1, 0x0a, 0xae, 0x93, 0xf6,
+    0x14, 0xf8, 0x8c, 0x57, 0xc0, 0xa7, 0x5d, 0x32, 0xcd, 0x5c, 0x0a, 0xde,
+    0xba, 0xfd, 0x4c, 0x09, 0x09, 0x74, 0xa0, 0x93, 0xe8, 0x8a, 0x05, 0x62,
+    0xd2, 0xa8, 0xad, 0x5c, 0x71, 0x05, 0x9a, 0x6d, 0x6c, 0x70, 0xe8, 0xb2,
+    0x36, 0x3c, 0x37, 0xba, 0x7c, 0xbd, 0x32, 0x61, 0xdc, 0x5c, 0x54, 0xcb,
+    0xe9, 0x4f, 0x99, 0x2f, 0xfa, 0x8e, 0xd1, 0x98, 0x5d, 0x7b, 0xb8, 0xf1,
+    0xc4, 0x9d, 0x63, 0xf3, 0x47, 0x17, 0x92, 0x85, 0xf4, 0xcb, 0xce, 0x57,
+    0x89, 0xd7, 0xca, 0x3f, 0x20, 0xab, 0xd9, 0xa3, 0x4d, 0x9b, 0x7e, 0x75,
+    0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82};
+
+// 11 x 7 8-bit grayscale PNG compressed with the fixed Huffman codes, rows
+// filtered the same way. Sample (x, r) is Sample8(x, r).
+const unsigned char PNG_8_BIT_FIXED[140] = {
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d,
+    0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x00, 0x00, 0x07,
+    0x08, 0x00, 0x00, 0x00, 0x00, 0xfb, 0x05, 0xe8, 0x81, 0x00, 0x00, 0x00,
+    0x23, 0x49, 0x44, 0x41, 0x54, 0x78, 0x01, 0x63, 0x60, 0x50, 0xf3, 0x29,
+    0x9a, 0xb1, 0xef, 0x09, 0x97, 0x41, 0x58, 0x0d, 0x23, 0x8f, 0x8a, 0x06,
+    0x0c, 0x32, 0xf1, 0xf0, 0x71, 0x70, 0x41, 0x31, 0xb3, 0x84, 0xb8, 0x84,
+    0xb8, 0x0c, 0x04, 0xb3, 0xbc, 0xeb, 0x1a, 0x68, 0x00, 0x00, 0x00, 0x24,
+    0x49, 0x44, 0x41, 0x54, 0xf0, 0xf0, 0x09, 0x08, 0xb1, 0xb0, 0x81, 0xc4,
+    0x05, 0x18, 0x6c, 0x12, 0x3a, 0xd6, 0x9c, 0xf9, 0x20, 0x61, 0x93, 0x33,
+    0x61, 0x07, 0xa3, 0x87, 0x9a, 0x12, 0x18, 0x1a, 0xa9, 0x29, 0x01, 0x00,
+    0x6c, 0x5a, 0x0f, 0x19, 0x6b, 0xeb, 0x51, 0xbf, 0x00, 0x00, 0x00, 0x00,
+    0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82};
+
+unsigned short Sample16(int x, int row) {
+  return (unsigned short)(x * 1000 + row * 700 + ((x * row) % 7) * 50);
+}
+
+unsigned char Sample8(int x, int row) {
+  return (unsigned char)((x * 37 + row * 11 + (x ^ row)) & 255);
+}
+
+void AppendBigEndian(std::vector<unsigned char> &data, unsigned int value) {
+  data.push_back((unsigned char)(value >> 24));
+  data.push_back((unsigned char)(value >> 16));
+  data.push_back((unsigned char)(value >> 8));
+  data.push_back((unsigned char)value);
+}
+
+void AppendChunk(std::vector<unsigned char> &data, const char *type,
+                 const std::vector<unsigned char> &contents) {
+  AppendBigEndian(data, (unsigned int)contents.size());
+  data.insert(data.end(), type, type + 4);
+  data.insert(data.end(), contents.begin(), contents.end());
+
+  // The decoder does not check the CRC.
+  AppendBigEndian(data, 0);
+}
+
+// A 16-bit grayscale PNG with unfiltered rows in stored deflate blocks of
+// at most blockSize bytes.
+std::vector<unsigned char> MakeStoredPng(int width, int height,
+                                         const std::vector<unsigned short> &
+                                             samples,
+                                         size_t blockSize) {
+  const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+  std::vector<unsigned char> png(signature, signature + 8);
+  std::vector<unsigned char> header, raw, compressed;
+  size_t position, length;
+
+  AppendBigEndian(header, (unsigned int)width);
+  AppendBigEndian(header, (unsigned int)height);
+  header.push_back(16);
+  header.push_back(0);
+  header.push_back(0);
+  header.push_back(0);
+  header.push_back(0);
+  AppendChunk(png, "IHDR", header);
+
+  for (int j = 0; j < height; j++) {
+    raw.push_back(0);
+    for (int i = 0; i < width; i++) {
+      raw.push_back((unsigned char)(samples[(size_t)width * j + i] >> 8));
+      raw.push_back((unsigned char)samples[(size_t)width * j + i]);
+    }
+  }
+
+  compressed.push_back(0x78);
+  compressed.push_back(0x01);
+  for (position = 0; position < raw.size(); position += length) {
+    length = raw.size() - position;
+    if (length > blockSize) {
+      length = blockSize;
+    }
+    compressed.push_back(position + length == raw.size() ? 1 : 0);
+    compressed.push_back((unsigned char)length);
+    compressed.push_back((unsigned char)(length >> 8));
+    compressed.push_back((unsigned char)~length);
+    compressed.push_back((unsigned char)(~length >> 8));
+    compressed.insert(compressed.end(), raw.begin() + position,
+                      raw.begin() + position + length);
+  }
+  compressed.insert(compressed.end(), 4, 0);
+  AppendChunk(png, "IDAT", compressed);
+  AppendChunk(png, "IEND", std::vector<unsigned char>());
+
+  return png;
+}
+
+// A 4x4 8-bit grayscale PNG whose single fixed Huffman block expands to
+// about 1 MB: one literal followed by copies of the maximum length.
+std::vector<unsigned char> MakeOversizePng() {
+  const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+  std::vector<unsigned char> png(signature, signature + 8);
+  std::vector<unsigned char> header, compressed;
+  unsigned int bits = 0;
+  int count = 0;
+
+  AppendBigEndian(header, 4);
+  AppendBigEndian(header, 4);
+  header.push_back(8);
+  header.insert(header.end(), 4, 0);
+  AppendChunk(png, "IHDR", header);
+
+  // Huffman codes are packed starting with their most significant bit.
+  auto putCode = [&](unsigned int code, int length) {
+    for (int i = length - 1; i >= 0; i--) {
+      bits |= ((code >> i) & 1) << count;
+      if (++count == 8) {
+        compressed.push_back((unsigned char)bits);
+        bits = 0;
+        count = 0;
+      }
+    }
+  };
+
+  compressed.push_back(0x78);
+  compressed.push_back(0x01);
+  putCode(1, 1);
+  putCode(2, 2);
+  putCode(0x30, 8);
+  for (int i = 0; i < 4096; i++) {
+    putCode(0xc5, 8);
+    putCode(0, 5);
+  }
+  putCode(0, 7);
+  compressed.push_back((unsigned char)bits);
+  compressed.insert(compressed.end(), 4, 0);
+  AppendChunk(png, "IDAT", compressed);
+  AppendChunk(png, "IEND", std::vector<unsigned char>());
+
+  return png;
+}
+
+bool WriteFile(const char *filename, const std::vector<unsigned char> &data) {
+  FILE *file;
+  size_t count;
+
+  if (fopen_s(&file, filename, "wb") != 0) {
+    return false;
+  }
+  count = fwrite(data.data(), 1, data.size(), file);
+  fclose(file);
+  return count == data.size();
+}
+
+// Little endian 16-bit samples, top row first.
+std::vector<unsigned char> MakeRaw(int size) {
+  std::vector<unsigned char> data;
+  for (int j = 0; j < size; j++) {
+    for (int i = 0; i < size; i++) {
+      const unsigned short sample = (unsigned short)(i * 131 + j * 257);
+      data.push_back((unsigned char)sample);
+      data.push_back((unsigned char)(sample >> 8));
+    }
+  }
+  return data;
+}
+
+unsigned short RawSample(int x, int z, int size) {
+  const int row = size - 1 - z;
+  return (unsigned short)(x * 131 + row * 257);
+}
+
+bool TestDynamicPng(std::string &message) {
+  std::vector<unsigned short> samples;
+  int width, height;
+
+  if (!HeightMapClass::DecodePng(PNG_16_BIT_DYNAMIC,
+                                 sizeof(PNG_16_BIT_DYNAMIC), width, height,
+                                 samples)) {
+    message = "decode failed";
+    return false;
+  }
+  if (width != 24 || height != 16) {
+    message = "wrong size";
+    return false;
+  }
+  for (int j = 0; j < height; j++) {
+    for (int i = 0; i < width; i++) {
+      if (samples[(size_t)width * j + i] != Sample16(i, j)) {
+        message = "wrong sample at " + std::to_string(i) + ", " +
+                  std::to_string(j);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool TestFixedPng(std::string &message) {
+  std::vector<unsigned short> samples;
+  int width, height;
+
+  if (!HeightMapClass::DecodePng(PNG_8_BIT_FIXED, sizeof(PNG_8_BIT_FIXED),
+                                 width, height, samples)) {
+    message = "decode failed";
+    return false;
+  }
+  if (width != 11 || height != 7) {
+    message = "wrong size";
+    return false;
+  }
+
+  // 8-bit samples are widened to the full 16-bit range.
+  for (int j = 0; j < height; j++) {
+    for (int i = 0; i < width; i++) {
+      if (samples[(size_t)width * j + i] != Sample8(i, j) * 257) {
+        message = "wrong sample at " + std::to_string(i) + ", " +
+                  std::to_string(j);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool TestCorruptPng(std::string &message) {
+  std::vector<unsigned char> png(PNG_16_BIT_DYNAMIC,
+                                 PNG_16_BIT_DYNAMIC +
+                                     sizeof(PNG_16_BIT_DYNAMIC));
+  std::vector<unsigned short> samples;
+  int width, height;
+
+  // Every truncation fails cleanly.
+  for (size_t size = 0; size < png.size() - 12; size += 7) {
+    if (HeightMapClass::DecodePng(png.data(), size, width, height, samples)) {
+      message = "truncated PNG decoded";
+      return false;
+    }
+  }
+
+  // Flipping bits in the compressed data must not crash.
+  for (size_t i = 45; i < png.size() - 12; i += 3) {
+    png[i] ^= 0x5a;
+    HeightMapClass::DecodePng(png.data(), png.size(), width, height, samples);
+    png[i] ^= 0x5a;
+  }
+
+  // A block that expands past the image is rejected.
+  const std::vector<unsigned char> oversize = MakeOversizePng();
+  if (HeightMapClass::DecodePng(oversize.data(), oversize.size(), width,
+                                height, samples)) {
+    message = "oversize PNG decoded";
+    return false;
+  }
+
+  // Color images are not height maps.
+  png[25] = 2;
+  if (HeightMapClass::DecodePng(png.data(), png.size(), width, height,
+                                samples)) {
+    message = "color PNG decoded";
+    return false;
+  }
+  return true;
+}
+
+bool TestPngFile(std::string &message) {
+  const int width = 300;
+  const int height = 200;
+  char filename[] = "heightmaptests.png";
+  std::vector<unsigned short> samples((size_t)width * height);
+  HeightMapClass heightMap;
+  bool passed;
+
+  for (size_t i = 0; i < samples.size(); i++) {
+    samples[i] = (unsigned short)(i * 2654435761u >> 16);
+  }
+
+  // Stored blocks that split rows, through the file loader.
+  if (!WriteFile(filename, MakeStoredPng(width, height, samples, 1000))) {
+    message = "could not write the test file";
+    return false;
+  }
+  passed = heightMap.Initialize(filename);
+  if (!passed) {
+    message = "load failed";
+  }
+
+  // The top row of the image is the far edge of the terrain.
+  if (passed && (heightMap.GetTerrainWidth() != width ||
+                 heightMap.GetTerrainHeight() != height)) {
+    message = "wrong size";
+    passed = false;
+  }
+  for (int z = 0; passed && z < height; z++) {
+    for (int x = 0; x < width; x++) {
+      if (heightMap.GetSample(x, z) !=
+          samples[(size_t)width * (height - 1 - z) + x]) {
+        message = "wrong sample";
+        passed = false;
+        break;
+      }
+    }
+  }
+
+  heightMap.Shutdown();
+  remove(filename);
+  return passed;
+}
+
+bool TestRawFile(std::string &message) {
+  const int size = 129;
+  char filename[] = "heightmaptests.r16";
+  std::vector<unsigned char> data = MakeRaw(size);
+  HeightMapClass heightMap;
+  bool passed;
+
+  if (!WriteFile(filename, data)) {
+    message = "could not write the test file";
+    return false;
+  }
+  passed = heightMap.Initialize(filename);
+  if (!passed) {
+    message = "load failed";
+  }
+  if (passed && (heightMap.GetTerrainWidth() != size ||
+                 heightMap.GetTerrainHeight() != size)) {
+    message = "wrong size";
+    passed = false;
+  }
+  for (int z = 0; passed && z < size; z++) {
+    for (int x = 0; x < size; x++) {
+      if (heightMap.GetSample(x, z) != RawSample(x, z, size) ||
+          heightMap.GetHeight(x, z) !=
+              RawSample(x, z, size) * HEIGHT_MAP_SAMPLE_SCALE) {
+        message = "wrong sample";
+        passed = false;
+        break;
+      }
+    }
+  }
+  heightMap.Shutdown();
+
+  // A RAW file that is not a square of samples is rejected.
+  data.resize(data.size() - 2);
+  if (passed && WriteFile(filename, data) && heightMap.Initialize(filename)) {
+    message = "non-square RAW file loaded";
+    heightMap.Shutdown();
+    passed = false;
+  }
+
+  remove(filename);
+  return passed;
+}
+
+bool TestBitmapFile(std::string &message) {
+  const int width = 5;
+  const int height = 3;
+  char filename[] = "heightmaptests.bmp";
+  BITMAPFILEHEADER fileHeader = {};
+  BITMAPINFOHEADER infoHeader = {};
+  std::vector<unsigned char> data;
+  const int rowSize = (width * 3 + 3) & ~3;
+  HeightMapClass heightMap;
+  bool passed;
+
+  fileHeader.bfType = 0x4d42;
+  fileHeader.bfOffBits = sizeof(fileHeader) + sizeof(infoHeader);
+  infoHeader.biSize = sizeof(infoHeader);
+  infoHeader.biWidth = width;
+  infoHeader.biHeight = height;
+  infoHeader.biPlanes = 1;
+  infoHeader.biBitCount = 24;
+  data.insert(data.end(), (unsigned char *)&fileHeader,
+              (unsigned char *)&fileHeader + sizeof(fileHeader));
+  data.insert(data.end(), (unsigned char *)&infoHeader,
+              (unsigned char *)&infoHeader + sizeof(infoHeader));
+
+  // Rows are stored bottom first and padded to four bytes.
+  for (int j = 0; j < height; j++) {
+    for (int i = 0; i < rowSize; i++) {
+      data.push_back((unsigned char)(i < width * 3 ? (j * 50 + i * 7) : 0));
+    }
+  }
+  if (!WriteFile(filename, data)) {
+    message = "could not write the test file";
+    return false;
+  }
+
+  // Heights are the first byte of each pixel, exactly as before.
+  passed = heightMap.Initialize(filename);
+  if (!passed) {
+    message = "load failed";
+  }
+  for (int z = 0; passed && z < height; z++) {
+    for (int x = 0; x < width; x++) {
+      if (heightMap.GetHeight(x, z) != (float)(z * 50 + x * 21)) {
+        message = "wrong height";
+        passed = false;
+        break;
+      }
+    }
+  }
+
+  heightMap.Shutdown();
+  remove(filename);
+  return passed;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(6);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("16-bit PNG with dynamic codes", TestDynamicPng);
+  run("8-bit PNG with fixed codes", TestFixedPng);
+  run("Corrupt PNGs are rejected", TestCorruptPng);
+  run("PNG file", TestPngFile);
+  run("RAW file", TestRawFile);
+  run("Bitmap file", TestBitmapFile);
+
+  return results;
+}
+
+} // namespace
+
+bool RunHeightMapTests() {
+  const std::vector<TestCaseResult> results = RunAllTestsInternal();
+  bool allPassed = true;
+  std::string line;
+
+  for (const TestCaseResult &result : results) {
+    if (!result.passed) {
+      allPassed = false;
+      line = "HeightMapTests: Test failed: " + result.name;
+      if (!result.message.empty()) {
+        line += " - " + result.message;
+      }
+      line += "\n";
+      OutputDebugStringA(line.c_str());
+    }
+  }
+
+  return allPassed;
+}
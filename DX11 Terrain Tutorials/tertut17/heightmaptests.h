@@ -0,0 +1,12 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: heightmaptests.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _HEIGHTMAPTESTS_H_
+#define _HEIGHTMAPTESTS_H_
+
+// Headless tests of HeightMapClass: PNG decoding, and bitmap and RAW files.
+// Temporary files are written to the working directory. Failures are written to the debugger output.
+// Returns false if any test fails.
+bool RunHeightMapTests();
+
+#endif
@@ -284,5 +284,15 @@ bool InputClass::IsPgDownPressed() {
     return true;
   }
 
+  return false;
+}
+
+bool InputClass::IsSpacePressed() {
+  // Do a bitwise and on the keyboard state to check if the key is currently
+  // being pressed.
+  if (m_keyboardState[DIK_SPACE] & 0x80) {
+    return true;
+  }
+
   return false;
 }
\ No newline at end of file
@@ -38,6 +38,7 @@ public:
   bool IsZPressed();
   bool IsPgUpPressed();
   bool IsPgDownPressed();
+  bool IsSpacePressed();
 
 private:
   bool ReadKeyboard();
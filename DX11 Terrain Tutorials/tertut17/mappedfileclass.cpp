@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mappedfileclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "mappedfileclass.h"
+
+#include <windows.h>
+
+MappedFileClass::MappedFileClass() {
+  m_file = 0;
+  m_mapping = 0;
+  m_data = 0;
+  m_size = 0;
+}
+
+MappedFileClass::MappedFileClass(const MappedFileClass &other) {}
+
+MappedFileClass::~MappedFileClass() {}
+
+bool MappedFileClass::Initialize(const char *filename) {
+  HANDLE file, mapping;
+  LARGE_INTEGER size;
+  void *view;
+
+  // Open the file for reading.
+  file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                     OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  // Empty files can't be mapped, and the view has to fit the address space.
+  if (!GetFileSizeEx(file, &size) || (size.QuadPart <= 0) ||
+      ((unsigned long long)size.QuadPart > (unsigned long long)SIZE_MAX)) {
+    CloseHandle(file);
+    return false;
+  }
+
+  // Create a read-only mapping of the whole file and map a view of it.
+  mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!mapping) {
+    CloseHandle(file);
+    return false;
+  }
+
+  view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!view) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  m_file = file;
+  m_mapping = mapping;
+  m_data = (const unsigned char *)view;
+  m_size = (size_t)size.QuadPart;
+
+  return true;
+}
+
+void MappedFileClass::Shutdown() {
+  // Release the view, the mapping and the file.
+  if (m_data) {
+    UnmapViewOfFile(m_data);
+    m_data = 0;
+  }
+
+  if (m_mapping) {
+    CloseHandle(m_mapping);
+    m_mapping = 0;
+  }
+
+  if (m_file) {
+    CloseHandle(m_file);
+    m_file = 0;
+  }
+
+  m_size = 0;
+
+  return;
+}
+
+const unsigned char *MappedFileClass::GetData() { return m_data; }
+
+size_t MappedFileClass::GetSize() { return m_size; }
@@ -0,0 +1,37 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mappedfileclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MAPPEDFILECLASS_H_
+#define _MAPPEDFILECLASS_H_
+
+//////////////
+// INCLUDES //
+//////////////
+#include <stddef.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MappedFileClass
+//
+// Maps a whole file read-only into the address space, so large height maps
+// are paged in by the system as they are read instead of being copied into
+// a buffer first. The view stays valid until Shutdown.
+////////////////////////////////////////////////////////////////////////////////
+class MappedFileClass {
+public:
+  MappedFileClass();
+  MappedFileClass(const MappedFileClass &);
+  ~MappedFileClass();
+
+  bool Initialize(const char *);
+  void Shutdown();
+
+  const unsigned char *GetData();
+  size_t GetSize();
+
+private:
+  void *m_file, *m_mapping;
+  const unsigned char *m_data;
+  size_t m_size;
+};
+
+#endif
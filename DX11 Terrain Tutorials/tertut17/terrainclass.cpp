@@ -3,11 +3,15 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "terrainclass.h"
 
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
 TerrainClass::TerrainClass() {
-  m_heightMap = 0;
-  m_model = 0;
-  m_vertexBuffer = 0;
-  m_indexBuffer = 0;
+  m_terrainWidth = 0;
+  m_terrainHeight = 0;
 }
 
 TerrainClass::TerrainClass(const TerrainClass &other) {}
@@ -27,32 +31,31 @@ bool TerrainClass::Initialize(ID3D11Device *device, char *heightMapFilename,
   // Reduce the height of the height map.
   ReduceHeightMap(maximumHeight);
 
-  // Calculate the normals for the terrain data.
-  result = CalculateNormals();
+  // Calculate the normals of the whole height map once; edits update them
+  // in place.
+  result = m_Normals.Initialize(m_terrainWidth, m_terrainHeight);
   if (!result) {
     return false;
   }
+  m_Normals.CalculateNormals(m_heightMap.data());
 
-  // Construct a 3D model from the height map and normal data.
-  result = BuildModel();
+  // Split the height map into chunks and create the index buffers they share.
+  result = BuildChunkLayout();
   if (!result) {
     return false;
   }
-
-  // Calculate the normal, tangent, and binormal vectors for the terrain model.
-  CalculateModelVectors();
-
-  // Initialize the vertex and index buffer that hold the geometry for the
-  // terrain.
-  result = InitializeBuffers(device);
+  result = InitializeIndexBuffers(device);
   if (!result) {
     return false;
   }
 
-  // Release the height map and the model since the data is now loaded into the
-  // vertex and index buffers.
-  ReleaseHeightMap();
-  ReleaseModel();
+  // Build the vertices of every chunk, normals and tangent frames included,
+  // create their vertex buffers and measure the error of each level of
+  // detail.
+  result = BuildChunks(device);
+  if (!result) {
+    return false;
+  }
 
   return true;
 }
@@ -61,8 +64,11 @@ void TerrainClass::Shutdown() {
   // Release the buffers.
   ReleaseBuffers();
 
-  // Release the model.
-  ReleaseModel();
+  // Release the level of detail data.
+  m_Lod.Shutdown();
+
+  // Release the normals.
+  m_Normals.Shutdown();
 
   // Release the height map.
   ReleaseHeightMap();
@@ -70,642 +76,468 @@ void TerrainClass::Shutdown() {
   return;
 }
 
-void TerrainClass::Render(ID3D11DeviceContext *deviceContext) {
-  // Put the vertex and index buffers on the graphics pipeline to prepare them
-  // for drawing.
-  RenderBuffers(deviceContext);
+void TerrainClass::Render(ID3D11DeviceContext *deviceContext,
+                          TerrainShaderClass *shader) {
+  int i;
+
+  // Draw every chunk with the shader parameters already set by the caller.
+  for (i = 0; i < (int)m_chunks.size(); i++) {
+    RenderChunk(deviceContext, i);
+    shader->RenderShader(deviceContext, GetChunkIndexCount(i));
+  }
 
   return;
 }
 
-int TerrainClass::GetIndexCount() { return m_indexCount; }
-
-bool TerrainClass::LoadHeightMap(char *filename) {
-  FILE *filePtr;
-  int error;
-  size_t count;
-  BITMAPFILEHEADER bitmapFileHeader;
-  BITMAPINFOHEADER bitmapInfoHeader;
-  int imageSize, i, j, k, index;
-  unsigned char *bitmapImage;
-  unsigned char height;
-
-  // Open the height map file in binary.
-  error = fopen_s(&filePtr, filename, "rb");
-  if (error != 0) {
-    return false;
-  }
-
-  // Read in the file header.
-  count = fread(&bitmapFileHeader, sizeof(BITMAPFILEHEADER), 1, filePtr);
-  if (count != 1) {
-    return false;
-  }
+void TerrainClass::RenderChunk(ID3D11DeviceContext *deviceContext,
+                               int chunk) {
+  unsigned int stride;
+  unsigned int offset;
 
-  // Read in the bitmap info header.
-  count = fread(&bitmapInfoHeader, sizeof(BITMAPINFOHEADER), 1, filePtr);
-  if (count != 1) {
-    return false;
-  }
+  // Set vertex buffer stride and offset.
+  stride = sizeof(VertexType);
+  offset = 0;
 
-  // Save the dimensions of the terrain.
-  m_terrainWidth = bitmapInfoHeader.biWidth;
-  m_terrainHeight = bitmapInfoHeader.biHeight;
+  // Set the chunk's vertex buffer and the index buffer for its size, level
+  // and stitched edges to active in the input assembler so they can be
+  // rendered.
+  deviceContext->IASetVertexBuffers(0, 1, &m_chunks[chunk].vertexBuffer,
+                                    &stride, &offset);
+  deviceContext->IASetIndexBuffer(
+      m_indexBuffers[GetChunkIndexBuffer(chunk)].buffer, DXGI_FORMAT_R16_UINT,
+      0);
 
-  // Calculate the size of the bitmap image data.
-  imageSize = m_terrainWidth * m_terrainHeight * 3;
+  // Set the type of primitive that should be rendered from this vertex buffer,
+  // in this case triangles.
+  deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-  // Allocate memory for the bitmap image data.
-  bitmapImage = new unsigned char[imageSize];
-  if (!bitmapImage) {
-    return false;
-  }
+  return;
+}
 
-  // Move to the beginning of the bitmap data.
-  fseek(filePtr, bitmapFileHeader.bfOffBits, SEEK_SET);
+void TerrainClass::SelectLod(float cameraX, float cameraY, float cameraZ,
+                             float projectionScale, float pixelError) {
+  // Pick the level of detail and stitched edges of every chunk.
+  m_Lod.SelectLevels(cameraX, cameraY, cameraZ, projectionScale, pixelError);
 
-  // Read in the bitmap image data.
-  count = fread(bitmapImage, 1, imageSize, filePtr);
-  if (count != imageSize) {
-    return false;
-  }
-
-  // Close the file.
-  error = fclose(filePtr);
-  if (error != 0) {
-    return false;
-  }
+  return;
+}
 
-  // Create the structure to hold the height map data.
-  m_heightMap = new HeightMapType[m_terrainWidth * m_terrainHeight];
-  if (!m_heightMap) {
+bool TerrainClass::AddCrater(ID3D11DeviceContext *deviceContext,
+                             float centerX, float centerZ, float radius,
+                             float depth) {
+  int minX, minZ, maxX, maxZ, x, z;
+  float distanceX, distanceZ, falloff;
+
+  // Find the samples under the crater, clipped to the terrain.
+  minX = (std::max)((int)ceilf(centerX - radius), 0);
+  minZ = (std::max)((int)ceilf(centerZ - radius), 0);
+  maxX = (std::min)((int)floorf(centerX + radius), m_terrainWidth - 1);
+  maxZ = (std::min)((int)floorf(centerZ + radius), m_terrainHeight - 1);
+  if (radius <= 0.0f || minX > maxX || minZ > maxZ) {
     return false;
   }
 
-  // Initialize the position in the image data buffer.
-  k = 0;
-
-  // Read the image data into the height map.
-  for (j = 0; j < m_terrainHeight; j++) {
-    for (i = 0; i < m_terrainWidth; i++) {
-      height = bitmapImage[k];
-
-      index = (m_terrainWidth * j) + i;
-
-      m_heightMap[index].x = (float)i;
-      m_heightMap[index].y = (float)height;
-      m_heightMap[index].z = (float)j;
-
-      k += 3;
+  // Push the heights down in a bowl, deepest in the middle.
+  for (z = minZ; z <= maxZ; z++) {
+    for (x = minX; x <= maxX; x++) {
+      distanceX = (float)x - centerX;
+      distanceZ = (float)z - centerZ;
+      falloff = 1.0f - (distanceX * distanceX + distanceZ * distanceZ) /
+                           (radius * radius);
+      if (falloff > 0.0f) {
+        m_heightMap[(size_t)m_terrainWidth * z + x] -= depth * falloff;
+      }
     }
   }
 
-  // Release the bitmap image data.
-  delete[] bitmapImage;
-  bitmapImage = 0;
+  // Bring the normals and the vertex buffers up to date.
+  UpdateRegion(deviceContext, minX, minZ, maxX, maxZ);
 
   return true;
 }
 
-void TerrainClass::ReduceHeightMap(float value) {
-  int i, j;
+int TerrainClass::GetIndexCount() { return m_Lod.GetTriangleCount() * 3; }
 
-  for (j = 0; j < m_terrainHeight; j++) {
-    for (i = 0; i < m_terrainWidth; i++) {
-      m_heightMap[(m_terrainWidth * j) + i].y /= value;
-    }
-  }
+int TerrainClass::GetChunkCount() { return (int)m_chunks.size(); }
+
+int TerrainClass::GetChunkIndexCount(int chunk) {
+  return m_indexBuffers[GetChunkIndexBuffer(chunk)].indexCount;
+}
 
+void TerrainClass::GetChunkBounds(int chunk, XMFLOAT3 &minBounds,
+                                  XMFLOAT3 &maxBounds) {
+  minBounds = m_chunks[chunk].minBounds;
+  maxBounds = m_chunks[chunk].maxBounds;
   return;
 }
 
-bool TerrainClass::CalculateNormals() {
-  int i, j, index1, index2, index3, index, count;
-  float vertex1[3], vertex2[3], vertex3[3], vector1[3], vector2[3], sum[3],
-      length;
-  VectorType *normals;
+bool TerrainClass::LoadHeightMap(char *filename) {
+  HeightMapClass heightMap;
+  int i, j;
+  bool result;
 
-  // Create a temporary array to hold the un-normalized normal vectors.
-  normals = new VectorType[(m_terrainHeight - 1) * (m_terrainWidth - 1)];
-  if (!normals) {
+  // Load the height map file, a bitmap, a 16-bit PNG or a 16-bit RAW file.
+  result = heightMap.Initialize(filename);
+  if (!result) {
     return false;
   }
 
-  // Go through all the faces in the mesh and calculate their normals.
-  for (j = 0; j < (m_terrainHeight - 1); j++) {
-    for (i = 0; i < (m_terrainWidth - 1); i++) {
-      index1 = (j * m_terrainWidth) + i;
-      index2 = (j * m_terrainWidth) + (i + 1);
-      index3 = ((j + 1) * m_terrainWidth) + i;
-
-      // Get three vertices from the face.
-      vertex1[0] = m_heightMap[index1].x;
-      vertex1[1] = m_heightMap[index1].y;
-      vertex1[2] = m_heightMap[index1].z;
-
-      vertex2[0] = m_heightMap[index2].x;
-      vertex2[1] = m_heightMap[index2].y;
-      vertex2[2] = m_heightMap[index2].z;
-
-      vertex3[0] = m_heightMap[index3].x;
-      vertex3[1] = m_heightMap[index3].y;
-      vertex3[2] = m_heightMap[index3].z;
-
-      // Calculate the two vectors for this face.
-      vector1[0] = vertex1[0] - vertex3[0];
-      vector1[1] = vertex1[1] - vertex3[1];
-      vector1[2] = vertex1[2] - vertex3[2];
-      vector2[0] = vertex3[0] - vertex2[0];
-      vector2[1] = vertex3[1] - vertex2[1];
-      vector2[2] = vertex3[2] - vertex2[2];
-
-      index = (j * (m_terrainWidth - 1)) + i;
-
-      // Calculate the cross product of those two vectors to get the
-      // un-normalized value for this face normal.
-      normals[index].x = (vector1[1] * vector2[2]) - (vector1[2] * vector2[1]);
-      normals[index].y = (vector1[2] * vector2[0]) - (vector1[0] * vector2[2]);
-      normals[index].z = (vector1[0] * vector2[1]) - (vector1[1] * vector2[0]);
-    }
-  }
+  // Save the dimensions of the terrain.
+  m_terrainWidth = heightMap.GetTerrainWidth();
+  m_terrainHeight = heightMap.GetTerrainHeight();
 
-  // Now go through all the vertices and take an average of each face normal
-  // that the vertex touches to get the averaged normal for that vertex.
+  // Copy the samples into the height map as floats, which only keeps the
+  // heights: x and z follow from the index.
+  m_heightMap.resize((size_t)m_terrainWidth * m_terrainHeight);
   for (j = 0; j < m_terrainHeight; j++) {
     for (i = 0; i < m_terrainWidth; i++) {
-      // Initialize the sum.
-      sum[0] = 0.0f;
-      sum[1] = 0.0f;
-      sum[2] = 0.0f;
-
-      // Initialize the count.
-      count = 0;
-
-      // Bottom left face.
-      if (((i - 1) >= 0) && ((j - 1) >= 0)) {
-        index = ((j - 1) * (m_terrainWidth - 1)) + (i - 1);
-
-        sum[0] += normals[index].x;
-        sum[1] += normals[index].y;
-        sum[2] += normals[index].z;
-        count++;
-      }
-
-      // Bottom right face.
-      if ((i < (m_terrainWidth - 1)) && ((j - 1) >= 0)) {
-        index = ((j - 1) * (m_terrainWidth - 1)) + i;
-
-        sum[0] += normals[index].x;
-        sum[1] += normals[index].y;
-        sum[2] += normals[index].z;
-        count++;
-      }
-
-      // Upper left face.
-      if (((i - 1) >= 0) && (j < (m_terrainHeight - 1))) {
-        index = (j * (m_terrainWidth - 1)) + (i - 1);
-
-        sum[0] += normals[index].x;
-        sum[1] += normals[index].y;
-        sum[2] += normals[index].z;
-        count++;
-      }
-
-      // Upper right face.
-      if ((i < (m_terrainWidth - 1)) && (j < (m_terrainHeight - 1))) {
-        index = (j * (m_terrainWidth - 1)) + i;
-
-        sum[0] += normals[index].x;
-        sum[1] += normals[index].y;
-        sum[2] += normals[index].z;
-        count++;
-      }
-
-      // Take the average of the faces touching this vertex.
-      sum[0] = (sum[0] / (float)count);
-      sum[1] = (sum[1] / (float)count);
-      sum[2] = (sum[2] / (float)count);
-
-      // Calculate the length of this normal.
-      length = sqrt((sum[0] * sum[0]) + (sum[1] * sum[1]) + (sum[2] * sum[2]));
-
-      // Get an index to the vertex location in the height map array.
-      index = (j * m_terrainWidth) + i;
-
-      // Normalize the final shared normal for this vertex and store it in the
-      // height map array.
-      m_heightMap[index].nx = (sum[0] / length);
-      m_heightMap[index].ny = (sum[1] / length);
-      m_heightMap[index].nz = (sum[2] / length);
+      m_heightMap[(size_t)m_terrainWidth * j + i] = heightMap.GetHeight(i, j);
     }
   }
 
-  // Release the temporary normals.
-  delete[] normals;
-  normals = 0;
+  // Release the height map file.
+  heightMap.Shutdown();
 
   return true;
 }
 
-bool TerrainClass::BuildModel() {
-  int i, j, index, index1, index2, index3, index4;
-  float incrementSize, tu2Left, tu2Right, tv2Top, tv2Bottom;
+void TerrainClass::ReduceHeightMap(float value) {
+  for (float &height : m_heightMap) {
+    height /= value;
+  }
 
-  // Set the number of vertices in the model.
-  m_vertexCount = (m_terrainWidth - 1) * (m_terrainHeight - 1) * 6;
+  return;
+}
 
-  // Create the terrain model array.
-  m_model = new ModelType[m_vertexCount];
-  if (!m_model) {
+bool TerrainClass::BuildChunkLayout() {
+  int chunkCount, i, j, level, mask;
+  ChunkType chunk;
+  IndexBufferType indexBuffer;
+
+  // Chunks cover TERRAIN_CHUNK_QUADS quads each way, less along the far
+  // edges; neighbours share the vertices on their common edge. The level
+  // of detail object owns the layout so its chunk numbers match ours.
+  m_chunks.clear();
+  m_indexBuffers.clear();
+  if (!m_Lod.Initialize(m_terrainWidth, m_terrainHeight,
+                        TERRAIN_CHUNK_QUADS)) {
     return false;
   }
 
-  // Setup the increment size for the second set of textures (alpha map).
-  incrementSize = 1.0f / 31.0f;
-
-  // Initialize the texture increments.
-  tu2Left = 0.0f;
-  tu2Right = incrementSize;
-  tv2Bottom = 1.0f;
-  tv2Top = 1.0f - incrementSize;
-
-  // Load the terrain model with the height map terrain data.
-  index = 0;
-
-  for (j = 0; j < (m_terrainHeight - 1); j++) {
-    for (i = 0; i < (m_terrainWidth - 1); i++) {
-      index1 = (m_terrainWidth * j) + i;             // Bottom left.
-      index2 = (m_terrainWidth * j) + (i + 1);       // Bottom right.
-      index3 = (m_terrainWidth * (j + 1)) + i;       // Upper left.
-      index4 = (m_terrainWidth * (j + 1)) + (i + 1); // Upper right.
-
-      // Upper left.
-      m_model[index].x = m_heightMap[index3].x;
-      m_model[index].y = m_heightMap[index3].y;
-      m_model[index].z = m_heightMap[index3].z;
-      m_model[index].nx = m_heightMap[index3].nx;
-      m_model[index].ny = m_heightMap[index3].ny;
-      m_model[index].nz = m_heightMap[index3].nz;
-      m_model[index].tu = 0.0f;
-      m_model[index].tv = 0.0f;
-      m_model[index].tu2 = tu2Left;
-      m_model[index].tv2 = tv2Top;
-      index++;
-
-      // Upper right.
-      m_model[index].x = m_heightMap[index4].x;
-      m_model[index].y = m_heightMap[index4].y;
-      m_model[index].z = m_heightMap[index4].z;
-      m_model[index].nx = m_heightMap[index4].nx;
-      m_model[index].ny = m_heightMap[index4].ny;
-      m_model[index].nz = m_heightMap[index4].nz;
-      m_model[index].tu = 1.0f;
-      m_model[index].tv = 0.0f;
-      m_model[index].tu2 = tu2Right;
-      m_model[index].tv2 = tv2Top;
-      index++;
-
-      // Bottom left.
-      m_model[index].x = m_heightMap[index1].x;
-      m_model[index].y = m_heightMap[index1].y;
-      m_model[index].z = m_heightMap[index1].z;
-      m_model[index].nx = m_heightMap[index1].nx;
-      m_model[index].ny = m_heightMap[index1].ny;
-      m_model[index].nz = m_heightMap[index1].nz;
-      m_model[index].tu = 0.0f;
-      m_model[index].tv = 1.0f;
-      m_model[index].tu2 = tu2Left;
-      m_model[index].tv2 = tv2Bottom;
-      index++;
-
-      // Bottom left.
-      m_model[index].x = m_heightMap[index1].x;
-      m_model[index].y = m_heightMap[index1].y;
-      m_model[index].z = m_heightMap[index1].z;
-      m_model[index].nx = m_heightMap[index1].nx;
-      m_model[index].ny = m_heightMap[index1].ny;
-      m_model[index].nz = m_heightMap[index1].nz;
-      m_model[index].tu = 0.0f;
-      m_model[index].tv = 1.0f;
-      m_model[index].tu2 = tu2Left;
-      m_model[index].tv2 = tv2Bottom;
-      index++;
-
-      // Upper right.
-      m_model[index].x = m_heightMap[index4].x;
-      m_model[index].y = m_heightMap[index4].y;
-      m_model[index].z = m_heightMap[index4].z;
-      m_model[index].nx = m_heightMap[index4].nx;
-      m_model[index].ny = m_heightMap[index4].ny;
-      m_model[index].nz = m_heightMap[index4].nz;
-      m_model[index].tu = 1.0f;
-      m_model[index].tv = 0.0f;
-      m_model[index].tu2 = tu2Right;
-      m_model[index].tv2 = tv2Top;
-      index++;
-
-      // Bottom right.
-      m_model[index].x = m_heightMap[index2].x;
-      m_model[index].y = m_heightMap[index2].y;
-      m_model[index].z = m_heightMap[index2].z;
-      m_model[index].nx = m_heightMap[index2].nx;
-      m_model[index].ny = m_heightMap[index2].ny;
-      m_model[index].nz = m_heightMap[index2].nz;
-      m_model[index].tu = 1.0f;
-      m_model[index].tv = 1.0f;
-      m_model[index].tu2 = tu2Right;
-      m_model[index].tv2 = tv2Bottom;
-      index++;
-
-      // Increment the tu texture coords for the alpha map.
-      tu2Left += incrementSize;
-      tu2Right += incrementSize;
+  chunkCount = m_Lod.GetChunkCount();
+  m_chunks.reserve(chunkCount);
+  for (i = 0; i < chunkCount; i++) {
+    m_Lod.GetChunkArea(i, chunk.startX, chunk.startZ, chunk.quadsX,
+                       chunk.quadsZ);
+    chunk.minBounds = XMFLOAT3((float)chunk.startX, 0.0f, (float)chunk.startZ);
+    chunk.maxBounds = XMFLOAT3((float)(chunk.startX + chunk.quadsX), 0.0f,
+                               (float)(chunk.startZ + chunk.quadsZ));
+    chunk.vertexBuffer = 0;
+
+    // At most four chunk sizes exist: full, right edge, far edge, corner.
+    // Each size gets an index buffer per level and stitch mask.
+    for (j = 0; j < (int)m_indexBuffers.size(); j++) {
+      if (m_indexBuffers[j].quadsX == chunk.quadsX &&
+          m_indexBuffers[j].quadsZ == chunk.quadsZ) {
+        break;
+      }
     }
+    if (j == (int)m_indexBuffers.size()) {
+      indexBuffer.quadsX = chunk.quadsX;
+      indexBuffer.quadsZ = chunk.quadsZ;
+      indexBuffer.buffer = 0;
+      for (level = 0; level < m_Lod.GetChunkLevelCount(i); level++) {
+        for (mask = 0; mask < TERRAIN_LOD_STITCH_MASKS; mask++) {
+          indexBuffer.level = level;
+          indexBuffer.stitchMask = mask;
+          indexBuffer.indexCount = 3 * TerrainLodClass::GetTriangleCount(
+                                           chunk.quadsX, chunk.quadsZ, level,
+                                           mask);
+          m_indexBuffers.push_back(indexBuffer);
+        }
+      }
+    }
+    chunk.indexBuffer = j;
 
-    // Reset the tu texture coordinate increments for the alpha map.
-    tu2Left = 0.0f;
-    tu2Right = incrementSize;
-
-    // Increment the tv texture coords for the alpha map.
-    tv2Top -= incrementSize;
-    tv2Bottom -= incrementSize;
+    m_chunks.push_back(chunk);
   }
 
   return true;
 }
 
-void TerrainClass::CalculateModelVectors() {
-  int faceCount, i, index;
-  TempVertexType vertex1, vertex2, vertex3;
-  VectorType tangent, binormal;
-
-  // Calculate the number of faces in the terrain model.
-  faceCount = m_vertexCount / 3;
-
-  // Initialize the index to the model data.
-  index = 0;
-
-  // Go through all the faces and calculate the the tangent, binormal, and
-  // normal vectors.
-  for (i = 0; i < faceCount; i++) {
-    // Get the three vertices for this face from the terrain model.
-    vertex1.x = m_model[index].x;
-    vertex1.y = m_model[index].y;
-    vertex1.z = m_model[index].z;
-    vertex1.tu = m_model[index].tu;
-    vertex1.tv = m_model[index].tv;
-    vertex1.nx = m_model[index].nx;
-    vertex1.ny = m_model[index].ny;
-    vertex1.nz = m_model[index].nz;
-    index++;
-
-    vertex2.x = m_model[index].x;
-    vertex2.y = m_model[index].y;
-    vertex2.z = m_model[index].z;
-    vertex2.tu = m_model[index].tu;
-    vertex2.tv = m_model[index].tv;
-    vertex2.nx = m_model[index].nx;
-    vertex2.ny = m_model[index].ny;
-    vertex2.nz = m_model[index].nz;
-    index++;
-
-    vertex3.x = m_model[index].x;
-    vertex3.y = m_model[index].y;
-    vertex3.z = m_model[index].z;
-    vertex3.tu = m_model[index].tu;
-    vertex3.tv = m_model[index].tv;
-    vertex3.nx = m_model[index].nx;
-    vertex3.ny = m_model[index].ny;
-    vertex3.nz = m_model[index].nz;
-    index++;
-
-    // Calculate the tangent and binormal of that face.
-    CalculateTangentBinormal(vertex1, vertex2, vertex3, tangent, binormal);
-
-    // Store the tangent and binormal for this face back in the model structure.
-    m_model[index - 1].tx = tangent.x;
-    m_model[index - 1].ty = tangent.y;
-    m_model[index - 1].tz = tangent.z;
-    m_model[index - 1].bx = binormal.x;
-    m_model[index - 1].by = binormal.y;
-    m_model[index - 1].bz = binormal.z;
-
-    m_model[index - 2].tx = tangent.x;
-    m_model[index - 2].ty = tangent.y;
-    m_model[index - 2].tz = tangent.z;
-    m_model[index - 2].bx = binormal.x;
-    m_model[index - 2].by = binormal.y;
-    m_model[index - 2].bz = binormal.z;
-
-    m_model[index - 3].tx = tangent.x;
-    m_model[index - 3].ty = tangent.y;
-    m_model[index - 3].tz = tangent.z;
-    m_model[index - 3].bx = binormal.x;
-    m_model[index - 3].by = binormal.y;
-    m_model[index - 3].bz = binormal.z;
+bool TerrainClass::InitializeIndexBuffers(ID3D11Device *device) {
+  std::vector<unsigned short> indices;
+  D3D11_BUFFER_DESC indexBufferDesc;
+  D3D11_SUBRESOURCE_DATA indexData;
+  HRESULT result;
+
+  for (IndexBufferType &indexBuffer : m_indexBuffers) {
+    // Build the indices of the chunk size at this level of detail, with
+    // the edges in the stitch mask joined to a coarser neighbour.
+    TerrainLodClass::BuildIndices(indexBuffer.quadsX, indexBuffer.quadsZ,
+                                  indexBuffer.level, indexBuffer.stitchMask,
+                                  indices);
+
+    // Set up the description of the static index buffer.
+    indexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    indexBufferDesc.ByteWidth =
+        (UINT)(sizeof(unsigned short) * indices.size());
+    indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+    indexBufferDesc.CPUAccessFlags = 0;
+    indexBufferDesc.MiscFlags = 0;
+    indexBufferDesc.StructureByteStride = 0;
+
+    // Give the subresource structure a pointer to the index data.
+    indexData.pSysMem = indices.data();
+    indexData.SysMemPitch = 0;
+    indexData.SysMemSlicePitch = 0;
+
+    // Create the index buffer.
+    result =
+        device->CreateBuffer(&indexBufferDesc, &indexData, &indexBuffer.buffer);
+    if (FAILED(result)) {
+      return false;
+    }
   }
 
-  return;
+  return true;
 }
 
-void TerrainClass::CalculateTangentBinormal(TempVertexType vertex1,
-                                            TempVertexType vertex2,
-                                            TempVertexType vertex3,
-                                            VectorType &tangent,
-                                            VectorType &binormal) {
-  float vector1[3], vector2[3];
-  float tuVector[2], tvVector[2];
-  float den;
-  float length;
-
-  // Calculate the two vectors for this face.
-  vector1[0] = vertex2.x - vertex1.x;
-  vector1[1] = vertex2.y - vertex1.y;
-  vector1[2] = vertex2.z - vertex1.z;
-
-  vector2[0] = vertex3.x - vertex1.x;
-  vector2[1] = vertex3.y - vertex1.y;
-  vector2[2] = vertex3.z - vertex1.z;
-
-  // Calculate the tu and tv texture space vectors.
-  tuVector[0] = vertex2.tu - vertex1.tu;
-  tvVector[0] = vertex2.tv - vertex1.tv;
-
-  tuVector[1] = vertex3.tu - vertex1.tu;
-  tvVector[1] = vertex3.tv - vertex1.tv;
-
-  // Calculate the denominator of the tangent/binormal equation.
-  den = 1.0f / (tuVector[0] * tvVector[1] - tuVector[1] * tvVector[0]);
-
-  // Calculate the cross products and multiply by the coefficient to get the
-  // tangent and binormal.
-  tangent.x = (tvVector[1] * vector1[0] - tvVector[0] * vector2[0]) * den;
-  tangent.y = (tvVector[1] * vector1[1] - tvVector[0] * vector2[1]) * den;
-  tangent.z = (tvVector[1] * vector1[2] - tvVector[0] * vector2[2]) * den;
-
-  binormal.x = (tuVector[0] * vector2[0] - tuVector[1] * vector1[0]) * den;
-  binormal.y = (tuVector[0] * vector2[1] - tuVector[1] * vector1[1]) * den;
-  binormal.z = (tuVector[0] * vector2[2] - tuVector[1] * vector1[2]) * den;
-
-  // Calculate the length of this normal.
-  length = sqrt((tangent.x * tangent.x) + (tangent.y * tangent.y) +
-                (tangent.z * tangent.z));
-
-  // Normalize the normal and then store it
-  tangent.x = tangent.x / length;
-  tangent.y = tangent.y / length;
-  tangent.z = tangent.z / length;
-
-  // Calculate the length of this normal.
-  length = sqrt((binormal.x * binormal.x) + (binormal.y * binormal.y) +
-                (binormal.z * binormal.z));
-
-  // Normalize the normal and then store it
-  binormal.x = binormal.x / length;
-  binormal.y = binormal.y / length;
-  binormal.z = binormal.z / length;
+bool TerrainClass::BuildChunks(ID3D11Device *device) {
+  std::atomic<bool> failed(false);
+
+  // Chunks only read the height map and each writes its own entry, so they
+  // are built in parallel. Resource creation on ID3D11Device is
+  // free-threaded, so every chunk creates its vertex buffer as soon as its
+  // vertices are ready and only a chunk's worth of vertices is alive per
+  // thread.
+  JobSystem::GetShared().ParallelFor((int)m_chunks.size(), [&](int chunk) {
+    std::vector<VertexType> vertices;
+    if (!failed && !BuildChunk(device, m_chunks[chunk], vertices)) {
+      failed = true;
+    }
+    m_Lod.CalculateChunkErrors(chunk, m_heightMap.data());
+  });
 
-  return;
+  return !failed;
 }
 
-bool TerrainClass::InitializeBuffers(ID3D11Device *device) {
-  VertexType *vertices;
-  unsigned long *indices;
-  int i;
-  D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
-  D3D11_SUBRESOURCE_DATA vertexData, indexData;
+bool TerrainClass::BuildChunk(ID3D11Device *device, ChunkType &chunk,
+                              std::vector<VertexType> &vertices) {
+  D3D11_BUFFER_DESC vertexBufferDesc;
+  D3D11_SUBRESOURCE_DATA vertexData;
   HRESULT result;
 
-  // Set the index count to the same as the vertex count.
-  m_indexCount = m_vertexCount;
-
-  // Create the vertex array.
-  vertices = new VertexType[m_vertexCount];
-  if (!vertices) {
-    return false;
-  }
-
-  // Create the index array.
-  indices = new unsigned long[m_indexCount];
-  if (!indices) {
-    return false;
-  }
+  // Load the chunk's vertices, row by row, from the height map and store
+  // the height range for culling.
+  CalculateChunkVertices(chunk, 0, chunk.quadsZ, vertices);
+  CalculateChunkBounds(chunk);
 
-  // Load the vertex and index array with data from the terrain model.
-  for (i = 0; i < m_vertexCount; i++) {
-    vertices[i].position = XMFLOAT3(m_model[i].x, m_model[i].y, m_model[i].z);
-    vertices[i].texture = XMFLOAT2(m_model[i].tu, m_model[i].tv);
-    vertices[i].normal = XMFLOAT3(m_model[i].nx, m_model[i].ny, m_model[i].nz);
-    vertices[i].tangent = XMFLOAT3(m_model[i].tx, m_model[i].ty, m_model[i].tz);
-    vertices[i].binormal =
-        XMFLOAT3(m_model[i].bx, m_model[i].by, m_model[i].bz);
-    vertices[i].texture2 = XMFLOAT2(m_model[i].tu2, m_model[i].tv2);
-
-    indices[i] = i;
-  }
-
-  // Set up the description of the static vertex buffer.
+  // Set up the description of the vertex buffer. It is not immutable so
+  // edits to the terrain can update the rows they touch.
   vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-  vertexBufferDesc.ByteWidth = sizeof(VertexType) * m_vertexCount;
+  vertexBufferDesc.ByteWidth = (UINT)(sizeof(VertexType) * vertices.size());
   vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
   vertexBufferDesc.CPUAccessFlags = 0;
   vertexBufferDesc.MiscFlags = 0;
   vertexBufferDesc.StructureByteStride = 0;
 
   // Give the subresource structure a pointer to the vertex data.
-  vertexData.pSysMem = vertices;
+  vertexData.pSysMem = vertices.data();
   vertexData.SysMemPitch = 0;
   vertexData.SysMemSlicePitch = 0;
 
   // Now create the vertex buffer.
   result =
-      device->CreateBuffer(&vertexBufferDesc, &vertexData, &m_vertexBuffer);
+      device->CreateBuffer(&vertexBufferDesc, &vertexData, &chunk.vertexBuffer);
   if (FAILED(result)) {
     return false;
   }
 
-  // Set up the description of the static index buffer.
-  indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-  indexBufferDesc.ByteWidth = sizeof(unsigned long) * m_indexCount;
-  indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-  indexBufferDesc.CPUAccessFlags = 0;
-  indexBufferDesc.MiscFlags = 0;
-  indexBufferDesc.StructureByteStride = 0;
-
-  // Give the subresource structure a pointer to the index data.
-  indexData.pSysMem = indices;
-  indexData.SysMemPitch = 0;
-  indexData.SysMemSlicePitch = 0;
-
-  // Create the index buffer.
-  result = device->CreateBuffer(&indexBufferDesc, &indexData, &m_indexBuffer);
-  if (FAILED(result)) {
-    return false;
-  }
-
-  // Release the arrays now that the buffers have been created and loaded.
-  delete[] vertices;
-  vertices = 0;
-
-  delete[] indices;
-  indices = 0;
-
   return true;
 }
 
-void TerrainClass::ReleaseHeightMap() {
-  if (m_heightMap) {
-    delete[] m_heightMap;
-    m_heightMap = 0;
+void TerrainClass::CalculateChunkVertices(const ChunkType &chunk,
+                                          int firstRow, int lastRow,
+                                          std::vector<VertexType> &vertices) {
+  int i, j, pitch;
+
+  // Rows firstRow to lastRow of the chunk, counted from its start.
+  pitch = chunk.quadsX + 1;
+  vertices.resize((size_t)pitch * (lastRow - firstRow + 1));
+  for (j = firstRow; j <= lastRow; j++) {
+    for (i = 0; i <= chunk.quadsX; i++) {
+      CalculateVertex(chunk.startX + i, chunk.startZ + j, chunk,
+                      vertices[(size_t)pitch * (j - firstRow) + i]);
+    }
   }
 
   return;
 }
 
-void TerrainClass::ReleaseModel() {
-  if (m_model) {
-    delete[] m_model;
-    m_model = 0;
+void TerrainClass::CalculateChunkBounds(ChunkType &chunk) {
+  int i, j;
+  float height, minHeight, maxHeight;
+
+  minHeight = maxHeight = GetHeight(chunk.startX, chunk.startZ);
+  for (j = 0; j <= chunk.quadsZ; j++) {
+    for (i = 0; i <= chunk.quadsX; i++) {
+      height = GetHeight(chunk.startX + i, chunk.startZ + j);
+      minHeight = (std::min)(minHeight, height);
+      maxHeight = (std::max)(maxHeight, height);
+    }
   }
 
+  chunk.minBounds.y = minHeight;
+  chunk.maxBounds.y = maxHeight;
+
   return;
 }
 
-void TerrainClass::ReleaseBuffers() {
-  // Release the index buffer.
-  if (m_indexBuffer) {
-    m_indexBuffer->Release();
-    m_indexBuffer = 0;
-  }
+void TerrainClass::UpdateRegion(ID3D11DeviceContext *deviceContext,
+                                int minX, int minZ, int maxX, int maxZ) {
+  std::vector<VertexType> vertices;
+  D3D11_BOX box;
+  int chunk, firstRow, lastRow, pitch;
+
+  // Recalculate the normals around the changed heights.
+  m_Normals.UpdateRegion(m_heightMap.data(), minX, minZ, maxX, maxZ);
+
+  // A vertex's normal and tangent frame use the heights next to it, so the
+  // vertices one sample around the changed heights change as well.
+  minX = (std::max)(minX - 1, 0);
+  minZ = (std::max)(minZ - 1, 0);
+  maxX = (std::min)(maxX + 1, m_terrainWidth - 1);
+  maxZ = (std::min)(maxZ + 1, m_terrainHeight - 1);
+
+  for (chunk = 0; chunk < (int)m_chunks.size(); chunk++) {
+    ChunkType &chunkData = m_chunks[chunk];
+    if (chunkData.startX > maxX || chunkData.startZ > maxZ ||
+        chunkData.startX + chunkData.quadsX < minX ||
+        chunkData.startZ + chunkData.quadsZ < minZ) {
+      continue;
+    }
 
-  // Release the vertex buffer.
-  if (m_vertexBuffer) {
-    m_vertexBuffer->Release();
-    m_vertexBuffer = 0;
+    // Rebuild the changed rows of the chunk, which are one contiguous range
+    // of its vertex buffer, and copy just those over.
+    firstRow = (std::max)(minZ - chunkData.startZ, 0);
+    lastRow = (std::min)(maxZ - chunkData.startZ, chunkData.quadsZ);
+    CalculateChunkVertices(chunkData, firstRow, lastRow, vertices);
+
+    pitch = chunkData.quadsX + 1;
+    box.left = (UINT)(sizeof(VertexType) * pitch * firstRow);
+    box.right = (UINT)(sizeof(VertexType) * pitch * (lastRow + 1));
+    box.top = 0;
+    box.bottom = 1;
+    box.front = 0;
+    box.back = 1;
+    deviceContext->UpdateSubresource(chunkData.vertexBuffer, 0, &box,
+                                     vertices.data(), 0, 0);
+
+    // The height range and the level of detail errors change with the
+    // heights.
+    CalculateChunkBounds(chunkData);
+    m_Lod.CalculateChunkErrors(chunk, m_heightMap.data());
   }
 
   return;
 }
 
-void TerrainClass::RenderBuffers(ID3D11DeviceContext *deviceContext) {
-  unsigned int stride;
-  unsigned int offset;
+void TerrainClass::CalculateVertex(int x, int z, const ChunkType &chunk,
+                                   VertexType &vertex) {
+  float tangent[3], binormal[3], length, dot;
+  int left, right, down, up;
+
+  vertex.position = XMFLOAT3((float)x, GetHeight(x, z), (float)z);
+
+  // The normal comes from the cache.
+  m_Normals.GetNormal(x, z, vertex.normal.x, vertex.normal.y,
+                      vertex.normal.z);
+
+  // The detail textures repeat once per quad: tu runs along +x and tv
+  // along -z. Offsets are taken from the chunk origin to keep the texture
+  // coordinates small; the sampler wraps.
+  vertex.texture =
+      XMFLOAT2((float)(x - chunk.startX), (float)(chunk.startZ - z));
+
+  // The alpha map covers the whole terrain once.
+  vertex.texture2 = XMFLOAT2((float)x / (float)(m_terrainWidth - 1),
+                             1.0f - (float)z / (float)(m_terrainHeight - 1));
+
+  // Tangent and binormal are dP/du and dP/dv from central differences of
+  // the heights, made orthonormal to the normal (Gram-Schmidt).
+  left = (std::max)(x - 1, 0);
+  right = (std::min)(x + 1, m_terrainWidth - 1);
+  down = (std::max)(z - 1, 0);
+  up = (std::min)(z + 1, m_terrainHeight - 1);
+  tangent[0] = (float)(right - left);
+  tangent[1] = GetHeight(right, z) - GetHeight(left, z);
+  tangent[2] = 0.0f;
+  binormal[0] = 0.0f;
+  binormal[1] = GetHeight(x, down) - GetHeight(x, up);
+  binormal[2] = (float)(down - up);
+
+  dot = tangent[0] * vertex.normal.x + tangent[1] * vertex.normal.y;
+  tangent[0] -= vertex.normal.x * dot;
+  tangent[1] -= vertex.normal.y * dot;
+  tangent[2] -= vertex.normal.z * dot;
+  length = sqrtf(tangent[0] * tangent[0] + tangent[1] * tangent[1] +
+                 tangent[2] * tangent[2]);
+  vertex.tangent =
+      XMFLOAT3(tangent[0] / length, tangent[1] / length, tangent[2] / length);
+
+  dot = binormal[1] * vertex.normal.y + binormal[2] * vertex.normal.z;
+  binormal[0] -= vertex.normal.x * dot;
+  binormal[1] -= vertex.normal.y * dot;
+  binormal[2] -= vertex.normal.z * dot;
+  dot = binormal[0] * vertex.tangent.x + binormal[1] * vertex.tangent.y +
+        binormal[2] * vertex.tangent.z;
+  binormal[0] -= vertex.tangent.x * dot;
+  binormal[1] -= vertex.tangent.y * dot;
+  binormal[2] -= vertex.tangent.z * dot;
+  length = sqrtf(binormal[0] * binormal[0] + binormal[1] * binormal[1] +
+                 binormal[2] * binormal[2]);
+  vertex.binormal = XMFLOAT3(binormal[0] / length, binormal[1] / length,
+                             binormal[2] / length);
 
-  // Set vertex buffer stride and offset.
-  stride = sizeof(VertexType);
-  offset = 0;
+  return;
+}
 
-  // Set the vertex buffer to active in the input assembler so it can be
-  // rendered.
-  deviceContext->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
+float TerrainClass::GetHeight(int x, int z) {
+  return m_heightMap[(size_t)m_terrainWidth * z + x];
+}
 
-  // Set the index buffer to active in the input assembler so it can be
-  // rendered.
-  deviceContext->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+int TerrainClass::GetChunkIndexBuffer(int chunk) {
+  return m_chunks[chunk].indexBuffer +
+         TERRAIN_LOD_STITCH_MASKS * m_Lod.GetChunkLevel(chunk) +
+         m_Lod.GetChunkStitchMask(chunk);
+}
 
-  // Set the type of primitive that should be rendered from this vertex buffer,
-  // in this case triangles.
-  deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+void TerrainClass::ReleaseHeightMap() {
+  // Free the heights rather than just clearing them.
+  std::vector<float>().swap(m_heightMap);
 
   return;
-}
\ No newline at end of file
+}
+
+void TerrainClass::ReleaseBuffers() {
+  // Release the chunk vertex buffers.
+  for (ChunkType &chunk : m_chunks) {
+    if (chunk.vertexBuffer) {
+      chunk.vertexBuffer->Release();
+      chunk.vertexBuffer = 0;
+    }
+  }
+  m_chunks.clear();
+
+  // Release the shared index buffers.
+  for (IndexBufferType &indexBuffer : m_indexBuffers) {
+    if (indexBuffer.buffer) {
+      indexBuffer.buffer->Release();
+      indexBuffer.buffer = 0;
+    }
+  }
+  m_indexBuffers.clear();
+
+  return;
+}
@@ -4,43 +4,43 @@
 #ifndef _TERRAINCLASS_H_
 #define _TERRAINCLASS_H_
 
+/////////////
+// GLOBALS //
+/////////////
+// Quads along each side of a chunk: 65x65 vertices, which keeps chunk
+// indices within 16 bits.
+const int TERRAIN_CHUNK_QUADS = 64;
+
 //////////////
 // INCLUDES //
 //////////////
 #include <DirectXMath.h>
 #include <d3d11.h>
 #include <stdio.h>
+#include <vector>
 using namespace DirectX;
 
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "heightmapclass.h"
+#include "terrainlodclass.h"
+#include "terrainnormalclass.h"
+#include "terrainshaderclass.h"
+
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: TerrainClass
+//
+// The height map is split into chunks of TERRAIN_CHUNK_QUADS quads that
+// share their edge vertices. Each chunk is an indexed triangle list with its
+// own vertex buffer; chunks with the same dimensions share their 16-bit index
+// buffers, one per level of detail and stitch mask. Normals, tangents and
+// chunk meshes are built straight from the heights on a pool of threads,
+// without a full-size model array. The heights and normals are kept, so an
+// edit only recomputes the normals and vertex rows around it.
 ////////////////////////////////////////////////////////////////////////////////
 class TerrainClass {
 private:
-  struct HeightMapType {
-    float x, y, z;
-    float nx, ny, nz;
-  };
-
-  struct VectorType {
-    float x, y, z;
-  };
-
-  struct ModelType {
-    float x, y, z;
-    float tu, tv;
-    float nx, ny, nz;
-    float tx, ty, tz;
-    float bx, by, bz;
-    float tu2, tv2;
-  };
-
-  struct TempVertexType {
-    float x, y, z;
-    float tu, tv;
-    float nx, ny, nz;
-  };
-
   struct VertexType {
     XMFLOAT3 position;
     XMFLOAT2 texture;
@@ -50,6 +50,23 @@ private:
     XMFLOAT2 texture2;
   };
 
+  struct IndexBufferType {
+    int quadsX, quadsZ;
+    int level, stitchMask;
+    int indexCount;
+    ID3D11Buffer *buffer;
+  };
+
+  struct ChunkType {
+    int startX, startZ;
+    int quadsX, quadsZ;
+    XMFLOAT3 minBounds, maxBounds;
+    // First index buffer of the chunk's size; the one for a level and
+    // stitch mask is TERRAIN_LOD_STITCH_MASKS * level + mask after it.
+    int indexBuffer;
+    ID3D11Buffer *vertexBuffer;
+  };
+
 public:
   TerrainClass();
   TerrainClass(const TerrainClass &);
@@ -57,31 +74,41 @@ public:
 
   bool Initialize(ID3D11Device *, char *, float);
   void Shutdown();
-  void Render(ID3D11DeviceContext *);
+  void Render(ID3D11DeviceContext *, TerrainShaderClass *);
+  void RenderChunk(ID3D11DeviceContext *, int);
+  void SelectLod(float, float, float, float, float);
+  bool AddCrater(ID3D11DeviceContext *, float, float, float, float);
 
   int GetIndexCount();
+  int GetChunkCount();
+  int GetChunkIndexCount(int);
+  void GetChunkBounds(int, XMFLOAT3 &, XMFLOAT3 &);
 
 private:
   bool LoadHeightMap(char *);
   void ReduceHeightMap(float);
-  bool CalculateNormals();
-  bool BuildModel();
-  void CalculateModelVectors();
-  void CalculateTangentBinormal(TempVertexType, TempVertexType, TempVertexType,
-                                VectorType &, VectorType &);
-  bool InitializeBuffers(ID3D11Device *);
+  bool BuildChunkLayout();
+  bool InitializeIndexBuffers(ID3D11Device *);
+  bool BuildChunks(ID3D11Device *);
+  bool BuildChunk(ID3D11Device *, ChunkType &, std::vector<VertexType> &);
+  void CalculateChunkVertices(const ChunkType &, int, int,
+                              std::vector<VertexType> &);
+  void CalculateChunkBounds(ChunkType &);
+  void UpdateRegion(ID3D11DeviceContext *, int, int, int, int);
+  void CalculateVertex(int, int, const ChunkType &, VertexType &);
+  float GetHeight(int, int);
+  int GetChunkIndexBuffer(int);
 
   void ReleaseHeightMap();
-  void ReleaseModel();
   void ReleaseBuffers();
 
-  void RenderBuffers(ID3D11DeviceContext *);
-
 private:
-  int m_terrainWidth, m_terrainHeight, m_vertexCount, m_indexCount;
-  HeightMapType *m_heightMap;
-  ModelType *m_model;
-  ID3D11Buffer *m_vertexBuffer, *m_indexBuffer;
+  int m_terrainWidth, m_terrainHeight;
+  std::vector<float> m_heightMap;
+  std::vector<ChunkType> m_chunks;
+  std::vector<IndexBufferType> m_indexBuffers;
+  TerrainLodClass m_Lod;
+  TerrainNormalClass m_Normals;
 };
 
-#endif
\ No newline at end of file
+#endif
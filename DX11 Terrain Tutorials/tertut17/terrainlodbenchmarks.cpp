@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: terrainlodbenchmarks.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "terrainlodbenchmarks.h"
+
+#include "terrainlodclass.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int kTerrainSize = 2049;
+const int kFrames = 2000;
+
+// Matches the tutorial: 1080 pixel high view with a field of view of pi / 4.
+const float kProjectionScale = 1080.0f / (2.0f * 0.41421356f);
+const float kPixelError = 2.0f;
+
+template <typename Func> double MeasureMilliseconds(Func &&func) {
+  const auto start = Clock::now();
+  func();
+  const auto end = Clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Ridged hills from a few octaves of sines, scaled like a height map
+// divided by the tutorial's maximum height.
+float SampleHeight(float x, float z) {
+  float height = 0.0f;
+  float amplitude = 24.0f;
+  float frequency = 0.004f;
+  for (int octave = 0; octave < 5; octave++) {
+    height += amplitude * (1.0f - fabsf(sinf(x * frequency) *
+                                        cosf(z * frequency * 1.3f)));
+    amplitude *= 0.45f;
+    frequency *= 2.1f;
+  }
+  return height;
+}
+
+bool NeighboursWithinOneLevel(TerrainLodClass &lod) {
+  const int chunksX = lod.GetChunksX();
+  for (int chunk = 0; chunk < lod.GetChunkCount(); chunk++) {
+    const int level = lod.GetChunkLevel(chunk);
+    if ((chunk % chunksX < chunksX - 1 &&
+         abs(lod.GetChunkLevel(chunk + 1) - level) > 1) ||
+        (chunk + chunksX < lod.GetChunkCount() &&
+         abs(lod.GetChunkLevel(chunk + chunksX) - level) > 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+bool RunTerrainLodBenchmarks() {
+  std::vector<float> heights((size_t)kTerrainSize * kTerrainSize);
+  TerrainLodClass lod;
+  double errorMs, selectMs, triangles, fullTriangles;
+  int minTriangles, maxTriangles, frame, count;
+  bool consistent;
+
+  printf("=== Terrain LOD fly-through benchmark ===\n");
+
+  for (int z = 0; z < kTerrainSize; z++) {
+    for (int x = 0; x < kTerrainSize; x++) {
+      heights[(size_t)kTerrainSize * z + x] =
+          SampleHeight((float)x, (float)z);
+    }
+  }
+  if (!lod.Initialize(kTerrainSize, kTerrainSize, 64)) {
+    return false;
+  }
+  errorMs = MeasureMilliseconds([&] {
+    for (int i = 0; i < lod.GetChunkCount(); i++) {
+      lod.CalculateChunkErrors(i, heights.data());
+    }
+  });
+  fullTriangles = 2.0 * (kTerrainSize - 1) * (kTerrainSize - 1);
+
+  // Fly a figure of eight over the terrain, skimming the hills where the
+  // loops cross and climbing high over their far ends.
+  triangles = 0.0;
+  minTriangles = 0x7fffffff;
+  maxTriangles = 0;
+  consistent = true;
+  selectMs = 0.0;
+  for (frame = 0; frame < kFrames; frame++) {
+    const float t = 6.2831853f * (float)frame / (float)kFrames;
+    const float x = kTerrainSize * (0.5f + 0.4f * sinf(t));
+    const float z = kTerrainSize * (0.5f + 0.4f * sinf(t) * cosf(t));
+    const float y = SampleHeight(x, z) + 2.0f + 300.0f * (1.0f - cosf(2 * t));
+    selectMs += MeasureMilliseconds(
+        [&] { lod.SelectLevels(x, y, z, kProjectionScale, kPixelError); });
+
+    count = lod.GetTriangleCount();
+    triangles += count;
+    minTriangles = (std::min)(minTriangles, count);
+    maxTriangles = (std::max)(maxTriangles, count);
+    consistent = NeighboursWithinOneLevel(lod) && consistent;
+  }
+
+  printf("%dx%d height map, %d chunks | level errors %.1f ms\n",
+         kTerrainSize, kTerrainSize, lod.GetChunkCount(), errorMs);
+  printf("  full detail %.0f triangles per frame\n", fullTriangles);
+  printf("  %d frames: %.0f triangles per frame on average (%.2f%%), "
+         "%d to %d\n",
+         kFrames, triangles / kFrames,
+         100.0 * triangles / kFrames / fullTriangles, minTriangles,
+         maxTriangles);
+  printf("  selection %.4f ms per frame\n", selectMs / kFrames);
+
+  if (!consistent) {
+    printf("Neighbouring chunks more than one level apart\n");
+  }
+  return consistent;
+}
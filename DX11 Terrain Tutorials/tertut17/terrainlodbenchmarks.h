@@ -0,0 +1,13 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: terrainlodbenchmarks.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TERRAINLODBENCHMARKS_H_
+#define _TERRAINLODBENCHMARKS_H_
+
+// Headless fly-through over a 2049 x 2049 height map: prints the triangles
+// the level of detail selection draws per frame against full detail, and
+// how long the error build and the selection take. Returns false if a
+// frame's selection breaks the one level rule between neighbours.
+bool RunTerrainLodBenchmarks();
+
+#endif
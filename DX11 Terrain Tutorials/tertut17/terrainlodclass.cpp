@@ -0,0 +1,390 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: terrainlodclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "terrainlodclass.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace {
+
+// Which edges of a quadsX x quadsZ chunk drawn at the given step really get
+// stitched: only edges with an even number of cells can meet a neighbour one
+// level coarser, so the others never need it.
+int EffectiveStitchMask(int quadsX, int quadsZ, int step, int stitchMask) {
+  if ((quadsZ / step) % 2 != 0) {
+    stitchMask &= ~(TERRAIN_LOD_STITCH_LEFT | TERRAIN_LOD_STITCH_RIGHT);
+  }
+  if ((quadsX / step) % 2 != 0) {
+    stitchMask &= ~(TERRAIN_LOD_STITCH_BOTTOM | TERRAIN_LOD_STITCH_TOP);
+  }
+  return stitchMask;
+}
+
+} // namespace
+
+TerrainLodClass::TerrainLodClass() {
+  m_terrainWidth = 0;
+  m_chunksX = 0;
+  m_chunksZ = 0;
+}
+
+TerrainLodClass::TerrainLodClass(const TerrainLodClass &other) {}
+
+TerrainLodClass::~TerrainLodClass() {}
+
+bool TerrainLodClass::Initialize(int terrainWidth, int terrainHeight,
+                                 int chunkQuads) {
+  int quadsX, quadsZ, startX, startZ, i;
+  ChunkType chunk;
+
+  // Chunk vertices must stay addressable with 16-bit indices.
+  if (terrainWidth < 2 || terrainHeight < 2 || chunkQuads < 1 ||
+      (chunkQuads + 1) * (chunkQuads + 1) > 65536) {
+    return false;
+  }
+
+  m_terrainWidth = terrainWidth;
+  quadsX = terrainWidth - 1;
+  quadsZ = terrainHeight - 1;
+  m_chunksX = (quadsX + chunkQuads - 1) / chunkQuads;
+  m_chunksZ = (quadsZ + chunkQuads - 1) / chunkQuads;
+
+  // Lay the chunks out row by row, the same way TerrainClass does.
+  m_chunks.clear();
+  m_chunks.reserve((size_t)m_chunksX * m_chunksZ);
+  for (startZ = 0; startZ < quadsZ; startZ += chunkQuads) {
+    for (startX = 0; startX < quadsX; startX += chunkQuads) {
+      chunk.startX = startX;
+      chunk.startZ = startZ;
+      chunk.quadsX = (std::min)(chunkQuads, quadsX - startX);
+      chunk.quadsZ = (std::min)(chunkQuads, quadsZ - startZ);
+      chunk.levelCount = GetLevelCount(chunk.quadsX, chunk.quadsZ);
+      chunk.minHeight = 0.0f;
+      chunk.maxHeight = 0.0f;
+      for (i = 0; i < TERRAIN_LOD_MAX_LEVELS; i++) {
+        chunk.errors[i] = 0.0f;
+      }
+
+      // Full detail until the first selection.
+      chunk.level = 0;
+      chunk.stitchMask = 0;
+      m_chunks.push_back(chunk);
+    }
+  }
+
+  return true;
+}
+
+void TerrainLodClass::Shutdown() {
+  m_chunks.clear();
+  m_chunksX = 0;
+  m_chunksZ = 0;
+
+  return;
+}
+
+void TerrainLodClass::CalculateChunkErrors(int chunkIndex,
+                                           const float *heightMap) {
+  ChunkType &chunk = m_chunks[chunkIndex];
+  int level, step, cellX, cellZ, i, j;
+  float h00, h10, h01, h11, u, v, height, surface, error;
+
+  // Get the height range of the chunk for the distance to the camera.
+  chunk.minHeight = chunk.maxHeight =
+      heightMap[(size_t)m_terrainWidth * chunk.startZ + chunk.startX];
+  for (j = 0; j <= chunk.quadsZ; j++) {
+    for (i = 0; i <= chunk.quadsX; i++) {
+      height = heightMap[(size_t)m_terrainWidth * (chunk.startZ + j) +
+                         chunk.startX + i];
+      chunk.minHeight = (std::min)(chunk.minHeight, height);
+      chunk.maxHeight = (std::max)(chunk.maxHeight, height);
+    }
+  }
+
+  // Level 0 is the height map itself. For each coarser level, measure how
+  // far every skipped vertex lies from the two triangles of its cell, split
+  // along the same bottom left to upper right diagonal the index buffers use.
+  chunk.errors[0] = 0.0f;
+  for (level = 1; level < chunk.levelCount; level++) {
+    step = 1 << level;
+    error = 0.0f;
+    for (cellZ = chunk.startZ; cellZ < chunk.startZ + chunk.quadsZ;
+         cellZ += step) {
+      const float *bottom = heightMap + (size_t)m_terrainWidth * cellZ;
+      const float *top = heightMap + (size_t)m_terrainWidth * (cellZ + step);
+      for (cellX = chunk.startX; cellX < chunk.startX + chunk.quadsX;
+           cellX += step) {
+        h00 = bottom[cellX];
+        h10 = bottom[cellX + step];
+        h01 = top[cellX];
+        h11 = top[cellX + step];
+        for (j = 0; j <= step; j++) {
+          const float *row = heightMap + (size_t)m_terrainWidth * (cellZ + j);
+          v = (float)j / (float)step;
+          for (i = 0; i <= step; i++) {
+            u = (float)i / (float)step;
+            if (v >= u) {
+              surface = h00 + u * (h11 - h01) + v * (h01 - h00);
+            } else {
+              surface = h00 + u * (h10 - h00) + v * (h11 - h10);
+            }
+            error = (std::max)(error, fabsf(row[cellX + i] - surface));
+          }
+        }
+      }
+    }
+
+    // A coarser level never counts as more accurate than a finer one.
+    chunk.errors[level] = (std::max)(error, chunk.errors[level - 1]);
+  }
+
+  return;
+}
+
+void TerrainLodClass::SelectLevels(float cameraX, float cameraY,
+                                   float cameraZ, float projectionScale,
+                                   float pixelError) {
+  float distance;
+
+  // An error of e world units at distance d covers e * projectionScale / d
+  // pixels, where projectionScale is the screen height over
+  // 2 * tan(fov / 2). Take the coarsest level that stays within pixelError.
+  for (ChunkType &chunk : m_chunks) {
+    distance = GetDistance(chunk, cameraX, cameraY, cameraZ);
+    chunk.level = 0;
+    while (chunk.level + 1 < chunk.levelCount &&
+           chunk.errors[chunk.level + 1] * projectionScale <=
+               pixelError * distance) {
+      chunk.level++;
+    }
+  }
+
+  // Neighbours may differ by one level at most, which the stitched index
+  // buffers can join without cracks.
+  RestrictLevels();
+  CalculateStitchMasks();
+
+  return;
+}
+
+int TerrainLodClass::GetChunkCount() { return (int)m_chunks.size(); }
+
+int TerrainLodClass::GetChunksX() { return m_chunksX; }
+
+int TerrainLodClass::GetChunksZ() { return m_chunksZ; }
+
+void TerrainLodClass::GetChunkArea(int chunk, int &startX, int &startZ,
+                                   int &quadsX, int &quadsZ) {
+  startX = m_chunks[chunk].startX;
+  startZ = m_chunks[chunk].startZ;
+  quadsX = m_chunks[chunk].quadsX;
+  quadsZ = m_chunks[chunk].quadsZ;
+  return;
+}
+
+int TerrainLodClass::GetChunkLevelCount(int chunk) {
+  return m_chunks[chunk].levelCount;
+}
+
+float TerrainLodClass::GetChunkError(int chunk, int level) {
+  return m_chunks[chunk].errors[level];
+}
+
+int TerrainLodClass::GetChunkLevel(int chunk) { return m_chunks[chunk].level; }
+
+int TerrainLodClass::GetChunkStitchMask(int chunk) {
+  return m_chunks[chunk].stitchMask;
+}
+
+int TerrainLodClass::GetTriangleCount() {
+  int count = 0;
+
+  for (const ChunkType &chunk : m_chunks) {
+    count += GetTriangleCount(chunk.quadsX, chunk.quadsZ, chunk.level,
+                              chunk.stitchMask);
+  }
+
+  return count;
+}
+
+int TerrainLodClass::GetLevelCount(int quadsX, int quadsZ) {
+  int count = 1;
+
+  // A level needs whole cells, so its step has to divide both sides.
+  while (count < TERRAIN_LOD_MAX_LEVELS && quadsX % (1 << count) == 0 &&
+         quadsZ % (1 << count) == 0) {
+    count++;
+  }
+
+  return count;
+}
+
+void TerrainLodClass::BuildIndices(int quadsX, int quadsZ, int level,
+                                   int stitchMask,
+                                   std::vector<unsigned short> &indices) {
+  int step, pitch, i, j, k;
+  int x[4], z[4];
+  unsigned short corner[4];
+
+  step = 1 << level;
+  pitch = quadsX + 1;
+  stitchMask = EffectiveStitchMask(quadsX, quadsZ, step, stitchMask);
+
+  indices.clear();
+  indices.reserve((size_t)GetTriangleCount(quadsX, quadsZ, level, stitchMask) *
+                  3);
+  for (j = 0; j < quadsZ; j += step) {
+    for (i = 0; i < quadsX; i += step) {
+      // Bottom left, bottom right, upper left, upper right.
+      x[0] = i;
+      z[0] = j;
+      x[1] = i + step;
+      z[1] = j;
+      x[2] = i;
+      z[2] = j + step;
+      x[3] = i + step;
+      z[3] = j + step;
+
+      // On a stitched edge the vertices the coarser neighbour does not have
+      // are snapped onto the previous one. The triangles that collapse are
+      // dropped and the rest follow the neighbour's straight edge.
+      for (k = 0; k < 4; k++) {
+        if (((z[k] == 0 && (stitchMask & TERRAIN_LOD_STITCH_BOTTOM)) ||
+             (z[k] == quadsZ && (stitchMask & TERRAIN_LOD_STITCH_TOP))) &&
+            x[k] % (2 * step) != 0) {
+          x[k] -= step;
+        }
+        if (((x[k] == 0 && (stitchMask & TERRAIN_LOD_STITCH_LEFT)) ||
+             (x[k] == quadsX && (stitchMask & TERRAIN_LOD_STITCH_RIGHT))) &&
+            z[k] % (2 * step) != 0) {
+          z[k] -= step;
+        }
+        corner[k] = (unsigned short)(pitch * z[k] + x[k]);
+      }
+
+      // Same winding as the full detail quads: upper left, upper right,
+      // bottom left; bottom left, upper right, bottom right.
+      if (corner[2] != corner[3] && corner[2] != corner[0] &&
+          corner[3] != corner[0]) {
+        indices.push_back(corner[2]);
+        indices.push_back(corner[3]);
+        indices.push_back(corner[0]);
+      }
+      if (corner[0] != corner[3] && corner[0] != corner[1] &&
+          corner[3] != corner[1]) {
+        indices.push_back(corner[0]);
+        indices.push_back(corner[3]);
+        indices.push_back(corner[1]);
+      }
+    }
+  }
+
+  return;
+}
+
+int TerrainLodClass::GetTriangleCount(int quadsX, int quadsZ, int level,
+                                      int stitchMask) {
+  int step, cellsX, cellsZ, count;
+
+  step = 1 << level;
+  cellsX = quadsX / step;
+  cellsZ = quadsZ / step;
+  stitchMask = EffectiveStitchMask(quadsX, quadsZ, step, stitchMask);
+
+  // Every snapped vertex collapses exactly one triangle.
+  count = cellsX * cellsZ * 2;
+  if (stitchMask & TERRAIN_LOD_STITCH_LEFT) {
+    count -= cellsZ / 2;
+  }
+  if (stitchMask & TERRAIN_LOD_STITCH_RIGHT) {
+    count -= cellsZ / 2;
+  }
+  if (stitchMask & TERRAIN_LOD_STITCH_BOTTOM) {
+    count -= cellsX / 2;
+  }
+  if (stitchMask & TERRAIN_LOD_STITCH_TOP) {
+    count -= cellsX / 2;
+  }
+
+  return count;
+}
+
+float TerrainLodClass::GetDistance(const ChunkType &chunk, float cameraX,
+                                   float cameraY, float cameraZ) {
+  float dx, dy, dz;
+
+  // Distance from the camera to the nearest point of the chunk bounds.
+  dx = (std::max)((std::max)((float)chunk.startX - cameraX, 0.0f),
+                  cameraX - (float)(chunk.startX + chunk.quadsX));
+  dy = (std::max)((std::max)(chunk.minHeight - cameraY, 0.0f),
+                  cameraY - chunk.maxHeight);
+  dz = (std::max)((std::max)((float)chunk.startZ - cameraZ, 0.0f),
+                  cameraZ - (float)(chunk.startZ + chunk.quadsZ));
+
+  return sqrtf(dx * dx + dy * dy + dz * dz);
+}
+
+void TerrainLodClass::RestrictLevels() {
+  int x, z, index;
+
+  // Each level becomes the smallest of its own and every other chunk's
+  // level plus their grid distance. Two sweeps compute that exactly, the
+  // first over the left and lower neighbours, the second over the right and
+  // upper ones, so the result never depends on the camera history.
+  for (z = 0; z < m_chunksZ; z++) {
+    for (x = 0; x < m_chunksX; x++) {
+      index = m_chunksX * z + x;
+      if (x > 0) {
+        m_chunks[index].level =
+            (std::min)(m_chunks[index].level, m_chunks[index - 1].level + 1);
+      }
+      if (z > 0) {
+        m_chunks[index].level = (std::min)(
+            m_chunks[index].level, m_chunks[index - m_chunksX].level + 1);
+      }
+    }
+  }
+  for (z = m_chunksZ - 1; z >= 0; z--) {
+    for (x = m_chunksX - 1; x >= 0; x--) {
+      index = m_chunksX * z + x;
+      if (x < m_chunksX - 1) {
+        m_chunks[index].level =
+            (std::min)(m_chunks[index].level, m_chunks[index + 1].level + 1);
+      }
+      if (z < m_chunksZ - 1) {
+        m_chunks[index].level = (std::min)(
+            m_chunks[index].level, m_chunks[index + m_chunksX].level + 1);
+      }
+    }
+  }
+
+  return;
+}
+
+void TerrainLodClass::CalculateStitchMasks() {
+  int x, z, index, level, mask;
+
+  for (z = 0; z < m_chunksZ; z++) {
+    for (x = 0; x < m_chunksX; x++) {
+      index = m_chunksX * z + x;
+      level = m_chunks[index].level;
+      mask = 0;
+      if (x > 0 && m_chunks[index - 1].level > level) {
+        mask |= TERRAIN_LOD_STITCH_LEFT;
+      }
+      if (x < m_chunksX - 1 && m_chunks[index + 1].level > level) {
+        mask |= TERRAIN_LOD_STITCH_RIGHT;
+      }
+      if (z > 0 && m_chunks[index - m_chunksX].level > level) {
+        mask |= TERRAIN_LOD_STITCH_BOTTOM;
+      }
+      if (z < m_chunksZ - 1 && m_chunks[index + m_chunksX].level > level) {
+        mask |= TERRAIN_LOD_STITCH_TOP;
+      }
+      m_chunks[index].stitchMask = mask;
+    }
+  }
+
+  return;
+}
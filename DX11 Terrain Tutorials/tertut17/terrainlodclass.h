@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: terrainlodclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TERRAINLODCLASS_H_
+#define _TERRAINLODCLASS_H_
+
+/////////////
+// GLOBALS //
+/////////////
+// Level l draws every 2^l-th vertex; a chunk of 64 quads has levels 0 to 6.
+const int TERRAIN_LOD_MAX_LEVELS = 8;
+
+// Stitch mask bits: the chunk edges whose neighbour is one level coarser.
+const int TERRAIN_LOD_STITCH_LEFT = 1;   // -x
+const int TERRAIN_LOD_STITCH_RIGHT = 2;  // +x
+const int TERRAIN_LOD_STITCH_BOTTOM = 4; // -z
+const int TERRAIN_LOD_STITCH_TOP = 8;    // +z
+const int TERRAIN_LOD_STITCH_MASKS = 16;
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: TerrainLodClass
+//
+// Geomipmapping over the terrain chunks. Every chunk stores the largest
+// height error of each level against the full height map. Each frame the
+// coarsest level whose error projects to at most a given number of pixels
+// is picked per chunk, neighbours are pulled to within one level of each
+// other, and every edge next to a coarser neighbour is stitched: its odd
+// vertices are snapped onto the even ones so no cracks open.
+//
+// Only plain CPU code: no device is needed, so it is unit tested headless.
+////////////////////////////////////////////////////////////////////////////////
+class TerrainLodClass {
+private:
+  struct ChunkType {
+    int startX, startZ;
+    int quadsX, quadsZ;
+    int levelCount;
+    float minHeight, maxHeight;
+    float errors[TERRAIN_LOD_MAX_LEVELS];
+    int level, stitchMask;
+  };
+
+public:
+  TerrainLodClass();
+  TerrainLodClass(const TerrainLodClass &);
+  ~TerrainLodClass();
+
+  bool Initialize(int, int, int);
+  void Shutdown();
+
+  void CalculateChunkErrors(int, const float *);
+  void SelectLevels(float, float, float, float, float);
+
+  int GetChunkCount();
+  int GetChunksX();
+  int GetChunksZ();
+  void GetChunkArea(int, int &, int &, int &, int &);
+  int GetChunkLevelCount(int);
+  float GetChunkError(int, int);
+  int GetChunkLevel(int);
+  int GetChunkStitchMask(int);
+  int GetTriangleCount();
+
+  static int GetLevelCount(int, int);
+  static void BuildIndices(int, int, int, int, std::vector<unsigned short> &);
+  static int GetTriangleCount(int, int, int, int);
+
+private:
+  float GetDistance(const ChunkType &, float, float, float);
+  void RestrictLevels();
+  void CalculateStitchMasks();
+
+private:
+  int m_terrainWidth, m_chunksX, m_chunksZ;
+  std::vector<ChunkType> m_chunks;
+};
+
+#endif
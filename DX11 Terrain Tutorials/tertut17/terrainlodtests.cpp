@@ -0,0 +1,352 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: terrainlodtests.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "terrainlodtests.h"
+
+#include "terrainlodclass.h"
+
+#include <windows.h>
+
+#include <exception>
+#include <math.h>
+#include <set>
+#include <stdlib.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+// Rolling hills with a ridge, heights row by row like TerrainClass keeps
+// them.
+std::vector<float> MakeHeightMap(int width, int height) {
+  std::vector<float> heights((size_t)width * height);
+  for (int z = 0; z < height; z++) {
+    for (int x = 0; x < width; x++) {
+      heights[(size_t)width * z + x] =
+          4.0f * sinf(x * 0.09f) * cosf(z * 0.05f) +
+          1.5f * sinf((x + z) * 0.31f) + 0.25f * cosf(x * 1.7f + z * 2.3f);
+    }
+  }
+  return heights;
+}
+
+bool InitializeLod(TerrainLodClass &lod, const std::vector<float> &heights,
+                   int width, int height, std::string &message) {
+  if (!lod.Initialize(width, height, 64)) {
+    message = "initialize failed";
+    return false;
+  }
+  for (int i = 0; i < lod.GetChunkCount(); i++) {
+    lod.CalculateChunkErrors(i, heights.data());
+  }
+  return true;
+}
+
+// Global grid positions of the vertices one chunk's triangles use on its
+// edge at the given side: 0 left, 1 right, 2 bottom, 3 top.
+std::set<std::pair<int, int>> EdgeVertices(TerrainLodClass &lod, int chunk,
+                                           int side) {
+  int startX, startZ, quadsX, quadsZ;
+  std::vector<unsigned short> indices;
+  std::set<std::pair<int, int>> vertices;
+
+  lod.GetChunkArea(chunk, startX, startZ, quadsX, quadsZ);
+  TerrainLodClass::BuildIndices(quadsX, quadsZ, lod.GetChunkLevel(chunk),
+                                lod.GetChunkStitchMask(chunk), indices);
+  for (unsigned short index : indices) {
+    const int x = index % (quadsX + 1);
+    const int z = index / (quadsX + 1);
+    if ((side == 0 && x == 0) || (side == 1 && x == quadsX) ||
+        (side == 2 && z == 0) || (side == 3 && z == quadsZ)) {
+      vertices.insert(std::make_pair(startX + x, startZ + z));
+    }
+  }
+  return vertices;
+}
+
+bool TestLevelCounts(std::string &message) {
+  if (TerrainLodClass::GetLevelCount(64, 64) != 7 ||
+      TerrainLodClass::GetLevelCount(32, 64) != 6 ||
+      TerrainLodClass::GetLevelCount(64, 31) != 1 ||
+      TerrainLodClass::GetLevelCount(12, 64) != 3) {
+    message = "wrong number of levels";
+    return false;
+  }
+  return true;
+}
+
+bool TestIndexListsTileTheChunk(std::string &message) {
+  const int shapes[4][2] = {{64, 64}, {32, 64}, {64, 12}, {2, 2}};
+  std::vector<unsigned short> indices;
+
+  // Every level and stitch mask must cover the chunk exactly once, wound
+  // like the full detail quads, with the counts the buffers are sized by.
+  for (const auto &shape : shapes) {
+    const int quadsX = shape[0];
+    const int quadsZ = shape[1];
+    const int vertexCount = (quadsX + 1) * (quadsZ + 1);
+    for (int level = 0;
+         level < TerrainLodClass::GetLevelCount(quadsX, quadsZ); level++) {
+      for (int mask = 0; mask < TERRAIN_LOD_STITCH_MASKS; mask++) {
+        TerrainLodClass::BuildIndices(quadsX, quadsZ, level, mask, indices);
+        const std::string where = std::to_string(quadsX) + "x" +
+                                  std::to_string(quadsZ) + " level " +
+                                  std::to_string(level) + " mask " +
+                                  std::to_string(mask);
+        if ((int)indices.size() !=
+            3 * TerrainLodClass::GetTriangleCount(quadsX, quadsZ, level,
+                                                  mask)) {
+          message = where + ": triangle count differs";
+          return false;
+        }
+
+        double area = 0.0;
+        for (size_t i = 0; i < indices.size(); i += 3) {
+          int x[3], z[3];
+          for (int k = 0; k < 3; k++) {
+            if (indices[i + k] >= vertexCount) {
+              message = where + ": index out of range";
+              return false;
+            }
+            x[k] = indices[i + k] % (quadsX + 1);
+            z[k] = indices[i + k] / (quadsX + 1);
+          }
+          // Full detail triangles have a negative signed area in x/z.
+          const int twiceArea = (x[1] - x[0]) * (z[2] - z[0]) -
+                                (x[2] - x[0]) * (z[1] - z[0]);
+          if (twiceArea >= 0) {
+            message = where + ": triangle flipped or degenerate";
+            return false;
+          }
+          area -= 0.5 * twiceArea;
+        }
+        if (area != (double)quadsX * quadsZ) {
+          message = where + ": triangles do not cover the chunk";
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool TestStitchedEdgesMatchCoarserLevel(std::string &message) {
+  std::vector<unsigned short> indices;
+
+  // Level 2 stitched on every side may only use the level 3 vertices along
+  // its edges.
+  TerrainLodClass::BuildIndices(64, 64, 2, TERRAIN_LOD_STITCH_MASKS - 1,
+                                indices);
+  for (unsigned short index : indices) {
+    const int x = index % 65;
+    const int z = index / 65;
+    if (((x == 0 || x == 64) && z % 8 != 0) ||
+        ((z == 0 || z == 64) && x % 8 != 0)) {
+      message = "edge vertex the coarser neighbour does not have";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestErrors(std::string &message) {
+  const int size = 65;
+  std::vector<float> heights((size_t)size * size);
+  TerrainLodClass lod;
+
+  // A tilted plane is exact at every level.
+  for (int z = 0; z < size; z++) {
+    for (int x = 0; x < size; x++) {
+      heights[(size_t)size * z + x] = 0.25f * x - 0.5f * z + 3.0f;
+    }
+  }
+  if (!InitializeLod(lod, heights, size, size, message)) {
+    return false;
+  }
+  for (int level = 0; level < lod.GetChunkLevelCount(0); level++) {
+    if (lod.GetChunkError(0, level) > 1e-4f) {
+      message = "plane has an error at level " + std::to_string(level);
+      return false;
+    }
+  }
+
+  // A spike on an odd vertex is missed by every level above 0, by its full
+  // height.
+  for (float &height : heights) {
+    height = 0.0f;
+  }
+  heights[(size_t)size * 33 + 31] = 5.0f;
+  lod.CalculateChunkErrors(0, heights.data());
+  if (lod.GetChunkError(0, 0) != 0.0f) {
+    message = "level 0 has an error";
+    return false;
+  }
+  for (int level = 1; level < lod.GetChunkLevelCount(0); level++) {
+    if (fabsf(lod.GetChunkError(0, level) - 5.0f) > 1e-4f) {
+      message = "spike error wrong at level " + std::to_string(level);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestSelection(std::string &message) {
+  const int width = 513;
+  const int height = 449;
+  const std::vector<float> heights = MakeHeightMap(width, height);
+  TerrainLodClass lod;
+  if (!InitializeLod(lod, heights, width, height, message)) {
+    return false;
+  }
+
+  // Standing over the first chunk: it is drawn at full detail, the far
+  // corner coarser, and neighbours stay within one level.
+  lod.SelectLevels(10.0f, 8.0f, 10.0f, 500.0f, 2.0f);
+  const int chunksX = lod.GetChunksX();
+  const int chunksZ = lod.GetChunksZ();
+  if (lod.GetChunkLevel(0) != 0 ||
+      lod.GetChunkLevel(chunksX * chunksZ - 1) < 2) {
+    message = "levels do not follow the distance";
+    return false;
+  }
+  for (int z = 0; z < chunksZ; z++) {
+    for (int x = 0; x < chunksX; x++) {
+      const int chunk = chunksX * z + x;
+      const int level = lod.GetChunkLevel(chunk);
+      const int neighbours[4] = {x > 0 ? chunk - 1 : -1,
+                                 x < chunksX - 1 ? chunk + 1 : -1,
+                                 z > 0 ? chunk - chunksX : -1,
+                                 z < chunksZ - 1 ? chunk + chunksX : -1};
+      for (int side = 0; side < 4; side++) {
+        const bool coarser = neighbours[side] >= 0 &&
+                             lod.GetChunkLevel(neighbours[side]) > level;
+        if (neighbours[side] >= 0 &&
+            abs(lod.GetChunkLevel(neighbours[side]) - level) > 1) {
+          message = "neighbours more than one level apart";
+          return false;
+        }
+        if (coarser != ((lod.GetChunkStitchMask(chunk) & (1 << side)) != 0)) {
+          message = "stitch mask does not match the neighbours";
+          return false;
+        }
+      }
+    }
+  }
+
+  // The result depends on the camera only, not on the previous selection.
+  std::vector<int> levels;
+  for (int i = 0; i < lod.GetChunkCount(); i++) {
+    levels.push_back(lod.GetChunkLevel(i));
+  }
+  lod.SelectLevels(500.0f, 300.0f, 400.0f, 500.0f, 2.0f);
+  lod.SelectLevels(10.0f, 8.0f, 10.0f, 500.0f, 2.0f);
+  for (int i = 0; i < lod.GetChunkCount(); i++) {
+    if (lod.GetChunkLevel(i) != levels[i]) {
+      message = "selection depends on history";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestNoCracks(std::string &message) {
+  const int width = 385;
+  const int height = 321;
+  const std::vector<float> heights = MakeHeightMap(width, height);
+  const float cameras[3][3] = {
+      {30.0f, 6.0f, 40.0f}, {200.0f, 12.0f, 150.0f}, {380.0f, 3.0f, 10.0f}};
+  TerrainLodClass lod;
+  if (!InitializeLod(lod, heights, width, height, message)) {
+    return false;
+  }
+
+  // Both sides of every shared edge must use the same vertices, or the
+  // edge triangles would leave T-junctions and cracks. Each view has to
+  // mix levels for the test to mean anything.
+  for (const auto &camera : cameras) {
+    lod.SelectLevels(camera[0], camera[1], camera[2], 300.0f, 2.0f);
+    if (lod.GetTriangleCount() == 2 * (width - 1) * (height - 1)) {
+      message = "view selects full detail everywhere";
+      return false;
+    }
+    const int chunksX = lod.GetChunksX();
+    for (int chunk = 0; chunk < lod.GetChunkCount(); chunk++) {
+      const int x = chunk % chunksX;
+      if (x < chunksX - 1 &&
+          EdgeVertices(lod, chunk, 1) != EdgeVertices(lod, chunk + 1, 0)) {
+        message = "crack between chunks " + std::to_string(chunk) + " and " +
+                  std::to_string(chunk + 1);
+        return false;
+      }
+      if (chunk + chunksX < lod.GetChunkCount() &&
+          EdgeVertices(lod, chunk, 3) !=
+              EdgeVertices(lod, chunk + chunksX, 2)) {
+        message = "crack between chunks " + std::to_string(chunk) + " and " +
+                  std::to_string(chunk + chunksX);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(6);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("Level counts", TestLevelCounts);
+  run("Index lists tile the chunk", TestIndexListsTileTheChunk);
+  run("Stitched edges match the coarser level",
+      TestStitchedEdgesMatchCoarserLevel);
+  run("Level errors", TestErrors);
+  run("Selection", TestSelection);
+  run("No cracks between chunks", TestNoCracks);
+
+  return results;
+}
+
+} // namespace
+
+bool RunTerrainLodTests() {
+  const std::vector<TestCaseResult> results = RunAllTestsInternal();
+  bool allPassed = true;
+  std::string line;
+
+  for (const TestCaseResult &result : results) {
+    if (!result.passed) {
+      allPassed = false;
+      line = "TerrainLodTests: Test failed: " + result.name;
+      if (!result.message.empty()) {
+        line += " - " + result.message;
+      }
+      line += "\n";
+      OutputDebugStringA(line.c_str());
+    }
+  }
+
+  return allPassed;
+}
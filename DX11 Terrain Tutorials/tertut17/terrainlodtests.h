@@ -0,0 +1,12 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: terrainlodtests.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TERRAINLODTESTS_H_
+#define _TERRAINLODTESTS_H_
+
+// Headless tests of TerrainLodClass: stitched index lists, level errors and
+// the per-chunk level selection. Failures are written to the debugger
+// output. Returns false if any test fails.
+bool RunTerrainLodTests();
+
+#endif
@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: terrainnormalbenchmarks.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "terrainnormalbenchmarks.h"
+
+#include "terrainnormalclass.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int kTerrainSize = 2049;
+const int kCraters = 2000;
+const int kCraterRadius = 8;
+
+template <typename Func> double MeasureMilliseconds(Func &&func) {
+  const auto start = Clock::now();
+  func();
+  const auto end = Clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Ridged hills from a few octaves of sines, as in the LOD benchmark.
+float SampleHeight(float x, float z) {
+  float height = 0.0f;
+  float amplitude = 24.0f;
+  float frequency = 0.004f;
+  for (int octave = 0; octave < 5; octave++) {
+    height += amplitude * (1.0f - fabsf(sinf(x * frequency) *
+                                        cosf(z * frequency * 1.3f)));
+    amplitude *= 0.45f;
+    frequency *= 2.1f;
+  }
+  return height;
+}
+
+// The normals the tutorials started with: a temporary array of face
+// normals, then the average of the up to four faces around each vertex.
+void FaceAveragedNormals(const std::vector<float> &heights, int size,
+                         std::vector<float> &normals) {
+  std::vector<float> faces((size_t)(size - 1) * (size - 1) * 3);
+  for (int j = 0; j < size - 1; j++) {
+    for (int i = 0; i < size - 1; i++) {
+      float *face = &faces[((size_t)(size - 1) * j + i) * 3];
+      face[0] =
+          heights[(size_t)size * j + i] - heights[(size_t)size * j + i + 1];
+      face[1] = 1.0f;
+      face[2] =
+          heights[(size_t)size * j + i] - heights[(size_t)size * (j + 1) + i];
+    }
+  }
+
+  normals.resize((size_t)size * size * 3);
+  for (int j = 0; j < size; j++) {
+    for (int i = 0; i < size; i++) {
+      float sum[3] = {0.0f, 0.0f, 0.0f};
+      for (int z = j - 1; z <= j; z++) {
+        for (int x = i - 1; x <= i; x++) {
+          if (x >= 0 && z >= 0 && x < size - 1 && z < size - 1) {
+            const float *face = &faces[((size_t)(size - 1) * z + x) * 3];
+            sum[0] += face[0];
+            sum[1] += face[1];
+            sum[2] += face[2];
+          }
+        }
+      }
+      const float length =
+          sqrtf(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+      float *normal = &normals[((size_t)size * j + i) * 3];
+      normal[0] = sum[0] / length;
+      normal[1] = sum[1] / length;
+      normal[2] = sum[2] / length;
+    }
+  }
+}
+
+// Central differences one normal at a time on one thread.
+void ScalarNormals(const std::vector<float> &heights, int size,
+                   std::vector<float> &normals) {
+  normals.resize((size_t)size * size * 3);
+  for (int z = 0; z < size; z++) {
+    for (int x = 0; x < size; x++) {
+      const int left = (std::max)(x - 1, 0);
+      const int right = (std::min)(x + 1, size - 1);
+      const int down = (std::max)(z - 1, 0);
+      const int up = (std::min)(z + 1, size - 1);
+      const float slopeX = (heights[(size_t)size * z + left] -
+                            heights[(size_t)size * z + right]) /
+                           (float)(right - left);
+      const float slopeZ = (heights[(size_t)size * down + x] -
+                            heights[(size_t)size * up + x]) /
+                           (float)(up - down);
+      const float length =
+          1.0f / sqrtf(slopeX * slopeX + 1.0f + slopeZ * slopeZ);
+      float *normal = &normals[((size_t)size * z + x) * 3];
+      normal[0] = slopeX * length;
+      normal[1] = length;
+      normal[2] = slopeZ * length;
+    }
+  }
+}
+
+} // namespace
+
+bool RunTerrainNormalBenchmarks() {
+  std::vector<float> heights((size_t)kTerrainSize * kTerrainSize);
+  std::vector<float> reference;
+  TerrainNormalClass normals, fresh;
+  double faceMs, scalarMs, fullMs, craterMs;
+  float a[3], b[3];
+  bool consistent;
+
+  printf("=== Terrain normal benchmark ===\n");
+
+  for (int z = 0; z < kTerrainSize; z++) {
+    for (int x = 0; x < kTerrainSize; x++) {
+      heights[(size_t)kTerrainSize * z + x] =
+          SampleHeight((float)x, (float)z);
+    }
+  }
+  if (!normals.Initialize(kTerrainSize, kTerrainSize) ||
+      !fresh.Initialize(kTerrainSize, kTerrainSize)) {
+    return false;
+  }
+
+  faceMs = MeasureMilliseconds(
+      [&] { FaceAveragedNormals(heights, kTerrainSize, reference); });
+  scalarMs = MeasureMilliseconds(
+      [&] { ScalarNormals(heights, kTerrainSize, reference); });
+  fullMs = MeasureMilliseconds(
+      [&] { normals.CalculateNormals(heights.data()); });
+
+  // Dig craters along a spiral, updating the normals around each one.
+  craterMs = 0.0;
+  for (int crater = 0; crater < kCraters; crater++) {
+    const float t = 0.01f * (float)crater;
+    const int centerX =
+        (int)(kTerrainSize * (0.5f + 0.45f * t / 20.0f * cosf(t * 7.0f)));
+    const int centerZ =
+        (int)(kTerrainSize * (0.5f + 0.45f * t / 20.0f * sinf(t * 7.0f)));
+    const int minX = (std::max)(centerX - kCraterRadius, 0);
+    const int minZ = (std::max)(centerZ - kCraterRadius, 0);
+    const int maxX = (std::min)(centerX + kCraterRadius, kTerrainSize - 1);
+    const int maxZ = (std::min)(centerZ + kCraterRadius, kTerrainSize - 1);
+    for (int z = minZ; z <= maxZ; z++) {
+      for (int x = minX; x <= maxX; x++) {
+        const float distance = (float)((x - centerX) * (x - centerX) +
+                                       (z - centerZ) * (z - centerZ));
+        heights[(size_t)kTerrainSize * z + x] -=
+            (std::max)(0.0f, 1.0f - distance / (kCraterRadius * kCraterRadius));
+      }
+    }
+    craterMs += MeasureMilliseconds([&] {
+      normals.UpdateRegion(heights.data(), minX, minZ, maxX, maxZ);
+    });
+  }
+
+  // The updated normals must match a recalculation from scratch.
+  fresh.CalculateNormals(heights.data());
+  consistent = true;
+  for (int z = 0; z < kTerrainSize && consistent; z++) {
+    for (int x = 0; x < kTerrainSize; x++) {
+      normals.GetNormal(x, z, a[0], a[1], a[2]);
+      fresh.GetNormal(x, z, b[0], b[1], b[2]);
+      if (a[0] != b[0] || a[1] != b[1] || a[2] != b[2]) {
+        consistent = false;
+        break;
+      }
+    }
+  }
+
+  printf("%dx%d height map\n", kTerrainSize, kTerrainSize);
+  printf("  face-averaged normals      %8.2f ms\n", faceMs);
+  printf("  scalar central differences %8.2f ms\n", scalarMs);
+  printf("  SSE, threaded row bands    %8.2f ms\n", fullMs);
+  printf("  %d crater updates of %dx%d samples: %.4f ms each\n", kCraters,
+         2 * kCraterRadius + 1, 2 * kCraterRadius + 1, craterMs / kCraters);
+
+  if (!consistent) {
+    printf("Region updates differ from a full recalculation\n");
+  }
+  return consistent;
+}
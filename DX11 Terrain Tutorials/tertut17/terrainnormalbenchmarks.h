@@ -0,0 +1,14 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: terrainnormalbenchmarks.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TERRAINNORMALBENCHMARKS_H_
+#define _TERRAINNORMALBENCHMARKS_H_
+
+// Headless normal generation over a 2049 x 2049 height map: prints the time
+// of the old face-averaged normals, scalar central differences, the
+// vectorized and threaded TerrainNormalClass, and crater-sized region
+// updates. Returns false if the updated normals differ from a full
+// recalculation.
+bool RunTerrainNormalBenchmarks();
+
+#endif
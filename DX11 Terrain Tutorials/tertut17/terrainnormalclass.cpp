@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: terrainnormalclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "terrainnormalclass.h"
+
+#include "JobSystem.h"
+
+#include <emmintrin.h>
+#include <math.h>
+
+TerrainNormalClass::TerrainNormalClass() {
+  m_terrainWidth = 0;
+  m_terrainHeight = 0;
+}
+
+TerrainNormalClass::TerrainNormalClass(const TerrainNormalClass &other) {}
+
+TerrainNormalClass::~TerrainNormalClass() {}
+
+bool TerrainNormalClass::Initialize(int terrainWidth, int terrainHeight) {
+  size_t count;
+
+  // Differences need at least two samples each way.
+  if (terrainWidth < 2 || terrainHeight < 2) {
+    return false;
+  }
+
+  m_terrainWidth = terrainWidth;
+  m_terrainHeight = terrainHeight;
+
+  // Keep the three components in separate arrays so a row of normals is
+  // written four at a time; flat normals until the first calculation.
+  count = (size_t)m_terrainWidth * m_terrainHeight;
+  m_normalX.assign(count, 0.0f);
+  m_normalY.assign(count, 1.0f);
+  m_normalZ.assign(count, 0.0f);
+
+  return true;
+}
+
+void TerrainNormalClass::Shutdown() {
+  // Free the normals rather than just clearing them.
+  std::vector<float>().swap(m_normalX);
+  std::vector<float>().swap(m_normalY);
+  std::vector<float>().swap(m_normalZ);
+  m_terrainWidth = 0;
+  m_terrainHeight = 0;
+
+  return;
+}
+
+void TerrainNormalClass::CalculateNormals(const float *heights) {
+  CalculateRows(heights, 0, 0, m_terrainWidth - 1, m_terrainHeight - 1);
+
+  return;
+}
+
+void TerrainNormalClass::UpdateRegion(const float *heights, int minX,
+                                      int minZ, int maxX, int maxZ) {
+  // A height is used by the normals next to it as well, so grow the
+  // rectangle of changed heights by one sample and clip it to the terrain.
+  minX = (minX > 0) ? minX - 1 : 0;
+  minZ = (minZ > 0) ? minZ - 1 : 0;
+  maxX = (maxX < m_terrainWidth - 2) ? maxX + 1 : m_terrainWidth - 1;
+  maxZ = (maxZ < m_terrainHeight - 2) ? maxZ + 1 : m_terrainHeight - 1;
+  if (minX > maxX || minZ > maxZ) {
+    return;
+  }
+
+  CalculateRows(heights, minX, minZ, maxX, maxZ);
+
+  return;
+}
+
+void TerrainNormalClass::GetNormal(int x, int z, float &normalX,
+                                   float &normalY, float &normalZ) {
+  size_t index;
+
+  index = (size_t)m_terrainWidth * z + x;
+  normalX = m_normalX[index];
+  normalY = m_normalY[index];
+  normalZ = m_normalZ[index];
+
+  return;
+}
+
+void TerrainNormalClass::CalculateRows(const float *heights, int minX,
+                                       int minZ, int maxX, int maxZ) {
+  int bandCount;
+
+  // Every normal only reads the heights and writes its own entry, so bands
+  // of rows are computed in parallel. Small regions are a single band and
+  // stay on the calling thread.
+  bandCount = (maxZ - minZ + TERRAIN_NORMAL_BAND_ROWS) /
+              TERRAIN_NORMAL_BAND_ROWS;
+  JobSystem::GetShared().ParallelFor(bandCount, [&](int band) {
+    const int firstRow = minZ + band * TERRAIN_NORMAL_BAND_ROWS;
+    int lastRow = firstRow + TERRAIN_NORMAL_BAND_ROWS - 1;
+    if (lastRow > maxZ) {
+      lastRow = maxZ;
+    }
+    for (int z = firstRow; z <= lastRow; z++) {
+      CalculateRow(heights, z, minX, maxX);
+    }
+  });
+
+  return;
+}
+
+void TerrainNormalClass::CalculateRow(const float *heights, int z, int minX,
+                                      int maxX) {
+  const float *row, *rowDown, *rowUp;
+  float *normalX, *normalY, *normalZ;
+  __m128 scaleZ, half, one, differenceX, differenceZ, length;
+  int x, lastX;
+
+  // The first and last column take one-sided differences.
+  if (minX == 0) {
+    CalculateNormal(heights, 0, z);
+    minX = 1;
+  }
+  lastX = maxX;
+  if (maxX == m_terrainWidth - 1) {
+    CalculateNormal(heights, maxX, z);
+    lastX = maxX - 1;
+  }
+
+  // The rows above and below, or this row itself along the top and bottom
+  // edges, where the difference spans one sample instead of two.
+  row = heights + (size_t)m_terrainWidth * z;
+  rowDown = (z > 0) ? row - m_terrainWidth : row;
+  rowUp = (z < m_terrainHeight - 1) ? row + m_terrainWidth : row;
+  scaleZ = _mm_set1_ps((z > 0 && z < m_terrainHeight - 1) ? 0.5f : 1.0f);
+  half = _mm_set1_ps(0.5f);
+  one = _mm_set1_ps(1.0f);
+  normalX = m_normalX.data() + (size_t)m_terrainWidth * z;
+  normalY = m_normalY.data() + (size_t)m_terrainWidth * z;
+  normalZ = m_normalZ.data() + (size_t)m_terrainWidth * z;
+
+  // Four interior normals at a time.
+  for (x = minX; x + 3 <= lastX; x += 4) {
+    differenceX = _mm_mul_ps(
+        _mm_sub_ps(_mm_loadu_ps(row + x - 1), _mm_loadu_ps(row + x + 1)),
+        half);
+    differenceZ = _mm_mul_ps(
+        _mm_sub_ps(_mm_loadu_ps(rowDown + x), _mm_loadu_ps(rowUp + x)),
+        scaleZ);
+    length = _mm_sqrt_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(differenceX, differenceX), one),
+                   _mm_mul_ps(differenceZ, differenceZ)));
+    length = _mm_div_ps(one, length);
+    _mm_storeu_ps(normalX + x, _mm_mul_ps(differenceX, length));
+    _mm_storeu_ps(normalY + x, length);
+    _mm_storeu_ps(normalZ + x, _mm_mul_ps(differenceZ, length));
+  }
+
+  // And the rest one at a time.
+  for (; x <= lastX; x++) {
+    CalculateNormal(heights, x, z);
+  }
+
+  return;
+}
+
+void TerrainNormalClass::CalculateNormal(const float *heights, int x, int z) {
+  int left, right, down, up;
+  float differenceX, differenceZ, length;
+  size_t index;
+
+  left = (x > 0) ? x - 1 : x;
+  right = (x < m_terrainWidth - 1) ? x + 1 : x;
+  down = (z > 0) ? z - 1 : z;
+  up = (z < m_terrainHeight - 1) ? z + 1 : z;
+
+  // The slope along x and z, per unit of distance.
+  differenceX = (heights[(size_t)m_terrainWidth * z + left] -
+                 heights[(size_t)m_terrainWidth * z + right]) *
+                (1.0f / (float)(right - left));
+  differenceZ = (heights[(size_t)m_terrainWidth * down + x] -
+                 heights[(size_t)m_terrainWidth * up + x]) *
+                (1.0f / (float)(up - down));
+
+  // Normalize (differenceX, 1, differenceZ).
+  length = 1.0f / sqrtf(differenceX * differenceX + 1.0f +
+                        differenceZ * differenceZ);
+  index = (size_t)m_terrainWidth * z + x;
+  m_normalX[index] = differenceX * length;
+  m_normalY[index] = length;
+  m_normalZ[index] = differenceZ * length;
+
+  return;
+}
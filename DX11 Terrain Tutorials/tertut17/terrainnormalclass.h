@@ -0,0 +1,55 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: terrainnormalclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TERRAINNORMALCLASS_H_
+#define _TERRAINNORMALCLASS_H_
+
+/////////////
+// GLOBALS //
+/////////////
+// Rows of normals one thread computes at a time.
+const int TERRAIN_NORMAL_BAND_ROWS = 32;
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: TerrainNormalClass
+//
+// Vertex normals of a height map, cached for the whole terrain. Each normal
+// comes straight from central differences of the heights around it,
+// (h(x - 1, z) - h(x + 1, z), 2, h(x, z - 1) - h(x, z + 1)) normalized,
+// with one-sided differences along the borders, so no face normals are
+// needed. Rows are computed four samples at a time with SSE and bands of
+// rows are spread over threads. After the heights inside a rectangle change
+// only the normals that depend on them are computed again.
+//
+// Only plain CPU code: no device is needed, so it is unit tested headless.
+////////////////////////////////////////////////////////////////////////////////
+class TerrainNormalClass {
+public:
+  TerrainNormalClass();
+  TerrainNormalClass(const TerrainNormalClass &);
+  ~TerrainNormalClass();
+
+  bool Initialize(int, int);
+  void Shutdown();
+
+  void CalculateNormals(const float *);
+  void UpdateRegion(const float *, int, int, int, int);
+
+  void GetNormal(int, int, float &, float &, float &);
+
+private:
+  void CalculateRows(const float *, int, int, int, int);
+  void CalculateRow(const float *, int, int, int);
+  void CalculateNormal(const float *, int, int);
+
+private:
+  int m_terrainWidth, m_terrainHeight;
+  std::vector<float> m_normalX, m_normalY, m_normalZ;
+};
+
+#endif
@@ -0,0 +1,274 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: terrainnormaltests.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "terrainnormaltests.h"
+
+#include "terrainnormalclass.h"
+
+#include <windows.h>
+
+#include <exception>
+#include <math.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+const float kTolerance = 1e-6f;
+
+// Bumpy heights that differ in every sample.
+std::vector<float> MakeHeights(int width, int height, unsigned int seed) {
+  std::vector<float> heights((size_t)width * height);
+  for (size_t i = 0; i < heights.size(); i++) {
+    seed = seed * 1664525u + 1013904223u;
+    heights[i] = (float)(seed >> 8) / (float)(1 << 24) * 12.0f;
+  }
+  return heights;
+}
+
+// The normal from central differences, one-sided along the borders.
+void ReferenceNormal(const std::vector<float> &heights, int width, int height,
+                     int x, int z, float normal[3]) {
+  const int left = (x > 0) ? x - 1 : x;
+  const int right = (x < width - 1) ? x + 1 : x;
+  const int down = (z > 0) ? z - 1 : z;
+  const int up = (z < height - 1) ? z + 1 : z;
+  const double slopeX = ((double)heights[(size_t)width * z + left] -
+                         heights[(size_t)width * z + right]) /
+                        (right - left);
+  const double slopeZ = ((double)heights[(size_t)width * down + x] -
+                         heights[(size_t)width * up + x]) /
+                        (up - down);
+  const double length = sqrt(slopeX * slopeX + 1.0 + slopeZ * slopeZ);
+  normal[0] = (float)(slopeX / length);
+  normal[1] = (float)(1.0 / length);
+  normal[2] = (float)(slopeZ / length);
+}
+
+bool NormalsMatch(TerrainNormalClass &normals,
+                  const std::vector<float> &heights, int width, int height,
+                  std::string &message) {
+  float expected[3], actual[3];
+
+  for (int z = 0; z < height; z++) {
+    for (int x = 0; x < width; x++) {
+      ReferenceNormal(heights, width, height, x, z, expected);
+      normals.GetNormal(x, z, actual[0], actual[1], actual[2]);
+      for (int k = 0; k < 3; k++) {
+        if (fabsf(actual[k] - expected[k]) > kTolerance) {
+          message = "wrong normal at " + std::to_string(x) + ", " +
+                    std::to_string(z);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool TestFlatTerrain(std::string &message) {
+  std::vector<float> heights(17 * 9, 3.5f);
+  TerrainNormalClass normals;
+  float x, y, z;
+
+  if (!normals.Initialize(17, 9)) {
+    message = "initialize failed";
+    return false;
+  }
+  normals.CalculateNormals(heights.data());
+  for (int j = 0; j < 9; j++) {
+    for (int i = 0; i < 17; i++) {
+      normals.GetNormal(i, j, x, y, z);
+      if (x != 0.0f || y != 1.0f || z != 0.0f) {
+        message = "flat terrain is not straight up";
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool TestPlane(std::string &message) {
+  const int width = 23;
+  const int height = 6;
+  std::vector<float> heights((size_t)width * height);
+  TerrainNormalClass normals;
+  float x, y, z, length;
+
+  // Differences of a plane are exact, borders included.
+  for (int j = 0; j < height; j++) {
+    for (int i = 0; i < width; i++) {
+      heights[(size_t)width * j + i] = 0.5f * i - 0.25f * j + 4.0f;
+    }
+  }
+  normals.Initialize(width, height);
+  normals.CalculateNormals(heights.data());
+
+  length = sqrtf(0.25f + 1.0f + 0.0625f);
+  for (int j = 0; j < height; j++) {
+    for (int i = 0; i < width; i++) {
+      normals.GetNormal(i, j, x, y, z);
+      if (fabsf(x + 0.5f / length) > kTolerance ||
+          fabsf(y - 1.0f / length) > kTolerance ||
+          fabsf(z - 0.25f / length) > kTolerance) {
+        message = "wrong plane normal at " + std::to_string(i) + ", " +
+                  std::to_string(j);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool TestMatchesReference(std::string &message) {
+  TerrainNormalClass normals;
+
+  // Widths that leave every remainder after the four-wide loop, down to
+  // the smallest terrain.
+  for (int width = 2; width <= 13; width++) {
+    const int height = 2 + width % 4;
+    const std::vector<float> heights = MakeHeights(width, height, width);
+    normals.Initialize(width, height);
+    normals.CalculateNormals(heights.data());
+    if (!NormalsMatch(normals, heights, width, height, message)) {
+      message += " with width " + std::to_string(width);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestManyBands(std::string &message) {
+  const int width = 203;
+  const int height = TERRAIN_NORMAL_BAND_ROWS * 5 + 7;
+  const std::vector<float> heights = MakeHeights(width, height, 99);
+  TerrainNormalClass normals;
+
+  // Enough rows for several bands, the last one short.
+  normals.Initialize(width, height);
+  normals.CalculateNormals(heights.data());
+  return NormalsMatch(normals, heights, width, height, message);
+}
+
+bool TestUpdateRegion(std::string &message) {
+  const int width = 97;
+  const int height = 81;
+  std::vector<float> heights = MakeHeights(width, height, 7);
+  const std::vector<float> original = heights;
+  TerrainNormalClass normals;
+  float before[3], after[3];
+
+  normals.Initialize(width, height);
+  normals.CalculateNormals(heights.data());
+
+  // Edit the heights of a rectangle and update it.
+  for (int z = 30; z <= 44; z++) {
+    for (int x = 20; x <= 57; x++) {
+      heights[(size_t)width * z + x] -= 3.0f;
+    }
+  }
+  normals.UpdateRegion(heights.data(), 20, 30, 57, 44);
+  if (!NormalsMatch(normals, heights, width, height, message)) {
+    return false;
+  }
+
+  // Heights changed outside the rectangle are not looked at: only the
+  // normals next to the rectangle are recomputed.
+  heights = original;
+  normals.CalculateNormals(heights.data());
+  for (float &value : heights) {
+    value += 1.0f;
+  }
+  heights[(size_t)width * 10 + 10] += 5.0f;
+  heights[(size_t)width * 11 + 11] += 5.0f;
+  normals.UpdateRegion(heights.data(), 11, 11, 11, 11);
+  for (int z = 0; z < height; z++) {
+    for (int x = 0; x < width; x++) {
+      ReferenceNormal(original, width, height, x, z, before);
+      normals.GetNormal(x, z, after[0], after[1], after[2]);
+      const bool inside = x >= 10 && x <= 12 && z >= 10 && z <= 12;
+      const bool changed = fabsf(after[0] - before[0]) > kTolerance ||
+                           fabsf(after[1] - before[1]) > kTolerance ||
+                           fabsf(after[2] - before[2]) > kTolerance;
+      if (!inside && changed) {
+        message = "normal outside the region changed";
+        return false;
+      }
+    }
+  }
+
+  // Regions along and past the borders are clipped.
+  heights = MakeHeights(width, height, 8);
+  normals.UpdateRegion(heights.data(), -5, -5, 3, 200);
+  normals.UpdateRegion(heights.data(), 90, -2, 120, 90);
+  normals.UpdateRegion(heights.data(), 0, 78, 96, 80);
+  normals.UpdateRegion(heights.data(), 0, 0, 96, 2);
+  normals.UpdateRegion(heights.data(), 4, 0, 92, 80);
+  if (!NormalsMatch(normals, heights, width, height, message)) {
+    message += " after clipped updates";
+    return false;
+  }
+
+  // A region entirely off the terrain changes nothing.
+  normals.UpdateRegion(heights.data(), 200, 200, 300, 300);
+  normals.UpdateRegion(heights.data(), -50, -50, -10, -10);
+  return NormalsMatch(normals, heights, width, height, message);
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(5);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("Flat terrain", TestFlatTerrain);
+  run("Plane", TestPlane);
+  run("Matches the scalar reference", TestMatchesReference);
+  run("Many bands", TestManyBands);
+  run("Region updates", TestUpdateRegion);
+
+  return results;
+}
+
+} // namespace
+
+bool RunTerrainNormalTests() {
+  const std::vector<TestCaseResult> results = RunAllTestsInternal();
+  bool allPassed = true;
+  std::string line;
+
+  for (const TestCaseResult &result : results) {
+    if (!result.passed) {
+      allPassed = false;
+      line = "TerrainNormalTests: Test failed: " + result.name;
+      if (!result.message.empty()) {
+        line += " - " + result.message;
+      }
+      line += "\n";
+      OutputDebugStringA(line.c_str());
+    }
+  }
+
+  return allPassed;
+}
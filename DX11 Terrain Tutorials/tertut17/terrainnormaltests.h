@@ -0,0 +1,12 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: terrainnormaltests.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TERRAINNORMALTESTS_H_
+#define _TERRAINNORMALTESTS_H_
+
+// Headless tests of TerrainNormalClass: the vectorized and threaded normals
+// against a scalar reference, and region updates after edits. Failures are
+// written to the debugger output. Returns false if any test fails.
+bool RunTerrainNormalTests();
+
+#endif
@@ -43,11 +43,6 @@ public:
               ID3D11ShaderResourceView *, ID3D11ShaderResourceView *,
               ID3D11ShaderResourceView *, ID3D11ShaderResourceView *);
 
-private:
-  bool InitializeShader(ID3D11Device *, HWND, WCHAR *, WCHAR *);
-  void ShutdownShader();
-  void OutputShaderErrorMessage(ID3D10Blob *, HWND, WCHAR *);
-
   bool
   SetShaderParameters(ID3D11DeviceContext *, const XMMATRIX &, const XMMATRIX &,
                       const XMMATRIX &, const XMFLOAT3 &,
@@ -57,6 +52,11 @@ private:
                       ID3D11ShaderResourceView *);
   void RenderShader(ID3D11DeviceContext *, int);
 
+private:
+  bool InitializeShader(ID3D11Device *, HWND, WCHAR *, WCHAR *);
+  void ShutdownShader();
+  void OutputShaderErrorMessage(ID3D10Blob *, HWND, WCHAR *);
+
 private:
   ID3D11VertexShader *m_vertexShader;
   ID3D11PixelShader *m_pixelShader;
@@ -150,9 +150,10 @@ bool ApplicationClass::Initialize(HINSTANCE hinstance, HWND hwnd,
     return false;
   }
 
-  // Initialize the foliage object.
+  // Initialize the foliage object; the same seed scatters the same foliage
+  // on every run.
   result = m_Foliage->Initialize(m_Direct3D->GetDevice(),
-                                 L"../tertut19/data/grass.dds", 500);
+                                 L"../tertut19/data/grass.dds", 1);
   if (!result) {
     MessageBox(hwnd, L"Could not initialize the foliage object.", L"Error",
                MB_OK);
@@ -362,12 +363,22 @@ bool ApplicationClass::Render() {
   // Turn on the alpha-to-coverage blending.
   m_Direct3D->EnableAlphaToCoverageBlending();
 
-  // Render the foliage.
+  // Render the foliage, either billboarded in the shader from the cells near
+  // the camera or with the matrices built for them this frame.
   m_Foliage->Render(m_Direct3D->GetDeviceContext());
-  m_ShaderManager->RenderFoliageShader(
-      m_Direct3D->GetDeviceContext(), m_Foliage->GetVertexCount(),
-      m_Foliage->GetInstanceCount(), viewMatrix, projectionMatrix,
-      m_Foliage->GetTexture());
+  if (FOLIAGE_GPU_BILLBOARDS) {
+    m_ShaderManager->RenderFoliageBillboardShader(
+        m_Direct3D->GetDeviceContext(), m_Foliage->GetVertexCount(),
+        m_Foliage->GetRangeCount(), m_Foliage->GetRangeStarts(),
+        m_Foliage->GetRangeCounts(), viewMatrix, projectionMatrix,
+        m_Camera->GetPosition(), m_Foliage->GetWindPhase(),
+        m_Foliage->GetTexture());
+  } else {
+    m_ShaderManager->RenderFoliageShader(
+        m_Direct3D->GetDeviceContext(), m_Foliage->GetVertexCount(),
+        m_Foliage->GetInstanceCount(), viewMatrix, projectionMatrix,
+        m_Foliage->GetTexture());
+  }
 
   // Turn off the alpha blending.
   m_Direct3D->TurnOffAlphaBlending();
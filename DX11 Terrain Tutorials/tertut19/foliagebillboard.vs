@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: foliagebillboard.vs
+////////////////////////////////////////////////////////////////////////////////
+
+
+/////////////
+// GLOBALS //
+/////////////
+cbuffer MatrixBuffer
+{
+	matrix viewMatrix;
+	matrix projectionMatrix;
+};
+
+cbuffer WindBuffer
+{
+	float3 cameraPosition;
+	float windPhase;
+};
+
+// Largest wind sway of a blade, ten degrees in radians, as in FoliageFieldClass.
+static const float windAmplitude = 0.174532925f;
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+struct VertexInputType
+{
+    float4 position : POSITION;
+    float2 tex : TEXCOORD0;
+	float4 instancePosition : TEXCOORD1;
+	float3 instanceColor : TEXCOORD2;
+};
+
+struct PixelInputType
+{
+    float4 position : SV_POSITION;
+    float2 tex : TEXCOORD0;
+	float3 foliageColor : TEXCOORD1;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Vertex Shader
+////////////////////////////////////////////////////////////////////////////////
+PixelInputType FoliageBillboardVertexShader(VertexInputType input)
+{
+    PixelInputType output;
+	float2 toFoliage;
+	float facingLength, sinY, cosY, sway, sinX, cosX, turnedZ;
+	float3 worldPosition;
+    
+
+	// Get the sine and cosine of the angle that faces the blade toward the camera, the
+	// direction from the camera normalized, with no turn for a blade right under it.
+	toFoliage = input.instancePosition.xz - cameraPosition.xz;
+	facingLength = length(toFoliage);
+	sinY = 0.0f;
+	cosY = 1.0f;
+	if(facingLength > 0.0f)
+	{
+		sinY = toFoliage.x / facingLength;
+		cosY = toFoliage.y / facingLength;
+	}
+
+	// Sway the blade about the x axis, each blade offset in the wind by its seed.
+	sway = windAmplitude * sin(windPhase + input.instancePosition.w);
+	sincos(sway, sinX, cosX);
+
+	// Turn the quad about the y axis, tip it about the x axis and move it into place,
+	// the same rotations and translation the matrix path multiplies together.
+	worldPosition.x = input.position.x * cosY + input.position.z * sinY;
+	turnedZ = input.position.z * cosY - input.position.x * sinY;
+	worldPosition.y = input.position.y * cosX - turnedZ * sinX;
+	worldPosition.z = input.position.y * sinX + turnedZ * cosX;
+	worldPosition += input.instancePosition.xyz;
+
+	// Calculate the position of the vertex against the view and projection matrices.
+    output.position = mul(float4(worldPosition, 1.0f), viewMatrix);
+    output.position = mul(output.position, projectionMatrix);
+    
+	// Store the texture coordinates for the pixel shader.
+	output.tex = input.tex;
+    
+	// Send the instanced foliage color into the pixel shader.
+	output.foliageColor = input.instanceColor;
+
+    return output;
+}
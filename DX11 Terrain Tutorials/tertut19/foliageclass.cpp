@@ -2,11 +2,10 @@
 // Filename: foliageclass.cpp
 ///////////////////////////////////////////////////////////////////////////////
 #include "foliageclass.h"
-#include <new>
 
 FoliageClass::FoliageClass() {
-  m_foliageArray = 0;
-  m_Instances = 0;
+  m_Scatter = 0;
+  m_Field = 0;
 
   m_vertexBuffer = 0;
   m_instanceBuffer = 0;
@@ -18,20 +17,32 @@ FoliageClass::FoliageClass(const FoliageClass &other) {}
 FoliageClass::~FoliageClass() {}
 
 bool FoliageClass::Initialize(ID3D11Device *device, WCHAR *textureFilename,
-                              int fCount) {
+                              unsigned int seed) {
   bool result;
+  float minX, minZ, maxX, maxZ;
 
-  // Set the foliage count.
-  m_foliageCount = fCount;
+  // Set up the scatter that places the foliage from the seed.
+  result = InitializeScatter(seed);
+  if (!result) {
+    return false;
+  }
 
-  // Generate the positions of the foliage.
-  result = GeneratePositions();
+  // Create the foliage field object.
+  m_Field = new FoliageFieldClass;
+  if (!m_Field) {
+    return false;
+  }
+
+  // Start with an empty field; the chunks near the camera are scattered on
+  // the first frame.
+  m_Scatter->GetBounds(minX, minZ, maxX, maxZ);
+  result = m_Field->Initialize(0, 0, minX, minZ, maxX, maxZ, FOLIAGE_CELL_SIZE);
   if (!result) {
     return false;
   }
 
-  // Initialize the vertex and instance buffer that hold the geometry for the
-  // foliage model.
+  // Initialize the vertex buffer that holds the geometry for the foliage
+  // model.
   result = InitializeBuffers(device);
   if (!result) {
     return false;
@@ -43,9 +54,9 @@ bool FoliageClass::Initialize(ID3D11Device *device, WCHAR *textureFilename,
     return false;
   }
 
-  // Set the initial wind rotation and direction.
-  m_windRotation = 0.0f;
-  m_windDirection = 1;
+  // Set the initial wind phase and no instances until the first frame.
+  m_windPhase = 0.0f;
+  m_instanceCount = 0;
 
   return true;
 }
@@ -57,10 +68,18 @@ void FoliageClass::Shutdown() {
   // Release the vertex and instance buffers.
   ShutdownBuffers();
 
-  // Release the foliage array.
-  if (m_foliageArray) {
-    delete[] m_foliageArray;
-    m_foliageArray = 0;
+  // Release the foliage field object.
+  if (m_Field) {
+    m_Field->Shutdown();
+    delete m_Field;
+    m_Field = 0;
+  }
+
+  // Release the foliage scatter object.
+  if (m_Scatter) {
+    m_Scatter->Shutdown();
+    delete m_Scatter;
+    m_Scatter = 0;
   }
 
   return;
@@ -76,60 +95,32 @@ void FoliageClass::Render(ID3D11DeviceContext *deviceContext) {
 
 bool FoliageClass::Frame(XMFLOAT3 cameraPosition,
                          ID3D11DeviceContext *deviceContext) {
-  XMMATRIX rotateMatrix, translationMatrix, rotateMatrix2, finalMatrix;
-  XMFLOAT3 modelPosition;
-  int i;
-  double angle;
-  float rotation, windRotation;
   HRESULT result;
   D3D11_MAPPED_SUBRESOURCE mappedResource;
-  InstanceType *instancesPtr;
 
-  // Update the wind rotation.
-  if (m_windDirection == 1) {
-    m_windRotation += 0.1f;
-    if (m_windRotation > 10.0f) {
-      m_windDirection = 2;
-    }
-  } else {
-    m_windRotation -= 0.1f;
-    if (m_windRotation < -10.0f) {
-      m_windDirection = 1;
+  // Scatter the chunks the camera came near and drop the ones it left; the
+  // field and instance buffer are only rebuilt when they changed.
+  if (m_Scatter->Update(cameraPosition.x, cameraPosition.z,
+                        FOLIAGE_DRAW_DISTANCE)) {
+    if (!UpdateInstances(deviceContext)) {
+      return false;
     }
   }
 
-  // Load the instance buffer with the updated locations.
-  for (i = 0; i < m_foliageCount; i++) {
-    // Get the position of this piece of foliage.
-    modelPosition.x = m_foliageArray[i].x;
-    modelPosition.y = -0.1f;
-    modelPosition.z = m_foliageArray[i].z;
-
-    // Calculate the rotation that needs to be applied to the billboard model to
-    // face the current camera position using the arc tangent function.
-    angle = atan2(modelPosition.x - cameraPosition.x,
-                  modelPosition.z - cameraPosition.z) *
-            (180.0 / XM_PI);
-
-    // Convert rotation into radians.
-    rotation = (float)angle * 0.0174532925f;
-
-    // Setup the X rotation of the billboard.
-    rotateMatrix = XMMatrixRotationY(rotation);
-
-    // Get the wind rotation for the foliage.
-    windRotation = m_windRotation * 0.0174532925f;
-
-    // Setup the wind rotation.
-    rotateMatrix2 = XMMatrixRotationX(windRotation);
+  // Move the wind on; the sway of every blade follows from the phase.
+  m_windPhase += FOLIAGE_WIND_PHASE_STEP;
+  if (m_windPhase > XM_2PI) {
+    m_windPhase -= XM_2PI;
+  }
 
-    // Setup the translation matrix.
-    translationMatrix =
-        XMMatrixTranslation(modelPosition.x, modelPosition.y, modelPosition.z);
+  // Select the cells near the camera, the only foliage updated and drawn.
+  m_Field->SelectCells(cameraPosition.x, cameraPosition.z,
+                       FOLIAGE_DRAW_DISTANCE);
+  m_instanceCount = m_Field->GetVisibleCount();
 
-    // Create the final matrix and store it in the instances array.
-    finalMatrix = XMMatrixMultiply(rotateMatrix, rotateMatrix2);
-    m_Instances[i].matrix = XMMatrixMultiply(finalMatrix, translationMatrix);
+  // The vertex shader faces and sways the static instances itself.
+  if (FOLIAGE_GPU_BILLBOARDS || m_instanceCount == 0) {
+    return true;
   }
 
   // Lock the instance buffer so it can be written to.
@@ -139,12 +130,11 @@ bool FoliageClass::Frame(XMFLOAT3 cameraPosition,
     return false;
   }
 
-  // Get a pointer to the data in the instance buffer.
-  instancesPtr = (InstanceType *)mappedResource.pData;
-
-  // Copy the instances array into the instance buffer.
-  memcpy(instancesPtr, (void *)m_Instances,
-         (sizeof(InstanceType) * m_foliageCount));
+  // Build the world matrices of the visible blades straight into the
+  // instance buffer.
+  m_Field->CalculateMatrices(
+      cameraPosition.x, cameraPosition.z, m_windPhase,
+      (FoliageFieldClass::MatrixInstanceType *)mappedResource.pData);
 
   // Unlock the instance buffer.
   deviceContext->Unmap(m_instanceBuffer, 0);
@@ -156,17 +146,23 @@ int FoliageClass::GetVertexCount() { return m_vertexCount; }
 
 int FoliageClass::GetInstanceCount() { return m_instanceCount; }
 
+int FoliageClass::GetRangeCount() { return m_Field->GetRangeCount(); }
+
+const int *FoliageClass::GetRangeStarts() { return m_Field->GetRangeStarts(); }
+
+const int *FoliageClass::GetRangeCounts() { return m_Field->GetRangeCounts(); }
+
+float FoliageClass::GetWindPhase() { return m_windPhase; }
+
 ID3D11ShaderResourceView *FoliageClass::GetTexture() {
   return m_Texture->GetTexture();
 }
 
 bool FoliageClass::InitializeBuffers(ID3D11Device *device) {
   VertexType *vertices;
-  D3D11_BUFFER_DESC vertexBufferDesc, instanceBufferDesc;
-  D3D11_SUBRESOURCE_DATA vertexData, instanceData;
+  D3D11_BUFFER_DESC vertexBufferDesc;
+  D3D11_SUBRESOURCE_DATA vertexData;
   HRESULT result;
-  int i;
-  XMMATRIX matrix;
 
   // Set the number of vertices in the vertex array.
   m_vertexCount = 6;
@@ -220,44 +216,53 @@ bool FoliageClass::InitializeBuffers(ID3D11Device *device) {
   delete[] vertices;
   vertices = 0;
 
-  // Set the number of instances in the array.
-  m_instanceCount = m_foliageCount;
+  return true;
+}
 
-  // Create the instance array.
+bool FoliageClass::InitializeInstanceBuffer(ID3D11Device *device) {
+  D3D11_BUFFER_DESC instanceBufferDesc;
+  D3D11_SUBRESOURCE_DATA instanceData;
+  HRESULT result;
 
-  m_Instances = (InstanceType *)_aligned_malloc(
-      m_instanceCount * sizeof(InstanceType), 16);
-  new (m_Instances) InstanceType[m_instanceCount]();
-  if (!m_Instances) {
-    return false;
+  // Release the instance buffer of the chunks loaded before.
+  if (m_instanceBuffer) {
+    m_instanceBuffer->Release();
+    m_instanceBuffer = 0;
   }
 
-  // Setup an initial matrix.
-  matrix = XMMatrixIdentity();
-
-  // Load the instance array with data.
-  for (i = 0; i < m_instanceCount; i++) {
-    m_Instances[i].matrix = matrix;
-    m_Instances[i].color =
-        XMFLOAT3(m_foliageArray[i].r, m_foliageArray[i].g, m_foliageArray[i].b);
+  // An empty buffer cannot be created; with no foliage nothing is drawn.
+  if (m_Field->GetInstanceCount() == 0) {
+    return true;
   }
 
-  // Set up the description of the instance buffer.
-  instanceBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-  instanceBufferDesc.ByteWidth = sizeof(InstanceType) * m_instanceCount;
+  if (FOLIAGE_GPU_BILLBOARDS) {
+    // The shader reads the position, seed and color of every blade, so the
+    // instances are only uploaded, in cell order, when the chunks change.
+    instanceBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    instanceBufferDesc.ByteWidth =
+        sizeof(FoliageFieldClass::InstanceType) * m_Field->GetInstanceCount();
+    instanceBufferDesc.CPUAccessFlags = 0;
+  } else {
+    // Room for a world matrix and color per blade, written every frame.
+    instanceBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    instanceBufferDesc.ByteWidth =
+        sizeof(FoliageFieldClass::MatrixInstanceType) *
+        m_Field->GetInstanceCount();
+    instanceBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+  }
   instanceBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-  instanceBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
   instanceBufferDesc.MiscFlags = 0;
   instanceBufferDesc.StructureByteStride = 0;
 
   // Give the subresource structure a pointer to the instance data.
-  instanceData.pSysMem = m_Instances;
+  instanceData.pSysMem = m_Field->GetInstances();
   instanceData.SysMemPitch = 0;
   instanceData.SysMemSlicePitch = 0;
 
   // Create the instance buffer.
-  result = device->CreateBuffer(&instanceBufferDesc, &instanceData,
-                                &m_instanceBuffer);
+  result = device->CreateBuffer(
+      &instanceBufferDesc, FOLIAGE_GPU_BILLBOARDS ? &instanceData : NULL,
+      &m_instanceBuffer);
   if (FAILED(result)) {
     return false;
   }
@@ -278,17 +283,6 @@ void FoliageClass::ShutdownBuffers() {
     m_vertexBuffer = 0;
   }
 
-  if (m_Instances) {
-    _aligned_free(m_Instances);
-    m_Instances = 0;
-  }
-
-  // Release the instance array.
-  if (m_Instances) {
-    delete[] m_Instances;
-    m_Instances = 0;
-  }
-
   return;
 }
 
@@ -299,7 +293,11 @@ void FoliageClass::RenderBuffers(ID3D11DeviceContext *deviceContext) {
 
   // Set the buffer strides.
   strides[0] = sizeof(VertexType);
-  strides[1] = sizeof(InstanceType);
+  if (FOLIAGE_GPU_BILLBOARDS) {
+    strides[1] = sizeof(FoliageFieldClass::InstanceType);
+  } else {
+    strides[1] = sizeof(FoliageFieldClass::MatrixInstanceType);
+  }
 
   // Set the buffer offsets.
   offsets[0] = 0;
@@ -349,31 +347,74 @@ void FoliageClass::ReleaseTexture() {
   return;
 }
 
-bool FoliageClass::GeneratePositions() {
+bool FoliageClass::InitializeScatter(unsigned int seed) {
+  float heights[11 * 11];
+  FoliageScatterClass::TerrainType terrain;
+  FoliageScatterClass::RuleType rule;
+  bool result;
   int i;
-  float red, green;
 
-  // Create an array to store all the foliage information.
-  m_foliageArray = new FoliageType[m_foliageCount];
-  if (!m_foliageArray) {
+  // The ground is a flat plane, so the terrain is a grid of zero heights
+  // over the square the foliage used to be spread in.
+  for (i = 0; i < 11 * 11; i++) {
+    heights[i] = 0.0f;
+  }
+  terrain.heights = heights;
+  terrain.materials = 0;
+  terrain.width = 11;
+  terrain.height = 11;
+  terrain.originX = -4.5f;
+  terrain.originZ = -4.5f;
+  terrain.gridSpacing = 0.9f;
+
+  // Grass grows where the terrain shaders draw grass, on any material, and
+  // sinks a little into the ground.
+  rule.spacing = FOLIAGE_SPACING;
+  rule.maxSlope = 0.2f;
+  rule.minHeight = -1000.0f;
+  rule.maxHeight = 1000.0f;
+  rule.red = -1;
+  rule.green = -1;
+  rule.blue = -1;
+  rule.offsetY = -0.1f;
+
+  // Create the foliage scatter object.
+  m_Scatter = new FoliageScatterClass;
+  if (!m_Scatter) {
     return false;
   }
 
-  // Seed the random generator.
-  srand((int)time(NULL));
+  // Initialize the foliage scatter object.
+  result = m_Scatter->Initialize(terrain, rule, FOLIAGE_CHUNK_SIZE, seed);
+  if (!result) {
+    return false;
+  }
 
-  // Set random positions and random colors for each piece of foliage.
-  for (i = 0; i < m_foliageCount; i++) {
-    m_foliageArray[i].x = ((float)rand() / (float)(RAND_MAX)) * 9.0f - 4.5f;
-    m_foliageArray[i].z = ((float)rand() / (float)(RAND_MAX)) * 9.0f - 4.5f;
+  return true;
+}
 
-    red = ((float)rand() / (float)(RAND_MAX)) * 1.0f;
-    green = ((float)rand() / (float)(RAND_MAX)) * 1.0f;
+bool FoliageClass::UpdateInstances(ID3D11DeviceContext *deviceContext) {
+  std::vector<FoliageFieldClass::InstanceType> instances;
+  ID3D11Device *device;
+  float minX, minZ, maxX, maxZ;
+  bool result;
 
-    m_foliageArray[i].r = red + 1.0f;
-    m_foliageArray[i].g = green + 0.5f;
-    m_foliageArray[i].b = 0.0f;
+  // Sort the instances of the loaded chunks into cells again.
+  m_Scatter->GetInstances(instances);
+  m_Scatter->GetBounds(minX, minZ, maxX, maxZ);
+  result = m_Field->Initialize(instances.data(), (int)instances.size(), minX,
+                               minZ, maxX, maxZ, FOLIAGE_CELL_SIZE);
+  if (!result) {
+    return false;
+  }
+
+  // Create the instance buffer for them on the device of the context.
+  deviceContext->GetDevice(&device);
+  result = InitializeInstanceBuffer(device);
+  device->Release();
+  if (!result) {
+    return false;
   }
 
   return true;
-}
\ No newline at end of file
+}
@@ -4,17 +4,40 @@
 #ifndef _FOLIAGECLASS_H_
 #define _FOLIAGECLASS_H_
 
+/////////////
+// GLOBALS //
+/////////////
+// Billboard and sway the foliage in the vertex shader from the static
+// instances. When false the world matrices of the visible blades are built
+// on the CPU every frame instead.
+const bool FOLIAGE_GPU_BILLBOARDS = true;
+
+// Side of the square cells the foliage is grouped into.
+const float FOLIAGE_CELL_SIZE = 4.0f;
+
+// Cells farther than this from the camera are neither updated nor drawn.
+const float FOLIAGE_DRAW_DISTANCE = 60.0f;
+
+// Wind phase added every frame, a full sway back and forth in 400 frames.
+const float FOLIAGE_WIND_PHASE_STEP = 0.0157079633f;
+
+// Side of the square chunks the foliage is scattered in, and the closest two
+// blades may be, about 500 blades over the ground plane.
+const float FOLIAGE_CHUNK_SIZE = 8.0f;
+const float FOLIAGE_SPACING = 0.31f;
+
 //////////////
 // INCLUDES //
 //////////////
 #include <DirectXMath.h>
 #include <d3d11.h>
-#include <time.h>
 using namespace DirectX;
 
 ///////////////////////
 // MY CLASS INCLUDES //
 ///////////////////////
+#include "foliagefieldclass.h"
+#include "foliagescatterclass.h"
 #include "textureclass.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -27,50 +50,44 @@ private:
     XMFLOAT2 texture;
   };
 
-  struct FoliageType {
-    float x, z;
-    float r, g, b;
-  };
-
-  struct InstanceType {
-    XMMATRIX matrix;
-    XMFLOAT3 color;
-  };
-
 public:
   FoliageClass();
   FoliageClass(const FoliageClass &);
   ~FoliageClass();
 
-  bool Initialize(ID3D11Device *, WCHAR *, int);
+  bool Initialize(ID3D11Device *, WCHAR *, unsigned int);
   void Shutdown();
   void Render(ID3D11DeviceContext *);
   bool Frame(XMFLOAT3, ID3D11DeviceContext *);
 
   int GetVertexCount();
   int GetInstanceCount();
+  int GetRangeCount();
+  const int *GetRangeStarts();
+  const int *GetRangeCounts();
+  float GetWindPhase();
 
   ID3D11ShaderResourceView *GetTexture();
 
 private:
   bool InitializeBuffers(ID3D11Device *);
+  bool InitializeInstanceBuffer(ID3D11Device *);
   void ShutdownBuffers();
   void RenderBuffers(ID3D11DeviceContext *);
 
   bool LoadTexture(ID3D11Device *, WCHAR *);
   void ReleaseTexture();
 
-  bool GeneratePositions();
+  bool InitializeScatter(unsigned int);
+  bool UpdateInstances(ID3D11DeviceContext *);
 
 private:
-  int m_foliageCount;
-  FoliageType *m_foliageArray;
-  InstanceType *m_Instances;
+  FoliageScatterClass *m_Scatter;
+  FoliageFieldClass *m_Field;
   ID3D11Buffer *m_vertexBuffer, *m_instanceBuffer;
   int m_vertexCount, m_instanceCount;
   TextureClass *m_Texture;
-  float m_windRotation;
-  int m_windDirection;
+  float m_windPhase;
 };
 
 #endif
\ No newline at end of file
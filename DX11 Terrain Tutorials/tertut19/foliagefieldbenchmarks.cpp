@@ -0,0 +1,170 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: foliagefieldbenchmarks.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "foliagefieldbenchmarks.h"
+
+#include "foliagefieldclass.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int kBladeCount = 1000000;
+const float kFieldSize = 200.0f;
+const float kCellSize = 8.0f;
+const float kDrawDistance = 60.0f;
+const int kFrames = 10;
+
+template <typename Func> double MeasureMilliseconds(Func &&func) {
+  const auto start = Clock::now();
+  func();
+  const auto end = Clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void Multiply(const float a[16], const float b[16], float result[16]) {
+  for (int row = 0; row < 4; row++) {
+    for (int column = 0; column < 4; column++) {
+      result[row * 4 + column] = 0.0f;
+      for (int k = 0; k < 4; k++) {
+        result[row * 4 + column] += a[row * 4 + k] * b[k * 4 + column];
+      }
+    }
+  }
+}
+
+// What FoliageClass::Frame used to do for every blade on one thread: the
+// facing angle from atan2, three matrices and two multiplies.
+void OldMatrix(const FoliageFieldClass::InstanceType &instance, float cameraX,
+               float cameraZ, float windPhase,
+               FoliageFieldClass::MatrixInstanceType &output) {
+  const float facing =
+      (float)atan2(instance.x - cameraX, instance.z - cameraZ);
+  const float sway = FOLIAGE_WIND_AMPLITUDE * sinf(windPhase + instance.seed);
+  const float rotateY[16] = {cosf(facing), 0.0f, -sinf(facing), 0.0f,
+                             0.0f,         1.0f, 0.0f,          0.0f,
+                             sinf(facing), 0.0f, cosf(facing),  0.0f,
+                             0.0f,         0.0f, 0.0f,          1.0f};
+  const float rotateX[16] = {1.0f, 0.0f,        0.0f,       0.0f,
+                             0.0f, cosf(sway),  sinf(sway), 0.0f,
+                             0.0f, -sinf(sway), cosf(sway), 0.0f,
+                             0.0f, 0.0f,        0.0f,       1.0f};
+  const float translate[16] = {1.0f,       0.0f,       0.0f,       0.0f,
+                               0.0f,       1.0f,       0.0f,       0.0f,
+                               0.0f,       0.0f,       1.0f,       0.0f,
+                               instance.x, instance.y, instance.z, 1.0f};
+  float rotate[16];
+
+  Multiply(rotateY, rotateX, rotate);
+  Multiply(rotate, translate, output.matrix);
+  output.r = instance.r;
+  output.g = instance.g;
+  output.b = instance.b;
+  output.padding = 0.0f;
+}
+
+} // namespace
+
+bool RunFoliageFieldBenchmarks() {
+  std::vector<FoliageFieldClass::InstanceType> instances(kBladeCount);
+  std::vector<FoliageFieldClass::MatrixInstanceType> oldMatrices(kBladeCount),
+      upload(kBladeCount), matrices(kBladeCount);
+  FoliageFieldClass field;
+  double oldMs, matrixMs, selectMs;
+  unsigned int seed;
+  float cameraX, cameraZ, windPhase, error;
+  int frame, output, visible, ranges;
+  bool consistent;
+
+  // A million blades over a 200 x 200 field, 25 to the square unit.
+  seed = 1;
+  for (FoliageFieldClass::InstanceType &instance : instances) {
+    seed = seed * 1664525u + 1013904223u;
+    instance.x = (float)(seed >> 8) / (float)(1 << 24) * kFieldSize;
+    seed = seed * 1664525u + 1013904223u;
+    instance.z = (float)(seed >> 8) / (float)(1 << 24) * kFieldSize;
+    seed = seed * 1664525u + 1013904223u;
+    instance.seed = (float)(seed >> 8) / (float)(1 << 24) * 6.2831853f;
+    instance.y = -0.1f;
+    instance.r = 1.5f;
+    instance.g = 1.0f;
+    instance.b = 0.0f;
+  }
+  if (!field.Initialize(instances.data(), kBladeCount, 0.0f, 0.0f,
+                        kFieldSize, kFieldSize, kCellSize)) {
+    printf("Could not initialize the foliage field\n");
+    return false;
+  }
+
+  // The camera walks across the field while the wind blows.
+  oldMs = 0.0;
+  matrixMs = 0.0;
+  selectMs = 0.0;
+  visible = 0;
+  ranges = 0;
+  for (frame = 0; frame < kFrames; frame++) {
+    cameraX = 40.0f + 12.0f * (float)frame;
+    cameraZ = 70.0f + 5.0f * (float)frame;
+    windPhase = 0.0157f * (float)frame;
+
+    oldMs += MeasureMilliseconds([&] {
+      for (int i = 0; i < kBladeCount; i++) {
+        OldMatrix(instances[i], cameraX, cameraZ, windPhase, oldMatrices[i]);
+      }
+      memcpy(upload.data(), oldMatrices.data(),
+             sizeof(FoliageFieldClass::MatrixInstanceType) * kBladeCount);
+    });
+    selectMs += MeasureMilliseconds(
+        [&] { field.SelectCells(cameraX, cameraZ, kDrawDistance); });
+    matrixMs += MeasureMilliseconds([&] {
+      field.SelectCells(cameraX, cameraZ, kDrawDistance);
+      field.CalculateMatrices(cameraX, cameraZ, windPhase, matrices.data());
+    });
+    visible += field.GetVisibleCount();
+    ranges += field.GetRangeCount();
+  }
+
+  // The matrices of the last frame must match the old ones for the same
+  // blades.
+  consistent = true;
+  output = 0;
+  for (int range = 0; range < field.GetRangeCount() && consistent; range++) {
+    for (int i = 0; i < field.GetRangeCounts()[range]; i++) {
+      OldMatrix(field.GetInstances()[field.GetRangeStarts()[range] + i],
+                cameraX, cameraZ, windPhase, oldMatrices[0]);
+      for (int k = 0; k < 16; k++) {
+        error = fabsf(oldMatrices[0].matrix[k] - matrices[output].matrix[k]);
+        if (error > 1e-4f) {
+          consistent = false;
+        }
+      }
+      output++;
+    }
+  }
+
+  printf("%d blades, cells of %.0f, drawn within %.0f: %d visible and %d "
+         "draws per frame\n",
+         kBladeCount, kCellSize, kDrawDistance, visible / kFrames,
+         ranges / kFrames);
+  printf("  old per-blade matrices      %8.2f ms %8d KB uploaded\n",
+         oldMs / kFrames,
+         (int)(sizeof(FoliageFieldClass::MatrixInstanceType) * kBladeCount /
+               1024));
+  printf("  SSE, threaded cell matrices %8.2f ms %8d KB uploaded\n",
+         matrixMs / kFrames,
+         (int)(sizeof(FoliageFieldClass::MatrixInstanceType) *
+               (visible / kFrames) / 1024));
+  printf("  cell selection for shader   %8.2f ms %8d KB uploaded\n",
+         selectMs / kFrames, 0);
+
+  if (!consistent) {
+    printf("Cell matrices differ from the old matrices\n");
+  }
+  return consistent;
+}
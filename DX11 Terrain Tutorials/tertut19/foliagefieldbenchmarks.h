@@ -0,0 +1,14 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: foliagefieldbenchmarks.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _FOLIAGEFIELDBENCHMARKS_H_
+#define _FOLIAGEFIELDBENCHMARKS_H_
+
+// Headless foliage frames over a million blades: prints the time and upload
+// size of the old per-blade matrices for the whole field, of the vectorized
+// and threaded matrices for the cells near the camera, and of the cell
+// selection alone that the shader path needs. Returns false if the matrices
+// differ from the old ones.
+bool RunFoliageFieldBenchmarks();
+
+#endif
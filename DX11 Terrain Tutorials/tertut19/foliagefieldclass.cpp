@@ -0,0 +1,429 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: foliagefieldclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "foliagefieldclass.h"
+
+#include "JobSystem.h"
+
+#include <emmintrin.h>
+#include <math.h>
+
+FoliageFieldClass::FoliageFieldClass() {
+  m_minX = 0.0f;
+  m_minZ = 0.0f;
+  m_cellSize = 1.0f;
+  m_cellCountX = 0;
+  m_cellCountZ = 0;
+  m_visibleCount = 0;
+}
+
+FoliageFieldClass::FoliageFieldClass(const FoliageFieldClass &other) {}
+
+FoliageFieldClass::~FoliageFieldClass() {}
+
+bool FoliageFieldClass::Initialize(const InstanceType *instances, int count,
+                                   float minX, float minZ, float maxX,
+                                   float maxZ, float cellSize) {
+  std::vector<int> cells, next;
+  int i, cellCount;
+
+  if (count < 0 || cellSize <= 0.0f || maxX < minX || maxZ < minZ) {
+    return false;
+  }
+
+  // Cover the field with cells; instances outside it go to the border cells.
+  m_minX = minX;
+  m_minZ = minZ;
+  m_cellSize = cellSize;
+  m_cellCountX = (int)ceilf((maxX - minX) / cellSize);
+  m_cellCountZ = (int)ceilf((maxZ - minZ) / cellSize);
+  if (m_cellCountX < 1) {
+    m_cellCountX = 1;
+  }
+  if (m_cellCountZ < 1) {
+    m_cellCountZ = 1;
+  }
+  cellCount = m_cellCountX * m_cellCountZ;
+
+  // Count the instances of every cell, turn the counts into the first
+  // instance of every cell, then place the instances in cell order.
+  cells.resize(count);
+  m_cellStarts.assign(cellCount + 1, 0);
+  for (i = 0; i < count; i++) {
+    cells[i] = GetCell(instances[i].x, instances[i].z);
+    m_cellStarts[cells[i] + 1]++;
+  }
+  for (i = 0; i < cellCount; i++) {
+    m_cellStarts[i + 1] += m_cellStarts[i];
+  }
+
+  m_instances.resize(count);
+  next.assign(m_cellStarts.begin(), m_cellStarts.end() - 1);
+  for (i = 0; i < count; i++) {
+    m_instances[next[cells[i]]++] = instances[i];
+  }
+
+  // The matrix fallback reads the instances as separate arrays, four at a
+  // time, with the sine and cosine of every seed ready for the sway.
+  m_positionX.resize(count);
+  m_positionY.resize(count);
+  m_positionZ.resize(count);
+  m_seedSin.resize(count);
+  m_seedCos.resize(count);
+  m_colorR.resize(count);
+  m_colorG.resize(count);
+  m_colorB.resize(count);
+  for (i = 0; i < count; i++) {
+    m_positionX[i] = m_instances[i].x;
+    m_positionY[i] = m_instances[i].y;
+    m_positionZ[i] = m_instances[i].z;
+    m_seedSin[i] = sinf(m_instances[i].seed);
+    m_seedCos[i] = cosf(m_instances[i].seed);
+    m_colorR[i] = m_instances[i].r;
+    m_colorG[i] = m_instances[i].g;
+    m_colorB[i] = m_instances[i].b;
+  }
+
+  m_rangeStarts.clear();
+  m_rangeCounts.clear();
+  m_visibleCount = 0;
+
+  return true;
+}
+
+void FoliageFieldClass::Shutdown() {
+  // Release the instances, cells and ranges.
+  std::vector<InstanceType>().swap(m_instances);
+  std::vector<int>().swap(m_cellStarts);
+  std::vector<float>().swap(m_positionX);
+  std::vector<float>().swap(m_positionY);
+  std::vector<float>().swap(m_positionZ);
+  std::vector<float>().swap(m_seedSin);
+  std::vector<float>().swap(m_seedCos);
+  std::vector<float>().swap(m_colorR);
+  std::vector<float>().swap(m_colorG);
+  std::vector<float>().swap(m_colorB);
+  std::vector<int>().swap(m_rangeStarts);
+  std::vector<int>().swap(m_rangeCounts);
+  std::vector<int>().swap(m_blockStarts);
+  std::vector<int>().swap(m_blockCounts);
+  std::vector<int>().swap(m_blockOutputs);
+
+  m_cellCountX = 0;
+  m_cellCountZ = 0;
+  m_visibleCount = 0;
+
+  return;
+}
+
+const FoliageFieldClass::InstanceType *FoliageFieldClass::GetInstances() {
+  return m_instances.data();
+}
+
+int FoliageFieldClass::GetInstanceCount() { return (int)m_instances.size(); }
+
+int FoliageFieldClass::GetCellCount() { return m_cellCountX * m_cellCountZ; }
+
+void FoliageFieldClass::SelectCells(float cameraX, float cameraZ,
+                                    float radius) {
+  float cellMinX, cellMinZ, distanceX, distanceZ;
+  int firstX, firstZ, lastX, lastZ, x, z, cell, start, count, last;
+
+  m_rangeStarts.clear();
+  m_rangeCounts.clear();
+  m_visibleCount = 0;
+
+  if (m_cellCountX == 0 || radius < 0.0f) {
+    return;
+  }
+
+  // The cells under the square around the circle, clipped to the grid.
+  firstX = (int)floorf((cameraX - radius - m_minX) / m_cellSize);
+  lastX = (int)floorf((cameraX + radius - m_minX) / m_cellSize);
+  firstZ = (int)floorf((cameraZ - radius - m_minZ) / m_cellSize);
+  lastZ = (int)floorf((cameraZ + radius - m_minZ) / m_cellSize);
+  if (lastX < 0 || lastZ < 0 || firstX >= m_cellCountX ||
+      firstZ >= m_cellCountZ) {
+    return;
+  }
+  firstX = (firstX < 0) ? 0 : firstX;
+  firstZ = (firstZ < 0) ? 0 : firstZ;
+  lastX = (lastX >= m_cellCountX) ? m_cellCountX - 1 : lastX;
+  lastZ = (lastZ >= m_cellCountZ) ? m_cellCountZ - 1 : lastZ;
+
+  for (z = firstZ; z <= lastZ; z++) {
+    // Distance along z from the camera to the row, zero inside it.
+    cellMinZ = m_minZ + (float)z * m_cellSize;
+    distanceZ = 0.0f;
+    if (cameraZ < cellMinZ) {
+      distanceZ = cellMinZ - cameraZ;
+    } else if (cameraZ > cellMinZ + m_cellSize) {
+      distanceZ = cameraZ - (cellMinZ + m_cellSize);
+    }
+
+    for (x = firstX; x <= lastX; x++) {
+      cellMinX = m_minX + (float)x * m_cellSize;
+      distanceX = 0.0f;
+      if (cameraX < cellMinX) {
+        distanceX = cellMinX - cameraX;
+      } else if (cameraX > cellMinX + m_cellSize) {
+        distanceX = cameraX - (cellMinX + m_cellSize);
+      }
+      if (distanceX * distanceX + distanceZ * distanceZ > radius * radius) {
+        continue;
+      }
+
+      cell = m_cellCountX * z + x;
+      start = m_cellStarts[cell];
+      count = m_cellStarts[cell + 1] - start;
+      if (count == 0) {
+        continue;
+      }
+
+      // Cells next to each other in memory join the same range.
+      last = (int)m_rangeStarts.size() - 1;
+      if (last >= 0 && m_rangeStarts[last] + m_rangeCounts[last] == start) {
+        m_rangeCounts[last] += count;
+      } else {
+        m_rangeStarts.push_back(start);
+        m_rangeCounts.push_back(count);
+      }
+      m_visibleCount += count;
+    }
+  }
+
+  return;
+}
+
+int FoliageFieldClass::GetRangeCount() { return (int)m_rangeStarts.size(); }
+
+const int *FoliageFieldClass::GetRangeStarts() { return m_rangeStarts.data(); }
+
+const int *FoliageFieldClass::GetRangeCounts() { return m_rangeCounts.data(); }
+
+int FoliageFieldClass::GetVisibleCount() { return m_visibleCount; }
+
+void FoliageFieldClass::CalculateMatrices(float cameraX, float cameraZ,
+                                          float windPhase,
+                                          MatrixInstanceType *matrices) {
+  float sinPhase, cosPhase;
+  int range, offset, count, output;
+
+  // Split the selected ranges into blocks, each with its place in the
+  // packed output.
+  m_blockStarts.clear();
+  m_blockCounts.clear();
+  m_blockOutputs.clear();
+  output = 0;
+  for (range = 0; range < (int)m_rangeStarts.size(); range++) {
+    for (offset = 0; offset < m_rangeCounts[range];
+         offset += FOLIAGE_MATRIX_BLOCK) {
+      count = m_rangeCounts[range] - offset;
+      if (count > FOLIAGE_MATRIX_BLOCK) {
+        count = FOLIAGE_MATRIX_BLOCK;
+      }
+      m_blockStarts.push_back(m_rangeStarts[range] + offset);
+      m_blockCounts.push_back(count);
+      m_blockOutputs.push_back(output);
+      output += count;
+    }
+  }
+
+  // The phase is shared, so sin(phase + seed) only needs the sine and
+  // cosine of each seed.
+  sinPhase = sinf(windPhase);
+  cosPhase = cosf(windPhase);
+
+  JobSystem::GetShared().ParallelFor((int)m_blockStarts.size(), [&](int block) {
+    CalculateBlock(m_blockStarts[block], m_blockCounts[block], cameraX,
+                   cameraZ, sinPhase, cosPhase,
+                   matrices + m_blockOutputs[block]);
+  });
+
+  return;
+}
+
+int FoliageFieldClass::GetCell(float x, float z) {
+  int cellX, cellZ;
+
+  cellX = (int)floorf((x - m_minX) / m_cellSize);
+  cellZ = (int)floorf((z - m_minZ) / m_cellSize);
+  cellX = (cellX < 0) ? 0 : (cellX >= m_cellCountX) ? m_cellCountX - 1 : cellX;
+  cellZ = (cellZ < 0) ? 0 : (cellZ >= m_cellCountZ) ? m_cellCountZ - 1 : cellZ;
+
+  return m_cellCountX * cellZ + cellX;
+}
+
+void FoliageFieldClass::CalculateBlock(int first, int count, float cameraX,
+                                       float cameraZ, float sinPhase,
+                                       float cosPhase,
+                                       MatrixInstanceType *matrices) {
+  __m128 zero, one, amplitude, positionX, positionY, positionZ, toX, toZ,
+      lengthSquared, facing, inverseLength, sinY, cosY, sway, swaySquared,
+      series, sinX, cosX, row0, row1, row2, row3;
+  int i;
+
+  zero = _mm_setzero_ps();
+  one = _mm_set1_ps(1.0f);
+  amplitude = _mm_set1_ps(FOLIAGE_WIND_AMPLITUDE);
+
+  // Four blades at a time.
+  for (i = 0; i + 4 <= count; i += 4) {
+    const int index = first + i;
+
+    // The facing angle: sine and cosine of atan2(toX, toZ) straight from the
+    // direction, with no rotation for a blade right under the camera.
+    positionX = _mm_loadu_ps(&m_positionX[index]);
+    positionY = _mm_loadu_ps(&m_positionY[index]);
+    positionZ = _mm_loadu_ps(&m_positionZ[index]);
+    toX = _mm_sub_ps(positionX, _mm_set1_ps(cameraX));
+    toZ = _mm_sub_ps(positionZ, _mm_set1_ps(cameraZ));
+    lengthSquared = _mm_add_ps(_mm_mul_ps(toX, toX), _mm_mul_ps(toZ, toZ));
+    facing = _mm_cmpgt_ps(lengthSquared, zero);
+    inverseLength = _mm_div_ps(
+        one, _mm_sqrt_ps(_mm_or_ps(_mm_and_ps(facing, lengthSquared),
+                                   _mm_andnot_ps(facing, one))));
+    sinY = _mm_and_ps(facing, _mm_mul_ps(toX, inverseLength));
+    cosY = _mm_or_ps(_mm_and_ps(facing, _mm_mul_ps(toZ, inverseLength)),
+                     _mm_andnot_ps(facing, one));
+
+    // The sway angle stays within ten degrees, where a few terms of the
+    // series give its sine and cosine to float precision.
+    sway = _mm_mul_ps(
+        amplitude,
+        _mm_add_ps(
+            _mm_mul_ps(_mm_loadu_ps(&m_seedSin[index]), _mm_set1_ps(cosPhase)),
+            _mm_mul_ps(_mm_loadu_ps(&m_seedCos[index]),
+                       _mm_set1_ps(sinPhase))));
+    swaySquared = _mm_mul_ps(sway, sway);
+    series =
+        _mm_sub_ps(one, _mm_mul_ps(swaySquared, _mm_set1_ps(1.0f / 20.0f)));
+    series = _mm_sub_ps(
+        one, _mm_mul_ps(_mm_mul_ps(swaySquared, _mm_set1_ps(1.0f / 6.0f)),
+                        series));
+    sinX = _mm_mul_ps(sway, series);
+    series =
+        _mm_sub_ps(one, _mm_mul_ps(swaySquared, _mm_set1_ps(1.0f / 30.0f)));
+    series = _mm_sub_ps(
+        one, _mm_mul_ps(_mm_mul_ps(swaySquared, _mm_set1_ps(1.0f / 12.0f)),
+                        series));
+    cosX = _mm_sub_ps(
+        one, _mm_mul_ps(_mm_mul_ps(swaySquared, _mm_set1_ps(0.5f)), series));
+
+    // Rotation about y, then about x, then the translation. Each transpose
+    // turns one row of the four matrices into a row per blade.
+    row0 = cosY;
+    row1 = _mm_mul_ps(sinY, sinX);
+    row2 = _mm_sub_ps(zero, _mm_mul_ps(sinY, cosX));
+    row3 = zero;
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+    _mm_storeu_ps(matrices[i + 0].matrix, row0);
+    _mm_storeu_ps(matrices[i + 1].matrix, row1);
+    _mm_storeu_ps(matrices[i + 2].matrix, row2);
+    _mm_storeu_ps(matrices[i + 3].matrix, row3);
+
+    row0 = zero;
+    row1 = cosX;
+    row2 = sinX;
+    row3 = zero;
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+    _mm_storeu_ps(matrices[i + 0].matrix + 4, row0);
+    _mm_storeu_ps(matrices[i + 1].matrix + 4, row1);
+    _mm_storeu_ps(matrices[i + 2].matrix + 4, row2);
+    _mm_storeu_ps(matrices[i + 3].matrix + 4, row3);
+
+    row0 = sinY;
+    row1 = _mm_sub_ps(zero, _mm_mul_ps(cosY, sinX));
+    row2 = _mm_mul_ps(cosY, cosX);
+    row3 = zero;
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+    _mm_storeu_ps(matrices[i + 0].matrix + 8, row0);
+    _mm_storeu_ps(matrices[i + 1].matrix + 8, row1);
+    _mm_storeu_ps(matrices[i + 2].matrix + 8, row2);
+    _mm_storeu_ps(matrices[i + 3].matrix + 8, row3);
+
+    row0 = positionX;
+    row1 = positionY;
+    row2 = positionZ;
+    row3 = one;
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+    _mm_storeu_ps(matrices[i + 0].matrix + 12, row0);
+    _mm_storeu_ps(matrices[i + 1].matrix + 12, row1);
+    _mm_storeu_ps(matrices[i + 2].matrix + 12, row2);
+    _mm_storeu_ps(matrices[i + 3].matrix + 12, row3);
+
+    // And the colors, padding included.
+    row0 = _mm_loadu_ps(&m_colorR[index]);
+    row1 = _mm_loadu_ps(&m_colorG[index]);
+    row2 = _mm_loadu_ps(&m_colorB[index]);
+    row3 = zero;
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+    _mm_storeu_ps(&matrices[i + 0].r, row0);
+    _mm_storeu_ps(&matrices[i + 1].r, row1);
+    _mm_storeu_ps(&matrices[i + 2].r, row2);
+    _mm_storeu_ps(&matrices[i + 3].r, row3);
+  }
+
+  // And the rest one at a time.
+  for (; i < count; i++) {
+    CalculateMatrix(first + i, cameraX, cameraZ, sinPhase, cosPhase,
+                    &matrices[i]);
+  }
+
+  return;
+}
+
+void FoliageFieldClass::CalculateMatrix(int index, float cameraX,
+                                        float cameraZ, float sinPhase,
+                                        float cosPhase,
+                                        MatrixInstanceType *matrix) {
+  float toX, toZ, lengthSquared, inverseLength, sinY, cosY, sway,
+      swaySquared, sinX, cosX;
+  float *m;
+
+  // The same steps as the four-wide loop.
+  toX = m_positionX[index] - cameraX;
+  toZ = m_positionZ[index] - cameraZ;
+  lengthSquared = toX * toX + toZ * toZ;
+  sinY = 0.0f;
+  cosY = 1.0f;
+  if (lengthSquared > 0.0f) {
+    inverseLength = 1.0f / sqrtf(lengthSquared);
+    sinY = toX * inverseLength;
+    cosY = toZ * inverseLength;
+  }
+
+  sway = FOLIAGE_WIND_AMPLITUDE *
+         (m_seedSin[index] * cosPhase + m_seedCos[index] * sinPhase);
+  swaySquared = sway * sway;
+  sinX = sway * (1.0f - swaySquared * (1.0f / 6.0f) *
+                            (1.0f - swaySquared * (1.0f / 20.0f)));
+  cosX = 1.0f - swaySquared * 0.5f *
+                    (1.0f - swaySquared * (1.0f / 12.0f) *
+                                (1.0f - swaySquared * (1.0f / 30.0f)));
+
+  m = matrix->matrix;
+  m[0] = cosY;
+  m[1] = sinY * sinX;
+  m[2] = -(sinY * cosX);
+  m[3] = 0.0f;
+  m[4] = 0.0f;
+  m[5] = cosX;
+  m[6] = sinX;
+  m[7] = 0.0f;
+  m[8] = sinY;
+  m[9] = -(cosY * sinX);
+  m[10] = cosY * cosX;
+  m[11] = 0.0f;
+  m[12] = m_positionX[index];
+  m[13] = m_positionY[index];
+  m[14] = m_positionZ[index];
+  m[15] = 1.0f;
+
+  matrix->r = m_colorR[index];
+  matrix->g = m_colorG[index];
+  matrix->b = m_colorB[index];
+  matrix->padding = 0.0f;
+
+  return;
+}
@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: foliagefieldclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _FOLIAGEFIELDCLASS_H_
+#define _FOLIAGEFIELDCLASS_H_
+
+/////////////
+// GLOBALS //
+/////////////
+// Largest wind sway of a blade, ten degrees in radians. The foliage vertex
+// shader uses the same value.
+const float FOLIAGE_WIND_AMPLITUDE = 0.174532925f;
+
+// Matrices one thread builds at a time.
+const int FOLIAGE_MATRIX_BLOCK = 4096;
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: FoliageFieldClass
+//
+// The static foliage instances of a field, sorted into a grid of square
+// cells so the instances of a cell are contiguous. Every frame the cells
+// within a distance of the camera are selected as a few ranges of
+// instances, one draw each, and nothing else is touched.
+//
+// A blade is turned about y to face the camera, then swayed about x by
+// FOLIAGE_WIND_AMPLITUDE * sin(windPhase + seed), then moved to its position.
+// The vertex shader does this from the static instances. As a fallback the
+// same world matrices are built here for the selected ranges, four blades
+// at a time with SSE and blocks of blades spread over threads.
+//
+// Only plain CPU code: no device is needed, so it is unit tested headless.
+////////////////////////////////////////////////////////////////////////////////
+class FoliageFieldClass {
+public:
+  struct InstanceType {
+    float x, y, z;
+    float seed;
+    float r, g, b;
+  };
+
+  // The layout of the matrix instance buffer: a row-major world matrix for
+  // row vectors and the color, padded to 16 bytes.
+  struct MatrixInstanceType {
+    float matrix[16];
+    float r, g, b;
+    float padding;
+  };
+
+public:
+  FoliageFieldClass();
+  FoliageFieldClass(const FoliageFieldClass &);
+  ~FoliageFieldClass();
+
+  bool Initialize(const InstanceType *, int, float, float, float, float,
+                  float);
+  void Shutdown();
+
+  const InstanceType *GetInstances();
+  int GetInstanceCount();
+  int GetCellCount();
+
+  void SelectCells(float, float, float);
+  int GetRangeCount();
+  const int *GetRangeStarts();
+  const int *GetRangeCounts();
+  int GetVisibleCount();
+
+  void CalculateMatrices(float, float, float, MatrixInstanceType *);
+
+private:
+  int GetCell(float, float);
+  void CalculateBlock(int, int, float, float, float, float,
+                      MatrixInstanceType *);
+  void CalculateMatrix(int, float, float, float, float, MatrixInstanceType *);
+
+private:
+  float m_minX, m_minZ, m_cellSize;
+  int m_cellCountX, m_cellCountZ;
+  std::vector<InstanceType> m_instances;
+  std::vector<int> m_cellStarts;
+  std::vector<float> m_positionX, m_positionY, m_positionZ;
+  std::vector<float> m_seedSin, m_seedCos;
+  std::vector<float> m_colorR, m_colorG, m_colorB;
+  std::vector<int> m_rangeStarts, m_rangeCounts;
+  int m_visibleCount;
+  std::vector<int> m_blockStarts, m_blockCounts, m_blockOutputs;
+};
+
+#endif
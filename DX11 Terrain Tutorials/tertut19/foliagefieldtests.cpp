@@ -0,0 +1,451 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: foliagefieldtests.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "foliagefieldtests.h"
+
+#include "foliagefieldclass.h"
+
+#include <windows.h>
+
+#include <exception>
+#include <math.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+const float kTolerance = 1e-5f;
+
+float NextRandom(unsigned int &seed) {
+  seed = seed * 1664525u + 1013904223u;
+  return (float)(seed >> 8) / (float)(1 << 24);
+}
+
+// Blades spread over [minX, minX + size] x [minZ, minZ + size], a few of
+// them past the edges.
+std::vector<FoliageFieldClass::InstanceType>
+MakeInstances(int count, float minX, float minZ, float size,
+              unsigned int seed) {
+  std::vector<FoliageFieldClass::InstanceType> instances(count);
+  for (FoliageFieldClass::InstanceType &instance : instances) {
+    instance.x = minX + (NextRandom(seed) * 1.1f - 0.05f) * size;
+    instance.y = NextRandom(seed) - 0.5f;
+    instance.z = minZ + (NextRandom(seed) * 1.1f - 0.05f) * size;
+    instance.seed = NextRandom(seed) * 6.2831853f;
+    instance.r = NextRandom(seed) + 1.0f;
+    instance.g = NextRandom(seed) + 0.5f;
+    instance.b = NextRandom(seed);
+  }
+  return instances;
+}
+
+bool SameInstance(const FoliageFieldClass::InstanceType &a,
+                  const FoliageFieldClass::InstanceType &b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z && a.seed == b.seed &&
+         a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+void Multiply(const float a[16], const float b[16], float result[16]) {
+  for (int row = 0; row < 4; row++) {
+    for (int column = 0; column < 4; column++) {
+      result[row * 4 + column] = 0.0f;
+      for (int k = 0; k < 4; k++) {
+        result[row * 4 + column] += a[row * 4 + k] * b[k * 4 + column];
+      }
+    }
+  }
+}
+
+// The world matrix built the way FoliageClass::Frame used to: the facing
+// angle from atan2, rotations about y and x and a translation, multiplied
+// together.
+void ReferenceMatrix(const FoliageFieldClass::InstanceType &instance,
+                     float cameraX, float cameraZ, float windPhase,
+                     float matrix[16]) {
+  const float facing =
+      (float)atan2(instance.x - cameraX, instance.z - cameraZ);
+  const float sway = FOLIAGE_WIND_AMPLITUDE * sinf(windPhase + instance.seed);
+  const float rotateY[16] = {cosf(facing), 0.0f, -sinf(facing), 0.0f,
+                             0.0f,         1.0f, 0.0f,          0.0f,
+                             sinf(facing), 0.0f, cosf(facing),  0.0f,
+                             0.0f,         0.0f, 0.0f,          1.0f};
+  const float rotateX[16] = {1.0f, 0.0f,        0.0f,       0.0f,
+                             0.0f, cosf(sway),  sinf(sway), 0.0f,
+                             0.0f, -sinf(sway), cosf(sway), 0.0f,
+                             0.0f, 0.0f,        0.0f,       1.0f};
+  const float translate[16] = {1.0f,       0.0f,       0.0f,       0.0f,
+                               0.0f,       1.0f,       0.0f,       0.0f,
+                               0.0f,       0.0f,       1.0f,       0.0f,
+                               instance.x, instance.y, instance.z, 1.0f};
+  float rotate[16];
+
+  Multiply(rotateY, rotateX, rotate);
+  Multiply(rotate, translate, matrix);
+}
+
+float DistanceToSpan(float value, float low, float high) {
+  if (value < low) {
+    return low - value;
+  }
+  if (value > high) {
+    return value - high;
+  }
+  return 0.0f;
+}
+
+// The instances of every cell within the radius, found by checking each
+// cell of the grid.
+std::vector<int> ReferenceSelection(FoliageFieldClass &field, float minX,
+                                    float minZ, float cellSize,
+                                    int cellCountX, float cameraX,
+                                    float cameraZ, float radius) {
+  const FoliageFieldClass::InstanceType *instances = field.GetInstances();
+  std::vector<int> selected;
+
+  for (int i = 0; i < field.GetInstanceCount(); i++) {
+    int cellX = (int)floorf((instances[i].x - minX) / cellSize);
+    int cellZ = (int)floorf((instances[i].z - minZ) / cellSize);
+    const int cellCountZ = field.GetCellCount() / cellCountX;
+    cellX = (cellX < 0) ? 0 : (cellX >= cellCountX) ? cellCountX - 1 : cellX;
+    cellZ = (cellZ < 0) ? 0 : (cellZ >= cellCountZ) ? cellCountZ - 1 : cellZ;
+
+    const float distanceX = DistanceToSpan(
+        cameraX, minX + cellX * cellSize, minX + (cellX + 1) * cellSize);
+    const float distanceZ = DistanceToSpan(
+        cameraZ, minZ + cellZ * cellSize, minZ + (cellZ + 1) * cellSize);
+    if (distanceX * distanceX + distanceZ * distanceZ <= radius * radius) {
+      selected.push_back(i);
+    }
+  }
+  return selected;
+}
+
+bool SelectionMatches(FoliageFieldClass &field, float minX, float minZ,
+                      float cellSize, int cellCountX, float cameraX,
+                      float cameraZ, float radius, std::string &message) {
+  const std::vector<int> expected = ReferenceSelection(
+      field, minX, minZ, cellSize, cellCountX, cameraX, cameraZ, radius);
+  std::vector<int> actual;
+
+  field.SelectCells(cameraX, cameraZ, radius);
+  for (int range = 0; range < field.GetRangeCount(); range++) {
+    // Ranges are in order, apart and never empty.
+    if (field.GetRangeCounts()[range] <= 0) {
+      message = "empty range";
+      return false;
+    }
+    if (range > 0 && field.GetRangeStarts()[range] <=
+                         field.GetRangeStarts()[range - 1] +
+                             field.GetRangeCounts()[range - 1]) {
+      message = "ranges touch or overlap";
+      return false;
+    }
+    for (int i = 0; i < field.GetRangeCounts()[range]; i++) {
+      actual.push_back(field.GetRangeStarts()[range] + i);
+    }
+  }
+
+  if (actual != expected) {
+    message = "wrong instances around " + std::to_string(cameraX) + ", " +
+              std::to_string(cameraZ) + " within " + std::to_string(radius);
+    return false;
+  }
+  if (field.GetVisibleCount() != (int)expected.size()) {
+    message = "wrong visible count";
+    return false;
+  }
+  return true;
+}
+
+bool MatricesMatch(FoliageFieldClass &field, float cameraX, float cameraZ,
+                   float windPhase, std::string &message) {
+  const FoliageFieldClass::InstanceType *instances = field.GetInstances();
+  std::vector<FoliageFieldClass::MatrixInstanceType> matrices;
+  float expected[16];
+  int output;
+
+  // Every entry starts out as garbage, and one spare entry past the end
+  // must stay untouched.
+  matrices.resize(field.GetVisibleCount() + 1);
+  for (FoliageFieldClass::MatrixInstanceType &matrix : matrices) {
+    matrix.padding = 7.0f;
+  }
+  field.CalculateMatrices(cameraX, cameraZ, windPhase, matrices.data());
+  if (matrices.back().padding != 7.0f) {
+    message = "wrote past the visible instances";
+    return false;
+  }
+
+  output = 0;
+  for (int range = 0; range < field.GetRangeCount(); range++) {
+    for (int i = 0; i < field.GetRangeCounts()[range]; i++) {
+      const FoliageFieldClass::InstanceType &instance =
+          instances[field.GetRangeStarts()[range] + i];
+      const FoliageFieldClass::MatrixInstanceType &actual = matrices[output];
+      ReferenceMatrix(instance, cameraX, cameraZ, windPhase, expected);
+      for (int k = 0; k < 16; k++) {
+        if (fabsf(actual.matrix[k] - expected[k]) > kTolerance) {
+          message = "wrong matrix element " + std::to_string(k) +
+                    " for output " + std::to_string(output);
+          return false;
+        }
+      }
+      if (actual.r != instance.r || actual.g != instance.g ||
+          actual.b != instance.b || actual.padding != 0.0f) {
+        message = "wrong color for output " + std::to_string(output);
+        return false;
+      }
+      output++;
+    }
+  }
+  return true;
+}
+
+bool TestCellOrder(std::string &message) {
+  const std::vector<FoliageFieldClass::InstanceType> instances =
+      MakeInstances(5000, -20.0f, 10.0f, 40.0f, 1);
+  FoliageFieldClass field;
+  std::vector<bool> used(instances.size(), false);
+
+  if (!field.Initialize(instances.data(), (int)instances.size(), -20.0f, 10.0f,
+                        20.0f, 50.0f, 3.0f)) {
+    message = "Initialize failed";
+    return false;
+  }
+  if (field.GetInstanceCount() != (int)instances.size() ||
+      field.GetCellCount() != 14 * 14) {
+    message = "wrong instance or cell count";
+    return false;
+  }
+
+  // Every instance once, and the cells in row order.
+  const FoliageFieldClass::InstanceType *sorted = field.GetInstances();
+  int lastCell = 0;
+  for (int i = 0; i < field.GetInstanceCount(); i++) {
+    bool found = false;
+    for (size_t j = 0; j < instances.size() && !found; j++) {
+      if (!used[j] && SameInstance(sorted[i], instances[j])) {
+        used[j] = true;
+        found = true;
+      }
+    }
+    if (!found) {
+      message = "instance " + std::to_string(i) + " is not in the input";
+      return false;
+    }
+
+    int cellX = (int)floorf((sorted[i].x + 20.0f) / 3.0f);
+    int cellZ = (int)floorf((sorted[i].z - 10.0f) / 3.0f);
+    cellX = (cellX < 0) ? 0 : (cellX > 13) ? 13 : cellX;
+    cellZ = (cellZ < 0) ? 0 : (cellZ > 13) ? 13 : cellZ;
+    if (cellZ * 14 + cellX < lastCell) {
+      message = "instances out of cell order";
+      return false;
+    }
+    lastCell = cellZ * 14 + cellX;
+  }
+
+  // Nothing to select before the first frame.
+  return field.GetRangeCount() == 0 && field.GetVisibleCount() == 0;
+}
+
+bool TestSelectCells(std::string &message) {
+  const std::vector<FoliageFieldClass::InstanceType> instances =
+      MakeInstances(20000, 0.0f, 0.0f, 100.0f, 2);
+  FoliageFieldClass field;
+  unsigned int seed = 3;
+
+  if (!field.Initialize(instances.data(), (int)instances.size(), 0.0f, 0.0f,
+                        100.0f, 100.0f, 8.0f)) {
+    message = "Initialize failed";
+    return false;
+  }
+
+  // Cameras inside, along the edges and outside the field.
+  for (int test = 0; test < 200; test++) {
+    const float cameraX = NextRandom(seed) * 160.0f - 30.0f;
+    const float cameraZ = NextRandom(seed) * 160.0f - 30.0f;
+    const float radius = NextRandom(seed) * 50.0f;
+    if (!SelectionMatches(field, 0.0f, 0.0f, 8.0f, 13, cameraX, cameraZ,
+                          radius, message)) {
+      return false;
+    }
+  }
+
+  // A circle around the whole field selects everything as one range.
+  field.SelectCells(50.0f, 50.0f, 200.0f);
+  if (field.GetRangeCount() != 1 ||
+      field.GetRangeCounts()[0] != (int)instances.size()) {
+    message = "whole field is not one range";
+    return false;
+  }
+
+  // And one far away selects nothing.
+  field.SelectCells(500.0f, -500.0f, 100.0f);
+  if (field.GetRangeCount() != 0 || field.GetVisibleCount() != 0) {
+    message = "selected cells far away";
+    return false;
+  }
+  return true;
+}
+
+bool TestMatrices(std::string &message) {
+  std::vector<FoliageFieldClass::InstanceType> instances =
+      MakeInstances(3001, -4.5f, -4.5f, 9.0f, 4);
+  FoliageFieldClass field;
+
+  // A blade right under the camera, with no direction to face.
+  instances[17].x = 1.25f;
+  instances[17].z = -2.0f;
+
+  if (!field.Initialize(instances.data(), (int)instances.size(), -4.5f, -4.5f,
+                        4.5f, 4.5f, 2.0f)) {
+    message = "Initialize failed";
+    return false;
+  }
+
+  // Wind phases over a whole period, the camera inside and outside.
+  for (int step = 0; step < 8; step++) {
+    const float windPhase = (float)step * 0.9f;
+    field.SelectCells(1.25f, -2.0f, 3.0f + (float)step);
+    if (!MatricesMatch(field, 1.25f, -2.0f, windPhase, message)) {
+      return false;
+    }
+    field.SelectCells(-20.0f, 30.0f, 60.0f);
+    if (!MatricesMatch(field, -20.0f, 30.0f, windPhase, message)) {
+      message += " from outside";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestFewBlades(std::string &message) {
+  std::vector<FoliageFieldClass::InstanceType> instances =
+      MakeInstances(3, 0.0f, 0.0f, 4.0f, 6);
+  FoliageFieldClass field;
+
+  // Fewer than four blades all take the one-at-a-time path, one of them
+  // right under the camera.
+  instances[1].x = 2.0f;
+  instances[1].z = 3.0f;
+  if (!field.Initialize(instances.data(), (int)instances.size(), 0.0f, 0.0f,
+                        4.0f, 4.0f, 1.0f)) {
+    message = "Initialize failed";
+    return false;
+  }
+  field.SelectCells(2.0f, 3.0f, 10.0f);
+  if (field.GetVisibleCount() != 3) {
+    message = "not all blades visible";
+    return false;
+  }
+  return MatricesMatch(field, 2.0f, 3.0f, 4.0f, message);
+}
+
+bool TestManyBlocks(std::string &message) {
+  const std::vector<FoliageFieldClass::InstanceType> instances =
+      MakeInstances(50003, 0.0f, 0.0f, 60.0f, 5);
+  FoliageFieldClass field;
+
+  // Ranges long enough to be split into several blocks, with odd lengths
+  // that leave blades for the scalar tail.
+  if (!field.Initialize(instances.data(), (int)instances.size(), 0.0f, 0.0f,
+                        60.0f, 60.0f, 7.0f)) {
+    message = "Initialize failed";
+    return false;
+  }
+  field.SelectCells(25.0f, 35.0f, 22.0f);
+  if (field.GetVisibleCount() <= 2 * FOLIAGE_MATRIX_BLOCK) {
+    message = "too few visible instances to test blocks";
+    return false;
+  }
+  if (!MatricesMatch(field, 25.0f, 35.0f, 2.5f, message)) {
+    return false;
+  }
+
+  field.SelectCells(30.0f, 30.0f, 100.0f);
+  return MatricesMatch(field, 30.0f, 30.0f, -1.0f, message);
+}
+
+bool TestEmptyField(std::string &message) {
+  FoliageFieldClass field;
+  FoliageFieldClass::MatrixInstanceType unused;
+
+  if (!field.Initialize(0, 0, 0.0f, 0.0f, 10.0f, 10.0f, 1.0f)) {
+    message = "Initialize failed";
+    return false;
+  }
+  field.SelectCells(5.0f, 5.0f, 100.0f);
+  field.CalculateMatrices(5.0f, 5.0f, 0.0f, &unused);
+  if (field.GetRangeCount() != 0 || field.GetVisibleCount() != 0) {
+    message = "selected instances in an empty field";
+    return false;
+  }
+
+  // Bad cells or bounds are refused.
+  if (field.Initialize(0, 0, 0.0f, 0.0f, 10.0f, 10.0f, 0.0f) ||
+      field.Initialize(0, 0, 0.0f, 0.0f, -10.0f, 10.0f, 1.0f)) {
+    message = "accepted a bad field";
+    return false;
+  }
+  return true;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(6);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("Cell order", TestCellOrder);
+  run("Select cells", TestSelectCells);
+  run("Matrices", TestMatrices);
+  run("Few blades", TestFewBlades);
+  run("Many blocks", TestManyBlocks);
+  run("Empty field", TestEmptyField);
+
+  return results;
+}
+
+} // namespace
+
+bool RunFoliageFieldTests() {
+  const std::vector<TestCaseResult> results = RunAllTestsInternal();
+  bool allPassed = true;
+  std::string line;
+
+  for (const TestCaseResult &result : results) {
+    if (!result.passed) {
+      allPassed = false;
+      line = "FoliageFieldTests: Test failed: " + result.name;
+      if (!result.message.empty()) {
+        line += " - " + result.message;
+      }
+      line += "\n";
+      OutputDebugStringA(line.c_str());
+    }
+  }
+
+  return allPassed;
+}
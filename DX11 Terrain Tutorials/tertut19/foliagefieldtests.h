@@ -0,0 +1,14 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: foliagefieldtests.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _FOLIAGEFIELDTESTS_H_
+#define _FOLIAGEFIELDTESTS_H_
+
+// Headless tests of FoliageFieldClass: instances sorted into cells, the
+// ranges selected around the camera against a cell-by-cell check, and the
+// vectorized and threaded matrices against the rotations built one by one.
+// Failures are written to the debugger output. Returns false if any test
+// fails.
+bool RunFoliageFieldTests();
+
+#endif
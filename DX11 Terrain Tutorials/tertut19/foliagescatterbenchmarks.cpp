@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: foliagescatterbenchmarks.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "foliagescatterbenchmarks.h"
+
+#include "foliagescatterclass.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int kTerrainSize = 513;
+const float kChunkSize = 16.0f;
+const float kSpacing = 0.35f;
+
+template <typename Func> double MeasureMilliseconds(Func &&func) {
+  const auto start = Clock::now();
+  func();
+  const auto end = Clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+bool SameBytes(const std::vector<FoliageFieldClass::InstanceType> &a,
+               const std::vector<FoliageFieldClass::InstanceType> &b) {
+  return a.size() == b.size() &&
+         (a.empty() || memcmp(a.data(), b.data(),
+                              a.size() * sizeof(a[0])) == 0);
+}
+
+} // namespace
+
+bool RunFoliageScatterBenchmarks() {
+  std::vector<float> heights((size_t)kTerrainSize * kTerrainSize);
+  std::vector<FoliageFieldClass::InstanceType> serial, parallel, cached,
+      chunk;
+  FoliageScatterClass::TerrainType terrain;
+  FoliageScatterClass::RuleType rule;
+  FoliageScatterClass scatter, writer, reader;
+  double serialMs, parallelMs, writeMs, readMs;
+  int chunks, x, z;
+  bool consistent;
+
+  // Rolling hills, steep enough in places for the slope rule to matter.
+  for (z = 0; z < kTerrainSize; z++) {
+    for (x = 0; x < kTerrainSize; x++) {
+      heights[(size_t)z * kTerrainSize + x] =
+          12.0f * sinf((float)x * 0.045f) * cosf((float)z * 0.037f) +
+          3.0f * sinf((float)(x + 2 * z) * 0.11f);
+    }
+  }
+  terrain.heights = heights.data();
+  terrain.materials = 0;
+  terrain.width = kTerrainSize;
+  terrain.height = kTerrainSize;
+  terrain.originX = 0.0f;
+  terrain.originZ = 0.0f;
+  terrain.gridSpacing = 1.0f;
+
+  rule.spacing = kSpacing;
+  rule.maxSlope = 0.2f;
+  rule.minHeight = -1000.0f;
+  rule.maxHeight = 1000.0f;
+  rule.red = -1;
+  rule.green = -1;
+  rule.blue = -1;
+  rule.offsetY = -0.1f;
+
+  if (!scatter.Initialize(terrain, rule, kChunkSize, 2024) ||
+      !writer.Initialize(terrain, rule, kChunkSize, 2024) ||
+      !reader.Initialize(terrain, rule, kChunkSize, 2024)) {
+    printf("Could not initialize the foliage scatter\n");
+    return false;
+  }
+  chunks = (int)((float)(kTerrainSize - 1) / kChunkSize);
+
+  // Every chunk on this thread, in the order Update keeps them.
+  serialMs = MeasureMilliseconds([&] {
+    for (int j = 0; j <= chunks; j++) {
+      for (int i = 0; i <= chunks; i++) {
+        scatter.GenerateChunk(i, j, chunk);
+        serial.insert(serial.end(), chunk.begin(), chunk.end());
+      }
+    }
+  });
+
+  // The same chunks on all cores.
+  parallelMs = MeasureMilliseconds([&] {
+    scatter.Update(256.0f, 256.0f, 1000.0f);
+    scatter.GetInstances(parallel);
+  });
+
+  // Written to the cache once, then read back instead of sampled.
+  writer.SetCacheDirectory(".");
+  reader.SetCacheDirectory(".");
+  writeMs = MeasureMilliseconds(
+      [&] { writer.Update(256.0f, 256.0f, 1000.0f); });
+  readMs = MeasureMilliseconds([&] {
+    reader.Update(256.0f, 256.0f, 1000.0f);
+    reader.GetInstances(cached);
+  });
+  for (z = 0; z <= chunks; z++) {
+    for (x = 0; x <= chunks; x++) {
+      remove(writer.GetChunkFilename(x, z).c_str());
+    }
+  }
+
+  consistent = SameBytes(serial, parallel) && SameBytes(serial, cached);
+
+  printf("%d blades in %d chunks of %.0f, spaced %.2f apart\n",
+         (int)serial.size(), scatter.GetChunkCount(), kChunkSize, kSpacing);
+  printf("  sampled on one thread     %8.2f ms\n", serialMs);
+  printf("  sampled on all cores      %8.2f ms\n", parallelMs);
+  printf("  sampled and cached        %8.2f ms\n", writeMs);
+  printf("  loaded from the cache     %8.2f ms\n", readMs);
+
+  if (!consistent) {
+    printf("Scattered chunks differ between runs\n");
+  }
+  return consistent;
+}
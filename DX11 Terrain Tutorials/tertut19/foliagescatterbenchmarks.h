@@ -0,0 +1,13 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: foliagescatterbenchmarks.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _FOLIAGESCATTERBENCHMARKS_H_
+#define _FOLIAGESCATTERBENCHMARKS_H_
+
+// Headless scatter of about a million blades over a hilly 512 x 512 terrain:
+// prints the time to sample every chunk on one thread, on all cores, and to
+// load them back from the disk cache. Returns false if the three differ in
+// a single byte.
+bool RunFoliageScatterBenchmarks();
+
+#endif
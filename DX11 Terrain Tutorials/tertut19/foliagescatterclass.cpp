@@ -0,0 +1,647 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: foliagescatterclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "foliagescatterclass.h"
+
+#include "JobSystem.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+// Header of a chunk cache file, followed by the instances.
+struct ChunkFileHeaderType {
+  char magic[4];
+  unsigned int version;
+  unsigned int settingsHash;
+  int chunkX, chunkZ;
+  int instanceCount;
+};
+
+// Scrambles the bits of a value, the finalizer of MurmurHash3.
+unsigned int Mix(unsigned int value) {
+  value ^= value >> 16;
+  value *= 0x85ebca6bu;
+  value ^= value >> 13;
+  value *= 0xc2b2ae35u;
+  value ^= value >> 16;
+  return value;
+}
+
+// Adds bytes to an FNV-1a hash.
+unsigned int HashBytes(unsigned int hash, const void *data, size_t size) {
+  const unsigned char *bytes = (const unsigned char *)data;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+// A random sequence that depends on nothing but its seed.
+class RandomType {
+public:
+  explicit RandomType(unsigned int seed) : m_state(seed) {}
+
+  unsigned int Next() {
+    m_state = m_state * 1664525u + 1013904223u;
+    return Mix(m_state);
+  }
+
+  // In [0, 1), from the top 24 bits so every value is exact.
+  float NextFloat() { return (float)(Next() >> 8) * (1.0f / 16777216.0f); }
+
+private:
+  unsigned int m_state;
+};
+
+float DistanceToSpan(float value, float low, float high) {
+  if (value < low) {
+    return low - value;
+  }
+  if (value > high) {
+    return value - high;
+  }
+  return 0.0f;
+}
+
+} // namespace
+
+FoliageScatterClass::FoliageScatterClass() {
+  m_terrainWidth = 0;
+  m_terrainHeight = 0;
+  m_originX = 0.0f;
+  m_originZ = 0.0f;
+  m_gridSpacing = 1.0f;
+  memset(&m_rule, 0, sizeof(m_rule));
+  m_chunkSize = 1.0f;
+  m_seed = 0;
+  m_settingsHash = 0;
+}
+
+FoliageScatterClass::FoliageScatterClass(const FoliageScatterClass &other) {}
+
+FoliageScatterClass::~FoliageScatterClass() {}
+
+bool FoliageScatterClass::Initialize(const TerrainType &terrain,
+                                     const RuleType &rule, float chunkSize,
+                                     unsigned int seed) {
+  size_t count;
+  unsigned int version;
+
+  // The terrain needs a face to have a slope, and the chunks need room for
+  // at least one point away from their edges.
+  if (!terrain.heights || terrain.width < 2 || terrain.height < 2 ||
+      terrain.gridSpacing <= 0.0f || rule.spacing <= 0.0f ||
+      chunkSize <= rule.spacing) {
+    return false;
+  }
+
+  // Copy the terrain so the caller can release it.
+  m_terrainWidth = terrain.width;
+  m_terrainHeight = terrain.height;
+  m_originX = terrain.originX;
+  m_originZ = terrain.originZ;
+  m_gridSpacing = terrain.gridSpacing;
+  count = (size_t)m_terrainWidth * m_terrainHeight;
+  m_heights.assign(terrain.heights, terrain.heights + count);
+  m_materials.clear();
+  if (terrain.materials) {
+    m_materials.assign(terrain.materials, terrain.materials + count * 3);
+  }
+
+  m_rule = rule;
+  m_chunkSize = chunkSize;
+  m_seed = seed;
+  m_chunks.clear();
+
+  // Calculate the slope of every sample.
+  CalculateSlopes();
+
+  // Everything the placement depends on goes into the hash that names the
+  // cache files, so a changed terrain or rule never reads stale chunks.
+  version = FOLIAGE_SCATTER_VERSION;
+  m_settingsHash = 2166136261u;
+  m_settingsHash = HashBytes(m_settingsHash, &version, sizeof(version));
+  m_settingsHash = HashBytes(m_settingsHash, &m_seed, sizeof(m_seed));
+  m_settingsHash = HashBytes(m_settingsHash, &m_chunkSize, sizeof(m_chunkSize));
+  m_settingsHash = HashBytes(m_settingsHash, &m_rule.spacing, sizeof(float));
+  m_settingsHash = HashBytes(m_settingsHash, &m_rule.maxSlope, sizeof(float));
+  m_settingsHash = HashBytes(m_settingsHash, &m_rule.minHeight, sizeof(float));
+  m_settingsHash = HashBytes(m_settingsHash, &m_rule.maxHeight, sizeof(float));
+  m_settingsHash = HashBytes(m_settingsHash, &m_rule.red, sizeof(int));
+  m_settingsHash = HashBytes(m_settingsHash, &m_rule.green, sizeof(int));
+  m_settingsHash = HashBytes(m_settingsHash, &m_rule.blue, sizeof(int));
+  m_settingsHash = HashBytes(m_settingsHash, &m_rule.offsetY, sizeof(float));
+  m_settingsHash = HashBytes(m_settingsHash, &m_terrainWidth, sizeof(int));
+  m_settingsHash = HashBytes(m_settingsHash, &m_terrainHeight, sizeof(int));
+  m_settingsHash = HashBytes(m_settingsHash, &m_originX, sizeof(float));
+  m_settingsHash = HashBytes(m_settingsHash, &m_originZ, sizeof(float));
+  m_settingsHash = HashBytes(m_settingsHash, &m_gridSpacing, sizeof(float));
+  m_settingsHash =
+      HashBytes(m_settingsHash, m_heights.data(), count * sizeof(float));
+  m_settingsHash =
+      HashBytes(m_settingsHash, m_materials.data(), m_materials.size());
+
+  return true;
+}
+
+void FoliageScatterClass::Shutdown() {
+  // Release the terrain copy and the loaded chunks.
+  std::vector<float>().swap(m_heights);
+  std::vector<float>().swap(m_slopes);
+  std::vector<unsigned char>().swap(m_materials);
+  m_chunks.clear();
+
+  m_terrainWidth = 0;
+  m_terrainHeight = 0;
+
+  return;
+}
+
+void FoliageScatterClass::SetCacheDirectory(const char *directory) {
+  // An empty or null directory turns the cache off.
+  m_cacheDirectory = directory ? directory : "";
+
+  return;
+}
+
+bool FoliageScatterClass::Update(float cameraX, float cameraZ, float radius) {
+  std::vector<std::pair<int, int>> missing;
+  std::vector<std::vector<FoliageFieldClass::InstanceType>> generated;
+  std::map<std::pair<int, int>,
+           std::vector<FoliageFieldClass::InstanceType>>::iterator chunk;
+  float minX, minZ, maxX, maxZ, distanceX, distanceZ, keepRadius;
+  int firstX, firstZ, lastX, lastZ, x, z;
+  bool changed;
+
+  if (m_terrainWidth == 0) {
+    return false;
+  }
+
+  // Drop the chunks more than a chunk past the radius, so moving back and
+  // forth over an edge does not generate the same chunks again and again.
+  changed = false;
+  keepRadius = radius + m_chunkSize;
+  for (chunk = m_chunks.begin(); chunk != m_chunks.end();) {
+    z = chunk->first.first;
+    x = chunk->first.second;
+    distanceX = DistanceToSpan(cameraX, (float)x * m_chunkSize,
+                               (float)(x + 1) * m_chunkSize);
+    distanceZ = DistanceToSpan(cameraZ, (float)z * m_chunkSize,
+                               (float)(z + 1) * m_chunkSize);
+    if (distanceX * distanceX + distanceZ * distanceZ >
+        keepRadius * keepRadius) {
+      chunk = m_chunks.erase(chunk);
+      changed = true;
+    } else {
+      ++chunk;
+    }
+  }
+
+  // The chunks under the square around the circle, clipped to the terrain.
+  GetBounds(minX, minZ, maxX, maxZ);
+  firstX = (int)floorf(((cameraX - radius) > minX ? cameraX - radius : minX) /
+                       m_chunkSize);
+  lastX = (int)floorf(((cameraX + radius) < maxX ? cameraX + radius : maxX) /
+                      m_chunkSize);
+  firstZ = (int)floorf(((cameraZ - radius) > minZ ? cameraZ - radius : minZ) /
+                       m_chunkSize);
+  lastZ = (int)floorf(((cameraZ + radius) < maxZ ? cameraZ + radius : maxZ) /
+                      m_chunkSize);
+
+  // Find the chunks within the radius that are not loaded yet.
+  for (z = firstZ; z <= lastZ; z++) {
+    distanceZ = DistanceToSpan(cameraZ, (float)z * m_chunkSize,
+                               (float)(z + 1) * m_chunkSize);
+    for (x = firstX; x <= lastX; x++) {
+      distanceX = DistanceToSpan(cameraX, (float)x * m_chunkSize,
+                                 (float)(x + 1) * m_chunkSize);
+      if (distanceX * distanceX + distanceZ * distanceZ <= radius * radius &&
+          m_chunks.find(std::make_pair(z, x)) == m_chunks.end()) {
+        missing.push_back(std::make_pair(z, x));
+      }
+    }
+  }
+
+  if (missing.empty()) {
+    return changed;
+  }
+
+  // Every chunk only reads the terrain, so the missing ones are generated
+  // in parallel, then added in order.
+  generated.resize(missing.size());
+  JobSystem::GetShared().ParallelFor((int)missing.size(), [&](int i) {
+    GenerateChunk(missing[i].second, missing[i].first, generated[i]);
+  });
+  for (size_t i = 0; i < missing.size(); i++) {
+    m_chunks[missing[i]].swap(generated[i]);
+  }
+
+  return true;
+}
+
+int FoliageScatterClass::GetChunkCount() { return (int)m_chunks.size(); }
+
+int FoliageScatterClass::GetInstanceCount() {
+  std::map<std::pair<int, int>,
+           std::vector<FoliageFieldClass::InstanceType>>::iterator chunk;
+  int count;
+
+  count = 0;
+  for (chunk = m_chunks.begin(); chunk != m_chunks.end(); ++chunk) {
+    count += (int)chunk->second.size();
+  }
+
+  return count;
+}
+
+void FoliageScatterClass::GetInstances(
+    std::vector<FoliageFieldClass::InstanceType> &instances) {
+  std::map<std::pair<int, int>,
+           std::vector<FoliageFieldClass::InstanceType>>::iterator chunk;
+
+  // The loaded chunks row by row, each in the order it was sampled.
+  instances.clear();
+  instances.reserve(GetInstanceCount());
+  for (chunk = m_chunks.begin(); chunk != m_chunks.end(); ++chunk) {
+    instances.insert(instances.end(), chunk->second.begin(),
+                     chunk->second.end());
+  }
+
+  return;
+}
+
+void FoliageScatterClass::GetBounds(float &minX, float &minZ, float &maxX,
+                                    float &maxZ) {
+  minX = m_originX;
+  minZ = m_originZ;
+  maxX = m_originX + (float)(m_terrainWidth - 1) * m_gridSpacing;
+  maxZ = m_originZ + (float)(m_terrainHeight - 1) * m_gridSpacing;
+
+  return;
+}
+
+void FoliageScatterClass::GenerateChunk(
+    int chunkX, int chunkZ,
+    std::vector<FoliageFieldClass::InstanceType> &instances) {
+  // Use the cached chunk when there is a valid one.
+  if (ReadChunk(chunkX, chunkZ, instances)) {
+    return;
+  }
+
+  SampleChunk(chunkX, chunkZ, instances);
+
+  WriteChunk(chunkX, chunkZ, instances);
+
+  return;
+}
+
+float FoliageScatterClass::GetHeight(float x, float z) {
+  float gridX, gridZ, fractionX, fractionZ, bottom, top;
+  int i, j;
+  size_t index;
+
+  // Interpolate between the four samples around the point, clamped to the
+  // terrain.
+  gridX = (x - m_originX) / m_gridSpacing;
+  gridZ = (z - m_originZ) / m_gridSpacing;
+  gridX = (gridX < 0.0f) ? 0.0f : gridX;
+  gridZ = (gridZ < 0.0f) ? 0.0f : gridZ;
+  i = (int)floorf(gridX);
+  j = (int)floorf(gridZ);
+  i = (i > m_terrainWidth - 2) ? m_terrainWidth - 2 : i;
+  j = (j > m_terrainHeight - 2) ? m_terrainHeight - 2 : j;
+  fractionX = gridX - (float)i;
+  fractionZ = gridZ - (float)j;
+  fractionX = (fractionX > 1.0f) ? 1.0f : fractionX;
+  fractionZ = (fractionZ > 1.0f) ? 1.0f : fractionZ;
+
+  index = (size_t)m_terrainWidth * j + i;
+  bottom = m_heights[index] +
+           (m_heights[index + 1] - m_heights[index]) * fractionX;
+  index += m_terrainWidth;
+  top = m_heights[index] +
+        (m_heights[index + 1] - m_heights[index]) * fractionX;
+
+  return bottom + (top - bottom) * fractionZ;
+}
+
+float FoliageScatterClass::GetSlope(float x, float z) {
+  float gridX, gridZ, fractionX, fractionZ, bottom, top;
+  int i, j;
+  size_t index;
+
+  // Interpolate the slopes the same way as the heights.
+  gridX = (x - m_originX) / m_gridSpacing;
+  gridZ = (z - m_originZ) / m_gridSpacing;
+  gridX = (gridX < 0.0f) ? 0.0f : gridX;
+  gridZ = (gridZ < 0.0f) ? 0.0f : gridZ;
+  i = (int)floorf(gridX);
+  j = (int)floorf(gridZ);
+  i = (i > m_terrainWidth - 2) ? m_terrainWidth - 2 : i;
+  j = (j > m_terrainHeight - 2) ? m_terrainHeight - 2 : j;
+  fractionX = gridX - (float)i;
+  fractionZ = gridZ - (float)j;
+  fractionX = (fractionX > 1.0f) ? 1.0f : fractionX;
+  fractionZ = (fractionZ > 1.0f) ? 1.0f : fractionZ;
+
+  index = (size_t)m_terrainWidth * j + i;
+  bottom =
+      m_slopes[index] + (m_slopes[index + 1] - m_slopes[index]) * fractionX;
+  index += m_terrainWidth;
+  top = m_slopes[index] + (m_slopes[index + 1] - m_slopes[index]) * fractionX;
+
+  return bottom + (top - bottom) * fractionZ;
+}
+
+void FoliageScatterClass::CalculateSlopes() {
+  float sum[3], length;
+  int i, j, faceX, faceZ;
+  size_t index;
+
+  m_slopes.resize((size_t)m_terrainWidth * m_terrainHeight);
+
+  for (j = 0; j < m_terrainHeight; j++) {
+    for (i = 0; i < m_terrainWidth; i++) {
+      // Sum the normals of the up to four faces that touch this sample. The
+      // face from (i, j) to (i + 1, j) and (i, j + 1) has the normal
+      // (h(i, j) - h(i + 1, j), spacing, h(i, j) - h(i, j + 1)) times the
+      // spacing; the common factor drops out when normalizing.
+      sum[0] = 0.0f;
+      sum[1] = 0.0f;
+      sum[2] = 0.0f;
+      for (faceZ = j - 1; faceZ <= j; faceZ++) {
+        for (faceX = i - 1; faceX <= i; faceX++) {
+          if (faceX < 0 || faceZ < 0 || faceX >= m_terrainWidth - 1 ||
+              faceZ >= m_terrainHeight - 1) {
+            continue;
+          }
+          index = (size_t)m_terrainWidth * faceZ + faceX;
+          sum[0] += m_heights[index] - m_heights[index + 1];
+          sum[1] += m_gridSpacing;
+          sum[2] += m_heights[index] - m_heights[index + m_terrainWidth];
+        }
+      }
+
+      // The slope is one minus the up component of the normal, as the
+      // terrain pixel shaders blend their textures by.
+      length = sqrtf(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+      m_slopes[(size_t)m_terrainWidth * j + i] = 1.0f - sum[1] / length;
+    }
+  }
+
+  return;
+}
+
+void FoliageScatterClass::SampleChunk(
+    int chunkX, int chunkZ,
+    std::vector<FoliageFieldClass::InstanceType> &instances) {
+  std::vector<float> pointX, pointZ;
+  std::vector<int> grid, active;
+  FoliageFieldClass::InstanceType instance;
+  float spacing, size, cellSize, candidateX, candidateZ, offsetX, offsetZ,
+      distance, startX, startZ, differenceX, differenceZ;
+  int gridSize, stride, tries, pick, point, cell, neighbour, near[21], k;
+  size_t i;
+
+  instances.clear();
+
+  // The points stay half the spacing inside the chunk, so points of
+  // neighbouring chunks are at least the spacing apart as well.
+  spacing = m_rule.spacing;
+  size = m_chunkSize - spacing;
+  startX = (float)chunkX * m_chunkSize + spacing * 0.5f;
+  startZ = (float)chunkZ * m_chunkSize + spacing * 0.5f;
+
+  // A grid with cells small enough to hold one point at most, and a border
+  // of two empty cells so the neighbours need no bounds checks.
+  cellSize = spacing / sqrtf(2.0f);
+  gridSize = (int)ceilf(size / cellSize);
+  stride = gridSize + 4;
+  grid.assign((size_t)stride * stride, -1);
+
+  // Any point closer than the spacing is in the 5 x 5 cells around, less
+  // the corners, which are a whole spacing away. The nearest cells come
+  // first, as they reject most candidates.
+  k = 0;
+  for (int ring = 0; ring <= 5; ring++) {
+    for (int z = -2; z <= 2; z++) {
+      for (int x = -2; x <= 2; x++) {
+        if (x * x + z * z == ring) {
+          near[k++] = z * stride + x;
+        }
+      }
+    }
+  }
+
+  // The sequence only depends on the seed and the chunk.
+  RandomType random(
+      Mix(m_seed ^ Mix((unsigned int)chunkX * 0x9e3779b9u ^
+                       Mix((unsigned int)chunkZ + 0x7f4a7c15u))));
+
+  // Start from a random point and grow from the active points: try points
+  // between one and two spacings around one, and retire it when none fits.
+  pointX.push_back(random.NextFloat() * size);
+  pointZ.push_back(random.NextFloat() * size);
+  active.push_back(0);
+  cell = ((int)(pointZ[0] / cellSize) + 2) * stride +
+         (int)(pointX[0] / cellSize) + 2;
+  grid[cell] = 0;
+
+  while (!active.empty()) {
+    pick = (int)(random.Next() % (unsigned int)active.size());
+    point = active[pick];
+
+    for (tries = 0; tries < FOLIAGE_SCATTER_TRIES; tries++) {
+      // An offset in the ring, taken from the square around it.
+      do {
+        offsetX = (random.NextFloat() * 4.0f - 2.0f) * spacing;
+        offsetZ = (random.NextFloat() * 4.0f - 2.0f) * spacing;
+        distance = offsetX * offsetX + offsetZ * offsetZ;
+      } while (distance < spacing * spacing ||
+               distance > 4.0f * spacing * spacing);
+
+      candidateX = pointX[point] + offsetX;
+      candidateZ = pointZ[point] + offsetZ;
+      if (candidateX < 0.0f || candidateZ < 0.0f || candidateX >= size ||
+          candidateZ >= size) {
+        continue;
+      }
+
+      cell = ((int)(candidateZ / cellSize) + 2) * stride +
+             (int)(candidateX / cellSize) + 2;
+      for (k = 0; k < 21; k++) {
+        neighbour = grid[cell + near[k]];
+        if (neighbour < 0) {
+          continue;
+        }
+        differenceX = pointX[neighbour] - candidateX;
+        differenceZ = pointZ[neighbour] - candidateZ;
+        if (differenceX * differenceX + differenceZ * differenceZ <
+            spacing * spacing) {
+          break;
+        }
+      }
+      if (k < 21) {
+        continue;
+      }
+
+      grid[cell] = (int)pointX.size();
+      active.push_back((int)pointX.size());
+      pointX.push_back(candidateX);
+      pointZ.push_back(candidateZ);
+      break;
+    }
+
+    if (tries == FOLIAGE_SCATTER_TRIES) {
+      active[pick] = active.back();
+      active.pop_back();
+    }
+  }
+
+  // Keep the points the terrain accepts, with a sway seed and color drawn
+  // for every point either way so one rejection leaves the rest alone.
+  for (i = 0; i < pointX.size(); i++) {
+    instance.x = startX + pointX[i];
+    instance.z = startZ + pointZ[i];
+    instance.seed = random.NextFloat() * 6.28318531f;
+    instance.r = random.NextFloat() + 1.0f;
+    instance.g = random.NextFloat() + 0.5f;
+    instance.b = 0.0f;
+    if (Accept(instance.x, instance.z)) {
+      instance.y = GetHeight(instance.x, instance.z) + m_rule.offsetY;
+      instances.push_back(instance);
+    }
+  }
+
+  return;
+}
+
+bool FoliageScatterClass::Accept(float x, float z) {
+  float minX, minZ, maxX, maxZ, height;
+  int i, j;
+  size_t index;
+
+  // Only on the terrain.
+  GetBounds(minX, minZ, maxX, maxZ);
+  if (x < minX || z < minZ || x > maxX || z > maxZ) {
+    return false;
+  }
+
+  height = GetHeight(x, z);
+  if (height < m_rule.minHeight || height > m_rule.maxHeight) {
+    return false;
+  }
+
+  if (GetSlope(x, z) > m_rule.maxSlope) {
+    return false;
+  }
+
+  // The material of the nearest sample.
+  if (m_rule.red >= 0 && !m_materials.empty()) {
+    i = (int)floorf((x - m_originX) / m_gridSpacing + 0.5f);
+    j = (int)floorf((z - m_originZ) / m_gridSpacing + 0.5f);
+    i = (i > m_terrainWidth - 1) ? m_terrainWidth - 1 : i;
+    j = (j > m_terrainHeight - 1) ? m_terrainHeight - 1 : j;
+    index = ((size_t)m_terrainWidth * j + i) * 3;
+    if (m_materials[index] != m_rule.red ||
+        m_materials[index + 1] != m_rule.green ||
+        m_materials[index + 2] != m_rule.blue) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+std::string FoliageScatterClass::GetChunkFilename(int chunkX, int chunkZ) {
+  char name[64];
+
+  snprintf(name, sizeof(name), "/foliage_%08x_%d_%d.bin", m_settingsHash,
+           chunkX, chunkZ);
+
+  return m_cacheDirectory + name;
+}
+
+bool FoliageScatterClass::ReadChunk(
+    int chunkX, int chunkZ,
+    std::vector<FoliageFieldClass::InstanceType> &instances) {
+  ChunkFileHeaderType header;
+  FILE *filePtr;
+  size_t count, start;
+  errno_t error;
+  int block;
+  bool result;
+
+  if (m_cacheDirectory.empty()) {
+    return false;
+  }
+
+  error = fopen_s(&filePtr, GetChunkFilename(chunkX, chunkZ).c_str(), "rb");
+  if (error != 0) {
+    return false;
+  }
+
+  // A file from other settings, a wrong chunk or a short write is ignored
+  // and the chunk sampled again.
+  count = fread(&header, sizeof(header), 1, filePtr);
+  result = count == 1 && memcmp(header.magic, "FSCT", 4) == 0 &&
+           header.version == FOLIAGE_SCATTER_VERSION &&
+           header.settingsHash == m_settingsHash && header.chunkX == chunkX &&
+           header.chunkZ == chunkZ && header.instanceCount >= 0;
+  // The instances are read a block at a time, so a broken count runs out of
+  // file instead of memory.
+  instances.clear();
+  while (result && (int)instances.size() < header.instanceCount) {
+    start = instances.size();
+    block = header.instanceCount - (int)start;
+    block = (block > 4096) ? 4096 : block;
+    instances.resize(start + block);
+    count = fread(&instances[start], sizeof(FoliageFieldClass::InstanceType),
+                  block, filePtr);
+    result = count == (size_t)block;
+  }
+  result = result && fgetc(filePtr) == EOF;
+  fclose(filePtr);
+
+  if (!result) {
+    instances.clear();
+  }
+
+  return result;
+}
+
+void FoliageScatterClass::WriteChunk(
+    int chunkX, int chunkZ,
+    const std::vector<FoliageFieldClass::InstanceType> &instances) {
+  ChunkFileHeaderType header;
+  FILE *filePtr;
+  errno_t error;
+
+  if (m_cacheDirectory.empty()) {
+    return;
+  }
+
+  error = fopen_s(&filePtr, GetChunkFilename(chunkX, chunkZ).c_str(), "wb");
+  if (error != 0) {
+    return;
+  }
+
+  // A failed write leaves a file the next read rejects.
+  memcpy(header.magic, "FSCT", 4);
+  header.version = FOLIAGE_SCATTER_VERSION;
+  header.settingsHash = m_settingsHash;
+  header.chunkX = chunkX;
+  header.chunkZ = chunkZ;
+  header.instanceCount = (int)instances.size();
+  fwrite(&header, sizeof(header), 1, filePtr);
+  if (!instances.empty()) {
+    fwrite(instances.data(), sizeof(FoliageFieldClass::InstanceType),
+           instances.size(), filePtr);
+  }
+  fclose(filePtr);
+
+  return;
+}
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: foliagescatterclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _FOLIAGESCATTERCLASS_H_
+#define _FOLIAGESCATTERCLASS_H_
+
+/////////////
+// GLOBALS //
+/////////////
+// Candidates tried around a point before the sampler stops growing from it.
+const int FOLIAGE_SCATTER_TRIES = 30;
+
+// Version of the sampling, part of every cache file name and header. Change
+// it whenever the placement changes.
+const unsigned int FOLIAGE_SCATTER_VERSION = 1;
+
+//////////////
+// INCLUDES //
+//////////////
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "foliagefieldclass.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: FoliageScatterClass
+//
+// Places foliage over a terrain in square chunks. Each chunk is filled with
+// a Poisson-disk set, no two points closer than the rule spacing, grown with
+// Bridson's algorithm from a random sequence seeded by the scatter seed and
+// the chunk coordinates alone. Points are kept half the spacing inside
+// their chunk, so chunks never need each other and are generated in any
+// order, on any thread.
+//
+// Every point is then tested against the terrain: the height, the slope as
+// 1 - normal.y of the averaged face normals like the terrain tutorials
+// compute it, and the color of the material map under it. The sampling
+// only adds, multiplies, divides and takes square roots of floats, so a
+// chunk comes out the same bytes on every run; chunks can be cached to disk
+// and compared in tests.
+//
+// Update loads the chunks around the camera, generating the missing ones in
+// parallel, and drops the ones left far behind.
+////////////////////////////////////////////////////////////////////////////////
+class FoliageScatterClass {
+public:
+  // Heights of width x height samples, row after row along x, gridSpacing
+  // apart from (originX, originZ). The optional material map holds a red,
+  // green and blue byte per sample.
+  struct TerrainType {
+    const float *heights;
+    const unsigned char *materials;
+    int width, height;
+    float originX, originZ, gridSpacing;
+  };
+
+  // Where foliage grows: at least spacing apart, no steeper than maxSlope,
+  // between the two heights, and where the material map has this color;
+  // a negative red takes any material. Instances sit offsetY above the
+  // terrain.
+  struct RuleType {
+    float spacing;
+    float maxSlope;
+    float minHeight, maxHeight;
+    int red, green, blue;
+    float offsetY;
+  };
+
+public:
+  FoliageScatterClass();
+  FoliageScatterClass(const FoliageScatterClass &);
+  ~FoliageScatterClass();
+
+  bool Initialize(const TerrainType &, const RuleType &, float, unsigned int);
+  void Shutdown();
+
+  void SetCacheDirectory(const char *);
+
+  bool Update(float, float, float);
+  int GetChunkCount();
+  int GetInstanceCount();
+  void GetInstances(std::vector<FoliageFieldClass::InstanceType> &);
+  void GetBounds(float &, float &, float &, float &);
+
+  void GenerateChunk(int, int, std::vector<FoliageFieldClass::InstanceType> &);
+  std::string GetChunkFilename(int, int);
+
+  float GetHeight(float, float);
+  float GetSlope(float, float);
+
+private:
+  void CalculateSlopes();
+  void SampleChunk(int, int, std::vector<FoliageFieldClass::InstanceType> &);
+  bool Accept(float, float);
+
+  bool ReadChunk(int, int, std::vector<FoliageFieldClass::InstanceType> &);
+  void WriteChunk(int, int,
+                  const std::vector<FoliageFieldClass::InstanceType> &);
+
+private:
+  int m_terrainWidth, m_terrainHeight;
+  float m_originX, m_originZ, m_gridSpacing;
+  std::vector<float> m_heights, m_slopes;
+  std::vector<unsigned char> m_materials;
+  RuleType m_rule;
+  float m_chunkSize;
+  unsigned int m_seed, m_settingsHash;
+  std::string m_cacheDirectory;
+  std::map<std::pair<int, int>, std::vector<FoliageFieldClass::InstanceType>>
+      m_chunks;
+};
+
+#endif
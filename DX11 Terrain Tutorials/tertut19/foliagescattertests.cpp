@@ -0,0 +1,668 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: foliagescattertests.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "foliagescattertests.h"
+
+#include "foliagescatterclass.h"
+
+#include <windows.h>
+
+#include <exception>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestCaseResult {
+  std::string name;
+  bool passed = false;
+  std::string message;
+};
+
+typedef std::vector<FoliageFieldClass::InstanceType> InstanceList;
+
+const float kTolerance = 1e-5f;
+
+// A terrain of width x height samples that keeps its own maps.
+struct TestTerrain {
+  std::vector<float> heights;
+  std::vector<unsigned char> materials;
+  FoliageScatterClass::TerrainType desc;
+
+  TestTerrain(int width, int height, float originX, float originZ,
+              float gridSpacing) {
+    heights.assign((size_t)width * height, 0.0f);
+    desc.heights = heights.data();
+    desc.materials = 0;
+    desc.width = width;
+    desc.height = height;
+    desc.originX = originX;
+    desc.originZ = originZ;
+    desc.gridSpacing = gridSpacing;
+  }
+
+  void AddMaterials() {
+    materials.assign(heights.size() * 3, 0);
+    desc.materials = materials.data();
+  }
+};
+
+FoliageScatterClass::RuleType MakeRule(float spacing) {
+  FoliageScatterClass::RuleType rule;
+  rule.spacing = spacing;
+  rule.maxSlope = 1.0f;
+  rule.minHeight = -1000.0f;
+  rule.maxHeight = 1000.0f;
+  rule.red = -1;
+  rule.green = -1;
+  rule.blue = -1;
+  rule.offsetY = 0.0f;
+  return rule;
+}
+
+bool SameBytes(const InstanceList &a, const InstanceList &b) {
+  return a.size() == b.size() &&
+         (a.empty() || memcmp(a.data(), b.data(),
+                              a.size() * sizeof(a[0])) == 0);
+}
+
+float DistanceSquared(const FoliageFieldClass::InstanceType &a, float x,
+                      float z) {
+  return (a.x - x) * (a.x - x) + (a.z - z) * (a.z - z);
+}
+
+// Every instance sits on the terrain plus the rule offset.
+bool OnTerrain(FoliageScatterClass &scatter, const InstanceList &instances,
+               float offsetY, std::string &message) {
+  for (const FoliageFieldClass::InstanceType &instance : instances) {
+    if (fabsf(instance.y - scatter.GetHeight(instance.x, instance.z) -
+              offsetY) > kTolerance) {
+      message = "instance not on the terrain";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestSpacing(std::string &message) {
+  const float spacing = 0.7f;
+  TestTerrain terrain(49, 49, -24.0f, -24.0f, 1.0f);
+  FoliageScatterClass scatter;
+  InstanceList instances;
+  std::vector<std::vector<int>> buckets(48 * 48);
+  float x, z, nearest;
+  int bucketX, bucketZ;
+
+  if (!scatter.Initialize(terrain.desc, MakeRule(spacing), 4.0f, 7)) {
+    message = "Initialize failed";
+    return false;
+  }
+  scatter.Update(0.0f, 0.0f, 100.0f);
+  scatter.GetInstances(instances);
+  if (scatter.GetChunkCount() != 13 * 13 ||
+      (int)instances.size() != scatter.GetInstanceCount()) {
+    message = "wrong chunk or instance count";
+    return false;
+  }
+
+  // No two instances closer than the spacing, in one chunk or across two.
+  for (size_t i = 0; i < instances.size(); i++) {
+    for (size_t j = i + 1; j < instances.size(); j++) {
+      if (DistanceSquared(instances[i], instances[j].x, instances[j].z) <
+          spacing * spacing) {
+        message = "instances closer than the spacing";
+        return false;
+      }
+    }
+  }
+
+  // And no holes: every spot of the terrain, chunk edges included, has an
+  // instance within two spacings.
+  for (size_t i = 0; i < instances.size(); i++) {
+    bucketX = (int)(instances[i].x + 24.0f);
+    bucketZ = (int)(instances[i].z + 24.0f);
+    bucketX = (bucketX > 47) ? 47 : bucketX;
+    bucketZ = (bucketZ > 47) ? 47 : bucketZ;
+    buckets[bucketZ * 48 + bucketX].push_back((int)i);
+  }
+  for (z = -24.0f; z <= 24.0f; z += 0.25f) {
+    for (x = -24.0f; x <= 24.0f; x += 0.25f) {
+      nearest = 1000.0f;
+      for (bucketZ = (int)(z + 22.0f); bucketZ <= (int)(z + 26.0f);
+           bucketZ++) {
+        for (bucketX = (int)(x + 22.0f); bucketX <= (int)(x + 26.0f);
+             bucketX++) {
+          if (bucketX < 0 || bucketZ < 0 || bucketX >= 48 || bucketZ >= 48) {
+            continue;
+          }
+          for (int index : buckets[bucketZ * 48 + bucketX]) {
+            const float distance = DistanceSquared(instances[index], x, z);
+            nearest = (distance < nearest) ? distance : nearest;
+          }
+        }
+      }
+      if (nearest > 4.0f * spacing * spacing) {
+        message = "hole in the scatter";
+        return false;
+      }
+    }
+  }
+  return OnTerrain(scatter, instances, 0.0f, message);
+}
+
+bool TestSameSeed(std::string &message) {
+  TestTerrain terrain(33, 33, -16.0f, -16.0f, 1.0f);
+  FoliageScatterClass first, second, other;
+  InstanceList a, b, c, shifted;
+  bool anyDifferent, repeated;
+
+  for (size_t i = 0; i < terrain.heights.size(); i++) {
+    terrain.heights[i] = 0.01f * (float)(i % 7);
+  }
+  if (!first.Initialize(terrain.desc, MakeRule(0.5f), 4.0f, 1234) ||
+      !second.Initialize(terrain.desc, MakeRule(0.5f), 4.0f, 1234) ||
+      !other.Initialize(terrain.desc, MakeRule(0.5f), 4.0f, 1235)) {
+    message = "Initialize failed";
+    return false;
+  }
+
+  // The same seed gives the same bytes for every chunk, negative ones too;
+  // another seed gives other points.
+  anyDifferent = false;
+  for (int z = -4; z < 4; z++) {
+    for (int x = -4; x < 4; x++) {
+      first.GenerateChunk(x, z, a);
+      second.GenerateChunk(x, z, b);
+      other.GenerateChunk(x, z, c);
+      if (a.empty() || !SameBytes(a, b)) {
+        message = "same seed, different chunk";
+        return false;
+      }
+      anyDifferent = anyDifferent || !SameBytes(a, c);
+    }
+  }
+  if (!anyDifferent) {
+    message = "different seeds, same chunks";
+    return false;
+  }
+
+  // Neighbouring chunks are not copies of each other.
+  first.GenerateChunk(0, 0, a);
+  first.GenerateChunk(1, 0, shifted);
+  repeated = a.size() == shifted.size();
+  for (size_t i = 0; i < a.size() && repeated; i++) {
+    repeated = fabsf(a[i].x + 4.0f - shifted[i].x) < kTolerance &&
+               a[i].z == shifted[i].z && a[i].seed == shifted[i].seed;
+  }
+  if (repeated) {
+    message = "neighbouring chunks repeat";
+    return false;
+  }
+  return true;
+}
+
+bool TestAnyOrder(std::string &message) {
+  TestTerrain terrain(49, 49, -24.0f, -24.0f, 1.0f);
+  FoliageScatterClass threaded, walked, single;
+  InstanceList all, steps, expected;
+  std::vector<InstanceList> chunks(13 * 13);
+
+  for (int j = 0; j < 49; j++) {
+    for (int i = 0; i < 49; i++) {
+      terrain.heights[j * 49 + i] = 0.1f * (float)i - 0.05f * (float)j;
+    }
+  }
+  if (!threaded.Initialize(terrain.desc, MakeRule(0.6f), 4.0f, 99) ||
+      !walked.Initialize(terrain.desc, MakeRule(0.6f), 4.0f, 99) ||
+      !single.Initialize(terrain.desc, MakeRule(0.6f), 4.0f, 99)) {
+    message = "Initialize failed";
+    return false;
+  }
+
+  // All chunks at once on the worker threads.
+  threaded.Update(0.0f, 0.0f, 100.0f);
+  threaded.GetInstances(all);
+
+  // The same chunks one by one, backwards, on this thread.
+  for (int z = 6; z >= -6; z--) {
+    for (int x = 6; x >= -6; x--) {
+      single.GenerateChunk(x, z, chunks[(z + 6) * 13 + x + 6]);
+    }
+  }
+  for (const InstanceList &list : chunks) {
+    expected.insert(expected.end(), list.begin(), list.end());
+  }
+  if (!SameBytes(all, expected)) {
+    message = "threaded chunks differ from single chunks";
+    return false;
+  }
+
+  // The same chunks again, loaded a few at a time while walking over.
+  for (float step = -30.0f; step <= 30.0f; step += 5.0f) {
+    walked.Update(step, step * 0.5f, 100.0f);
+  }
+  walked.GetInstances(steps);
+  if (!SameBytes(all, steps)) {
+    message = "walked chunks differ from threaded chunks";
+    return false;
+  }
+  return true;
+}
+
+bool TestSlopeRule(std::string &message) {
+  TestTerrain terrain(33, 33, 0.0f, 0.0f, 1.0f);
+  FoliageScatterClass::RuleType rule = MakeRule(0.5f);
+  FoliageScatterClass scatter;
+  InstanceList instances;
+  const float tilted = 1.0f - 1.0f / sqrtf(1.0f + 0.09f + 0.04f);
+
+  // A plane tilted both ways has the same slope everywhere, the one its
+  // normal gives.
+  for (int j = 0; j < 33; j++) {
+    for (int i = 0; i < 33; i++) {
+      terrain.heights[j * 33 + i] = 0.3f * (float)i + 0.2f * (float)j;
+    }
+  }
+  if (!scatter.Initialize(terrain.desc, rule, 4.0f, 5)) {
+    message = "Initialize failed";
+    return false;
+  }
+  for (float z = 0.0f; z <= 32.0f; z += 1.75f) {
+    for (float x = 0.0f; x <= 32.0f; x += 1.75f) {
+      if (fabsf(scatter.GetSlope(x, z) - tilted) > kTolerance ||
+          fabsf(scatter.GetHeight(x, z) - 0.3f * x - 0.2f * z) > 1e-4f) {
+        message = "wrong slope or height on a plane";
+        return false;
+      }
+    }
+  }
+
+  // Flat on the left, a 45 degree hill from x = 16 on. Grass grows below
+  // the slope the terrain shader draws grass on, which the foot of the hill
+  // blends into between x = 16 and 17.
+  for (int j = 0; j < 33; j++) {
+    for (int i = 0; i < 33; i++) {
+      terrain.heights[j * 33 + i] = (i < 16) ? 0.0f : (float)(i - 16);
+    }
+  }
+  rule.maxSlope = 0.2f;
+  rule.offsetY = -0.1f;
+  if (!scatter.Initialize(terrain.desc, rule, 4.0f, 5)) {
+    message = "Initialize failed";
+    return false;
+  }
+  scatter.Update(16.0f, 16.0f, 50.0f);
+  scatter.GetInstances(instances);
+  if (instances.size() < 200) {
+    message = "too few instances on the flat part";
+    return false;
+  }
+  for (const FoliageFieldClass::InstanceType &instance : instances) {
+    if (scatter.GetSlope(instance.x, instance.z) > 0.2f ||
+        instance.x > 17.0f) {
+      message = "instance on the hill";
+      return false;
+    }
+  }
+  return OnTerrain(scatter, instances, -0.1f, message);
+}
+
+bool TestHeightRule(std::string &message) {
+  TestTerrain terrain(33, 33, 0.0f, 0.0f, 1.0f);
+  FoliageScatterClass::RuleType rule = MakeRule(0.5f);
+  FoliageScatterClass scatter;
+  InstanceList instances;
+  bool low, high;
+
+  // A gentle ramp up along z; grass only between heights 2 and 5.
+  for (int j = 0; j < 33; j++) {
+    for (int i = 0; i < 33; i++) {
+      terrain.heights[j * 33 + i] = 0.25f * (float)j;
+    }
+  }
+  rule.minHeight = 2.0f;
+  rule.maxHeight = 5.0f;
+  if (!scatter.Initialize(terrain.desc, rule, 4.0f, 11)) {
+    message = "Initialize failed";
+    return false;
+  }
+  scatter.Update(16.0f, 16.0f, 50.0f);
+  scatter.GetInstances(instances);
+
+  low = false;
+  high = false;
+  for (const FoliageFieldClass::InstanceType &instance : instances) {
+    if (instance.y < 2.0f || instance.y > 5.0f) {
+      message = "instance outside the heights";
+      return false;
+    }
+    low = low || instance.z < 8.5f;
+    high = high || instance.z > 19.5f;
+  }
+  if (!low || !high) {
+    message = "band not filled to its heights";
+    return false;
+  }
+  return OnTerrain(scatter, instances, 0.0f, message);
+}
+
+bool TestMaterialRule(std::string &message) {
+  TestTerrain terrain(33, 33, 0.0f, 0.0f, 1.0f);
+  FoliageScatterClass::RuleType rule = MakeRule(0.5f);
+  FoliageScatterClass scatter, anywhere;
+  InstanceList instances, all;
+  size_t index;
+  int i, j;
+
+  // A checkerboard of red and green squares of four samples.
+  terrain.AddMaterials();
+  for (j = 0; j < 33; j++) {
+    for (i = 0; i < 33; i++) {
+      index = ((size_t)j * 33 + i) * 3;
+      if (((i / 4) + (j / 4)) % 2 == 0) {
+        terrain.materials[index] = 255;
+      } else {
+        terrain.materials[index + 1] = 255;
+      }
+    }
+  }
+  if (!anywhere.Initialize(terrain.desc, rule, 4.0f, 3)) {
+    message = "Initialize failed";
+    return false;
+  }
+  rule.red = 255;
+  rule.green = 0;
+  rule.blue = 0;
+  if (!scatter.Initialize(terrain.desc, rule, 4.0f, 3)) {
+    message = "Initialize failed";
+    return false;
+  }
+  anywhere.Update(16.0f, 16.0f, 50.0f);
+  anywhere.GetInstances(all);
+  scatter.Update(16.0f, 16.0f, 50.0f);
+  scatter.GetInstances(instances);
+
+  // Only on red, which is about half of the terrain.
+  for (const FoliageFieldClass::InstanceType &instance : instances) {
+    i = (int)floorf(instance.x + 0.5f);
+    j = (int)floorf(instance.z + 0.5f);
+    if (terrain.materials[((size_t)j * 33 + i) * 3] != 255) {
+      message = "instance off the material";
+      return false;
+    }
+  }
+  if (instances.size() * 10 < all.size() * 4 ||
+      instances.size() * 10 > all.size() * 6) {
+    message = "material covers the wrong share";
+    return false;
+  }
+  return true;
+}
+
+bool TestCache(std::string &message) {
+  TestTerrain terrain(17, 17, 0.0f, 0.0f, 1.0f);
+  FoliageScatterClass writer, reader, repaired, other;
+  InstanceList written, read, chunk;
+  std::vector<char> bytes;
+  FILE *filePtr;
+  size_t size = 0;
+  errno_t error;
+  bool result;
+
+  for (size_t i = 0; i < terrain.heights.size(); i++) {
+    terrain.heights[i] = 0.02f * (float)(i % 5);
+  }
+  if (!writer.Initialize(terrain.desc, MakeRule(0.5f), 4.0f, 42) ||
+      !reader.Initialize(terrain.desc, MakeRule(0.5f), 4.0f, 42) ||
+      !repaired.Initialize(terrain.desc, MakeRule(0.5f), 4.0f, 42) ||
+      !other.Initialize(terrain.desc, MakeRule(0.5f), 4.0f, 43)) {
+    message = "Initialize failed";
+    return false;
+  }
+  writer.SetCacheDirectory(".");
+  reader.SetCacheDirectory(".");
+  repaired.SetCacheDirectory(".");
+  other.SetCacheDirectory(".");
+  for (int z = 0; z <= 4; z++) {
+    for (int x = 0; x <= 4; x++) {
+      remove(writer.GetChunkFilename(x, z).c_str());
+    }
+  }
+
+  result = true;
+  if (writer.GetChunkFilename(1, 1) == other.GetChunkFilename(1, 1)) {
+    message = "another seed shares the cache files";
+    result = false;
+  }
+
+  // The first scatter writes every chunk.
+  writer.Update(8.0f, 8.0f, 20.0f);
+  writer.GetInstances(written);
+  writer.GenerateChunk(1, 1, chunk);
+  error = fopen_s(&filePtr, writer.GetChunkFilename(1, 1).c_str(), "rb");
+  if (result && error != 0) {
+    message = "no cache file written";
+    result = false;
+  }
+  if (error == 0) {
+    fclose(filePtr);
+  }
+
+  // The second reads them back into the same bytes.
+  if (result) {
+    reader.Update(8.0f, 8.0f, 20.0f);
+    reader.GetInstances(read);
+    if (!SameBytes(written, read)) {
+      message = "cached chunks differ";
+      result = false;
+    }
+  }
+
+  // A changed instance in a file is read as it is, which shows the file is
+  // used at all.
+  if (result) {
+    bytes.resize(sizeof(FoliageFieldClass::InstanceType) * chunk.size() + 64);
+    error = fopen_s(&filePtr, writer.GetChunkFilename(1, 1).c_str(), "rb");
+    size = (error == 0) ? fread(bytes.data(), 1, bytes.size(), filePtr) : 0;
+    if (error == 0) {
+      fclose(filePtr);
+    }
+    if (chunk.empty() || size <= sizeof(chunk[0])) {
+      message = "cache file too short";
+      result = false;
+    }
+  }
+  if (result) {
+    bytes[size - 1] ^= 1;
+    error = fopen_s(&filePtr, writer.GetChunkFilename(1, 1).c_str(), "wb");
+    if (error == 0) {
+      fwrite(bytes.data(), 1, size, filePtr);
+      fclose(filePtr);
+    }
+    reader.GenerateChunk(1, 1, read);
+    if (read.size() != chunk.size() || SameBytes(chunk, read)) {
+      message = "cache file not read";
+      result = false;
+    }
+    bytes[size - 1] ^= 1;
+  }
+
+  // A cut-off file, or one with bytes left over, is sampled again and
+  // written over.
+  for (int extra = -8; extra <= 4 && result; extra += 12) {
+    error = fopen_s(&filePtr, writer.GetChunkFilename(1, 1).c_str(), "wb");
+    if (error == 0) {
+      fwrite(bytes.data(), 1, size + extra, filePtr);
+      fclose(filePtr);
+    }
+    repaired.GenerateChunk(1, 1, read);
+    if (!SameBytes(chunk, read)) {
+      message = "broken cache file not sampled again";
+      result = false;
+    }
+    reader.GenerateChunk(1, 1, read);
+    if (result && !SameBytes(chunk, read)) {
+      message = "broken cache file not written over";
+      result = false;
+    }
+  }
+
+  for (int z = 0; z <= 4; z++) {
+    for (int x = 0; x <= 4; x++) {
+      remove(writer.GetChunkFilename(x, z).c_str());
+      remove(other.GetChunkFilename(x, z).c_str());
+    }
+  }
+  return result;
+}
+
+bool TestStreaming(std::string &message) {
+  const float radius = 20.0f;
+  const float reach = radius + 8.0f + 8.0f * 1.41421356f;
+  TestTerrain terrain(129, 129, -64.0f, -64.0f, 1.0f);
+  FoliageScatterClass scatter;
+  InstanceList first, instances, again;
+
+  if (!scatter.Initialize(terrain.desc, MakeRule(0.8f), 8.0f, 17)) {
+    message = "Initialize failed";
+    return false;
+  }
+
+  // The chunks around the camera, and nothing new without moving.
+  if (!scatter.Update(-40.0f, -40.0f, radius) ||
+      scatter.GetChunkCount() == 0) {
+    message = "no chunks loaded";
+    return false;
+  }
+  scatter.GetInstances(first);
+  if (scatter.Update(-40.0f, -40.0f, radius)) {
+    message = "chunks changed without moving";
+    return false;
+  }
+
+  // Across the terrain the old chunks are dropped.
+  if (!scatter.Update(40.0f, 40.0f, radius)) {
+    message = "no chunks loaded after moving";
+    return false;
+  }
+  scatter.GetInstances(instances);
+  for (const FoliageFieldClass::InstanceType &instance : instances) {
+    if (DistanceSquared(instance, 40.0f, 40.0f) > reach * reach) {
+      message = "far chunk kept";
+      return false;
+    }
+  }
+
+  // Coming back regenerates the same chunks.
+  scatter.Update(-40.0f, -40.0f, radius);
+  scatter.GetInstances(again);
+  if (!SameBytes(first, again)) {
+    message = "chunks changed after coming back";
+    return false;
+  }
+
+  // Off the terrain there is nothing to load.
+  scatter.Update(500.0f, 500.0f, radius);
+  if (scatter.GetChunkCount() != 0) {
+    message = "chunks loaded off the terrain";
+    return false;
+  }
+  return true;
+}
+
+bool TestBadTerrain(std::string &message) {
+  TestTerrain terrain(9, 9, 0.0f, 0.0f, 1.0f);
+  FoliageScatterClass scatter;
+  FoliageScatterClass::TerrainType bad;
+
+  if (scatter.Update(0.0f, 0.0f, 10.0f)) {
+    message = "updated before Initialize";
+    return false;
+  }
+
+  // No heights, a single row, no grid spacing or chunks no wider than the
+  // spacing are refused.
+  bad = terrain.desc;
+  bad.heights = 0;
+  if (scatter.Initialize(bad, MakeRule(0.5f), 4.0f, 1)) {
+    message = "accepted missing heights";
+    return false;
+  }
+  bad = terrain.desc;
+  bad.height = 1;
+  if (scatter.Initialize(bad, MakeRule(0.5f), 4.0f, 1)) {
+    message = "accepted a single row";
+    return false;
+  }
+  bad = terrain.desc;
+  bad.gridSpacing = 0.0f;
+  if (scatter.Initialize(bad, MakeRule(0.5f), 4.0f, 1)) {
+    message = "accepted no grid spacing";
+    return false;
+  }
+  if (scatter.Initialize(terrain.desc, MakeRule(4.0f), 4.0f, 1) ||
+      scatter.Initialize(terrain.desc, MakeRule(0.0f), 4.0f, 1)) {
+    message = "accepted a bad spacing";
+    return false;
+  }
+  return true;
+}
+
+std::vector<TestCaseResult> RunAllTestsInternal() {
+  std::vector<TestCaseResult> results;
+  results.reserve(9);
+
+  auto run = [&results](const std::string &name, auto &&callable) {
+    TestCaseResult result{name};
+    try {
+      result.passed = callable(result.message);
+      if (!result.passed && result.message.empty()) {
+        result.message = "Assertion failed";
+      }
+    } catch (const std::exception &ex) {
+      result.passed = false;
+      result.message = ex.what();
+    } catch (...) {
+      result.passed = false;
+      result.message = "Unknown exception";
+    }
+    results.push_back(result);
+  };
+
+  run("Spacing", TestSpacing);
+  run("Same seed", TestSameSeed);
+  run("Any order", TestAnyOrder);
+  run("Slope rule", TestSlopeRule);
+  run("Height rule", TestHeightRule);
+  run("Material rule", TestMaterialRule);
+  run("Cache", TestCache);
+  run("Streaming", TestStreaming);
+  run("Bad terrain", TestBadTerrain);
+
+  return results;
+}
+
+} // namespace
+
+bool RunFoliageScatterTests() {
+  const std::vector<TestCaseResult> results = RunAllTestsInternal();
+  bool allPassed = true;
+  std::string line;
+
+  for (const TestCaseResult &result : results) {
+    if (!result.passed) {
+      allPassed = false;
+      line = "FoliageScatterTests: Test failed: " + result.name;
+      if (!result.message.empty()) {
+        line += " - " + result.message;
+      }
+      line += "\n";
+      OutputDebugStringA(line.c_str());
+    }
+  }
+
+  return allPassed;
+}
@@ -0,0 +1,14 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: foliagescattertests.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _FOLIAGESCATTERTESTS_H_
+#define _FOLIAGESCATTERTESTS_H_
+
+// Headless tests of FoliageScatterClass: the spacing within and across
+// chunks, the same bytes for the same seed in any order and from the cache,
+// the slope, height and material rules on made-up terrains, and chunks
+// loaded and dropped as the camera moves. Failures are written to the
+// debugger output. Returns false if any test fails.
+bool RunFoliageScatterTests();
+
+#endif
@@ -9,6 +9,9 @@ FoliageShaderClass::FoliageShaderClass() {
   m_layout = 0;
   m_matrixBuffer = 0;
   m_sampleState = 0;
+  m_billboardVertexShader = 0;
+  m_billboardLayout = 0;
+  m_windBuffer = 0;
 }
 
 FoliageShaderClass::FoliageShaderClass(const FoliageShaderClass &other) {}
@@ -25,6 +28,13 @@ bool FoliageShaderClass::Initialize(ID3D11Device *device, HWND hwnd) {
     return false;
   }
 
+  // Initialize the vertex shader that billboards the static instances.
+  result = InitializeBillboardShader(device, hwnd,
+                                     L"../tertut19/foliagebillboard.vs");
+  if (!result) {
+    return false;
+  }
+
   return true;
 }
 
@@ -55,6 +65,33 @@ bool FoliageShaderClass::Render(ID3D11DeviceContext *deviceContext,
   return true;
 }
 
+bool FoliageShaderClass::RenderBillboards(
+    ID3D11DeviceContext *deviceContext, int vertexCount, int rangeCount,
+    const int *rangeStarts, const int *rangeCounts, const XMMATRIX &viewMatrix,
+    const XMMATRIX &projectionMatrix, XMFLOAT3 cameraPosition,
+    float windPhase, ID3D11ShaderResourceView *texture) {
+  bool result;
+
+  // Set the matrices and texture shared with the matrix path.
+  result =
+      SetShaderParameters(deviceContext, viewMatrix, projectionMatrix, texture);
+  if (!result) {
+    return false;
+  }
+
+  // Set the camera position and wind phase the blades are turned by.
+  result = SetWindParameters(deviceContext, cameraPosition, windPhase);
+  if (!result) {
+    return false;
+  }
+
+  // Now render each range of instances with the billboard shader.
+  RenderBillboardShader(deviceContext, vertexCount, rangeCount, rangeStarts,
+                        rangeCounts);
+
+  return true;
+}
+
 bool FoliageShaderClass::InitializeShader(ID3D11Device *device, HWND hwnd,
                                           WCHAR *vsFilename,
                                           WCHAR *psFilename) {
@@ -242,7 +279,135 @@ bool FoliageShaderClass::InitializeShader(ID3D11Device *device, HWND hwnd,
   return true;
 }
 
+bool FoliageShaderClass::InitializeBillboardShader(ID3D11Device *device,
+                                                   HWND hwnd,
+                                                   WCHAR *vsFilename) {
+  HRESULT result;
+  ID3D10Blob *errorMessage;
+  ID3D10Blob *vertexShaderBuffer;
+  D3D11_INPUT_ELEMENT_DESC polygonLayout[4];
+  unsigned int numElements;
+  D3D11_BUFFER_DESC windBufferDesc;
+
+  // Initialize the pointers this function will use to null.
+  errorMessage = 0;
+  vertexShaderBuffer = 0;
+
+  // Compile the vertex shader code.
+  result = D3DCompileFromFile(vsFilename, NULL, NULL,
+                              "FoliageBillboardVertexShader", "vs_5_0",
+                              D3D10_SHADER_ENABLE_STRICTNESS, 0,
+                              &vertexShaderBuffer, &errorMessage);
+  if (FAILED(result)) {
+    // If the shader failed to compile it should have written something to the
+    // error message.
+    if (errorMessage) {
+      OutputShaderErrorMessage(errorMessage, hwnd, vsFilename);
+    }
+    // If there was nothing in the error message then it simply could not find
+    // the shader file itself.
+    else {
+      MessageBox(hwnd, vsFilename, L"Missing Shader File", MB_OK);
+    }
+
+    return false;
+  }
+
+  // Create the vertex shader from the buffer.
+  result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(),
+                                      vertexShaderBuffer->GetBufferSize(), NULL,
+                                      &m_billboardVertexShader);
+  if (FAILED(result)) {
+    return false;
+  }
+
+  // Create the vertex input layout description: the quad corner, then the
+  // position and sway seed and the color of each instance.
+  polygonLayout[0].SemanticName = "POSITION";
+  polygonLayout[0].SemanticIndex = 0;
+  polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+  polygonLayout[0].InputSlot = 0;
+  polygonLayout[0].AlignedByteOffset = 0;
+  polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+  polygonLayout[0].InstanceDataStepRate = 0;
+
+  polygonLayout[1].SemanticName = "TEXCOORD";
+  polygonLayout[1].SemanticIndex = 0;
+  polygonLayout[1].Format = DXGI_FORMAT_R32G32_FLOAT;
+  polygonLayout[1].InputSlot = 0;
+  polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+  polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+  polygonLayout[1].InstanceDataStepRate = 0;
+
+  polygonLayout[2].SemanticName = "TEXCOORD";
+  polygonLayout[2].SemanticIndex = 1;
+  polygonLayout[2].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+  polygonLayout[2].InputSlot = 1;
+  polygonLayout[2].AlignedByteOffset = 0;
+  polygonLayout[2].InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+  polygonLayout[2].InstanceDataStepRate = 1;
+
+  polygonLayout[3].SemanticName = "TEXCOORD";
+  polygonLayout[3].SemanticIndex = 2;
+  polygonLayout[3].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+  polygonLayout[3].InputSlot = 1;
+  polygonLayout[3].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+  polygonLayout[3].InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+  polygonLayout[3].InstanceDataStepRate = 1;
+
+  // Get a count of the elements in the layout.
+  numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
+
+  // Create the vertex input layout.
+  result = device->CreateInputLayout(
+      polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(),
+      vertexShaderBuffer->GetBufferSize(), &m_billboardLayout);
+  if (FAILED(result)) {
+    return false;
+  }
+
+  // Release the vertex shader buffer since it is no longer needed.
+  vertexShaderBuffer->Release();
+  vertexShaderBuffer = 0;
+
+  // Setup the description of the dynamic wind constant buffer that is in the
+  // vertex shader.
+  windBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+  windBufferDesc.ByteWidth = sizeof(WindBufferType);
+  windBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+  windBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+  windBufferDesc.MiscFlags = 0;
+  windBufferDesc.StructureByteStride = 0;
+
+  // Create the constant buffer pointer so we can access the vertex shader
+  // constant buffer from within this class.
+  result = device->CreateBuffer(&windBufferDesc, NULL, &m_windBuffer);
+  if (FAILED(result)) {
+    return false;
+  }
+
+  return true;
+}
+
 void FoliageShaderClass::ShutdownShader() {
+  // Release the wind constant buffer.
+  if (m_windBuffer) {
+    m_windBuffer->Release();
+    m_windBuffer = 0;
+  }
+
+  // Release the billboard layout.
+  if (m_billboardLayout) {
+    m_billboardLayout->Release();
+    m_billboardLayout = 0;
+  }
+
+  // Release the billboard vertex shader.
+  if (m_billboardVertexShader) {
+    m_billboardVertexShader->Release();
+    m_billboardVertexShader = 0;
+  }
+
   // Release the sampler state.
   if (m_sampleState) {
     m_sampleState->Release();
@@ -372,5 +537,64 @@ void FoliageShaderClass::RenderShader(ID3D11DeviceContext *deviceContext,
   // Render the geometry.
   deviceContext->DrawInstanced(vertexCount, instanceCount, 0, 0);
 
+  return;
+}
+
+bool FoliageShaderClass::SetWindParameters(ID3D11DeviceContext *deviceContext,
+                                           XMFLOAT3 cameraPosition,
+                                           float windPhase) {
+  HRESULT result;
+  D3D11_MAPPED_SUBRESOURCE mappedResource;
+  WindBufferType *dataPtr;
+  unsigned int bufferNumber;
+
+  // Lock the wind constant buffer so it can be written to.
+  result = deviceContext->Map(m_windBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0,
+                              &mappedResource);
+  if (FAILED(result)) {
+    return false;
+  }
+
+  // Get a pointer to the data in the constant buffer.
+  dataPtr = (WindBufferType *)mappedResource.pData;
+
+  // Copy the camera position and wind phase into the constant buffer.
+  dataPtr->cameraPosition = cameraPosition;
+  dataPtr->windPhase = windPhase;
+
+  // Unlock the constant buffer.
+  deviceContext->Unmap(m_windBuffer, 0);
+
+  // Set the position of the wind constant buffer in the vertex shader.
+  bufferNumber = 1;
+
+  // Now set the wind constant buffer in the vertex shader with the updated
+  // values.
+  deviceContext->VSSetConstantBuffers(bufferNumber, 1, &m_windBuffer);
+
+  return true;
+}
+
+void FoliageShaderClass::RenderBillboardShader(
+    ID3D11DeviceContext *deviceContext, int vertexCount, int rangeCount,
+    const int *rangeStarts, const int *rangeCounts) {
+  int i;
+
+  // Set the vertex input layout.
+  deviceContext->IASetInputLayout(m_billboardLayout);
+
+  // Set the vertex and pixel shaders that will be used to render the geometry.
+  deviceContext->VSSetShader(m_billboardVertexShader, NULL, 0);
+  deviceContext->PSSetShader(m_pixelShader, NULL, 0);
+
+  // Set the sampler state in the pixel shader.
+  deviceContext->PSSetSamplers(0, 1, &m_sampleState);
+
+  // Render each range of neighbouring cells, starting at its first instance.
+  for (i = 0; i < rangeCount; i++) {
+    deviceContext->DrawInstanced(vertexCount, rangeCounts[i], 0,
+                                 rangeStarts[i]);
+  }
+
   return;
 }
\ No newline at end of file
@@ -24,6 +24,11 @@ private:
     XMMATRIX projection;
   };
 
+  struct WindBufferType {
+    XMFLOAT3 cameraPosition;
+    float windPhase;
+  };
+
 public:
   FoliageShaderClass();
   FoliageShaderClass(const FoliageShaderClass &);
@@ -33,15 +38,22 @@ public:
   void Shutdown();
   bool Render(ID3D11DeviceContext *, int, int, const XMMATRIX &,
               const XMMATRIX &, ID3D11ShaderResourceView *);
+  bool RenderBillboards(ID3D11DeviceContext *, int, int, const int *,
+                        const int *, const XMMATRIX &, const XMMATRIX &,
+                        XMFLOAT3, float, ID3D11ShaderResourceView *);
 
 private:
   bool InitializeShader(ID3D11Device *, HWND, WCHAR *, WCHAR *);
+  bool InitializeBillboardShader(ID3D11Device *, HWND, WCHAR *);
   void ShutdownShader();
   void OutputShaderErrorMessage(ID3D10Blob *, HWND, WCHAR *);
 
   bool SetShaderParameters(ID3D11DeviceContext *, const XMMATRIX &,
                            const XMMATRIX &, ID3D11ShaderResourceView *);
   void RenderShader(ID3D11DeviceContext *, int, int);
+  bool SetWindParameters(ID3D11DeviceContext *, XMFLOAT3, float);
+  void RenderBillboardShader(ID3D11DeviceContext *, int, int, const int *,
+                             const int *);
 
 private:
   ID3D11VertexShader *m_vertexShader;
@@ -49,6 +61,9 @@ private:
   ID3D11InputLayout *m_layout;
   ID3D11Buffer *m_matrixBuffer;
   ID3D11SamplerState *m_sampleState;
+  ID3D11VertexShader *m_billboardVertexShader;
+  ID3D11InputLayout *m_billboardLayout;
+  ID3D11Buffer *m_windBuffer;
 };
 
 #endif
\ No newline at end of file
@@ -1,13 +1,72 @@
 ////////////////////////////////////////////////////////////////////////////////
 // Filename: main.cpp
 ////////////////////////////////////////////////////////////////////////////////
+#include "foliagefieldbenchmarks.h"
+#include "foliagefieldtests.h"
+#include "foliagescatterbenchmarks.h"
+#include "foliagescattertests.h"
 #include "systemclass.h"
 
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+struct StartupTest {
+  const wchar_t *name;
+  bool (*run)();
+};
+
+static const StartupTest startupTests[] = {
+    {L"Foliage field", RunFoliageFieldTests},
+    {L"Foliage scatter", RunFoliageScatterTests},
+};
+
+// Runs the unit tests in order and reports the first failure.
+static bool RunStartupTests() {
+  std::wstring message;
+  int count, i;
+
+  count = (int)(sizeof(startupTests) / sizeof(startupTests[0]));
+  for (i = 0; i < count; i++) {
+    if (!startupTests[i].run()) {
+      message = std::wstring(startupTests[i].name) + L" tests failed.";
+      MessageBox(NULL, message.c_str(), L"Error", MB_OK);
+      return false;
+    }
+  }
+
+  return true;
+}
+
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR pScmdline,
                    int iCmdshow) {
   SystemClass *System;
+  FILE *benchmarkOut;
   bool result;
 
+  // --self-test runs the unit tests and exits. Debug builds also run them on
+  // every start; Release builds go straight to the window.
+  if (pScmdline && strstr(pScmdline, "--self-test")) {
+    return RunStartupTests() ? 0 : 1;
+  }
+#ifdef _DEBUG
+  if (!RunStartupTests()) {
+    return 1;
+  }
+#endif
+
+  // Headless benchmark mode: run the benchmarks on a console and exit
+  // without creating a window or device.
+  if (pScmdline && strstr(pScmdline, "--benchmark")) {
+    AllocConsole();
+    freopen_s(&benchmarkOut, "CONOUT$", "w", stdout);
+    result = RunFoliageFieldBenchmarks();
+    result = RunFoliageScatterBenchmarks() && result;
+    FreeConsole();
+    return result ? 0 : 1;
+  }
+
   // Create the system object.
   System = new SystemClass;
   if (!System) {
@@ -114,4 +114,16 @@ void ShaderManagerClass::RenderFoliageShader(
   m_FoliageShader->Render(deviceContext, vertexCount, instanceCount, viewMatrix,
                           projectionMatrix, texture);
   return;
+}
+
+void ShaderManagerClass::RenderFoliageBillboardShader(
+    ID3D11DeviceContext *deviceContext, int vertexCount, int rangeCount,
+    const int *rangeStarts, const int *rangeCounts, const XMMATRIX &viewMatrix,
+    const XMMATRIX &projectionMatrix, XMFLOAT3 cameraPosition, float windPhase,
+    ID3D11ShaderResourceView *texture) {
+  m_FoliageShader->RenderBillboards(deviceContext, vertexCount, rangeCount,
+                                    rangeStarts, rangeCounts, viewMatrix,
+                                    projectionMatrix, cameraPosition, windPhase,
+                                    texture);
+  return;
 }
\ No newline at end of file
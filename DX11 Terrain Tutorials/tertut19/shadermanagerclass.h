@@ -32,6 +32,10 @@ public:
                         ID3D11ShaderResourceView *, XMFLOAT4 &);
   void RenderFoliageShader(ID3D11DeviceContext *, int, int, const XMMATRIX &,
                            const XMMATRIX &, ID3D11ShaderResourceView *);
+  void RenderFoliageBillboardShader(ID3D11DeviceContext *, int, int,
+                                    const int *, const int *, const XMMATRIX &,
+                                    const XMMATRIX &, XMFLOAT3, float,
+                                    ID3D11ShaderResourceView *);
 
 private:
   TextureShaderClass *m_TextureShader;